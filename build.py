@@ -197,12 +197,15 @@ CTX.INPUT['common'] = """
  TupleSchema.cpp
  types.cpp
  UndoLog.cpp
+ WireTupleSerializer.cpp
  NValue.cpp
  MMAPMemoryManager.cpp
  RecoveryProtoMessage.cpp
  RecoveryProtoMessageBuilder.cpp
  DefaultTupleSerializer.cpp
  StringRef.cpp
+ crc32c.cpp
+ BlockAllocator.cpp
 """
 
 CTX.INPUT['execution'] = """
@@ -215,6 +218,7 @@ CTX.INPUT['executors'] = """
  deleteexecutor.cpp
  distinctexecutor.cpp
  executorutil.cpp
+ hashjoinexecutor.cpp
  indexscanexecutor.cpp
  insertexecutor.cpp
  limitexecutor.cpp
@@ -232,6 +236,7 @@ CTX.INPUT['executors'] = """
 
 CTX.INPUT['expressions'] = """
  abstractexpression.cpp
+ compiledpredicate.cpp
  expressionutil.cpp
  tupleaddressexpression.cpp
 """
@@ -244,6 +249,7 @@ CTX.INPUT['plannodes'] = """
  aggregatenode.cpp
  deletenode.cpp
  distinctnode.cpp
+ hashjoinnode.cpp
  indexscannode.cpp
  insertnode.cpp
  limitnode.cpp
@@ -270,6 +276,7 @@ CTX.INPUT['indexes'] = """
 """
 
 CTX.INPUT['storage'] = """
+ ColumnarBlocks.cpp
  constraintutil.cpp
  CopyOnWriteContext.cpp
  CopyOnWriteIterator.cpp
@@ -303,7 +310,10 @@ CTX.INPUT['logging'] = """
  JNILogProxy.cpp
  LogManager.cpp
  AriesLogProxy.cpp
+ LogWriter.cpp
  Logrecord.cpp
+ CompactLogrecord.cpp
+ AriesReplayer.cpp
 """
  
 # specify the third party input
@@ -327,9 +337,18 @@ CTX.TESTS['catalog'] = """
 """
 
 CTX.TESTS['logging'] = """
+ aries_recovery_test
+ compact_logrecord_test
  logging_test
 """
 
+# micro benchmarks, built by "build.py buildbench" and run by hand
+CTX.BENCHMARKS['logging'] = """
+ aries_groupcommit_bench
+ aries_logrecord_bench
+ aries_recovery_bench
+"""
+
 CTX.TESTS['common'] = """
  debuglog_test
  serializeio_test
@@ -338,17 +357,32 @@ CTX.TESTS['common'] = """
  nvalue_test
  tupleschema_test
  tabletuple_test
+ block_allocator_test
 """
 
 CTX.TESTS['execution'] = """
  engine_test
 """
 
+CTX.BENCHMARKS['execution'] = """
+ executequeries_bench
+"""
+
+CTX.TESTS['executors'] = """
+ hash_join_executor_test
+ order_by_executor_test
+"""
+
 CTX.TESTS['expressions'] = """
  expression_test
 """
 
+CTX.BENCHMARKS['expressions'] = """
+ scan_predicate_bench
+"""
+
 CTX.TESTS['indexes'] = """
+ concurrent_tree_index_test
  index_allocatortracker_test
  index_key_test
  index_multikey_test
@@ -356,11 +390,17 @@ CTX.TESTS['indexes'] = """
  index_test
 """
 
+CTX.BENCHMARKS['indexes'] = """
+ hash_index_bench
+"""
+
 CTX.TESTS['storage'] = """
+ columnar_blocks_test
  CopyOnWriteTest
  constraint_test
  filter_test
  mmap_persistent_table_test
+ persistent_table_compaction_test
  persistent_table_log_test
  serialize_test
  StreamedTable_test
@@ -370,6 +410,11 @@ CTX.TESTS['storage'] = """
  TupleStreamWrapper_test
 """
 
+CTX.BENCHMARKS['storage'] = """
+ columnar_scan_bench
+ result_serialize_bench
+"""
+
 # these are incomplete and out of date. need to be replaced
 # CTX.TESTS['expressions'] = """expserialize_test expression_test"""
 
@@ -409,6 +454,15 @@ if CTX.ANTICACHE_BUILD:
     if CTX.ANTICACHE_TIMESTAMPS_PRIME:
         CTX.CPPFLAGS += " -DANTICACHE_TIMESTAMPS_PRIME"
 
+    # Optional block compression libraries
+    if CTX.ANTICACHE_LZ4:
+        CTX.CPPFLAGS += " -DANTICACHE_LZ4"
+        CTX.LDFLAGS += " -llz4"
+
+    if CTX.ANTICACHE_ZSTD:
+        CTX.CPPFLAGS += " -DANTICACHE_ZSTD"
+        CTX.LDFLAGS += " -lzstd"
+
     # Bring in berkeleydb library
     CTX.SYSTEM_DIRS.append(os.path.join(CTX.OUTPUT_PREFIX, 'berkeleydb'))
     CTX.THIRD_PARTY_STATIC_LIBS.extend([
@@ -423,13 +477,18 @@ if CTX.ANTICACHE_BUILD:
         AntiCacheDB.cpp
         BerkeleyAntiCacheDB.cpp
         NVMAntiCacheDB.cpp
+        FileAntiCacheDB.cpp
+        AntiCacheBlockCodec.cpp
+        AntiCacheBlockWriter.cpp
         AntiCacheEvictionManager.cpp
         EvictionIterator.cpp
         EvictedTable.cpp
+        EvictedIndexRanges.cpp
     """
     
     CTX.TESTS['anticache'] = """
         anticachedb_test
+        anticache_block_codec_test
         berkeleydb_test
         anticache_eviction_manager_test
     """
@@ -481,6 +540,8 @@ if retval != 0:
 retval = 0
 if CTX.TARGET == "BUILDTEST":
     retval = buildTests(CTX)
+elif CTX.TARGET == "BUILDBENCH":
+    retval = buildBenchmarks(CTX)
 elif CTX.TARGET == "TEST":
     retval = runTests(CTX)
 elif CTX.TARGET == "VOLTDBIPC":
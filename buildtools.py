@@ -31,6 +31,7 @@ class BuildContext:
         self.THIRD_PARTY_INPUT = {}
         self.THIRD_PARTY_STATIC_LIBS = [ ]
         self.TESTS = {}
+        self.BENCHMARKS = {}
         self.PLATFORM = os.uname()[0]
         self.PLATFORM_VERSION = os.uname()[2] 
         self.LEVEL = "DEBUG"
@@ -48,11 +49,13 @@ class BuildContext:
         self.ARIES= False
         self.ANTICACHE_TIMESTAMPS = True
         self.ANTICACHE_TIMESTAMPS_PRIME = True
+        self.ANTICACHE_LZ4 = False
+        self.ANTICACHE_ZSTD = False
 
         for arg in [x.strip().upper() for x in args]:
             if arg in ["DEBUG", "RELEASE", "MEMCHECK", "MEMCHECK_NOFREELIST"]:
                 self.LEVEL = arg
-            if arg in ["BUILD", "CLEAN", "BUILDTEST", "TEST", "VOLTRUN", "VOLTDBIPC"]:
+            if arg in ["BUILD", "CLEAN", "BUILDTEST", "BUILDBENCH", "TEST", "VOLTRUN", "VOLTDBIPC"]:
                 self.TARGET = arg
             if arg in ["COVERAGE"]:
                 self.COVERAGE = True
@@ -95,6 +98,15 @@ class BuildContext:
                 parts = arg.split("=")
                 if len(parts) > 1 and not parts[1].startswith("${"):
                     self.ANTICACHE_TIMESTAMPS_PRIME = bool(parts[1])
+            # these need a system library, so only an explicit true turns them on
+            if arg.startswith("ANTICACHE_LZ4="):
+                parts = arg.split("=")
+                if len(parts) > 1 and not parts[1].startswith("${"):
+                    self.ANTICACHE_LZ4 = parts[1] in ("TRUE", "1")
+            if arg.startswith("ANTICACHE_ZSTD="):
+                parts = arg.split("=")
+                if len(parts) > 1 and not parts[1].startswith("${"):
+                    self.ANTICACHE_ZSTD = parts[1] in ("TRUE", "1")
                 
             if arg.startswith("LOG_LEVEL="):
                 parts = arg.split("=")
@@ -228,6 +240,12 @@ def buildMakefile(CTX):
         input = CTX.TESTS[dir].split()
         tests += [TEST_PREFIX + "/" + dir + "/" + x for x in input]
 
+    # built like tests, but only by the bench target and never run by runTests
+    benchmarks = []
+    for dir in CTX.BENCHMARKS.keys():
+        input = CTX.BENCHMARKS[dir].split()
+        benchmarks += [TEST_PREFIX + "/" + dir + "/" + x for x in input]
+
     makefile = file(OUTPUT_PREFIX + "/makefile", 'w')
     makefile.write("CC = gcc\n")
     makefile.write("CXX = g++\n")
@@ -300,6 +318,13 @@ def buildMakefile(CTX):
     if CTX.LEVEL == "MEMCHECK_NOFREELIST":
         makefile.write("prod/voltdbipc")
     makefile.write("\n\n")
+
+    makefile.write(".PHONY: bench\n")
+    makefile.write("bench: ")
+    for bench in benchmarks:
+        binname, objectname, sourcename = namesForTestCode(bench)
+        makefile.write(binname + " ")
+    makefile.write("\n\n")
     makefile.write("objects/volt.a: " + " ".join(jni_objects) + " objects/harness.o objects/execution/IPCTopend.o\n")
     makefile.write("\t$(AR) $(ARFLAGS) $@ $?\n")
     makefile.write("objects/harness.o: ../../" + TEST_PREFIX + "/harness.cpp\n")
@@ -314,7 +339,7 @@ def buildMakefile(CTX):
         allsources += [(filename, LOCALCPPFLAGS, IGNORE_SYS_PREFIXES)]
     for filename in third_party_input_paths:
         allsources += [(filename, LOCALCPPFLAGS, IGNORE_SYS_PREFIXES)]
-    for test in tests:
+    for test in tests + benchmarks:
         binname, objectname, sourcename = namesForTestCode(test)
         allsources += [(sourcename, LOCALTESTCPPFLAGS, IGNORE_SYS_PREFIXES)]
     deps = getAllDependencies(allsources, 1)
@@ -349,7 +374,7 @@ def buildMakefile(CTX):
         makefile.write("\t$(CCACHE) $(COMPILE.cpp) %s -o $@ %s\n" % (CTX.EXTRAFLAGS, filename))
     makefile.write("\n")
 
-    for test in tests:
+    for test in tests + benchmarks:
         binname, objectname, sourcename = namesForTestCode(test)
 
         # build the object file
@@ -385,6 +410,12 @@ def buildTests(CTX):
         return -1
     return retval
 
+def buildBenchmarks(CTX):
+    retval = os.system("make --directory=%s bench -j4" % (CTX.OUTPUT_PREFIX))
+    if retval != 0:
+        return -1
+    return retval
+
 def runTests(CTX):
     failedTests = []
 
@@ -0,0 +1,322 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "anticache/AntiCacheBlockCodec.h"
+#include "common/debuglog.h"
+#include "common/FatalException.hpp"
+#include "common/LatencyHistogram.h"
+#include "common/serializeio.h"
+#include <string.h>
+
+#ifdef ANTICACHE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef ANTICACHE_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+using namespace std;
+
+namespace voltdb {
+
+const int AntiCacheBlockCodec::HEADER_SIZE;
+const int32_t AntiCacheBlockCodec::MAGIC;
+const int AntiCacheBlockCodec::DICT_SAMPLE_BYTES;
+const int AntiCacheBlockCodec::DICT_SAMPLE_SIZE;
+const int AntiCacheBlockCodec::DICT_SAMPLES_PER_BLOCK;
+const int AntiCacheBlockCodec::DICT_CAPACITY;
+
+AntiCacheBlockCodec::AntiCacheBlockCodec() :
+    m_type(ANTICACHE_COMPRESSION_NONE),
+    m_level(0),
+    m_nextDictId(0),
+    m_cctx(NULL),
+    m_dctx(NULL) {
+#ifdef ANTICACHE_ZSTD
+    m_cctx = ZSTD_createCCtx();
+    m_dctx = ZSTD_createDCtx();
+#endif
+}
+
+AntiCacheBlockCodec::~AntiCacheBlockCodec() {
+#ifdef ANTICACHE_ZSTD
+    for (map<string, TableDictionary>::iterator it = m_tableDicts.begin(); it != m_tableDicts.end(); ++it) {
+        ZSTD_freeCDict(static_cast<ZSTD_CDict*>(it->second.cdict));
+    }
+    for (map<uint32_t, void*>::iterator it = m_ddicts.begin(); it != m_ddicts.end(); ++it) {
+        ZSTD_freeDDict(static_cast<ZSTD_DDict*>(it->second));
+    }
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(m_cctx));
+    ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(m_dctx));
+#endif
+}
+
+bool AntiCacheBlockCodec::isAvailable(AntiCacheCompressionType type) {
+    switch (type) {
+        case ANTICACHE_COMPRESSION_NONE:
+            return true;
+#ifdef ANTICACHE_LZ4
+        case ANTICACHE_COMPRESSION_LZ4:
+            return true;
+#endif
+#ifdef ANTICACHE_ZSTD
+        case ANTICACHE_COMPRESSION_ZSTD:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool AntiCacheBlockCodec::isCompressed(const char* data, long size) {
+    if (size < HEADER_SIZE) {
+        return false;
+    }
+    ReferenceSerializeInput in(data, HEADER_SIZE);
+    return (in.readInt() == MAGIC);
+}
+
+bool AntiCacheBlockCodec::setCompression(AntiCacheCompressionType type, int level) {
+    if (isAvailable(type) == false) {
+        VOLT_WARN("Anti-cache block compression %d was not enabled when compiling the EE", (int)type);
+        return false;
+    }
+    VOLT_INFO("Compressing anti-cache blocks with format %d level %d", (int)type, level);
+    m_type = type;
+    m_level = level;
+    return true;
+}
+
+const char* AntiCacheBlockCodec::compressBlock(const std::string &tableName, const char* data,
+                                               long size, long &outSize) {
+    AntiCacheCodecStats &stats = m_stats[tableName];
+    stats.blocksWritten++;
+    stats.rawBytes += size;
+    outSize = size;
+
+    if (m_type == ANTICACHE_COMPRESSION_NONE) {
+        stats.storedBytes += size;
+        return data;
+    }
+
+    int64_t start = LatencyHistogram::nowMicros();
+    long compressed = 0;
+    uint32_t dictId = 0;
+    switch (m_type) {
+#ifdef ANTICACHE_LZ4
+        case ANTICACHE_COMPRESSION_LZ4: {
+            int bound = LZ4_compressBound(static_cast<int>(size));
+            m_buffer.resize(HEADER_SIZE + bound);
+            compressed = LZ4_compress_default(data, &m_buffer[HEADER_SIZE], static_cast<int>(size), bound);
+            break;
+        }
+#endif
+#ifdef ANTICACHE_ZSTD
+        case ANTICACHE_COMPRESSION_ZSTD: {
+            TableDictionary &dict = m_tableDicts[tableName];
+            if (dict.cdict == NULL && dict.failed == false) {
+                addSamples(dict, data, size);
+                if (static_cast<long>(dict.samples.size()) >= DICT_SAMPLE_BYTES) {
+                    trainDictionary(dict, tableName);
+                }
+            }
+
+            size_t bound = ZSTD_compressBound(size);
+            m_buffer.resize(HEADER_SIZE + bound);
+            size_t result;
+            if (dict.cdict != NULL) {
+                result = ZSTD_compress_usingCDict(static_cast<ZSTD_CCtx*>(m_cctx),
+                                                  &m_buffer[HEADER_SIZE], bound, data, size,
+                                                  static_cast<ZSTD_CDict*>(dict.cdict));
+                dictId = dict.dictId;
+            } else {
+                result = ZSTD_compressCCtx(static_cast<ZSTD_CCtx*>(m_cctx),
+                                           &m_buffer[HEADER_SIZE], bound, data, size, m_level);
+            }
+            compressed = (ZSTD_isError(result) ? 0 : static_cast<long>(result));
+            break;
+        }
+#endif
+        default:
+            break;
+    }
+    stats.compressMicros += LatencyHistogram::nowMicros() - start;
+
+    // keep the raw block if compressing did not pay off
+    if (compressed <= 0 || compressed + HEADER_SIZE >= size) {
+        VOLT_DEBUG("Storing %ld byte block of %s uncompressed", size, tableName.c_str());
+        stats.storedBytes += size;
+        return data;
+    }
+
+    ReferenceSerializeOutput out(&m_buffer[0], HEADER_SIZE);
+    out.writeInt(MAGIC);
+    out.writeByte(static_cast<int8_t>(m_type));
+    out.writeByte(0);
+    out.writeByte(0);
+    out.writeByte(0);
+    out.writeInt(static_cast<int32_t>(dictId));
+    out.writeInt(static_cast<int32_t>(size));
+
+    outSize = compressed + HEADER_SIZE;
+    stats.storedBytes += outSize;
+    VOLT_DEBUG("Compressed %ld byte block of %s to %ld bytes [format=%d, dict=%u]",
+               size, tableName.c_str(), outSize, (int)m_type, dictId);
+    return &m_buffer[0];
+}
+
+char* AntiCacheBlockCodec::decompressBlock(const std::string &tableName, const char* data,
+                                           long size, long &outSize) {
+    AntiCacheCodecStats &stats = m_stats[tableName];
+    stats.blocksRead++;
+
+    if (isCompressed(data, size) == false) {
+        char* raw = new char[size];
+        memcpy(raw, data, size);
+        outSize = size;
+        return raw;
+    }
+
+    ReferenceSerializeInput in(data, HEADER_SIZE);
+    in.readInt();
+    int format = in.readByte();
+    in.readByte();
+    in.readByte();
+    in.readByte();
+    uint32_t dictId = static_cast<uint32_t>(in.readInt());
+    int32_t rawSize = in.readInt();
+
+    // the compressed payload starts at data + HEADER_SIZE, it is only read
+    // by the codecs that were compiled in
+    char* raw = new char[rawSize];
+    bool success = false;
+
+    int64_t start = LatencyHistogram::nowMicros();
+    switch (format) {
+#ifdef ANTICACHE_LZ4
+        case ANTICACHE_COMPRESSION_LZ4: {
+            int result = LZ4_decompress_safe(data + HEADER_SIZE, raw,
+                                             static_cast<int>(size - HEADER_SIZE), rawSize);
+            success = (result == rawSize);
+            break;
+        }
+#endif
+#ifdef ANTICACHE_ZSTD
+        case ANTICACHE_COMPRESSION_ZSTD: {
+            size_t result;
+            if (dictId != 0) {
+                map<uint32_t, void*>::const_iterator ddict = m_ddicts.find(dictId);
+                if (ddict == m_ddicts.end()) {
+                    delete [] raw;
+                    throwFatalException("Block of table '%s' was compressed with unknown dictionary %u",
+                                        tableName.c_str(), dictId);
+                }
+                result = ZSTD_decompress_usingDDict(static_cast<ZSTD_DCtx*>(m_dctx), raw, rawSize,
+                                                    data + HEADER_SIZE, size - HEADER_SIZE,
+                                                    static_cast<ZSTD_DDict*>(ddict->second));
+            } else {
+                result = ZSTD_decompressDCtx(static_cast<ZSTD_DCtx*>(m_dctx), raw, rawSize,
+                                         data + HEADER_SIZE, size - HEADER_SIZE);
+            }
+            success = (ZSTD_isError(result) == false && result == static_cast<size_t>(rawSize));
+            break;
+        }
+#endif
+        default:
+            delete [] raw;
+            throwFatalException("Block of table '%s' was compressed with format %d, which was not "
+                                "enabled when compiling the EE", tableName.c_str(), format);
+    }
+    stats.decompressMicros += LatencyHistogram::nowMicros() - start;
+
+    if (success == false) {
+        delete [] raw;
+        throwFatalException("Failed to decompress %ld byte block of table '%s' [format=%d, dict=%u]",
+                            size, tableName.c_str(), format, dictId);
+    }
+    outSize = rawSize;
+    return raw;
+}
+
+AntiCacheCodecStats AntiCacheBlockCodec::getStats(const std::string &tableName) const {
+    map<string, AntiCacheCodecStats>::const_iterator it = m_stats.find(tableName);
+    if (it == m_stats.end()) {
+        return AntiCacheCodecStats();
+    }
+    return it->second;
+}
+
+bool AntiCacheBlockCodec::hasDictionary(const std::string &tableName) const {
+    map<string, TableDictionary>::const_iterator it = m_tableDicts.find(tableName);
+    return (it != m_tableDicts.end() && it->second.cdict != NULL);
+}
+
+/*
+ * Take evenly spaced chunks of the block rather than its head so that the
+ * samples cover all of the columns' value ranges in the block.
+ */
+void AntiCacheBlockCodec::addSamples(TableDictionary &dict, const char* data, long size) {
+    long chunks = size / DICT_SAMPLE_SIZE;
+    if (chunks == 0) {
+        dict.samples.insert(dict.samples.end(), data, data + size);
+        dict.sampleSizes.push_back(size);
+        return;
+    }
+    long take = (chunks < DICT_SAMPLES_PER_BLOCK ? chunks : DICT_SAMPLES_PER_BLOCK);
+    long stride = chunks / take;
+    for (long i = 0; i < take; i++) {
+        const char* chunk = data + (i * stride * DICT_SAMPLE_SIZE);
+        dict.samples.insert(dict.samples.end(), chunk, chunk + DICT_SAMPLE_SIZE);
+        dict.sampleSizes.push_back(DICT_SAMPLE_SIZE);
+    }
+}
+
+void AntiCacheBlockCodec::trainDictionary(TableDictionary &dict, const std::string &tableName) {
+#ifdef ANTICACHE_ZSTD
+    std::vector<char> buffer(DICT_CAPACITY);
+    size_t dictSize = ZDICT_trainFromBuffer(&buffer[0], DICT_CAPACITY,
+                                            &dict.samples[0], &dict.sampleSizes[0],
+                                            static_cast<unsigned>(dict.sampleSizes.size()));
+    if (ZDICT_isError(dictSize)) {
+        // don't keep sampling a table whose blocks we can't train on
+        VOLT_WARN("Failed to train compression dictionary for table '%s': %s",
+                  tableName.c_str(), ZDICT_getErrorName(dictSize));
+        dict.failed = true;
+    } else {
+        // the compression level is fixed into the dictionary when it is trained
+        dict.dictId = ++m_nextDictId;
+        dict.cdict = ZSTD_createCDict(&buffer[0], dictSize, m_level);
+        m_ddicts[dict.dictId] = ZSTD_createDDict(&buffer[0], dictSize);
+        VOLT_INFO("Trained %ld byte compression dictionary %u for table '%s' from %ld samples",
+                  (long)dictSize, dict.dictId, tableName.c_str(), (long)dict.sampleSizes.size());
+    }
+#endif
+    std::vector<char>().swap(dict.samples);
+    std::vector<size_t>().swap(dict.sampleSizes);
+}
+
+}
@@ -0,0 +1,157 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ANTICACHEBLOCKCODEC_H
+#define ANTICACHEBLOCKCODEC_H
+
+#include "common/types.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace voltdb {
+
+/**
+ * Per table compression counters. Bytes are serialized block sizes,
+ * times are in microseconds.
+ */
+struct AntiCacheCodecStats {
+    AntiCacheCodecStats() :
+        blocksWritten(0), rawBytes(0), storedBytes(0), compressMicros(0),
+        blocksRead(0), decompressMicros(0) {}
+
+    int64_t blocksWritten;
+    int64_t rawBytes;
+    int64_t storedBytes;
+    int64_t compressMicros;
+    int64_t blocksRead;
+    int64_t decompressMicros;
+};
+
+/**
+ * Compresses evicted blocks on their way to an AntiCacheDB and restores
+ * them when they are read back.
+ *
+ * A compressed block starts with a 16 byte header: a magic number, the
+ * format, the id of the dictionary it was compressed with and its raw
+ * size. The magic's leading byte has the high bit set, which a block
+ * written raw can never have since it starts with a small positive
+ * table count, so raw and compressed blocks can sit in the same
+ * AntiCacheDB and the compression can be changed at any time. A block
+ * that does not get smaller is stored raw.
+ *
+ * LZ4 and Zstd are only available when the EE is built with
+ * ANTICACHE_LZ4 / ANTICACHE_ZSTD. With Zstd each table gets its own
+ * dictionary, trained from samples of that table's first evicted blocks;
+ * blocks evicted before the dictionary exists are compressed without one.
+ * Dictionaries are kept in memory for as long as the codec lives, which
+ * is as long as the evicted blocks that refer to them can be read.
+ *
+ * Not thread safe.
+ */
+class AntiCacheBlockCodec {
+    public:
+        static const int HEADER_SIZE = 16;
+        static const int32_t MAGIC = static_cast<int32_t>(0xAC0DEC00);
+
+        /** Bytes of samples gathered per table before training its dictionary */
+        static const int DICT_SAMPLE_BYTES = 1024 * 1024;
+        static const int DICT_SAMPLE_SIZE = 4096;
+        static const int DICT_SAMPLES_PER_BLOCK = 32;
+        static const int DICT_CAPACITY = 16 * 1024;
+
+        AntiCacheBlockCodec();
+        ~AntiCacheBlockCodec();
+
+        /** Whether this EE was built with the library for the given format */
+        static bool isAvailable(AntiCacheCompressionType type);
+
+        /** Whether the block was written by compressBlock() with a header */
+        static bool isCompressed(const char* data, long size);
+
+        /**
+         * Compress blocks written from now on. Level only applies to Zstd,
+         * 0 picks its default. Returns false and leaves the setting alone
+         * if the format is not compiled in.
+         */
+        bool setCompression(AntiCacheCompressionType type, int level);
+
+        inline AntiCacheCompressionType getCompression() const {
+            return m_type;
+        }
+
+        /**
+         * Returns the bytes to write for the given raw block of the table,
+         * either data itself or a buffer owned by the codec that stays valid
+         * until the next call.
+         */
+        const char* compressBlock(const std::string &tableName, const char* data, long size, long &outSize);
+
+        /**
+         * Returns a newly allocated copy of the raw block, whatever format
+         * it was stored in. The caller owns the buffer.
+         */
+        char* decompressBlock(const std::string &tableName, const char* data, long size, long &outSize);
+
+        /** Counters of the given table, zero if it has none */
+        AntiCacheCodecStats getStats(const std::string &tableName) const;
+
+        /** Whether a Zstd dictionary has been trained for the table */
+        bool hasDictionary(const std::string &tableName) const;
+
+    private:
+        struct TableDictionary {
+            TableDictionary() : dictId(0), failed(false), cdict(NULL) {}
+
+            uint32_t dictId;
+            bool failed;
+            std::vector<char> samples;
+            std::vector<size_t> sampleSizes;
+            void* cdict;
+        };
+
+        void addSamples(TableDictionary &dict, const char* data, long size);
+        void trainDictionary(TableDictionary &dict, const std::string &tableName);
+
+        AntiCacheCompressionType m_type;
+        int m_level;
+
+        std::vector<char> m_buffer;
+        std::map<std::string, AntiCacheCodecStats> m_stats;
+
+        std::map<std::string, TableDictionary> m_tableDicts;
+        // decompression dictionaries by the id recorded in the block header
+        std::map<uint32_t, void*> m_ddicts;
+        uint32_t m_nextDictId;
+
+        void* m_cctx;
+        void* m_dctx;
+}; // CLASS
+
+}
+
+#endif
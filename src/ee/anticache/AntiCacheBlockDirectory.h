@@ -0,0 +1,90 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ANTICACHEBLOCKDIRECTORY_H
+#define ANTICACHEBLOCKDIRECTORY_H
+
+#include <cassert>
+#include <vector>
+#include <stdint.h>
+
+namespace voltdb {
+
+/**
+ * Directory of the blocks stored in an AntiCacheDB whose block ids are
+ * slot numbers handed out densely from a free list (NVM, file). It is a
+ * plain array indexed by block id holding the size of each stored block,
+ * four bytes per slot instead of a tree node per block, so lookups are a
+ * single load however many blocks the database holds.
+ */
+class AntiCacheBlockDirectory {
+public:
+    AntiCacheBlockDirectory() : m_count(0) {
+    }
+
+    /** Record a block of the given size, size must be > 0 */
+    inline void insert(int64_t blockId, int32_t size) {
+        assert(blockId >= 0 && size > 0);
+        if (static_cast<size_t>(blockId) >= m_sizes.size()) {
+            m_sizes.resize(static_cast<size_t>(blockId) + 1, 0);
+        }
+        if (m_sizes[blockId] == 0) {
+            m_count++;
+        }
+        m_sizes[blockId] = size;
+    }
+
+    /** Size of the block, 0 if the block is not stored */
+    inline int32_t find(int64_t blockId) const {
+        if (blockId < 0 || static_cast<size_t>(blockId) >= m_sizes.size()) {
+            return 0;
+        }
+        return m_sizes[blockId];
+    }
+
+    inline bool contains(int64_t blockId) const {
+        return find(blockId) != 0;
+    }
+
+    inline void erase(int64_t blockId) {
+        if (contains(blockId)) {
+            m_sizes[blockId] = 0;
+            m_count--;
+        }
+    }
+
+    /** Number of blocks stored */
+    inline int64_t size() const {
+        return m_count;
+    }
+
+private:
+    std::vector<int32_t> m_sizes;
+    int64_t m_count;
+};
+
+}
+
+#endif
@@ -0,0 +1,317 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "anticache/AntiCacheBlockWriter.h"
+#include "anticache/AntiCacheBlockCodec.h"
+#include "anticache/AntiCacheDB.h"
+#include "common/FatalException.hpp"
+#include "common/SerializableEEException.h"
+#include "common/debuglog.h"
+
+#include <cstring>
+#include <exception>
+
+namespace voltdb {
+
+AntiCacheBlockWriter::AntiCacheBlockWriter(AntiCacheBlockCodec &codec) :
+    m_codec(codec), m_running(false), m_stopping(false), m_queueDepth(0),
+    m_retryFlush(false), m_writing(0) {
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_notEmpty, NULL);
+    pthread_cond_init(&m_notFull, NULL);
+    pthread_cond_init(&m_drained, NULL);
+    pthread_mutex_init(&m_ioMutex, NULL);
+}
+
+AntiCacheBlockWriter::~AntiCacheBlockWriter() {
+    stop();
+    pthread_mutex_destroy(&m_ioMutex);
+    pthread_cond_destroy(&m_drained);
+    pthread_cond_destroy(&m_notFull);
+    pthread_cond_destroy(&m_notEmpty);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+void AntiCacheBlockWriter::start(int queueDepth) {
+    stop();
+    if (queueDepth <= 0) {
+        return;
+    }
+    m_queueDepth = queueDepth;
+    m_stopping = false;
+    if (pthread_create(&m_thread, NULL, AntiCacheBlockWriter::run, this) != 0) {
+        throwFatalException("Failed to start the anti-cache block writer thread");
+    }
+    m_running = true;
+    VOLT_INFO("Started the anti-cache block writer [queueDepth=%d]", queueDepth);
+}
+
+void AntiCacheBlockWriter::stop() {
+    if (m_running == false) {
+        return;
+    }
+    pthread_mutex_lock(&m_mutex);
+    m_stopping = true;
+    pthread_cond_signal(&m_notEmpty);
+    pthread_mutex_unlock(&m_mutex);
+    pthread_join(m_thread, NULL);
+    m_running = false;
+
+    writeRemaining();
+    // nobody is left to report it to
+    if (m_error.empty() == false) {
+        VOLT_ERROR("Anti-cache block writer failed: %s", m_error.c_str());
+        m_error.clear();
+    }
+}
+
+void AntiCacheBlockWriter::submit(AntiCacheDB* db, const std::string &tableName, int64_t blockId,
+                                  int32_t tupleCount, const char* data, long size) {
+    Job job;
+    job.db = db;
+    job.tableName = tableName;
+    job.blockId = blockId;
+    job.tupleCount = tupleCount;
+    job.data = new char[size];
+    job.size = size;
+    memcpy(job.data, data, size);
+
+    pthread_mutex_lock(&m_mutex);
+    while (m_queue.size() >= m_queueDepth && m_error.empty()) {
+        pthread_cond_wait(&m_notFull, &m_mutex);
+    }
+    // the tuples are gone from the table, so the block is queued even if
+    // the writer failed before
+    m_queue.push_back(job);
+    m_pending.insert(db);
+    pthread_cond_signal(&m_notEmpty);
+    pthread_mutex_unlock(&m_mutex);
+    checkError();
+}
+
+void AntiCacheBlockWriter::drain() {
+    if (m_running == false) {
+        return;
+    }
+    pthread_mutex_lock(&m_mutex);
+    if (m_failed.empty() == false || m_error.empty() == false) {
+        m_queue.insert(m_queue.begin(), m_failed.begin(), m_failed.end());
+        m_failed.clear();
+        m_retryFlush = true;
+        m_error.clear();
+        pthread_cond_signal(&m_notEmpty);
+    }
+    while (m_queue.empty() == false || m_writing > 0 || m_retryFlush) {
+        pthread_cond_wait(&m_drained, &m_mutex);
+    }
+    pthread_mutex_unlock(&m_mutex);
+    checkError();
+}
+
+int AntiCacheBlockWriter::pendingBlocks(const AntiCacheDB* db) {
+    if (m_running == false) {
+        return 0;
+    }
+    pthread_mutex_lock(&m_mutex);
+    int pending = (int)m_pending.count(db);
+    pthread_mutex_unlock(&m_mutex);
+    return pending;
+}
+
+LatencyHistogram AntiCacheBlockWriter::getWriteLatency() {
+    pthread_mutex_lock(&m_mutex);
+    LatencyHistogram latency = m_writeLatency;
+    pthread_mutex_unlock(&m_mutex);
+    return latency;
+}
+
+void AntiCacheBlockWriter::checkError() {
+    pthread_mutex_lock(&m_mutex);
+    std::string error = m_error;
+    m_error.clear();
+    pthread_mutex_unlock(&m_mutex);
+    if (error.empty() == false) {
+        throwFatalException("Anti-cache block writer failed: %s", error.c_str());
+    }
+}
+
+void* AntiCacheBlockWriter::run(void* writer) {
+    static_cast<AntiCacheBlockWriter*>(writer)->writeBlocks();
+    return NULL;
+}
+
+/*
+ * Only called from a catch block. Nothing may leave the thread, so every
+ * exception is turned into a message for the site thread.
+ */
+std::string AntiCacheBlockWriter::exceptionMessage() {
+    try {
+        throw;
+    } catch (SerializableEEException &e) {
+        return e.message();
+    } catch (FatalException &e) {
+        return e.m_reason;
+    } catch (std::exception &e) {
+        return e.what();
+    } catch (...) {
+        return "unknown exception";
+    }
+}
+
+bool AntiCacheBlockWriter::writeBlock(Job &job, std::string &error) {
+    bool written = false;
+    pthread_mutex_lock(&m_ioMutex);
+    try {
+        long size;
+        const char* data = m_codec.compressBlock(job.tableName, job.data, job.size, size);
+        job.db->writeBlock(job.tableName, job.blockId, job.tupleCount, data, size);
+        written = true;
+    } catch (...) {
+        error = exceptionMessage();
+    }
+    pthread_mutex_unlock(&m_ioMutex);
+    return written;
+}
+
+/*
+ * Flush every AntiCacheDB that was written to and let go of the blocks of
+ * the ones that made it. The others keep theirs for the next try.
+ */
+bool AntiCacheBlockWriter::flushBlocks(std::string &error) {
+    pthread_mutex_lock(&m_ioMutex);
+    UnflushedJobs::iterator it = m_unflushed.begin();
+    while (it != m_unflushed.end()) {
+        try {
+            it->first->flushBlocks();
+        } catch (...) {
+            error = exceptionMessage();
+            ++it;
+            continue;
+        }
+        for (size_t i = 0; i < it->second.size(); i++) {
+            delete [] it->second[i].data;
+        }
+        m_unflushed.erase(it++);
+    }
+    pthread_mutex_unlock(&m_ioMutex);
+    return error.empty();
+}
+
+void AntiCacheBlockWriter::writeBlocks() {
+    // a flush that failed is retried when there is more to write or on drain()
+    bool flushFailed = false;
+    pthread_mutex_lock(&m_mutex);
+    while (true) {
+        if (m_retryFlush) {
+            flushFailed = false;
+            m_retryFlush = false;
+        }
+        if (m_queue.empty()) {
+            if (m_unflushed.empty() == false && flushFailed == false) {
+                m_writing++;
+                pthread_mutex_unlock(&m_mutex);
+                std::string error;
+                flushFailed = (flushBlocks(error) == false);
+
+                pthread_mutex_lock(&m_mutex);
+                m_writing--;
+                if (error.empty() == false && m_error.empty()) {
+                    m_error = error;
+                }
+                continue;
+            }
+            pthread_cond_broadcast(&m_drained);
+            if (m_stopping) {
+                break;
+            }
+            pthread_cond_wait(&m_notEmpty, &m_mutex);
+            continue;
+        }
+
+        Job job = m_queue.front();
+        m_queue.pop_front();
+        m_writing++;
+        flushFailed = false;
+        pthread_cond_signal(&m_notFull);
+        pthread_mutex_unlock(&m_mutex);
+
+        int64_t start = LatencyHistogram::nowMicros();
+        std::string error;
+        bool written = writeBlock(job, error);
+        if (written) {
+            m_unflushed[job.db].push_back(job);
+        }
+
+        pthread_mutex_lock(&m_mutex);
+        m_writeLatency.record(LatencyHistogram::nowMicros() - start);
+        m_writing--;
+        if (written) {
+            m_pending.erase(m_pending.find(job.db));
+        } else {
+            m_failed.push_back(job);
+            if (m_error.empty()) {
+                m_error = error;
+            }
+            pthread_cond_broadcast(&m_notFull);
+        }
+    }
+    pthread_mutex_unlock(&m_mutex);
+}
+
+/*
+ * Last try on the site thread once the thread is gone. Whatever still
+ * fails is lost, which is logged.
+ */
+void AntiCacheBlockWriter::writeRemaining() {
+    m_queue.insert(m_queue.end(), m_failed.begin(), m_failed.end());
+    m_failed.clear();
+    while (m_queue.empty() == false) {
+        Job job = m_queue.front();
+        m_queue.pop_front();
+        m_pending.erase(m_pending.find(job.db));
+        std::string error;
+        if (writeBlock(job, error)) {
+            m_unflushed[job.db].push_back(job);
+        } else {
+            VOLT_ERROR("Lost anti-cache block %ld of table '%s': %s",
+                       (long)job.blockId, job.tableName.c_str(), error.c_str());
+            delete [] job.data;
+        }
+    }
+
+    std::string error;
+    if (flushBlocks(error) == false) {
+        VOLT_ERROR("Failed to flush anti-cache blocks: %s", error.c_str());
+        for (UnflushedJobs::iterator it = m_unflushed.begin(); it != m_unflushed.end(); ++it) {
+            for (size_t i = 0; i < it->second.size(); i++) {
+                delete [] it->second[i].data;
+            }
+        }
+        m_unflushed.clear();
+    }
+    m_retryFlush = false;
+}
+
+}
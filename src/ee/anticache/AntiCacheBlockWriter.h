@@ -0,0 +1,160 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ANTICACHEBLOCKWRITER_H
+#define ANTICACHEBLOCKWRITER_H
+
+#include "common/LatencyHistogram.h"
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stdint.h>
+
+namespace voltdb {
+
+class AntiCacheDB;
+class AntiCacheBlockCodec;
+
+/**
+ * Compresses and writes evicted blocks to their AntiCacheDB on a
+ * background thread, so that the site thread only has to serialize the
+ * tuples and swap the index entries over to the EvictedTable.
+ *
+ * The queue is bounded: submit() blocks while it is full. Each AntiCacheDB
+ * a block went to is flushed whenever the queue runs empty.
+ *
+ * Neither the AntiCacheDBs nor the codec are thread safe. While the writer
+ * is running the site thread has to either hold a Guard around its own
+ * calls into them, or drain() the queue first so the thread sits idle.
+ * A write or flush that fails on the thread, whatever it throws, is raised
+ * as a fatal exception on the site thread by the next submit() or drain().
+ * The tuples are already gone from the table by then, so the writer keeps
+ * each serialized block until its AntiCacheDB was flushed: drain() retries
+ * the blocks that failed, and stop() makes a last attempt before it lets
+ * go of them.
+ */
+class AntiCacheBlockWriter {
+    public:
+        AntiCacheBlockWriter(AntiCacheBlockCodec &codec);
+        ~AntiCacheBlockWriter();
+
+        /** Start the thread with room for queueDepth blocks */
+        void start(int queueDepth);
+
+        /** Write out what is queued and stop the thread */
+        void stop();
+
+        inline bool isRunning() const {
+            return m_running;
+        }
+
+        /**
+         * Queue a serialized block. The bytes are copied, the block is
+         * compressed on the thread. The block is queued even if an earlier
+         * failure is raised.
+         */
+        void submit(AntiCacheDB* db, const std::string &tableName, int64_t blockId,
+                    int32_t tupleCount, const char* data, long size);
+
+        /**
+         * Retry the blocks that failed, then wait until every queued block
+         * is written and flushed
+         */
+        void drain();
+
+        /** Blocks queued, being written or failed for the given AntiCacheDB */
+        int pendingBlocks(const AntiCacheDB* db);
+
+        /** Compress and write time of each block, copied under the lock */
+        LatencyHistogram getWriteLatency();
+
+        /** Keeps the thread out of the AntiCacheDBs and the codec */
+        class Guard {
+            public:
+                Guard(AntiCacheBlockWriter &writer) : m_writer(writer) {
+                    if (m_writer.m_running) pthread_mutex_lock(&m_writer.m_ioMutex);
+                    m_locked = m_writer.m_running;
+                }
+                ~Guard() {
+                    if (m_locked) pthread_mutex_unlock(&m_writer.m_ioMutex);
+                }
+            private:
+                AntiCacheBlockWriter &m_writer;
+                bool m_locked;
+        };
+
+    private:
+        struct Job {
+            AntiCacheDB* db;
+            std::string tableName;
+            int64_t blockId;
+            int32_t tupleCount;
+            char* data;
+            long size;
+        };
+
+        typedef std::map<AntiCacheDB*, std::vector<Job> > UnflushedJobs;
+
+        static void* run(void* writer);
+        static std::string exceptionMessage();
+        void writeBlocks();
+        bool writeBlock(Job &job, std::string &error);
+        bool flushBlocks(std::string &error);
+        void writeRemaining();
+        void checkError();
+
+        AntiCacheBlockCodec &m_codec;
+        bool m_running;
+        bool m_stopping;
+        size_t m_queueDepth;
+        pthread_t m_thread;
+
+        // guards the queue, the counters and the error
+        pthread_mutex_t m_mutex;
+        pthread_cond_t m_notEmpty;
+        pthread_cond_t m_notFull;
+        pthread_cond_t m_drained;
+        std::deque<Job> m_queue;
+        std::deque<Job> m_failed;
+        bool m_retryFlush;
+        int m_writing;
+        std::multiset<const AntiCacheDB*> m_pending;
+        std::string m_error;
+        LatencyHistogram m_writeLatency;
+
+        // held by the thread around each block it writes
+        pthread_mutex_t m_ioMutex;
+
+        // written but not flushed yet, only touched by the thread while it runs
+        UnflushedJobs m_unflushed;
+}; // CLASS
+
+}
+
+#endif
@@ -39,7 +39,7 @@ using namespace std;
 
 namespace voltdb {
 
-AntiCacheBlock::AntiCacheBlock(int16_t blockId) {
+AntiCacheBlock::AntiCacheBlock(int64_t blockId) {
 
 //    for(int i=0;i<size;i++){
 //       VOLT_INFO("%x", data[i]);
@@ -61,14 +61,46 @@ AntiCacheDB::AntiCacheDB(ExecutorContext *ctx, std::string db_dir, long blockSiz
         } else {
             m_maxDBSize = maxSize;
         }
-        
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&m_readMutex, &attr);
+        pthread_mutexattr_destroy(&attr);
 }
 
 AntiCacheDB::~AntiCacheDB() {
+    for (std::map<int64_t, AntiCacheBlock*>::iterator it = m_readBlocks.begin(); it != m_readBlocks.end(); ++it) {
+        delete it->second;
+    }
+    pthread_mutex_destroy(&m_readMutex);
+}
+
+void AntiCacheDB::submitReads(const std::vector<int64_t> &blockIds) {
+    AntiCacheMutexGuard guard(m_readMutex);
+    for (std::vector<int64_t>::const_iterator it = blockIds.begin(); it != blockIds.end(); ++it) {
+        if (m_readBlocks.find(*it) == m_readBlocks.end()) {
+            m_readBlocks[*it] = readBlock(*it);
+        }
+    }
+}
+
+AntiCacheBlock* AntiCacheDB::completeRead(int64_t blockId) {
+    AntiCacheMutexGuard guard(m_readMutex);
+    std::map<int64_t, AntiCacheBlock*>::iterator it = m_readBlocks.find(blockId);
+    if (it == m_readBlocks.end()) {
+        return readBlock(blockId);
+    }
+    AntiCacheBlock* block = it->second;
+    m_readBlocks.erase(it);
+    return block;
+}
+
+long AntiCacheDB::readBlockRange(int64_t blockId, long offset, long length, char* buffer) {
+    return -1;
 }
 
 AntiCacheBlock* AntiCacheDB::getLRUBlock() {
-    uint16_t lru_block_id;
+    int64_t lru_block_id;
     AntiCacheBlock* lru_block;
 
     if (m_block_lru.empty()) {
@@ -83,36 +115,37 @@ AntiCacheBlock* AntiCacheDB::getLRUBlock() {
     }
 }
 
-void AntiCacheDB::removeBlockLRU(uint16_t blockId) {
-    std::deque<uint16_t>::iterator it;
-    bool found = false;
-           
-    
-    for (it = m_block_lru.begin(); it != m_block_lru.end(); ++it) {
-        if (*it == blockId) {
-            VOLT_INFO("Found block id %d == blockId %d", *it, blockId);
-            m_block_lru.erase(it);
-            found = true;
-            m_totalBlocks--;
-            break;
-        }
-    }
-
-    if (!found) {
-        VOLT_ERROR("Found block but didn't find blockId %d in LRU!", blockId);
+void AntiCacheDB::removeBlockLRU(int64_t blockId) {
+    boost::unordered_map<int64_t, std::list<int64_t>::iterator>::iterator it = m_block_lru_index.find(blockId);
+    if (it == m_block_lru_index.end()) {
+        VOLT_ERROR("Found block but didn't find blockId %ld in LRU!", (long)blockId);
         //throw UnknownBlockAccessException(blockId);
+        return;
     }
+    VOLT_INFO("Found block id %ld in LRU", (long)blockId);
+    m_block_lru.erase(it->second);
+    m_block_lru_index.erase(it);
+    m_totalBlocks--;
 }
 
-void AntiCacheDB::pushBlockLRU(uint16_t blockId) {
-    VOLT_INFO("Pushing blockId %d into LRU", blockId);
-    m_block_lru.push_back(blockId);
+void AntiCacheDB::pushBlockLRU(int64_t blockId) {
+    VOLT_INFO("Pushing blockId %ld into LRU", (long)blockId);
+    m_block_lru_index[blockId] = m_block_lru.insert(m_block_lru.end(), blockId);
     m_totalBlocks++;
 }
 
-uint16_t AntiCacheDB::popBlockLRU() {
-    uint16_t blockId = m_block_lru.front();
+void AntiCacheDB::touchBlockLRU(int64_t blockId) {
+    boost::unordered_map<int64_t, std::list<int64_t>::iterator>::iterator it = m_block_lru_index.find(blockId);
+    if (it == m_block_lru_index.end()) {
+        return;
+    }
+    m_block_lru.splice(m_block_lru.end(), m_block_lru, it->second);
+}
+
+int64_t AntiCacheDB::popBlockLRU() {
+    int64_t blockId = m_block_lru.front();
     m_block_lru.pop_front();
+    m_block_lru_index.erase(blockId);
     return blockId;
 }
 
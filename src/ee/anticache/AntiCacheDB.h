@@ -34,9 +34,11 @@
 #include "anticache/UnknownBlockAccessException.h"
 #include "anticache/FullBackingStoreException.h"
 
-#include <deque>
+#include <pthread.h>
+#include <list>
 #include <map>
 #include <vector>
+#include <boost/unordered_map.hpp>
 
 
 //#define ANTICACHE_DB_NAME "anticache.db"
@@ -58,7 +60,7 @@ class AntiCacheBlock {
     public:
         virtual ~AntiCacheBlock() {};
         
-        inline int16_t getBlockId() const {
+        inline int64_t getBlockId() const {
             return m_blockId;
         }
 
@@ -74,7 +76,7 @@ class AntiCacheBlock {
         }
 
         struct payload{
-            int16_t blockId;
+            int64_t blockId;
             std::string tableName;
             char * data;
             long size;
@@ -86,8 +88,8 @@ class AntiCacheBlock {
     
     protected:
         // Why is this private/protected?
-        AntiCacheBlock(int16_t blockId);
-        int16_t m_blockId;
+        AntiCacheBlock(int64_t blockId);
+        int64_t m_blockId;
         payload m_payload;
         long m_size;
         char * m_block;
@@ -96,10 +98,42 @@ class AntiCacheBlock {
         AntiCacheDBType m_blockType;
 }; // CLASS
 
+/**
+ * Holds a mutex for as long as it is in scope, so that the exceptions the
+ * AntiCacheDBs throw don't leave it locked
+ */
+class AntiCacheMutexGuard {
+    public:
+        AntiCacheMutexGuard(pthread_mutex_t &mutex) : m_mutex(mutex) {
+            pthread_mutex_lock(&m_mutex);
+        }
+        ~AntiCacheMutexGuard() {
+            pthread_mutex_unlock(&m_mutex);
+        }
+    private:
+        pthread_mutex_t &m_mutex;
+};
+
 class AntiCacheDB {
-        
     public: 
        
+        /**
+         * Block ids outside of an AntiCacheDB (the EvictedTable, the Java layer)
+         * carry the ACID of the database in their top 16 bits and the id within
+         * that database in the low 48 bits.
+         */
+        static const int ACID_SHIFT = 48;
+
+        static inline int64_t packBlockId(int16_t ACID, int64_t blockId) {
+            return (static_cast<int64_t>(ACID) << ACID_SHIFT) | blockId;
+        }
+        static inline int16_t unpackACID(int64_t packedBlockId) {
+            return static_cast<int16_t>(packedBlockId >> ACID_SHIFT);
+        }
+        static inline int64_t unpackBlockId(int64_t packedBlockId) {
+            return packedBlockId & ((static_cast<int64_t>(1) << ACID_SHIFT) - 1);
+        }
+
         AntiCacheDB(ExecutorContext *ctx, std::string db_dir, long blockSize, long maxSize);
         virtual ~AntiCacheDB();
 
@@ -107,14 +141,39 @@ class AntiCacheDB {
          * Write a block of serialized tuples out to the anti-cache database
          */
         virtual void writeBlock(const std::string tableName,
-                                int16_t blockId,
+                                int64_t blockId,
                                 const int tupleCount,
                                 const char* data,
                                 const long size) = 0;
         /**
          * Read a block and return its contents
          */
-        virtual AntiCacheBlock* readBlock(int16_t blockId) = 0;
+        virtual AntiCacheBlock* readBlock(int64_t blockId) = 0;
+
+        /**
+         * Start reading all of the given blocks without waiting for them.
+         * Each one is picked up with completeRead() later on. A database
+         * that cannot read in the background reads them right here, which
+         * is what this default does. Throws UnknownBlockAccessException like
+         * readBlock() does.
+         */
+        virtual void submitReads(const std::vector<int64_t> &blockIds);
+
+        /**
+         * Return a block that submitReads() started reading, waiting for it
+         * if it is still in flight. The block is gone from the database
+         * just like after readBlock().
+         */
+        virtual AntiCacheBlock* completeRead(int64_t blockId);
+
+        /**
+         * Copy up to length bytes starting at offset of a block into buffer
+         * and return how many were copied, leaving the block in the database.
+         * Returns -1 if this database can only read whole blocks, which is
+         * what this default does. Throws UnknownBlockAccessException like
+         * readBlock() does.
+         */
+        virtual long readBlockRange(int64_t blockId, long offset, long length, char* buffer);
 
 
         /**
@@ -125,7 +184,7 @@ class AntiCacheDB {
         /**
          * Return the next BlockId to use in the anti-cache database
          */
-        virtual int16_t nextBlockId() = 0;
+        virtual int64_t nextBlockId() = 0;
         /**
          * Return the AntiCacheDBType of the database
          */
@@ -141,7 +200,7 @@ class AntiCacheDB {
         /**
          * Return the number of blocks stored in the database
          */
-        inline int getNumBlocks() {
+        inline int64_t getNumBlocks() {
             return m_totalBlocks;
         }
         /**
@@ -154,13 +213,13 @@ class AntiCacheDB {
          * Return the maximum number of blocks that can be stored 
          * in the database.
          */
-        inline int getMaxBlocks() {
-            return (int)(m_maxDBSize/m_blockSize);
+        inline int64_t getMaxBlocks() {
+            return (int64_t)(m_maxDBSize/m_blockSize);
         }
         /**
          * Return the number of free (available) blocks
          */
-        inline int getFreeBlocks() {
+        inline int64_t getFreeBlocks() {
             return getMaxBlocks()-getNumBlocks();
         }
         /**
@@ -176,12 +235,18 @@ class AntiCacheDB {
          * Removes a blockId from the LRU queue. This is used when reading a
          * specific block.
          */
-        void removeBlockLRU(uint16_t blockId);
+        void removeBlockLRU(int64_t blockId);
         
         /** 
          * Adds a blockId to the LRU deque.
          */
-        void pushBlockLRU(uint16_t blockId);
+        void pushBlockLRU(int64_t blockId);
+
+        /**
+         * Moves a blockId that is still in the database to the most recently
+         * used end of the LRU deque.
+         */
+        void touchBlockLRU(int64_t blockId);
 
         /**
          * Pops and returns the LRU blockID from the deque. This isn't a 
@@ -189,7 +254,7 @@ class AntiCacheDB {
          * but the blockId is no longer in the LRU. This shouldn't necessarily
          * be fatal, but it should be avoided.
          */
-        inline uint16_t popBlockLRU();
+        inline int64_t popBlockLRU();
 
         /**
          * Set the AntiCacheID number. This should be done on initialization and
@@ -218,22 +283,35 @@ class AntiCacheDB {
         ExecutorContext *m_executorContext;
         string m_dbDir;
 
-        int16_t m_nextBlockId;
+        int64_t m_nextBlockId;
         int16_t m_ACID;
         long m_blockSize;
         int m_partitionId; 
-        int m_totalBlocks; 
+        int64_t m_totalBlocks; 
         
         bool m_stall;
 
         AntiCacheDBType m_dbType;
         long m_maxDBSize;
 
-        /* we need to test whether a deque or list is better. If we push/pop more than we
-         * remove, this is better. otherwise, let's use a list
+        /*
+         * Block ids from least to most recently written. Reads remove blocks from
+         * the middle, so the list is indexed by block id to keep that O(1).
+         */
+        std::list<int64_t> m_block_lru;
+        boost::unordered_map<int64_t, std::list<int64_t>::iterator> m_block_lru_index;
+
+        /*
+         * Blocks read by the default submitReads() that nobody has picked up yet
          */
+        std::map<int64_t, AntiCacheBlock*> m_readBlocks;
 
-        std::deque<uint16_t> m_block_lru;
+        /*
+         * The AntiCacheManager thread submits reads while the site thread
+         * completes them, so reads in flight are only touched under this.
+         * It is recursive because completing a read can fall back to readBlock().
+         */
+        pthread_mutex_t m_readMutex;
 
         /*
          * DB specific method of shutting down the database on destructor call
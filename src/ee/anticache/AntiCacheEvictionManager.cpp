@@ -26,6 +26,7 @@
 #include "anticache/AntiCacheEvictionManager.h"
 #include "common/types.h"
 #include "common/FatalException.hpp"
+#include "common/SQLException.h"
 #include "common/ValueFactory.hpp"
 #include "common/ValuePeeker.hpp"
 #include "common/debuglog.h"
@@ -33,18 +34,24 @@
 #include "storage/persistenttable.h"
 #include "storage/temptable.h"
 #include "storage/tablefactory.h"
+#include "indexes/tableindex.h"
 #include "anticache/EvictionIterator.h"
 #include "boost/timer.hpp"
 #include "anticache/EvictedTable.h"
+#include "anticache/EvictedIndexRanges.h"
 #include "anticache/UnknownBlockAccessException.h"
 #include "anticache/AntiCacheDB.h"
 #include "anticache/BerkeleyAntiCacheDB.h"
 
+#include <algorithm>
+#include <set>
 #include <string>
 #include <vector>
 #include <time.h>
 #include <stdlib.h>
 #define MAX_EVICTED_TUPLE_SIZE 2500
+// bytes read from the front of a block to find its tuple directory
+#define MAX_BLOCK_HEADER_SIZE 4096
 
 namespace voltdb
 {
@@ -69,7 +76,7 @@ namespace voltdb
  
  */
     
-AntiCacheEvictionManager::AntiCacheEvictionManager(const VoltDBEngine *engine) {
+AntiCacheEvictionManager::AntiCacheEvictionManager(const VoltDBEngine *engine) : m_writer(m_codec) {
     
     // Initialize readBlocks table
     m_engine = engine;
@@ -83,12 +90,24 @@ AntiCacheEvictionManager::AntiCacheEvictionManager(const VoltDBEngine *engine) {
 
     m_numdbs = 0;
     m_migrate = false;
+    m_promoteAccesses = 0;
+    m_demotePercent = 100;
+    pthread_mutex_init(&m_fetchMutex, NULL);
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&m_blockMutex, &attr);
+    pthread_mutexattr_destroy(&attr);
 }
 
 AntiCacheEvictionManager::~AntiCacheEvictionManager() {
+    // the queued blocks have to reach their AntiCacheDBs before those go away
+    m_writer.stop();
     delete m_evictResultTable;
     delete m_evicted_tuple;
     TupleSchema::freeTupleSchema(m_evicted_schema);
+    pthread_mutex_destroy(&m_fetchMutex);
+    pthread_mutex_destroy(&m_blockMutex);
     
     // int i;
     //for (i = 1; i <= m_numdbs; i++) {
@@ -128,6 +147,36 @@ void AntiCacheEvictionManager::initEvictResultTable() {
     colLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
     colAllowNull.push_back(false);
     
+    // ANTICACHE_BLOCK_BYTES_RAW
+    colNames.push_back("ANTICACHE_BLOCK_BYTES_RAW");
+    colTypes.push_back(VALUE_TYPE_BIGINT);
+    colLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    colAllowNull.push_back(false);
+    
+    // ANTICACHE_BLOCK_BYTES_STORED
+    colNames.push_back("ANTICACHE_BLOCK_BYTES_STORED");
+    colTypes.push_back(VALUE_TYPE_BIGINT);
+    colLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    colAllowNull.push_back(false);
+    
+    // ANTICACHE_COMPRESS_MICROS
+    colNames.push_back("ANTICACHE_COMPRESS_MICROS");
+    colTypes.push_back(VALUE_TYPE_BIGINT);
+    colLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    colAllowNull.push_back(false);
+    
+    // ANTICACHE_DECOMPRESS_MICROS
+    colNames.push_back("ANTICACHE_DECOMPRESS_MICROS");
+    colTypes.push_back(VALUE_TYPE_BIGINT);
+    colLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    colAllowNull.push_back(false);
+    
+    // ANTICACHE_EVICT_PAUSE_MICROS
+    colNames.push_back("ANTICACHE_EVICT_PAUSE_MICROS");
+    colTypes.push_back(VALUE_TYPE_BIGINT);
+    colLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    colAllowNull.push_back(false);
+    
     TupleSchema *schema = TupleSchema::createTupleSchema(colTypes,
                                                          colLengths,
                                                          colAllowNull, true);
@@ -140,11 +189,134 @@ void AntiCacheEvictionManager::initEvictResultTable() {
                                                         NULL));
 }
 
+/*
+ * The compression columns cover the blocks written since lastStats was
+ * taken and the blocks of the table read back since its previous row. With
+ * background writes, blocks still queued are counted in a later row.
+ */
+void AntiCacheEvictionManager::addEvictResultRow(PersistentTable *table, int32_t tuplesEvicted,
+                                                 int32_t blocksEvicted, int64_t bytesEvicted,
+                                                 const AntiCacheCodecStats &lastStats, int64_t pauseMicros) {
+    AntiCacheCodecStats stats = getCodecStats(table->name());
+    int64_t &reportedDecompressMicros = m_reportedDecompressMicros[table->name()];
+    int64_t decompressMicros = stats.decompressMicros - reportedDecompressMicros;
+    reportedDecompressMicros = stats.decompressMicros;
+
+    TableTuple tuple = m_evictResultTable->tempTuple();
+    int idx = 0;
+    tuple.setNValue(idx++, ValueFactory::getStringValue(table->name()));
+    tuple.setNValue(idx++, ValueFactory::getIntegerValue(static_cast<int32_t>(tuplesEvicted)));
+    tuple.setNValue(idx++, ValueFactory::getIntegerValue(static_cast<int32_t>(blocksEvicted)));
+    tuple.setNValue(idx++, ValueFactory::getBigIntValue(static_cast<int32_t>(bytesEvicted)));
+    tuple.setNValue(idx++, ValueFactory::getBigIntValue(stats.rawBytes - lastStats.rawBytes));
+    tuple.setNValue(idx++, ValueFactory::getBigIntValue(stats.storedBytes - lastStats.storedBytes));
+    tuple.setNValue(idx++, ValueFactory::getBigIntValue(stats.compressMicros - lastStats.compressMicros));
+    tuple.setNValue(idx++, ValueFactory::getBigIntValue(decompressMicros));
+    tuple.setNValue(idx++, ValueFactory::getBigIntValue(pauseMicros));
+    m_evictResultTable->insertTuple(tuple);
+}
+
+AntiCacheCodecStats AntiCacheEvictionManager::getCodecStats(const std::string &tableName) {
+    AntiCacheBlockWriter::Guard guard(m_writer);
+    return m_codec.getStats(tableName);
+}
+
+void AntiCacheEvictionManager::setBackgroundWrites(int queueDepth) {
+    m_writer.start(queueDepth);
+}
+
+/*
+ * Pick the AntiCacheDB for the next evicted block and get its id there
+ */
+AntiCacheDB* AntiCacheEvictionManager::nextEvictedBlockId(PersistentTable *table, long block_size, int64_t &block_id) {
+    AntiCacheDB* antiCacheDB = table->getAntiCacheDB(chooseDB(block_size, m_migrate));
+    AntiCacheBlockWriter::Guard guard(m_writer);
+    block_id = nextFreeBlockId(antiCacheDB);
+    return antiCacheDB;
+}
+
+/*
+ * Get a new block id from the AntiCacheDB. An id whose block was migrated
+ * away is held back while evicted tuples still point to it, as they are
+ * forwarded to the block's new id rather than rewritten.
+ */
+int64_t AntiCacheEvictionManager::nextFreeBlockId(AntiCacheDB* antiCacheDB) {
+    AntiCacheMutexGuard guard(m_blockMutex);
+    int16_t acid = antiCacheDB->getACID();
+    for (std::vector<int64_t>::iterator it = m_releasedIds.begin(); it != m_releasedIds.end(); ++it) {
+        if (AntiCacheDB::unpackACID(*it) == acid) {
+            int64_t block_id = AntiCacheDB::unpackBlockId(*it);
+            m_releasedIds.erase(it);
+            return block_id;
+        }
+    }
+    while (true) {
+        int64_t block_id = antiCacheDB->nextBlockId();
+        int64_t packed = AntiCacheDB::packBlockId(acid, block_id);
+        if (m_movedBlocks.find(packed) == m_movedBlocks.end()) {
+            return block_id;
+        }
+        VOLT_DEBUG("Holding back block id %lx until its forwarding is dropped", (long)packed);
+        m_parkedIds.insert(packed);
+    }
+}
+
+/*
+ * Compress and write out an evicted block, or queue it for the background
+ * writer. The tuples are already gone from the table either way.
+ */
+void AntiCacheEvictionManager::writeEvictedBlock(AntiCacheDB* antiCacheDB, const std::string &tableName,
+                                                 int64_t block_id, int32_t num_tuples, BerkeleyDBBlock &block) {
+    m_tierStats[antiCacheDB->getACID()].blocksWritten++;
+    if (m_writer.isRunning()) {
+        m_writer.submit(antiCacheDB, tableName, block_id, num_tuples,
+                        block.getSerializedData(), block.getSerializedSize());
+        return;
+    }
+
+    // the AntiCacheDB copies the bytes, so the codec can hand back
+    // its own buffer
+    long blocksize;
+    const char* blockdata = m_codec.compressBlock(tableName,
+                                                  block.getSerializedData(),
+                                                  block.getSerializedSize(),
+                                                  blocksize);
+    antiCacheDB->writeBlock(tableName, block_id, num_tuples, blockdata, blocksize);
+}
+
 // insert tuple at front of chain, next for eviction 
+/*
+ * Point the index entries of a tuple that is being evicted at its
+ * EvictedTable tuple. With index eviction on, the entries of the indexes
+ * the table keeps key ranges for are dropped instead.
+ */
+void AntiCacheEvictionManager::evictIndexEntries(PersistentTable *table, TableTuple &tuple,
+                                                 const void* evicted_tuple_address, int64_t block_id) {
+    EvictedIndexRanges *ranges = table->getEvictedIndexRanges();
+    if (ranges == NULL) {
+        table->setEntryToNewAddressForAllIndexes(&tuple, evicted_tuple_address, tuple.address());
+        return;
+    }
+    ranges->addTuple(block_id, tuple);
+    for (int i = table->m_indexCount - 1; i >= 0; --i) {
+        TableIndex *index = table->m_indexes[i];
+        bool updated = (ranges->covers(index) ?
+                        index->deleteEntry(&tuple) :
+                        index->setEntryToNewAddress(&tuple, evicted_tuple_address, tuple.address()));
+        if (!updated) {
+            throwFatalException("Failed to evict tuple from index %s.%s",
+                                table->name().c_str(), index->getName().c_str());
+        }
+    }
+}
+
 bool AntiCacheEvictionManager::updateUnevictedTuple(PersistentTable* table, TableTuple* tuple) {
     if(table->getEvictedTable() == NULL || table->isBatchEvicted())  // no need to maintain chain for non-evictable tables or batch evicted tables
         return true;
 
+    if (table->getEvictionPolicy() == ANTICACHE_EVICTION_CLOCK) // merged tuples do not count as references
+        return true;
+
 #ifndef ANTICACHE_TIMESTAMPS
     int tuples_in_chain;
     int current_tuple_id = table->getTupleID(tuple->address()); // scan blocks for this tuple
@@ -189,6 +361,13 @@ bool AntiCacheEvictionManager::updateTuple(PersistentTable* table, TableTuple* t
     if (table->getEvictedTable() == NULL || table->isBatchEvicted())  // no need to maintain chain for non-evictable tables or batch evicted tables
         return true; 
 
+    if (table->getEvictionPolicy() == ANTICACHE_EVICTION_CLOCK) {
+        // set the reference bit of the tuple's storage block, the tuple itself is not touched
+        int tuple_id = table->getTupleID(tuple->address());
+        if (tuple_id >= 0)
+            table->setBlockReferenced(tuple_id / table->m_tuplesPerBlock);
+        return true;
+    }
 
 #ifndef ANTICACHE_TIMESTAMPS
     int SAMPLE_RATE = 100; // aLRU sampling rate
@@ -270,8 +449,54 @@ bool AntiCacheEvictionManager::updateTuple(PersistentTable* table, TableTuple* t
     return true; 
 }
 
+/*
+ * Choose how the tuples of the table to evict are picked. The LRU chain is
+ * not maintained under CLOCK, so switching back to LRU rebuilds it from the
+ * tuples in storage order.
+ */
+void AntiCacheEvictionManager::setEvictionPolicy(PersistentTable* table, AntiCacheEvictionPolicy policy) {
+    if (table->getEvictionPolicy() == policy)
+        return;
+
+    VOLT_INFO("Switching table '%s' to %s eviction", table->name().c_str(),
+              (policy == ANTICACHE_EVICTION_CLOCK ? "CLOCK" : "LRU"));
+    table->setEvictionPolicy(policy);
+#ifndef ANTICACHE_TIMESTAMPS
+    table->setNumTuplesInEvictionChain(0);
+    if (policy != ANTICACHE_EVICTION_LRU)
+        return;
+
+    TableTuple tuple(table->m_schema);
+    TableTuple previous_tuple(table->m_schema);
+    uint32_t previous_id = 0;
+    int tuples_in_chain = 0;
+    for (uint32_t i = 0; i < table->usedTupleCount(); i++) {
+        tuple.move(table->dataPtrForTuple(i));
+        if (!tuple.isActive() || tuple.isEvicted())
+            continue;
+
+        if (tuples_in_chain == 0) {
+            table->setOldestTupleID(i);
+        } else {
+            previous_tuple.move(table->dataPtrForTuple(previous_id));
+            previous_tuple.setNextTupleInChain(i);
+            #ifdef ANTICACHE_REVERSIBLE_LRU
+            tuple.setPreviousTupleInChain(previous_id);
+            #endif
+        }
+        previous_id = i;
+        tuples_in_chain++;
+    }
+    table->setNewestTupleID(previous_id);
+    table->setNumTuplesInEvictionChain(tuples_in_chain);
+#endif
+}
+
 #ifndef ANTICACHE_TIMESTAMPS
 bool AntiCacheEvictionManager::removeTuple(PersistentTable* table, TableTuple* tuple) {
+    if (table->getEvictionPolicy() == ANTICACHE_EVICTION_CLOCK) // there is no chain to remove it from
+        return true;
+
     int current_tuple_id = table->getTupleID(tuple->address());
     
     // the removeTuple() method called is dependent on whether it is a single or double linked list
@@ -506,24 +731,21 @@ Table* AntiCacheEvictionManager::evictBlock(PersistentTable *table, long blockSi
     int32_t lastTuplesEvicted = table->getTuplesEvicted();
     int32_t lastBlocksEvicted = table->getBlocksEvicted();
     int64_t lastBytesEvicted  = table->getBytesEvicted();
+    AntiCacheCodecStats lastStats = getCodecStats(table->name());
     
+    int64_t start = LatencyHistogram::nowMicros();
     if (evictBlockToDisk(table, blockSize, numBlocks) == false) {
         throwFatalException("Failed to evict tuples from table '%s'", table->name().c_str());
     }
+    int64_t pauseMicros = LatencyHistogram::nowMicros() - start;
+    m_evictPauseLatency.record(pauseMicros);
     
     int32_t tuplesEvicted = table->getTuplesEvicted() - lastTuplesEvicted;
     int32_t blocksEvicted = table->getBlocksEvicted() - lastBlocksEvicted; 
     int64_t bytesEvicted = table->getBytesEvicted() - lastBytesEvicted;
     
     m_evictResultTable->deleteAllTuples(false);
-    TableTuple tuple = m_evictResultTable->tempTuple();
-    
-    int idx = 0;
-    tuple.setNValue(idx++, ValueFactory::getStringValue(table->name()));
-    tuple.setNValue(idx++, ValueFactory::getIntegerValue(static_cast<int32_t>(tuplesEvicted)));
-    tuple.setNValue(idx++, ValueFactory::getIntegerValue(static_cast<int32_t>(blocksEvicted)));
-    tuple.setNValue(idx++, ValueFactory::getBigIntValue(static_cast<int32_t>(bytesEvicted)));
-    m_evictResultTable->insertTuple(tuple);
+    addEvictResultRow(table, tuplesEvicted, blocksEvicted, bytesEvicted, lastStats, pauseMicros);
     
     return (m_evictResultTable);
 }
@@ -569,18 +791,16 @@ bool AntiCacheEvictionManager::evictBlockToDisk(PersistentTable *table, const lo
         // For now use the single AntiCacheDB from PersistentTable but in the future, this 
         // method to get the AntiCacheDB will have to choose which AntiCacheDB from to
         // evict to
-        antiCacheDB = table->getAntiCacheDB(chooseDB(block_size, m_migrate));
-        // get the LS16B and send that to the antiCacheDB
-        int16_t _block_id = antiCacheDB->nextBlockId();
+        int64_t _block_id;
+        antiCacheDB = nextEvictedBlockId(table, block_size, _block_id);
 
-        int32_t block_id = (int32_t)antiCacheDB->getACID();
-        block_id = ((block_id << 16) | (int32_t)_block_id); 
+        int64_t block_id = AntiCacheDB::packBlockId(antiCacheDB->getACID(), _block_id);
 
 
         // create a new evicted table tuple based on the schema for the source tuple
         TableTuple evicted_tuple = evictedTable->tempTuple();
-        VOLT_DEBUG("Setting %s tuple blockId %8x at offset %d", evictedTable->name().c_str(), block_id,0);
-        evicted_tuple.setNValue(0, ValueFactory::getIntegerValue(block_id));   // Set the ID for this block
+        VOLT_DEBUG("Setting %s tuple blockId %lx at offset %d", evictedTable->name().c_str(), (long)block_id,0);
+        evicted_tuple.setNValue(0, ValueFactory::getBigIntValue(block_id));   // Set the ID for this block
         evicted_tuple.setNValue(1, ValueFactory::getIntegerValue(0));          // set the tuple offset of this block
 
         #ifdef VOLT_INFO_ENABLED
@@ -628,8 +848,8 @@ bool AntiCacheEvictionManager::evictBlockToDisk(PersistentTable *table, const lo
             // Populate the evicted_tuple with the block id and tuple offset
             // Make sure this tuple is marked as evicted, so that we know it is an evicted
             // tuple as we iterate through the index
-            VOLT_TRACE("block id is %d for table %s", block_id, table->name().c_str());
-            evicted_tuple.setNValue(0, ValueFactory::getIntegerValue(block_id)); // BLOCK ID
+            VOLT_TRACE("block id is %ld for table %s", (long)block_id, table->name().c_str());
+            evicted_tuple.setNValue(0, ValueFactory::getBigIntValue(block_id)); // BLOCK ID
             evicted_tuple.setNValue(1, ValueFactory::getIntegerValue(num_tuples_evicted)); // OFFSET
             evicted_tuple.setEvictedTrue();
             VOLT_TRACE("EvictedTuple: %s", evicted_tuple.debug(evictedTable->name()).c_str());
@@ -638,7 +858,7 @@ bool AntiCacheEvictionManager::evictBlockToDisk(PersistentTable *table, const lo
             const void* evicted_tuple_address = static_cast<EvictedTable*>(evictedTable)->insertEvictedTuple(evicted_tuple);
             VOLT_TRACE("block address is %p", evicted_tuple_address);
             // Change all of the indexes to point to our new evicted tuple
-            table->setEntryToNewAddressForAllIndexes(&tuple, evicted_tuple_address, tuple.address());
+            evictIndexEntries(table, tuple, evicted_tuple_address, block_id);
 
             block.addTuple(tuple);
 
@@ -648,8 +868,8 @@ bool AntiCacheEvictionManager::evictBlockToDisk(PersistentTable *table, const lo
             table->deleteTupleStorage(tuple);
 
             num_tuples_evicted++;
-            VOLT_DEBUG("Added new evicted %s tuple to block #%8x [tuplesEvicted=%d]",
-                       table->name().c_str(), block_id, num_tuples_evicted);
+            VOLT_DEBUG("Added new evicted %s tuple to block #%lx [tuplesEvicted=%d]",
+                       table->name().c_str(), (long)block_id, num_tuples_evicted);
 
         } // WHILE
         VOLT_DEBUG("Finished evictable tuple iterator for %s [tuplesEvicted=%d]",
@@ -668,32 +888,15 @@ bool AntiCacheEvictionManager::evictBlockToDisk(PersistentTable *table, const lo
             timer.restart();
             #endif
 
-            long blocksize = block.getSerializedSize();
-
-            char* blockdata = new char[blocksize];
-            memcpy(blockdata, block.getSerializedData(), blocksize);
-            /*
-            for (int i = 0; i < blocksize; i++) {
-                printf( "%x", blockdata[i]);
-            }
-            cout << "\n";
-            */
-            // TODO: make this look like
-            // block.flush();
-            //  antiCacheDB->writeBlock(block);
-            antiCacheDB->writeBlock(table->name(),
-                                    _block_id,
-                                    num_tuples_evicted,
-                                    blockdata,
-                                    blocksize);
+            writeEvictedBlock(antiCacheDB, table->name(), _block_id, num_tuples_evicted, block);
             
             // MJG: We need to check whether we're reusing a blockID.
 
             bool reused = table->removeUnevictedBlockID(block_id);
             if (reused) {
-                VOLT_INFO("Reusing block_id %x, should be safe", block_id);
+                VOLT_INFO("Reusing block_id %lx, should be safe", (long)block_id);
             } else {
-                VOLT_DEBUG("First time block_id %x has been used", block_id);
+                VOLT_DEBUG("First time block_id %lx has been used", (long)block_id);
             }
 
             needs_flush = true;
@@ -724,8 +927,8 @@ bool AntiCacheEvictionManager::evictBlockToDisk(PersistentTable *table, const lo
 
             #ifdef VOLT_INFO_ENABLED
             VOLT_INFO("AntiCacheDB Time: %.2f sec", timer.elapsed());
-            VOLT_INFO("Evicted Block #%x for %s [tuples=%d / size=%ld / tupleLen=%d]",
-                      block_id, table->name().c_str(),
+            VOLT_INFO("Evicted Block #%lx for %s [tuples=%d / size=%ld / tupleLen=%d]",
+                      (long)block_id, table->name().c_str(),
                       num_tuples_evicted, m_bytesEvicted, tuple_length);
 //            VOLT_INFO("%s EvictedTable [origCount:%ld / newCount:%ld]",
 //                      name().c_str(), (long)origEvictedTableSize, (long)evictedTable->activeTupleCount());
@@ -737,7 +940,8 @@ bool AntiCacheEvictionManager::evictBlockToDisk(PersistentTable *table, const lo
 
     }  // FOR
 
-    if (needs_flush) {
+    // the background writer flushes once its queue runs empty
+    if (needs_flush && m_writer.isRunning() == false) {
         #ifdef VOLT_INFO_ENABLED
         boost::timer timer;
         #endif
@@ -816,15 +1020,15 @@ bool AntiCacheEvictionManager::evictBlockToDiskInBatch(PersistentTable *table, P
    //     this->printLRUChain(table, 4, true);
     //    VOLT_INFO("Printing child's LRU chain");
    //     this->printLRUChain(childTable, 4, true);
-        antiCacheDB = table->getAntiCacheDB(chooseDB(block_size, m_migrate));
         // get a unique block id from the executorContext
-        int16_t _block_id = antiCacheDB->nextBlockId();
-        int32_t block_id = ((antiCacheDB->getACID() << 16) | _block_id);
+        int64_t _block_id;
+        antiCacheDB = nextEvictedBlockId(table, block_size, _block_id);
+        int64_t block_id = AntiCacheDB::packBlockId(antiCacheDB->getACID(), _block_id);
 
         // create a new evicted table tuple based on the schema for the source tuple
         TableTuple evicted_tuple = evictedTable->tempTuple();
    //     VOLT_DEBUG("Setting %s tuple blockId at offset %d", evictedTable->name().c_str(), 0);
-        evicted_tuple.setNValue(0, ValueFactory::getIntegerValue(block_id));   // Set the ID for this block
+        evicted_tuple.setNValue(0, ValueFactory::getBigIntValue(block_id));   // Set the ID for this block
         evicted_tuple.setNValue(1, ValueFactory::getIntegerValue(0));          // set the tuple offset of this block
 
        // #ifdef VOLT_INFO_ENABLED
@@ -924,7 +1128,7 @@ bool AntiCacheEvictionManager::evictBlockToDiskInBatch(PersistentTable *table, P
             // Populate the evicted_tuple with the block id and tuple offset
             // Make sure this tuple is marked as evicted, so that we know it is an evicted
             // tuple as we iterate through the index
-            evicted_tuple.setNValue(0, ValueFactory::getIntegerValue(block_id));
+            evicted_tuple.setNValue(0, ValueFactory::getBigIntValue(block_id));
             evicted_tuple.setNValue(1, ValueFactory::getIntegerValue(num_tuples_evicted));
             evicted_tuple.setEvictedTrue();
             //VOLT_INFO("EvictedTuple: %s", evicted_tuple.debug(evictedTable->name()).c_str());
@@ -933,7 +1137,7 @@ bool AntiCacheEvictionManager::evictBlockToDiskInBatch(PersistentTable *table, P
             const void* evicted_tuple_address = static_cast<EvictedTable*>(evictedTable)->insertEvictedTuple(evicted_tuple);
 
             // Change all of the indexes to point to our new evicted tuple
-            table->setEntryToNewAddressForAllIndexes(&tuple, evicted_tuple_address, tuple.address());
+            evictIndexEntries(table, tuple, evicted_tuple_address, block_id);
 
             block.addTuple(tuple);
 
@@ -943,8 +1147,8 @@ bool AntiCacheEvictionManager::evictBlockToDiskInBatch(PersistentTable *table, P
 
 
             num_tuples_evicted++;
-            VOLT_DEBUG("Added new evicted %s tuple to block #%x [tuplesEvicted=%d]",
-                    table->name().c_str(), block_id, num_tuples_evicted);
+            VOLT_DEBUG("Added new evicted %s tuple to block #%lx [tuplesEvicted=%d]",
+                    table->name().c_str(), (long)block_id, num_tuples_evicted);
             if(block.getSerializedSize() + childTuplesSize >= block_size){
                 break;
             }
@@ -957,7 +1161,7 @@ bool AntiCacheEvictionManager::evictBlockToDiskInBatch(PersistentTable *table, P
             TableTuple childTuple(childTable->m_schema);
             TableTuple child_evicted_tuple = child_evictedTable->tempTuple();
             VOLT_INFO("Setting %s tuple blockId at offset %d", child_evictedTable->name().c_str(), 0);
-            child_evicted_tuple.setNValue(0, ValueFactory::getIntegerValue(block_id));   // Set the ID for this block
+            child_evicted_tuple.setNValue(0, ValueFactory::getBigIntValue(block_id));   // Set the ID for this block
             child_evicted_tuple.setNValue(1, ValueFactory::getIntegerValue(0));          // set the tuple offset of this block
 
             childTuple = *it;
@@ -968,7 +1172,7 @@ bool AntiCacheEvictionManager::evictBlockToDiskInBatch(PersistentTable *table, P
             // Populate the evicted_tuple with the block id and tuple offset
             // Make sure this tuple is marked as evicted, so that we know it is an evicted
             // tuple as we iterate through the index
-            child_evicted_tuple.setNValue(0, ValueFactory::getIntegerValue(block_id));
+            child_evicted_tuple.setNValue(0, ValueFactory::getBigIntValue(block_id));
             child_evicted_tuple.setNValue(1, ValueFactory::getIntegerValue(childTuples));
             child_evicted_tuple.setEvictedTrue();
             VOLT_INFO("EvictedTuple: %s", child_evicted_tuple.debug(child_evictedTable->name()).c_str());
@@ -977,7 +1181,7 @@ bool AntiCacheEvictionManager::evictBlockToDiskInBatch(PersistentTable *table, P
             const void* evicted_tuple_address = static_cast<EvictedTable*>(child_evictedTable)->insertEvictedTuple(child_evicted_tuple);
 
             // Change all of the indexes to point to our new evicted tuple
-            childTable->setEntryToNewAddressForAllIndexes(&childTuple, evicted_tuple_address, childTuple.address());
+            evictIndexEntries(childTable, childTuple, evicted_tuple_address, block_id);
 
             //VOLT_INFO("tuple foreign key id %d", ValuePeeker::peekAsInteger(childTuple.getNValue(foreignKeyIndexColumn)));
             VOLT_INFO("EvictedTuple: %s", childTuple.debug(childTable->name()).c_str());
@@ -1021,11 +1225,7 @@ bool AntiCacheEvictionManager::evictBlockToDiskInBatch(PersistentTable *table, P
             //          antiCacheDB->writeBlock(block);
 
 
-            antiCacheDB->writeBlock(table->name(),
-                    _block_id,
-                    num_tuples_evicted,
-                    block.getSerializedData(),
-                    block.getSerializedSize());
+            writeEvictedBlock(antiCacheDB, table->name(), _block_id, num_tuples_evicted, block);
             needs_flush = true;
 
 
@@ -1078,7 +1278,8 @@ bool AntiCacheEvictionManager::evictBlockToDiskInBatch(PersistentTable *table, P
 
     }  // FOR
 
-    if (needs_flush) {
+    // the background writer flushes once its queue runs empty
+    if (needs_flush && m_writer.isRunning() == false) {
         //     #ifdef VOLT_INFO_ENABLED
         //   boost::timer timer;
         //    #endif
@@ -1103,35 +1304,29 @@ Table* AntiCacheEvictionManager::evictBlockInBatch(PersistentTable *table, Persi
     int32_t childLastTuplesEvicted = childTable->getTuplesEvicted();
     int32_t childLastBlocksEvicted = childTable->getBlocksEvicted();
     int64_t childLastBytesEvicted  = childTable->getBytesEvicted();
+    AntiCacheCodecStats lastStats = getCodecStats(table->name());
+    AntiCacheCodecStats childLastStats = getCodecStats(childTable->name());
 
+    int64_t start = LatencyHistogram::nowMicros();
     if (evictBlockToDiskInBatch(table, childTable, blockSize, numBlocks) == false) {
         throwFatalException("Failed to evict tuples from table '%s'", table->name().c_str());
     }
+    int64_t pauseMicros = LatencyHistogram::nowMicros() - start;
+    m_evictPauseLatency.record(pauseMicros);
 
     int32_t tuplesEvicted = table->getTuplesEvicted() - lastTuplesEvicted;
     int32_t blocksEvicted = table->getBlocksEvicted() - lastBlocksEvicted;
     int64_t bytesEvicted = table->getBytesEvicted() - lastBytesEvicted;
 
     m_evictResultTable->deleteAllTuples(false);
-    TableTuple tuple = m_evictResultTable->tempTuple();
-
-    int idx = 0;
-    tuple.setNValue(idx++, ValueFactory::getStringValue(table->name()));
-    tuple.setNValue(idx++, ValueFactory::getIntegerValue(static_cast<int32_t>(tuplesEvicted)));
-    tuple.setNValue(idx++, ValueFactory::getIntegerValue(static_cast<int32_t>(blocksEvicted)));
-    tuple.setNValue(idx++, ValueFactory::getBigIntValue(static_cast<int32_t>(bytesEvicted)));
-    m_evictResultTable->insertTuple(tuple);
+    addEvictResultRow(table, tuplesEvicted, blocksEvicted, bytesEvicted, lastStats, pauseMicros);
 
     int32_t childTuplesEvicted = childTable->getTuplesEvicted() - childLastTuplesEvicted;
     int32_t childBlocksEvicted = childTable->getBlocksEvicted() - childLastBlocksEvicted;
     int64_t childBytesEvicted = childTable->getBytesEvicted() - childLastBytesEvicted;
 
-    idx = 0;
-    tuple.setNValue(idx++, ValueFactory::getStringValue(childTable->name()));
-    tuple.setNValue(idx++, ValueFactory::getIntegerValue(static_cast<int32_t>(childTuplesEvicted)));
-    tuple.setNValue(idx++, ValueFactory::getIntegerValue(static_cast<int32_t>(childBlocksEvicted)));
-    tuple.setNValue(idx++, ValueFactory::getBigIntValue(static_cast<int32_t>(childBytesEvicted)));
-    m_evictResultTable->insertTuple(tuple);
+    // the pause is reported once, with the parent
+    addEvictResultRow(childTable, childTuplesEvicted, childBlocksEvicted, childBytesEvicted, childLastStats, 0);
 
     return (m_evictResultTable);
 }
@@ -1153,20 +1348,27 @@ Table* AntiCacheEvictionManager::evictBlockInBatch(PersistentTable *table, Persi
 //     return (m_readResultTable);
 // }
     
-bool AntiCacheEvictionManager::readEvictedBlock(PersistentTable *table, int32_t block_id, int32_t tuple_offset) {
+bool AntiCacheEvictionManager::readEvictedBlock(PersistentTable *table, int64_t block_id, int32_t tuple_offset) {
+
+    // the block may not have reached its AntiCacheDB yet
+    m_writer.drain();
+    block_id = resolveBlockId(block_id);
 
     bool already_unevicted = table->isAlreadyUnEvicted(block_id);
     if (already_unevicted) { // this block has already been read
-        VOLT_WARN("Block %d has already been read.", block_id);
+        VOLT_WARN("Block %lx has already been read.", (long)block_id);
+        return true;
+    }
+    if (table->mergeStrategy() == false && readEvictedTuple(table, block_id, tuple_offset)) {
         return true;
     }
 
     /*
      * Finds the AntiCacheDB* instance associated with the needed block_id
      */
-    int16_t _block_id = (int16_t)(block_id & 0x0000FFFF);
-    int16_t ACID = (int16_t)((block_id & 0xFFFF0000) >> 16);
-    VOLT_DEBUG("block_id: %d ACID: %d _block_id: %d\n", block_id, ACID, _block_id);
+    int64_t _block_id = AntiCacheDB::unpackBlockId(block_id);
+    int16_t ACID = AntiCacheDB::unpackACID(block_id);
+    VOLT_DEBUG("block_id: %lx ACID: %d _block_id: %ld\n", (long)block_id, ACID, (long)_block_id);
 
     AntiCacheDB* antiCacheDB = m_db_lookup[ACID]; 
     
@@ -1185,41 +1387,11 @@ bool AntiCacheEvictionManager::readEvictedBlock(PersistentTable *table, int32_t
     //AntiCacheDB* antiCacheDB = table->getAntiCacheDB();
 
     try {
+        int64_t start = LatencyHistogram::nowMicros();
         AntiCacheBlock* value = antiCacheDB->readBlock(_block_id);
-
-        // allocate the memory for this block
-        char* unevicted_tuples = new char[value->getSize()];
-        memcpy(unevicted_tuples, value->getData(), value->getSize());
-        /*
-        for (int i = 0; i < 200; i++) {
-            printf( "%X", unevicted_tuples[i]);
-        }
-        cout << "\n";*/
-        VOLT_INFO("***************** READ EVICTED BLOCK %d *****************", _block_id);
-        VOLT_INFO("Block Size = %ld / Table = %s", value->getSize(), table->name().c_str());
-        ReferenceSerializeInput in(unevicted_tuples, value->getSize());
-        
-        // Read in all the block meta-data
-        int num_tables = in.readInt();
-        VOLT_DEBUG("num tables is %d", num_tables);
-        std::vector<std::string> tableNames;
-        std::vector<int> numTuples;
-        for(int j = 0; j < num_tables; j++){
-            std::string name = in.readTextString();
-            tableNames.push_back(name);
-            VOLT_DEBUG("tableName is %s", name.c_str());
-            int tuples = in.readInt();
-            numTuples.push_back(tuples);
-            VOLT_DEBUG("num tuples is %d", tuples);
-        }
-
-        table->insertUnevictedBlock(unevicted_tuples);
-        VOLT_DEBUG("BLOCK %d - unevicted blocks size is %d",
-                   _block_id, static_cast<int>(table->unevictedBlocksSize()));
-        table->insertTupleOffset(tuple_offset);
-
-
-        table->insertUnevictedBlockID(std::pair<int32_t,int16_t>(block_id, 0));
+        m_tierStats[ACID].blocksRead++;
+        m_tierStats[ACID].readLatency.record(LatencyHistogram::nowMicros() - start);
+        installUnevictedBlock(table, block_id, tuple_offset, value);
         delete value;
     } catch (UnknownBlockAccessException e) {
         throw e;
@@ -1234,6 +1406,344 @@ bool AntiCacheEvictionManager::readEvictedBlock(PersistentTable *table, int32_t
 }
 
 
+void AntiCacheEvictionManager::installUnevictedBlock(PersistentTable *table, int64_t block_id,
+                                                     int32_t tuple_offset, AntiCacheBlock* value) {
+    // allocate the memory for this block, restoring it if it was compressed
+    long unevicted_size;
+    char* unevicted_tuples = m_codec.decompressBlock(table->name(), value->getData(),
+                                                     value->getSize(), unevicted_size);
+    VOLT_INFO("***************** READ EVICTED BLOCK %ld *****************", (long)value->getBlockId());
+    VOLT_INFO("Block Size = %ld / Raw Size = %ld / Table = %s",
+              value->getSize(), unevicted_size, table->name().c_str());
+    ReferenceSerializeInput in(unevicted_tuples, unevicted_size);
+    
+    // Read in all the block meta-data
+    int num_tables = in.readInt();
+    VOLT_DEBUG("num tables is %d", num_tables);
+    std::vector<std::string> tableNames;
+    std::vector<int> numTuples;
+    for(int j = 0; j < num_tables; j++){
+        std::string name = in.readTextString();
+        tableNames.push_back(name);
+        VOLT_DEBUG("tableName is %s", name.c_str());
+        int tuples = in.readInt();
+        numTuples.push_back(tuples);
+        VOLT_DEBUG("num tuples is %d", tuples);
+        in.readInt(); // tuple directory offset
+    }
+
+    // some of its tuples may have been merged on their own already
+    AntiCacheMutexGuard guard(m_blockMutex);
+    std::map<int64_t, PartialBlock>::iterator partial = m_partialBlocks.find(block_id);
+    if (partial != m_partialBlocks.end()) {
+        VOLT_DEBUG("Block %lx has %d of %d tuples still evicted", (long)block_id,
+                   partial->second.remaining, (int)partial->second.unevicted.size());
+        m_mergeInfo[unevicted_tuples].skip.swap(partial->second.unevicted);
+        m_partialBlocks.erase(partial);
+    }
+
+    table->insertUnevictedBlock(unevicted_tuples);
+    VOLT_DEBUG("BLOCK %ld - unevicted blocks size is %d",
+               (long)value->getBlockId(), static_cast<int>(table->unevictedBlocksSize()));
+    table->insertTupleOffset(tuple_offset);
+
+    table->insertUnevictedBlockID(std::pair<int64_t,int32_t>(block_id, 0));
+    // key ranges are kept under the id the block was evicted with
+    std::map<int64_t, int64_t>::iterator from = m_movedFrom.find(block_id);
+    m_mergeInfo[unevicted_tuples].blockId = (from == m_movedFrom.end() ? block_id : from->second);
+    forgetBlock(block_id);
+}
+
+/*
+ * Start reading all of the requested blocks at once. The reads for each
+ * AntiCacheDB go out in a single submitReads() call so that a database
+ * that reads in the background has all of them in flight together. The
+ * blocks are picked up by completeFetches() when the transaction that
+ * needs them is merged.
+ */
+bool AntiCacheEvictionManager::readEvictedBlocks(PersistentTable *table, int numBlocks,
+                                                 int64_t blockIds[], int32_t tupleOffsets[]) {
+    submitBlockReads(table, numBlocks, blockIds, tupleOffsets);
+    return true;
+}
+
+/*
+ * Returns how many of the blocks are now being read, or had their tuple read
+ * right away
+ */
+int AntiCacheEvictionManager::submitBlockReads(PersistentTable *table, int numBlocks,
+                                               int64_t blockIds[], int32_t tupleOffsets[]) {
+    m_writer.drain();
+    int started = 0;
+    std::map<int16_t, std::vector<int> > requests;
+    std::set<int64_t> requested;
+    for (int i = 0; i < numBlocks; i++) {
+        // ids handed out before a migration still find their block
+        blockIds[i] = resolveBlockId(blockIds[i]);
+        if (table->isAlreadyUnEvicted(blockIds[i]) || isFetchPending(table, blockIds[i]) ||
+            requested.find(blockIds[i]) != requested.end()) {
+            VOLT_WARN("Block %lx has already been read.", (long)blockIds[i]);
+            continue;
+        }
+        // tables that merge single tuples only read the tuple if they can
+        if (table->mergeStrategy() == false && readEvictedTuple(table, blockIds[i], tupleOffsets[i])) {
+            started++;
+            continue;
+        }
+        int16_t ACID = AntiCacheDB::unpackACID(blockIds[i]);
+        requests[ACID].push_back(i);
+        requested.insert(blockIds[i]);
+    }
+
+    int64_t submitted = LatencyHistogram::nowMicros();
+    for (std::map<int16_t, std::vector<int> >::iterator it = requests.begin(); it != requests.end(); ++it) {
+        AntiCacheDB* antiCacheDB = m_db_lookup[it->first];
+        std::vector<int64_t> ids;
+        for (std::vector<int>::iterator i = it->second.begin(); i != it->second.end(); ++i) {
+            ids.push_back(AntiCacheDB::unpackBlockId(blockIds[*i]));
+        }
+        antiCacheDB->submitReads(ids);
+
+        // completeFetches() runs on the site thread
+        AntiCacheMutexGuard guard(m_fetchMutex);
+        for (std::vector<int>::iterator i = it->second.begin(); i != it->second.end(); ++i) {
+            PendingFetch fetch;
+            fetch.table = table;
+            fetch.blockId = blockIds[*i];
+            fetch.tupleOffset = tupleOffsets[*i];
+            fetch.submitted = submitted;
+            m_pendingFetches.push_back(fetch);
+        }
+        started += (int)ids.size();
+        VOLT_DEBUG("Submitted %d block reads to ACID %d", (int)ids.size(), it->first);
+    }
+    return started;
+}
+
+/*
+ * Read one evicted tuple and leave the rest of its block in the AntiCacheDB.
+ * The tuple is found through the block's tuple directory, which is read the
+ * first time a tuple of the block is needed and kept until the block goes.
+ * Returns false if the whole block has to be read instead: the AntiCacheDB
+ * only reads whole blocks, the block is compressed or holds more than one
+ * table, the table dropped index entries of its evicted tuples, or this is
+ * its last evicted tuple, so reading the block frees it.
+ */
+bool AntiCacheEvictionManager::readEvictedTuple(PersistentTable *table, int64_t block_id, int32_t tuple_offset) {
+    // the key ranges of a block with dropped index entries go all at once
+    if (table->getEvictedIndexRanges() != NULL) {
+        return false;
+    }
+    int64_t start = LatencyHistogram::nowMicros();
+    int64_t _block_id = AntiCacheDB::unpackBlockId(block_id);
+    int16_t ACID = AntiCacheDB::unpackACID(block_id);
+    AntiCacheDB* antiCacheDB = m_db_lookup[ACID];
+
+    // the site thread migrates blocks and ages their access counts
+    AntiCacheMutexGuard guard(m_blockMutex);
+    std::map<int64_t, PartialBlock>::iterator partial = m_partialBlocks.find(block_id);
+    if (partial == m_partialBlocks.end()) {
+        char header[MAX_BLOCK_HEADER_SIZE];
+        long size = antiCacheDB->readBlockRange(_block_id, 0, MAX_BLOCK_HEADER_SIZE, header);
+        if (size < 0 || AntiCacheBlockCodec::isCompressed(header, size)) {
+            return false;
+        }
+        std::vector<std::string> tableNames;
+        std::vector<int> numTuples;
+        std::vector<int> directoryOffsets;
+        long headerSize;
+        if (BerkeleyDBBlock::readHeader(header, size, tableNames, numTuples, directoryOffsets, headerSize) == false ||
+            tableNames.size() != 1) {
+            return false;
+        }
+
+        long directorySize = (numTuples[0] + 1) * sizeof(int32_t);
+        std::vector<char> directory(directorySize);
+        if (antiCacheDB->readBlockRange(_block_id, directoryOffsets[0], directorySize, &directory[0]) != directorySize) {
+            throwFatalException("Failed to read the tuple directory of anti-cache block %lx", (long)block_id);
+        }
+        PartialBlock block;
+        ReferenceSerializeInput in(&directory[0], directorySize);
+        for (int i = 0; i <= numTuples[0]; i++) {
+            block.offsets.push_back(in.readInt());
+        }
+        block.unevicted.resize(numTuples[0], false);
+        block.remaining = numTuples[0];
+        partial = m_partialBlocks.insert(std::make_pair(block_id, block)).first;
+    }
+
+    PartialBlock &block = partial->second;
+    if (tuple_offset < 0 || tuple_offset >= static_cast<int32_t>(block.unevicted.size())) {
+        VOLT_WARN("Block %lx has no tuple at offset %d", (long)block_id, tuple_offset);
+        return false;
+    }
+    if (block.unevicted[tuple_offset]) {
+        VOLT_WARN("Tuple %d of block %lx has already been read.", tuple_offset, (long)block_id);
+        return true;
+    }
+    if (block.remaining == 1) {
+        return false;
+    }
+
+    // Lay the tuple out as a block of its own so that it is merged like any other
+    const std::string &name = table->name();
+    int32_t tupleSize = block.offsets[tuple_offset + 1] - block.offsets[tuple_offset];
+    long headerSize = 4 * sizeof(int32_t) + name.size();
+    long size = headerSize + tupleSize + 2 * sizeof(int32_t);
+    char* unevicted_tuple = new char[size];
+    ReferenceSerializeOutput out(unevicted_tuple, size);
+    out.writeInt(1);
+    out.writeTextString(name);
+    out.writeInt(1);
+    out.writeInt(static_cast<int32_t>(headerSize + tupleSize));
+    size_t tupleStart = out.reserveBytes(tupleSize);
+    out.writeInt(static_cast<int32_t>(headerSize));
+    out.writeInt(static_cast<int32_t>(headerSize + tupleSize));
+    if (antiCacheDB->readBlockRange(_block_id, block.offsets[tuple_offset], tupleSize,
+                                    unevicted_tuple + tupleStart) != tupleSize) {
+        delete [] unevicted_tuple;
+        throwFatalException("Failed to read tuple %d of anti-cache block %lx", tuple_offset, (long)block_id);
+    }
+
+    block.unevicted[tuple_offset] = true;
+    block.remaining--;
+
+    // the block stays where it is, count the access towards promoting it
+    antiCacheDB->touchBlockLRU(_block_id);
+    m_blockAccesses[block_id]++;
+    m_tierStats[ACID].tuplesRead++;
+    m_tierStats[ACID].readLatency.record(LatencyHistogram::nowMicros() - start);
+    VOLT_DEBUG("Read tuple %d of block %lx [size=%d / stillEvicted=%d]",
+               tuple_offset, (long)block_id, tupleSize, block.remaining);
+
+    table->insertUnevictedBlock(unevicted_tuple);
+    table->insertTupleOffset(0);
+    m_mergeInfo[unevicted_tuple].partial = true;
+    return true;
+}
+
+/*
+ * Keep what we know about a block when it moves to another AntiCacheDB
+ * under a new id: its partially read tuples, its access count and where
+ * the id it was first evicted under points to now
+ */
+void AntiCacheEvictionManager::renameMigratedBlock(int64_t block_id, int64_t new_block_id) {
+    AntiCacheMutexGuard guard(m_blockMutex);
+    std::map<int64_t, PartialBlock>::iterator partial = m_partialBlocks.find(block_id);
+    if (partial != m_partialBlocks.end()) {
+        m_partialBlocks[new_block_id] = partial->second;
+        m_partialBlocks.erase(block_id);
+    }
+
+    int32_t accesses = 0;
+    std::map<int64_t, int32_t>::iterator access = m_blockAccesses.find(block_id);
+    if (access != m_blockAccesses.end()) {
+        accesses = access->second;
+        m_blockAccesses.erase(access);
+    }
+    int64_t original = block_id;
+    std::map<int64_t, int64_t>::iterator from = m_movedFrom.find(block_id);
+    if (from != m_movedFrom.end()) {
+        original = from->second;
+        m_movedFrom.erase(from);
+    }
+
+    forgetBlock(new_block_id);
+    if (accesses > 0) {
+        m_blockAccesses[new_block_id] = accesses;
+    }
+    if (original != new_block_id) {
+        m_movedBlocks[original] = new_block_id;
+        m_movedFrom[new_block_id] = original;
+    }
+}
+
+int64_t AntiCacheEvictionManager::resolveBlockId(int64_t block_id) {
+    AntiCacheMutexGuard guard(m_blockMutex);
+    std::map<int64_t, int64_t>::const_iterator to = m_movedBlocks.find(block_id);
+    return (to == m_movedBlocks.end() ? block_id : to->second);
+}
+
+/*
+ * Drop the access count and forwarding of a block that was read back.
+ * Nothing points to the id it was evicted under anymore, so an id held
+ * back by nextFreeBlockId() can be handed out again.
+ */
+void AntiCacheEvictionManager::forgetBlock(int64_t block_id) {
+    AntiCacheMutexGuard guard(m_blockMutex);
+    m_blockAccesses.erase(block_id);
+    int64_t original = -1;
+    std::map<int64_t, int64_t>::iterator from = m_movedFrom.find(block_id);
+    if (from != m_movedFrom.end()) {
+        original = from->second;
+        m_movedBlocks.erase(from->second);
+        m_movedFrom.erase(from);
+    }
+    std::map<int64_t, int64_t>::iterator to = m_movedBlocks.find(block_id);
+    if (to != m_movedBlocks.end()) {
+        original = block_id;
+        m_movedFrom.erase(to->second);
+        m_movedBlocks.erase(to);
+    }
+    if (original != -1 && m_parkedIds.erase(original) > 0) {
+        m_releasedIds.push_back(original);
+    }
+}
+
+bool AntiCacheEvictionManager::hasPendingFetch(int16_t acid) {
+    AntiCacheMutexGuard guard(m_fetchMutex);
+    for (std::vector<PendingFetch>::const_iterator it = m_pendingFetches.begin(); it != m_pendingFetches.end(); ++it) {
+        if (AntiCacheDB::unpackACID(it->blockId) == acid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AntiCacheEvictionManager::isFetchPending(PersistentTable *table, int64_t block_id) {
+    AntiCacheMutexGuard guard(m_fetchMutex);
+    for (std::vector<PendingFetch>::const_iterator it = m_pendingFetches.begin(); it != m_pendingFetches.end(); ++it) {
+        if (it->table == table && it->blockId == block_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AntiCacheEvictionManager::completeFetches(PersistentTable *table) {
+    m_writer.drain();
+    while (true) {
+        // forget the fetch first, a failed read must not be retried forever
+        PendingFetch fetch;
+        {
+            AntiCacheMutexGuard guard(m_fetchMutex);
+            std::vector<PendingFetch>::iterator it = m_pendingFetches.begin();
+            while (it != m_pendingFetches.end() && it->table != table) {
+                ++it;
+            }
+            if (it == m_pendingFetches.end()) {
+                break;
+            }
+            fetch = *it;
+            m_pendingFetches.erase(it);
+        }
+
+        int64_t _block_id = AntiCacheDB::unpackBlockId(fetch.blockId);
+        int16_t ACID = AntiCacheDB::unpackACID(fetch.blockId);
+        int64_t start = LatencyHistogram::nowMicros();
+        AntiCacheBlock* value = m_db_lookup[ACID]->completeRead(_block_id);
+        int64_t now = LatencyHistogram::nowMicros();
+        m_fetchWaitLatency.record(now - start);
+        m_fetchLatency.record(now - fetch.submitted);
+        m_tierStats[ACID].blocksRead++;
+        m_tierStats[ACID].readLatency.record(now - fetch.submitted);
+
+        installUnevictedBlock(table, fetch.blockId, fetch.tupleOffset, value);
+        delete value;
+    }
+}
+
+
 // stub method that may either be implemented by plug in policies
 // or via class inheritance.
 
@@ -1241,6 +1751,16 @@ int AntiCacheEvictionManager::chooseDB() {
     return 0;
 }
 
+// Free blocks of an AntiCacheDB, less the blocks still queued for it
+long AntiCacheEvictionManager::freeBlocks(AntiCacheDB* acdb) {
+    long free_blocks;
+    {
+        AntiCacheBlockWriter::Guard guard(m_writer);
+        free_blocks = acdb->getFreeBlocks();
+    }
+    return free_blocks - m_writer.pendingBlocks(acdb);
+}
+
 // A version of chooseDB that takes blockSize. This will allow us to check if
 // a block will fit.
 
@@ -1255,9 +1775,9 @@ int AntiCacheEvictionManager::chooseDB(long blockSize) {
             continue;
         }
 
-        if (acdb->getFreeBlocks() < 1) {
-            VOLT_INFO("AntiCacheDB ACID: %d has %d free blocks", i, acdb->getFreeBlocks());
-            VOLT_DEBUG("maxBlocks: %d maxDBSize: %ld numBlocks %d",
+        if (freeBlocks(acdb) < 1) {
+            VOLT_INFO("AntiCacheDB ACID: %d has %ld free blocks", i, (long)freeBlocks(acdb));
+            VOLT_DEBUG("maxBlocks: %ld maxDBSize: %ld numBlocks %ld",
                     acdb->getMaxBlocks(), acdb->getMaxDBSize(), acdb->getNumBlocks());
             continue;
         }
@@ -1287,12 +1807,14 @@ int AntiCacheEvictionManager::chooseDB(long blockSize, bool migrate) {
                 continue;
             }
 
-            if (acdb->getFreeBlocks() < 1) {
-                VOLT_DEBUG("AntiCacheDB ACID: %d has %d free blocks", i, acdb->getFreeBlocks());
-                VOLT_DEBUG("maxBlocks: %d maxDBSize: %ld numBlocks %d",
+            if (freeBlocks(acdb) < 1) {
+                VOLT_DEBUG("AntiCacheDB ACID: %d has %ld free blocks", i, (long)freeBlocks(acdb));
+                // the LRU block to migrate may still be in the write queue
+                m_writer.drain();
+                VOLT_DEBUG("maxBlocks: %ld maxDBSize: %ld numBlocks %ld",
                     acdb->getMaxBlocks(), acdb->getMaxDBSize(), acdb->getNumBlocks());
                 AntiCacheDB* dst_acdb = m_db_lookup[i+1];
-                int32_t new_block_id = migrateLRUBlock(acdb, dst_acdb);
+                int64_t new_block_id = migrateLRUBlock(acdb, dst_acdb);
                 if (new_block_id == -1) {
                     // If we fail to migrate, an exception should have been thrown 
                     // before this so this should never happen. But ya never know
@@ -1320,24 +1842,28 @@ int AntiCacheEvictionManager::chooseDB(long blockSize, bool migrate) {
  * physical medium
  */
 
-int32_t AntiCacheEvictionManager::migrateBlock(int32_t block_id, AntiCacheDB* dstDB) {
-    int16_t _new_block_id = -1;
+int64_t AntiCacheEvictionManager::migrateBlock(int64_t block_id, AntiCacheDB* dstDB) {
+    int64_t _new_block_id = -1;
     int16_t new_acid;
-    int32_t new_block_id = 0;
+    int64_t new_block_id = 0;
+
+    m_writer.drain();
 
     if (dstDB->getFreeBlocks() == 0) {
         return _new_block_id;
     }
+    // a tuple of the block may be being read on the AntiCacheManager thread
+    AntiCacheMutexGuard guard(m_blockMutex);
     
-    int16_t acid = (int16_t)((block_id & 0xFFFF0000) >> 16);
-    int16_t _block_id = (int16_t)(block_id & 0x0000FFFF);
+    int16_t acid = AntiCacheDB::unpackACID(block_id);
+    int64_t _block_id = AntiCacheDB::unpackBlockId(block_id);
     AntiCacheDB* srcDB = m_db_lookup[acid];
 
-    VOLT_TRACE("source: block_id: %x _block_id: %x acid: %x",
-            block_id, _block_id, acid);
+    VOLT_TRACE("source: block_id: %lx _block_id: %lx acid: %x",
+            (long)block_id, (long)_block_id, acid);
     AntiCacheBlock* block = srcDB->readBlock(_block_id);    
     //VOLT_DEBUG("oldname: %s\n", block->getTableName().c_str());
-    _new_block_id = dstDB->nextBlockId();
+    _new_block_id = nextFreeBlockId(dstDB);
     
     //VOLT_DEBUG("tablename: %s newBlockId: %d, data: %s, size: %ld\n", block->getTableName().c_str(), newBlockId,
     //        block->getData(), block->getSize());
@@ -1346,31 +1872,11 @@ int32_t AntiCacheEvictionManager::migrateBlock(int32_t block_id, AntiCacheDB* ds
 
     new_acid = dstDB->getACID();
 
-    new_block_id = (int32_t) _new_block_id;
-    new_block_id = new_block_id | (new_acid << 16);
-    VOLT_DEBUG("block_id: %x _block_id: %x acid: %x new_block_id: %x _new_block_id: %x new_acid: %x",
-            block_id, _block_id, acid, new_block_id, _new_block_id, new_acid);
-
-    std::string tableName = block->getTableName();
-    PersistentTable *table = dynamic_cast<PersistentTable*>(m_engine->getTable(tableName));
-    if (table) {
-        EvictedTable *etable = dynamic_cast<EvictedTable*>(table->getEvictedTable());
-        if (etable) {
-            TableTuple tuple(etable->m_schema);
-
-            voltdb::TableIterator it(etable);
-            while (it.next(tuple)) {
-                if ((int32_t)ValuePeeker::peekInteger(tuple.getNValue(0)) == block_id) {
-                    tuple.setNValue(0, ValueFactory::getIntegerValue(new_block_id));
-                    VOLT_DEBUG("Updating tuple blockid from %8x to %8x", block_id, new_block_id);
-                }
-            }
-        } else {
-            VOLT_WARN("No evicted table! If this is an EE test, shouldn't be a problem");
-        }
-    } else {
-        VOLT_WARN("No persistent table! If this is an EE test, shouldn't be a problem");
-    }
+    new_block_id = AntiCacheDB::packBlockId(new_acid, _new_block_id);
+    VOLT_DEBUG("block_id: %lx _block_id: %lx acid: %x new_block_id: %lx _new_block_id: %lx new_acid: %x",
+            (long)block_id, (long)_block_id, acid, (long)new_block_id, (long)_new_block_id, new_acid);
+    // the evicted tuples keep the old id, reads of it are forwarded
+    renameMigratedBlock(block_id, new_block_id);
 
     delete block;
     return new_block_id;
@@ -1385,59 +1891,41 @@ int32_t AntiCacheEvictionManager::migrateBlock(int32_t block_id, AntiCacheDB* ds
  * returning -1.
  */
 
-int32_t AntiCacheEvictionManager::migrateLRUBlock(AntiCacheDB* srcDB, AntiCacheDB* dstDB) {
-    int16_t _new_block_id = -1;
+int64_t AntiCacheEvictionManager::migrateLRUBlock(AntiCacheDB* srcDB, AntiCacheDB* dstDB) {
+    int64_t _new_block_id = -1;
     int16_t new_acid;
-    int32_t new_block_id = 0;
+    int64_t new_block_id = 0;
 
+    m_writer.drain();
     if (dstDB->getFreeBlocks() == 0) {
-        return (int32_t) _new_block_id;
+        return _new_block_id;
     }
-
+    AntiCacheMutexGuard guard(m_blockMutex);
 
     AntiCacheBlock* block = srcDB->getLRUBlock();
-    int32_t block_id = block->getBlockId();
-    _new_block_id = dstDB->nextBlockId();
+    int64_t block_id = AntiCacheDB::packBlockId(srcDB->getACID(), block->getBlockId());
+    _new_block_id = nextFreeBlockId(dstDB);
     
-    VOLT_DEBUG("block_id: %8x _new_block_id: %8x", block_id, _new_block_id);
+    VOLT_DEBUG("block_id: %lx _new_block_id: %lx", (long)block_id, (long)_new_block_id);
 
     // if we don't get a new block_id, we can at least try to write it back
     // then throw an exception. at this point, it's probably best for it to be fatal
     if (_new_block_id == -1) {
-        _new_block_id = srcDB->nextBlockId();
+        _new_block_id = nextFreeBlockId(srcDB);
         srcDB->writeBlock(block->getTableName(), _new_block_id, 0, block->getData(), block->getSize());
+        renameMigratedBlock(block_id, AntiCacheDB::packBlockId(srcDB->getACID(), _new_block_id));
         VOLT_ERROR("No room in the destination backing store!");
-        throw FullBackingStoreException((int32_t)_new_block_id, -1);
+        throw FullBackingStoreException(AntiCacheDB::packBlockId(srcDB->getACID(), _new_block_id), -1);
     }
     
     dstDB->writeBlock(block->getTableName(), _new_block_id, 0, block->getData(), block->getSize());
     
     new_acid = dstDB->getACID();
-    new_block_id = (int32_t) _new_block_id;
-    new_block_id = new_block_id | (new_acid << 16);
-    VOLT_DEBUG("new_block_id: %x _new_block_id: %x new_acid: %x",
-            new_block_id, _new_block_id, new_acid);
-
-    std::string tableName = block->getTableName();
-    PersistentTable *table = dynamic_cast<PersistentTable*>(m_engine->getTable(tableName));
-    if (table) {
-        EvictedTable *etable = dynamic_cast<EvictedTable*>(table->getEvictedTable());
-        if (etable) {
-            TableTuple tuple(etable->m_schema);
-
-            voltdb::TableIterator it(etable);
-            while (it.next(tuple)) {
-                if ((int32_t)ValuePeeker::peekInteger(tuple.getNValue(0)) == block_id) {
-                    tuple.setNValue(0, ValueFactory::getIntegerValue(new_block_id));
-                    VOLT_TRACE("Updating tuple blockid from %8x to %8x", block_id, new_block_id);
-                }
-            }
-        } else {
-            VOLT_WARN("No evicted table! If this is an EE test, shouldn't be a problem");
-        }
-    } else {
-        VOLT_WARN("No persistent table! If this is an EE test, shouldn't be a problem");
-    }
+    new_block_id = AntiCacheDB::packBlockId(new_acid, _new_block_id);
+    VOLT_DEBUG("new_block_id: %lx _new_block_id: %lx new_acid: %x",
+            (long)new_block_id, (long)_new_block_id, new_acid);
+    // the evicted tuples keep the old id, reads of it are forwarded
+    renameMigratedBlock(block_id, new_block_id);
 
     // MJG TODO!!!: We can't just delete this block willy nilly if we can't get a new_block_id. 
     // Have to do something better than this. XXX
@@ -1475,11 +1963,103 @@ AntiCacheDB* AntiCacheEvictionManager::getAntiCacheDB(int acid) {
     }
 }    
 
+bool AntiCacheEvictionManager::setTierPolicy(int promoteAccesses, int demotePercent) {
+    if (demotePercent < 1 || demotePercent > 100) {
+        VOLT_ERROR("Invalid anti-cache demotion watermark %d%%", demotePercent);
+        return false;
+    }
+    m_promoteAccesses = (promoteAccesses > 0 ? promoteAccesses : 0);
+    m_demotePercent = demotePercent;
+    VOLT_INFO("Anti-cache tier policy [promoteAccesses=%d / demotePercent=%d]",
+              m_promoteAccesses, m_demotePercent);
+    return true;
+}
+
+int AntiCacheEvictionManager::tick() {
+    // with the default policy nothing would ever move
+    if (m_numdbs < 2 || (m_promoteAccesses == 0 && m_demotePercent == 100)) {
+        return 0;
+    }
+    return migrateTiers(MIGRATE_BLOCKS_PER_TICK);
+}
+
+/*
+ * Demote first so that the faster tiers have room for the blocks promoted
+ * after. A tier with block reads in flight is left alone, since the block
+ * a read is waiting for must not move.
+ */
+int AntiCacheEvictionManager::migrateTiers(int maxBlocks) {
+    m_writer.drain();
+    int moved = 0;
+
+    for (int i = 0; i < m_numdbs - 1 && moved < maxBlocks; i++) {
+        AntiCacheDB* srcDB = m_db_lookup[i];
+        AntiCacheDB* dstDB = m_db_lookup[i+1];
+        if (hasPendingFetch(srcDB->getACID())) {
+            continue;
+        }
+        int64_t watermark = srcDB->getMaxBlocks() * m_demotePercent / 100;
+        while (moved < maxBlocks && srcDB->getNumBlocks() > watermark && dstDB->getFreeBlocks() > 0) {
+            if (migrateLRUBlock(srcDB, dstDB) == -1) {
+                break;
+            }
+            m_tierStats[i+1].blocksDemoted++;
+            moved++;
+        }
+    }
+
+    if (m_promoteAccesses > 0) {
+        std::vector<std::pair<int32_t, int64_t> > hot;
+        {
+            // readEvictedTuple() counts accesses on the AntiCacheManager thread
+            AntiCacheMutexGuard guard(m_blockMutex);
+            for (std::map<int64_t, int32_t>::iterator it = m_blockAccesses.begin(); it != m_blockAccesses.end(); ++it) {
+                if (it->second >= m_promoteAccesses && AntiCacheDB::unpackACID(it->first) > 0) {
+                    hot.push_back(std::make_pair(it->second, it->first));
+                }
+            }
+        }
+        // hottest first
+        std::sort(hot.rbegin(), hot.rend());
+        for (size_t i = 0; i < hot.size() && moved < maxBlocks; i++) {
+            int16_t acid = AntiCacheDB::unpackACID(hot[i].second);
+            AntiCacheDB* dstDB = m_db_lookup[acid-1];
+            // don't fill the faster tier past where it would be demoted again
+            if (hasPendingFetch(acid) ||
+                dstDB->getNumBlocks() >= dstDB->getMaxBlocks() * m_demotePercent / 100) {
+                continue;
+            }
+            if (migrateBlock(hot[i].second, dstDB) == -1) {
+                continue;
+            }
+            m_tierStats[acid-1].blocksPromoted++;
+            moved++;
+        }
+    }
+
+    // age the counters so that only recent accesses count
+    AntiCacheMutexGuard guard(m_blockMutex);
+    std::map<int64_t, int32_t>::iterator it = m_blockAccesses.begin();
+    while (it != m_blockAccesses.end()) {
+        it->second /= 2;
+        if (it->second == 0) {
+            m_blockAccesses.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    VOLT_DEBUG("Moved %d blocks between %d anti-cache tiers", moved, m_numdbs);
+    return moved;
+}
+
 /*
  * Merges the unevicted block into the regular data table
  */
 bool AntiCacheEvictionManager::mergeUnevictedTuples(PersistentTable *table) {
     VOLT_TRACE("in merge");
+    int64_t start = LatencyHistogram::nowMicros();
+    completeFetches(table);
     int num_blocks = table->unevictedBlocksSize();
     int32_t num_tuples_in_block = -1;
 
@@ -1519,6 +2099,16 @@ bool AntiCacheEvictionManager::mergeUnevictedTuples(PersistentTable *table) {
         for(int j = 0; j < num_tables; j++){
             tableNames.push_back(in.readTextString());
             numTuples.push_back(in.readInt());
+            in.readInt(); // tuple directory offset
+        }
+
+        // tuples of this block that were already merged on their own, and
+        // whether the block is such a single tuple
+        MergeInfo mergeInfo;
+        std::map<const char*, MergeInfo>::iterator info = m_mergeInfo.find(table->getUnevictedBlocks(i));
+        if (info != m_mergeInfo.end()) {
+            mergeInfo = info->second;
+            m_mergeInfo.erase(info);
         }
 
         merge_tuple_offset = table->getMergeTupleOffset(i); // what to do about this?
@@ -1535,14 +2125,15 @@ bool AntiCacheEvictionManager::mergeUnevictedTuples(PersistentTable *table) {
             int tuplesRead = 0;
             for (int j = 0; j < num_tuples_in_block; j++)
             {
-                // if we're using the tuple-merge strategy, only merge in a single tuple
-                if(!table->mergeStrategy())
-                {
-                    if(j != merge_tuple_offset)  // don't merge this tuple
-                        continue;
+                // the whole block is gone from the AntiCacheDB, so every tuple
+                // has to be merged except the ones that already were
+                if (count == 0 && j < (int)mergeInfo.skip.size() && mergeInfo.skip[j]) {
+                    in.getRawPointer(in.readInt());
+                    continue;
                 }
 
                 bytes_unevicted += tableInBlock->unevictTuple(&in, j, merge_tuple_offset);
+                tuplesRead++;
                 /*                // get a free tuple and increment the count of tuples current used
                                   voltdb::TableTuple * m_tmpTarget1 = tableInBlock->getTempTarget1();
                                   tableInBlock->nextFreeTuple(m_tmpTarget1);
@@ -1578,10 +2169,6 @@ bool AntiCacheEvictionManager::mergeUnevictedTuples(PersistentTable *table) {
                 }
                  */
             }
-            if(tableInBlock->mergeStrategy())
-                tuplesRead += num_tuples_in_block;
-            else
-                tuplesRead++;
             int m_tuplesEvicted = tableInBlock->getTuplesEvicted();
             m_tuplesEvicted -= tuplesRead;
             tableInBlock->setTuplesEvicted(m_tuplesEvicted);
@@ -1591,8 +2178,14 @@ bool AntiCacheEvictionManager::mergeUnevictedTuples(PersistentTable *table) {
             tableInBlock->m_bytesEvicted-=bytes_unevicted;
             VOLT_INFO("Bytes unevicted: %ld", long(bytes_unevicted));
             tableInBlock->m_bytesRead+=bytes_unevicted;
-            tableInBlock->m_blocksEvicted -= 1;
-            tableInBlock->m_blocksRead += 1;
+            if (mergeInfo.partial == false) {
+                tableInBlock->m_blocksEvicted -= 1;
+                tableInBlock->m_blocksRead += 1;
+            }
+            // its tuples are back in every index
+            if (mergeInfo.partial == false && tableInBlock->getEvictedIndexRanges() != NULL) {
+                tableInBlock->getEvictedIndexRanges()->removeBlock(mergeInfo.blockId);
+            }
 
             count++;
 
@@ -1613,6 +2206,10 @@ bool AntiCacheEvictionManager::mergeUnevictedTuples(PersistentTable *table) {
     VOLT_INFO("Tuples in Eviction Chain: %d -- %d", (int)tuples_in_eviction_chain, (int)table->getNumTuplesInEvictionChain());
 #endif
 
+    m_mergeLatency.record(LatencyHistogram::nowMicros() - start);
+    VOLT_DEBUG("%s", m_fetchLatency.debug("Block fetch").c_str());
+    VOLT_DEBUG("%s", m_fetchWaitLatency.debug("Block fetch wait").c_str());
+    VOLT_DEBUG("%s", m_mergeLatency.debug("Block merge").c_str());
 
     return true;
 }
@@ -1636,18 +2233,40 @@ void AntiCacheEvictionManager::recordEvictedAccess(catalog::Table* catalogTable,
     // Determine the block id and tuple offset in the block using the EvictedTable tuple
     int32_t tuple_id = peeker.peekInteger(m_evicted_tuple->getNValue(1)); 
     VOLT_DEBUG("Got tuple_id: %d", tuple_id);
-    int32_t block_id = peeker.peekInteger(m_evicted_tuple->getNValue(0));
-    VOLT_DEBUG("Got blockId: %d", block_id);
+    int64_t block_id = peeker.peekBigInt(m_evicted_tuple->getNValue(0));
+    VOLT_DEBUG("Got blockId: %lx", (long)block_id);
     // Updated internal tracking info
     m_evicted_tables.push_back(catalogTable);
     m_evicted_block_ids.push_back(block_id); 
     m_evicted_offsets.push_back(tuple_id);
 
-    VOLT_DEBUG("Recording evicted tuple access [table=%s / blockId=%d / tupleId=%d]",
-               catalogTable->name().c_str(), block_id, tuple_id);    
+    VOLT_DEBUG("Recording evicted tuple access [table=%s / blockId=%lx / tupleId=%d]",
+               catalogTable->name().c_str(), (long)block_id, tuple_id);    
     VOLT_TRACE("Evicted Tuple Acccess: %s", m_evicted_tuple->debug(catalogTable->name()).c_str());
 }
 
+void AntiCacheEvictionManager::recordEvictedIndexAccess(catalog::Table* catalogTable, PersistentTable *table,
+                                                        const TableIndex *index, const TableTuple *searchKey,
+                                                        int numKeys, IndexLookupType lookupType,
+                                                        const TableTuple *stopTuple, bool ascending) {
+    EvictedIndexRanges *ranges = table->getEvictedIndexRanges();
+    if (ranges == NULL || ranges->covers(index) == false) {
+        return;
+    }
+    std::vector<int64_t> block_ids;
+    ranges->findBlocks(index, searchKey, numKeys, lookupType, stopTuple, ascending, block_ids);
+    for (std::vector<int64_t>::iterator it = block_ids.begin(); it != block_ids.end(); ++it) {
+        if (std::find(m_evicted_block_ids.begin(), m_evicted_block_ids.end(), *it) != m_evicted_block_ids.end()) {
+            continue;
+        }
+        VOLT_DEBUG("Lookup on %s.%s may need evicted block %lx",
+                   table->name().c_str(), index->getName().c_str(), (long)*it);
+        m_evicted_tables.push_back(catalogTable);
+        m_evicted_block_ids.push_back(*it);
+        m_evicted_offsets.push_back(0);
+    }
+}
+
 void AntiCacheEvictionManager::throwEvictedAccessException() {
     // Do we really want to remove all the non-unique blockIds here?
     // m_evicted_block_ids.unique();
@@ -1657,13 +2276,13 @@ void AntiCacheEvictionManager::throwEvictedAccessException() {
     
     VOLT_DEBUG("Txn accessed data from %d evicted blocks", num_block_ids);
         
-    int32_t* block_ids = new int32_t[num_block_ids];
+    int64_t* block_ids = new int64_t[num_block_ids];
     int32_t* tuple_ids = new int32_t[num_block_ids];
         
     // copy the block ids into an array 
     int num_blocks = 0; 
-    for(vector<int32_t>::iterator itr = m_evicted_block_ids.begin(); itr != m_evicted_block_ids.end(); ++itr) {
-        VOLT_DEBUG("Marking block %d as being needed for uneviction", *itr); 
+    for(vector<int64_t>::iterator itr = m_evicted_block_ids.begin(); itr != m_evicted_block_ids.end(); ++itr) {
+        VOLT_DEBUG("Marking block %lx as being needed for uneviction", (long)*itr); 
         block_ids[num_blocks++] = *itr; 
     }
 
@@ -1676,6 +2295,7 @@ void AntiCacheEvictionManager::throwEvictedAccessException() {
     
     // HACK
     catalog::Table *catalogTable = m_evicted_tables.front();
+    m_prefetchStats.restarts++;
         
     // Do we really want to throw this here?
     // FIXME We need to support multiple tables in the exception data
@@ -1686,6 +2306,63 @@ void AntiCacheEvictionManager::throwEvictedAccessException() {
     throw EvictedTupleAccessException(catalogTable->relativeIndex(), num_block_ids, block_ids, tuple_ids);
 }
 
+void AntiCacheEvictionManager::prefetchEvictedTuples(PersistentTable *table, int32_t tableId,
+                                                     const NValueArray &keys, int numValues) {
+    m_prefetchStats.requests++;
+    TableIndex *index = table->primaryKeyIndex();
+    if (index == NULL || table->getEvictedTable() == NULL) {
+        return;
+    }
+    const TupleSchema *keySchema = index->getKeySchema();
+    int keyColumns = keySchema->columnCount();
+
+    std::vector<char> backing(keySchema->tupleLength());
+    TableTuple searchKey(keySchema);
+    searchKey.moveNoHeader(&backing[0]);
+
+    std::vector<int64_t> block_ids;
+    std::vector<int32_t> tuple_offsets;
+    for (int i = 0; i + keyColumns <= numValues; i += keyColumns) {
+        try {
+            for (int col = 0; col < keyColumns; col++) {
+                searchKey.setNValue(col, keys[i + col]);
+            }
+        } catch (SQLException &e) {
+            // the transaction reports it when it gets to the same lookup
+            VOLT_DEBUG("Skipping prefetch key %d of %s: %s", i / keyColumns,
+                       table->name().c_str(), e.message().c_str());
+            continue;
+        }
+        m_prefetchStats.keysProbed++;
+        if (index->moveToKey(&searchKey) == false) {
+            continue;
+        }
+        TableTuple tuple;
+        while ((tuple = index->nextValueAtKey()).isNullTuple() == false) {
+            if (tuple.isEvicted() == false) {
+                continue;
+            }
+            m_evicted_tuple->move(tuple.address());
+            block_ids.push_back(peeker.peekBigInt(m_evicted_tuple->getNValue(0)));
+            tuple_offsets.push_back(peeker.peekInteger(m_evicted_tuple->getNValue(1)));
+        }
+    }
+    if (block_ids.empty()) {
+        return;
+    }
+
+    m_prefetchStats.evictedTuples += block_ids.size();
+    m_prefetchStats.requeued++;
+    int num_block_ids = static_cast<int>(block_ids.size());
+    int64_t* blockIds = new int64_t[num_block_ids];
+    int32_t* tupleOffsets = new int32_t[num_block_ids];
+    std::copy(block_ids.begin(), block_ids.end(), blockIds);
+    std::copy(tuple_offsets.begin(), tuple_offsets.end(), tupleOffsets);
+    VOLT_DEBUG("Requeuing the txn for %d evicted tuples of %s before it runs",
+               num_block_ids, table->name().c_str());
+    throw EvictedTupleAccessException(tableId, num_block_ids, blockIds, tupleOffsets);
+}
+
 
 #ifndef ANTICACHE_TIMESTAMPS
 
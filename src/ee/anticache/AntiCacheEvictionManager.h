@@ -34,19 +34,61 @@
 #include "execution/VoltDBEngine.h"
 #include "common/NValue.hpp"
 #include "common/ValuePeeker.hpp"
+#include "common/valuevector.h"
 #include "anticache/AntiCacheDB.h"
+#include "anticache/AntiCacheBlockCodec.h"
+#include "anticache/AntiCacheBlockWriter.h"
+#include "common/LatencyHistogram.h"
 
 #include <vector>
 #include <map>
+#include <set>
 
 #define MAX_DBS 8
+#define MIGRATE_BLOCKS_PER_TICK 16
 
 namespace voltdb {
 
 class Table;
 class PersistentTable;
 class EvictionIterator;    
+class BerkeleyDBBlock;
+class TableIndex;
     
+/**
+ * Counters of one AntiCacheDB tier. Promoted and demoted count the blocks
+ * that were moved into the tier, reads cover whole blocks and the single
+ * tuples read out of blocks that stay in the tier.
+ */
+struct AntiCacheTierStats {
+    AntiCacheTierStats() :
+        blocksWritten(0), blocksRead(0), tuplesRead(0), blocksPromoted(0), blocksDemoted(0) {}
+
+    int64_t blocksWritten;
+    int64_t blocksRead;
+    int64_t tuplesRead;
+    int64_t blocksPromoted;
+    int64_t blocksDemoted;
+    LatencyHistogram readLatency;
+};
+
+/**
+ * Counters of prefetchEvictedTuples(). requeued counts the transactions
+ * that a prefetch sent back to the AntiCacheManager before they ran;
+ * restarts counts the ones that ran into evicted tuples while running,
+ * through throwEvictedAccessException().
+ */
+struct AntiCachePrefetchStats {
+    AntiCachePrefetchStats() :
+        requests(0), keysProbed(0), evictedTuples(0), requeued(0), restarts(0) {}
+
+    int64_t requests;
+    int64_t keysProbed;
+    int64_t evictedTuples;
+    int64_t requeued;
+    int64_t restarts;
+};
+
 class AntiCacheEvictionManager {
         
 public: 
@@ -63,15 +105,17 @@ public:
     Table* evictBlockInBatch(PersistentTable *table, PersistentTable *childTable, long blockSize, int numBlocks);
     // Table* readBlocks(PersistentTable *table, int numBlocks, int16_t blockIds[], int32_t tuple_offsets[]);
     bool mergeUnevictedTuples(PersistentTable *table);
-    bool readEvictedBlock(PersistentTable *table, int32_t block_id, int32_t tuple_offset);
+    bool readEvictedBlock(PersistentTable *table, int64_t block_id, int32_t tuple_offset);
+    bool readEvictedBlocks(PersistentTable *table, int numBlocks, int64_t blockIds[], int32_t tupleOffsets[]);
+    void completeFetches(PersistentTable *table);
     //int numTuplesInEvictionList(); 
 
     int chooseDB();
     int chooseDB(long blockSize);
     int chooseDB(long blockSize, bool migrate);
 
-    int32_t migrateBlock(int32_t blockId, AntiCacheDB* dstDB); 
-    int32_t migrateLRUBlock(AntiCacheDB* srcDB, AntiCacheDB* dstDB); 
+    int64_t migrateBlock(int64_t blockId, AntiCacheDB* dstDB); 
+    int64_t migrateLRUBlock(AntiCacheDB* srcDB, AntiCacheDB* dstDB); 
     
     int16_t addAntiCacheDB(AntiCacheDB* acdb);
     AntiCacheDB* getAntiCacheDB(int acid);
@@ -89,14 +133,146 @@ public:
         return (m_evicted_block_ids.empty() == false);
     }
     void recordEvictedAccess(catalog::Table* catalogTable, TableTuple *tuple);
+    /**
+     * Record the evicted blocks whose tuples a finished lookup on an index
+     * that dropped their entries could have found, see
+     * EvictedIndexRanges::findBlocks
+     */
+    void recordEvictedIndexAccess(catalog::Table* catalogTable, PersistentTable *table,
+                                  const TableIndex *index, const TableTuple *searchKey,
+                                  int numKeys, IndexLookupType lookupType,
+                                  const TableTuple *stopTuple, bool ascending);
     void throwEvictedAccessException();
+
+    /**
+     * Look up the given primary keys of the table, numValues values laid
+     * out one key after the other, before the transaction that is about to
+     * access them runs. If any of them are evicted, throw the
+     * EvictedTupleAccessException the transaction would have hit halfway
+     * through: the AntiCacheManager reads the blocks on its own thread and
+     * the transaction merges them in once it is scheduled again. Keys that
+     * do not fit the index are skipped.
+     */
+    void prefetchEvictedTuples(PersistentTable *table, int32_t tableId, const NValueArray &keys, int numValues);
+
+    inline const AntiCachePrefetchStats& getPrefetchStats() const {
+        return m_prefetchStats;
+    }
+
+    // -----------------------------------------
+    // Block Compression
+    // -----------------------------------------
+
+    /** Compress the blocks evicted from now on, see AntiCacheBlockCodec */
+    inline bool setCompression(AntiCacheCompressionType type, int level) {
+        AntiCacheBlockWriter::Guard guard(m_writer);
+        return m_codec.setCompression(type, level);
+    }
+    inline const AntiCacheBlockCodec& getCodec() const {
+        return m_codec;
+    }
+
+    // -----------------------------------------
+    // Eviction Policy
+    // -----------------------------------------
+
+    /** Choose how the tuples to evict from the table are picked (LRU by default) */
+    void setEvictionPolicy(PersistentTable* table, AntiCacheEvictionPolicy policy);
+
+    // -----------------------------------------
+    // Background Block Writes
+    // -----------------------------------------
+
+    /**
+     * Compress and write evicted blocks on a background thread with room
+     * for queueDepth blocks, or on the site thread again if it is 0
+     */
+    void setBackgroundWrites(int queueDepth);
+
+    inline bool hasBackgroundWrites() const {
+        return m_writer.isRunning();
+    }
+    /** Compress and write time of each block written in the background */
+    inline LatencyHistogram getWriteLatency() {
+        return m_writer.getWriteLatency();
+    }
+    /** How long each eviction held up the site thread */
+    inline const LatencyHistogram& getEvictPauseLatency() const {
+        return m_evictPauseLatency;
+    }
+
+    // -----------------------------------------
+    // Tiered Storage
+    // -----------------------------------------
+
+    /**
+     * Promote blocks that had at least promoteAccesses tuples read out of
+     * them to the next faster tier (0 turns promotion off), and demote the
+     * LRU blocks of a tier filled past demotePercent of its capacity.
+     * Both happen in migrateTiers(), which every tick() calls. Returns false and leaves the policy
+     * alone if demotePercent is not within 1-100.
+     */
+    bool setTierPolicy(int promoteAccesses, int demotePercent);
+
+    /**
+     * Move up to maxBlocks blocks between tiers according to the tier
+     * policy and age the access counters. Returns the number moved.
+     */
+    int migrateTiers(int maxBlocks);
+
+    /**
+     * Periodic work, called from VoltDBEngine::tick() between transactions.
+     * Once a tier policy is set, moves up to MIGRATE_BLOCKS_PER_TICK blocks
+     * between the tiers. Returns the number moved.
+     */
+    int tick();
+
+    inline const AntiCacheTierStats& getTierStats(int acid) const {
+        return m_tierStats[acid];
+    }
+
+    // -----------------------------------------
+    // Block Fetch Latency
+    // -----------------------------------------
+
+    /** From submitting a block read until its block is installed */
+    inline const LatencyHistogram& getFetchLatency() const {
+        return m_fetchLatency;
+    }
+    /** How long completeFetches() blocked on reads still in flight */
+    inline const LatencyHistogram& getFetchWaitLatency() const {
+        return m_fetchWaitLatency;
+    }
+    /** Duration of each mergeUnevictedTuples() call */
+    inline const LatencyHistogram& getMergeLatency() const {
+        return m_mergeLatency;
+    }
     
 protected:
     void initEvictResultTable();
+    void addEvictResultRow(PersistentTable *table, int32_t tuplesEvicted, int32_t blocksEvicted,
+                           int64_t bytesEvicted, const AntiCacheCodecStats &lastStats, int64_t pauseMicros);
+    AntiCacheCodecStats getCodecStats(const std::string &tableName);
+    AntiCacheDB* nextEvictedBlockId(PersistentTable *table, long block_size, int64_t &block_id);
+    int64_t nextFreeBlockId(AntiCacheDB* antiCacheDB);
+    long freeBlocks(AntiCacheDB* acdb);
+    void writeEvictedBlock(AntiCacheDB* antiCacheDB, const std::string &tableName, int64_t block_id,
+                           int32_t num_tuples, BerkeleyDBBlock &block);
+    void evictIndexEntries(PersistentTable *table, TableTuple &tuple,
+                           const void* evicted_tuple_address, int64_t block_id);
     
     bool removeTupleSingleLinkedList(PersistentTable* table, uint32_t removal_id);
     bool removeTupleDoubleLinkedList(PersistentTable* table, TableTuple* tuple_to_remove, uint32_t removal_id);
     
+    void installUnevictedBlock(PersistentTable *table, int64_t block_id, int32_t tuple_offset, AntiCacheBlock* value);
+    int submitBlockReads(PersistentTable *table, int numBlocks, int64_t blockIds[], int32_t tupleOffsets[]);
+    bool isFetchPending(PersistentTable *table, int64_t block_id);
+    bool readEvictedTuple(PersistentTable *table, int64_t block_id, int32_t tuple_offset);
+    void renameMigratedBlock(int64_t block_id, int64_t new_block_id);
+    int64_t resolveBlockId(int64_t block_id);
+    void forgetBlock(int64_t block_id);
+    bool hasPendingFetch(int16_t acid);
+
     void printLRUChain(PersistentTable* table, int max, bool forward);
     char *itoa(uint32_t i);
     
@@ -109,8 +285,9 @@ protected:
     TableTuple* m_evicted_tuple; 
     
     std::vector<catalog::Table*> m_evicted_tables;
-    std::vector<int32_t> m_evicted_block_ids;
+    std::vector<int64_t> m_evicted_block_ids;
     std::vector<int32_t> m_evicted_offsets;
+    AntiCachePrefetchStats m_prefetchStats;
 
     AntiCacheDB* m_db_lookup[MAX_DBS];
     int16_t m_numdbs;
@@ -121,6 +298,66 @@ protected:
     // m_numdbs > 1;
     bool m_migrate;
     //std::map<int16_t, AntiCacheDB*> m_db_lookup_table;
+
+    // Block reads submitted by readEvictedBlocks() that have not been merged yet
+    struct PendingFetch {
+        PersistentTable *table;
+        int64_t blockId;
+        int32_t tupleOffset;
+        int64_t submitted;
+    };
+    std::vector<PendingFetch> m_pendingFetches;
+    // readEvictedBlocks() adds fetches on the AntiCacheManager thread
+    pthread_mutex_t m_fetchMutex;
+
+    // Blocks still in an AntiCacheDB that some tuples were read from one
+    // at a time (tables using the tuple-merge strategy), by block id
+    struct PartialBlock {
+        std::vector<int32_t> offsets;
+        std::vector<bool> unevicted;
+        int32_t remaining;
+    };
+    std::map<int64_t, PartialBlock> m_partialBlocks;
+
+    // Unevicted buffers waiting for mergeUnevictedTuples() that hold a
+    // single tuple (partial) or a block some of whose tuples were merged
+    // already (skip), and the id the block was evicted with
+    struct MergeInfo {
+        MergeInfo() : partial(false), blockId(-1) {}
+
+        bool partial;
+        std::vector<bool> skip;
+        int64_t blockId;
+    };
+    std::map<const char*, MergeInfo> m_mergeInfo;
+
+    // tuples read out of each block still in a tier since it got there,
+    // halved by every migrateTiers() pass
+    std::map<int64_t, int32_t> m_blockAccesses;
+    // where the blocks moved by a migration went and back, so that ids
+    // handed out before the move can still be read
+    std::map<int64_t, int64_t> m_movedBlocks;
+    std::map<int64_t, int64_t> m_movedFrom;
+    // ids of migrated blocks that evicted tuples still point to, and those
+    // that nothing points to anymore but that were taken from their AntiCacheDB
+    std::set<int64_t> m_parkedIds;
+    std::vector<int64_t> m_releasedIds;
+    // guards the partial blocks, access counts and forwarding above, which
+    // readEvictedTuple() uses on the AntiCacheManager thread
+    pthread_mutex_t m_blockMutex;
+    int m_promoteAccesses;
+    int m_demotePercent;
+    AntiCacheTierStats m_tierStats[MAX_DBS];
+
+    AntiCacheBlockCodec m_codec;
+    AntiCacheBlockWriter m_writer;
+    // decompression time of each table already reported in an EVICT_RESULT
+    std::map<std::string, int64_t> m_reportedDecompressMicros;
+
+    LatencyHistogram m_fetchLatency;
+    LatencyHistogram m_fetchWaitLatency;
+    LatencyHistogram m_mergeLatency;
+    LatencyHistogram m_evictPauseLatency;
     
 }; // AntiCacheEvictionManager class
 
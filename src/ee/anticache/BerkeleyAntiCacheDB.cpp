@@ -18,12 +18,12 @@ using namespace std;
 
 namespace voltdb {
 
-BerkeleyAntiCacheBlock::BerkeleyAntiCacheBlock(int16_t blockId, Dbt value) :
+BerkeleyAntiCacheBlock::BerkeleyAntiCacheBlock(int64_t blockId, Dbt value) :
    AntiCacheBlock(blockId) 
     {
     m_buf = (char *) value.get_data();
-    int16_t id = *((int16_t *)m_buf);
-    long bufLen_ = sizeof(int16_t);
+    int64_t id = *((int64_t *)m_buf);
+    long bufLen_ = sizeof(int64_t);
     std::string tableName = m_buf + bufLen_;
     bufLen_ += tableName.size()+1;
     long size = *((long *)(m_buf+bufLen_));
@@ -41,8 +41,8 @@ BerkeleyAntiCacheBlock::BerkeleyAntiCacheBlock(int16_t blockId, Dbt value) :
     
     m_block = m_payload.data;
 	    
-    VOLT_DEBUG("BerkeleyAntiCacheBlock #%d from table: %s [size=%ld / payload=%ld = '%s']",
-              blockId, m_payload.tableName.c_str(), m_size, m_payload.size, m_payload.data);
+    VOLT_DEBUG("BerkeleyAntiCacheBlock #%ld from table: %s [size=%ld / payload=%ld = '%s']",
+              (long)blockId, m_payload.tableName.c_str(), m_size, m_payload.size, m_payload.data);
     //VOLT_INFO("data from getBlock %s", getData());
     m_blockType = ANTICACHEDB_BERKELEY;
 }
@@ -124,7 +124,7 @@ BerkeleyAntiCacheDB::~BerkeleyAntiCacheDB() {
 }
 
 void BerkeleyAntiCacheDB::writeBlock(const std::string tableName,
-                             int16_t blockId,
+                             int64_t blockId,
                              const int tupleCount,
                              const char* data,
                              const long size) {
@@ -159,8 +159,8 @@ void BerkeleyAntiCacheDB::writeBlock(const std::string tableName,
     value.set_size(static_cast<int32_t>(bufLen_));
 
 
-    VOLT_INFO("Writing out a block #%d to anti-cache database [tuples=%d / size=%ld]",
-               blockId, tupleCount, size);
+    VOLT_INFO("Writing out a block #%ld to anti-cache database [tuples=%d / size=%ld]",
+               (long)blockId, tupleCount, size);
     // TODO: Error checking
     m_db->put(NULL, &key, &value, 0);
     
@@ -169,7 +169,7 @@ void BerkeleyAntiCacheDB::writeBlock(const std::string tableName,
     delete [] databuf_;
 }
 
-AntiCacheBlock* BerkeleyAntiCacheDB::readBlock(int16_t blockId) {
+AntiCacheBlock* BerkeleyAntiCacheDB::readBlock(int64_t blockId) {
     Dbt key;
     key.set_data(&blockId);
     key.set_size(sizeof(blockId));
@@ -177,13 +177,13 @@ AntiCacheBlock* BerkeleyAntiCacheDB::readBlock(int16_t blockId) {
     Dbt value;
     value.set_flags(DB_DBT_MALLOC);
     
-    VOLT_INFO("Reading evicted block with id %d", blockId);
+    VOLT_INFO("Reading evicted block with id %ld", (long)blockId);
     
     int ret_value = m_db->get(NULL, &key, &value, 0);
 
     if (ret_value != 0) 
     {
-        VOLT_ERROR("Invalid anti-cache blockId '%d'", blockId);
+        VOLT_ERROR("Invalid anti-cache blockId '%ld'", (long)blockId);
         throw UnknownBlockAccessException(blockId);
     }
     else 
@@ -24,16 +24,26 @@ class BerkeleyAntiCacheBlock : public AntiCacheBlock {
         ~BerkeleyAntiCacheBlock();
 
     private:
-        BerkeleyAntiCacheBlock(int16_t blockId, Dbt value);
+        BerkeleyAntiCacheBlock(int64_t blockId, Dbt value);
 };
 
 // Encapsulates a block that is flushed out to BerkeleyDB
 // TODO: merge it with AntiCacheBlock
+//
+// Layout of an evicted block:
+//
+//   int32 number of tables
+//   for each table: string name, int32 number of tuples, int32 offset of its directory
+//   the tuples of each table, one table after the other
+//   for each table: a directory of int32 offsets of its tuples within the block,
+//   plus the offset where its last tuple ends
+//
+// The directory lets a single tuple be read back without the rest of the block.
 class BerkeleyDBBlock{
 public:
     ~BerkeleyDBBlock();
 
-    inline void initialize(long blockSize, std::vector<std::string> tableNames, int32_t blockId, int numTuplesEvicted){
+    inline void initialize(long blockSize, std::vector<std::string> tableNames, int64_t blockId, int numTuplesEvicted){
         DefaultTupleSerializer serializer;
         // buffer used for serializing a single tuple
         serialized_data = new char[blockSize];
@@ -42,38 +52,81 @@ public:
         for (std::vector<std::string>::iterator it = tableNames.begin() ; it != tableNames.end(); ++it){
             out.writeTextString(*it);
             // note this offset since we need to write at this again later on
-            offsets.push_back(getSerializedSize());
+            offsets.push_back((int)out.size());
             out.writeInt(numTuplesEvicted);// reserve first 4 bytes in buffer for number of tuples in block
+            out.writeInt(0); // and 4 more for the offset of the table's tuple directory
         }
-
-
+        directoryWritten = false;
     }
 
     inline void addTuple(TableTuple tuple){
+        tupleOffsets.push_back(static_cast<int32_t>(out.size()));
         // Now copy the raw bytes for this tuple into the serialized buffer
         tuple.serializeWithHeaderTo(out);
     }
 
     inline void writeHeader(std::vector<int> num_tuples_evicted){
-        // write out the block header (i.e. number of tuples in block)
+        // write out the block header (i.e. number of tuples in block) and
+        // append the tuple directory of each table
+        int32_t tuplesEnd = static_cast<int32_t>(out.size());
+        size_t next = 0;
         int count = 0;
         for (std::vector<int>::iterator it = num_tuples_evicted.begin() ; it != num_tuples_evicted.end(); ++it){
             out.writeIntAt(offsets.at(count), *it);
+            out.writeIntAt(offsets.at(count) + sizeof(int32_t), static_cast<int32_t>(out.size()));
+            for (int i = 0; i <= *it; i++) {
+                out.writeInt(next < tupleOffsets.size() ? tupleOffsets[next] : tuplesEnd);
+                if (i < *it) next++;
+            }
             count++;
         }
+        directoryWritten = true;
     }
 
+    /** Size of the block, including the directory that writeHeader() adds */
     inline int getSerializedSize(){
-        return (int)out.size();
+        if (directoryWritten) {
+            return (int)out.size();
+        }
+        return (int)(out.size() + (tupleOffsets.size() + offsets.size()) * sizeof(int32_t));
     }
 
     inline const char* getSerializedData(){
         return out.data();
     }
+
+    /**
+     * Read the header of a block written by this class. Returns false if
+     * the header does not fit in the given bytes.
+     */
+    static inline bool readHeader(const char* data, long size,
+                                  std::vector<std::string> &tableNames,
+                                  std::vector<int> &numTuples,
+                                  std::vector<int> &directoryOffsets,
+                                  long &headerSize) {
+        if (size < (long)sizeof(int32_t)) return false;
+        ReferenceSerializeInput in(data, size);
+        int numTables = in.readInt();
+        long position = sizeof(int32_t);
+        for (int i = 0; i < numTables; i++) {
+            if (position + (long)sizeof(int32_t) > size) return false;
+            int32_t nameLength = in.readInt();
+            position += sizeof(int32_t) + nameLength + 2 * sizeof(int32_t);
+            if (nameLength < 0 || position > size) return false;
+            tableNames.push_back(std::string(reinterpret_cast<const char*>(in.getRawPointer(nameLength)), nameLength));
+            numTuples.push_back(in.readInt());
+            directoryOffsets.push_back(in.readInt());
+        }
+        headerSize = position;
+        return true;
+    }
+
 private:
     ReferenceSerializeOutput out;
     char * serialized_data;
     std::vector<int> offsets;
+    std::vector<int32_t> tupleOffsets;
+    bool directoryWritten;
 
 };
 
@@ -82,19 +135,19 @@ class BerkeleyAntiCacheDB : public AntiCacheDB {
         BerkeleyAntiCacheDB(ExecutorContext *ctx, std::string db_dir, long blockSize, long maxSize);
         ~BerkeleyAntiCacheDB(); 
 
-        inline int16_t nextBlockId() {
+        inline int64_t nextBlockId() {
             return (++m_nextBlockId);
         }
         void initializeDB();
 
-        AntiCacheBlock* readBlock(int16_t blockId);
+        AntiCacheBlock* readBlock(int64_t blockId);
 
         void shutdownDB();
 
         void flushBlocks();
 
         void writeBlock(const std::string tableName,
-                        int16_t blockID,
+                        int64_t blockID,
                         const int tupleCount,
                         const char* data,
                         const long size);
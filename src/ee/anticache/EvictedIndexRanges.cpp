@@ -0,0 +1,366 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "anticache/EvictedIndexRanges.h"
+#include "common/tabletuple.h"
+#include "common/TupleSchema.h"
+#include "indexes/tableindex.h"
+
+#include <algorithm>
+
+namespace voltdb {
+
+// bits of bloom filter per distinct key prefix of a block, and the bits
+// each of them sets, for a false positive rate of about one percent
+static const size_t FILTER_BITS_PER_KEY = 10;
+static const uint32_t FILTER_PROBES = 7;
+
+/*
+ * Compare the indexed columns of a table tuple, or the first numKeys
+ * columns of a key, with the first numKeys columns of a stored key
+ */
+static int compareToKey(const TableTuple &tuple, const std::vector<int> *columns,
+                        const TableTuple &key, int numKeys) {
+    for (int i = 0; i < numKeys; i++) {
+        int diff = tuple.getNValue(columns == NULL ? i : (*columns)[i]).compare(key.getNValue(i));
+        if (diff != 0) {
+            return diff;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Hash every prefix of the indexed columns of a table tuple, or of the
+ * first numKeys columns of a key. boost's hash_combine barely mixes small
+ * integers, so each hash is finished with the murmur3 finalizer.
+ */
+static void hashPrefixes(const TableTuple &tuple, const std::vector<int> *columns,
+                         int numKeys, std::vector<uint64_t> &hashes) {
+    std::size_t seed = 0;
+    for (int i = 0; i < numKeys; i++) {
+        tuple.getNValue(columns == NULL ? i : (*columns)[i]).hashCombine(seed);
+        uint64_t hash = seed;
+        hash ^= hash >> 33;
+        hash *= UINT64_C(0xff51afd7ed558ccd);
+        hash ^= hash >> 33;
+        hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+        hash ^= hash >> 33;
+        hashes.push_back(hash);
+    }
+}
+
+static int compareKeys(const TupleSchema *keySchema, const std::vector<char> &a, const std::vector<char> &b) {
+    TableTuple left(keySchema);
+    left.moveNoHeader(const_cast<char*>(&a[0]));
+    TableTuple right(keySchema);
+    right.moveNoHeader(const_cast<char*>(&b[0]));
+    return compareToKey(left, NULL, right, keySchema->columnCount());
+}
+
+/*
+ * Orders the blocks of an index by their lowest key
+ */
+struct LowerBlock {
+    const TupleSchema *keySchema;
+
+    LowerBlock(const TupleSchema *keySchema) : keySchema(keySchema) {}
+
+    template <typename Iterator>
+    bool operator()(const Iterator &a, const Iterator &b) const {
+        return compareKeys(keySchema, a->second.low, b->second.low) < 0;
+    }
+};
+
+EvictedIndexRanges::EvictedIndexRanges(const std::vector<TableIndex*> &indexes) : m_entriesEvicted(0) {
+    for (std::vector<TableIndex*>::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+        m_ranges[*it].dirty = false;
+    }
+}
+
+EvictedIndexRanges::~EvictedIndexRanges() {
+    for (std::map<const TableIndex*, IndexRanges>::iterator it = m_ranges.begin(); it != m_ranges.end(); ++it) {
+        for (BlockRanges::iterator range = it->second.blocks.begin(); range != it->second.blocks.end(); ++range) {
+            freeKey(it->first, range->second.low);
+            freeKey(it->first, range->second.high);
+        }
+    }
+}
+
+void EvictedIndexRanges::copyKey(const TableIndex *index, const TableTuple &tuple, std::vector<char> &storage) {
+    const TupleSchema *keySchema = index->getKeySchema();
+    const std::vector<int> &columns = index->getColumnIndices();
+    storage.assign(keySchema->tupleLength(), 0);
+    TableTuple key(keySchema);
+    key.moveNoHeader(&storage[0]);
+    for (int i = 0; i < keySchema->columnCount(); i++) {
+        key.setNValueAllocateForObjectCopies(i, tuple.getNValue(columns[i]), NULL);
+    }
+}
+
+void EvictedIndexRanges::freeKey(const TableIndex *index, std::vector<char> &storage) {
+    if (storage.empty()) {
+        return;
+    }
+    TableTuple key(index->getKeySchema());
+    key.moveNoHeader(&storage[0]);
+    key.freeObjectColumns();
+    storage.clear();
+}
+
+void EvictedIndexRanges::addToFilter(std::vector<uint64_t> &filter, uint64_t hash) {
+    const uint64_t bits = filter.size() * 64;
+    const uint32_t h1 = static_cast<uint32_t>(hash);
+    const uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+    for (uint32_t i = 0; i < FILTER_PROBES; i++) {
+        uint64_t bit = (h1 + static_cast<uint64_t>(i) * h2) % bits;
+        filter[bit / 64] |= UINT64_C(1) << (bit % 64);
+    }
+}
+
+bool EvictedIndexRanges::mayContain(const std::vector<uint64_t> &filter, uint64_t hash) {
+    if (filter.empty()) {
+        return true;
+    }
+    const uint64_t bits = filter.size() * 64;
+    const uint32_t h1 = static_cast<uint32_t>(hash);
+    const uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+    for (uint32_t i = 0; i < FILTER_PROBES; i++) {
+        uint64_t bit = (h1 + static_cast<uint64_t>(i) * h2) % bits;
+        if ((filter[bit / 64] & (UINT64_C(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EvictedIndexRanges::addTuple(int64_t blockId, const TableTuple &tuple) {
+    for (std::map<const TableIndex*, IndexRanges>::iterator it = m_ranges.begin(); it != m_ranges.end(); ++it) {
+        const TableIndex *index = it->first;
+        const std::vector<int> &columns = index->getColumnIndices();
+        int numKeys = index->getKeySchema()->columnCount();
+
+        BlockRanges::iterator range = it->second.blocks.find(blockId);
+        if (range == it->second.blocks.end()) {
+            BlockKeys &first = it->second.blocks[blockId];
+            copyKey(index, tuple, first.low);
+            copyKey(index, tuple, first.high);
+            hashPrefixes(tuple, &columns, numKeys, first.pending);
+            it->second.dirty = true;
+            continue;
+        }
+
+        // the filter is sized once the block is complete, by the next lookup
+        if (range->second.filter.empty()) {
+            hashPrefixes(tuple, &columns, numKeys, range->second.pending);
+        } else {
+            std::vector<uint64_t> hashes;
+            hashPrefixes(tuple, &columns, numKeys, hashes);
+            for (std::vector<uint64_t>::iterator hash = hashes.begin(); hash != hashes.end(); ++hash) {
+                addToFilter(range->second.filter, *hash);
+            }
+        }
+
+        TableTuple bound(index->getKeySchema());
+        bound.moveNoHeader(&range->second.low[0]);
+        if (compareToKey(tuple, &columns, bound, numKeys) < 0) {
+            freeKey(index, range->second.low);
+            copyKey(index, tuple, range->second.low);
+            it->second.dirty = true;
+            continue;
+        }
+        bound.moveNoHeader(&range->second.high[0]);
+        if (compareToKey(tuple, &columns, bound, numKeys) > 0) {
+            freeKey(index, range->second.high);
+            copyKey(index, tuple, range->second.high);
+            it->second.dirty = true;
+        }
+    }
+    m_numTuples[blockId]++;
+    m_entriesEvicted += m_ranges.size();
+}
+
+void EvictedIndexRanges::removeBlock(int64_t blockId) {
+    std::map<int64_t, int32_t>::iterator tuples = m_numTuples.find(blockId);
+    if (tuples == m_numTuples.end()) {
+        return;
+    }
+    for (std::map<const TableIndex*, IndexRanges>::iterator it = m_ranges.begin(); it != m_ranges.end(); ++it) {
+        BlockRanges::iterator range = it->second.blocks.find(blockId);
+        if (range != it->second.blocks.end()) {
+            freeKey(it->first, range->second.low);
+            freeKey(it->first, range->second.high);
+            it->second.blocks.erase(range);
+            it->second.dirty = true;
+        }
+    }
+    m_entriesEvicted -= tuples->second * static_cast<int64_t>(m_ranges.size());
+    m_numTuples.erase(tuples);
+}
+
+/*
+ * Size the filters of the blocks added since the last lookup, sort the
+ * blocks by their lowest key and build the tree over their highest keys
+ */
+void EvictedIndexRanges::rebuild(const TableIndex *index, IndexRanges &ranges) {
+    ranges.byLow.clear();
+    for (BlockRanges::iterator range = ranges.blocks.begin(); range != ranges.blocks.end(); ++range) {
+        BlockKeys &keys = range->second;
+        if (keys.pending.empty() == false) {
+            std::sort(keys.pending.begin(), keys.pending.end());
+            keys.pending.erase(std::unique(keys.pending.begin(), keys.pending.end()), keys.pending.end());
+            keys.filter.assign((keys.pending.size() * FILTER_BITS_PER_KEY + 63) / 64, 0);
+            for (std::vector<uint64_t>::iterator hash = keys.pending.begin(); hash != keys.pending.end(); ++hash) {
+                addToFilter(keys.filter, *hash);
+            }
+            std::vector<uint64_t>().swap(keys.pending);
+        }
+        ranges.byLow.push_back(range);
+    }
+    std::sort(ranges.byLow.begin(), ranges.byLow.end(), LowerBlock(index->getKeySchema()));
+
+    ranges.maxHigh.clear();
+    if (ranges.byLow.empty() == false) {
+        ranges.maxHigh.resize(4 * ranges.byLow.size());
+        buildMaxHigh(index, ranges, 0, 0, ranges.byLow.size());
+    }
+    ranges.dirty = false;
+}
+
+size_t EvictedIndexRanges::buildMaxHigh(const TableIndex *index, IndexRanges &ranges,
+                                        size_t node, size_t begin, size_t end) {
+    if (end - begin == 1) {
+        ranges.maxHigh[node] = begin;
+        return begin;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    size_t left = buildMaxHigh(index, ranges, 2 * node + 1, begin, middle);
+    size_t right = buildMaxHigh(index, ranges, 2 * node + 2, middle, end);
+    size_t highest = (compareKeys(index->getKeySchema(), ranges.byLow[left]->second.high,
+                                  ranges.byLow[right]->second.high) < 0 ? right : left);
+    ranges.maxHigh[node] = highest;
+    return highest;
+}
+
+/*
+ * Collect the positions below limit in the subtree whose blocks' highest
+ * keys are not below the low bound, skipping the subtrees whose highest
+ * key is
+ */
+void EvictedIndexRanges::collect(const TableIndex *index, const IndexRanges &ranges, const Bound &low,
+                                 size_t limit, size_t node, size_t begin, size_t end,
+                                 std::vector<size_t> &positions) const {
+    if (begin >= limit) {
+        return;
+    }
+    if (low.tuple != NULL) {
+        TableTuple high(index->getKeySchema());
+        high.moveNoHeader(const_cast<char*>(&ranges.byLow[ranges.maxHigh[node]]->second.high[0]));
+        if (compareToKey(*low.tuple, low.columns, high, low.numKeys) > 0) {
+            return;
+        }
+    }
+    if (end - begin == 1) {
+        positions.push_back(begin);
+        return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    collect(index, ranges, low, limit, 2 * node + 1, begin, middle, positions);
+    collect(index, ranges, low, limit, 2 * node + 2, middle, end, positions);
+}
+
+void EvictedIndexRanges::findBlocks(const TableIndex *index, const TableTuple *searchKey, int numKeys,
+                                    IndexLookupType lookupType, const TableTuple *stopTuple, bool ascending,
+                                    std::vector<int64_t> &blockIds) {
+    std::map<const TableIndex*, IndexRanges>::iterator it = m_ranges.find(index);
+    if (it == m_ranges.end()) {
+        return;
+    }
+    IndexRanges &ranges = it->second;
+    if (ranges.dirty) {
+        rebuild(index, ranges);
+    }
+    if (ranges.byLow.empty()) {
+        return;
+    }
+    const int keyColumns = index->getKeySchema()->columnCount();
+    if (numKeys > keyColumns) {
+        numKeys = keyColumns;
+    }
+
+    // the keys the scan went over
+    Bound low = { NULL, NULL, 0 };
+    Bound high = { NULL, NULL, 0 };
+    if (numKeys > 0) {
+        Bound key = { searchKey, NULL, numKeys };
+        low = key;
+        if (lookupType == INDEX_LOOKUP_TYPE_EQ) {
+            high = key;
+        }
+    }
+    if (stopTuple != NULL) {
+        Bound stop = { stopTuple, &index->getColumnIndices(), keyColumns };
+        if (ascending) {
+            high = stop;
+        } else if (numKeys == 0) {
+            low = stop;
+        }
+    }
+
+    // only the blocks before the first one whose lowest key is past the
+    // high bound can overlap
+    size_t limit = ranges.byLow.size();
+    if (high.tuple != NULL) {
+        size_t begin = 0;
+        TableTuple bound(index->getKeySchema());
+        while (begin < limit) {
+            size_t middle = begin + (limit - begin) / 2;
+            bound.moveNoHeader(&ranges.byLow[middle]->second.low[0]);
+            if (compareToKey(*high.tuple, high.columns, bound, high.numKeys) < 0) {
+                limit = middle;
+            } else {
+                begin = middle + 1;
+            }
+        }
+    }
+    std::vector<size_t> positions;
+    collect(index, ranges, low, limit, 0, 0, ranges.byLow.size(), positions);
+
+    // a lookup of one key can skip the blocks whose filters don't have it
+    std::vector<uint64_t> hashes;
+    if (lookupType == INDEX_LOOKUP_TYPE_EQ && numKeys > 0) {
+        hashPrefixes(*searchKey, NULL, numKeys, hashes);
+    }
+    for (std::vector<size_t>::iterator position = positions.begin(); position != positions.end(); ++position) {
+        const BlockRanges::iterator &range = ranges.byLow[*position];
+        if (hashes.empty() == false && mayContain(range->second.filter, hashes.back()) == false) {
+            continue;
+        }
+        blockIds.push_back(range->first);
+    }
+}
+
+}
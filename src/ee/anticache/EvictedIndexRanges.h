@@ -0,0 +1,143 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef EVICTEDINDEXRANGES_H
+#define EVICTEDINDEXRANGES_H
+
+#include "common/types.h"
+
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+namespace voltdb {
+
+class TableIndex;
+class TableTuple;
+class TupleSchema;
+
+/**
+ * Lets a table drop the entries its non-unique secondary indexes have for
+ * the tuples it evicts, instead of pointing them at the EvictedTable. For
+ * each of those indexes this keeps the lowest and highest key of every
+ * evicted block and a bloom filter over the prefixes of its keys, so that
+ * a lookup that could have found one of the block's tuples can record the
+ * block as accessed and have the transaction restarted once it is read
+ * back, like a lookup that runs into an evicted tuple does.
+ *
+ * The blocks of an index are kept sorted by their lowest key, with a tree
+ * over the highest keys on top, so a lookup only visits the blocks whose
+ * ranges overlap the keys it scanned. The sorted order is rebuilt by the
+ * first lookup after blocks were added or removed.
+ *
+ * The range of a block stays until its tuples are merged, at which point
+ * their entries are added back to the indexes.
+ */
+class EvictedIndexRanges {
+    public:
+        EvictedIndexRanges(const std::vector<TableIndex*> &indexes);
+        ~EvictedIndexRanges();
+
+        inline bool covers(const TableIndex *index) const {
+            return m_ranges.find(index) != m_ranges.end();
+        }
+
+        /** Widen the ranges of the block by the keys of the evicted tuple */
+        void addTuple(int64_t blockId, const TableTuple &tuple);
+
+        /** The tuples of the block are back in the table */
+        void removeBlock(int64_t blockId);
+
+        /**
+         * Collect the blocks that may hold tuples the lookup would find.
+         * Only the first numKeys columns of the search key are compared.
+         * stopTuple is the table tuple the scan stopped at, because of its
+         * end expression or limit, and NULL if it ran out of entries.
+         * An ascending scan did not get past the key of stopTuple; a
+         * descending one, which only a scan without search keys can be,
+         * did not get below it. A scan without search keys that ran out
+         * of entries read the whole index and needs every block.
+         */
+        void findBlocks(const TableIndex *index, const TableTuple *searchKey, int numKeys,
+                        IndexLookupType lookupType, const TableTuple *stopTuple, bool ascending,
+                        std::vector<int64_t> &blockIds);
+
+        /** Number of index entries dropped for tuples that are still evicted */
+        inline int64_t getEntriesEvicted() const {
+            return m_entriesEvicted;
+        }
+        inline size_t getNumBlocks() const {
+            return m_numTuples.size();
+        }
+
+    private:
+        struct BlockKeys {
+            std::vector<char> low;
+            std::vector<char> high;
+            // bloom filter over the hashes of every prefix of every key
+            std::vector<uint64_t> filter;
+            // hashes of the keys added before the filter was sized
+            std::vector<uint64_t> pending;
+        };
+        typedef std::map<int64_t, BlockKeys> BlockRanges;
+
+        struct IndexRanges {
+            BlockRanges blocks;
+            // blocks sorted by their lowest key
+            std::vector<BlockRanges::iterator> byLow;
+            // position in byLow of the block with the highest key of each
+            // subtree, with the children of node i at 2i+1 and 2i+2
+            std::vector<size_t> maxHigh;
+            bool dirty;
+        };
+
+        // a key bound on the first numKeys columns of a tuple or key, with
+        // tuple NULL if the scan was unbounded on that side
+        struct Bound {
+            const TableTuple *tuple;
+            const std::vector<int> *columns;
+            int numKeys;
+        };
+
+        static void copyKey(const TableIndex *index, const TableTuple &tuple, std::vector<char> &storage);
+        static void freeKey(const TableIndex *index, std::vector<char> &storage);
+        static void addToFilter(std::vector<uint64_t> &filter, uint64_t hash);
+        static bool mayContain(const std::vector<uint64_t> &filter, uint64_t hash);
+
+        void rebuild(const TableIndex *index, IndexRanges &ranges);
+        size_t buildMaxHigh(const TableIndex *index, IndexRanges &ranges, size_t node, size_t begin, size_t end);
+        void collect(const TableIndex *index, const IndexRanges &ranges, const Bound &low, size_t limit,
+                     size_t node, size_t begin, size_t end, std::vector<size_t> &positions) const;
+
+        std::map<const TableIndex*, IndexRanges> m_ranges;
+        // evicted tuples of each block
+        std::map<int64_t, int32_t> m_numTuples;
+        int64_t m_entriesEvicted;
+}; // CLASS
+
+}
+
+#endif
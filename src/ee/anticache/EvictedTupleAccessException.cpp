@@ -35,7 +35,7 @@ using namespace voltdb;
 
 std::string EvictedTupleAccessException::ERROR_MSG = std::string("Txn tried to access evicted tuples");
 
-EvictedTupleAccessException::EvictedTupleAccessException(int tableId, int numBlockIds, int32_t blockIds[], int32_t tupleIDs[]) :
+EvictedTupleAccessException::EvictedTupleAccessException(int tableId, int numBlockIds, int64_t blockIds[], int32_t tupleIDs[]) :
     SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EVICTED_TUPLE, EvictedTupleAccessException::ERROR_MSG),
         m_tableId(tableId),
         m_numBlockIds(numBlockIds),
@@ -57,7 +57,7 @@ void EvictedTupleAccessException::p_serialize(ReferenceSerializeOutput *output)
     output->writeInt(m_tableId);
     output->writeShort(static_cast<short>(m_numBlockIds)); // # of block ids
     for (int ii = 0; ii < m_numBlockIds; ii++) {
-        output->writeInt(m_blockIds[ii]);
+        output->writeLong(m_blockIds[ii]);
     }
     
     for(int ii = 0; ii<m_numBlockIds; ii++) {  // write out the tuple offsets 
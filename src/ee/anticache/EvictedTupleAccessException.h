@@ -36,7 +36,7 @@ class ReferenceSerializeOutput;
 class EvictedTupleAccessException : public SerializableEEException {
     public:
 
-        EvictedTupleAccessException(int tableId, int numBlockIds, int32_t blockIds[], int32_t tupleKeys[]);
+        EvictedTupleAccessException(int tableId, int numBlockIds, int64_t blockIds[], int32_t tupleKeys[]);
         virtual ~EvictedTupleAccessException() {}
         
         static std::string ERROR_MSG;
@@ -47,7 +47,7 @@ class EvictedTupleAccessException : public SerializableEEException {
     private:
         const int m_tableId;
         const int m_numBlockIds;
-        const int32_t *m_blockIds;
+        const int64_t *m_blockIds;
         const int32_t *m_tupleKeys;
         const int m_partitionId;
 };
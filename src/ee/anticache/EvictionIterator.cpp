@@ -67,6 +67,64 @@ EvictionIterator::EvictionIterator(Table *t)
     current_tuple_id = 0;
     current_tuple = new TableTuple(table->schema());
     is_first = true; 
+#ifdef ANTICACHE_TIMESTAMPS
+    candidates = NULL;
+    m_size = 0;
+#endif
+
+    m_clock = (static_cast<PersistentTable*>(table)->getEvictionPolicy() == ANTICACHE_EVICTION_CLOCK);
+    m_clockReady = false;
+    m_inBlock = false;
+    m_block = 0;
+    m_slot = 0;
+    m_blocksSwept = 0;
+}
+
+/**
+ * Move current_tuple to the next tuple to evict under CLOCK. The hand
+ * gives every block whose reference bit is set a second chance by
+ * clearing the bit; the first block found with its bit clear is cold and
+ * all of its tuples are handed out before the hand moves on. Gives up
+ * once the hand went around twice without finding a tuple.
+ */
+bool EvictionIterator::nextClockTuple()
+{
+    PersistentTable* ptable = static_cast<PersistentTable*>(table);
+    uint32_t tuples_per_block = ptable->m_tuplesPerBlock;
+
+    while (true) {
+        uint32_t used_tuples = (uint32_t)ptable->usedTupleCount();
+        if (m_inBlock) {
+            while (m_slot < tuples_per_block) {
+                uint32_t tuple_id = m_block * tuples_per_block + m_slot;
+                if (tuple_id >= used_tuples)
+                    break;
+                m_slot++;
+                current_tuple->move(ptable->dataPtrForTuple(tuple_id));
+                if (current_tuple->isActive() && !current_tuple->isEvicted()) {
+                    m_blocksSwept = 0;
+                    return true;
+                }
+            }
+            m_inBlock = false;
+            ptable->setClockHand(m_block + 1);
+        }
+
+        uint32_t num_blocks = (used_tuples + tuples_per_block - 1) / tuples_per_block;
+        if (num_blocks == 0 || m_blocksSwept >= 2 * num_blocks)
+            return false;
+        m_blocksSwept++;
+
+        m_block = ptable->getClockHand() % num_blocks;
+        if (ptable->clearBlockReferenced(m_block)) {
+            VOLT_TRACE("Block %u was referenced, second chance", m_block);
+            ptable->setClockHand(m_block + 1);
+            continue;
+        }
+        VOLT_DEBUG("Evicting from cold block %u", m_block);
+        m_inBlock = true;
+        m_slot = 0;
+    }
 }
 
 #ifdef ANTICACHE_TIMESTAMPS
@@ -75,6 +133,8 @@ EvictionIterator::EvictionIterator(Table *t)
  */
 void EvictionIterator::reserve(int64_t amount) {
     VOLT_DEBUG("amount: %ld\n", amount);
+    if (m_clock)
+        return;
 
     char* addr = NULL;
     PersistentTable* ptable = static_cast<PersistentTable*>(table);
@@ -263,6 +323,12 @@ bool EvictionIterator::hasNext()
     if(ptable->usedTupleCount() == 0)
         return false; 
 
+    if (m_clock) {
+        if (!m_clockReady)
+            m_clockReady = nextClockTuple();
+        return m_clockReady;
+    }
+
 #ifndef ANTICACHE_TIMESTAMPS
     if(current_tuple_id == ptable->getNewestTupleID())
         return false;
@@ -280,6 +346,14 @@ bool EvictionIterator::hasNext()
 
 bool EvictionIterator::next(TableTuple &tuple)
 {    
+    if (m_clock) {
+        if (!m_clockReady && !nextClockTuple())
+            return false;
+        m_clockReady = false;
+        tuple.move(current_tuple->address());
+        return true;
+    }
+
 #ifndef ANTICACHE_TIMESTAMPS
     PersistentTable* ptable = static_cast<PersistentTable*>(table);
 
@@ -86,10 +86,21 @@ public:
     
 private: 
     
+    bool nextClockTuple();
+
     Table *table;     
     uint32_t current_tuple_id;
     TableTuple* current_tuple;
     bool is_first; 
+
+    // CLOCK eviction: the block under the hand, the next slot to look at in
+    // it and how many blocks the hand passed without finding a tuple
+    bool m_clock;
+    bool m_clockReady;
+    bool m_inBlock;
+    uint32_t m_block;
+    uint32_t m_slot;
+    uint32_t m_blocksSwept;
 #ifdef ANTICACHE_TIMESTAMPS
     EvictionTuple *candidates;
     int32_t m_size;
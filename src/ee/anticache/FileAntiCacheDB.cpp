@@ -0,0 +1,483 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "anticache/FileAntiCacheDB.h"
+#include "anticache/UnknownBlockAccessException.h"
+#include "anticache/FullBackingStoreException.h"
+#include "common/debuglog.h"
+#include "common/FatalException.hpp"
+#include "common/executorcontext.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef LINUX
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,1,0)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define ANTICACHE_IO_URING
+#endif
+#endif
+
+using namespace std;
+
+namespace voltdb {
+
+#ifdef ANTICACHE_IO_URING
+// submission and completion rings shared with the kernel
+struct FileAntiCacheDB::Ring {
+    int fd;
+    unsigned entries;
+    char *sqRing;
+    size_t sqRingSize;
+    char *cqRing;
+    size_t cqRingSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    volatile unsigned *sqHead;
+    volatile unsigned *sqTail;
+    unsigned sqMask;
+    unsigned *sqArray;
+    volatile unsigned *cqHead;
+    volatile unsigned *cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe *cqes;
+    unsigned queued;
+};
+
+static const unsigned RING_ENTRIES = 64;
+#else
+struct FileAntiCacheDB::Ring {
+};
+#endif
+
+FileAntiCacheBlock::FileAntiCacheBlock(int64_t blockId, char* buffer, long size) :
+    AntiCacheBlock(blockId) {
+
+    std::string tableName = buffer;
+    m_buf = buffer;
+    m_block = buffer + tableName.size() + 1;
+    m_size = size - tableName.size() - 1;
+
+    payload p;
+    p.tableName = tableName;
+    p.blockId = blockId;
+    p.data = m_block;
+    p.size = m_size;
+    m_payload = p;
+    m_blockType = ANTICACHEDB_FILE;
+
+    VOLT_INFO("FileAntiCacheBlock #%ld from table: %s [size=%ld / payload=%ld]",
+              (long)blockId, m_payload.tableName.c_str(), m_size, m_payload.size);
+}
+
+FileAntiCacheBlock::~FileAntiCacheBlock() {
+    delete [] m_buf;
+}
+
+FileAntiCacheDB::FileAntiCacheDB(ExecutorContext *ctx, std::string db_dir, long blockSize, long maxSize) :
+    AntiCacheDB(ctx, db_dir, blockSize, maxSize),
+    m_fd(-1),
+    m_slotSize(blockSize + SLOT_HEADER_SIZE),
+    m_nextSlot(0),
+    m_ring(NULL),
+    m_inFlight(0) {
+
+    m_dbType = ANTICACHEDB_FILE;
+    initializeDB();
+}
+
+FileAntiCacheDB::~FileAntiCacheDB() {
+    shutdownDB();
+}
+
+void FileAntiCacheDB::initializeDB() {
+    int partition_id;
+    // if there is no executor context, assume this is a test and let it go
+    if (!m_executorContext) {
+        VOLT_WARN("FileAntiCacheDB has no executor context. If this is an EE test, don't worry\n");
+        partition_id = 0;
+    } else {
+        partition_id = (int)m_executorContext->getPartitionId();
+    }
+
+    char file_name[32];
+    snprintf(file_name, sizeof(file_name), "/anticache-file-%d", partition_id);
+    std::string path = m_dbDir + file_name;
+    VOLT_INFO("Creating anti-cache block file: %s", path.c_str());
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0) {
+        VOLT_ERROR("Failed to open anti-cache block file %s: %s", path.c_str(), strerror(errno));
+        throwFatalException("Failed to initialize anti-cache block file in directory %s.", m_dbDir.c_str());
+    }
+    setupRing();
+}
+
+void FileAntiCacheDB::shutdownDB() {
+    AntiCacheMutexGuard guard(m_readMutex);
+    // the kernel may still write into the buffers of reads in flight
+    while (m_inFlight > 0) {
+        reapCompletions(true);
+    }
+    for (std::map<int64_t, PendingRead*>::iterator it = m_pendingReads.begin(); it != m_pendingReads.end(); ++it) {
+        delete [] it->second->buffer;
+        delete it->second;
+    }
+    m_pendingReads.clear();
+    teardownRing();
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void FileAntiCacheDB::flushBlocks() {
+    if (fdatasync(m_fd) != 0) {
+        VOLT_ERROR("Failed to sync anti-cache block file: %s", strerror(errno));
+    }
+}
+
+int64_t FileAntiCacheDB::nextBlockId() {
+    // completing a read frees its slot
+    AntiCacheMutexGuard guard(m_readMutex);
+    if (!m_freeSlots.empty()) {
+        int64_t slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        return slot;
+    }
+    if (m_nextSlot >= getMaxBlocks()) {
+        throw FullBackingStoreException(0, m_nextSlot);
+    }
+    return m_nextSlot++;
+}
+
+void FileAntiCacheDB::writeBlock(const std::string tableName,
+                                 int64_t blockId,
+                                 const int tupleCount,
+                                 const char* data,
+                                 const long size) {
+
+    if (getFreeBlocks() == 0) {
+        VOLT_WARN("No free space in ACID %d for blockid %ld with blocksize %ld",
+                  m_ACID, (long)blockId, size);
+        throw FullBackingStoreException(packBlockId(m_ACID, blockId), 0);
+    }
+    // the directory is read by the thread that submits reads
+    AntiCacheMutexGuard guard(m_readMutex);
+    long bufsize = tableName.size() + 1 + size;
+    if (bufsize > m_slotSize) {
+        throwFatalException("Anti-cache block %ld of %ld bytes does not fit a %ld byte slot",
+                            (long)blockId, bufsize, m_slotSize);
+    }
+
+    char* buffer = new char[bufsize];
+    memcpy(buffer, tableName.c_str(), tableName.size() + 1);
+    memcpy(buffer + tableName.size() + 1, data, size);
+    off_t offset = (off_t)blockId * m_slotSize;
+    long written = 0;
+    while (written < bufsize) {
+        ssize_t result = pwrite(m_fd, buffer + written, bufsize - written, offset + written);
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) {
+            delete [] buffer;
+            throwFatalException("Failed to write anti-cache block %ld: %s", (long)blockId, strerror(errno));
+        }
+        written += result;
+    }
+    delete [] buffer;
+
+    VOLT_INFO("Writing File Block: ID = %ld, size = %ld", (long)blockId, bufsize);
+    m_blockDirectory.insert(blockId, static_cast<int32_t>(bufsize));
+    if (static_cast<size_t>(blockId) >= m_dataOffsets.size()) {
+        m_dataOffsets.resize(static_cast<size_t>(blockId) + 1, 0);
+    }
+    m_dataOffsets[blockId] = static_cast<uint16_t>(tableName.size() + 1);
+    pushBlockLRU(blockId);
+}
+
+AntiCacheBlock* FileAntiCacheDB::readBlock(int64_t blockId) {
+    AntiCacheMutexGuard guard(m_readMutex);
+    if (m_pendingReads.find(blockId) != m_pendingReads.end()) {
+        return completeRead(blockId);
+    }
+    int32_t size = m_blockDirectory.find(blockId);
+    if (size == 0) {
+        VOLT_ERROR("Invalid anti-cache blockId '%ld'", (long)blockId);
+        throw UnknownBlockAccessException(blockId);
+    }
+    char* buffer = new char[size];
+    readFully(buffer, size, (off_t)blockId * m_slotSize, 0);
+    releaseBlock(blockId);
+    return new FileAntiCacheBlock(blockId, buffer, size);
+}
+
+long FileAntiCacheDB::readBlockRange(int64_t blockId, long offset, long length, char* buffer) {
+    AntiCacheMutexGuard guard(m_readMutex);
+    int32_t size = m_blockDirectory.find(blockId);
+    if (size == 0) {
+        VOLT_ERROR("Invalid anti-cache blockId '%ld'", (long)blockId);
+        throw UnknownBlockAccessException(blockId);
+    }
+    long dataOffset = m_dataOffsets[blockId];
+    long available = size - dataOffset - offset;
+    if (length > available) {
+        length = (available > 0 ? available : 0);
+    }
+    readFully(buffer, length, (off_t)blockId * m_slotSize + dataOffset + offset, 0);
+    return length;
+}
+
+void FileAntiCacheDB::submitReads(const std::vector<int64_t> &blockIds) {
+    if (!isAsync()) {
+        AntiCacheDB::submitReads(blockIds);
+        return;
+    }
+    // the ring and the reads in flight are shared with completeRead()
+    AntiCacheMutexGuard guard(m_readMutex);
+    // nothing is submitted unless every block is known
+    for (std::vector<int64_t>::const_iterator it = blockIds.begin(); it != blockIds.end(); ++it) {
+        if (!m_blockDirectory.contains(*it)) {
+            VOLT_ERROR("Invalid anti-cache blockId '%ld'", (long)*it);
+            throw UnknownBlockAccessException(*it);
+        }
+    }
+    for (std::vector<int64_t>::const_iterator it = blockIds.begin(); it != blockIds.end(); ++it) {
+        if (m_pendingReads.find(*it) != m_pendingReads.end()) {
+            continue;
+        }
+        PendingRead *read = new PendingRead();
+        read->size = m_blockDirectory.find(*it);
+        read->buffer = new char[read->size];
+        read->iov.iov_base = read->buffer;
+        read->iov.iov_len = read->size;
+        read->result = 0;
+        read->landed = false;
+        read->submitted = LatencyHistogram::nowMicros();
+        m_pendingReads[*it] = read;
+        while (!queueRead(*it, read)) {
+            // the rings are full, make room
+            submitQueued();
+            reapCompletions(true);
+        }
+    }
+    submitQueued();
+    reapCompletions(false);
+    VOLT_DEBUG("Submitted %d anti-cache block reads, %d in flight", (int)blockIds.size(), m_inFlight);
+}
+
+AntiCacheBlock* FileAntiCacheDB::completeRead(int64_t blockId) {
+    AntiCacheMutexGuard guard(m_readMutex);
+    std::map<int64_t, PendingRead*>::iterator it = m_pendingReads.find(blockId);
+    if (it == m_pendingReads.end()) {
+        return AntiCacheDB::completeRead(blockId);
+    }
+    PendingRead *read = it->second;
+    while (!read->landed) {
+        reapCompletions(true);
+    }
+    m_pendingReads.erase(it);
+
+    off_t offset = (off_t)blockId * m_slotSize;
+    if (read->result < 0) {
+        VOLT_WARN("Asynchronous read of anti-cache block %ld failed (%s), reading it again",
+                  (long)blockId, strerror(-read->result));
+        read->result = 0;
+    }
+    // short reads are finished synchronously
+    readFully(read->buffer, read->size, offset, read->result);
+
+    char *buffer = read->buffer;
+    int32_t size = read->size;
+    delete read;
+    releaseBlock(blockId);
+    return new FileAntiCacheBlock(blockId, buffer, size);
+}
+
+void FileAntiCacheDB::releaseBlock(int64_t blockId) {
+    m_freeSlots.push_back(blockId);
+    m_blockDirectory.erase(blockId);
+    removeBlockLRU(blockId);
+}
+
+void FileAntiCacheDB::readFully(char *buffer, long size, off_t offset, long done) {
+    while (done < size) {
+        ssize_t result = pread(m_fd, buffer + done, size - done, offset + done);
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) {
+            throwFatalException("Failed to read anti-cache block at offset %ld: %s",
+                                (long)offset, result == 0 ? "end of file" : strerror(errno));
+        }
+        done += result;
+    }
+}
+
+#ifdef ANTICACHE_IO_URING
+
+void FileAntiCacheDB::setupRing() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+    if (fd < 0) {
+        VOLT_WARN("io_uring is not available (%s), anti-cache blocks are read synchronously",
+                  strerror(errno));
+        return;
+    }
+
+    Ring *ring = new Ring();
+    memset(ring, 0, sizeof(Ring));
+    ring->fd = fd;
+    ring->entries = params.sq_entries;
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    void *sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_SQ_RING);
+    void *cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_CQ_RING);
+    void *sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+        VOLT_WARN("Failed to map the io_uring rings (%s), anti-cache blocks are read synchronously",
+                  strerror(errno));
+        if (sqRing != MAP_FAILED) munmap(sqRing, ring->sqRingSize);
+        if (cqRing != MAP_FAILED) munmap(cqRing, ring->cqRingSize);
+        if (sqes != MAP_FAILED) munmap(sqes, ring->sqesSize);
+        close(fd);
+        delete ring;
+        return;
+    }
+    ring->sqRing = static_cast<char*>(sqRing);
+    ring->cqRing = static_cast<char*>(cqRing);
+    ring->sqes = static_cast<struct io_uring_sqe*>(sqes);
+    ring->sqHead = reinterpret_cast<volatile unsigned*>(ring->sqRing + params.sq_off.head);
+    ring->sqTail = reinterpret_cast<volatile unsigned*>(ring->sqRing + params.sq_off.tail);
+    ring->sqMask = *reinterpret_cast<unsigned*>(ring->sqRing + params.sq_off.ring_mask);
+    ring->sqArray = reinterpret_cast<unsigned*>(ring->sqRing + params.sq_off.array);
+    ring->cqHead = reinterpret_cast<volatile unsigned*>(ring->cqRing + params.cq_off.head);
+    ring->cqTail = reinterpret_cast<volatile unsigned*>(ring->cqRing + params.cq_off.tail);
+    ring->cqMask = *reinterpret_cast<unsigned*>(ring->cqRing + params.cq_off.ring_mask);
+    ring->cqes = reinterpret_cast<struct io_uring_cqe*>(ring->cqRing + params.cq_off.cqes);
+    m_ring = ring;
+    VOLT_INFO("Anti-cache block reads go through io_uring with %u entries", ring->entries);
+}
+
+void FileAntiCacheDB::teardownRing() {
+    if (m_ring == NULL) return;
+    munmap(m_ring->sqes, m_ring->sqesSize);
+    munmap(m_ring->cqRing, m_ring->cqRingSize);
+    munmap(m_ring->sqRing, m_ring->sqRingSize);
+    close(m_ring->fd);
+    delete m_ring;
+    m_ring = NULL;
+}
+
+bool FileAntiCacheDB::queueRead(int64_t blockId, PendingRead *read) {
+    // every read in flight needs a completion entry, there are twice as many as submission entries
+    if (m_inFlight + m_ring->queued >= (int)m_ring->entries) {
+        return false;
+    }
+    unsigned tail = *m_ring->sqTail;
+    unsigned index = tail & m_ring->sqMask;
+    struct io_uring_sqe *sqe = &m_ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = m_fd;
+    sqe->off = (uint64_t)blockId * m_slotSize;
+    sqe->addr = (uint64_t)(uintptr_t)&read->iov;
+    sqe->len = 1;
+    sqe->user_data = (uint64_t)blockId;
+    m_ring->sqArray[index] = index;
+    __sync_synchronize();
+    *m_ring->sqTail = tail + 1;
+    m_ring->queued++;
+    return true;
+}
+
+void FileAntiCacheDB::submitQueued() {
+    while (m_ring->queued > 0) {
+        int submitted = (int)syscall(__NR_io_uring_enter, m_ring->fd, m_ring->queued, 0, 0, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+            throwFatalException("Failed to submit anti-cache block reads: %s", strerror(errno));
+        }
+        m_ring->queued -= submitted;
+        m_inFlight += submitted;
+    }
+}
+
+void FileAntiCacheDB::reapCompletions(bool wait) {
+    unsigned head = *m_ring->cqHead;
+    __sync_synchronize();
+    if (wait && head == *m_ring->cqTail && m_inFlight > 0) {
+        int result = (int)syscall(__NR_io_uring_enter, m_ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (result < 0 && errno != EINTR) {
+            throwFatalException("Failed to wait for anti-cache block reads: %s", strerror(errno));
+        }
+        __sync_synchronize();
+    }
+    int64_t now = LatencyHistogram::nowMicros();
+    while (head != *m_ring->cqTail) {
+        __sync_synchronize();
+        struct io_uring_cqe *cqe = &m_ring->cqes[head & m_ring->cqMask];
+        int64_t blockId = (int64_t)cqe->user_data;
+        std::map<int64_t, PendingRead*>::iterator it = m_pendingReads.find(blockId);
+        assert(it != m_pendingReads.end());
+        it->second->result = cqe->res;
+        it->second->landed = true;
+        m_readLatency.record(now - it->second->submitted);
+        m_inFlight--;
+        head++;
+    }
+    __sync_synchronize();
+    *m_ring->cqHead = head;
+}
+
+#else
+
+void FileAntiCacheDB::setupRing() {
+    VOLT_INFO("Built without io_uring, anti-cache blocks are read synchronously");
+}
+
+void FileAntiCacheDB::teardownRing() {
+}
+
+bool FileAntiCacheDB::queueRead(int64_t blockId, PendingRead *read) {
+    return false;
+}
+
+void FileAntiCacheDB::submitQueued() {
+}
+
+void FileAntiCacheDB::reapCompletions(bool wait) {
+}
+
+#endif
+
+}
@@ -0,0 +1,173 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FILEHSTOREANTICACHE_H
+#define FILEHSTOREANTICACHE_H
+
+#include "common/types.h"
+#include "common/debuglog.h"
+#include "common/LatencyHistogram.h"
+#include "anticache/AntiCacheDB.h"
+#include "anticache/AntiCacheBlockDirectory.h"
+
+#include <sys/uio.h>
+
+using namespace std;
+
+namespace voltdb {
+
+class ExecutorContext;
+class AntiCacheDB;
+
+class FileAntiCacheBlock : public AntiCacheBlock {
+    friend class FileAntiCacheDB;
+
+    public:
+        ~FileAntiCacheBlock();
+
+    private:
+        /** Takes over buffer, which holds the table name followed by the data */
+        FileAntiCacheBlock(int64_t blockId, char* buffer, long size);
+}; // CLASS
+
+/**
+ * Anti-cache database that keeps its blocks in a plain file, one fixed
+ * size slot per block id. submitReads() hands all of its reads to the
+ * kernel at once through io_uring, so they land in the background while
+ * the site keeps running, and completeRead() only waits for the ones that
+ * have not landed yet. Without io_uring (older kernel or headers) the
+ * reads happen in submitReads() with pread().
+ */
+class FileAntiCacheDB : public AntiCacheDB {
+    public:
+        FileAntiCacheDB(ExecutorContext *ctx, std::string db_dir, long blockSize, long maxSize);
+        ~FileAntiCacheDB();
+
+        void initializeDB();
+
+        int64_t nextBlockId();
+
+        AntiCacheBlock* readBlock(int64_t blockId);
+
+        void submitReads(const std::vector<int64_t> &blockIds);
+
+        AntiCacheBlock* completeRead(int64_t blockId);
+
+        long readBlockRange(int64_t blockId, long offset, long length, char* buffer);
+
+        void shutdownDB();
+
+        void flushBlocks();
+
+        void writeBlock(const std::string tableName,
+                        int64_t blockId,
+                        const int tupleCount,
+                        const char* data,
+                        const long size);
+
+        /**
+         * Whether reads go through io_uring
+         */
+        inline bool isAsync() const {
+            return m_ring != NULL;
+        }
+
+        /**
+         * Number of submitted reads that have not completed yet
+         */
+        inline int getReadsInFlight() const {
+            return m_inFlight;
+        }
+
+        /**
+         * Time from submitting a read until its completion was seen
+         */
+        inline const LatencyHistogram& getReadLatency() const {
+            return m_readLatency;
+        }
+
+    private:
+        struct Ring;
+
+        struct PendingRead {
+            char *buffer;
+            struct iovec iov;
+            int32_t size;
+            int32_t result;
+            bool landed;
+            int64_t submitted;
+        };
+
+        /** Space for the table name in front of the data of a block */
+        static const long SLOT_HEADER_SIZE = 4096;
+
+        int m_fd;
+        long m_slotSize;
+        int64_t m_nextSlot;
+        std::vector<int64_t> m_freeSlots;
+
+        /*
+         *  Size of each stored block, the block id is its slot
+         */
+        AntiCacheBlockDirectory m_blockDirectory;
+
+        /*
+         *  Bytes in front of the data of each slot (the table name), by slot
+         */
+        std::vector<uint16_t> m_dataOffsets;
+
+        std::map<int64_t, PendingRead*> m_pendingReads;
+        Ring *m_ring;
+        int m_inFlight;
+        LatencyHistogram m_readLatency;
+
+        void setupRing();
+        void teardownRing();
+
+        /**
+         * Queue the read on the submission ring, false if the ring is full
+         */
+        bool queueRead(int64_t blockId, PendingRead *read);
+
+        /**
+         * Hand the queued reads to the kernel
+         */
+        void submitQueued();
+
+        /**
+         * Collect finished reads, waiting for at least one if wait is set
+         */
+        void reapCompletions(bool wait);
+
+        /**
+         * Forget the block and give its slot back once it has been read
+         */
+        void releaseBlock(int64_t blockId);
+
+        void readFully(char *buffer, long size, off_t offset, long done);
+};
+
+}
+#endif
@@ -32,7 +32,7 @@ using namespace voltdb;
 
 std::string FullBackingStoreException::ERROR_MSG = std::string("Backing store full");
 
-FullBackingStoreException::FullBackingStoreException(uint32_t srcBlockId, uint32_t dstBlockId) :
+FullBackingStoreException::FullBackingStoreException(int64_t srcBlockId, int64_t dstBlockId) :
     SerializableEEException(VOLT_EE_EXCEPTION_TYPE_UNKNOWN_BLOCK, FullBackingStoreException::ERROR_MSG),
         m_src_blockId(srcBlockId), 
         m_dst_blockId(dstBlockId) {
@@ -41,6 +41,6 @@ FullBackingStoreException::FullBackingStoreException(uint32_t srcBlockId, uint32
 }
 
 void FullBackingStoreException::p_serialize(ReferenceSerializeOutput *output) {
-    output->writeInt(m_src_blockId);
-    output->writeInt(m_dst_blockId);
+    output->writeLong(m_src_blockId);
+    output->writeLong(m_dst_blockId);
 }
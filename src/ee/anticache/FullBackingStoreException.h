@@ -36,7 +36,7 @@ class ReferenceSerializeOutput;
 class FullBackingStoreException: public SerializableEEException {
     public:
 
-        FullBackingStoreException(uint32_t srcBlockId, uint32_t dstBlockId); 
+        FullBackingStoreException(int64_t srcBlockId, int64_t dstBlockId); 
         virtual ~FullBackingStoreException() {}
         
         static std::string ERROR_MSG;
@@ -45,8 +45,8 @@ class FullBackingStoreException: public SerializableEEException {
         void p_serialize(ReferenceSerializeOutput *output);
         
     private:
-        const uint32_t m_src_blockId;
-        const uint32_t m_dst_blockId;
+        const int64_t m_src_blockId;
+        const int64_t m_dst_blockId;
 };
 }
 
@@ -36,30 +36,19 @@
 #include <sys/mman.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 using namespace std;
 
 namespace voltdb {
 
-NVMAntiCacheBlock::NVMAntiCacheBlock(int16_t blockId, char* block, long size) :
-    AntiCacheBlock(blockId) {
+NVMAntiCacheBlock::NVMAntiCacheBlock(NVMAntiCacheDB* db, int64_t blockId, char* block, long size) :
+    AntiCacheBlock(blockId), m_db(db) {
 
-    /* m_block = block;
-    m_size = size;
-    m_blockType = ANTICACHEDB_NVM;
-    */
-    char* buffer = block;
-    std::string tableName = buffer;
-    
-    block = buffer + tableName.size() + 1;
+    std::string tableName = block;
+    m_block = block + tableName.size() + 1;
     size -= tableName.size() + 1;
 
-
-    m_block = new char[size];
-    memcpy(m_block, block, size);
-
-    delete [] buffer;
-
     payload p;
     p.tableName = tableName;
     p.blockId = blockId;
@@ -69,15 +58,14 @@ NVMAntiCacheBlock::NVMAntiCacheBlock(int16_t blockId, char* block, long size) :
     m_payload = p;
     m_size = size;
     m_blockType = ANTICACHEDB_NVM;
-    //std::string payload_str(m_payload.data, m_size);
     
-    VOLT_INFO("NVMAntiCacheBlock #%d from table: %s [size=%ld / payload=%ld]",
-              blockId, m_payload.tableName.c_str(), m_size, m_payload.size);
+    VOLT_INFO("NVMAntiCacheBlock #%ld from table: %s [size=%ld / payload=%ld]",
+              (long)blockId, m_payload.tableName.c_str(), m_size, m_payload.size);
     
 }
 
 NVMAntiCacheBlock::~NVMAntiCacheBlock() {
-    delete [] m_block;
+    m_db->freeNVMBlock(m_blockId);
 }
 
 NVMAntiCacheDB::NVMAntiCacheDB(ExecutorContext *ctx, std::string db_dir, long blockSize, long maxSize) :
@@ -88,6 +76,11 @@ NVMAntiCacheDB::NVMAntiCacheDB(ExecutorContext *ctx, std::string db_dir, long bl
 }
 
 NVMAntiCacheDB::~NVMAntiCacheDB() {
+    // blocks read ahead by submitReads() still point into the file
+    for (std::map<int64_t, AntiCacheBlock*>::iterator it = m_readBlocks.begin(); it != m_readBlocks.end(); ++it) {
+        delete it->second;
+    }
+    m_readBlocks.clear();
     shutdownDB();
 }
 
@@ -96,12 +89,14 @@ void NVMAntiCacheDB::initializeDB() {
     char nvm_file_name[150];
     char partition_str[50];
 
-    m_blockIndex = 0; 
     m_nextFreeBlock = 0;
+    m_fileSize = m_maxDBSize;
+
     // TODO: Make DRAM based store a separate type
     #ifdef ANTICACHE_DRAM
         VOLT_INFO("Allocating anti-cache in DRAM."); 
-        m_NVMBlocks = new char[m_maxDBSize];
+        m_NVMBlocks = new char[m_fileSize];
+        formatFile();
     return; 
     #endif
 
@@ -122,167 +117,159 @@ void NVMAntiCacheDB::initializeDB() {
     strcat(nvm_file_name, "/anticache-");
     strcat(nvm_file_name, partition_str);
     VOLT_INFO("Creating nvm file: %s", nvm_file_name); 
-    nvm_file = fopen(nvm_file_name, "w"); 
+    // the blocks of a previous run are dropped, see the class comment
+    int nvm_fd = open(nvm_file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
 
-    if(nvm_file == NULL)
-    {
-        VOLT_ERROR("Anti-Cache initialization error."); 
-        VOLT_ERROR("Failed to open PMFS file %s: %s.", nvm_file_name, strerror(errno));
-        throwFatalException("Failed to initialize anti-cache PMFS file in directory %s.", m_dbDir.c_str());
-    }
-
-    fclose(nvm_file); 
-    nvm_file = fopen(nvm_file_name, "rw+"); 
-
-    if(nvm_file == NULL)
+    if(nvm_fd < 0)
     {
         VOLT_ERROR("Anti-Cache initialization error."); 
         VOLT_ERROR("Failed to open PMFS file %s: %s.", nvm_file_name, strerror(errno));
         throwFatalException("Failed to initialize anti-cache PMFS file in directory %s.", m_dbDir.c_str());
     }
 
-    nvm_fd = fileno(nvm_file); 
-    if(nvm_fd < 0)
-    {
-        VOLT_ERROR("Anti-Cache initialization error."); 
-        VOLT_ERROR("Failed to allocate anti-cache PMFS file in directory %s.", m_dbDir.c_str());
-        throwFatalException("Failed to initialize anti-cache PMFS file in directory %s.", m_dbDir.c_str());
-    }
-    
-    if(ftruncate(nvm_fd, m_maxDBSize) < 0)
+    if(ftruncate(nvm_fd, m_fileSize) < 0)
     {
         VOLT_ERROR("Anti-Cache initialization error."); 
         VOLT_ERROR("Failed to ftruncate anti-cache PMFS file %s: %s", nvm_file_name, strerror(errno));
+        close(nvm_fd);
         throwFatalException("Failed to initialize anti-cache PMFS file in directory %s.", m_dbDir.c_str());
     }
 
-    //off_t aligned_file_size = (((NVM_FILE_SIZE) + MMAP_PAGE_SIZE - 1) / MMAP_PAGE_SIZE * MMAP_PAGE_SIZE);  
-    off_t aligned_file_size = (off_t)m_maxDBSize; 
-
-    m_NVMBlocks =  (char*)mmap(NULL, aligned_file_size, PROT_READ | PROT_WRITE, MAP_SHARED, nvm_fd, 0);
+    m_NVMBlocks =  (char*)mmap(NULL, m_fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, nvm_fd, 0);
  
     if(m_NVMBlocks == MAP_FAILED)
     {
         VOLT_ERROR("Anti-Cache initialization error."); 
         VOLT_ERROR("Failed to mmap PMFS file %s: %s", nvm_file_name, strerror(errno));
+        close(nvm_fd);
         throwFatalException("Failed to initialize anti-cache PMFS file in directory %s.", m_dbDir.c_str());
     }
 
     close(nvm_fd); // can safely close file now, mmap creates new reference
     
-    // write out NULL characters to ensure entire file has been fetchted from memory
-    
-    for(int i = 0; i < m_maxDBSize; i++)
-    {
-        m_NVMBlocks[i] = '\0'; 
-    }
-    
+    formatFile();
 }
+
 void NVMAntiCacheDB::shutdownDB() { 
-  fclose(nvm_file);
   #ifdef ANTICACHE_DRAM 
       delete [] m_NVMBlocks;
+  #else
+      munmap(m_NVMBlocks, m_fileSize);
   #endif 
 }
 
+void NVMAntiCacheDB::formatFile() {
+    // write out NULL characters to ensure entire file has been fetchted from memory
+    for(long i = 0; i < m_fileSize; i++)
+    {
+        m_NVMBlocks[i] = '\0'; 
+    }
+}
+
 void NVMAntiCacheDB::flushBlocks() {
-    //MJG TODO: Do we need a sync() or something?
+    // nothing is read back from the file after a restart
 }
 
 void NVMAntiCacheDB::writeBlock(const std::string tableName,
-                                int16_t blockId,
+                                int64_t blockId,
                                 const int tupleCount,
                                 const char* data,
                                 const long size)  {
    
     if (getFreeBlocks() == 0) {
-        VOLT_WARN("No free space in ACID %d for blockid %d with blocksize %ld",
-                m_ACID, blockId, size);
-        throw FullBackingStoreException(((int32_t)m_ACID << 16) & blockId, 0);
+        VOLT_WARN("No free space in ACID %d for blockid %ld with blocksize %ld",
+                m_ACID, (long)blockId, size);
+        throw FullBackingStoreException(packBlockId(m_ACID, blockId), 0);
+    }
+    int64_t index = blockId;
+    VOLT_TRACE("block index: %ld", (long)index);
+    long bufsize = tableName.size() + 1 + size;
+    if (index < 0 || index >= getMaxBlocks() || bufsize > m_blockSize) {
+        throwFatalException("Block %ld of table '%s' does not fit in the NVM anti-cache [size=%ld / slotSize=%ld]",
+                            (long)blockId, tableName.c_str(), bufsize, m_blockSize);
     }
-    int index = (int)blockId;
-    VOLT_TRACE("block index: %d", index);
+
+    // straight into the slot, the table name first
     char* block = getNVMBlock(index); 
-    long bufsize; 
-    char* buffer = new char [tableName.size() + 1 + size];
-    memset(buffer, 0, tableName.size() + 1 + size);
-    bufsize = tableName.size() + 1;
-    memcpy(buffer, tableName.c_str(), bufsize);
-    memcpy(buffer + bufsize, data, size);
-    bufsize += size;
-    memcpy(block, buffer, bufsize); 
-    delete[] buffer;
-
-    VOLT_INFO("Writing NVM Block: ID = %d, index = %d, size = %ld", blockId, index, bufsize); 
-
-    m_blockMap.insert(std::pair<int16_t, std::pair<int, int32_t> >(blockId, std::pair<int, int32_t>(index, static_cast<int32_t>(bufsize))));
-    m_nextFreeBlock++; 
+    memcpy(block, tableName.c_str(), tableName.size() + 1);
+    memmove(block + tableName.size() + 1, data, size);
+
+    VOLT_INFO("Writing NVM Block: ID = %ld, index = %ld, size = %ld", (long)blockId, (long)index, bufsize); 
+
+    m_blockDirectory.insert(blockId, static_cast<int32_t>(bufsize));
+    if (index >= m_nextFreeBlock) {
+        m_nextFreeBlock = index + 1;
+    }
     
     pushBlockLRU(blockId);
 }
 
-AntiCacheBlock* NVMAntiCacheDB::readBlock(int16_t blockId) {
+AntiCacheBlock* NVMAntiCacheDB::readBlock(int64_t blockId) {
     
-    std::map<int16_t, std::pair<int, int32_t> >::iterator itr; 
-    itr = m_blockMap.find(blockId); 
+    int blockSize = m_blockDirectory.find(blockId); 
   
-    if (itr == m_blockMap.end()) {
-        VOLT_INFO("Invalid anti-cache blockId '%d'", blockId);
-        VOLT_ERROR("Invalid anti-cache blockId '%d'", blockId);
+    if (blockSize == 0) {
+        VOLT_INFO("Invalid anti-cache blockId '%ld'", (long)blockId);
+        VOLT_ERROR("Invalid anti-cache blockId '%ld'", (long)blockId);
         //throw UnknownBlockAccessException(tableName, blockId);
         throw UnknownBlockAccessException(blockId);
    
     }
 
-    int blockIndex = itr->second.first; 
-    int blockSize = itr->second.second;
-    VOLT_INFO("Reading NVM block: ID = %d, index = %d, size = %d", blockId, blockIndex, blockSize);
+    int64_t blockIndex = blockId; 
+    VOLT_INFO("Reading NVM block: ID = %ld, index = %ld, size = %d", (long)blockId, (long)blockIndex, blockSize);
    
-    char* block_ptr = getNVMBlock(blockIndex);
-    char* block = new char[blockSize];
-    memcpy(block, block_ptr, blockSize); 
-    
-    AntiCacheBlock* anticache_block = new NVMAntiCacheBlock(blockId, block, blockSize);
-
-    freeNVMBlock(blockId); 
+    // no copy, the slot is freed when the block is deleted
+    AntiCacheBlock* anticache_block = new NVMAntiCacheBlock(this, blockId, getNVMBlock(blockIndex), blockSize);
 
-    m_blockMap.erase(itr); 
+    m_blockDirectory.erase(blockId); 
 
     removeBlockLRU(blockId);
     return (anticache_block);
 }
 
-char* NVMAntiCacheDB::getNVMBlock(int index) {
-    //char* nvm_block = new char[NVM_BLOCK_SIZE];     
-    //memcpy(nvm_block, m_NVMBlocks+(index*NVM_BLOCK_SIZE), NVM_BLOCK_SIZE); 
-    
-    //return nvm_block; 
-    //return (m_NVMBlocks+(index*NVM_BLOCK_SIZE));  
-    return (m_NVMBlocks+(index*m_blockSize));
+long NVMAntiCacheDB::readBlockRange(int64_t blockId, long offset, long length, char* buffer) {
+    int32_t blockSize = m_blockDirectory.find(blockId);
+    if (blockSize == 0) {
+        VOLT_ERROR("Invalid anti-cache blockId '%ld'", (long)blockId);
+        throw UnknownBlockAccessException(blockId);
+    }
+    // the data follows the name of the table
+    char* block_ptr = getNVMBlock(blockId);
+    long dataOffset = strlen(block_ptr) + 1;
+    long available = blockSize - dataOffset - offset;
+    if (length > available) {
+        length = (available > 0 ? available : 0);
+    }
+    memcpy(buffer, block_ptr + dataOffset + offset, length);
+    return length;
+}
+
+char* NVMAntiCacheDB::getNVMBlock(int64_t index) {
+    return (m_NVMBlocks + (index*m_blockSize));
 }
 
-int NVMAntiCacheDB::getFreeNVMBlockIndex() {
+int64_t NVMAntiCacheDB::getFreeNVMBlockIndex() {
   
-    int free_index = 0; 
+    int64_t free_index = 0; 
     if(m_NVMBlockFreeList.size() > 0) {
         free_index = m_NVMBlockFreeList.back(); 
-        VOLT_TRACE("popping %d from list of size: %d", free_index, (int)m_NVMBlockFreeList.size());
+        VOLT_TRACE("popping %ld from list of size: %d", (long)free_index, (int)m_NVMBlockFreeList.size());
         m_NVMBlockFreeList.pop_back(); 
     } else {
         if (m_nextFreeBlock == getMaxBlocks()) {
             throw FullBackingStoreException(0, m_nextFreeBlock);
         } else {
-            free_index = m_nextFreeBlock;
+            // taken right away, the block may be written after the next id is handed out
+            free_index = m_nextFreeBlock++;
         }
     }
   
-    //int free_index = m_blockIndex++; 
     return free_index; 
 }
 
-void NVMAntiCacheDB::freeNVMBlock(int index) {
+void NVMAntiCacheDB::freeNVMBlock(int64_t index) {
     m_NVMBlockFreeList.push_back(index); 
-    VOLT_TRACE("list size: %d  back: %d", (int)m_NVMBlockFreeList.size(), m_NVMBlockFreeList.back());
-    //m_blockIndex--; 
+    VOLT_TRACE("list size: %d  back: %ld", (int)m_NVMBlockFreeList.size(), (long)m_NVMBlockFreeList.back());
 }
 }
@@ -29,6 +29,7 @@
 #include "common/types.h"
 #include "common/debuglog.h"
 #include "anticache/AntiCacheDB.h"
+#include "anticache/AntiCacheBlockDirectory.h"
 
 using namespace std;
 
@@ -36,7 +37,13 @@ namespace voltdb {
 
 class ExecutorContext;
 class AntiCacheDB;
+class NVMAntiCacheDB;
 
+/**
+ * A block read back from the NVM tier. Its data is a view into the mapped
+ * file rather than a copy: the block's slot is only handed out again once
+ * the block is deleted, which has to happen before the NVMAntiCacheDB goes.
+ */
 class NVMAntiCacheBlock : public AntiCacheBlock {
     friend class NVMAntiCacheDB;
     friend class AntiCacheDB;
@@ -45,73 +52,80 @@ class NVMAntiCacheBlock : public AntiCacheBlock {
         ~NVMAntiCacheBlock();
 
     private:
-        NVMAntiCacheBlock(int16_t blockId, char* block, long size);
-        //std::string m_tableName;
+        /** block points at the slot, which holds the table name followed by the data */
+        NVMAntiCacheBlock(NVMAntiCacheDB* db, int64_t blockId, char* block, long size);
+
+        NVMAntiCacheDB* m_db;
 }; // CLASS
 
+/**
+ * Anti-cache database that keeps its blocks in a memory-mapped file on
+ * NVM (PMFS), one fixed size slot per block id.
+ *
+ * The blocks do not survive a restart: the file is truncated when the
+ * database is opened. The EvictedTables that point at the blocks live in
+ * memory only and start out empty after a restart, so nothing could find
+ * the blocks of a previous run anyway.
+ */
 class NVMAntiCacheDB : public AntiCacheDB {
+    friend class NVMAntiCacheBlock;
+
     public:
         NVMAntiCacheDB(ExecutorContext *ctx, std::string db_dir, long blockSize, long maxSize);
         ~NVMAntiCacheDB();
 
         void initializeDB();
 
-        inline int16_t nextBlockId() {
-            return (int16_t)getFreeNVMBlockIndex(); 
+        inline int64_t nextBlockId() {
+            return getFreeNVMBlockIndex(); 
         }
 
-        AntiCacheBlock* readBlock(int16_t blockId);
+        AntiCacheBlock* readBlock(int64_t blockId);
+
+        long readBlockRange(int64_t blockId, long offset, long length, char* buffer);
 
         void shutdownDB();
 
         void flushBlocks();
 
         void writeBlock(const std::string tableName,
-                        int16_t blockId,
+                        int64_t blockId,
                         const int tupleCount,
                         const char* data,
                         const long size);
 
     private:
-        /**
-         * NVM constants
-         */
-        /* I don't think these are used anymore -MJG
-        static const off_t NVM_FILE_SIZE = 1073741824/2; 
-        static const int NVM_BLOCK_SIZE = 524288 + 1000; 
-        static const int MMAP_PAGE_SIZE = 2 * 1024 * 1024; 
-        */
-        FILE* nvm_file;
         char* m_NVMBlocks; 
-        int nvm_fd; 
-        int m_blockIndex;
+        long m_fileSize;
 
-        int m_nextFreeBlock; 
+        int64_t m_nextFreeBlock; 
         
         /**
          *  List of free block indexes before the end of the last allocated block.
          */
-        std::vector<int> m_NVMBlockFreeList; 
+        std::vector<int64_t> m_NVMBlockFreeList; 
 
         /*
-         *  Maps a block id to a <index, size> pair
+         *  Size of each stored block, the block id is its index
          */
-        std::map<int16_t, pair<int, int32_t> > m_blockMap; 
+        AntiCacheBlockDirectory m_blockDirectory; 
 
         /**
          *   Returns a pointer to the start of the block at the specified index. 
          */
-        char* getNVMBlock(int index); 
+        char* getNVMBlock(int64_t index); 
+
+        void formatFile();
 
         /**
          *  Adds the index to the free block list. 
          */
-        void freeNVMBlock(int index);
+        void freeNVMBlock(int64_t index);
 
         /**
          *   Returns the index of a free slot in the NVM block array. 
          */
-        int getFreeNVMBlockIndex(); 
+        int64_t getFreeNVMBlockIndex(); 
 };
 
 }
@@ -0,0 +1,244 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cassert>
+#include <new>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef LINUX
+#include <sys/syscall.h>
+#endif
+
+#include "common/BlockAllocator.h"
+#include "common/debuglog.h"
+
+// from linux/mempolicy.h, so that libnuma is not needed
+#define BLOCK_ALLOCATOR_MPOL_PREFERRED 1
+
+namespace voltdb {
+
+namespace {
+
+enum {
+    MAPPING_HUGETLB = 1,
+    MAPPING_TRANSPARENT = 2,
+    MAPPING_NUMA_LOCAL = 4
+};
+
+volatile bool s_hugePages = false;
+volatile bool s_numaLocal = false;
+
+// shared by the allocators of all sites
+int64_t s_mappedBytes = 0;
+int64_t s_hugePageBytes = 0;
+int64_t s_transparentHugePageBytes = 0;
+int64_t s_numaLocalBytes = 0;
+int64_t s_hugePageFallbacks = 0;
+
+size_t roundUp(size_t size, size_t multiple) {
+    return ((size + multiple - 1) / multiple) * multiple;
+}
+
+/** Map length bytes aligned to HUGE_PAGE_SIZE, trimming the slack */
+char* mapAligned(size_t length) {
+    size_t slack = BlockAllocator::HUGE_PAGE_SIZE;
+    void *region = mmap(NULL, length + slack, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        return NULL;
+    }
+    char *start = static_cast<char*>(region);
+    char *aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<size_t>(start), slack));
+    if (aligned > start) {
+        munmap(start, aligned - start);
+    }
+    char *end = start + length + slack;
+    if (end > aligned + length) {
+        munmap(aligned + length, end - (aligned + length));
+    }
+    return aligned;
+}
+
+int64_t readStat(int64_t &stat) {
+    return __sync_fetch_and_add(&stat, 0);
+}
+
+}
+
+BlockAllocator::BlockAllocator() {
+}
+
+BlockAllocator::~BlockAllocator() {
+    for (std::map<char*, Mapping>::iterator i = m_mappings.begin(); i != m_mappings.end(); i++) {
+        account(i->second, -1);
+        munmap(i->first, i->second.length);
+    }
+}
+
+void BlockAllocator::configure(bool hugePages, bool numaLocal) {
+    s_hugePages = hugePages;
+    s_numaLocal = numaLocal;
+    VOLT_INFO("Block allocator: huge pages %s, NUMA local %s",
+              hugePages ? "on" : "off", numaLocal ? "on" : "off");
+}
+
+void BlockAllocator::account(const Mapping &mapping, int sign) {
+    int64_t length = sign * static_cast<int64_t>(mapping.length);
+    __sync_fetch_and_add(&s_mappedBytes, length);
+    if (mapping.flags & MAPPING_HUGETLB) __sync_fetch_and_add(&s_hugePageBytes, length);
+    if (mapping.flags & MAPPING_TRANSPARENT) __sync_fetch_and_add(&s_transparentHugePageBytes, length);
+    if (mapping.flags & MAPPING_NUMA_LOCAL) __sync_fetch_and_add(&s_numaLocalBytes, length);
+}
+
+bool BlockAllocator::onHugePages(const Mapping &mapping) {
+    return (mapping.flags & (MAPPING_HUGETLB | MAPPING_TRANSPARENT)) != 0;
+}
+
+char* BlockAllocator::allocate(size_t size, bool *onHugePagesOut) {
+    if (onHugePagesOut != NULL) {
+        *onHugePagesOut = false;
+    }
+#ifndef MEMCHECK
+    bool hugePages = s_hugePages && size >= HUGE_PAGE_SIZE;
+    bool numaLocal = s_numaLocal;
+    if (size < MAPPED_ALLOCATION_SIZE || !(hugePages || numaLocal)) {
+        return new char[size];
+    }
+
+    Mapping mapping;
+    mapping.flags = 0;
+    char *memory = NULL;
+    if (hugePages) {
+        mapping.length = roundUp(size, HUGE_PAGE_SIZE);
+#ifdef MAP_HUGETLB
+        void *region = mmap(NULL, mapping.length, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (region != MAP_FAILED) {
+            memory = static_cast<char*>(region);
+            mapping.flags |= MAPPING_HUGETLB;
+        }
+#endif
+        if (memory == NULL) {
+            memory = mapAligned(mapping.length);
+#ifdef MADV_HUGEPAGE
+            if (memory != NULL && madvise(memory, mapping.length, MADV_HUGEPAGE) == 0) {
+                mapping.flags |= MAPPING_TRANSPARENT;
+            }
+#endif
+            __sync_fetch_and_add(&s_hugePageFallbacks, 1);
+        }
+    } else {
+        mapping.length = roundUp(size, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+        void *region = mmap(NULL, mapping.length, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        memory = (region != MAP_FAILED) ? static_cast<char*>(region) : NULL;
+    }
+    if (memory == NULL) {
+        VOLT_ERROR("Block allocator: could not map %ld bytes", (long) mapping.length);
+        throw std::bad_alloc();
+    }
+
+#if defined(LINUX) && defined(SYS_mbind)
+    if (numaLocal) {
+        // preferred rather than bound, a full node spills instead of failing
+        int32_t node = currentNode();
+        unsigned long nodeMask = 0;
+        unsigned long maxNode = sizeof(nodeMask) * 8 + 1;
+        if (node >= 0 && node < static_cast<int32_t>(sizeof(nodeMask) * 8)) {
+            nodeMask = 1UL << node;
+            if (syscall(SYS_mbind, memory, mapping.length, BLOCK_ALLOCATOR_MPOL_PREFERRED,
+                        &nodeMask, maxNode, 0) == 0) {
+                mapping.flags |= MAPPING_NUMA_LOCAL;
+            }
+        }
+    }
+#endif
+
+    m_mappings[memory] = mapping;
+    account(mapping, 1);
+
+    if (onHugePagesOut != NULL) {
+        *onHugePagesOut = onHugePages(mapping);
+    }
+    return memory;
+#else
+    return new char[size];
+#endif
+}
+
+bool BlockAllocator::deallocate(char *memory, size_t size) {
+#ifndef MEMCHECK
+    std::map<char*, Mapping>::iterator mapping = m_mappings.end();
+    if (size >= MAPPED_ALLOCATION_SIZE) {
+        mapping = m_mappings.find(memory);
+    }
+    if (mapping == m_mappings.end()) {
+        // allocated while the options were off
+        delete[] memory;
+        return false;
+    }
+    Mapping released = mapping->second;
+    m_mappings.erase(mapping);
+    account(released, -1);
+    munmap(memory, released.length);
+    return onHugePages(released);
+#else
+    delete[] memory;
+    return false;
+#endif
+}
+
+int32_t BlockAllocator::currentNode() {
+#if defined(LINUX) && defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) {
+        return static_cast<int32_t>(node);
+    }
+#endif
+    return -1;
+}
+
+int64_t BlockAllocator::mappedBytes() {
+    return readStat(s_mappedBytes);
+}
+
+int64_t BlockAllocator::hugePageBytes() {
+    return readStat(s_hugePageBytes);
+}
+
+int64_t BlockAllocator::transparentHugePageBytes() {
+    return readStat(s_transparentHugePageBytes);
+}
+
+int64_t BlockAllocator::numaLocalBytes() {
+    return readStat(s_numaLocalBytes);
+}
+
+int64_t BlockAllocator::hugePageFallbacks() {
+    return readStat(s_hugePageFallbacks);
+}
+
+}
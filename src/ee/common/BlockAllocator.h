@@ -0,0 +1,116 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BLOCKALLOCATOR_H_
+#define BLOCKALLOCATOR_H_
+
+#include <cstddef>
+#include <map>
+#include <stdint.h>
+
+namespace voltdb {
+
+/**
+ * Allocator for the large, long lived memory of the EE: table blocks, Pool
+ * chunks and the arrays behind the indexes. Everything comes from the heap
+ * unless configure() turned on huge pages or NUMA locality. Then requests
+ * of MAPPED_ALLOCATION_SIZE and more are mapped directly, so that they can
+ * be backed by 2MB huge pages and placed on the NUMA node of the thread
+ * that allocates them.
+ *
+ * Huge pages are tried with MAP_HUGETLB first. When no huge pages are
+ * reserved the mapping is aligned to 2MB and advised with MADV_HUGEPAGE so
+ * transparent huge pages can back it. The MEMCHECK builds always use the
+ * heap.
+ *
+ * Every owner of such memory (a table, a Pool, an index) has its own
+ * BlockAllocator, which remembers how each of its mappings was made. Like
+ * its owner it is only used by one thread at a time, so it takes no locks.
+ */
+class BlockAllocator {
+public:
+    static const size_t MAPPED_ALLOCATION_SIZE = 65536;
+    static const size_t HUGE_PAGE_SIZE = 2097152;
+
+    BlockAllocator();
+    /** Unmaps whatever the owner did not give back */
+    ~BlockAllocator();
+
+    /**
+     * Process wide options, meant to be set before the sites start.
+     * hugePages backs mapped allocations of at least HUGE_PAGE_SIZE with
+     * huge pages, numaLocal prefers the NUMA node of the CPU the allocating
+     * thread runs on. Memory that is already allocated keeps its placement.
+     */
+    static void configure(bool hugePages, bool numaLocal);
+
+    /**
+     * Allocate size bytes. If onHugePages is not NULL it is set to whether
+     * the memory is backed by (or advised for) huge pages.
+     */
+    char* allocate(size_t size, bool *onHugePages = NULL);
+
+    /**
+     * Release memory from allocate(), size must be the size it was
+     * allocated with. Returns whether the memory was on huge pages.
+     */
+    bool deallocate(char *memory, size_t size);
+
+    /** NUMA node of the CPU this thread is running on, -1 if unknown */
+    static int32_t currentNode();
+
+    // ------------------------------------------------------------------
+    // STATS (process wide)
+    // ------------------------------------------------------------------
+    /** Bytes currently mapped by the allocators */
+    static int64_t mappedBytes();
+    /** Bytes currently on MAP_HUGETLB pages */
+    static int64_t hugePageBytes();
+    /** Bytes currently advised for transparent huge pages */
+    static int64_t transparentHugePageBytes();
+    /** Bytes currently bound to the NUMA node of their allocating thread */
+    static int64_t numaLocalBytes();
+    /** Huge page allocations that fell back to transparent huge pages */
+    static int64_t hugePageFallbacks();
+
+private:
+    struct Mapping {
+        size_t length;
+        int flags;
+    };
+
+    // only the mapped allocations, everything else is on the heap
+    std::map<char*, Mapping> m_mappings;
+
+    static void account(const Mapping &mapping, int sign);
+    static bool onHugePages(const Mapping &mapping);
+
+    BlockAllocator(const BlockAllocator&);
+    BlockAllocator& operator=(const BlockAllocator&);
+};
+
+}
+
+#endif /* BLOCKALLOCATOR_H_ */
@@ -0,0 +1,116 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <stdint.h>
+#include <sys/time.h>
+
+namespace voltdb {
+
+/**
+ * Histogram of latencies in microseconds with power of two buckets.
+ * Bucket 0 counts zero latencies and bucket b > 0 those in
+ * [2^(b-1), 2^b). Not thread safe.
+ */
+class LatencyHistogram {
+public:
+    static const int BUCKETS = 40;
+
+    LatencyHistogram() {
+        reset();
+    }
+
+    void reset() {
+        ::memset(m_buckets, 0, sizeof(m_buckets));
+        m_count = 0;
+        m_totalMicros = 0;
+        m_maxMicros = 0;
+    }
+
+    void record(int64_t micros) {
+        if (micros < 0) micros = 0;
+        int bucket = 0;
+        while (bucket < BUCKETS - 1 && (micros >> bucket) != 0) {
+            bucket++;
+        }
+        m_buckets[bucket]++;
+        m_count++;
+        m_totalMicros += micros;
+        if (micros > m_maxMicros) m_maxMicros = micros;
+    }
+
+    int64_t count() const { return m_count; }
+    int64_t totalMicros() const { return m_totalMicros; }
+    int64_t maxMicros() const { return m_maxMicros; }
+    int64_t bucketCount(int bucket) const { return m_buckets[bucket]; }
+
+    /**
+     * Upper bound in microseconds of the bucket that holds the given
+     * fraction of the samples, 0 when there are none.
+     */
+    int64_t percentile(double fraction) const {
+        int64_t wanted = static_cast<int64_t>(fraction * static_cast<double>(m_count) + 0.5);
+        if (wanted < 1) wanted = 1;
+        int64_t seen = 0;
+        for (int bucket = 0; bucket < BUCKETS; bucket++) {
+            seen += m_buckets[bucket];
+            if (seen >= wanted) {
+                return bucket == 0 ? 0 : (static_cast<int64_t>(1) << bucket) - 1;
+            }
+        }
+        return 0;
+    }
+
+    std::string debug(const std::string &name) const {
+        std::ostringstream buffer;
+        buffer << name << ": count=" << m_count
+               << " avg=" << (m_count > 0 ? m_totalMicros / m_count : 0) << "us"
+               << " p50<=" << percentile(0.5) << "us"
+               << " p99<=" << percentile(0.99) << "us"
+               << " max=" << m_maxMicros << "us";
+        return buffer.str();
+    }
+
+    static int64_t nowMicros() {
+        timeval tv;
+        gettimeofday(&tv, NULL);
+        return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+    }
+
+private:
+    int64_t m_buckets[BUCKETS];
+    int64_t m_count;
+    int64_t m_totalMicros;
+    int64_t m_maxMicros;
+};
+
+}
+
+#endif /* LATENCYHISTOGRAM_H_ */
@@ -95,6 +95,7 @@ void throwCastSQLValueOutOfRangeException<int64_t>(
 class NValue {
     friend class ValuePeeker;
     friend class ValueFactory;
+    friend class WireTupleSerializer;
 
   public:
     /* Create a default NValue */
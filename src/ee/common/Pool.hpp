@@ -28,6 +28,7 @@
 #include "common/debuglog.h"
 #include "common/FatalException.hpp"
 #include "common/MMAPMemoryManager.h"
+#include "common/BlockAllocator.h"
 
 namespace voltdb {
 #ifndef MEMCHECK
@@ -80,7 +81,7 @@ namespace voltdb {
         {
             VOLT_TRACE("MALLOC Pool Storage Request :: %d %d ",static_cast<int>(m_allocationSize), static_cast<int>(m_maxChunkCount));
 
-            char *storage = new char[m_allocationSize];
+            char *storage = m_blockAllocator.allocate(m_allocationSize);
             m_chunks.push_back(Chunk(m_allocationSize, storage));
         }
 
@@ -91,7 +92,7 @@ namespace voltdb {
                 m_enableMMAP(false),
                 m_pool_manager(NULL)
         {
-            char *storage = new char[allocationSize];
+            char *storage = m_blockAllocator.allocate(allocationSize);
             m_chunks.push_back(Chunk(allocationSize, storage));
         }
 
@@ -108,7 +109,7 @@ namespace voltdb {
             if(m_enableMMAP == false){
                 VOLT_TRACE("MALLOC Pool Storage Request :: %d %d ",static_cast<int>(m_allocationSize), static_cast<int>(m_maxChunkCount));
 
-                char *storage = new char[allocationSize];
+                char *storage = m_blockAllocator.allocate(allocationSize);
                 m_chunks.push_back(Chunk(allocationSize, storage));
             }
             else{
@@ -130,10 +131,10 @@ namespace voltdb {
             ~Pool() {
                 if(m_enableMMAP == false){
                     for (std::size_t ii = 0; ii < m_chunks.size(); ii++) {
-                        delete [] m_chunks[ii].m_chunkData;
+                        m_blockAllocator.deallocate(m_chunks[ii].m_chunkData, m_chunks[ii].m_size);
                     }
                     for (std::size_t ii = 0; ii < m_oversizeChunks.size(); ii++) {
-                        delete [] m_oversizeChunks[ii].m_chunkData;
+                        m_blockAllocator.deallocate(m_oversizeChunks[ii].m_chunkData, m_oversizeChunks[ii].m_size);
                     }
                 }
                 /**
@@ -159,7 +160,7 @@ namespace voltdb {
                          * Allocate an oversize chunk that will not be reused.
                          */
                         if(m_enableMMAP == false){
-                            char *storage = new char[size];
+                            char *storage = m_blockAllocator.allocate(size);
                             m_oversizeChunks.push_back(Chunk(size, storage));
                         }
                         else{
@@ -171,7 +172,7 @@ namespace voltdb {
                             m_oversizeChunks.push_back(Chunk(size, memory));
                         }
 
-                        Chunk *newChunk = &(*(m_oversizeChunks.end()));
+                        Chunk *newChunk = &m_oversizeChunks.back();
                         newChunk->m_offset = size;
                         return newChunk->m_chunkData;
                     }
@@ -193,7 +194,7 @@ namespace voltdb {
                         //                  "into structuring our pool sizes and allocations so the this doesn't "
                         //                  "happen frequently" << std::endl;
                         if(m_enableMMAP == false){
-                            char *storage = new char[m_allocationSize];
+                            char *storage = m_blockAllocator.allocate(m_allocationSize);
                             m_chunks.push_back(Chunk(m_allocationSize, storage));
                         }
                         else{
@@ -234,7 +235,7 @@ namespace voltdb {
                 const std::size_t numOversizeChunks = m_oversizeChunks.size();
                 for (std::size_t ii = 0; ii < numOversizeChunks; ii++) {
                     if(m_enableMMAP == false){
-                        delete [] m_oversizeChunks[ii].m_chunkData;
+                        m_blockAllocator.deallocate(m_oversizeChunks[ii].m_chunkData, m_oversizeChunks[ii].m_size);
                     }
                     /**
                      * MMAP'ed pool will be cleaned up by its own destructor
@@ -253,8 +254,8 @@ namespace voltdb {
                  */
                 if (numChunks > m_maxChunkCount) {
                     for (std::size_t ii = m_maxChunkCount; ii < numChunks; ii++) {
-                        if(m_enableMMAP){
-                            delete []m_chunks[ii].m_chunkData;
+                        if(m_enableMMAP == false){
+                            m_blockAllocator.deallocate(m_chunks[ii].m_chunkData, m_chunks[ii].m_size);
                         }
                         /**
                          * MMAP'ed pool will be cleaned up by its own destructor
@@ -282,6 +283,7 @@ namespace voltdb {
              * Oversize chunks that will be freed and not reused.
              */
             std::vector<Chunk> m_oversizeChunks;
+            BlockAllocator m_blockAllocator;
 
             /* To support STORAGE MMAP */
             bool m_enableMMAP;
@@ -226,6 +226,14 @@ namespace voltdb
             m_lastUndoToken = m_undoQuantums.back()->getUndoToken();
         }
 
+        /*
+         * True if no transaction can be undone anymore, so nothing
+         * refers to tuples by their address.
+         */
+        inline bool isEmpty() const {
+            return m_undoQuantums.empty();
+        }
+
         /*
          * Release memory held by all undo quantums up to and
          * including the quantum with the specified token. It will be
@@ -71,7 +71,8 @@ public:
     }
 
 	static inline void* peekObjectValue(const NValue value) {
-		assert(value.getValueType() == VALUE_TYPE_VARCHAR);
+		assert((value.getValueType() == VALUE_TYPE_VARCHAR) ||
+		       (value.getValueType() == VALUE_TYPE_VARBINARY));
 		return value.getObjectValue();
 	}
 
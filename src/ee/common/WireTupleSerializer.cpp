@@ -0,0 +1,62 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "common/WireTupleSerializer.h"
+#include "common/FatalException.hpp"
+#include "common/TupleSchema.h"
+
+namespace voltdb {
+
+WireTupleSerializer::WireTupleSerializer(const TupleSchema *schema) :
+    m_fixedSize(sizeof(int32_t)) {
+    for (int i = 0; i < schema->columnCount(); i++) {
+        Column column;
+        column.type = schema->columnType(i);
+        column.offset = schema->columnOffset(i);
+        column.inlined = schema->columnIsInlined(i);
+        switch (column.type) {
+          case VALUE_TYPE_TINYINT:
+          case VALUE_TYPE_SMALLINT:
+          case VALUE_TYPE_INTEGER:
+          case VALUE_TYPE_BIGINT:
+          case VALUE_TYPE_TIMESTAMP:
+          case VALUE_TYPE_DOUBLE:
+          case VALUE_TYPE_DECIMAL:
+            m_fixedSize += NValue::getTupleStorageSize(column.type);
+            break;
+          case VALUE_TYPE_VARCHAR:
+          case VALUE_TYPE_VARBINARY:
+            m_fixedSize += sizeof(int32_t);
+            m_objects.push_back(column);
+            break;
+          default:
+            throwFatalException("WireTupleSerializer found a column with ValueType '%d' that is not handled",
+                                column.type);
+        }
+        m_columns.push_back(column);
+    }
+}
+
+}
@@ -0,0 +1,143 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HSTOREWIRETUPLESERIALIZER_H
+#define HSTOREWIRETUPLESERIALIZER_H
+
+#include "common/NValue.hpp"
+#include "common/StringRef.h"
+#include "common/serializeio.h"
+#include "common/tabletuple.h"
+
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+
+namespace voltdb {
+
+class TupleSchema;
+
+/**
+ * Writes tuples of one schema in the wire format TableTuple::serializeTo()
+ * produces, straight from their storage. What each column needs is worked
+ * out once per schema, so a tuple costs one bounds check on the output
+ * and a byte swap or copy per column instead of an NValue and a checked
+ * write per column. Used by Table::serializeTo() for result tables.
+ */
+class WireTupleSerializer {
+    public:
+        WireTupleSerializer(const TupleSchema *schema);
+
+        /** Append the tuple, with its length prefix, to the output */
+        inline void serializeTo(const TableTuple &tuple, SerializeOutput &output) const;
+
+        /** Bytes the tuple takes on the wire, with its length prefix */
+        inline size_t serializedSize(const TableTuple &tuple) const;
+
+    private:
+        struct Column {
+            ValueType type;
+            uint32_t offset;
+            bool inlined;
+        };
+
+        /** Start of an object column's length preceded value, NULL for a null */
+        static inline const char* objectLocation(const char *data, const Column &column) {
+            if (column.inlined) {
+                return data + column.offset;
+            }
+            const StringRef *sref = *reinterpret_cast<StringRef* const*>(data + column.offset);
+            return (sref == NULL) ? NULL : sref->get();
+        }
+
+        template <typename T>
+        static inline char* put(char *out, T value) {
+            ::memcpy(out, &value, sizeof(value));
+            return out + sizeof(value);
+        }
+
+        std::vector<Column> m_columns;
+        std::vector<Column> m_objects;
+        // length prefix, fixed width columns and the length of each object
+        size_t m_fixedSize;
+};
+
+inline size_t WireTupleSerializer::serializedSize(const TableTuple &tuple) const {
+    const char *data = tuple.address() + TUPLE_HEADER_SIZE;
+    size_t size = m_fixedSize;
+    for (size_t i = 0; i < m_objects.size(); i++) {
+        const int32_t length = NValue::getObjectLengthFromLocation(objectLocation(data, m_objects[i]));
+        size += (length > 0) ? length : 0;
+    }
+    return size;
+}
+
+inline void WireTupleSerializer::serializeTo(const TableTuple &tuple, SerializeOutput &output) const {
+    const char *data = tuple.address() + TUPLE_HEADER_SIZE;
+    const size_t size = serializedSize(tuple);
+    char *out = output.reserveRawBytes(size);
+    out = put(out, static_cast<int32_t>(htonl(static_cast<int32_t>(size - sizeof(int32_t)))));
+
+    for (size_t i = 0; i < m_columns.size(); i++) {
+        const Column &column = m_columns[i];
+        const char *value = data + column.offset;
+        switch (column.type) {
+          case VALUE_TYPE_TINYINT:
+            *out++ = *value;
+            break;
+          case VALUE_TYPE_SMALLINT:
+            out = put(out, htons(*reinterpret_cast<const uint16_t*>(value)));
+            break;
+          case VALUE_TYPE_INTEGER:
+            out = put(out, htonl(*reinterpret_cast<const uint32_t*>(value)));
+            break;
+          case VALUE_TYPE_BIGINT:
+          case VALUE_TYPE_TIMESTAMP:
+          case VALUE_TYPE_DOUBLE:
+            out = put(out, htonll(*reinterpret_cast<const uint64_t*>(value)));
+            break;
+          case VALUE_TYPE_DECIMAL:
+            // the high word goes first, as NValue::serializeTo() writes it
+            out = put(out, htonll(*reinterpret_cast<const uint64_t*>(value + sizeof(uint64_t))));
+            out = put(out, htonll(*reinterpret_cast<const uint64_t*>(value)));
+            break;
+          default: {
+            // VARCHAR and VARBINARY
+            const char *location = objectLocation(data, column);
+            const int32_t length = NValue::getObjectLengthFromLocation(location);
+            out = put(out, static_cast<int32_t>(htonl(length)));
+            if (length > 0) {
+                ::memcpy(out, location + NValue::getAppropriateObjectLengthLength(length), length);
+                out += length;
+            }
+            break;
+          }
+        }
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,94 @@
+/* Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+ * All rights reserved. Use of this source code is governed by a
+ * BSD-style license that can be found in the LICENSE file.
+ */
+
+#include "common/crc32c.h"
+
+#include <cstring>
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+namespace voltdb {
+
+// Castagnoli polynomial, reflected
+static const uint32_t CRC32C_POLY = 0x82F63B78;
+
+static uint32_t crcTable[256];
+static bool crcTableReady = false;
+
+static void initCrcTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : (crc >> 1);
+        }
+        crcTable[i] = crc;
+    }
+    crcTableReady = true;
+}
+
+static uint32_t crc32c_CPUDetection(uint32_t crc, const void* data, size_t length) {
+    // Avoid issues that could potentially be caused by multiple threads: use a local variable
+    CRC32CFunctionPtr best = detectBestCRC32C();
+    crc32c = best;
+    return best(crc, data, length);
+}
+
+CRC32CFunctionPtr crc32c = crc32c_CPUDetection;
+
+CRC32CFunctionPtr detectBestCRC32C() {
+#if defined(__x86_64__)
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2)) {
+        return crc32cHardware64;
+    }
+#endif
+    if (!crcTableReady) {
+        initCrcTable();
+    }
+    return crc32cSarwate;
+}
+
+uint32_t crc32cSarwate(uint32_t crc, const void* data, size_t length) {
+    if (!crcTableReady) {
+        initCrcTable();
+    }
+    const unsigned char* p_buf = static_cast<const unsigned char*>(data);
+    const unsigned char* p_end = p_buf + length;
+
+    while (p_buf < p_end) {
+        crc = crcTable[(crc ^ *p_buf++) & 0x000000FF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+// Hardware-accelerated CRC-32C (using the SSE4.2 CRC32 instruction)
+__attribute__((target("sse4.2")))
+uint32_t crc32cHardware64(uint32_t crc, const void* data, size_t length) {
+    const char* p_buf = static_cast<const char*>(data);
+    uint64_t crc64bit = crc;
+    for (size_t i = 0; i < length / sizeof(uint64_t); i++) {
+        uint64_t word;
+        memcpy(&word, p_buf, sizeof(word));
+        crc64bit = __builtin_ia32_crc32di(crc64bit, word);
+        p_buf += sizeof(uint64_t);
+    }
+
+    uint32_t crc32bit = static_cast<uint32_t>(crc64bit);
+    length &= sizeof(uint64_t) - 1;
+    while (length > 0) {
+        crc32bit = __builtin_ia32_crc32qi(crc32bit, static_cast<unsigned char>(*p_buf++));
+        length--;
+    }
+    return crc32bit;
+}
+#else
+uint32_t crc32cHardware64(uint32_t crc, const void* data, size_t length) {
+    return crc32cSarwate(crc, data, length);
+}
+#endif
+
+}
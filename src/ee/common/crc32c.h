@@ -0,0 +1,49 @@
+/* Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+ * All rights reserved. Use of this source code is governed by a
+ * BSD-style license that can be found in the LICENSE file.
+ *
+ * EE copy of the dtxn CRC32-C (src/dtxn/logging/crc32c.h). The EE is built
+ * separately from dtxn, so the parts we need for log framing live here.
+ */
+
+#ifndef HSTORECRC32C_H
+#define HSTORECRC32C_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace voltdb {
+
+/** Returns the initial value for a CRC32-C computation. */
+inline uint32_t crc32cInit() {
+    return 0xFFFFFFFF;
+}
+
+/** Pointer to a function that computes a CRC32C checksum.
+@arg crc Previous CRC32C value, or crc32cInit().
+@arg data Pointer to the data to be checksummed.
+@arg length length of the data in bytes.
+*/
+typedef uint32_t (*CRC32CFunctionPtr)(uint32_t crc, const void* data, size_t length);
+
+/** This will map automatically to the "best" CRC implementation (SSE4.2 if the CPU has it). */
+extern CRC32CFunctionPtr crc32c;
+
+CRC32CFunctionPtr detectBestCRC32C();
+
+/** Converts a partial CRC32-C computation to the final value. */
+inline uint32_t crc32cFinish(uint32_t crc) {
+    return ~crc;
+}
+
+/** Computes a complete CRC32C over data, using crc32c. */
+inline uint32_t crc32cComplete(const void* data, size_t length) {
+    return crc32cFinish(crc32c(crc32cInit(), data, length));
+}
+
+uint32_t crc32cSarwate(uint32_t crc, const void* data, size_t length);
+uint32_t crc32cHardware64(uint32_t crc, const void* data, size_t length);
+
+}
+
+#endif // HSTORECRC32C_H
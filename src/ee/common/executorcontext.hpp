@@ -26,6 +26,7 @@
 #include "anticache/AntiCacheDB.h"
 #include "anticache/BerkeleyAntiCacheDB.h"
 #include "anticache/NVMAntiCacheDB.h"
+#include "anticache/FileAntiCacheDB.h"
 #include "anticache/AntiCacheEvictionManager.h"
 #include "execution/VoltDBEngine.h"
 #define MAX_LEVELS 5
@@ -243,6 +244,8 @@ namespace voltdb {
             } else if (dbType == ANTICACHEDB_NVM) {
                 m_antiCacheDB[m_levels] = new NVMAntiCacheDB(this, dbDir, blockSize, maxSize);
                 //m_antiCacheEvictionManager->addAntiCacheDB(new NVMAntiCacheDB(this, dbDir, blockSize, maxSize));
+            } else if (dbType == ANTICACHEDB_FILE) {
+                m_antiCacheDB[m_levels] = new FileAntiCacheDB(this, dbDir, blockSize, maxSize);
             } else {
                 VOLT_ERROR("Invalid AntiCacheDBType: %d! Aborting...", (int)dbType);
                 assert(m_antiCacheEnabled == false);
@@ -355,6 +355,16 @@ public:
         return offset;
     }
 
+    /** Reserves length bytes of space and returns a pointer to them, for
+    callers that lay the bytes out themselves. The pointer is only valid
+    until the next write, which may move the buffer. */
+    inline char* reserveRawBytes(size_t length) {
+        assureExpand(length);
+        char* current = buffer_ + position_;
+        position_ += length;
+        return current;
+    }
+
     /** Copies length bytes from value to this buffer, starting at
     offset. Offset should have been obtained from reserveBytes. This
     does not affect the current write position.  * @return offset +
@@ -293,6 +293,9 @@ string planNodeToString(PlanNodeType type)
     case PLAN_NODE_TYPE_NESTLOOPINDEX: {
         return "NESTLOOPINDEX";
     }
+    case PLAN_NODE_TYPE_HASHJOIN: {
+        return "HASHJOIN";
+    }
     case PLAN_NODE_TYPE_UPDATE: {
         return "UPDATE";
     }
@@ -351,6 +354,8 @@ PlanNodeType stringToPlanNode(string str )
         return PLAN_NODE_TYPE_NESTLOOP;
     } else if (str == "NESTLOOPINDEX") {
         return PLAN_NODE_TYPE_NESTLOOPINDEX;
+    } else if (str == "HASHJOIN") {
+        return PLAN_NODE_TYPE_HASHJOIN;
     } else if (str == "UPDATE") {
         return PLAN_NODE_TYPE_UPDATE;
     } else if (str == "INSERT") {
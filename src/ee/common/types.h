@@ -163,6 +163,7 @@ enum PlanNodeType {
     //
     PLAN_NODE_TYPE_NESTLOOP         = 20,
     PLAN_NODE_TYPE_NESTLOOPINDEX    = 21,
+    PLAN_NODE_TYPE_HASHJOIN         = 22,
 
     //
     // Operator Nodes
@@ -283,6 +284,8 @@ enum TableIndexType {
     BALANCED_TREE_INDEX     = 1,
     HASH_TABLE_INDEX        = 2,
     ARRAY_INDEX             = 3,
+    // 4 is BTREE on the Java side, which the EE does not implement
+    CONCURRENT_TREE_INDEX   = 5,
 };
 
 // ------------------------------------------------------------------
@@ -359,7 +362,38 @@ enum AntiCacheDBType {
     /*
      * NVM file-based store
      */
-    ANTICACHEDB_NVM = 2
+    ANTICACHEDB_NVM = 2,
+    /*
+     * Block file read asynchronously in batches
+     */
+    ANTICACHEDB_FILE = 3
+};
+
+enum AntiCacheCompressionType {
+    /*
+     * Blocks are written as they are serialized
+     */
+    ANTICACHE_COMPRESSION_NONE = 0,
+    /*
+     * LZ4 (fast)
+     */
+    ANTICACHE_COMPRESSION_LZ4 = 1,
+    /*
+     * Zstd with a dictionary trained per table
+     */
+    ANTICACHE_COMPRESSION_ZSTD = 2
+};
+
+enum AntiCacheEvictionPolicy {
+    /*
+     * Tuples are evicted in the order of the LRU chain kept in their headers
+     */
+    ANTICACHE_EVICTION_LRU = 0,
+    /*
+     * A CLOCK hand sweeps the table's storage blocks and evicts the tuples
+     * of blocks that were not referenced since it last passed them
+     */
+    ANTICACHE_EVICTION_CLOCK = 1
 };
 
 // ------------------------------------------------------------------
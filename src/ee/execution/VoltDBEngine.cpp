@@ -105,12 +105,18 @@
 
 // ARIES
 #include "logging/Logrecord.h"
+#include "logging/CompactLogrecord.h"
+#include "logging/AriesReplayer.h"
 #include "logging/AriesLogProxy.h"
 #include <string>
 
 #define BUFFER_SIZE         1024*1024*300    // 100 MB buffer for reading in log file
 
 using namespace std;
+
+// defined in voltdbjni.cpp
+extern void deserializeParameterSetCommon(int, voltdb::ReferenceSerializeInput&, voltdb::GenericValueArray<voltdb::NValue>&, voltdb::Pool *stringPool);
+
 namespace voltdb {
 
 const int64_t AD_HOC_FRAG_ID = -1;
@@ -128,7 +134,10 @@ VoltDBEngine::VoltDBEngine(Topend *topend, LogProxy *logProxy) :
         m_topend(topend),
         m_logProxy(logProxy),
         m_logManager(new LogManager(logProxy)),
-        m_ARIESEnabled(false) {
+        m_ARIESEnabled(false),
+        m_ARIESRecoveryThreads(0),
+        m_compactionTimeBudget(COMPACTION_TIME_BUDGET_MICROS),
+        m_compactionTableId(-1) {
     m_currentUndoQuantum = new DummyUndoQuantum();
 
     // init the number of planfragments executed
@@ -273,7 +282,95 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
         int32_t outputDependencyId, int32_t inputDependencyId,
         const NValueArray &params, int64_t txnId, int64_t lastCommittedTxnId,
         bool first, bool last) {
-    Table *cleanUpTable = NULL;
+    // configure the execution context.
+    m_executorContext->setupForPlanFragments(getCurrentUndoQuantum(), txnId,
+            lastCommittedTxnId);
+
+    // Read/Write Set Tracking
+    ReadWriteTracker *tracker = NULL;
+    if (m_executorContext->isTrackingEnabled()) {
+        ReadWriteTrackerManager *trackerMgr =
+                m_executorContext->getTrackerManager();
+        tracker = trackerMgr->getTracker(txnId);
+    }
+
+    return executeFragment(planfragmentId, *getExecutorVector(planfragmentId),
+            outputDependencyId, inputDependencyId, params, tracker, txnId,
+            first, last);
+}
+
+int VoltDBEngine::executeQueries(int numFragments,
+        const int64_t *planfragmentIds, const int32_t *outputDependencyIds,
+        const int32_t *inputDependencyIds, ReferenceSerializeInput &serialize_in,
+        int64_t txnId, int64_t lastCommittedTxnId) {
+    assert(numFragments <= MAX_BATCH_COUNT);
+
+    // the context and the tracker are the same for every fragment in the batch
+    m_executorContext->setupForPlanFragments(getCurrentUndoQuantum(), txnId,
+            lastCommittedTxnId);
+    ReadWriteTracker *tracker = NULL;
+    if (m_executorContext->isTrackingEnabled()) {
+        ReadWriteTrackerManager *trackerMgr =
+                m_executorContext->getTrackerManager();
+        tracker = trackerMgr->getTracker(txnId);
+    }
+
+    // The decoded values stay valid until the string pool is purged after
+    // the batch, so a parameter set that repeats the previous one can reuse
+    // them as they are.
+    const char *lastParams = NULL;
+    size_t lastParamsLength = 0;
+
+    ExecutorVector *execsForFrag = NULL;
+    int failures = 0;
+    for (int i = 0; i < numFragments; ++i) {
+        if (i == 0 || planfragmentIds[i] != planfragmentIds[i - 1]) {
+            execsForFrag = getExecutorVector(planfragmentIds[i]);
+        }
+
+        const char *paramsStart =
+                static_cast<const char*>(serialize_in.getRawPointer(0));
+        if (lastParams != NULL
+                && serialize_in.numBytesNotYetRead() >= lastParamsLength
+                && ::memcmp(paramsStart, lastParams, lastParamsLength) == 0) {
+            serialize_in.getRawPointer(lastParamsLength);
+        } else {
+            int cnt = serialize_in.readShort();
+            if (cnt < 0) {
+                throwFatalException("parameter count is negative: %d", cnt);
+            }
+            assert (cnt < MAX_PARAM_COUNT);
+            deserializeParameterSetCommon(cnt, serialize_in, m_staticParams, &m_stringPool);
+            m_usedParamcnt = cnt;
+            lastParams = paramsStart;
+            lastParamsLength = static_cast<const char*>(
+                    serialize_in.getRawPointer(0)) - paramsStart;
+        }
+
+        // success is 0 and error is 1.
+        if (executeFragment(planfragmentIds[i], *execsForFrag,
+                outputDependencyIds[i], inputDependencyIds[i], m_staticParams,
+                tracker, txnId, i == 0, i == (numFragments - 1))) {
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+VoltDBEngine::ExecutorVector* VoltDBEngine::getExecutorVector(
+        int64_t planfragmentId) const {
+    // execution lists for planfragments are cached by planfragment id
+    assert(planfragmentId >= -1);
+    std::map<int64_t, boost::shared_ptr<ExecutorVector> >::const_iterator iter =
+            m_executorMap.find(planfragmentId);
+    assert(iter != m_executorMap.end());
+    return iter->second.get();
+}
+
+int VoltDBEngine::executeFragment(int64_t planfragmentId,
+        ExecutorVector &execsForFrag, int32_t outputDependencyId,
+        int32_t inputDependencyId, const NValueArray &params,
+        ReadWriteTracker *tracker, int64_t txnId, bool first, bool last) {
     m_currentOutputDepId = outputDependencyId;
     m_currentInputDepId = inputDependencyId;
 
@@ -301,38 +398,9 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
     m_numResultDependencies = 0;
     size_t numResultDependenciesCountOffset = m_resultOutput.reserveBytes(4);
 
-    // configure the execution context.
-    m_executorContext->setupForPlanFragments(getCurrentUndoQuantum(), txnId,
-            lastCommittedTxnId);
-
     // count the number of plan fragments executed
     ++m_pfCount;
 
-    // execution lists for planfragments are cached by planfragment id
-    assert(planfragmentId >= -1);
-//     fprintf(stderr, "Looking to execute fragid %jd\n", (intmax_t)planfragmentId);
-//     
-//     std::map<int64_t, boost::shared_ptr<ExecutorVector> >::const_iterator pavlo_it;
-//     fprintf(stderr, "-----------------------------\n");
-//     for (pavlo_it = m_executorMap.begin();
-//          pavlo_it != m_executorMap.end(); pavlo_it++) {
-//         fprintf(stderr, "PlanFragment: %jd\n", (intmax_t)pavlo_it->first);
-//     } // FOR
-//     fprintf(stderr, "-----------------------------\n");
-
-    std::map<int64_t, boost::shared_ptr<ExecutorVector> >::const_iterator iter =
-            m_executorMap.find(planfragmentId);
-    assert(iter != m_executorMap.end());
-    boost::shared_ptr<ExecutorVector> execsForFrag = iter->second;
-
-    // Read/Write Set Tracking
-    ReadWriteTracker *tracker = NULL;
-    if (m_executorContext->isTrackingEnabled()) {
-        ReadWriteTrackerManager *trackerMgr =
-                m_executorContext->getTrackerManager();
-        tracker = trackerMgr->getTracker(txnId);
-    }
-    
     // PAVLO: If we see a SendPlanNode with the "fake" flag set to true,
     // then we won't really execute it and instead will send back the
     // number of tuples that we modified
@@ -342,15 +410,11 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
     // planner guarantees that for a given plannode, all of its
     // children are positioned before it in this list, therefore
     // dependency tracking is not needed here.
-    size_t ttl = execsForFrag->list.size();
+    size_t ttl = execsForFrag.list.size();
     for (int ctr = 0; ctr < ttl; ++ctr) {
-        AbstractExecutor *executor = execsForFrag->list[ctr];
+        AbstractExecutor *executor = execsForFrag.list[ctr];
         assert(executor);
 
-        if (executor->needsPostExecuteClear())
-            cleanUpTable =
-                    dynamic_cast<Table*>(executor->getPlanNode()->getOutputTable());
-
         // PAVLO: Check whether we don't need to execute anything and should just
         // send back the number of tuples modified
         if (executor->forceTupleCount()) {
@@ -373,8 +437,8 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
                     VOLT_DEBUG(
                             "The Executor's execution at position '%d' failed for PlanFragment '%jd'",
                             ctr, (intmax_t)planfragmentId);
-                    if (cleanUpTable != NULL)
-                        cleanUpTable->deleteAllTuples(false);
+                    if (execsForFrag.cleanUpTables[ctr] != NULL)
+                        execsForFrag.cleanUpTables[ctr]->deleteAllTuples(false);
                     // set these back to -1 for error handling
                     m_currentOutputDepId = -1;
                     m_currentInputDepId = -1;
@@ -385,8 +449,8 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
                         "The Executor's execution at position '%d' failed for PlanFragment '%jd'",
                         ctr, (intmax_t)planfragmentId);
                 VOLT_INFO("SerializableEEException: %s", e.message().c_str());
-                if (cleanUpTable != NULL)
-                    cleanUpTable->deleteAllTuples(false);
+                if (execsForFrag.cleanUpTables[ctr] != NULL)
+                    execsForFrag.cleanUpTables[ctr]->deleteAllTuples(false);
                 resetReusedResultOutputBuffer();
                 e.serialize(getExceptionOutputSerializer());
 
@@ -397,8 +461,8 @@ int VoltDBEngine::executeQuery(int64_t planfragmentId,
             }
         }
     }
-    if (cleanUpTable != NULL)
-        cleanUpTable->deleteAllTuples(false);
+    if (ttl > 0 && execsForFrag.cleanUpTables.back() != NULL)
+        execsForFrag.cleanUpTables.back()->deleteAllTuples(false);
 
     // assume this is sendless dml
     if (send_tuple_count || m_numResultDependencies == 0) {
@@ -716,43 +780,15 @@ bool VoltDBEngine::loadTable(Table *table,
 #ifdef ARIES
     // Don't do this if we are recovering
     if (isARIESEnabled() && isExecutionNormal) {
-        LogRecord *logrecord = new LogRecord(computeTimeStamp(),
-                LogRecord::T_BULKLOAD,    // we are bulk loading bytes directly
-                LogRecord::T_FORWARD,// the system is running normally
-                -1,// XXX: prevLSN
-                txnId,// xid
-                getSiteId(),// which execution site
-                table->name(),// the table affected
-                NULL,// bulk-load, no primary key
-                -1,// inserting, all columns affected
-                NULL,// insert, don't care about modified cols
-                NULL,// no before image
-                NULL// no TableTuple for after image, will store bytes directly
-        );
-
-        size_t logrecordEstLength = logrecord->getEstimatedLength();
-
-        // We could also include the length of the
-        // entire buffer of raw tuples while allocating
-        // the log record buffer but that might just be too slow
-        // and the allocated array just way too big.
-        char *logrecordBuffer = new char[logrecordEstLength];
-
-        FallbackSerializeOutput output;
-        output.initializeWithPosition(logrecordBuffer, logrecordEstLength, 0);
-
-        logrecord->serializeTo(output);
-
-        LogManager* m_logManager = getLogManager();
-        Logger m_ariesLogger = m_logManager->getAriesLogger();
-
-        const Logger *logger = m_logManager->getThreadLogger(LOGGERID_MM_ARIES);
+        catalog::Table *catalogTable = m_database->tables().get(table->name());
+        assert(catalogTable != NULL);
 
-        assert(logger != NULL);
+        // bulk-load, the tuples follow the record as raw bytes
+        logAriesRecord(LogRecord::T_BULKLOAD, txnId, catalogTable->relativeIndex(),
+                       NULL, NULL, NULL, NULL);
 
-        // we could ALSO directly write via writeToAriesLogBuffer(buffer, size)
-        // but not doing that for consistency while logging to Aries.
-        logger->log(LOGLEVEL_INFO, output.data(), output.position());
+        const Logger *logger = getLogManager()->getThreadLogger(LOGGERID_MM_ARIES);
+        assert(logger != NULL);
 
         // CAREFUL -- the number of bytes might just be too many
         // Its possible they could cause a buffer overflow
@@ -769,12 +805,6 @@ bool VoltDBEngine::loadTable(Table *table,
 
         // next log the raw bytes of the bulkload array
         logger->log(LOGLEVEL_INFO, reinterpret_cast<const char *>(serializeIn.getRawPointer(0)), numBytes);
-
-        delete[] logrecordBuffer;
-        logrecordBuffer = NULL;
-
-        delete logrecord;
-        logrecord = NULL;
     }
 #endif
 
@@ -959,9 +989,16 @@ bool VoltDBEngine::initPlanFragment(const int64_t fragId,
     }
 
     // Initialize the vector of executors for this planfragment, used at runtime.
+    Table *cleanUpTable = NULL;
     for (int ctr = 0, cnt = (int) pnf->getExecuteList().size(); ctr < cnt;
             ctr++) {
-        ev->list.push_back(pnf->getExecuteList()[ctr]->getExecutor());
+        AbstractExecutor *executor = pnf->getExecuteList()[ctr]->getExecutor();
+        ev->list.push_back(executor);
+        if (executor->needsPostExecuteClear()) {
+            cleanUpTable = dynamic_cast<Table*>(
+                    executor->getPlanNode()->getOutputTable());
+        }
+        ev->cleanUpTables.push_back(cleanUpTable);
     }
     m_executorMap[fragId] = ev;
 
@@ -1144,6 +1181,19 @@ bool VoltDBEngine::isLocalSite(const NValue& value) {
     return index == m_partitionId;
 }
 
+bool VoltDBEngine::setColumnarLayout(int32_t tableId, bool columnar) {
+    PersistentTable *table = dynamic_cast<PersistentTable*>(this->getTable(tableId));
+    if (table == NULL) {
+        throwFatalException("Invalid table id %d", tableId);
+    }
+    if (table->setColumnarLayout(columnar) == false) {
+        VOLT_ERROR("Unable to turn the columnar layout %s for table '%s'",
+                   (columnar ? "on" : "off"), table->name().c_str());
+        return false;
+    }
+    return true;
+}
+
 /** Perform once per second, non-transactional work. */
 void VoltDBEngine::tick(int64_t timeInMillis, int64_t lastCommittedTxnId) {
     m_executorContext->setupForTick(lastCommittedTxnId, timeInMillis);
@@ -1151,6 +1201,27 @@ void VoltDBEngine::tick(int64_t timeInMillis, int64_t lastCommittedTxnId) {
     BOOST_FOREACH (TablePair table, m_exportingTables){
     table.second->flushOldTuples(timeInMillis);
 }
+
+#ifdef ARIES
+    // surface a failed group commit write even while no txn is committing
+    if (isARIESEnabled() && m_logManager->getAriesLogProxy() != NULL) {
+        m_logManager->getAriesLogProxy()->checkError();
+    }
+#endif
+
+#ifdef ANTICACHE
+    if (m_executorContext->isAntiCacheEnabled()) {
+        try {
+            m_executorContext->getAntiCacheEvictionManager()->tick();
+        } catch (SerializableEEException &e) {
+            // the blocks stay where they are until the next tick
+            VOLT_ERROR("Failed to migrate anti-cache blocks at Partition %d: %s",
+                       m_partitionId, e.message().c_str());
+        }
+    }
+#endif
+
+    compactTables();
 }
 
 /** For now, bring the Export system to a steady state with no buffers with content */
@@ -1162,6 +1233,44 @@ void VoltDBEngine::quiesce(int64_t lastCommittedTxnId) {
 }
 }
 
+/*
+ * Give memory back from tables that shrank. Each table is compacted a
+ * few hundred tuples at a time until the tick's time budget is spent, and
+ * the next tick picks up with the table after the last one worked on.
+ * Moving tuples would leave the UndoActions of an unfinished transaction
+ * pointing at the wrong place, so nothing happens while any are around.
+ */
+void VoltDBEngine::compactTables() {
+    if (m_compactionTimeBudget <= 0 || !m_undoLog.isEmpty() || m_tables.empty()) {
+        return;
+    }
+
+    struct timeval start, now;
+    gettimeofday(&start, NULL);
+    int64_t elapsed = 0;
+
+    std::map<int32_t, Table*>::iterator iter = m_tables.upper_bound(m_compactionTableId);
+    for (size_t i = 0; i < m_tables.size() && elapsed < m_compactionTimeBudget; i++, iter++) {
+        if (iter == m_tables.end()) {
+            iter = m_tables.begin();
+        }
+        PersistentTable *table = dynamic_cast<PersistentTable*>(iter->second);
+        if (table == NULL) {
+            continue;
+        }
+
+        bool moreWork = true;
+        while (moreWork && elapsed < m_compactionTimeBudget) {
+            moreWork = table->compactTuples(256);
+            gettimeofday(&now, NULL);
+            elapsed = (now.tv_sec - start.tv_sec) * 1000000 + (now.tv_usec - start.tv_usec);
+        }
+        if (!moreWork) {
+            m_compactionTableId = iter->first;
+        }
+    }
+}
+
 string VoltDBEngine::debug(void) const {
     stringstream output(stringstream::in | stringstream::out);
     map<int64_t, boost::shared_ptr<ExecutorVector> >::const_iterator iter;
@@ -1449,10 +1558,31 @@ void VoltDBEngine::ARIESInitialize(std::string dbDir, std::string logFile) {
     m_logManager = new LogManager(m_logProxy, this);
     m_executorContext->enableARIES(dbDir);
 }
+
+bool VoltDBEngine::ARIESSetGroupCommit(int64_t groupCommitMicros, bool syncOnCommit, bool useDSync) {
+    AriesLogProxy *proxy = (isARIESEnabled() ? m_logManager->getAriesLogProxy() : NULL);
+    if (proxy == NULL) {
+        VOLT_ERROR("Unable to set the ARIES group commit policy at Partition %d: no local log",
+                   m_partitionId);
+        return false;
+    }
+    VOLT_INFO("ARIES group commit at Partition %d: %ld us, sync on commit %d, O_DSYNC %d",
+              m_partitionId, (long)groupCommitMicros, syncOnCommit, useDSync);
+    proxy->setGroupCommitPolicy(AriesLogProxy::DEFAULT_GROUP_COMMIT_BYTES,
+                                AriesLogProxy::DEFAULT_GROUP_COMMIT_RECORDS,
+                                groupCommitMicros, syncOnCommit);
+    proxy->setUseDSync(useDSync);
+    return true;
+}
 #else
 void VoltDBEngine::ARIESInitialize(std::string dbDir, std::string logFile) {
     VOLT_ERROR("ARIES feature was not enabled when compiling the EE");
 }
+
+bool VoltDBEngine::ARIESSetGroupCommit(int64_t groupCommitMicros, bool syncOnCommit, bool useDSync) {
+    VOLT_ERROR("ARIES feature was not enabled when compiling the EE");
+    return false;
+}
 #endif
 
 #ifdef ARIES
@@ -1551,13 +1681,17 @@ void VoltDBEngine::doAriesRecovery(char *logData, size_t length, int64_t replay_
     const Logger *logger = m_logManager->getThreadLogger(LOGGERID_MM_ARIES);
     logger->log(LOGLEVEL_INFO, "Running ARIES recovery, repeating history ...");
 
-    int64_t actualBufLen = length;
+    int32_t counter = 0;
+
+    // CompactLogRecords are split by table and replayed in parallel. A log
+    // that still has LogRecords in it goes through the serial loop below up
+    // to the last of them, and only the rest is left to the replayer.
+    AriesReplayer replayer(m_siteId, replay_txnid);
+    int64_t actualBufLen = replayer.partition(logData, length, m_tables);
     ReferenceSerializeInput input(logData, actualBufLen);
 
     char *endOfBuffer = logData + actualBufLen;
 
-    int32_t counter = 0;
-
     VOLT_DEBUG("actualBufLen : %ld", actualBufLen);
 
     while (input.getRawPointer(0) < endOfBuffer) {
@@ -1573,6 +1707,13 @@ void VoltDBEngine::doAriesRecovery(char *logData, size_t length, int64_t replay_
             // seek in reverse direction
             break;//XXX:hack when we have a single buffer for the entire file
             // logfilestream.seekg((logInitPosition - endOfBuffer), ios::cur);
+        } else if (CompactLogRecord::isCompactRecord(logInitPosition, endOfBuffer - logInitPosition)) {
+            // MAGIC reads as a negative size, so look for it before the size check
+            if (!replayCompactLogRecord(input, endOfBuffer, replay_txnid, counter)) {
+                // torn or corrupted record, this is the end of the log
+                break;
+            }
+            continue;
         } else {
             // read log record header to determine its size.
             memcpy(&recordSize, logInitPosition, sizeof(recordSize));
@@ -1758,6 +1899,15 @@ void VoltDBEngine::doAriesRecovery(char *logData, size_t length, int64_t replay_
         }
     }
 
+    // the tail only follows on if the serial part made it to its end
+    if (replayer.streamCount() > 0 && input.getRawPointer(0) == endOfBuffer) {
+        int numThreads = m_ARIESRecoveryThreads;
+        if (numThreads <= 0) {
+            numThreads = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+        }
+        counter += replayer.replay(numThreads);
+    }
+
 
     gettimeofday(&tv2, NULL);
 
@@ -1773,6 +1923,89 @@ void VoltDBEngine::doAriesRecovery(char *logData, size_t length, int64_t replay_
     logger->log(LOGLEVEL_INFO, &outputString);
 }
 
+/*
+ * Replay one CompactLogRecord. Returns false if the record could not be
+ * read, which ends recovery.
+ */
+bool VoltDBEngine::replayCompactLogRecord(ReferenceSerializeInput &input, const char *endOfBuffer,
+                                          int64_t replay_txnid, int32_t &counter) {
+    const char *frame = reinterpret_cast<const char*>(input.getRawPointer(0));
+    int32_t payloadLength;
+    memcpy(&payloadLength, frame + sizeof(int32_t), sizeof(payloadLength));
+    payloadLength = ntohl(payloadLength);
+    if (payloadLength <= 0 ||
+        payloadLength > endOfBuffer - frame - static_cast<int64_t>(CompactLogRecord::FRAME_HEADER_SIZE)) {
+        VOLT_WARN("ARIES : truncated log record at the end of the log");
+        return false;
+    }
+
+    CompactLogRecord logrecord(input);
+    if (!logrecord.isValidRecord()) {
+        return false;
+    }
+
+    int64_t numBulkLoadBytes = 0;
+    if (logrecord.hasTrailingLoadData()) {
+        if (endOfBuffer - reinterpret_cast<const char*>(input.getRawPointer(0)) < static_cast<int64_t>(sizeof(int64_t))) {
+            return false;
+        }
+        numBulkLoadBytes = input.readLong();
+        if (numBulkLoadBytes < 0 ||
+            numBulkLoadBytes > endOfBuffer - reinterpret_cast<const char*>(input.getRawPointer(0))) {
+            return false;
+        }
+    }
+
+    if ((logrecord.getTransactionId() < replay_txnid) || (logrecord.getExecutionSiteId() != m_siteId)) {
+        input.getRawPointer(numBulkLoadBytes);
+        return true;
+    }
+
+    PersistentTable* table = dynamic_cast<PersistentTable*>(getTable(logrecord.getTableId()));
+    if (table == NULL) {
+        VOLT_ERROR("ARIES : log record for unknown table id %d", logrecord.getTableId());
+        return false;
+    }
+
+    counter++;
+
+    if (logrecord.hasTrailingLoadData()) {
+        // applyRecord() reads the bulk load bytes itself
+        input.unread(sizeof(int64_t));
+    }
+    AriesReplayer::applyRecord(table, logrecord, input, &m_stringPool, false);
+    return true;
+}
+
+void VoltDBEngine::logAriesRecord(LogRecord::Logrec_type_t type, int64_t xid, int32_t tableId,
+                                  TableIndex *pkeyIndex, const std::vector<int32_t> *modifiedCols,
+                                  TableTuple *beforeImage, TableTuple *afterImage) {
+    AriesLogProxy *proxy = m_logManager->getAriesLogProxy();
+    int64_t lsn = (proxy != NULL) ? proxy->getAppendedLsn() : -1;
+
+    CompactLogRecord logrecord(type,
+            LogRecord::T_FORWARD,// the system is running normally
+            lsn,
+            -1,// XXX: prevLSN must be fetched from table!
+            xid,
+            getSiteId(),
+            tableId,
+            pkeyIndex,
+            modifiedCols,
+            beforeImage,
+            afterImage);
+
+    // most records fit on the stack, big ones fall back to the heap
+    char logrecordBuffer[ARIES_RECORD_STACK_BUFFER_SIZE];
+    FallbackSerializeOutput output;
+    output.initializeWithPosition(logrecordBuffer, sizeof(logrecordBuffer), 0);
+
+    logrecord.serializeTo(output);
+
+    const Logger *logger = m_logManager->getThreadLogger(LOGGERID_MM_ARIES);
+    logger->log(LOGLEVEL_INFO, output.data(), output.position());
+}
+
 void VoltDBEngine::writeToAriesLogBuffer(const char *data, size_t size) {
     memcpy(m_arieslogBuffer + m_ariesWriteOffset, data, size);
     m_ariesWriteOffset += size;
@@ -1984,7 +2217,7 @@ void VoltDBEngine::antiCacheAddDB(std::string dbDir, AntiCacheDBType dbType, lon
     m_executorContext->addAntiCacheDB(dbDir, blockSize, dbType, maxSize);
 }
 
-int VoltDBEngine::antiCacheReadBlocks(int32_t tableId, int numBlocks, int32_t blockIds[], int32_t tupleOffsets[]) {
+int VoltDBEngine::antiCacheReadBlocks(int32_t tableId, int numBlocks, int64_t blockIds[], int32_t tupleOffsets[]) {
     int retval = ENGINE_ERRORCODE_SUCCESS;
 
     // Grab the PersistentTable referenced by the given tableId
@@ -2008,9 +2241,8 @@ int VoltDBEngine::antiCacheReadBlocks(int32_t tableId, int numBlocks, int32_t bl
     bool finalResult = true;
     AntiCacheEvictionManager* eviction_manager = m_executorContext->getAntiCacheEvictionManager();
     try {
-        for (int i = 0; i < numBlocks; i++) {
-            finalResult = eviction_manager->readEvictedBlock(table, blockIds[i], tupleOffsets[i]) && finalResult;
-        } // FOR
+        // the reads are merged in by antiCacheMergeBlocks()
+        finalResult = eviction_manager->readEvictedBlocks(table, numBlocks, blockIds, tupleOffsets);
 
     } catch (SerializableEEException &e) {
         VOLT_ERROR("antiCacheReadBlocks: Failed to read %d evicted blocks for table '%s'\n%s",
@@ -2118,6 +2350,128 @@ void VoltDBEngine::antiCacheResetEvictedTupleTracker() {
     }
 }
 
+bool VoltDBEngine::antiCacheSetCompression(AntiCacheCompressionType type, int level) {
+    if (m_executorContext->isAntiCacheEnabled() == false) {
+        VOLT_ERROR("Unable to set anti-cache block compression at Partition %d before the anti-cache is initialized",
+                   m_partitionId);
+        return false;
+    }
+    return m_executorContext->getAntiCacheEvictionManager()->setCompression(type, level);
+}
+
+/**
+ * Tables that use tuple merge only read back the evicted tuples they
+ * touch where the AntiCacheDB allows it, instead of whole blocks
+ */
+void VoltDBEngine::antiCacheSetMergeStrategy(int32_t tableId, bool blockMerge) {
+    PersistentTable *table = dynamic_cast<PersistentTable*>(this->getTable(tableId));
+    if (table == NULL) {
+        throwFatalException("Invalid table id %d", tableId);
+    }
+    VOLT_INFO("Setting %s merge for table '%s'", (blockMerge ? "block" : "tuple"), table->name().c_str());
+    table->setBlockMerge(blockMerge);
+}
+
+/**
+ * Drop the entries that the non-unique secondary indexes of the table have
+ * for its evicted tuples, keeping only the key range of each evicted block.
+ * Returns false if the table has evicted tuples or no primary key.
+ */
+bool VoltDBEngine::antiCacheSetIndexEviction(int32_t tableId, bool evictIndexes) {
+    PersistentTable *table = dynamic_cast<PersistentTable*>(this->getTable(tableId));
+    if (table == NULL) {
+        throwFatalException("Invalid table id %d", tableId);
+    }
+    if (table->setIndexEviction(evictIndexes) == false) {
+        VOLT_ERROR("Unable to turn index eviction %s for table '%s'",
+                   (evictIndexes ? "on" : "off"), table->name().c_str());
+        return false;
+    }
+    return true;
+}
+
+bool VoltDBEngine::antiCacheSetEvictionPolicy(int32_t tableId, AntiCacheEvictionPolicy policy) {
+    if (m_executorContext->isAntiCacheEnabled() == false) {
+        VOLT_ERROR("Unable to set the anti-cache eviction policy at Partition %d before the anti-cache is initialized",
+                   m_partitionId);
+        return false;
+    }
+    PersistentTable *table = dynamic_cast<PersistentTable*>(this->getTable(tableId));
+    if (table == NULL) {
+        throwFatalException("Invalid table id %d", tableId);
+    }
+    m_executorContext->getAntiCacheEvictionManager()->setEvictionPolicy(table, policy);
+    return true;
+}
+
+/**
+ * Hand the compression and writing of evicted blocks to a background
+ * thread with room for queueDepth blocks. 0 turns it off again.
+ */
+bool VoltDBEngine::antiCacheSetBackgroundWrites(int queueDepth) {
+    if (m_executorContext->isAntiCacheEnabled() == false) {
+        VOLT_ERROR("Unable to set anti-cache background writes at Partition %d before the anti-cache is initialized",
+                   m_partitionId);
+        return false;
+    }
+    m_executorContext->getAntiCacheEvictionManager()->setBackgroundWrites(queueDepth);
+    return true;
+}
+
+bool VoltDBEngine::antiCacheSetTierPolicy(int promoteAccesses, int demotePercent) {
+    if (m_executorContext->isAntiCacheEnabled() == false) {
+        VOLT_ERROR("Unable to set the anti-cache tier policy at Partition %d before the anti-cache is initialized",
+                   m_partitionId);
+        return false;
+    }
+    return m_executorContext->getAntiCacheEvictionManager()->setTierPolicy(promoteAccesses, demotePercent);
+}
+
+/**
+ * Promote and demote up to maxBlocks evicted blocks between the anti-cache
+ * tiers. Meant to be called while the partition is idle. Returns the
+ * number of blocks moved, or -1 if that failed.
+ */
+int VoltDBEngine::antiCacheMigrateTiers(int maxBlocks) {
+    if (m_executorContext->isAntiCacheEnabled() == false) {
+        return 0;
+    }
+    try {
+        return m_executorContext->getAntiCacheEvictionManager()->migrateTiers(maxBlocks);
+    } catch (SerializableEEException &e) {
+        VOLT_INFO("Failed to migrate anti-cache blocks at Partition %d", m_partitionId);
+        resetReusedResultOutputBuffer();
+        e.serialize(getExceptionOutputSerializer());
+    }
+    return -1;
+}
+
+/**
+ * Check whether the tuples with the given primary keys of the table are
+ * evicted before the transaction that needs them runs. If they are, the
+ * EvictedTupleAccessException is passed up like that of a query, so that
+ * the transaction waits for the AntiCacheManager to read the blocks
+ * instead of running into them.
+ */
+int VoltDBEngine::antiCachePrefetch(int32_t tableId, const NValueArray &keys, int numValues) {
+    if (m_executorContext->isAntiCacheEnabled() == false) {
+        return ENGINE_ERRORCODE_SUCCESS;
+    }
+    PersistentTable *table = dynamic_cast<PersistentTable*>(this->getTable(tableId));
+    if (table == NULL) {
+        throwFatalException("Invalid table id %d", tableId);
+    }
+    try {
+        m_executorContext->getAntiCacheEvictionManager()->prefetchEvictedTuples(table, tableId, keys, numValues);
+    } catch (SerializableEEException &e) {
+        VOLT_DEBUG("Prefetch found evicted tuples of table '%s'", table->name().c_str());
+        resetReusedResultOutputBuffer();
+        e.serialize(getExceptionOutputSerializer());
+        return ENGINE_ERRORCODE_ERROR;
+    }
+    return ENGINE_ERRORCODE_SUCCESS;
+}
+
 #else
 void VoltDBEngine::antiCacheInitialize(std::string dbDir, AntiCacheDBType dbType,
         long blockSize, long maxSize) const {
@@ -56,6 +56,7 @@
 #include "catalog/database.h"
 #include "common/ids.h"
 #include "common/Pool.hpp"
+#include "common/BlockAllocator.h"
 #include "common/MMAPMemoryManager.h"
 #include "common/serializeio.h"
 #include "common/types.h"
@@ -68,6 +69,9 @@
 #include "logging/LogManager.h"
 #include "logging/LogProxy.h"
 #include "logging/StdoutLogProxy.h"
+#ifdef ARIES
+#include "logging/Logrecord.h"
+#endif
 #include "stats/StatsAgent.h"
 //#include "storage/persistenttable.h"
 //#include "storage/mmap_persistenttable.h"
@@ -83,6 +87,8 @@
 
 #define MAX_BATCH_COUNT 1000
 #define MAX_PARAM_COUNT 1000 // or whatever
+#define ARIES_RECORD_STACK_BUFFER_SIZE 4096
+#define COMPACTION_TIME_BUDGET_MICROS 0 // per tick, off until a budget is set
 
 namespace boost {
 template <typename T> class shared_ptr;
@@ -111,6 +117,7 @@ class ReferenceSerializeOutput;
 class PlanNodeFragment;
 class ExecutorContext;
 class RecoveryProtoMsg;
+class ReadWriteTracker;
 
 /**
  * Represents an Execution Engine which holds catalog objects (i.e. table) and executes
@@ -132,7 +139,10 @@ class __attribute__((visibility("default"))) VoltDBEngine {
           m_templateSingleLongTable(NULL),
           m_topend(NULL),
           m_logProxy(NULL),
-          m_ARIESEnabled(false)
+          m_ARIESEnabled(false),
+          m_ARIESRecoveryThreads(0),
+          m_compactionTimeBudget(COMPACTION_TIME_BUDGET_MICROS),
+          m_compactionTableId(-1)
         {
             m_currentUndoQuantum = new DummyUndoQuantum();
 
@@ -169,6 +179,18 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         // -------------------------------------------------
         int executeQuery(int64_t planfragmentId, int32_t outputDependencyId, int32_t inputDependencyId,
                          const NValueArray &params, int64_t txnId, int64_t lastCommittedTxnId, bool first, bool last);
+        /**
+         * Execute a batch of plan fragments whose parameter sets are packed one
+         * after the other in serialize_in, each prefixed by its short count.
+         * The execution context and tracker are set up once for the batch, a
+         * run of the same fragment id resolves its executors once, and a
+         * parameter set that repeats the previous one byte for byte is not
+         * decoded again. Every fragment still gets its own result dependency.
+         * Returns the number of fragments that failed.
+         */
+        int executeQueries(int numFragments, const int64_t *planfragmentIds,
+                           const int32_t *outputDependencyIds, const int32_t *inputDependencyIds,
+                           ReferenceSerializeInput &serialize_in, int64_t txnId, int64_t lastCommittedTxnId);
         int executePlanFragment(std::string fragmentString, int32_t outputDependencyId, int32_t inputDependencyId,
                                 int64_t txnId, int64_t lastCommittedTxnId);
 
@@ -257,6 +279,30 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         /** Perform once per second, non-transactional work. */
         void tick(int64_t timeInMillis, int64_t lastCommittedTxnId);
 
+        /**
+         * Microseconds each tick may spend moving tuples out of the sparse
+         * trailing blocks of tables. Compaction is off (0) until a budget
+         * is set.
+         */
+        void setCompactionTimeBudget(int64_t micros) {
+            m_compactionTimeBudget = micros;
+        }
+
+        /**
+         * Keep column minipages for the blocks of a read-mostly table, which
+         * lets SeqScan predicates and aggregates run a column at a time.
+         */
+        bool setColumnarLayout(int32_t tableId, bool columnar);
+
+        /**
+         * Back table blocks, Pool chunks and index arrays with huge pages
+         * and/or prefer the NUMA node of the site's CPU. Applies to the whole
+         * process and to memory allocated from now on.
+         */
+        void setBlockAllocatorOptions(bool hugePages, bool numaLocal) {
+            BlockAllocator::configure(hugePages, numaLocal);
+        }
+
         /** flush active work (like EL buffers) */
         void quiesce(int64_t lastCommittedTxnId);
 
@@ -300,11 +346,19 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         #ifdef ANTICACHE
         void antiCacheAddDB(std::string dbDir, AntiCacheDBType dbType, long blockSize, long maxSize) const;
 
-        int antiCacheReadBlocks(int32_t tableId, int numBlocks, int32_t blockIds[], int32_t tupleOffsets[]);
+        int antiCacheReadBlocks(int32_t tableId, int numBlocks, int64_t blockIds[], int32_t tupleOffsets[]);
         int antiCacheEvictBlock(int32_t tableId, long blockSize, int numBlocks);
         int antiCacheEvictBlockInBatch(int32_t tableId, int32_t childTableId, long blockSize, int numBlocks);
         int antiCacheMergeBlocks(int32_t tableId);
         void antiCacheResetEvictedTupleTracker();
+        bool antiCacheSetCompression(AntiCacheCompressionType type, int level);
+        void antiCacheSetMergeStrategy(int32_t tableId, bool blockMerge);
+        bool antiCacheSetIndexEviction(int32_t tableId, bool evictIndexes);
+        bool antiCacheSetEvictionPolicy(int32_t tableId, AntiCacheEvictionPolicy policy);
+        bool antiCacheSetBackgroundWrites(int queueDepth);
+        bool antiCacheSetTierPolicy(int promoteAccesses, int demotePercent);
+        int antiCacheMigrateTiers(int maxBlocks);
+        int antiCachePrefetch(int32_t tableId, const NValueArray &keys, int numValues);
         #endif
 
         // -------------------------------------------------
@@ -316,6 +370,13 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         // ARIES
         void ARIESInitialize(std::string dbDir, std::string logFile) ;
 
+        /**
+         * Group commit policy of the local ARIES log, see AriesLogProxy.
+         * Only valid after ARIESInitialize(). Returns false if there is
+         * no local log to apply it to.
+         */
+        bool ARIESSetGroupCommit(int64_t groupCommitMicros, bool syncOnCommit, bool useDSync);
+
         std::string getARIESDir(){
             return m_ARIESDir;
         }
@@ -340,6 +401,11 @@ class __attribute__((visibility("default"))) VoltDBEngine {
             m_ARIESEnabled = status;
         }
 
+        /** Threads used to replay the log, 0 means one per core */
+        void setARIESRecoveryThreads(int numThreads) {
+            m_ARIESRecoveryThreads = numThreads;
+        }
+
 
         // -------------------------------------------------
         // Debug functions
@@ -463,6 +529,14 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         size_t getArieslogBufferLength();
 
         void rewindArieslogBuffer();
+
+        /**
+         * Write a CompactLogRecord for a change to the table with the given
+         * catalog id. The record's LSN is the current end of the log.
+         */
+        void logAriesRecord(LogRecord::Logrec_type_t type, int64_t xid, int32_t tableId,
+                            TableIndex *pkeyIndex, const std::vector<int32_t> *modifiedCols,
+                            TableTuple *beforeImage, TableTuple *afterImage);
         #endif
 
         /**
@@ -503,6 +577,11 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         bool initMaterializedViews(bool addAll);
         bool updateCatalogDatabaseReference();
 
+        #ifdef ARIES
+        bool replayCompactLogRecord(ReferenceSerializeInput &input, const char *endOfBuffer,
+                                    int64_t replay_txnid, int32_t &counter);
+        #endif
+
         void printReport();
         
         // HACK: PAVLO 2014-11-20
@@ -518,9 +597,18 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         struct ExecutorVector {
             std::vector<AbstractExecutor*> list;
             int tempTableMemoryInBytes;
+            // for every position in list, the output table of the last executor
+            // up to there that needs clearing after the fragment ran, or NULL
+            std::vector<Table*> cleanUpTables;
         };
         std::map<int64_t, boost::shared_ptr<ExecutorVector> > m_executorMap;
 
+        ExecutorVector* getExecutorVector(int64_t planfragmentId) const;
+        int executeFragment(int64_t planfragmentId, ExecutorVector &execsForFrag,
+                            int32_t outputDependencyId, int32_t inputDependencyId,
+                            const NValueArray &params, ReadWriteTracker *tracker,
+                            int64_t txnId, bool first, bool last);
+
         voltdb::UndoLog m_undoLog;
         voltdb::UndoQuantum *m_currentUndoQuantum;
 
@@ -666,6 +754,13 @@ class __attribute__((visibility("default"))) VoltDBEngine {
 
         bool m_ARIESEnabled ;
 
+        int m_ARIESRecoveryThreads;
+
+        // table compaction from tick(), resumes after m_compactionTableId
+        int64_t m_compactionTimeBudget;
+        int32_t m_compactionTableId;
+        void compactTables();
+
 };
 
 inline void VoltDBEngine::resetReusedResultOutputBuffer(const size_t headerSize) {
@@ -715,6 +810,17 @@ void VoltDBEngine::releaseUndoToken(int64_t undoToken){
   }
 #endif
 
+#ifdef ARIES
+  if (isARIESEnabled()) {
+      // group commit: wait for this txn's records to become durable
+      // instead of syncing every record as it is logged
+      AriesLogProxy* ariesProxy = m_logManager->getAriesLogProxy();
+      if (ariesProxy != NULL) {
+          ariesProxy->commit();
+      }
+  }
+#endif
+
   if (m_currentUndoQuantum != NULL && m_currentUndoQuantum->getUndoToken() == undoToken) {
       m_currentUndoQuantum = NULL;    
   }
@@ -475,6 +475,269 @@ helper(AggregatePlanNode* node, Agg** aggs,
     return true;
 }
 
+/*
+ * An aggregate whose result has already been computed a column at a time
+ */
+class ColumnarResultAgg : public Agg
+{
+public:
+    ColumnarResultAgg(const NValue value) :
+        m_value(value)
+    {}
+
+    void advance(const NValue val)
+    {}
+
+    NValue finalize()
+    {
+        return m_value;
+    }
+
+private:
+    NValue m_value;
+};
+
+/*
+ * Nulls in a minipage are widened to INT64_NULL and DOUBLE_MIN, and
+ * NValue takes any double at or below DOUBLE_NULL for a null
+ */
+inline bool isNullInMinipage(int64_t value)
+{
+    return value == INT64_NULL;
+}
+
+inline bool isNullInMinipage(double value)
+{
+    return value <= DOUBLE_NULL;
+}
+
+/*
+ * Add the way op_add() does, returns false where it would throw or
+ * produce a null
+ */
+inline bool addInMinipage(int64_t &sum, int64_t value)
+{
+    if ((value > 0 && sum > INT64_MAX - value) ||
+        (value < 0 && sum < INT64_MIN - value))
+    {
+        return false;
+    }
+    sum += value;
+    return sum != INT64_NULL;
+}
+
+inline bool addInMinipage(double &sum, double value)
+{
+    sum += value;
+    return !CHECK_FPE(sum) && sum > DOUBLE_NULL;
+}
+
+/*
+ * Fold a block's minipage into an aggregate, in slot order so that sums
+ * add up exactly as they do a tuple at a time. Returns false if a sum
+ * cannot be computed here.
+ */
+template <typename T>
+inline bool
+accumulateMinipage(ExpressionType type, const T* values, int slots,
+                   int64_t &count, bool &seen, T &result)
+{
+    switch (type) {
+    case EXPRESSION_TYPE_AGGREGATE_COUNT:
+        for (int slot = 0; slot < slots; slot++) {
+            count += isNullInMinipage(values[slot]) ? 0 : 1;
+        }
+        return true;
+    case EXPRESSION_TYPE_AGGREGATE_SUM:
+        for (int slot = 0; slot < slots; slot++) {
+            if (isNullInMinipage(values[slot])) {
+                continue;
+            }
+            if (!seen) {
+                result = values[slot];
+                seen = true;
+            } else if (!addInMinipage(result, values[slot])) {
+                return false;
+            }
+        }
+        return true;
+    case EXPRESSION_TYPE_AGGREGATE_MIN:
+        for (int slot = 0; slot < slots; slot++) {
+            if (isNullInMinipage(values[slot])) {
+                continue;
+            }
+            result = (seen && result < values[slot]) ? result : values[slot];
+            seen = true;
+        }
+        return true;
+    case EXPRESSION_TYPE_AGGREGATE_MAX:
+        for (int slot = 0; slot < slots; slot++) {
+            if (isNullInMinipage(values[slot])) {
+                continue;
+            }
+            result = (seen && result > values[slot]) ? result : values[slot];
+            seen = true;
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ * Running state of one aggregate over the minipages of a table
+ */
+struct ColumnarAggregate
+{
+    ColumnarAggregate() :
+        m_count(0), m_seen(false), m_bigInt(0), m_double(0)
+    {}
+
+    ExpressionType m_type;
+    int m_column;
+    int64_t m_count;
+    bool m_seen;
+    int64_t m_bigInt;
+    double m_double;
+};
+
+/*
+ * Aggregate a table with a columnar layout a minipage at a time instead
+ * of a tuple at a time. This only handles aggregates without a GROUP BY
+ * that are COUNT(*), or COUNT, MIN, MAX or SUM of an integer, timestamp
+ * (not summed) or double column; handled is left false for anything
+ * else, and when a sum would overflow, so that the caller aggregates the
+ * tuples instead and raises the error the same way.
+ */
+inline bool
+columnarAggregate(AggregatePlanNode* node, Table* input_table, Table* output_table,
+                  PassThroughColType* passThroughColumns, Pool* memoryPool,
+                  bool &handled)
+{
+    handled = false;
+    ColumnarBlocks* columns = input_table->getColumnarBlocks();
+    if (columns == NULL || node->getGroupByColumns().size() != 0) {
+        return true;
+    }
+    const TupleSchema* schema = input_table->schema();
+    const std::vector<ExpressionType> agg_types = node->getAggregates();
+    const std::vector<int> agg_columns = node->getAggregateColumns();
+    std::vector<ColumnarAggregate> aggregates(agg_types.size());
+    for (int i = 0; i < aggregates.size(); i++)
+    {
+        aggregates[i].m_type = agg_types[i];
+        aggregates[i].m_column = agg_columns[i];
+        switch (agg_types[i]) {
+        case EXPRESSION_TYPE_AGGREGATE_COUNT_STAR:
+            break;
+        case EXPRESSION_TYPE_AGGREGATE_SUM:
+            if (schema->columnType(agg_columns[i]) == VALUE_TYPE_TIMESTAMP) {
+                return true;
+            }
+            // fall through
+        case EXPRESSION_TYPE_AGGREGATE_COUNT:
+        case EXPRESSION_TYPE_AGGREGATE_MIN:
+        case EXPRESSION_TYPE_AGGREGATE_MAX:
+            if (!columns->hasColumn(agg_columns[i])) {
+                return true;
+            }
+            break;
+        default:
+            return true;
+        }
+    }
+
+    int64_t live_tuples = 0;
+    char* last = NULL;
+    const size_t blocks = columns->sync();
+    for (size_t block = 0; block < blocks; block++)
+    {
+        const int slots = columns->refresh(block);
+        const char* live = columns->live(block);
+        for (int slot = 0; slot < slots; slot++) {
+            live_tuples += live[slot];
+        }
+        for (int slot = slots - 1; slot >= 0; slot--) {
+            if (live[slot]) {
+                last = columns->tupleAddress(block, slot);
+                break;
+            }
+        }
+        for (int i = 0; i < aggregates.size(); i++)
+        {
+            ColumnarAggregate &aggregate = aggregates[i];
+            if (aggregate.m_type == EXPRESSION_TYPE_AGGREGATE_COUNT_STAR) {
+                continue;
+            }
+            bool accumulated = columns->isDouble(aggregate.m_column) ?
+                accumulateMinipage(aggregate.m_type, columns->doubles(block, aggregate.m_column),
+                                   slots, aggregate.m_count, aggregate.m_seen, aggregate.m_double) :
+                accumulateMinipage(aggregate.m_type, columns->bigInts(block, aggregate.m_column),
+                                   slots, aggregate.m_count, aggregate.m_seen, aggregate.m_bigInt);
+            if (!accumulated) {
+                VOLT_DEBUG("Aggregating table '%s' a tuple at a time", input_table->name().c_str());
+                return true;
+            }
+        }
+    }
+
+    Agg** aggs = static_cast<Agg**>(memoryPool->allocate(sizeof(void*) * aggregates.size()));
+    for (int i = 0; i < aggregates.size(); i++)
+    {
+        const ColumnarAggregate &aggregate = aggregates[i];
+        NValue result = ValueFactory::getNullValue();
+        switch (aggregate.m_type) {
+        case EXPRESSION_TYPE_AGGREGATE_COUNT_STAR:
+            result = ValueFactory::getBigIntValue(live_tuples);
+            break;
+        case EXPRESSION_TYPE_AGGREGATE_COUNT:
+            result = ValueFactory::getBigIntValue(aggregate.m_count);
+            break;
+        case EXPRESSION_TYPE_AGGREGATE_SUM:
+            if (aggregate.m_seen) {
+                result = columns->isDouble(aggregate.m_column) ?
+                    ValueFactory::getDoubleValue(aggregate.m_double) :
+                    ValueFactory::getBigIntValue(aggregate.m_bigInt);
+            }
+            break;
+        default:
+            // MIN and MAX are one of the column's values, in its own type
+            if (!aggregate.m_seen) {
+                break;
+            }
+            switch (schema->columnType(aggregate.m_column)) {
+            case VALUE_TYPE_TINYINT:
+                result = ValueFactory::getTinyIntValue(static_cast<int8_t>(aggregate.m_bigInt));
+                break;
+            case VALUE_TYPE_SMALLINT:
+                result = ValueFactory::getSmallIntValue(static_cast<int16_t>(aggregate.m_bigInt));
+                break;
+            case VALUE_TYPE_INTEGER:
+                result = ValueFactory::getIntegerValue(static_cast<int32_t>(aggregate.m_bigInt));
+                break;
+            case VALUE_TYPE_TIMESTAMP:
+                result = ValueFactory::getTimestampValue(aggregate.m_bigInt);
+                break;
+            case VALUE_TYPE_DOUBLE:
+                result = ValueFactory::getDoubleValue(aggregate.m_double);
+                break;
+            default:
+                result = ValueFactory::getBigIntValue(aggregate.m_bigInt);
+                break;
+            }
+            break;
+        }
+        aggs[i] = new (memoryPool->allocate(sizeof(ColumnarResultAgg))) ColumnarResultAgg(result);
+    }
+
+    // the pass through columns come from the last tuple, as they would
+    // when aggregating a tuple at a time
+    TableTuple prev(schema);
+    prev.move(last);
+    handled = true;
+    return helper(node, aggs, output_table, input_table, prev, passThroughColumns);
+}
+
 /**
  * A list of aggregates for a specific group.
  */
@@ -987,6 +1250,21 @@ bool AggregateExecutor<aggregateType>::p_execute(const NValueArray &params, Read
     assert(input_table);
     VOLT_DEBUG("%s Input Table\n%s", node->debug().c_str(), input_table->debug().c_str());
 
+    if (aggregateType == PLAN_NODE_TYPE_AGGREGATE)
+    {
+        bool handled;
+        if (!columnarAggregate(node, input_table, output_table,
+                               &m_passThroughColumns, &m_memoryPool, handled))
+        {
+            return false;
+        }
+        if (handled)
+        {
+            VOLT_TRACE("output table\n%s", output_table->debug().c_str());
+            return true;
+        }
+    }
+
     std::vector<ExpressionType> agg_types = node->getAggregates();
     std::vector<ValueType> col_types(node->getAggregateColumns().size());
     for (int i = 0; i < col_types.size(); i++)
@@ -54,6 +54,8 @@
 #include "storage/tableutil.h"
 #include "storage/temptable.h"
 #include "storage/persistenttable.h"
+#include "catalog/catalogmap.h"
+#include "catalog/table.h"
 
 #include <cassert>
 
@@ -72,6 +74,13 @@ bool DeleteExecutor::p_init(AbstractPlanNode *abstract_node, const catalog::Data
     m_targetTable = dynamic_cast<PersistentTable*>(node->getTargetTable()); //target table should be persistenttable
     assert(m_targetTable);
     m_truncate = node->getTruncate();
+
+#ifdef ARIES
+    catalog::Table *catalogTable = catalog_db->tables().get(m_targetTable->name());
+    assert(catalogTable != NULL);
+    m_targetTableId = catalogTable->relativeIndex();
+#endif
+
     if (m_truncate) {
         assert(node->getInputTables().size() == 0);
         // TODO : we can't use target table here because
@@ -105,42 +114,10 @@ bool DeleteExecutor::p_execute(const NValueArray &params, ReadWriteTracker *trac
         if(m_engine->isARIESEnabled()){
             // no need of persistency check, m_targetTable is
             // always persistent for deletes
-
-            LogRecord *logrecord = new LogRecord(computeTimeStamp(),
-                    LogRecord::T_TRUNCATE,// this is a truncate record
-                    LogRecord::T_FORWARD,// the system is running normally
-                    -1,// XXX: prevLSN must be fetched from table!
-                    m_engine->getExecutorContext()->currentTxnId() ,// txn id
-                    m_engine->getSiteId(),// which execution site
-                    m_targetTable->name(),// the table affected
-                    NULL,// primary key irrelevant
-                    -1,// irrelevant numCols
-                    NULL,// list of modified cols irrelevant
-                    NULL,// before image irrelevant
-                    NULL// after image irrelevant
-            );
-
-            size_t logrecordLength = logrecord->getEstimatedLength();
-            char *logrecordBuffer = new char[logrecordLength];
-
-            FallbackSerializeOutput output;
-            output.initializeWithPosition(logrecordBuffer, logrecordLength, 0);
-
-            logrecord->serializeTo(output);
-
-            LogManager* m_logManager = this->m_engine->getLogManager();
-            Logger m_ariesLogger = m_logManager->getAriesLogger();
-            //VOLT_WARN("m_logManager : %p AriesLogger : %p",&m_logManager, &m_ariesLogger);
-            const Logger *logger = m_logManager->getThreadLogger(LOGGERID_MM_ARIES);
-
-            logger->log(LOGLEVEL_INFO, output.data(), output.position());
-
-            delete[] logrecordBuffer;
-            logrecordBuffer = NULL;
-
-            delete logrecord;
-            logrecord = NULL;
-
+            m_engine->logAriesRecord(LogRecord::T_TRUNCATE,
+                    m_engine->getExecutorContext()->currentTxnId(),// txn id
+                    m_targetTableId,// the table affected
+                    NULL, NULL, NULL, NULL);
         }
         #endif
 
@@ -174,77 +151,15 @@ bool DeleteExecutor::p_execute(const NValueArray &params, ReadWriteTracker *trac
         #ifdef ARIES
         if(m_engine->isARIESEnabled()){
             // no need of persistency check, m_targetTable is
-            // always persistent for deletes
-
-            // before image -- target is tuple to be deleted.
-            TableTuple *beforeImage = &m_targetTuple;
-
-            TableTuple *keyTuple = NULL;
-            char *keydata = NULL;
-
-
-            // See if we use an index instead
-            TableIndex *index = m_targetTable->primaryKeyIndex();
-
-            if (index != NULL) {
-                // First construct tuple for primary key
-                keydata = new char[index->getKeySchema()->tupleLength()];
-                keyTuple = new TableTuple(keydata, index->getKeySchema());
-
-                for (int i = 0; i < index->getKeySchema()->columnCount(); i++) {
-                    keyTuple->setNValue(i, beforeImage->getNValue(index->getColumnIndices()[i]));
-                }
-
-                // no before image need be recorded, just the primary key
-                beforeImage = NULL;
-            }
-
-            LogRecord *logrecord = new LogRecord(computeTimeStamp(),
-                    LogRecord::T_DELETE,// this is a delete record
-                    LogRecord::T_FORWARD,// the system is running normally
-                    -1,// XXX: prevLSN must be fetched from table!
-                    m_engine->getExecutorContext()->currentTxnId() ,// txn id
-                    m_engine->getSiteId(),// which execution site
-                    m_targetTable->name(),// the table affected
-                    keyTuple,// primary key
-                    -1,// must delete all columns
+            // always persistent for deletes. With a primary key
+            // only the key of the deleted tuple is logged.
+            m_engine->logAriesRecord(LogRecord::T_DELETE,
+                    m_engine->getExecutorContext()->currentTxnId(),// txn id
+                    m_targetTableId,// the table affected
+                    m_targetTable->primaryKeyIndex(),
                     NULL,// no list of modified cols
-                    beforeImage,
-                    NULL// no after image
-            );
-
-            size_t logrecordLength = logrecord->getEstimatedLength();
-            char *logrecordBuffer = new char[logrecordLength];
-
-            FallbackSerializeOutput output;
-            output.initializeWithPosition(logrecordBuffer, logrecordLength, 0);
-
-            logrecord->serializeTo(output);
-
-            LogManager* m_logManager = this->m_engine->getLogManager();
-            Logger m_ariesLogger = m_logManager->getAriesLogger();
-            //VOLT_WARN("m_logManager : %p AriesLogger : %p",&m_logManager, &m_ariesLogger);
-
-            const Logger *logger = m_logManager->getThreadLogger(LOGGERID_MM_ARIES);
-
-            logger->log(LOGLEVEL_INFO, output.data(), output.position());
-
-            delete[] logrecordBuffer;
-            logrecordBuffer = NULL;
-
-            delete logrecord;
-            logrecord = NULL;
-
-            if (keydata != NULL) {
-                delete[] keydata;
-                keydata = NULL;
-            }
-
-            if (keyTuple != NULL) {
-                delete keyTuple;
-                keyTuple = NULL;
-            }
-
+                    &m_targetTuple,// before image
+                    NULL);// no after image
         }
         #endif
 
@@ -83,6 +83,11 @@ class DeleteExecutor : public OperationExecutor {
         TableTuple m_inputTuple;
         TableTuple m_targetTuple;
 
+        #ifdef ARIES
+        /** catalog id of the target table, identifies it in ARIES log records */
+        int32_t m_targetTableId;
+        #endif
+
         /** reference to the engine/context to store the number of modified tuples */
         VoltDBEngine* m_engine;
 };
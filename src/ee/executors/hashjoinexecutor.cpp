@@ -0,0 +1,460 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include "hashjoinexecutor.h"
+#include "nestloopexecutor.h"
+#include "common/debuglog.h"
+#include "common/common.h"
+#include "common/tabletuple.h"
+#include "common/TupleSchema.h"
+#include "common/SQLException.h"
+#include "expressions/abstractexpression.h"
+#include "expressions/tuplevalueexpression.h"
+#include "indexes/indexkey.h"
+#include "storage/table.h"
+#include "storage/temptable.h"
+#include "storage/tableiterator.h"
+#include "storage/tablefactory.h"
+#include "plannodes/hashjoinnode.h"
+
+namespace voltdb {
+
+namespace {
+
+/** Largest key the GenericKey instantiations below hold */
+const int MAX_GENERIC_KEY_SIZE = 512;
+/** Largest key the IntsKey instantiations below hold, in bigints */
+const int MAX_INTS_KEY_COLUMNS = 4;
+
+template <typename KeyType>
+struct HashJoinEntry {
+    HashJoinEntry *next;
+    const char *address;
+    std::size_t hash;
+    KeyType key;
+};
+
+bool isIntegral(ValueType type) {
+    return type == VALUE_TYPE_TINYINT || type == VALUE_TYPE_SMALLINT ||
+           type == VALUE_TYPE_INTEGER || type == VALUE_TYPE_BIGINT ||
+           type == VALUE_TYPE_TIMESTAMP;
+}
+
+/**
+ * The type a pair of equi-join columns is hashed as. Equal values must
+ * give equal keys, so integers are widened to BIGINT and doubles are not
+ * hashed at all (0.0 and -0.0 are equal but not the same bytes).
+ */
+ValueType keyType(ValueType outer, ValueType inner) {
+    if (isIntegral(outer) && isIntegral(inner)) {
+        return VALUE_TYPE_BIGINT;
+    }
+    if (outer == inner && (outer == VALUE_TYPE_VARCHAR || outer == VALUE_TYPE_DECIMAL)) {
+        return outer;
+    }
+    return VALUE_TYPE_INVALID;
+}
+
+/** Collect the outer = inner column comparisons of the predicate's conjunction */
+void findKeyColumns(const AbstractExpression *expression,
+                    const TupleSchema *outer, const TupleSchema *inner,
+                    std::vector<int> &outerColumns, std::vector<int> &innerColumns,
+                    std::vector<ValueType> &types, std::vector<int32_t> &lengths) {
+    if (expression == NULL) {
+        return;
+    }
+    if (expression->getExpressionType() == EXPRESSION_TYPE_CONJUNCTION_AND) {
+        findKeyColumns(expression->getLeft(), outer, inner, outerColumns, innerColumns, types, lengths);
+        findKeyColumns(expression->getRight(), outer, inner, outerColumns, innerColumns, types, lengths);
+        return;
+    }
+    if (expression->getExpressionType() != EXPRESSION_TYPE_COMPARE_EQUAL) {
+        return;
+    }
+    const TupleValueExpression *left = dynamic_cast<const TupleValueExpression*>(expression->getLeft());
+    const TupleValueExpression *right = dynamic_cast<const TupleValueExpression*>(expression->getRight());
+    if (left == NULL || right == NULL || left->getTupleIndex() == right->getTupleIndex()) {
+        return;
+    }
+    if (left->getTupleIndex() != 0) {
+        std::swap(left, right);
+    }
+    const int outerColumn = left->getColumnId();
+    const int innerColumn = right->getColumnId();
+    const ValueType type = keyType(outer->columnType(outerColumn), inner->columnType(innerColumn));
+    if (type == VALUE_TYPE_INVALID) {
+        return;
+    }
+    outerColumns.push_back(outerColumn);
+    innerColumns.push_back(innerColumn);
+    types.push_back(type);
+    if (type == VALUE_TYPE_BIGINT) {
+        lengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    } else {
+        lengths.push_back(std::max(outer->columnLength(outerColumn), inner->columnLength(innerColumn)));
+    }
+}
+
+/**
+ * Flags the key columns that are stored out of line in the key but inline
+ * in the input. Those values can't be referenced from the key and have to
+ * be copied into a pool.
+ */
+std::vector<bool> findCopiedColumns(const TupleSchema *keySchema, const TupleSchema *input,
+                                    const std::vector<int> &columns) {
+    std::vector<bool> copied(columns.size(), false);
+    for (int ii = 0; ii < columns.size(); ii++) {
+        copied[ii] = !keySchema->columnIsInlined(ii) && input->columnIsInlined(columns[ii]);
+    }
+    return copied;
+}
+
+template <typename KeyType>
+inline void setKey(KeyType &key, TableTuple &keyTuple,
+                   const TableTuple &tuple, const std::vector<int> &columns,
+                   const std::vector<bool> &copied, Pool *pool) {
+    for (int ii = 0; ii < columns.size(); ii++) {
+        if (copied[ii]) {
+            keyTuple.setNValueAllocateForObjectCopies(ii, tuple.getNValue(columns[ii]), pool);
+        } else {
+            keyTuple.setNValue(ii, tuple.getNValue(columns[ii]));
+        }
+    }
+    key.setFromKey(&keyTuple);
+}
+
+}
+
+HashJoinExecutor::~HashJoinExecutor() {
+    if (m_keySchema != NULL) {
+        TupleSchema::freeTupleSchema(m_keySchema);
+    }
+}
+
+bool HashJoinExecutor::p_init(AbstractPlanNode* abstract_node, const catalog::Database* catalog_db, int* tempTableMemoryInBytes) {
+    VOLT_TRACE("init HashJoin Executor");
+    assert(tempTableMemoryInBytes);
+    m_tempTableMemoryInBytes = tempTableMemoryInBytes;
+
+    HashJoinPlanNode* node = dynamic_cast<HashJoinPlanNode*>(abstract_node);
+    assert(node);
+
+    // produce the fully joined schema relying on a later projection
+    // to narrow the output later as required.
+    assert(node->getInputTables().size() == 2);
+    const TupleSchema *first = node->getInputTables()[0]->schema();
+    const TupleSchema *second = node->getInputTables()[1]->schema();
+    TupleSchema *schema = TupleSchema::createTupleSchema(first, second);
+
+    int combinedColumnCount = first->columnCount() + second->columnCount();
+    std::string *columnNames = new std::string[combinedColumnCount];
+    std::vector<int> outputColumnGuids;
+    int index = 0;
+
+    for (int ctr = 0; ctr < 2; ctr++) {
+        assert(node->getInputTables()[ctr]);
+        for (int col_ctr = 0, col_cnt = node->getInputTables()[ctr]->columnCount();
+             col_ctr < col_cnt;
+             col_ctr++, index++)
+        {
+            outputColumnGuids.
+                push_back(node->getChildren()[ctr]->getOutputColumnGuids()[col_ctr]);
+            columnNames[index] = node->getInputTables()[ctr]->columnName(col_ctr);
+        }
+    }
+
+    // Set the mapping of column names to column indexes in output tables
+    node->setOutputColumnGuids(outputColumnGuids);
+
+    // create the output table
+    node->setOutputTable(
+        TableFactory::getTempTable(
+            node->getInputTables()[0]->databaseId(), "temp", schema, columnNames, tempTableMemoryInBytes));
+    delete[] columnNames;
+
+    // outer columns are the first eval() tuple, inner the second
+    if (!assignTupleValueIndexes(node->getPredicate(),
+                                 node->getInputTables()[0]->name(),
+                                 node->getInputTables()[1]->name())) {
+        return false;
+    }
+
+    std::vector<ValueType> keyTypes;
+    std::vector<int32_t> keyLengths;
+    findKeyColumns(node->getPredicate(), first, second,
+                   m_outerKeyColumns, m_innerKeyColumns, keyTypes, keyLengths);
+    if (m_outerKeyColumns.empty()) {
+        VOLT_WARN("HashJoin predicate has no equi-join columns, joining with"
+                  " a nest loop");
+        return true;
+    }
+
+    // the rest of the predicate is checked on each match anyway, so key
+    // columns that don't fit in the largest key are left out
+    m_intsOnly = (std::count(keyTypes.begin(), keyTypes.end(), VALUE_TYPE_BIGINT) ==
+                  static_cast<int>(keyTypes.size()));
+    while (true) {
+        std::vector<bool> keyAllowNull(keyTypes.size(), true);
+        m_keySchema = TupleSchema::createTupleSchema(keyTypes, keyLengths, keyAllowNull, true);
+        bool fits = m_intsOnly ?
+            (keyTypes.size() <= MAX_INTS_KEY_COLUMNS) :
+            (m_keySchema->tupleLength() <= MAX_GENERIC_KEY_SIZE);
+        if (fits || keyTypes.size() == 1) {
+            break;
+        }
+        TupleSchema::freeTupleSchema(m_keySchema);
+        keyTypes.pop_back();
+        keyLengths.pop_back();
+        m_outerKeyColumns.pop_back();
+        m_innerKeyColumns.pop_back();
+    }
+    if (!m_intsOnly && m_keySchema->tupleLength() > MAX_GENERIC_KEY_SIZE) {
+        VOLT_WARN("HashJoin key is larger than %d bytes, joining with a"
+                  " nest loop", MAX_GENERIC_KEY_SIZE);
+        TupleSchema::freeTupleSchema(m_keySchema);
+        m_keySchema = NULL;
+        m_outerKeyColumns.clear();
+        m_innerKeyColumns.clear();
+    } else {
+        m_outerKeyCopies = findCopiedColumns(m_keySchema, first, m_outerKeyColumns);
+        m_innerKeyCopies = findCopiedColumns(m_keySchema, second, m_innerKeyColumns);
+    }
+    VOLT_DEBUG("HashJoin on %d key columns", keyColumnCount());
+    return true;
+}
+
+bool HashJoinExecutor::p_execute(const NValueArray &params, ReadWriteTracker *tracker) {
+    VOLT_DEBUG("executing HashJoin...");
+
+    HashJoinPlanNode* node = dynamic_cast<HashJoinPlanNode*>(abstract_node);
+    assert(node);
+    assert(node->getInputTables().size() == 2);
+
+    // output table must be a temp table
+    TempTable* output_table = dynamic_cast<TempTable*>(node->getOutputTable());
+    assert(output_table);
+
+    Table* outer_table = node->getInputTables()[0];
+    assert(outer_table);
+
+    Table* inner_table = node->getInputTables()[1];
+    assert(inner_table);
+
+    VOLT_TRACE ("input table left:\n %s", outer_table->debug().c_str());
+    VOLT_TRACE ("input table right:\n %s", inner_table->debug().c_str());
+
+    //
+    // Join Expression
+    //
+    AbstractExpression *predicate = node->getPredicate();
+    if (predicate) {
+        predicate->substitute(params);
+        VOLT_TRACE ("predicate: %s", predicate == NULL ?
+                    "NULL" : predicate->debug(true).c_str());
+    }
+
+    if (m_keySchema == NULL) {
+        nestLoop(outer_table, inner_table, predicate, output_table);
+        return true;
+    }
+    try {
+        dispatch(outer_table, inner_table, predicate, output_table);
+    } catch (...) {
+        release();
+        throw;
+    }
+    release();
+    return true;
+}
+
+void HashJoinExecutor::dispatch(Table *outer_table, Table *inner_table,
+                                AbstractExpression *predicate, TempTable *output_table) {
+    const int keySize = m_keySchema->tupleLength();
+    if (m_intsOnly) {
+        if (keySize <= sizeof(uint64_t)) {
+            join<IntsKey<1>, IntsHasher<1>, IntsEqualityChecker<1> >(outer_table, inner_table, predicate, output_table);
+        } else if (keySize <= sizeof(int64_t) * 2) {
+            join<IntsKey<2>, IntsHasher<2>, IntsEqualityChecker<2> >(outer_table, inner_table, predicate, output_table);
+        } else if (keySize <= sizeof(int64_t) * 3) {
+            join<IntsKey<3>, IntsHasher<3>, IntsEqualityChecker<3> >(outer_table, inner_table, predicate, output_table);
+        } else {
+            join<IntsKey<4>, IntsHasher<4>, IntsEqualityChecker<4> >(outer_table, inner_table, predicate, output_table);
+        }
+    } else if (keySize <= 4) {
+        join<GenericKey<4>, GenericHasher<4>, GenericEqualityChecker<4> >(outer_table, inner_table, predicate, output_table);
+    } else if (keySize <= 8) {
+        join<GenericKey<8>, GenericHasher<8>, GenericEqualityChecker<8> >(outer_table, inner_table, predicate, output_table);
+    } else if (keySize <= 12) {
+        join<GenericKey<12>, GenericHasher<12>, GenericEqualityChecker<12> >(outer_table, inner_table, predicate, output_table);
+    } else if (keySize <= 16) {
+        join<GenericKey<16>, GenericHasher<16>, GenericEqualityChecker<16> >(outer_table, inner_table, predicate, output_table);
+    } else if (keySize <= 24) {
+        join<GenericKey<24>, GenericHasher<24>, GenericEqualityChecker<24> >(outer_table, inner_table, predicate, output_table);
+    } else if (keySize <= 32) {
+        join<GenericKey<32>, GenericHasher<32>, GenericEqualityChecker<32> >(outer_table, inner_table, predicate, output_table);
+    } else if (keySize <= 48) {
+        join<GenericKey<48>, GenericHasher<48>, GenericEqualityChecker<48> >(outer_table, inner_table, predicate, output_table);
+    } else if (keySize <= 64) {
+        join<GenericKey<64>, GenericHasher<64>, GenericEqualityChecker<64> >(outer_table, inner_table, predicate, output_table);
+    } else if (keySize <= 96) {
+        join<GenericKey<96>, GenericHasher<96>, GenericEqualityChecker<96> >(outer_table, inner_table, predicate, output_table);
+    } else if (keySize <= 128) {
+        join<GenericKey<128>, GenericHasher<128>, GenericEqualityChecker<128> >(outer_table, inner_table, predicate, output_table);
+    } else if (keySize <= 256) {
+        join<GenericKey<256>, GenericHasher<256>, GenericEqualityChecker<256> >(outer_table, inner_table, predicate, output_table);
+    } else {
+        join<GenericKey<512>, GenericHasher<512>, GenericEqualityChecker<512> >(outer_table, inner_table, predicate, output_table);
+    }
+}
+
+template <typename KeyType, typename KeyHasher, typename KeyEqualityChecker>
+void HashJoinExecutor::join(Table *outer_table, Table *inner_table,
+                            AbstractExpression *predicate, TempTable *output_table) {
+    typedef HashJoinEntry<KeyType> Entry;
+    KeyHasher hasher(m_keySchema);
+    KeyEqualityChecker equals(m_keySchema);
+
+    // build on the smaller input, probe with the other
+    const bool buildOuter = outer_table->activeTupleCount() < inner_table->activeTupleCount();
+    Table *build_table = buildOuter ? outer_table : inner_table;
+    Table *probe_table = buildOuter ? inner_table : outer_table;
+    const std::vector<int> &buildColumns = buildOuter ? m_outerKeyColumns : m_innerKeyColumns;
+    const std::vector<int> &probeColumns = buildOuter ? m_innerKeyColumns : m_outerKeyColumns;
+    const std::vector<bool> &buildCopies = buildOuter ? m_outerKeyCopies : m_innerKeyCopies;
+    const std::vector<bool> &probeCopies = buildOuter ? m_innerKeyCopies : m_outerKeyCopies;
+
+    std::size_t bucketCount = 16;
+    while (bucketCount < build_table->activeTupleCount()) {
+        bucketCount <<= 1;
+    }
+    const std::size_t mask = bucketCount - 1;
+    Entry **buckets = static_cast<Entry**>(allocate(bucketCount * sizeof(Entry*)));
+    ::memset(buckets, 0, bucketCount * sizeof(Entry*));
+
+    std::vector<char> keyData(m_keySchema->tupleLength() + TUPLE_HEADER_SIZE, 0);
+    TableTuple keyTuple(&keyData[0], m_keySchema);
+
+    TableTuple build_tuple(build_table->schema());
+    TableIterator build_iterator(build_table);
+    while (build_iterator.next(build_tuple)) {
+        Entry *entry = new (allocate(sizeof(Entry))) Entry();
+        setKey(entry->key, keyTuple, build_tuple, buildColumns, buildCopies, &m_memoryPool);
+        entry->hash = hasher(entry->key);
+        entry->address = build_tuple.address();
+        Entry *&bucket = buckets[entry->hash & mask];
+        entry->next = bucket;
+        bucket = entry;
+    }
+    VOLT_DEBUG("HashJoin built %d tuples of '%s' into %d buckets",
+               (int)build_table->activeTupleCount(), build_table->name().c_str(), (int)bucketCount);
+
+    const int outer_cols = outer_table->columnCount();
+    const int inner_cols = inner_table->columnCount();
+    TableTuple &joined = output_table->tempTuple();
+    TableTuple match(build_table->schema());
+    TableTuple probe_tuple(probe_table->schema());
+    KeyType probeKey;
+    // copied probe key strings are only needed until the next probe
+    Pool probePool;
+    const bool copyProbeKeys = (std::count(probeCopies.begin(), probeCopies.end(), true) > 0);
+    TableIterator probe_iterator(probe_table);
+    while (probe_iterator.next(probe_tuple)) {
+        if (copyProbeKeys) {
+            probePool.purge();
+        }
+        setKey(probeKey, keyTuple, probe_tuple, probeColumns, probeCopies, &probePool);
+        const std::size_t hash = hasher(probeKey);
+        for (Entry *entry = buckets[hash & mask]; entry != NULL; entry = entry->next) {
+            if (entry->hash != hash || !equals(entry->key, probeKey)) {
+                continue;
+            }
+            match.move(const_cast<char*>(entry->address));
+            const TableTuple &outer_tuple = buildOuter ? match : probe_tuple;
+            const TableTuple &inner_tuple = buildOuter ? probe_tuple : match;
+            if (predicate == NULL || predicate->eval(&outer_tuple, &inner_tuple).isTrue()) {
+                for (int col_ctr = 0; col_ctr < outer_cols; col_ctr++) {
+                    joined.setNValue(col_ctr, outer_tuple.getNValue(col_ctr));
+                }
+                for (int col_ctr = 0; col_ctr < inner_cols; col_ctr++) {
+                    joined.setNValue(col_ctr + outer_cols, inner_tuple.getNValue(col_ctr));
+                }
+                output_table->insertTupleNonVirtual(joined);
+            }
+        }
+    }
+}
+
+void HashJoinExecutor::nestLoop(Table *outer_table, Table *inner_table,
+                                AbstractExpression *predicate, TempTable *output_table) {
+    int outer_cols = outer_table->columnCount();
+    int inner_cols = inner_table->columnCount();
+    TableTuple outer_tuple(outer_table->schema());
+    TableTuple inner_tuple(inner_table->schema());
+    TableTuple &joined = output_table->tempTuple();
+
+    TableIterator iterator0(outer_table);
+    while (iterator0.next(outer_tuple)) {
+        for (int col_ctr = 0; col_ctr < outer_cols; col_ctr++) {
+            joined.setNValue(col_ctr, outer_tuple.getNValue(col_ctr));
+        }
+        TableIterator iterator1(inner_table);
+        while (iterator1.next(inner_tuple)) {
+            if (predicate == NULL || predicate->eval(&outer_tuple, &inner_tuple).isTrue()) {
+                for (int col_ctr = 0; col_ctr < inner_cols; col_ctr++) {
+                    joined.setNValue(col_ctr + outer_cols, inner_tuple.getNValue(col_ctr));
+                }
+                output_table->insertTupleNonVirtual(joined);
+            }
+        }
+    }
+}
+
+void* HashJoinExecutor::allocate(std::size_t size) {
+    m_buildMemoryInBytes += static_cast<int>(size);
+    if (m_tempTableMemoryInBytes) {
+        (*m_tempTableMemoryInBytes) += static_cast<int>(size);
+        if ((*m_tempTableMemoryInBytes) > MAX_TEMP_TABLE_MEMORY) {
+            throw SQLException(SQLException::volt_temp_table_memory_overflow,
+                               "More than 100MB of temp table memory used while"
+                               " executing SQL. Aborting.");
+        }
+    }
+    return m_memoryPool.allocate(size);
+}
+
+void HashJoinExecutor::release() {
+    if (m_tempTableMemoryInBytes) {
+        (*m_tempTableMemoryInBytes) -= m_buildMemoryInBytes;
+    }
+    m_buildMemoryInBytes = 0;
+    m_memoryPool.purge();
+}
+
+}
@@ -0,0 +1,99 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HSTOREHASHJOINEXECUTOR_H
+#define HSTOREHASHJOINEXECUTOR_H
+
+#include <vector>
+
+#include "common/common.h"
+#include "common/valuevector.h"
+#include "common/Pool.hpp"
+#include "executors/abstractexecutor.h"
+
+namespace voltdb {
+
+class AbstractExpression;
+class TempTable;
+class TupleSchema;
+
+/**
+ * Hash join: the smaller input is loaded into a hash table on the join
+ * keys and the other input probes it, so a join costs O(N+M) instead of
+ * the O(N*M) of the NestLoopExecutor. The predicate is still evaluated
+ * on every pair that the hash table matches, so the output is the same
+ * as the nest loop join of the same plan.
+ *
+ * The hash table lives in the executor's Pool and counts against the
+ * temp table memory of the fragment while the join runs.
+ */
+class HashJoinExecutor : public AbstractExecutor {
+    public:
+        HashJoinExecutor(VoltDBEngine *engine, AbstractPlanNode* abstract_node)
+            : AbstractExecutor(engine, abstract_node),
+              m_keySchema(NULL),
+              m_intsOnly(false),
+              m_tempTableMemoryInBytes(NULL),
+              m_buildMemoryInBytes(0)
+        { }
+        ~HashJoinExecutor();
+
+        /** Number of join key columns, zero if the predicate has no equi-join */
+        int keyColumnCount() const { return static_cast<int>(m_outerKeyColumns.size()); }
+
+    protected:
+        bool p_init(AbstractPlanNode*, const catalog::Database* catalog_db, int* tempTableMemoryInBytes);
+        bool p_execute(const NValueArray &params, ReadWriteTracker *tracker);
+
+    private:
+        template <typename KeyType, typename KeyHasher, typename KeyEqualityChecker>
+        void join(Table *outer_table, Table *inner_table,
+                  AbstractExpression *predicate, TempTable *output_table);
+        void nestLoop(Table *outer_table, Table *inner_table,
+                      AbstractExpression *predicate, TempTable *output_table);
+        void dispatch(Table *outer_table, Table *inner_table,
+                      AbstractExpression *predicate, TempTable *output_table);
+
+        /** Build side memory, counted against MAX_TEMP_TABLE_MEMORY */
+        void* allocate(std::size_t size);
+        void release();
+
+        // columns of the outer and inner table that make up the key
+        std::vector<int> m_outerKeyColumns;
+        std::vector<int> m_innerKeyColumns;
+        // key columns that are inline in the input but not in the key
+        std::vector<bool> m_outerKeyCopies;
+        std::vector<bool> m_innerKeyCopies;
+        TupleSchema *m_keySchema;
+        bool m_intsOnly;
+
+        int *m_tempTableMemoryInBytes;
+        int m_buildMemoryInBytes;
+        Pool m_memoryPool;
+};
+
+}
+
+#endif
@@ -50,6 +50,7 @@
 #include "common/tabletuple.h"
 #include "common/FatalException.hpp"
 #include "expressions/abstractexpression.h"
+#include "expressions/compiledpredicate.h"
 #include "expressions/expressions.h"
 #include "expressions/expressionutil.h"
 
@@ -336,6 +337,11 @@ bool IndexScanExecutor::p_init(AbstractPlanNode *abstractNode,
     m_lookupType = m_node->getLookupType();
     m_sortDirection = m_node->getSortDirection();
 
+    m_endPredicate = CompiledPredicate::compile(m_node->getEndExpression(),
+                                                m_targetTable->schema(), NULL);
+    m_postPredicate = CompiledPredicate::compile(m_node->getPredicate(),
+                                                 m_targetTable->schema(), NULL);
+
     return true;
 }
 
@@ -432,6 +438,7 @@ bool IndexScanExecutor::p_execute(const NValueArray &params, ReadWriteTracker *t
     {
         if (m_needsSubstituteEndExpression) {
             end_expression->substitute(params);
+            m_endPredicate->bind();
         }
         VOLT_DEBUG("End Expression:\n%s", end_expression->debug(true).c_str());
     }
@@ -444,6 +451,7 @@ bool IndexScanExecutor::p_execute(const NValueArray &params, ReadWriteTracker *t
     {
         if (m_needsSubstitutePostExpression) {
             post_expression->substitute(params);
+            m_postPredicate->bind();
         }
         VOLT_DEBUG("Post Expression:\n%s", post_expression->debug(true).c_str());
     }
@@ -546,7 +554,7 @@ bool IndexScanExecutor::p_execute(const NValueArray &params, ReadWriteTracker *t
         // First check whether the end_expression is now false
         //
         if (end_expression != NULL &&
-            end_expression->eval(&m_tuple, NULL).isFalse()) {
+            m_endPredicate->isTrue(&m_tuple, NULL) == false) {
             VOLT_DEBUG("End Expression evaluated to false, stopping scan");
             break;
         }
@@ -554,7 +562,7 @@ bool IndexScanExecutor::p_execute(const NValueArray &params, ReadWriteTracker *t
         // Then apply our post-predicate to do further filtering
         //
         if (post_expression == NULL ||
-            post_expression->eval(&m_tuple, NULL).isTrue()) {
+            m_postPredicate->isTrue(&m_tuple, NULL)) {
 
             #ifdef ANTICACHE
             if (hasEvictedTable) {
@@ -632,6 +640,19 @@ bool IndexScanExecutor::p_execute(const NValueArray &params, ReadWriteTracker *t
         }
     } // WHILE
 
+    #ifdef ANTICACHE
+    // Evicted tuples whose entries were dropped from this index can only
+    // be found through the key ranges of their blocks. The scan did not
+    // get past the tuple it stopped at, if it stopped before the end.
+    if (hasEvictedTable) {
+        eviction_manager->recordEvictedIndexAccess(m_catalogTable, m_targetTable, m_index,
+                                                   &m_searchKey, m_numOfSearchkeys, m_lookupType,
+                                                   (m_tuple.isNullTuple() ? NULL : &m_tuple),
+                                                   (m_numOfSearchkeys > 0 ||
+                                                    m_sortDirection != SORT_DIRECTION_TYPE_DESC));
+    }
+    #endif
+
     //
     // Inline Aggregate
     //
@@ -689,4 +710,6 @@ bool IndexScanExecutor::p_execute(const NValueArray &params, ReadWriteTracker *t
 IndexScanExecutor::~IndexScanExecutor() {
     delete [] m_searchKeyBackingStore;
     delete [] m_projectionExpressions;
+    delete m_endPredicate;
+    delete m_postPredicate;
 }
@@ -63,6 +63,7 @@ class TempTable;
 class PersistentTable;
 
 class AbstractExpression;
+class CompiledPredicate;
 
 //
 // Inline PlanNodes
@@ -77,7 +78,8 @@ class IndexScanExecutor : public AbstractExecutor
 {
 public:
     IndexScanExecutor(VoltDBEngine* engine, AbstractPlanNode* abstractNode)
-        : AbstractExecutor(engine, abstractNode), m_searchKeyBackingStore(NULL)
+        : AbstractExecutor(engine, abstractNode),
+          m_endPredicate(NULL), m_postPredicate(NULL), m_searchKeyBackingStore(NULL)
     {
         m_projectionExpressions = NULL;
     }
@@ -119,6 +121,8 @@ protected:
     bool* m_needsSubstituteSearchKey; // needs_substitute_search_key_ptr[]
     bool m_needsSubstitutePostExpression;
     bool m_needsSubstituteEndExpression;
+    CompiledPredicate *m_endPredicate;
+    CompiledPredicate *m_postPredicate;
 
     // Inline Aggregate
     AggregatePlanNode* m_aggregateNode;
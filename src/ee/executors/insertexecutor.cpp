@@ -57,6 +57,8 @@
 #include "storage/tableutil.h"
 #include "storage/tablefactory.h"
 #include "storage/temptable.h"
+#include "catalog/catalogmap.h"
+#include "catalog/table.h"
 
 
 #ifdef ARIES
@@ -103,6 +105,12 @@ bool InsertExecutor::p_init(AbstractPlanNode *abstract_node, const catalog::Data
         }
     }
     m_multiPartition = m_node->isMultiPartition();
+
+#ifdef ARIES
+    catalog::Table *catalogTable = catalog_db->tables().get(m_targetTable->name());
+    assert(catalogTable != NULL);
+    m_targetTableId = catalogTable->relativeIndex();
+#endif
     return true;
 }
 
@@ -147,49 +155,16 @@ bool InsertExecutor::p_execute(const NValueArray &params, ReadWriteTracker *trac
 
         #ifdef ARIES
         if(m_engine->isARIESEnabled()){
-
-            // add persistency check:
-            PersistentTable* table = dynamic_cast<PersistentTable*>(m_targetTable);
-
             // only log if we are writing to a persistent table.
-            if (table != NULL) {
-                LogRecord *logrecord = new LogRecord(computeTimeStamp(),
-                        LogRecord::T_INSERT,    // this is an insert record
-                        LogRecord::T_FORWARD,// the system is running normally
-                        -1,// XXX: prevLSN must be fetched from table!
-                        m_engine->getExecutorContext()->currentTxnId() ,// txn id
-                        m_engine->getSiteId(),// which execution site
-                        m_targetTable->name(),// the table affected
+            if (dynamic_cast<PersistentTable*>(m_targetTable) != NULL) {
+                m_engine->logAriesRecord(LogRecord::T_INSERT,
+                        m_engine->getExecutorContext()->currentTxnId(),// txn id
+                        m_targetTableId,// the table affected
                         NULL,// insert, no primary key
-                        -1,// inserting, all columns affected
-                        NULL,// insert, don't care about modified cols
+                        NULL,// inserting, all columns affected
                         NULL,// no before image
-                        &m_tuple// after image
-                );
-
-                size_t logrecordEstLength = logrecord->getEstimatedLength();
-                char *logrecordBuffer = new char[logrecordEstLength];
-
-                FallbackSerializeOutput output;
-                output.initializeWithPosition(logrecordBuffer, logrecordEstLength, 0);
-
-                logrecord->serializeTo(output);
-
-                LogManager* m_logManager = this->m_engine->getLogManager();
-                Logger m_ariesLogger = m_logManager->getAriesLogger();
-                //VOLT_WARN("m_logManager : %p AriesLogger : %p",&m_logManager, &m_ariesLogger);
-                const Logger *logger = m_logManager->getThreadLogger(LOGGERID_MM_ARIES);
-
-                // output.position() indicates the actual number of bytes written out
-                logger->log(LOGLEVEL_INFO, output.data(), output.position());
-
-                delete[] logrecordBuffer;
-                logrecordBuffer = NULL;
-
-                delete logrecord;
-                logrecord = NULL;
+                        &m_tuple);// after image
             }
-
         }
         #endif
 
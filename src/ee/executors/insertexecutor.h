@@ -85,6 +85,11 @@ class InsertExecutor : public OperationExecutor {
         bool m_partitionColumnIsString;
         bool m_multiPartition;
 
+        #ifdef ARIES
+        /** catalog id of the target table, identifies it in ARIES log records */
+        int32_t m_targetTableId;
+        #endif
+
         /** reference to the engine/context to store the number of modified tuples */
         VoltDBEngine* m_engine;
 };
@@ -102,6 +102,42 @@ assignTupleValueIndex(AbstractExpression *ae,
     return true;
 }
 
+bool
+assignTupleValueIndexes(const AbstractExpression *predicate,
+                        const std::string &oname,
+                        const std::string &iname)
+{
+    std::stack<const AbstractExpression*> stack;
+    while (predicate != NULL) {
+        const AbstractExpression *left = predicate->getLeft();
+        const AbstractExpression *right = predicate->getRight();
+
+        if (right != NULL) {
+            if (right->getExpressionType() == EXPRESSION_TYPE_VALUE_TUPLE) {
+                if (!assignTupleValueIndex(const_cast<AbstractExpression*>(right), oname, iname)) {
+                    return false;
+                }
+            }
+            // remember the right node - must visit its children
+            stack.push(right);
+        }
+        if (left != NULL) {
+            if (left->getExpressionType() == EXPRESSION_TYPE_VALUE_TUPLE) {
+                if (!assignTupleValueIndex(const_cast<AbstractExpression*>(left), oname, iname)) {
+                    return false;
+                }
+            }
+        }
+
+        predicate = left;
+        if (!predicate && !stack.empty()) {
+            predicate = stack.top();
+            stack.pop();
+        }
+    }
+    return true;
+}
+
 bool NestLoopExecutor::p_init(AbstractPlanNode* abstract_node, const catalog::Database* catalog_db, int* tempTableMemoryInBytes) {
     VOLT_TRACE("init NestLoop Executor");
     assert(tempTableMemoryInBytes);
@@ -146,40 +182,11 @@ bool NestLoopExecutor::p_init(AbstractPlanNode* abstract_node, const catalog::Da
     // table or inner table. Configure the predicate to use the correct
     // eval() tuple parameter. By convention, eval's first parameter
     // will always be the outer table and its second parameter the inner
-    const AbstractExpression *predicate = node->getPredicate();
-    std::stack<const AbstractExpression*> stack;
-    while (predicate != NULL) {
-        const AbstractExpression *left = predicate->getLeft();
-        const AbstractExpression *right = predicate->getRight();
-
-        if (right != NULL) {
-            if (right->getExpressionType() == EXPRESSION_TYPE_VALUE_TUPLE) {
-                if (!assignTupleValueIndex(const_cast<AbstractExpression*>(right),
-                                           node->getInputTables()[0]->name(),
-                                           node->getInputTables()[1]->name())) {
-                    delete [] columnNames;
-                    return false;
-                }
-            }
-            // remember the right node - must visit its children
-            stack.push(right);
-        }
-        if (left != NULL) {
-            if (left->getExpressionType() == EXPRESSION_TYPE_VALUE_TUPLE) {
-                if (!assignTupleValueIndex(const_cast<AbstractExpression*>(left),
-                                           node->getInputTables()[0]->name(),
-                                           node->getInputTables()[1]->name())) {
-                    delete [] columnNames;
-                    return false;
-                }
-            }
-        }
-
-        predicate = left;
-        if (!predicate && !stack.empty()) {
-            predicate = stack.top();
-            stack.pop();
-        }
+    if (!assignTupleValueIndexes(node->getPredicate(),
+                                 node->getInputTables()[0]->name(),
+                                 node->getInputTables()[1]->name())) {
+        delete [] columnNames;
+        return false;
     }
 
     delete[] columnNames;
@@ -46,6 +46,7 @@
 #ifndef HSTORENESTLOOPEXECUTOR_H
 #define HSTORENESTLOOPEXECUTOR_H
 
+#include <string>
 #include "common/common.h"
 #include "common/valuevector.h"
 #include "executors/abstractexecutor.h"
@@ -54,6 +55,15 @@ namespace voltdb {
 
 class UndoLog;
 class ReadWriteSet;
+class AbstractExpression;
+
+/**
+ * Point each tuple value expression in a join predicate at the outer
+ * (eval()'s first tuple) or inner (second tuple) table by its table name.
+ */
+bool assignTupleValueIndexes(const AbstractExpression *predicate,
+                             const std::string &oname,
+                             const std::string &iname);
 
 /**
  *
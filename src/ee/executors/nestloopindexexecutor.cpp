@@ -51,6 +51,7 @@
 #include "common/FatalException.hpp"
 #include "execution/VoltDBEngine.h"
 #include "expressions/abstractexpression.h"
+#include "expressions/compiledpredicate.h"
 #include "plannodes/nestloopindexnode.h"
 #include "plannodes/indexscannode.h"
 #include "storage/table.h"
@@ -197,6 +198,11 @@ bool NestLoopIndexExecutor::p_init(AbstractPlanNode* abstract_node,
     index_values.move( index_values_backing_store - TUPLE_HEADER_SIZE);
     index_values.setAllNulls();
 
+    m_endPredicate = CompiledPredicate::compile(inline_node->getEndExpression(),
+                                                output_table->schema(), NULL);
+    m_postPredicate = CompiledPredicate::compile(inline_node->getPredicate(),
+                                                 output_table->schema(), NULL);
+
     return true;
 }
 
@@ -242,6 +248,7 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params, ReadWriteTracke
     AbstractExpression* end_expression = inline_node->getEndExpression();
     if (end_expression) {
         end_expression->substitute(params);
+        m_endPredicate->bind();
         VOLT_TRACE("End Expression:\n%s", end_expression->debug(true).c_str());
     }
 
@@ -249,6 +256,7 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params, ReadWriteTracke
     AbstractExpression* post_expression = inline_node->getPredicate();
     if (post_expression != NULL) {
         post_expression->substitute(params);
+        m_postPredicate->bind();
         VOLT_TRACE("Post Expression:\n%s", post_expression->debug(true).c_str());
     }
     
@@ -319,7 +327,6 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params, ReadWriteTracke
         } else {
             return false;
         }
-
         bool match = false;
         while ((m_lookupType == INDEX_LOOKUP_TYPE_EQ &&
                 !(inner_tuple = index->nextValueAtKey()).isNullTuple()) ||
@@ -362,7 +369,7 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params, ReadWriteTracke
             // First check whether the end_expression is now false
             //
             if (end_expression != NULL &&
-                end_expression->eval(&join_tuple, NULL).isFalse()) {
+                m_endPredicate->isTrue(&join_tuple, NULL) == false) {
                 VOLT_TRACE("End Expression evaluated to false, stopping scan");
                 break;
             }
@@ -370,7 +377,7 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params, ReadWriteTracke
             // Then apply our post-predicate to do further filtering
             //
             if (post_expression == NULL ||
-                post_expression->eval(&join_tuple, NULL).isTrue()) {
+                m_postPredicate->isTrue(&join_tuple, NULL)) {
                 //
                 // Try to put the tuple into our output table
                 //
@@ -387,6 +394,15 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params, ReadWriteTracke
             }
         } // WHILE
 
+        #ifdef ANTICACHE
+        if (hasEvictedTable) {
+            eviction_manager->recordEvictedIndexAccess(inner_catalogTable, inner_table, index,
+                                                       &index_values, num_of_searchkeys, m_lookupType,
+                                                       (inner_tuple.isNullTuple() ? NULL : &inner_tuple),
+                                                       true);
+        }
+        #endif
+
         //
         // Left Outer Join
         //
@@ -416,5 +432,7 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params, ReadWriteTracke
 }
 
 NestLoopIndexExecutor::~NestLoopIndexExecutor() {
+    delete m_endPredicate;
+    delete m_postPredicate;
     delete [] index_values_backing_store;
 }
@@ -62,6 +62,7 @@ class PersistentTable;
 class Table;
 class TempTable;
 class TableIndex;
+class CompiledPredicate;
 
 /**
  * Nested loop for IndexScan.
@@ -85,6 +86,8 @@ public:
         index = NULL;
         outer_table = NULL;
         m_lookupType = INDEX_LOOKUP_TYPE_INVALID;
+        m_endPredicate = NULL;
+        m_postPredicate = NULL;
     }
 
     ~NestLoopIndexExecutor();
@@ -104,6 +107,10 @@ protected:
     Table* outer_table;
     JoinType join_type;
 
+    // the inline IndexScan's end and post expressions over the join tuple
+    CompiledPredicate *m_endPredicate;
+    CompiledPredicate *m_postPredicate;
+
     //So valgrind doesn't report the data as lost.
     char *index_values_backing_store;
 };
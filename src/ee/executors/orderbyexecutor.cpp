@@ -44,11 +44,13 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <vector>
 #include "orderbyexecutor.h"
 #include "common/debuglog.h"
 #include "common/common.h"
 #include "common/tabletuple.h"
+#include "common/ValuePeeker.hpp"
 #include "common/FatalException.hpp"
 #include "plannodes/orderbynode.h"
 #include "plannodes/limitnode.h"
@@ -60,6 +62,9 @@
 using namespace voltdb;
 using namespace std;
 
+/** Bytes of a string that make it into its normalized sort key */
+static const int SORT_KEY_STRING_PREFIX = 16;
+
 bool
 OrderByExecutor::p_init(AbstractPlanNode* abstract_node,
                         const catalog::Database* catalog_db,
@@ -102,6 +107,72 @@ OrderByExecutor::p_init(AbstractPlanNode* abstract_node,
     }
     node->setSortColumns(sortColumns);
 
+    //
+    // Fixed width and string sort columns are normalized into keys that
+    // sort with memcmp. Strings only keep a prefix, so the key ends after
+    // the first string column and keys that are equal up to there fall
+    // back to comparing the values.
+    //
+    const TupleSchema *schema = node->getInputTables()[0]->schema();
+    m_keyColumnWidths.clear();
+    m_keyWidth = 0;
+    m_keyExact = true;
+    for (int ii = 0; ii < sortColumns.size(); ii++)
+    {
+        int width = 0;
+        switch (schema->columnType(sortColumns[ii]))
+        {
+        case VALUE_TYPE_TINYINT:
+            width = sizeof(int8_t);
+            break;
+        case VALUE_TYPE_SMALLINT:
+            width = sizeof(int16_t);
+            break;
+        case VALUE_TYPE_INTEGER:
+            width = sizeof(int32_t);
+            break;
+        case VALUE_TYPE_BIGINT:
+        case VALUE_TYPE_TIMESTAMP:
+            width = sizeof(int64_t);
+            break;
+        case VALUE_TYPE_DOUBLE:
+            width = sizeof(double);
+            break;
+        case VALUE_TYPE_DECIMAL:
+            width = sizeof(TTInt);
+            break;
+        case VALUE_TYPE_VARCHAR:
+        {
+            int length = schema->columnLength(sortColumns[ii]);
+            if (length <= 0 || length > SORT_KEY_STRING_PREFIX) {
+                length = SORT_KEY_STRING_PREFIX;
+            }
+            // a leading byte puts NULL first
+            width = 1 + length;
+            m_keyExact = false;
+            break;
+        }
+        default:
+            break;
+        }
+        SortDirectionType dir = node->getSortDirections()[ii];
+        if (width == 0 ||
+            (dir != SORT_DIRECTION_TYPE_ASC && dir != SORT_DIRECTION_TYPE_DESC))
+        {
+            m_keyColumnWidths.clear();
+            m_keyWidth = 0;
+            break;
+        }
+        m_keyColumnWidths.push_back(width);
+        m_keyWidth += width;
+        if (!m_keyExact) {
+            break;
+        }
+    }
+    if (m_keyWidth > 0 && m_keyWidth < sizeof(uint64_t)) {
+        m_keyWidth = sizeof(uint64_t);
+    }
+
     //
     // Our output table should look exactly like out input table
     //
@@ -130,7 +201,7 @@ public:
         assert(keys.size() == dirs.size());
     }
 
-    bool operator()(TableTuple ta, TableTuple tb)
+    bool operator()(TableTuple ta, TableTuple tb) const
     {
         for (size_t i = 0; i < m_keyCount; ++i)
         {
@@ -163,6 +234,167 @@ private:
     size_t m_keyCount;
 };
 
+namespace {
+
+inline void writeBigEndian(uint64_t value, int bytes, char *key)
+{
+    for (int ii = bytes - 1; ii >= 0; ii--)
+    {
+        key[ii] = static_cast<char>(value & 0xff);
+        value >>= 8;
+    }
+}
+
+inline uint64_t readBigEndian(const char *key)
+{
+    uint64_t value = 0;
+    for (int ii = 0; ii < sizeof(uint64_t); ii++)
+    {
+        value = (value << 8) | static_cast<unsigned char>(key[ii]);
+    }
+    return value;
+}
+
+/** Signed integers sort as unsigned ones once the sign bit is flipped */
+inline void writeSigned(int64_t value, int bytes, char *key)
+{
+    writeBigEndian(static_cast<uint64_t>(value) ^ (1ULL << (bytes * 8 - 1)),
+                   bytes, key);
+}
+
+/** Positive doubles get their sign bit set, negative ones are inverted */
+inline void writeDouble(double value, char *key)
+{
+    if (value == 0) {
+        value = 0; // -0.0 == 0.0
+    }
+    uint64_t bits;
+    ::memcpy(&bits, &value, sizeof(bits));
+    bits = (bits & (1ULL << 63)) ? ~bits : (bits | (1ULL << 63));
+    writeBigEndian(bits, sizeof(bits), key);
+}
+
+/** A normalized sort key, its first 8 bytes as a number, and its tuple */
+struct SortEntry
+{
+    uint64_t prefix;
+    const char *key;
+    char *address;
+};
+
+inline SortEntry makeEntry(const char *key, char *address)
+{
+    SortEntry entry = { readBigEndian(key), key, address };
+    return entry;
+}
+
+class NormalizedKeyComparer
+{
+public:
+    NormalizedKeyComparer(int width, bool exact, const TupleSchema *schema,
+                          const TupleComparer &values)
+        : m_width(width), m_exact(exact), m_schema(schema), m_values(values)
+    {
+        assert(width >= sizeof(uint64_t));
+    }
+
+    bool operator()(const SortEntry &a, const SortEntry &b) const
+    {
+        if (a.prefix != b.prefix) {
+            return a.prefix < b.prefix;
+        }
+        int cmp = ::memcmp(a.key + sizeof(uint64_t), b.key + sizeof(uint64_t),
+                           m_width - sizeof(uint64_t));
+        if (cmp != 0 || m_exact) {
+            return cmp < 0;
+        }
+        return m_values(TableTuple(a.address, m_schema),
+                        TableTuple(b.address, m_schema));
+    }
+
+private:
+    int m_width;
+    bool m_exact;
+    const TupleSchema *m_schema;
+    TupleComparer m_values;
+};
+
+}
+
+void
+OrderByExecutor::normalize(const TableTuple &tuple, char *key) const
+{
+    OrderByPlanNode* node = static_cast<OrderByPlanNode*>(abstract_node);
+    const vector<int> &columns = node->getSortColumns();
+    const vector<SortDirectionType> &dirs = node->getSortDirections();
+    char *end = key + m_keyWidth;
+    for (int ii = 0; ii < m_keyColumnWidths.size(); ii++)
+    {
+        const int width = m_keyColumnWidths[ii];
+        const NValue value = tuple.getNValue(columns[ii]);
+        // the NULL of the numeric types is their smallest value
+        switch (ValuePeeker::peekValueType(value))
+        {
+        case VALUE_TYPE_TINYINT:
+            writeSigned(ValuePeeker::peekTinyInt(value), width, key);
+            break;
+        case VALUE_TYPE_SMALLINT:
+            writeSigned(ValuePeeker::peekSmallInt(value), width, key);
+            break;
+        case VALUE_TYPE_INTEGER:
+            writeSigned(ValuePeeker::peekInteger(value), width, key);
+            break;
+        case VALUE_TYPE_BIGINT:
+            writeSigned(ValuePeeker::peekBigInt(value), width, key);
+            break;
+        case VALUE_TYPE_TIMESTAMP:
+            writeSigned(ValuePeeker::peekTimestamp(value), width, key);
+            break;
+        case VALUE_TYPE_DOUBLE:
+            writeDouble(ValuePeeker::peekDouble(value), key);
+            break;
+        case VALUE_TYPE_DECIMAL:
+        {
+            const TTInt decimal = ValuePeeker::peekDecimal(value);
+            writeSigned(static_cast<int64_t>(decimal.table[1]), sizeof(int64_t), key);
+            writeBigEndian(decimal.table[0], sizeof(int64_t), key + sizeof(int64_t));
+            break;
+        }
+        case VALUE_TYPE_VARCHAR:
+        {
+            // strings compare with strncmp, so a NUL ends the prefix
+            int copied = 0;
+            if (value.isNull()) {
+                key[0] = 0;
+            } else {
+                key[0] = 1;
+                const char *data =
+                    reinterpret_cast<const char*>(ValuePeeker::peekObjectValue(value));
+                const int length =
+                    std::min(ValuePeeker::peekObjectLength(value), width - 1);
+                while (copied < length && data[copied] != '\0') {
+                    key[1 + copied] = data[copied];
+                    copied++;
+                }
+            }
+            ::memset(key + 1 + copied, 0, width - 1 - copied);
+            break;
+        }
+        default:
+            throwFatalException("Sort column %d can not be normalized",
+                                columns[ii]);
+        }
+        if (dirs[ii] == SORT_DIRECTION_TYPE_DESC)
+        {
+            for (int jj = 0; jj < width; jj++) {
+                key[jj] = static_cast<char>(~key[jj]);
+            }
+        }
+        key += width;
+    }
+    ::memset(key, 0, end - key);
+}
+
 bool
 OrderByExecutor::p_execute(const NValueArray &params, ReadWriteTracker *tracker)
 {
@@ -175,7 +407,8 @@ OrderByExecutor::p_execute(const NValueArray &params, ReadWriteTracker *tracker)
 
     //
     // OPTIMIZATION: NESTED LIMIT
-    // How nice! We can also cut off our scanning with a nested limit!
+    // How nice! Only the first limit tuples need to be kept in order, so
+    // they are picked with a bounded heap instead of sorting everything.
     //
     int limit = -1;
     int offset = -1;
@@ -189,27 +422,128 @@ OrderByExecutor::p_execute(const NValueArray &params, ReadWriteTracker *tracker)
             return false;
         }
     }
+    if (limit == 0)
+    {
+        return true;
+    }
+    if (limit >= input_table->activeTupleCount())
+    {
+        limit = -1;
+    }
 
     VOLT_TRACE("Running OrderBy '%s'", abstract_node->debug().c_str());
     VOLT_TRACE("Input Table:\n '%s'", input_table->debug().c_str());
+    bool success = (m_keyWidth > 0) ?
+        sortNormalized(input_table, output_table, limit) :
+        sortTuples(input_table, output_table, limit);
+    VOLT_TRACE("Result of OrderBy:\n '%s'", output_table->debug().c_str());
+
+    return success;
+}
+
+bool
+OrderByExecutor::sortNormalized(Table *input_table, Table *output_table,
+                                int limit)
+{
+    OrderByPlanNode* node = static_cast<OrderByPlanNode*>(abstract_node);
+    NormalizedKeyComparer comparer(m_keyWidth, m_keyExact,
+                                   input_table->schema(),
+                                   TupleComparer(node->getSortColumns(),
+                                                 node->getSortDirections()));
+    const bool topK = (limit > 0);
+    const size_t capacity = topK ? limit : input_table->activeTupleCount();
+
+    // one more key than entries, for the candidates a full heap turns down
+    vector<char> keys((capacity + 1) * m_keyWidth);
+    char *spare = &keys[capacity * m_keyWidth];
+    vector<SortEntry> xs;
+    xs.reserve(capacity);
+
+    TableIterator iterator(input_table);
+    TableTuple tuple(input_table->schema());
+    while (iterator.next(tuple))
+    {
+        assert(tuple.isActive());
+        if (xs.size() < capacity)
+        {
+            char *key = &keys[xs.size() * m_keyWidth];
+            normalize(tuple, key);
+            xs.push_back(makeEntry(key, tuple.address()));
+            if (topK) {
+                push_heap(xs.begin(), xs.end(), comparer);
+            }
+            continue;
+        }
+        assert(topK);
+
+        // the heap keeps the best tuples so far, the worst of them on top
+        normalize(tuple, spare);
+        SortEntry entry = makeEntry(spare, tuple.address());
+        if (!comparer(entry, xs.front())) {
+            continue;
+        }
+        pop_heap(xs.begin(), xs.end(), comparer);
+        spare = const_cast<char*>(xs.back().key);
+        xs.back() = entry;
+        push_heap(xs.begin(), xs.end(), comparer);
+    }
+    if (topK) {
+        sort_heap(xs.begin(), xs.end(), comparer);
+    } else {
+        sort(xs.begin(), xs.end(), comparer);
+    }
+
+    TableTuple sorted(input_table->schema());
+    for (vector<SortEntry>::iterator it = xs.begin(); it != xs.end(); it++)
+    {
+        sorted.move(it->address);
+        if (!output_table->insertTuple(sorted))
+        {
+            VOLT_ERROR("Failed to insert order-by tuple from input table '%s'"
+                       " into output table '%s'",
+                       input_table->name().c_str(),
+                       output_table->name().c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+OrderByExecutor::sortTuples(Table *input_table, Table *output_table, int limit)
+{
+    OrderByPlanNode* node = static_cast<OrderByPlanNode*>(abstract_node);
+    TupleComparer comparer(node->getSortColumns(), node->getSortDirections());
+    const bool topK = (limit > 0);
+
     TableIterator iterator(input_table);
     TableTuple tuple(input_table->schema());
     vector<TableTuple> xs;
     while (iterator.next(tuple))
     {
         assert(tuple.isActive());
-        xs.push_back(tuple);
+        if (!topK || xs.size() < limit)
+        {
+            xs.push_back(tuple);
+            if (topK) {
+                push_heap(xs.begin(), xs.end(), comparer);
+            }
+        }
+        else if (comparer(tuple, xs.front()))
+        {
+            pop_heap(xs.begin(), xs.end(), comparer);
+            xs.back() = tuple;
+            push_heap(xs.begin(), xs.end(), comparer);
+        }
+    }
+    if (topK) {
+        sort_heap(xs.begin(), xs.end(), comparer);
+    } else {
+        sort(xs.begin(), xs.end(), comparer);
     }
-    VOLT_TRACE("\n***** Input Table PreSort:\n '%s'",
-               input_table->debug().c_str());
-    sort(xs.begin(), xs.end(), TupleComparer(node->getSortColumns(),
-                                             node->getSortDirections()));
 
-    int tuple_ctr = 0;
     for (vector<TableTuple>::iterator it = xs.begin(); it != xs.end(); it++)
     {
-        VOLT_TRACE("\n***** Input Table PostSort:\n '%s'",
-                   input_table->debug().c_str());
         if (!output_table->insertTuple(*it))
         {
             VOLT_ERROR("Failed to insert order-by tuple from input table '%s'"
@@ -218,15 +552,7 @@ OrderByExecutor::p_execute(const NValueArray &params, ReadWriteTracker *tracker)
                        output_table->name().c_str());
             return false;
         }
-        //
-        // Check whether we have gone past our limit
-        //
-        if (limit >= 0 && ++tuple_ctr >= limit) {
-            break;
-        }
     }
-    VOLT_TRACE("Result of OrderBy:\n '%s'", output_table->debug().c_str());
-
     return true;
 }
 
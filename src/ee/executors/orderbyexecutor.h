@@ -46,6 +46,7 @@
 #ifndef HSTOREORDERBYEXECUTOR_H
 #define HSTOREORDERBYEXECUTOR_H
 
+#include <vector>
 #include "common/common.h"
 #include "common/valuevector.h"
 #include "executors/abstractexecutor.h"
@@ -62,17 +63,39 @@ namespace voltdb {
     class OrderByExecutor : public AbstractExecutor {
     public:
         OrderByExecutor(VoltDBEngine *engine, AbstractPlanNode* abstract_node)
-            : AbstractExecutor(engine, abstract_node), limit_node(NULL)
+            : AbstractExecutor(engine, abstract_node), limit_node(NULL),
+              m_keyWidth(0), m_keyExact(true)
             { }
         ~OrderByExecutor();
 
+        /**
+         * Width in bytes of the normalized sort keys, 0 when the sort
+         * columns can not be normalized and TupleComparer is used instead
+         */
+        int keyWidth() const { return m_keyWidth; }
+
     protected:
         bool p_init(AbstractPlanNode* abstract_node,
                     const catalog::Database* catalog_db, int* tempTableMemoryInBytes);
         bool p_execute(const NValueArray &params, ReadWriteTracker *tracker);
 
     private:
+        /**
+         * Write the normalized sort key of the tuple. Keys compare with
+         * memcmp in the same order TupleComparer puts their tuples.
+         */
+        void normalize(const TableTuple &tuple, char *key) const;
+
+        bool sortNormalized(Table *input_table, Table *output_table, int limit);
+        bool sortTuples(Table *input_table, Table *output_table, int limit);
+
         LimitPlanNode *limit_node;
+
+        /** Key bytes of each sort column, in sort column order */
+        std::vector<int> m_keyColumnWidths;
+        int m_keyWidth;
+        /** False if the key ends with a string prefix, equal keys are then compared by value */
+        bool m_keyExact;
     };
 
 }
@@ -50,10 +50,12 @@
 #include "common/tabletuple.h"
 #include "common/FatalException.hpp"
 #include "expressions/abstractexpression.h"
+#include "expressions/compiledpredicate.h"
 #include "plannodes/seqscannode.h"
 #include "plannodes/projectionnode.h"
 #include "plannodes/limitnode.h"
 #include "storage/table.h"
+#include "storage/ColumnarBlocks.h"
 #include "storage/persistenttable.h"
 #include "storage/temptable.h"
 #include "storage/tablefactory.h"
@@ -124,9 +126,15 @@ bool SeqScanExecutor::p_init(AbstractPlanNode *abstract_node,
                     tempTableMemoryInBytes));
         }
     }
+
+    m_predicate = CompiledPredicate::compile(node->getPredicate(), target_table->schema(), NULL);
     return true;
 }
 
+SeqScanExecutor::~SeqScanExecutor() {
+    delete m_predicate;
+}
+
 bool SeqScanExecutor::needsOutputTableClear() {
     // clear the temporary output table only when it has a predicate.
     // if it doesn't have a predicate, it's the original persistent table
@@ -208,74 +216,125 @@ bool SeqScanExecutor::p_execute(const NValueArray &params, ReadWriteTracker *tra
             VOLT_DEBUG("SCAN PREDICATE A:\n%s\n", predicate->debug(true).c_str());
             predicate->substitute(params);
             assert(predicate != NULL);
+            m_predicate->bind();
             VOLT_DEBUG("SCAN PREDICATE B:\n%s\n",
                        predicate->debug(true).c_str());
         }
 
+        // The predicate is evaluated over batches of tuples at a time, which
+        // lets simple comparisons run as tight loops over a column. The rest
+        // of the predicate runs as the kernels it was compiled into in
+        // p_init(), and the rest of the work still happens one tuple at a
+        // time, in table order.
+        // With a columnar layout each batch comes from a single block and
+        // the comparisons read the block's minipages instead of the rows.
+        char *batch[EXPRESSION_BATCH_SIZE];
+        int selection[EXPRESSION_BATCH_SIZE];
+        int batch_slots[EXPRESSION_BATCH_SIZE];
+        ColumnarBlocks *columns = target_table->getColumnarBlocks();
+        ColumnarBatch columnar_batch = { columns, 0, batch_slots };
+        int next_slot = 0;
+        if (columns != NULL) {
+            columns->sync();
+        }
         int tuple_ctr = 0;
-        while (iterator.next(tuple)) {
-            target_table->updateTupleAccessCount();
-            
-            // Read/Write Set Tracking
-            if (tracker != NULL) {
-                tracker->markTupleRead(target_table, &tuple);
+        bool done = false;
+        while (!done) {
+            // With an inline limit, don't pull in more tuples than could
+            // still make it into the output
+            int batch_size = EXPRESSION_BATCH_SIZE;
+            if (limit >= 0 && limit - tuple_ctr < batch_size) {
+                batch_size = limit - tuple_ctr;
+            }
+            int count = 0;
+            if (batch_size <= 0) {
+                break;
+            } else if (columns != NULL) {
+                count = columns->nextBatch(columnar_batch.block, next_slot,
+                                           batch, batch_slots, batch_size);
+            } else {
+                while (count < batch_size && iterator.next(tuple)) {
+                    batch[count++] = tuple.address();
+                }
+            }
+            if (count == 0) {
+                break;
+            }
+            for (int i = 0; i < count; i++) {
+                selection[i] = i;
             }
+            int selected = (predicate == NULL) ? count :
+                m_predicate->evalBatch(batch, selection, count,
+                                       (columns != NULL) ? &columnar_batch : NULL);
+
+            int next_selected = 0;
+            for (int i = 0; i < count && !done; i++) {
+                tuple.move(batch[i]);
+                target_table->updateTupleAccessCount();
+            
+                // Read/Write Set Tracking
+                if (tracker != NULL) {
+                    tracker->markTupleRead(target_table, &tuple);
+                }
             
-            // No tuple that we find here should *ever* be evicted!!
-            #ifdef ANTICACHE
-            assert(tuple.isEvicted() == false);
-            #endif
+                // No tuple that we find here should *ever* be evicted!!
+                #ifdef ANTICACHE
+                assert(tuple.isEvicted() == false);
+                #endif
             
-            VOLT_DEBUG("INPUT TUPLE: %s, %d/%d\n",
-                       tuple.debug(target_table->name()).c_str(), tuple_ctr,
-                       (int)target_table->activeTupleCount());
-            //
-            // For each tuple we need to evaluate it against our predicate
-            //
-            if (predicate == NULL || predicate->eval(&tuple, NULL).isTrue()) {
+                VOLT_DEBUG("INPUT TUPLE: %s, %d/%d\n",
+                           tuple.debug(target_table->name()).c_str(), tuple_ctr,
+                           (int)target_table->activeTupleCount());
                 //
-                // Nested Projection
-                // Project (or replace) values from input tuple
+                // The predicate has already been evaluated for the batch
                 //
-                if (projection_node != NULL) {
-                    TableTuple &temp_tuple = output_table->tempTuple();
-                    for (int ctr = 0; ctr < num_of_columns; ctr++) {
-                        NValue value =
-                            projection_node->
-                          getOutputColumnExpressions()[ctr]->eval(&tuple, NULL);
-                        temp_tuple.setNValue(ctr, value);
-                    }
-                    if (!output_table->insertTuple(temp_tuple)) {
-                        VOLT_ERROR("Failed to insert tuple from table '%s' into"
-                                   " output table '%s'",
-                                   target_table->name().c_str(),
-                                   output_table->name().c_str());
-                        return false;
-                    }
-                } else {
+                if (next_selected < selected && selection[next_selected] == i) {
+                    ++next_selected;
                     //
-                    // Insert the tuple into our output table
+                    // Nested Projection
+                    // Project (or replace) values from input tuple
                     //
-                    if (!output_table->insertTuple(tuple)) {
-                        VOLT_ERROR("Failed to insert tuple from table '%s' into"
-                                   " output table '%s'",
-                                   target_table->name().c_str(),
-                                   output_table->name().c_str());
-                        return false;
+                    if (projection_node != NULL) {
+                        TableTuple &temp_tuple = output_table->tempTuple();
+                        for (int ctr = 0; ctr < num_of_columns; ctr++) {
+                            NValue value =
+                                projection_node->
+                              getOutputColumnExpressions()[ctr]->eval(&tuple, NULL);
+                            temp_tuple.setNValue(ctr, value);
+                        }
+                        if (!output_table->insertTuple(temp_tuple)) {
+                            VOLT_ERROR("Failed to insert tuple from table '%s' into"
+                                       " output table '%s'",
+                                       target_table->name().c_str(),
+                                       output_table->name().c_str());
+                            return false;
+                        }
+                    } else {
+                        //
+                        // Insert the tuple into our output table
+                        //
+                        if (!output_table->insertTuple(tuple)) {
+                            VOLT_ERROR("Failed to insert tuple from table '%s' into"
+                                       " output table '%s'",
+                                       target_table->name().c_str(),
+                                       output_table->name().c_str());
+                            return false;
+                        }
                     }
-                }
-                ++tuple_ctr;
+                    ++tuple_ctr;
                 
-                #ifdef ANTICACHE
-                if (hasEvictedTable) {
-                    // update the tuple in the LRU eviction chain
-                    eviction_manager->updateTuple(target_table, &tuple, false);
-                }
-                #endif
+                    #ifdef ANTICACHE
+                    if (hasEvictedTable) {
+                        // update the tuple in the LRU eviction chain
+                        eviction_manager->updateTuple(target_table, &tuple, false);
+                    }
+                    #endif
                 
-                // Check whether we have gone past our limit
-                if (limit >= 0 && tuple_ctr >= limit) {
-                    break;
+                    // Check whether we have gone past our limit
+                    if (limit >= 0 && tuple_ctr >= limit) {
+                        done = true;
+                        break;
+                    }
                 }
             }
         } // WHILE
@@ -55,12 +55,14 @@ namespace voltdb
 {
     class UndoLog;
     class ReadWriteSet;
+    class CompiledPredicate;
 
     class SeqScanExecutor : public AbstractExecutor {
     public:
         SeqScanExecutor(VoltDBEngine *engine, AbstractPlanNode* abstract_node)
-            : AbstractExecutor(engine, abstract_node)
+            : AbstractExecutor(engine, abstract_node), m_predicate(NULL)
         {}
+        ~SeqScanExecutor();
     protected:
         bool p_init(AbstractPlanNode* abstract_node,
                     const catalog::Database* catalog_db, int* tempTableMemoryInBytes);
@@ -68,6 +70,7 @@ namespace voltdb
         bool needsOutputTableClear();
         
         catalog::Table* m_catalogTable;
+        CompiledPredicate *m_predicate;
     };
 }
 
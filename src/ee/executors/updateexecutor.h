@@ -90,6 +90,13 @@ class UpdateExecutor : public OperationExecutor {
         bool m_partitionColumnIsString;
         bool m_updatesIndexes;
 
+        #ifdef ARIES
+        /** catalog id of the target table, identifies it in ARIES log records */
+        int32_t m_targetTableId;
+        /** target table columns changed by this update */
+        std::vector<int32_t> m_modifiedCols;
+        #endif
+
         /** reference to the engine/context to store the number of modified tuples */
         VoltDBEngine* m_engine;
 };
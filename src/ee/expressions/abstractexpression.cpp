@@ -48,6 +48,7 @@
 #include "common/debuglog.h"
 #include "common/serializeio.h"
 #include "common/types.h"
+#include "common/tabletuple.h"
 #include "expressions/expressionutil.h"
 
 #include <sstream>
@@ -106,6 +107,22 @@ AbstractExpression::substitute(const NValueArray &params)
     }
 }
 
+int
+AbstractExpression::evalBatch(const TupleSchema *schema, char * const *tuples,
+                              int *selection, int count,
+                              const ColumnarBatch *columns) const
+{
+    TableTuple tuple(schema);
+    int selected = 0;
+    for (int i = 0; i < count; i++) {
+        tuple.move(tuples[selection[i]]);
+        if (eval(&tuple, NULL).isTrue()) {
+            selection[selected++] = selection[i];
+        }
+    }
+    return selected;
+}
+
 bool
 AbstractExpression::hasParameter() const
 {
@@ -54,12 +54,17 @@
 #include <vector>
 #include "json_spirit/json_spirit.h"
 
+/** Most tuples evalBatch() is asked to filter at once */
+#define EXPRESSION_BATCH_SIZE 1024
+
 namespace voltdb {
 
 class SerializeInput;
 class SerializeOutput;
 class NValue;
 class TableTuple;
+class TupleSchema;
+struct ColumnarBatch;
 
 /**
  * Predicate objects for filtering tuples during query execution.
@@ -77,6 +82,19 @@ class AbstractExpression {
 
     virtual NValue eval(const TableTuple *tuple1, const TableTuple *tuple2) const = 0;
 
+    /**
+     * Evaluate this expression as a predicate over a batch of tuples with
+     * the given schema. selection holds the ascending indexes into tuples
+     * of the count candidates (at most EXPRESSION_BATCH_SIZE); it is
+     * narrowed in place to those the predicate holds for and the new
+     * count is returned. The default calls eval() on each tuple,
+     * comparisons of a column with a constant and conjunctions do better.
+     * columns, when given, has the batch's columns laid out in minipages.
+     */
+    virtual int evalBatch(const TupleSchema *schema, char * const *tuples,
+                          int *selection, int count,
+                          const ColumnarBatch *columns = NULL) const;
+
     /** set parameter values for this node and its descendents */
     virtual void substitute(const NValueArray &params);
 
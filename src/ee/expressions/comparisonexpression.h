@@ -49,41 +49,224 @@
 #include "common/common.h"
 #include "common/serializeio.h"
 #include "common/valuevector.h"
+#include "common/tabletuple.h"
+#include "common/TupleSchema.h"
+#include "common/ValuePeeker.hpp"
 
 #include "expressions/abstractexpression.h"
 #include "expressions/parametervalueexpression.h"
 #include "expressions/constantvalueexpression.h"
 #include "expressions/tuplevalueexpression.h"
+#include "storage/ColumnarBlocks.h"
 
 #include <string>
 
 namespace voltdb {
 
+// holds() gives the same answer as cmp() does through NValue::compare(),
+// which treats "neither equal nor greater" as less (so NaN < anything)
 class CmpEq {
 public:
     inline NValue cmp(NValue l, NValue r) const { return l.op_equals(r);}
+    template <typename T> static inline bool holds(T l, T r) { return l == r; }
 };
 class CmpNe {
 public:
     inline NValue cmp(NValue l, NValue r) const { return l.op_notEquals(r);}
+    template <typename T> static inline bool holds(T l, T r) { return !(l == r); }
 };
 class CmpLt {
 public:
     inline NValue cmp(NValue l, NValue r) const { return l.op_lessThan(r);}
+    template <typename T> static inline bool holds(T l, T r) { return !(l == r) && !(l > r); }
 };
 class CmpGt {
 public:
     inline NValue cmp(NValue l, NValue r) const { return l.op_greaterThan(r);}
+    template <typename T> static inline bool holds(T l, T r) { return l > r; }
 };
 class CmpLte {
 public:
     inline NValue cmp(NValue l, NValue r) const { return l.op_lessThanOrEqual(r);}
+    template <typename T> static inline bool holds(T l, T r) { return !(l > r); }
 };
 class CmpGte {
 public:
     inline NValue cmp(NValue l, NValue r) const { return l.op_greaterThanOrEqual(r);}
+    template <typename T> static inline bool holds(T l, T r) { return (l == r) || (l > r); }
 };
 
+/**
+ * Batch kernels for a comparison between a numeric column and a value that
+ * is the same for every tuple (a constant or a parameter). The column is
+ * gathered into a contiguous array, widened the way NValue::compare()
+ * widens it, so that the comparison loop has no branches and is vectorized
+ * by the compiler. The selection is then narrowed without branches either.
+ */
+namespace comparisonbatch {
+
+template <typename S, typename T>
+inline void gather(char * const *tuples, const int *selection, int count,
+                   uint32_t offset, S nullValue, T widenedNull, T *values) {
+    for (int i = 0; i < count; i++) {
+        S value = *reinterpret_cast<const S*>(tuples[selection[i]] + TUPLE_HEADER_SIZE + offset);
+        values[i] = (value == nullValue) ? widenedNull : static_cast<T>(value);
+    }
+}
+
+/** Gather an integer or timestamp column as bigints, false for other types */
+inline bool gatherBigInts(ValueType type, char * const *tuples, const int *selection,
+                          int count, uint32_t offset, int64_t *values) {
+    switch (type) {
+      case VALUE_TYPE_TINYINT:
+        gather<int8_t, int64_t>(tuples, selection, count, offset, INT8_NULL, INT64_NULL, values);
+        return true;
+      case VALUE_TYPE_SMALLINT:
+        gather<int16_t, int64_t>(tuples, selection, count, offset, INT16_NULL, INT64_NULL, values);
+        return true;
+      case VALUE_TYPE_INTEGER:
+        gather<int32_t, int64_t>(tuples, selection, count, offset, INT32_NULL, INT64_NULL, values);
+        return true;
+      case VALUE_TYPE_BIGINT:
+      case VALUE_TYPE_TIMESTAMP:
+        gather<int64_t, int64_t>(tuples, selection, count, offset, INT64_NULL, INT64_NULL, values);
+        return true;
+      default:
+        return false;
+    }
+}
+
+/** Gather a numeric column as doubles, nulls become DOUBLE_MIN as castAsDouble() does */
+inline bool gatherDoubles(ValueType type, char * const *tuples, const int *selection,
+                          int count, uint32_t offset, double *values) {
+    switch (type) {
+      case VALUE_TYPE_TINYINT:
+        gather<int8_t, double>(tuples, selection, count, offset, INT8_NULL, DOUBLE_MIN, values);
+        return true;
+      case VALUE_TYPE_SMALLINT:
+        gather<int16_t, double>(tuples, selection, count, offset, INT16_NULL, DOUBLE_MIN, values);
+        return true;
+      case VALUE_TYPE_INTEGER:
+        gather<int32_t, double>(tuples, selection, count, offset, INT32_NULL, DOUBLE_MIN, values);
+        return true;
+      case VALUE_TYPE_BIGINT:
+      case VALUE_TYPE_TIMESTAMP:
+        gather<int64_t, double>(tuples, selection, count, offset, INT64_NULL, DOUBLE_MIN, values);
+        return true;
+      case VALUE_TYPE_DOUBLE:
+        gather<double, double>(tuples, selection, count, offset, DOUBLE_MIN, DOUBLE_MIN, values);
+        return true;
+      default:
+        return false;
+    }
+}
+
+/** Gather a column out of its minipage, columns->blocks has to have one for it */
+inline void gatherBigInts(const ColumnarBatch *columns, int column, const int *selection,
+                          int count, int64_t *values) {
+    const int64_t *minipage = columns->blocks->bigInts(columns->block, column);
+    for (int i = 0; i < count; i++) {
+        values[i] = minipage[columns->slots[selection[i]]];
+    }
+}
+
+inline void gatherDoubles(const ColumnarBatch *columns, int column, const int *selection,
+                          int count, double *values) {
+    if (columns->blocks->isDouble(column)) {
+        const double *minipage = columns->blocks->doubles(columns->block, column);
+        for (int i = 0; i < count; i++) {
+            values[i] = minipage[columns->slots[selection[i]]];
+        }
+        return;
+    }
+    const int64_t *minipage = columns->blocks->bigInts(columns->block, column);
+    for (int i = 0; i < count; i++) {
+        int64_t value = minipage[columns->slots[selection[i]]];
+        values[i] = (value == INT64_NULL) ? DOUBLE_MIN : static_cast<double>(value);
+    }
+}
+
+template <typename C, bool COLUMN_ON_LEFT, typename T>
+inline int select(const T *values, T constant, int *selection, int count) {
+    char matches[EXPRESSION_BATCH_SIZE];
+    for (int i = 0; i < count; i++) {
+        matches[i] = COLUMN_ON_LEFT ? C::template holds<T>(values[i], constant)
+                                    : C::template holds<T>(constant, values[i]);
+    }
+    int selected = 0;
+    for (int i = 0; i < count; i++) {
+        selection[selected] = selection[i];
+        selected += matches[i];
+    }
+    return selected;
+}
+
+inline bool isIntegral(ValueType type) {
+    return type == VALUE_TYPE_TINYINT || type == VALUE_TYPE_SMALLINT ||
+           type == VALUE_TYPE_INTEGER || type == VALUE_TYPE_BIGINT ||
+           type == VALUE_TYPE_TIMESTAMP;
+}
+
+/**
+ * Narrow the selection if one side is a column of the outer tuple and the
+ * other a constant or parameter of a numeric type. The column is read out
+ * of its minipage when the batch comes with one. Returns -1 when the
+ * operands don't fit a kernel.
+ */
+template <typename C>
+int evalBatch(const AbstractExpression *left, const AbstractExpression *right,
+              const TupleSchema *schema, char * const *tuples, int *selection, int count,
+              const ColumnarBatch *columns) {
+    const TupleValueExpression *column = dynamic_cast<const TupleValueExpression*>(left);
+    const AbstractExpression *other = right;
+    bool columnOnLeft = true;
+    if (column == NULL) {
+        column = dynamic_cast<const TupleValueExpression*>(right);
+        other = left;
+        columnOnLeft = false;
+    }
+    if (column == NULL || column->getTupleIndex() != 0 ||
+        (dynamic_cast<const ConstantValueExpression*>(other) == NULL &&
+         dynamic_cast<const ParameterValueExpression*>(other) == NULL)) {
+        return -1;
+    }
+
+    const NValue constant = other->eval(NULL, NULL);
+    const ValueType constantType = ValuePeeker::peekValueType(constant);
+    const ValueType columnType = schema->columnType(column->getColumnId());
+    const uint32_t offset = schema->columnOffset(column->getColumnId());
+    if (columns != NULL && columns->blocks->hasColumn(column->getColumnId()) == false) {
+        columns = NULL;
+    }
+
+    if (isIntegral(columnType) && isIntegral(constantType)) {
+        int64_t values[EXPRESSION_BATCH_SIZE];
+        if (columns != NULL) {
+            gatherBigInts(columns, column->getColumnId(), selection, count, values);
+        } else {
+            gatherBigInts(columnType, tuples, selection, count, offset, values);
+        }
+        int64_t value = ValuePeeker::peekAsBigInt(constant);
+        return columnOnLeft ? select<C, true>(values, value, selection, count)
+                            : select<C, false>(values, value, selection, count);
+    }
+    if ((columnType == VALUE_TYPE_DOUBLE && (isIntegral(constantType) || constantType == VALUE_TYPE_DOUBLE)) ||
+        (isIntegral(columnType) && constantType == VALUE_TYPE_DOUBLE)) {
+        double values[EXPRESSION_BATCH_SIZE];
+        if (columns != NULL) {
+            gatherDoubles(columns, column->getColumnId(), selection, count, values);
+        } else {
+            gatherDoubles(columnType, tuples, selection, count, offset, values);
+        }
+        double value = ValuePeeker::peekDouble(constant.castAs(VALUE_TYPE_DOUBLE));
+        return columnOnLeft ? select<C, true>(values, value, selection, count)
+                            : select<C, false>(values, value, selection, count);
+    }
+    return -1;
+}
+
+}
+
 template <typename C>
 class ComparisonExpression : public AbstractExpression {
 public:
@@ -112,6 +295,12 @@ public:
             this->m_right->eval(tuple1, tuple2));
     }
 
+    int evalBatch(const TupleSchema *schema, char * const *tuples, int *selection, int count,
+                  const ColumnarBatch *columns = NULL) const {
+        int selected = comparisonbatch::evalBatch<C>(m_left, m_right, schema, tuples, selection, count, columns);
+        return (selected >= 0) ? selected : AbstractExpression::evalBatch(schema, tuples, selection, count);
+    }
+
     std::string debugInfo(const std::string &spacer) const {
         return (spacer + "ComparisonExpression\n");
     }
@@ -145,6 +334,12 @@ public:
             this->m_right->eval(tuple1, tuple2));
     }
 
+    int evalBatch(const TupleSchema *schema, char * const *tuples, int *selection, int count,
+                  const ColumnarBatch *columns = NULL) const {
+        int selected = comparisonbatch::evalBatch<C>(m_left, m_right, schema, tuples, selection, count, columns);
+        return (selected >= 0) ? selected : AbstractExpression::evalBatch(schema, tuples, selection, count);
+    }
+
     std::string debugInfo(const std::string &spacer) const {
         return (spacer + "OptimizedInlinedComparisonExpression\n");
     }
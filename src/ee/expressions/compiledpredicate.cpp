@@ -0,0 +1,366 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "expressions/compiledpredicate.h"
+
+#include "common/NValue.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/debuglog.h"
+#include "common/tabletuple.h"
+#include "common/TupleSchema.h"
+#include "expressions/abstractexpression.h"
+#include "expressions/comparisonexpression.h"
+#include "expressions/constantvalueexpression.h"
+#include "expressions/parametervalueexpression.h"
+#include "expressions/tuplevalueexpression.h"
+
+#include <algorithm>
+
+namespace voltdb {
+namespace compiledpredicate {
+
+using comparisonbatch::isIntegral;
+
+// Nulls are widened the way comparisonbatch::gather() widens them
+template <typename S> struct Null;
+template <> struct Null<int8_t> { static inline int8_t value() { return INT8_NULL; } };
+template <> struct Null<int16_t> { static inline int16_t value() { return INT16_NULL; } };
+template <> struct Null<int32_t> { static inline int32_t value() { return INT32_NULL; } };
+template <> struct Null<int64_t> { static inline int64_t value() { return INT64_NULL; } };
+template <> struct Null<double> { static inline double value() { return DOUBLE_MIN; } };
+
+/** A column stored as S, read as T */
+template <typename S, typename T>
+struct Column {
+    static inline T get(const Operand &operand, const TableTuple *tuple1, const TableTuple *tuple2) {
+        const TableTuple *tuple = (operand.tupleIndex == 0) ? tuple1 : tuple2;
+        S value = *reinterpret_cast<const S*>(tuple->address() + TUPLE_HEADER_SIZE + operand.offset);
+        return (value == Null<S>::value()) ? Null<T>::value() : static_cast<T>(value);
+    }
+};
+
+/** A constant or parameter copied by bind() */
+template <typename T> struct Bound;
+template <> struct Bound<int64_t> {
+    static inline int64_t get(const Operand &operand, const TableTuple*, const TableTuple*) {
+        return operand.bigint;
+    }
+};
+template <> struct Bound<double> {
+    static inline double get(const Operand &operand, const TableTuple*, const TableTuple*) {
+        return operand.dbl;
+    }
+};
+
+template <typename C, typename L, typename R>
+bool compare(const Node *node, const TableTuple *tuple1, const TableTuple *tuple2) {
+    return C::holds(L::get(node->leftOperand, tuple1, tuple2),
+                    R::get(node->rightOperand, tuple1, tuple2));
+}
+
+bool conjunctionAnd(const Node *node, const TableTuple *tuple1, const TableTuple *tuple2) {
+    return node->left->kernel(node->left, tuple1, tuple2) &&
+           node->right->kernel(node->right, tuple1, tuple2);
+}
+
+bool conjunctionOr(const Node *node, const TableTuple *tuple1, const TableTuple *tuple2) {
+    return node->left->kernel(node->left, tuple1, tuple2) ||
+           node->right->kernel(node->right, tuple1, tuple2);
+}
+
+bool negate(const Node *node, const TableTuple *tuple1, const TableTuple *tuple2) {
+    return !node->left->kernel(node->left, tuple1, tuple2);
+}
+
+bool interpret(const Node *node, const TableTuple *tuple1, const TableTuple *tuple2) {
+    return node->expression->eval(tuple1, tuple2).isTrue();
+}
+
+template <typename C, typename T, typename L>
+Kernel pickRight(const Operand &right) {
+    if (right.tupleIndex < 0) {
+        return &compare<C, L, Bound<T> >;
+    }
+    switch (right.type) {
+      case VALUE_TYPE_TINYINT:
+        return &compare<C, L, Column<int8_t, T> >;
+      case VALUE_TYPE_SMALLINT:
+        return &compare<C, L, Column<int16_t, T> >;
+      case VALUE_TYPE_INTEGER:
+        return &compare<C, L, Column<int32_t, T> >;
+      case VALUE_TYPE_BIGINT:
+      case VALUE_TYPE_TIMESTAMP:
+        return &compare<C, L, Column<int64_t, T> >;
+      case VALUE_TYPE_DOUBLE:
+        return &compare<C, L, Column<double, T> >;
+      default:
+        return NULL;
+    }
+}
+
+template <typename C, typename T>
+Kernel pickLeft(const Operand &left, const Operand &right) {
+    if (left.tupleIndex < 0) {
+        return pickRight<C, T, Bound<T> >(right);
+    }
+    switch (left.type) {
+      case VALUE_TYPE_TINYINT:
+        return pickRight<C, T, Column<int8_t, T> >(right);
+      case VALUE_TYPE_SMALLINT:
+        return pickRight<C, T, Column<int16_t, T> >(right);
+      case VALUE_TYPE_INTEGER:
+        return pickRight<C, T, Column<int32_t, T> >(right);
+      case VALUE_TYPE_BIGINT:
+      case VALUE_TYPE_TIMESTAMP:
+        return pickRight<C, T, Column<int64_t, T> >(right);
+      case VALUE_TYPE_DOUBLE:
+        return pickRight<C, T, Column<double, T> >(right);
+      default:
+        return NULL;
+    }
+}
+
+/** Compare as bigints if both sides are integral, as doubles if either is a double */
+template <typename C>
+Kernel pickDomain(const Operand &left, const Operand &right) {
+    if (isIntegral(left.type) && isIntegral(right.type)) {
+        return pickLeft<C, int64_t>(left, right);
+    }
+    if ((isIntegral(left.type) || left.type == VALUE_TYPE_DOUBLE) &&
+        (isIntegral(right.type) || right.type == VALUE_TYPE_DOUBLE)) {
+        return pickLeft<C, double>(left, right);
+    }
+    return NULL;
+}
+
+Kernel pickComparison(ExpressionType type, const Operand &left, const Operand &right) {
+    switch (type) {
+      case EXPRESSION_TYPE_COMPARE_EQUAL:
+        return pickDomain<CmpEq>(left, right);
+      case EXPRESSION_TYPE_COMPARE_NOTEQUAL:
+        return pickDomain<CmpNe>(left, right);
+      case EXPRESSION_TYPE_COMPARE_LESSTHAN:
+        return pickDomain<CmpLt>(left, right);
+      case EXPRESSION_TYPE_COMPARE_GREATERTHAN:
+        return pickDomain<CmpGt>(left, right);
+      case EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO:
+        return pickDomain<CmpLte>(left, right);
+      case EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO:
+        return pickDomain<CmpGte>(left, right);
+      default:
+        return NULL;
+    }
+}
+
+/** Copy the value of a constant or parameter, false if no kernel can compare it */
+bool bindOperand(Operand &operand) {
+    if (operand.tupleIndex >= 0) {
+        return true;
+    }
+    const NValue value = operand.expression->eval(NULL, NULL);
+    if (value.isNull()) {
+        return false;
+    }
+    operand.type = ValuePeeker::peekValueType(value);
+    if (isIntegral(operand.type)) {
+        operand.bigint = ValuePeeker::peekAsBigInt(value);
+        operand.dbl = static_cast<double>(operand.bigint);
+        return true;
+    }
+    if (operand.type == VALUE_TYPE_DOUBLE) {
+        operand.dbl = ValuePeeker::peekDouble(value);
+        return true;
+    }
+    return false;
+}
+
+}
+
+using namespace compiledpredicate;
+
+CompiledPredicate::CompiledPredicate(const TupleSchema *outerSchema, const TupleSchema *innerSchema)
+    : m_root(NULL), m_interpretedNodes(0) {
+    m_schemas[0] = outerSchema;
+    m_schemas[1] = innerSchema;
+}
+
+CompiledPredicate::~CompiledPredicate() {
+    for (size_t i = 0; i < m_nodes.size(); i++) {
+        delete m_nodes[i];
+    }
+}
+
+CompiledPredicate* CompiledPredicate::compile(const AbstractExpression *expression,
+                                              const TupleSchema *outerSchema,
+                                              const TupleSchema *innerSchema) {
+    if (expression == NULL) {
+        return NULL;
+    }
+    CompiledPredicate *predicate = new CompiledPredicate(outerSchema, innerSchema);
+    predicate->m_root = predicate->compileNode(expression);
+    predicate->bind();
+    VOLT_DEBUG("Compiled predicate with %d nodes, %d of them interpreted",
+               (int)predicate->m_nodes.size(), predicate->m_interpretedNodes);
+    return predicate;
+}
+
+Node* CompiledPredicate::compileNode(const AbstractExpression *expression) {
+    Node *node = new Node();
+    m_nodes.push_back(node);
+    node->kernel = &interpret;
+    node->expression = expression;
+    node->left = NULL;
+    node->right = NULL;
+    node->comparison = false;
+
+    const AbstractExpression *left = expression->getLeft();
+    const AbstractExpression *right = expression->getRight();
+    switch (expression->getExpressionType()) {
+      case EXPRESSION_TYPE_CONJUNCTION_AND:
+      case EXPRESSION_TYPE_CONJUNCTION_OR:
+        if (left != NULL && right != NULL) {
+            node->left = compileNode(left);
+            node->right = compileNode(right);
+            node->kernel = (expression->getExpressionType() == EXPRESSION_TYPE_CONJUNCTION_AND)
+                           ? &conjunctionAnd : &conjunctionOr;
+        }
+        break;
+      case EXPRESSION_TYPE_OPERATOR_NOT:
+        if (left != NULL) {
+            node->left = compileNode(left);
+            node->kernel = &negate;
+        }
+        break;
+      case EXPRESSION_TYPE_COMPARE_EQUAL:
+      case EXPRESSION_TYPE_COMPARE_NOTEQUAL:
+      case EXPRESSION_TYPE_COMPARE_LESSTHAN:
+      case EXPRESSION_TYPE_COMPARE_GREATERTHAN:
+      case EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO:
+      case EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO:
+        // the kernel is picked by bind(), once the constants' types are known
+        node->comparison = left != NULL && right != NULL &&
+                           compileOperand(left, node->leftOperand) &&
+                           compileOperand(right, node->rightOperand);
+        break;
+      default:
+        break;
+    }
+    return node;
+}
+
+bool CompiledPredicate::compileOperand(const AbstractExpression *expression, Operand &operand) const {
+    operand.expression = expression;
+    operand.tupleIndex = -1;
+    operand.offset = 0;
+    operand.type = VALUE_TYPE_INVALID;
+    operand.bigint = 0;
+    operand.dbl = 0;
+
+    const TupleValueExpression *column = dynamic_cast<const TupleValueExpression*>(expression);
+    if (column == NULL) {
+        return dynamic_cast<const ConstantValueExpression*>(expression) != NULL ||
+               dynamic_cast<const ParameterValueExpression*>(expression) != NULL;
+    }
+    const int tupleIndex = column->getTupleIndex();
+    if (tupleIndex < 0 || tupleIndex > 1 || m_schemas[tupleIndex] == NULL ||
+        column->getColumnId() >= m_schemas[tupleIndex]->columnCount()) {
+        return false;
+    }
+    operand.type = m_schemas[tupleIndex]->columnType(column->getColumnId());
+    if (isIntegral(operand.type) == false && operand.type != VALUE_TYPE_DOUBLE) {
+        return false;
+    }
+    operand.tupleIndex = tupleIndex;
+    operand.offset = m_schemas[tupleIndex]->columnOffset(column->getColumnId());
+    return true;
+}
+
+void CompiledPredicate::bind() {
+    m_interpretedNodes = 0;
+    for (size_t i = 0; i < m_nodes.size(); i++) {
+        Node *node = m_nodes[i];
+        if (node->comparison) {
+            node->kernel = NULL;
+            if (bindOperand(node->leftOperand) && bindOperand(node->rightOperand)) {
+                node->kernel = pickComparison(node->expression->getExpressionType(),
+                                              node->leftOperand, node->rightOperand);
+            }
+            if (node->kernel == NULL) {
+                node->kernel = &interpret;
+            }
+        }
+        if (node->kernel == &interpret) {
+            m_interpretedNodes++;
+        }
+    }
+}
+
+int CompiledPredicate::evalBatch(char * const *tuples, int *selection, int count,
+                                 const ColumnarBatch *columns) const {
+    return evalNodeBatch(m_root, tuples, selection, count, columns);
+}
+
+int CompiledPredicate::evalNodeBatch(const Node *node, char * const *tuples, int *selection, int count,
+                                     const ColumnarBatch *columns) const {
+    if (node->kernel == &conjunctionAnd) {
+        count = evalNodeBatch(node->left, tuples, selection, count, columns);
+        return (count > 0) ? evalNodeBatch(node->right, tuples, selection, count, columns) : 0;
+    }
+    if (node->kernel == &conjunctionOr) {
+        // same split and merge as ConjunctionExpression<ConjunctionOr>::evalBatch()
+        int left[EXPRESSION_BATCH_SIZE];
+        int right[EXPRESSION_BATCH_SIZE];
+        std::copy(selection, selection + count, left);
+        int leftCount = evalNodeBatch(node->left, tuples, left, count, columns);
+        int rightCount = 0;
+        for (int i = 0, j = 0; i < count; i++) {
+            if (j < leftCount && left[j] == selection[i]) {
+                j++;
+            } else {
+                right[rightCount++] = selection[i];
+            }
+        }
+        rightCount = evalNodeBatch(node->right, tuples, right, rightCount, columns);
+        std::merge(left, left + leftCount, right, right + rightCount, selection);
+        return leftCount + rightCount;
+    }
+    if (node->comparison &&
+        ((node->leftOperand.tupleIndex == 0 && node->rightOperand.tupleIndex < 0) ||
+         (node->leftOperand.tupleIndex < 0 && node->rightOperand.tupleIndex == 0))) {
+        return node->expression->evalBatch(m_schemas[0], tuples, selection, count, columns);
+    }
+
+    TableTuple tuple(m_schemas[0]);
+    int selected = 0;
+    for (int i = 0; i < count; i++) {
+        tuple.move(tuples[selection[i]]);
+        if (node->kernel(node, &tuple, NULL)) {
+            selection[selected++] = selection[i];
+        }
+    }
+    return selected;
+}
+
+}
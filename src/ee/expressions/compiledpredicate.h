@@ -0,0 +1,134 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HSTORECOMPILEDPREDICATE_H
+#define HSTORECOMPILEDPREDICATE_H
+
+#include "common/types.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace voltdb {
+
+class AbstractExpression;
+struct ColumnarBatch;
+class TableTuple;
+class TupleSchema;
+
+namespace compiledpredicate {
+
+struct Node;
+
+typedef bool (*Kernel)(const Node *node, const TableTuple *tuple1, const TableTuple *tuple2);
+
+/** One side of a comparison: a numeric column or a value bound by bind() */
+struct Operand {
+    const AbstractExpression *expression;
+    // which tuple the column is read from, -1 for a constant or parameter
+    int tupleIndex;
+    uint32_t offset;
+    ValueType type;
+    int64_t bigint;
+    double dbl;
+};
+
+struct Node {
+    Kernel kernel;
+    const AbstractExpression *expression;
+    // children of a conjunction or NOT
+    const Node *left;
+    const Node *right;
+    // set for a comparison whose operands a kernel can read
+    bool comparison;
+    Operand leftOperand;
+    Operand rightOperand;
+};
+
+}
+
+/**
+ * A predicate compiled from an expression tree into a tree of kernels,
+ * each a function template instantiated for the comparison and the storage
+ * types of its operands. A comparison reads its columns straight out of
+ * the tuples and compares them without building an NValue, AND and OR
+ * short circuit. Nodes that don't fit a kernel call eval() on their
+ * expression, so any predicate can be compiled.
+ *
+ * The expression tree has to outlive the predicate. The values of
+ * constants and parameters are copied by bind(), which has to be called
+ * again every time the expression is substitute()'d.
+ */
+class CompiledPredicate {
+  public:
+    /**
+     * Compile the predicate over tuples of the given schemas (the inner
+     * one may be NULL) and bind it. Returns NULL for a NULL expression.
+     */
+    static CompiledPredicate* compile(const AbstractExpression *expression,
+                                      const TupleSchema *outerSchema,
+                                      const TupleSchema *innerSchema);
+
+    ~CompiledPredicate();
+
+    /** Copy the current values of the constants and parameters */
+    void bind();
+
+    inline bool isTrue(const TableTuple *tuple1, const TableTuple *tuple2) const {
+        return m_root->kernel(m_root, tuple1, tuple2);
+    }
+
+    /**
+     * Narrow the selection over a batch of outer tuples, the way
+     * AbstractExpression::evalBatch() does. Comparisons of a column with
+     * a constant or parameter run as the expression's loops over the
+     * batch, or its minipages when columns is given. The other nodes run
+     * their kernels on one tuple at a time instead of calling eval().
+     */
+    int evalBatch(char * const *tuples, int *selection, int count,
+                  const ColumnarBatch *columns) const;
+
+    /** Nodes that call eval() as of the last bind() */
+    inline int getInterpretedNodes() const {
+        return m_interpretedNodes;
+    }
+
+  private:
+    CompiledPredicate(const TupleSchema *outerSchema, const TupleSchema *innerSchema);
+
+    compiledpredicate::Node* compileNode(const AbstractExpression *expression);
+    bool compileOperand(const AbstractExpression *expression, compiledpredicate::Operand &operand) const;
+    int evalNodeBatch(const compiledpredicate::Node *node, char * const *tuples, int *selection, int count,
+                      const ColumnarBatch *columns) const;
+
+    const TupleSchema *m_schemas[2];
+    std::vector<compiledpredicate::Node*> m_nodes;
+    compiledpredicate::Node *m_root;
+    int m_interpretedNodes;
+};
+
+}
+
+#endif
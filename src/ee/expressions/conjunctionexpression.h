@@ -52,6 +52,7 @@
 
 #include "expressions/abstractexpression.h"
 
+#include <algorithm>
 #include <string>
 
 namespace voltdb {
@@ -73,6 +74,8 @@ class ConjunctionExpression : public AbstractExpression
     }
 
     NValue eval(const TableTuple *tuple1, const TableTuple *tuple2) const;
+    int evalBatch(const TupleSchema *schema, char * const *tuples, int *selection, int count,
+                  const ColumnarBatch *columns = NULL) const;
 
     std::string debugInfo(const std::string &spacer) const {
         return (spacer + "ConjunctionExpression\n");
@@ -96,5 +99,43 @@ ConjunctionExpression<ConjunctionOr>::eval(const TableTuple *tuple1,
     return m_left->eval(tuple1, tuple2).op_or(m_right->eval(tuple1, tuple2));
 }
 
+/** The right side only sees the tuples that passed the left side */
+template<> inline int
+ConjunctionExpression<ConjunctionAnd>::evalBatch(const TupleSchema *schema,
+                                                 char * const *tuples,
+                                                 int *selection, int count,
+                                                 const ColumnarBatch *columns) const
+{
+    count = m_left->evalBatch(schema, tuples, selection, count, columns);
+    return (count > 0) ? m_right->evalBatch(schema, tuples, selection, count, columns) : 0;
+}
+
+/** The right side only sees the tuples that failed the left side */
+template<> inline int
+ConjunctionExpression<ConjunctionOr>::evalBatch(const TupleSchema *schema,
+                                                char * const *tuples,
+                                                int *selection, int count,
+                                                const ColumnarBatch *columns) const
+{
+    int left[EXPRESSION_BATCH_SIZE];
+    int right[EXPRESSION_BATCH_SIZE];
+    std::copy(selection, selection + count, left);
+    int leftCount = m_left->evalBatch(schema, tuples, left, count, columns);
+
+    int rightCount = 0;
+    for (int i = 0, j = 0; i < count; i++) {
+        if (j < leftCount && left[j] == selection[i]) {
+            j++;
+        } else {
+            right[rightCount++] = selection[i];
+        }
+    }
+    rightCount = m_right->evalBatch(schema, tuples, right, rightCount, columns);
+
+    // both are subsequences of the selection, merge them back in order
+    std::merge(left, left + leftCount, right, right + rightCount, selection);
+    return leftCount + rightCount;
+}
+
 }
 #endif
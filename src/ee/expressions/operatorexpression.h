@@ -64,8 +64,7 @@ namespace voltdb {
 class OperatorNotExpression : public AbstractExpression {
 public:
     OperatorNotExpression(AbstractExpression *left)
-        : AbstractExpression(EXPRESSION_TYPE_OPERATOR_NOT) {
-        m_left = left;
+        : AbstractExpression(EXPRESSION_TYPE_OPERATOR_NOT, left, NULL) {
     };
 
     NValue eval(const TableTuple *tuple1, const TableTuple *tuple2) const {
@@ -76,9 +75,6 @@ public:
     std::string debugInfo(const std::string &spacer) const {
         return (spacer + "OptimizedOperatorNotExpression");
     }
-
-private:
-    AbstractExpression *m_left;
 };
 
 
@@ -253,7 +253,7 @@ protected:
         m_eq(m_keySchema)
     {
         m_match = TableTuple(m_tupleSchema);
-        m_allocator = new AllocatorType(&m_memoryEstimate);
+        m_allocator = new AllocatorType(&m_memoryEstimate, &m_blockAllocator);
         m_entries = new MapType(KeyComparator(m_keySchema), (*m_allocator));
     }
 
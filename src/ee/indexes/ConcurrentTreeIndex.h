@@ -0,0 +1,850 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CONCURRENTTREEINDEX_H_
+#define CONCURRENTTREEINDEX_H_
+
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include "common/debuglog.h"
+#include "common/tabletuple.h"
+#include "indexes/tableindex.h"
+
+namespace voltdb {
+
+/**
+ * B+tree index that other threads can scan while the site thread changes
+ * it, through cursors from newCursor(). Readers never lock. Each node
+ * carries a version that a writer makes odd while it changes the node and
+ * bumps when it is done. Readers remember the version of every node they
+ * pass, check it again before they trust what they read, and start over
+ * from the root when it moved (optimistic lock coupling). Writers are
+ * serialized by a mutex that only the site thread takes in practice.
+ *
+ * Nodes are split but never merged or freed while the index exists, so a
+ * pointer a reader picked up is always safe to follow. Deleting entries
+ * only leaves emptier leaves behind.
+ *
+ * Unique and non-unique indexes share the tree. Entries are ordered by
+ * key and then by tuple address, so every entry is distinct.
+ *
+ * The TableIndex cursor methods of the index itself are for the site
+ * thread only, like those of the other indexes.
+ */
+template<typename KeyType, class KeyComparator, class KeyEqualityChecker>
+class ConcurrentTreeIndex : public TableIndex
+{
+    friend class TableIndexFactory;
+
+    struct Entry {
+        KeyType key;
+        const void *address;
+    };
+
+    struct Node {
+        volatile uint64_t version;
+        volatile int count;
+        bool leaf;
+    };
+
+    static const int NODE_SIZE = 4096;
+    static const int LEAF_CAPACITY = (NODE_SIZE / sizeof(Entry) > 8) ?
+        static_cast<int>(NODE_SIZE / sizeof(Entry)) : 8;
+    static const int INNER_CAPACITY = (NODE_SIZE / (sizeof(Entry) + sizeof(Node*)) > 8) ?
+        static_cast<int>(NODE_SIZE / (sizeof(Entry) + sizeof(Node*))) : 8;
+    static const int MAX_HEIGHT = 32;
+
+    struct Leaf : public Node {
+        Leaf * volatile next;
+        Leaf * volatile prev;
+        Entry entries[LEAF_CAPACITY];
+    };
+
+    struct Inner : public Node {
+        /** children[i] holds the entries below separators[i] */
+        Entry separators[INNER_CAPACITY];
+        Node * volatile children[INNER_CAPACITY + 1];
+    };
+
+    /** Where a search starts relative to its entry */
+    enum BoundType {
+        BOUND_FIRST,    // before every entry
+        BOUND_AT,       // at the first entry not less than it
+        BOUND_AFTER,    // at the first entry greater than it
+        BOUND_LAST      // after every entry
+    };
+
+    struct Bound {
+        Entry entry;
+        BoundType type;
+    };
+
+public:
+
+    /**
+     * Scan of the index. It copies a leaf at a time while the leaf's
+     * version holds still and then hands out the copies, so it sees every
+     * entry that stays in the index for the whole scan, in order.
+     */
+    class Cursor : public IndexCursor
+    {
+    public:
+        Cursor(const ConcurrentTreeIndex *index)
+            : m_index(index), m_leaf(NULL), m_version(0), m_neighbor(NULL),
+              m_forward(true), m_position(0), m_count(0), m_hasMatch(false)
+        {
+            m_bound.type = BOUND_FIRST;
+        }
+
+        bool moveToKey(const TableTuple *searchKey)
+        {
+            KeyType key;
+            key.setFromKey(searchKey);
+            return moveToKey(key);
+        }
+
+        bool moveToKey(const KeyType &key)
+        {
+            Bound bound;
+            bound.entry.key = key;
+            bound.entry.address = NULL;
+            bound.type = BOUND_AT;
+            seek(bound, true);
+            return match(&key);
+        }
+
+        TableTuple nextValueAtKey()
+        {
+            TableTuple retval(m_index->m_tupleSchema);
+            if (!m_hasMatch) {
+                return TableTuple();
+            }
+            retval.move(const_cast<void*>(m_match.address));
+            consume();
+            match(&m_match.key);
+            return retval;
+        }
+
+        bool advanceToNextKey()
+        {
+            // like the multimap, move past the key even if it had no entry
+            if (!m_hasMatch && (m_bound.type == BOUND_FIRST || m_bound.type == BOUND_LAST)) {
+                return false;
+            }
+            Bound bound;
+            bound.entry.key = m_hasMatch ? m_match.key : m_bound.entry.key;
+            bound.entry.address = maxAddress();
+            bound.type = BOUND_AFTER;
+            seek(bound, true);
+            return match(NULL);
+        }
+
+        void moveToKeyOrGreater(const TableTuple *searchKey)
+        {
+            Bound bound;
+            bound.entry.key.setFromKey(searchKey);
+            bound.entry.address = NULL;
+            bound.type = BOUND_AT;
+            seek(bound, true);
+        }
+
+        void moveToGreaterThanKey(const TableTuple *searchKey)
+        {
+            Bound bound;
+            bound.entry.key.setFromKey(searchKey);
+            bound.entry.address = maxAddress();
+            bound.type = BOUND_AFTER;
+            seek(bound, true);
+        }
+
+        void moveToEnd(bool begin)
+        {
+            Bound bound;
+            bound.type = begin ? BOUND_FIRST : BOUND_LAST;
+            seek(bound, begin);
+        }
+
+        TableTuple nextValue()
+        {
+            if (!fill()) {
+                return TableTuple();
+            }
+            TableTuple retval(m_index->m_tupleSchema);
+            retval.move(const_cast<void*>(m_buffer[m_position].address));
+            consume();
+            return retval;
+        }
+
+        /** The next entry with the key (any key if NULL) becomes the match */
+        bool match(const KeyType *key)
+        {
+            m_hasMatch = fill() &&
+                (key == NULL || m_index->m_eq(m_buffer[m_position].key, *key));
+            if (m_hasMatch) {
+                m_match = m_buffer[m_position];
+            }
+            return m_hasMatch;
+        }
+
+        /** Find the first entry with the key */
+        bool findKey(const KeyType &key, Entry *found)
+        {
+            if (!moveToKey(key)) {
+                return false;
+            }
+            *found = m_match;
+            return true;
+        }
+
+    private:
+        void seek(const Bound &bound, bool forward)
+        {
+            m_bound = bound;
+            m_forward = forward;
+            m_leaf = NULL;
+            m_position = m_count = 0;
+            m_hasMatch = false;
+        }
+
+        /** Hand out the first buffered entry, later scans start after it */
+        void consume()
+        {
+            m_bound.entry = m_buffer[m_position++];
+            m_bound.type = m_forward ? BOUND_AFTER : BOUND_AT;
+        }
+
+        /** Make sure there is a buffered entry, false at the end of the scan */
+        bool fill()
+        {
+            while (m_position == m_count) {
+                if (m_leaf != NULL && m_neighbor == NULL) {
+                    // no more leaves, unless the last one split since
+                    if (ConcurrentTreeIndex::validate(m_leaf, m_version)) {
+                        return false;
+                    }
+                    m_leaf = NULL;
+                }
+                const Leaf *leaf;
+                uint64_t version;
+                int begin = 0;
+                int end = 0;
+                if (m_leaf == NULL) {
+                    leaf = m_index->findLeaf(m_bound, &version);
+                    int count = ConcurrentTreeIndex::clamp(leaf->count, LEAF_CAPACITY);
+                    int position = m_index->position(leaf->entries, count, m_bound);
+                    if (m_forward) {
+                        begin = position;
+                        end = count;
+                    } else {
+                        end = position;
+                    }
+                } else {
+                    leaf = m_neighbor;
+                    version = ConcurrentTreeIndex::readLock(leaf);
+                    end = ConcurrentTreeIndex::clamp(leaf->count, LEAF_CAPACITY);
+                }
+
+                m_count = 0;
+                m_position = 0;
+                if (m_forward) {
+                    for (int ii = begin; ii < end; ii++) {
+                        m_buffer[m_count++] = leaf->entries[ii];
+                    }
+                    m_neighbor = leaf->next;
+                } else {
+                    for (int ii = end - 1; ii >= begin; ii--) {
+                        m_buffer[m_count++] = leaf->entries[ii];
+                    }
+                    m_neighbor = leaf->prev;
+                }
+                // the copy must be whole, and moving to a neighbor only
+                // works if the leaf it was linked from did not split
+                if (!ConcurrentTreeIndex::validate(leaf, version) ||
+                    (m_leaf != NULL && !ConcurrentTreeIndex::validate(m_leaf, m_version))) {
+                    m_leaf = NULL;
+                    m_count = 0;
+                    continue;
+                }
+                m_leaf = leaf;
+                m_version = version;
+            }
+            return true;
+        }
+
+        const ConcurrentTreeIndex *m_index;
+        Bound m_bound;
+        const Leaf *m_leaf;
+        uint64_t m_version;
+        const Leaf *m_neighbor;
+        bool m_forward;
+
+        Entry m_buffer[LEAF_CAPACITY];
+        int m_position;
+        int m_count;
+
+        Entry m_match;
+        bool m_hasMatch;
+    };
+
+    ~ConcurrentTreeIndex()
+    {
+        freeNode(m_root);
+        pthread_mutex_destroy(&m_writeMutex);
+    }
+
+    bool addEntry(const TableTuple *tuple)
+    {
+        m_tmp1.setFromTuple(tuple, column_indices_, m_keySchema);
+        return addEntryPrivate(tuple->address(), m_tmp1);
+    }
+
+    bool deleteEntry(const TableTuple *tuple)
+    {
+        m_tmp1.setFromTuple(tuple, column_indices_, m_keySchema);
+        return deleteEntryPrivate(tuple->address(), m_tmp1);
+    }
+
+    bool replaceEntry(const TableTuple *oldTupleValue,
+                      const TableTuple *newTupleValue)
+    {
+        m_tmp1.setFromTuple(oldTupleValue, column_indices_, m_keySchema);
+        m_tmp2.setFromTuple(newTupleValue, column_indices_, m_keySchema);
+        if (m_eq(m_tmp1, m_tmp2))
+        {
+            // no update is needed for this index
+            return true;
+        }
+
+        // like the multimap, the entry of a non-unique index is found by
+        // the address of the new tuple
+        bool deleted = deleteEntryPrivate(newTupleValue->address(), m_tmp1);
+        bool inserted = addEntryPrivate(newTupleValue->address(), m_tmp2);
+        --m_deletes;
+        --m_inserts;
+        ++m_updates;
+        return (deleted && inserted);
+    }
+
+    bool setEntryToNewAddress(const TableTuple *tuple, const void* address, const void *oldAddress)
+    {
+        m_tmp1.setFromTuple(tuple, column_indices_, m_keySchema);
+        ++m_updates;
+        if (!deleteEntryPrivate(oldAddress, m_tmp1)) {
+            VOLT_INFO("Tuple not found.");
+            return false;
+        }
+        --m_deletes;
+        --m_inserts;
+        return addEntryPrivate(address, m_tmp1);
+    }
+
+    bool checkForIndexChange(const TableTuple *lhs, const TableTuple *rhs)
+    {
+        m_tmp1.setFromTuple(lhs, column_indices_, m_keySchema);
+        m_tmp2.setFromTuple(rhs, column_indices_, m_keySchema);
+        return !(m_eq(m_tmp1, m_tmp2));
+    }
+
+    bool exists(const TableTuple *values)
+    {
+        ++m_lookups;
+        m_tmp1.setFromTuple(values, column_indices_, m_keySchema);
+        Cursor cursor(this);
+        return cursor.moveToKey(m_tmp1);
+    }
+
+    bool moveToKey(const TableTuple *searchKey)
+    {
+        ++m_lookups;
+        return m_cursor.moveToKey(searchKey);
+    }
+
+    bool moveToTuple(const TableTuple *searchTuple)
+    {
+        ++m_lookups;
+        m_tmp1.setFromTuple(searchTuple, column_indices_, m_keySchema);
+        return m_cursor.moveToKey(m_tmp1);
+    }
+
+    void moveToKeyOrGreater(const TableTuple *searchKey)
+    {
+        ++m_lookups;
+        m_cursor.moveToKeyOrGreater(searchKey);
+    }
+
+    void moveToGreaterThanKey(const TableTuple *searchKey)
+    {
+        ++m_lookups;
+        m_cursor.moveToGreaterThanKey(searchKey);
+    }
+
+    void moveToEnd(bool begin)
+    {
+        ++m_lookups;
+        m_cursor.moveToEnd(begin);
+    }
+
+    TableTuple nextValue()
+    {
+        return m_cursor.nextValue();
+    }
+
+    TableTuple nextValueAtKey()
+    {
+        return m_cursor.nextValueAtKey();
+    }
+
+    bool advanceToNextKey()
+    {
+        return m_cursor.advanceToNextKey();
+    }
+
+    IndexCursor* newCursor() const
+    {
+        return new Cursor(this);
+    }
+
+    size_t getSize() const { return static_cast<size_t>(m_size); }
+
+    int64_t getMemoryEstimate() const {
+        return m_memoryEstimate;
+    }
+
+    std::string getTypeName() const { return "ConcurrentTreeIndex"; };
+
+    std::string debug() const
+    {
+        std::ostringstream buffer;
+        buffer << TableIndex::debug() << std::endl;
+
+        Cursor cursor(this);
+        cursor.moveToEnd(true);
+        TableTuple retval;
+        while (!(retval = cursor.nextValue()).isNullTuple()) {
+            buffer << retval.debugNoHeader() << std::endl;
+        }
+        std::string ret(buffer.str());
+        return (ret);
+    }
+
+protected:
+    ConcurrentTreeIndex(const TableIndexScheme &scheme) :
+        TableIndex(scheme),
+        m_cmp(m_keySchema),
+        m_eq(m_keySchema),
+        m_size(0),
+        m_cursor(this)
+    {
+        pthread_mutex_init(&m_writeMutex, NULL);
+        m_root = newLeaf();
+    }
+
+    // ------------------------------------------------------------------
+    // NODE VERSIONS
+    // ------------------------------------------------------------------
+    /** The version of an unlocked node, waiting for a writer to finish */
+    static uint64_t readLock(const Node *node)
+    {
+        uint64_t version;
+        while ((version = node->version) & 1) {
+            sched_yield();
+        }
+        __sync_synchronize();
+        return version;
+    }
+
+    /** Whether the node is still at the version read before */
+    static bool validate(const Node *node, uint64_t version)
+    {
+        __sync_synchronize();
+        return node->version == version;
+    }
+
+    static void writeLock(Node *node)
+    {
+        node->version = node->version + 1;
+        __sync_synchronize();
+    }
+
+    static void writeUnlock(Node *node)
+    {
+        __sync_synchronize();
+        node->version = node->version + 1;
+    }
+
+    /** A count read while a writer may be changing it */
+    static int clamp(int count, int capacity)
+    {
+        return (count < 0) ? 0 : ((count > capacity) ? capacity : count);
+    }
+
+    static const void* maxAddress()
+    {
+        return reinterpret_cast<const void*>(~static_cast<uintptr_t>(0));
+    }
+
+    // ------------------------------------------------------------------
+    // SEARCH
+    // ------------------------------------------------------------------
+    bool less(const Entry &lhs, const Entry &rhs) const
+    {
+        if (m_cmp(lhs.key, rhs.key)) return true;
+        if (m_cmp(rhs.key, lhs.key)) return false;
+        return std::less<const void*>()(lhs.address, rhs.address);
+    }
+
+    /** Number of entries in front of the bound */
+    int position(const Entry *entries, int count, const Bound &bound) const
+    {
+        if (bound.type == BOUND_FIRST) return 0;
+        if (bound.type == BOUND_LAST) return count;
+        int low = 0;
+        int high = count;
+        while (low < high) {
+            int middle = (low + high) / 2;
+            bool before = (bound.type == BOUND_AT) ?
+                less(entries[middle], bound.entry) :
+                !less(bound.entry, entries[middle]);
+            if (before) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    /** The child of an inner node to look for the bound in */
+    int route(const Inner *inner, int count, const Bound &bound) const
+    {
+        if (bound.type == BOUND_FIRST) return 0;
+        if (bound.type == BOUND_LAST) return count;
+        // separators are the first entries of their right children
+        Bound after = bound;
+        after.type = BOUND_AFTER;
+        return position(inner->separators, count, after);
+    }
+
+    /** The leaf the bound falls into, consistent at the returned version */
+    const Leaf* findLeaf(const Bound &bound, uint64_t *version) const
+    {
+        while (true) {
+            const Node *node = m_root;
+            uint64_t nodeVersion = readLock(node);
+            if (node != m_root) {
+                continue;
+            }
+            bool restart = false;
+            while (!node->leaf) {
+                const Inner *inner = static_cast<const Inner*>(node);
+                int count = clamp(inner->count, INNER_CAPACITY);
+                const Node *child = inner->children[route(inner, count, bound)];
+                if (!validate(inner, nodeVersion)) {
+                    restart = true;
+                    break;
+                }
+                uint64_t childVersion = readLock(child);
+                if (!validate(inner, nodeVersion)) {
+                    restart = true;
+                    break;
+                }
+                node = child;
+                nodeVersion = childVersion;
+            }
+            if (!restart) {
+                *version = nodeVersion;
+                return static_cast<const Leaf*>(node);
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // CHANGES (one writer at a time)
+    // ------------------------------------------------------------------
+    inline bool addEntryPrivate(const void *address, const KeyType &key)
+    {
+        ++m_inserts;
+        Entry entry;
+        entry.key = key;
+        entry.address = address;
+        pthread_mutex_lock(&m_writeMutex);
+        bool inserted = true;
+        if (is_unique_index_) {
+            Entry existing;
+            Cursor cursor(this);
+            inserted = !cursor.findKey(key, &existing);
+        }
+        if (inserted) {
+            insert(entry);
+            m_size = m_size + 1;
+        }
+        pthread_mutex_unlock(&m_writeMutex);
+        return inserted;
+    }
+
+    /**
+     * Remove the entry of the tuple at the address, the first one with
+     * the key if the index is unique
+     */
+    inline bool deleteEntryPrivate(const void *address, const KeyType &key)
+    {
+        ++m_deletes;
+        Entry entry;
+        entry.key = key;
+        entry.address = address;
+        pthread_mutex_lock(&m_writeMutex);
+        bool deleted = true;
+        if (is_unique_index_) {
+            Cursor cursor(this);
+            deleted = cursor.findKey(key, &entry);
+        }
+        if (deleted) {
+            deleted = remove(entry);
+        }
+        if (deleted) {
+            m_size = m_size - 1;
+        }
+        pthread_mutex_unlock(&m_writeMutex);
+        return deleted;
+    }
+
+    void insert(const Entry &entry)
+    {
+        Bound bound;
+        bound.entry = entry;
+        bound.type = BOUND_AT;
+
+        Inner *path[MAX_HEIGHT];
+        int slots[MAX_HEIGHT];
+        int depth = 0;
+        Node *node = m_root;
+        while (!node->leaf) {
+            Inner *inner = static_cast<Inner*>(node);
+            int slot = route(inner, inner->count, bound);
+            assert(depth < MAX_HEIGHT);
+            path[depth] = inner;
+            slots[depth++] = slot;
+            node = inner->children[slot];
+        }
+        Leaf *leaf = static_cast<Leaf*>(node);
+        int count = leaf->count;
+        int pos = position(leaf->entries, count, bound);
+
+        if (count < LEAF_CAPACITY) {
+            writeLock(leaf);
+            ::memmove(&leaf->entries[pos + 1], &leaf->entries[pos], sizeof(Entry) * (count - pos));
+            leaf->entries[pos] = entry;
+            leaf->count = count + 1;
+            writeUnlock(leaf);
+            return;
+        }
+
+        // split the leaf, the new right half is complete before it is linked
+        const int half = LEAF_CAPACITY / 2;
+        Leaf *right = newLeaf();
+        ::memcpy(right->entries, &leaf->entries[half], sizeof(Entry) * (count - half));
+        right->count = count - half;
+        if (pos >= half) {
+            insertEntry(right, pos - half, entry);
+        }
+        Leaf *after = leaf->next;
+        right->next = after;
+        right->prev = leaf;
+        __sync_synchronize();
+
+        writeLock(leaf);
+        if (after != NULL) {
+            writeLock(after);
+            after->prev = right;
+            writeUnlock(after);
+        }
+        leaf->count = half;
+        leaf->next = right;
+        if (pos < half) {
+            insertEntry(leaf, pos, entry);
+        }
+        insertSeparator(path, slots, depth, right->entries[0], right, leaf);
+    }
+
+    static void insertEntry(Leaf *leaf, int pos, const Entry &entry)
+    {
+        int count = leaf->count;
+        ::memmove(&leaf->entries[pos + 1], &leaf->entries[pos], sizeof(Entry) * (count - pos));
+        leaf->entries[pos] = entry;
+        leaf->count = count + 1;
+    }
+
+    /**
+     * Link the sibling split off the right of a node into the parents.
+     * The split node stays locked until its parent knows the sibling, so
+     * no reader can be routed past the entries that moved.
+     */
+    void insertSeparator(Inner **path, int *slots, int depth,
+                         Entry separator, Node *right, Node *split)
+    {
+        while (depth > 0) {
+            Inner *inner = path[--depth];
+            int slot = slots[depth];
+            int count = inner->count;
+            if (count < INNER_CAPACITY) {
+                writeLock(inner);
+                ::memmove(&inner->separators[slot + 1], &inner->separators[slot],
+                          sizeof(Entry) * (count - slot));
+                ::memmove(const_cast<Node**>(&inner->children[slot + 2]),
+                          const_cast<Node**>(&inner->children[slot + 1]),
+                          sizeof(Node*) * (count - slot));
+                inner->separators[slot] = separator;
+                inner->children[slot + 1] = right;
+                inner->count = count + 1;
+                writeUnlock(inner);
+                writeUnlock(split);
+                return;
+            }
+
+            // split the full inner node around its middle separator
+            Entry separators[INNER_CAPACITY + 1];
+            Node *children[INNER_CAPACITY + 2];
+            ::memcpy(separators, inner->separators, sizeof(Entry) * slot);
+            separators[slot] = separator;
+            ::memcpy(&separators[slot + 1], &inner->separators[slot], sizeof(Entry) * (count - slot));
+            for (int ii = 0; ii <= slot; ii++) children[ii] = inner->children[ii];
+            children[slot + 1] = right;
+            for (int ii = slot + 1; ii <= count; ii++) children[ii + 1] = inner->children[ii];
+
+            const int total = count + 1;
+            const int middle = total / 2;
+            Inner *sibling = newInner();
+            sibling->count = total - middle - 1;
+            ::memcpy(sibling->separators, &separators[middle + 1], sizeof(Entry) * sibling->count);
+            for (int ii = 0; ii <= sibling->count; ii++) {
+                sibling->children[ii] = children[middle + 1 + ii];
+            }
+            __sync_synchronize();
+
+            writeLock(inner);
+            ::memcpy(inner->separators, separators, sizeof(Entry) * middle);
+            for (int ii = 0; ii <= middle; ii++) inner->children[ii] = children[ii];
+            inner->count = middle;
+            writeUnlock(split);
+            split = inner;
+            separator = separators[middle];
+            right = sibling;
+        }
+
+        // the root split, grow the tree
+        Inner *root = newInner();
+        root->count = 1;
+        root->separators[0] = separator;
+        root->children[0] = m_root;
+        root->children[1] = right;
+        __sync_synchronize();
+        m_root = root;
+        writeUnlock(split);
+    }
+
+    bool remove(const Entry &entry)
+    {
+        Bound bound;
+        bound.entry = entry;
+        bound.type = BOUND_AT;
+        Node *node = m_root;
+        while (!node->leaf) {
+            Inner *inner = static_cast<Inner*>(node);
+            node = inner->children[route(inner, inner->count, bound)];
+        }
+        // leaves emptied by earlier deletes may come first
+        for (Leaf *leaf = static_cast<Leaf*>(node); leaf != NULL; leaf = leaf->next) {
+            int count = leaf->count;
+            int pos = position(leaf->entries, count, bound);
+            if (pos == count) {
+                continue;
+            }
+            if (less(entry, leaf->entries[pos])) {
+                return false;
+            }
+            writeLock(leaf);
+            ::memmove(&leaf->entries[pos], &leaf->entries[pos + 1], sizeof(Entry) * (count - pos - 1));
+            leaf->count = count - 1;
+            writeUnlock(leaf);
+            return true;
+        }
+        return false;
+    }
+
+    Leaf* newLeaf()
+    {
+        Leaf *leaf = new Leaf();
+        leaf->version = 0;
+        leaf->count = 0;
+        leaf->leaf = true;
+        leaf->next = leaf->prev = NULL;
+        m_memoryEstimate += sizeof(Leaf);
+        return leaf;
+    }
+
+    Inner* newInner()
+    {
+        Inner *inner = new Inner();
+        inner->version = 0;
+        inner->count = 0;
+        inner->leaf = false;
+        m_memoryEstimate += sizeof(Inner);
+        return inner;
+    }
+
+    void freeNode(Node *node)
+    {
+        if (node->leaf) {
+            delete static_cast<Leaf*>(node);
+            return;
+        }
+        Inner *inner = static_cast<Inner*>(node);
+        for (int ii = 0; ii <= inner->count; ii++) {
+            freeNode(inner->children[ii]);
+        }
+        delete inner;
+    }
+
+    Node * volatile m_root;
+    pthread_mutex_t m_writeMutex;
+    KeyType m_tmp1;
+    KeyType m_tmp2;
+
+    // comparison stuff
+    KeyComparator m_cmp;
+    KeyEqualityChecker m_eq;
+
+    volatile int64_t m_size;
+    Cursor m_cursor;
+};
+
+}
+
+#endif // CONCURRENTTREEINDEX_H_
@@ -173,7 +173,7 @@ protected:
         m_match = TableTuple(m_tupleSchema);
         //m_entries->rehash(200000);
 
-        m_allocator = new AllocatorType(&m_memoryEstimate);
+        m_allocator = new AllocatorType(&m_memoryEstimate, &m_blockAllocator);
         m_entries = new MapType(100, KeyHasher(m_keySchema), KeyEqualityChecker(m_keySchema), *m_allocator);
         m_entries->max_load_factor(.75f);
     }
@@ -0,0 +1,475 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef OPENHASHTABLEINDEX_H_
+#define OPENHASHTABLEINDEX_H_
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "common/BlockAllocator.h"
+#include "common/debuglog.h"
+#include "common/tabletuple.h"
+#include "indexes/tableindex.h"
+
+namespace voltdb {
+
+/**
+ * Hash index with open addressing, laid out like a Swiss table. Keys are
+ * stored inline next to their tuple address in one flat slot array, so an
+ * entry of a unique index costs no allocation of its own and a lookup no
+ * pointer chase.
+ *
+ * Every slot has a control byte: EMPTY, DELETED or the low 7 bits of the
+ * hash of its key (the tag). Slots are probed in groups of 16. One SSE2
+ * compare of the 16 control bytes against the tag picks the candidate
+ * slots and only their keys are compared. The first group with an EMPTY
+ * slot ends a probe. Groups follow a triangular sequence, which visits
+ * every group of a table with a power of two number of them.
+ *
+ * Unique and non-unique indexes share the table. A non-unique index keeps
+ * one slot per key, whose address is the Chain of the tuples with that
+ * key, so a heavily duplicated key costs one probe and does not crowd the
+ * probes of other keys. A deleted slot becomes EMPTY again when its group
+ * still has an EMPTY slot and a DELETED tombstone otherwise. The table is
+ * rebuilt when live slots and tombstones fill 7/8 of it, twice as large if
+ * live slots alone fill 7/16.
+ */
+template<typename KeyType, class KeyHasher, class KeyEqualityChecker>
+class OpenHashTableIndex : public TableIndex {
+    friend class TableIndexFactory;
+
+    struct Slot {
+        KeyType key;
+        const void *address;
+    };
+
+    /** Tuples of one key of a non-unique index */
+    typedef std::vector<const void*> Chain;
+
+    /** Probe position of one key, kept between moveToKey() and nextValueAtKey() */
+    struct Probe {
+        size_t group;
+        size_t step;
+        uint32_t candidates;
+        int8_t tag;
+        bool finished;
+    };
+
+    static const size_t GROUP_SIZE = 16;
+    static const size_t MIN_CAPACITY = 128;
+    static const int8_t EMPTY = -128;
+    static const int8_t DELETED = -2;
+
+public:
+
+    ~OpenHashTableIndex() {
+        if (!is_unique_index_) {
+            for (size_t ii = 0; ii < m_capacity; ii++) {
+                if (m_control[ii] >= 0) {
+                    delete chainOf(m_slots + ii);
+                }
+            }
+        }
+        m_blockAllocator.deallocate(reinterpret_cast<char*>(m_control), allocationSize(m_capacity));
+    }
+
+    bool addEntry(const TableTuple *tuple) {
+        m_tmp1.setFromTuple(tuple, column_indices_, m_keySchema);
+        return addEntryPrivate(tuple->address(), m_tmp1);
+    }
+
+    bool deleteEntry(const TableTuple *tuple) {
+        m_tmp1.setFromTuple(tuple, column_indices_, m_keySchema);
+        return deleteEntryPrivate(tuple->address(), m_tmp1);
+    }
+
+    bool replaceEntry(const TableTuple *oldTupleValue, const TableTuple* newTupleValue) {
+        m_tmp1.setFromTuple(oldTupleValue, column_indices_, m_keySchema);
+        m_tmp2.setFromTuple(newTupleValue, column_indices_, m_keySchema);
+        if (m_eq(m_tmp1, m_tmp2)) return true; // no update is needed for this index
+
+        // the old and new values share the tuple address
+        bool deleted = deleteEntryPrivate(newTupleValue->address(), m_tmp1);
+        bool inserted = addEntryPrivate(newTupleValue->address(), m_tmp2);
+        --m_deletes;
+        --m_inserts;
+        ++m_updates;
+        return (deleted && inserted);
+    }
+
+    /**
+     * Point the entry of the tuple at its new address in place. A unique
+     * index finds the entry by key alone, like HashTableUniqueIndex.
+     */
+    bool setEntryToNewAddress(const TableTuple *tuple, const void* address, const void *oldAddress) {
+        m_tmp1.setFromTuple(tuple, column_indices_, m_keySchema);
+        ++m_updates;
+        Probe probe;
+        Slot *slot = nextMatch(m_tmp1, beginProbe(m_tmp1, probe));
+        if (slot != NULL && is_unique_index_) {
+            slot->address = address;
+            return true;
+        }
+        Chain *chain = (slot == NULL) ? NULL : chainOf(slot);
+        Chain::iterator entry;
+        if (chain == NULL || (entry = findInChain(chain, oldAddress)) == chain->end()) {
+            VOLT_INFO("Tuple not found.");
+            return false;
+        }
+        chain->erase(entry);
+        chain->insert(std::lower_bound(chain->begin(), chain->end(), address), address);
+        return true;
+    }
+
+    bool checkForIndexChange(const TableTuple *lhs, const TableTuple *rhs) {
+        m_tmp1.setFromTuple(lhs, column_indices_, m_keySchema);
+        m_tmp2.setFromTuple(rhs, column_indices_, m_keySchema);
+        return !(m_eq(m_tmp1, m_tmp2));
+    }
+
+    bool exists(const TableTuple* values) {
+        ++m_lookups;
+        m_tmp1.setFromTuple(values, column_indices_, m_keySchema);
+        Probe probe;
+        return nextMatch(m_tmp1, beginProbe(m_tmp1, probe)) != NULL;
+    }
+
+    bool moveToKey(const TableTuple *searchKey) {
+        m_tmp1.setFromKey(searchKey);
+        return moveToKey(m_tmp1);
+    }
+
+    bool moveToTuple(const TableTuple *searchTuple) {
+        m_tmp1.setFromTuple(searchTuple, column_indices_, m_keySchema);
+        return moveToKey(m_tmp1);
+    }
+
+    TableTuple nextValueAtKey() {
+        TableTuple retval = m_match;
+        if (m_match.isNullTuple()) return retval;
+        const void *next = NULL;
+        if (m_matchChain != NULL && ++m_matchPosition < m_matchChain->size()) {
+            next = (*m_matchChain)[m_matchPosition];
+        }
+        m_match.move(const_cast<void*>(next));
+        return retval;
+    }
+
+    virtual void ensureCapacity(uint32_t capacity) {
+        size_t wanted = capacityFor(capacity);
+        if (wanted > m_capacity) {
+            rehash(wanted);
+        }
+    }
+
+    size_t getSize() const { return m_entries; }
+    int64_t getMemoryEstimate() const {
+        return m_memoryEstimate + static_cast<int64_t>(m_chainBytes);
+    }
+    std::string getTypeName() const { return "OpenHashTableIndex"; };
+
+    // print out info about lookup usage
+    virtual void printReport() {
+        TableIndex::printReport();
+        std::cout << "  Loadfactor: " << static_cast<double>(m_size) / static_cast<double>(m_capacity)
+                  << " Tombstones: " << m_tombstones << std::endl;
+    }
+
+protected:
+    OpenHashTableIndex(const TableIndexScheme &scheme) :
+        TableIndex(scheme),
+        m_hasher(m_keySchema),
+        m_eq(m_keySchema),
+        m_control(NULL),
+        m_slots(NULL),
+        m_capacity(0),
+        m_size(0),
+        m_tombstones(0),
+        m_entries(0),
+        m_chainBytes(0),
+        m_matchChain(NULL),
+        m_matchPosition(0)
+    {
+        m_match = TableTuple(m_tupleSchema);
+        allocate(MIN_CAPACITY);
+    }
+
+    inline bool addEntryPrivate(const void *address, const KeyType &key) {
+        ++m_inserts;
+        Probe probe;
+        Slot *slot = nextMatch(key, beginProbe(key, probe));
+        if (slot != NULL) {
+            if (is_unique_index_) {
+                return false;
+            }
+            Chain *chain = chainOf(slot);
+            m_chainBytes -= chain->capacity() * sizeof(const void*);
+            chain->insert(std::lower_bound(chain->begin(), chain->end(), address), address);
+            m_chainBytes += chain->capacity() * sizeof(const void*);
+            ++m_entries;
+            return true;
+        }
+        if (m_size + m_tombstones + 1 > maxLoad(m_capacity)) {
+            rehash(m_size + 1 > m_capacity * 7 / 16 ? m_capacity * 2 : m_capacity);
+        }
+        if (is_unique_index_) {
+            insertSlot(key, address);
+        } else {
+            Chain *chain = new Chain(1, address);
+            m_chainBytes += sizeof(Chain) + chain->capacity() * sizeof(const void*);
+            insertSlot(key, chain);
+        }
+        ++m_entries;
+        return true;
+    }
+
+    inline bool deleteEntryPrivate(const void *address, const KeyType &key) {
+        ++m_deletes;
+        Probe probe;
+        Slot *slot = nextMatch(key, beginProbe(key, probe));
+        if (slot == NULL) {
+            return false;
+        }
+        --m_entries;
+        if (!is_unique_index_) {
+            Chain *chain = chainOf(slot);
+            Chain::iterator entry = findInChain(chain, address);
+            if (entry == chain->end()) {
+                ++m_entries;
+                return false;
+            }
+            chain->erase(entry);
+            if (!chain->empty()) {
+                return true;
+            }
+            m_chainBytes -= sizeof(Chain) + chain->capacity() * sizeof(const void*);
+            delete chain;
+        }
+        size_t index = static_cast<size_t>(slot - m_slots);
+        if (matchByte(m_control + (index - index % GROUP_SIZE), EMPTY) != 0) {
+            // no probe ever went past this group
+            m_control[index] = EMPTY;
+        } else {
+            m_control[index] = DELETED;
+            ++m_tombstones;
+        }
+        --m_size;
+        return true;
+    }
+
+    bool moveToKey(const KeyType &key) {
+        ++m_lookups;
+        Probe probe;
+        Slot *slot = nextMatch(key, beginProbe(key, probe));
+        m_matchChain = NULL;
+        m_matchPosition = 0;
+        const void *address = NULL;
+        if (slot != NULL) {
+            if (is_unique_index_) {
+                address = slot->address;
+            } else {
+                m_matchChain = chainOf(slot);
+                address = m_matchChain->front();
+            }
+        }
+        m_match.move(const_cast<void*>(address));
+        return slot != NULL;
+    }
+
+    static inline Chain* chainOf(const Slot *slot) {
+        return static_cast<Chain*>(const_cast<void*>(slot->address));
+    }
+
+    /** Chains are kept in address order, so tuples are found by bisection */
+    static inline Chain::iterator findInChain(Chain *chain, const void *address) {
+        Chain::iterator entry = std::lower_bound(chain->begin(), chain->end(), address);
+        return (entry != chain->end() && *entry == address) ? entry : chain->end();
+    }
+
+    inline uint64_t hashOf(const KeyType &key) const {
+        // the key hashers are weak in the high bits, mix them (murmur3 finalizer)
+        uint64_t hash = static_cast<uint64_t>(m_hasher(key));
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    inline Probe& beginProbe(const KeyType &key, Probe &probe) const {
+        uint64_t hash = hashOf(key);
+        probe.tag = static_cast<int8_t>(hash & 0x7F);
+        probe.group = static_cast<size_t>(hash >> 7) & groupMask();
+        probe.step = 0;
+        probe.candidates = matchByte(m_control + probe.group * GROUP_SIZE, probe.tag);
+        probe.finished = false;
+        return probe;
+    }
+
+    /** The next slot holding key along the probe, NULL when the probe is over */
+    inline Slot* nextMatch(const KeyType &key, Probe &probe) const {
+        while (!probe.finished) {
+            while (probe.candidates != 0) {
+                size_t index = probe.group * GROUP_SIZE + static_cast<size_t>(__builtin_ctz(probe.candidates));
+                probe.candidates &= probe.candidates - 1;
+                if (m_eq(m_slots[index].key, key)) {
+                    return m_slots + index;
+                }
+            }
+            if (matchByte(m_control + probe.group * GROUP_SIZE, EMPTY) != 0 || probe.step == groupMask()) {
+                probe.finished = true;
+                break;
+            }
+            probe.group = (probe.group + ++probe.step) & groupMask();
+            probe.candidates = matchByte(m_control + probe.group * GROUP_SIZE, probe.tag);
+        }
+        return NULL;
+    }
+
+    /** Put the entry in the first free slot of its probe, the table must have room */
+    inline void insertSlot(const KeyType &key, const void *address) {
+        uint64_t hash = hashOf(key);
+        size_t group = static_cast<size_t>(hash >> 7) & groupMask();
+        uint32_t free;
+        for (size_t step = 1; (free = matchFree(m_control + group * GROUP_SIZE)) == 0; step++) {
+            group = (group + step) & groupMask();
+        }
+        size_t index = group * GROUP_SIZE + static_cast<size_t>(__builtin_ctz(free));
+        if (m_control[index] == DELETED) {
+            --m_tombstones;
+        }
+        m_control[index] = static_cast<int8_t>(hash & 0x7F);
+        m_slots[index].key = key;
+        m_slots[index].address = address;
+        ++m_size;
+    }
+
+    void rehash(size_t capacity) {
+        int8_t *control = m_control;
+        Slot *slots = m_slots;
+        size_t oldCapacity = m_capacity;
+        allocate(capacity);
+        for (size_t ii = 0; ii < oldCapacity; ii++) {
+            if (control[ii] >= 0) {
+                insertSlot(slots[ii].key, slots[ii].address);
+            }
+        }
+        m_blockAllocator.deallocate(reinterpret_cast<char*>(control), allocationSize(oldCapacity));
+    }
+
+    /** Replace the table with an empty one, the caller frees the old one */
+    void allocate(size_t capacity) {
+        // control bytes first, the slots after them stay aligned as capacity is a multiple of 16
+        char *memory = m_blockAllocator.allocate(allocationSize(capacity));
+        m_control = reinterpret_cast<int8_t*>(memory);
+        m_slots = reinterpret_cast<Slot*>(memory + capacity);
+        ::memset(m_control, EMPTY, capacity);
+        m_capacity = capacity;
+        m_size = 0;
+        m_tombstones = 0;
+        m_memoryEstimate = static_cast<int64_t>(allocationSize(capacity));
+    }
+
+    inline size_t groupMask() const {
+        return m_capacity / GROUP_SIZE - 1;
+    }
+
+    static size_t allocationSize(size_t capacity) {
+        return capacity * (1 + sizeof(Slot));
+    }
+
+    static size_t maxLoad(size_t capacity) {
+        return capacity - capacity / 8;
+    }
+
+    /** Smallest table that holds entries without a rebuild */
+    static size_t capacityFor(size_t entries) {
+        size_t capacity = MIN_CAPACITY;
+        while (maxLoad(capacity) < entries + 1) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    /** Bit i is set when control byte i of the group equals value */
+    static inline uint32_t matchByte(const int8_t *group, int8_t value) {
+#ifdef __SSE2__
+        __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value))));
+#else
+        uint32_t mask = 0;
+        for (size_t ii = 0; ii < GROUP_SIZE; ii++) {
+            if (group[ii] == value) mask |= 1u << ii;
+        }
+        return mask;
+#endif
+    }
+
+    /** Bit i is set when slot i of the group is EMPTY or DELETED (sign bit set) */
+    static inline uint32_t matchFree(const int8_t *group) {
+#ifdef __SSE2__
+        __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(control));
+#else
+        uint32_t mask = 0;
+        for (size_t ii = 0; ii < GROUP_SIZE; ii++) {
+            if (group[ii] < 0) mask |= 1u << ii;
+        }
+        return mask;
+#endif
+    }
+
+    KeyHasher m_hasher;
+    KeyEqualityChecker m_eq;
+
+    int8_t *m_control;
+    Slot *m_slots;
+    size_t m_capacity;
+    // live slots, i.e. distinct keys
+    size_t m_size;
+    size_t m_tombstones;
+    // tuples, more than m_size when keys repeat
+    size_t m_entries;
+    size_t m_chainBytes;
+
+    KeyType m_tmp1;
+    KeyType m_tmp2;
+
+    // iteration stuff
+    Chain *m_matchChain;
+    size_t m_matchPosition;
+    TableTuple m_match;
+};
+
+}
+
+#endif // OPENHASHTABLEINDEX_H_
@@ -10,12 +10,15 @@
 #include <cstdlib>
 #include <iostream>
 
+#include "common/BlockAllocator.h"
 
 namespace h_index {
 
 template<typename ValueType> 
 /**
- * Custom allocator for all the indexes except array index.
+ * Custom allocator for all the indexes except array index. Memory comes from
+ * the BlockAllocator, so the large bucket arrays of the hash indexes can be
+ * on huge pages and on the site's NUMA node.
  */
 class AllocatorTracker : public std::allocator<ValueType> {
     public:
@@ -26,18 +29,23 @@ class AllocatorTracker : public std::allocator<ValueType> {
         // that's what we passed through copy constructor
         // all the stl and other stuff only use copy constructor
         int64_t *memory_size;
+        // owned by the index, like memory_size
+        voltdb::BlockAllocator *block_allocator;
 
         // This shouldn't be called. We should call the constructor with pointer to the memory_size.
         AllocatorTracker() throw() : BaseAllocator() {}
 
-        AllocatorTracker(int64_t* m_ptr) throw() : BaseAllocator() {
+        AllocatorTracker(int64_t* m_ptr, voltdb::BlockAllocator *blocks) throw() : BaseAllocator() {
             memory_size = m_ptr;
+            block_allocator = blocks;
         }
         AllocatorTracker(const AllocatorTracker& allocator) throw() : BaseAllocator(allocator) {
             memory_size = allocator.memory_size;
+            block_allocator = allocator.block_allocator;
         }
         template <class U> AllocatorTracker(const AllocatorTracker<U>& allocator) throw(): BaseAllocator(allocator) {
             memory_size = allocator.memory_size;
+            block_allocator = allocator.block_allocator;
         }
 
         ~AllocatorTracker() {}
@@ -47,7 +55,7 @@ class AllocatorTracker : public std::allocator<ValueType> {
         };
 
         pointer allocate(size_type size) {
-            pointer dataPtr = BaseAllocator::allocate(size);
+            pointer dataPtr = reinterpret_cast<pointer>(block_allocator->allocate(size * sizeof(ValueType)));
             *memory_size += size * sizeof(ValueType);
             VOLT_TRACE("allocate +++++++ %p %lu.\n", dataPtr, size * sizeof(ValueType));
             VOLT_TRACE("%s\n", typeid(ValueType).name());
@@ -55,7 +63,7 @@ class AllocatorTracker : public std::allocator<ValueType> {
         }
 
         pointer allocate(size_type size, pointer ptr) {
-            pointer dataPtr = BaseAllocator::allocate(size, ptr);
+            pointer dataPtr = reinterpret_cast<pointer>(block_allocator->allocate(size * sizeof(ValueType)));
             *memory_size += size * sizeof(ValueType);
             VOLT_TRACE("allocate +++++++ %p %lu.\n", dataPtr, size * sizeof(ValueType));
             VOLT_TRACE("%s\n", typeid(ValueType).name());
@@ -63,7 +71,7 @@ class AllocatorTracker : public std::allocator<ValueType> {
         }
 
         void deallocate(pointer ptr, size_type size) throw() {
-            BaseAllocator::deallocate(ptr, size);
+            block_allocator->deallocate(reinterpret_cast<char*>(ptr), size * sizeof(ValueType));
             *memory_size -= size * sizeof(ValueType);
         }
 
@@ -91,6 +91,31 @@ public:
     void setHash() {
         type = HASH_TABLE_INDEX;
     }
+    void setConcurrentTree() {
+        type = CONCURRENT_TREE_INDEX;
+    }
+};
+
+/**
+ * A scan over an index that does not share the index's own cursor, so
+ * that another thread than the one changing the index can run it. The
+ * methods behave like their TableIndex counterparts. The index has to
+ * outlive its cursors.
+ *
+ * @see TableIndex::newCursor()
+ */
+class IndexCursor
+{
+public:
+    virtual ~IndexCursor() {}
+
+    virtual bool moveToKey(const TableTuple *searchKey) = 0;
+    virtual TableTuple nextValueAtKey() = 0;
+    virtual bool advanceToNextKey() = 0;
+    virtual void moveToKeyOrGreater(const TableTuple *searchKey) = 0;
+    virtual void moveToGreaterThanKey(const TableTuple *searchKey) = 0;
+    virtual void moveToEnd(bool begin) = 0;
+    virtual TableTuple nextValue() = 0;
 };
 
 /**
@@ -323,6 +348,15 @@ public:
     
     virtual voltdb::IndexStats* getIndexStats();
 
+    /**
+     * A cursor that may scan this index on another thread while the
+     * site thread keeps changing it, NULL if the index does not allow
+     * that. The caller deletes the cursor.
+     */
+    virtual IndexCursor* newCursor() const {
+        return NULL;
+    }
+
 protected:
     TableIndex(const TableIndexScheme &scheme);
 
@@ -348,6 +382,8 @@ protected:
 
     // index memory size
     int64_t m_memoryEstimate;
+    // where the index's memory comes from, see AllocatorTracker
+    BlockAllocator m_blockAllocator;
 };
 
 }
@@ -55,6 +55,8 @@
 #include "indexes/BinaryTreeMultiMapIndex.h"
 #include "indexes/HashTableUniqueIndex.h"
 #include "indexes/HashTableMultiMapIndex.h"
+#include "indexes/OpenHashTableIndex.h"
+#include "indexes/ConcurrentTreeIndex.h"
 
 namespace voltdb {
 
@@ -87,6 +89,51 @@ namespace voltdb {
         if ((ints_only) && (unique) && (type == ARRAY_INDEX)) {
             return new ArrayUniqueIndex(schemeCopy);
         }
+        // unique and non-unique concurrent trees share one implementation
+        if ((ints_only) && (type == CONCURRENT_TREE_INDEX)) {
+            if (keySize <= sizeof(uint64_t)) {
+                return new ConcurrentTreeIndex<IntsKey<1>, IntsComparator<1>, IntsEqualityChecker<1> >(schemeCopy);
+            } else if (keySize <= sizeof(int64_t) * 2) {
+                return new ConcurrentTreeIndex<IntsKey<2>, IntsComparator<2>, IntsEqualityChecker<2> >(schemeCopy);
+            } else if (keySize <= sizeof(int64_t) * 3) {
+                return new ConcurrentTreeIndex<IntsKey<3>, IntsComparator<3>, IntsEqualityChecker<3> >(schemeCopy);
+            } else if (keySize <= sizeof(int64_t) * 4) {
+                return new ConcurrentTreeIndex<IntsKey<4>, IntsComparator<4>, IntsEqualityChecker<4> >(schemeCopy);
+            } else {
+                throwFatalException("We currently only support concurrent tree index on integer keys of size 32 bytes or smaller...");
+            }
+        }
+
+        if (type == CONCURRENT_TREE_INDEX) {
+            if (keySize <= 4) {
+                return new ConcurrentTreeIndex<GenericKey<4>, GenericComparator<4>, GenericEqualityChecker<4> >(schemeCopy);
+            } else if (keySize <= 8) {
+                return new ConcurrentTreeIndex<GenericKey<8>, GenericComparator<8>, GenericEqualityChecker<8> >(schemeCopy);
+            } else if (keySize <= 12) {
+                return new ConcurrentTreeIndex<GenericKey<12>, GenericComparator<12>, GenericEqualityChecker<12> >(schemeCopy);
+            } else if (keySize <= 16) {
+                return new ConcurrentTreeIndex<GenericKey<16>, GenericComparator<16>, GenericEqualityChecker<16> >(schemeCopy);
+            } else if (keySize <= 24) {
+                return new ConcurrentTreeIndex<GenericKey<24>, GenericComparator<24>, GenericEqualityChecker<24> >(schemeCopy);
+            } else if (keySize <= 32) {
+                return new ConcurrentTreeIndex<GenericKey<32>, GenericComparator<32>, GenericEqualityChecker<32> >(schemeCopy);
+            } else if (keySize <= 48) {
+                return new ConcurrentTreeIndex<GenericKey<48>, GenericComparator<48>, GenericEqualityChecker<48> >(schemeCopy);
+            } else if (keySize <= 64) {
+                return new ConcurrentTreeIndex<GenericKey<64>, GenericComparator<64>, GenericEqualityChecker<64> >(schemeCopy);
+            } else if (keySize <= 96) {
+                return new ConcurrentTreeIndex<GenericKey<96>, GenericComparator<96>, GenericEqualityChecker<96> >(schemeCopy);
+            } else if (keySize <= 128) {
+                return new ConcurrentTreeIndex<GenericKey<128>, GenericComparator<128>, GenericEqualityChecker<128> >(schemeCopy);
+            } else if (keySize <= 256) {
+                return new ConcurrentTreeIndex<GenericKey<256>, GenericComparator<256>, GenericEqualityChecker<256> >(schemeCopy);
+            } else if (keySize <= 512) {
+                return new ConcurrentTreeIndex<GenericKey<512>, GenericComparator<512>, GenericEqualityChecker<512> >(schemeCopy);
+            } else {
+                throwFatalException( "We currently only support concurrent tree index on keys of up to 512 bytes..." );
+            }
+        }
+
         if ((ints_only) && (type == BALANCED_TREE_INDEX) && (unique)) {
             if (keySize <= sizeof(uint64_t)) {
                 return new BinaryTreeUniqueIndex<IntsKey<1>, IntsComparator<1>, IntsEqualityChecker<1> >(schemeCopy);
@@ -115,31 +162,17 @@ namespace voltdb {
             }
         }
         
-        if ((ints_only) && (type == HASH_TABLE_INDEX) && (unique)) {
-            if (keySize <= sizeof(uint64_t)) {
-                return new HashTableUniqueIndex<IntsKey<1>, IntsHasher<1>, IntsEqualityChecker<1> >(schemeCopy);
-            } else if (keySize <= sizeof(int64_t) * 2) {
-                return new HashTableUniqueIndex<IntsKey<2>, IntsHasher<2>, IntsEqualityChecker<2> >(schemeCopy);
-            } else if (keySize <= sizeof(int64_t) * 3) {
-                return new HashTableUniqueIndex<IntsKey<3>, IntsHasher<3>, IntsEqualityChecker<3> >(schemeCopy);
-            } else if (keySize <= sizeof(int64_t) * 4) {
-                return new HashTableUniqueIndex<IntsKey<4>, IntsHasher<4>, IntsEqualityChecker<4> >(schemeCopy);
-            } else {
-                throwFatalException( "We currently only support hash index on unique integer keys of size 32 bytes or smaller..." );
-            }
-        }
-        
-        if ((ints_only) && (type == HASH_TABLE_INDEX) && (!unique)) {
+        if ((ints_only) && (type == HASH_TABLE_INDEX)) {
             if (keySize <= sizeof(uint64_t)) {
-                return new HashTableMultiMapIndex<IntsKey<1>, IntsHasher<1>, IntsEqualityChecker<1> >(schemeCopy);
+                return new OpenHashTableIndex<IntsKey<1>, IntsHasher<1>, IntsEqualityChecker<1> >(schemeCopy);
             } else if (keySize <= sizeof(int64_t) * 2) {
-                return new HashTableMultiMapIndex<IntsKey<2>, IntsHasher<2>, IntsEqualityChecker<2> >(schemeCopy);
+                return new OpenHashTableIndex<IntsKey<2>, IntsHasher<2>, IntsEqualityChecker<2> >(schemeCopy);
             } else if (keySize <= sizeof(int64_t) * 3) {
-                return new HashTableMultiMapIndex<IntsKey<3>, IntsHasher<3>, IntsEqualityChecker<3> >(schemeCopy);
+                return new OpenHashTableIndex<IntsKey<3>, IntsHasher<3>, IntsEqualityChecker<3> >(schemeCopy);
             } else if (keySize <= sizeof(int64_t) * 4) {
-                return new HashTableMultiMapIndex<IntsKey<4>, IntsHasher<4>, IntsEqualityChecker<4> >(schemeCopy);
+                return new OpenHashTableIndex<IntsKey<4>, IntsHasher<4>, IntsEqualityChecker<4> >(schemeCopy);
             } else {
-                throwFatalException( "We currently only support hash index on non-unique integer keys of size 32 bytes of smaller..." );
+                throwFatalException( "We currently only support hash index on integer keys of size 32 bytes or smaller..." );
             }
         }
         
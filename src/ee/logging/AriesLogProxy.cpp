@@ -16,7 +16,12 @@
  */
 #include "AriesLogProxy.h"
 #include "execution/VoltDBEngine.h"
+#include "common/FatalException.hpp"
+#include <algorithm>
 #include <string>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
 
 using std::ios;
 using std::string;
@@ -28,6 +33,16 @@ using namespace voltdb;
 //XXX Must match with HStoreSite
 string AriesLogProxy::defaultLogfileName = "aries.log";
 
+const size_t AriesLogProxy::DEFAULT_GROUP_COMMIT_BYTES;
+const int AriesLogProxy::DEFAULT_GROUP_COMMIT_RECORDS;
+const int64_t AriesLogProxy::DEFAULT_GROUP_COMMIT_MICROS;
+
+static inline int64_t nowMicros() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
 AriesLogProxy::AriesLogProxy(VoltDBEngine *engine) {
 	init(engine, defaultLogfileName);
 }
@@ -38,39 +53,77 @@ AriesLogProxy::AriesLogProxy(VoltDBEngine *engine, string logfileName) {
 
 void AriesLogProxy::init(VoltDBEngine *engine, string logfileName) {
 	this->logFileName = logfileName;
+	this->engine = engine;
 	// XXX originally true
 	jniLogging = false;
 
-	if (!jniLogging) {
-		// append + binary mode
-		logFile = fopen(logfileName.c_str(), "ab+");
-		logFileFD = fileno(logFile);
+	writer = NULL;
+	flusherRunning = false;
+	stopping = false;
+	filling = &buffers[0];
+	flushing = &buffers[1];
+	bufferedRecords = 0;
+	batchStartMicros = 0;
+	appendedLsn = 0;
+	durableLsn = 0;
+	forcedLsn = 0;
+	syncCount = 0;
 
-		if(logFile != NULL){
-			VOLT_DEBUG("AriesLogProxy : opened logfile %s ", logFileName.c_str());
-		}
-		else{
-			VOLT_ERROR("AriesLogProxy : cannot open logfile %s ", logFileName.c_str());
-		}
+	groupCommitBytes = DEFAULT_GROUP_COMMIT_BYTES;
+	groupCommitRecords = DEFAULT_GROUP_COMMIT_RECORDS;
+	groupCommitMicros = DEFAULT_GROUP_COMMIT_MICROS;
+	syncOnCommit = true;
+	useDSync = false;
+
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&batchReady, NULL);
+	pthread_cond_init(&progress, NULL);
+
+	if (!jniLogging) {
+		// LSNs continue from wherever the previous incarnation stopped
+		writer = new LogWriter(logFileName, useDSync);
+		appendedLsn = durableLsn = forcedLsn = writer->size();
+		VOLT_DEBUG("AriesLogProxy : opened logfile %s ", logFileName.c_str());
+		startFlusher();
 	} else {
 		if (engine == NULL) {
 			cout << "what in the god's name is this shit " << endl;
 		}
-		this->engine = engine;
 	}
 }
 
 AriesLogProxy::~AriesLogProxy() {
-	if(logFile != NULL){
-		int ret = fclose(logFile);
+	// the flusher writes out whatever is still buffered before it exits
+	stopFlusher();
+	if (!error.empty()) {
+		VOLT_ERROR("AriesLogProxy : log %s lost records after lsn %ld : %s",
+				logFileName.c_str(), durableLsn, error.c_str());
+	}
+	delete writer;
 
-		if(ret == 0){
-			VOLT_DEBUG("AriesLogProxy : closed logfile %s", logFileName.c_str());
-		}
-		else{
-			VOLT_ERROR("AriesLogProxy : could not close logfile %s", logFileName.c_str());
-		}
+	pthread_cond_destroy(&progress);
+	pthread_cond_destroy(&batchReady);
+	pthread_mutex_destroy(&mutex);
+}
+
+void AriesLogProxy::startFlusher() {
+	stopping = false;
+	if (pthread_create(&flusher, NULL, runFlusher, this) != 0) {
+		throwFatalException("AriesLogProxy : failed to start the flusher for %s", logFileName.c_str());
+	}
+	flusherRunning = true;
+}
+
+void AriesLogProxy::stopFlusher() {
+	if (!flusherRunning) {
+		return;
 	}
+	pthread_mutex_lock(&mutex);
+	stopping = true;
+	pthread_cond_signal(&batchReady);
+	pthread_mutex_unlock(&mutex);
+	pthread_join(flusher, NULL);
+	flusherRunning = false;
 }
 
 AriesLogProxy* AriesLogProxy::getAriesLogProxy(VoltDBEngine *engine) {
@@ -157,32 +210,210 @@ void AriesLogProxy::logBinaryOutput(const char *data, size_t size) {
 	}
 }
 
+void AriesLogProxy::setGroupCommitPolicy(size_t maxBytes, int maxRecords, int64_t maxMicros, bool syncOnCommit) {
+	pthread_mutex_lock(&mutex);
+	// a batch can never be larger than the buffer holding it
+	this->groupCommitBytes = (maxBytes > MinimalBuffer::BUFFER_SIZE ? MinimalBuffer::BUFFER_SIZE : maxBytes);
+	this->groupCommitRecords = maxRecords;
+	this->groupCommitMicros = maxMicros;
+	this->syncOnCommit = syncOnCommit;
+	// the flusher may be sleeping on the old interval
+	pthread_cond_signal(&batchReady);
+	pthread_mutex_unlock(&mutex);
+}
+
+void AriesLogProxy::setUseDSync(bool useDSync) {
+	if (this->useDSync == useDSync || writer == NULL) {
+		this->useDSync = useDSync;
+		return;
+	}
+	// nothing may be in flight while the file gets reopened
+	flush();
+	stopFlusher();
+	this->useDSync = useDSync;
+	delete writer;
+	writer = NULL;
+	writer = new LogWriter(logFileName, useDSync);
+	startFlusher();
+}
+
+int64_t AriesLogProxy::getAppendedLsn() {
+	pthread_mutex_lock(&mutex);
+	int64_t lsn = appendedLsn;
+	pthread_mutex_unlock(&mutex);
+	return lsn;
+}
+
+int64_t AriesLogProxy::getDurableLsn() {
+	pthread_mutex_lock(&mutex);
+	int64_t lsn = durableLsn;
+	pthread_mutex_unlock(&mutex);
+	return lsn;
+}
+
+int64_t AriesLogProxy::getSyncCount() {
+	pthread_mutex_lock(&mutex);
+	int64_t count = syncCount;
+	pthread_mutex_unlock(&mutex);
+	return count;
+}
+
 void AriesLogProxy::logLocally(const char *data, size_t size) {
-	size_t s_ret = -1;
-	int ret = -1;
+	if (writer == NULL) {
+		VOLT_ERROR("logLocally failed : logfile %s is not open", logFileName.c_str());
+		return;
+	}
 
-	s_ret = fwrite (data , sizeof(char), size, logFile);
-	if(s_ret != size){
-		VOLT_ERROR("logLocally failed : badbit set");
+	pthread_mutex_lock(&mutex);
+	checkErrorLocked();
+	if (bufferedRecords == 0) {
+		batchStartMicros = nowMicros();
 	}
+	// the log is a byte stream, so a record may straddle two batches
+	while (size > 0) {
+		if (filling->full()) {
+			forcedLsn = appendedLsn;
+			pthread_cond_signal(&batchReady);
+			while (filling->full() && error.empty()) {
+				pthread_cond_wait(&progress, &mutex);
+			}
+			checkErrorLocked();
+		}
+		size_t copied = filling->append(data, size);
+		data += copied;
+		size -= copied;
+		appendedLsn += copied;
+	}
+	bufferedRecords++;
 
-	ret = fflush(logFile);
-	if(ret == 0){
-	 	VOLT_DEBUG("logLocally : flushed : file pos %ld", ftell(logFile));
+	// wake the flusher when a batch opens, so it can start its timer
+	if (bufferedRecords == 1 || batchClosed()) {
+		pthread_cond_signal(&batchReady);
 	}
-	else{
-	 	VOLT_ERROR("logLocally : flushed : file pos %ld", ftell(logFile));
+	pthread_mutex_unlock(&mutex);
+}
+
+bool AriesLogProxy::batchClosed() const {
+	if (filling->available() == 0) {
+		return false;
 	}
+	int64_t batchStartLsn = appendedLsn - filling->available();
+	return stopping || forcedLsn > batchStartLsn || filling->full()
+			|| static_cast<size_t>(filling->available()) >= groupCommitBytes
+			|| bufferedRecords >= groupCommitRecords
+			|| nowMicros() - batchStartMicros >= groupCommitMicros;
+}
 
-	// SYNC changes
-	ret = fsync(logFileFD);
-	if(ret == 0){
-		VOLT_DEBUG("logLocally : synced file");
+void* AriesLogProxy::runFlusher(void* proxy) {
+	static_cast<AriesLogProxy*>(proxy)->flushBatches();
+	return NULL;
+}
+
+void AriesLogProxy::flushBatches() {
+	pthread_mutex_lock(&mutex);
+	while (error.empty() && !(stopping && filling->available() == 0)) {
+		if (!batchClosed()) {
+			if (filling->available() == 0) {
+				pthread_cond_wait(&batchReady, &mutex);
+			} else {
+				// sleep until the oldest record in the batch hits the interval
+				if (groupCommitMicros < 0 || groupCommitMicros > INT64_MAX - batchStartMicros) {
+					pthread_cond_wait(&batchReady, &mutex);
+				} else {
+					int64_t deadline = batchStartMicros + groupCommitMicros;
+					timespec ts;
+					ts.tv_sec = static_cast<time_t>(deadline / 1000000);
+					ts.tv_nsec = static_cast<long>((deadline % 1000000) * 1000);
+					pthread_cond_timedwait(&batchReady, &mutex, &ts);
+				}
+			}
+			continue;
+		}
+
+		std::swap(filling, flushing);
+		int64_t batchLsn = appendedLsn;
+		bufferedRecords = 0;
+		batchStartMicros = nowMicros();
+		// appenders waiting for room can use the other buffer now
+		pthread_cond_broadcast(&progress);
+		pthread_mutex_unlock(&mutex);
+
+		string failure;
+		try {
+			writer->syncWriteBuffer(flushing);
+		} catch (FatalException &e) {
+			failure = e.m_reason;
+		} catch (...) {
+			failure = "unknown error";
+		}
+
+		pthread_mutex_lock(&mutex);
+		if (failure.empty()) {
+			durableLsn = batchLsn;
+			syncCount++;
+			VOLT_DEBUG("logLocally : synced file up to lsn %ld", durableLsn);
+		} else {
+			error = failure;
+		}
+		pthread_cond_broadcast(&progress);
 	}
-	else{
-		VOLT_ERROR("logLocally : could not sync file ");
+	pthread_mutex_unlock(&mutex);
+}
+
+void AriesLogProxy::waitForDurableLsn(int64_t lsn) {
+	pthread_mutex_lock(&mutex);
+	waitForDurableLsnLocked(lsn);
+	pthread_mutex_unlock(&mutex);
+}
+
+void AriesLogProxy::waitForDurableLsnLocked(int64_t lsn) {
+	while (durableLsn < lsn && error.empty()) {
+		pthread_cond_wait(&progress, &mutex);
+	}
+	checkErrorLocked();
+}
+
+void AriesLogProxy::commit() {
+	pthread_mutex_lock(&mutex);
+	if (syncOnCommit) {
+		// the site thread is the only committer, so nobody else can join
+		// this batch: close it now instead of waiting out the timer
+		if (forcedLsn < appendedLsn) {
+			forcedLsn = appendedLsn;
+			pthread_cond_signal(&batchReady);
+		}
+		waitForDurableLsnLocked(appendedLsn);
+	} else {
+		checkErrorLocked();
 	}
+	pthread_mutex_unlock(&mutex);
+}
+
+void AriesLogProxy::flush() {
+	if (writer == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&mutex);
+	forcedLsn = appendedLsn;
+	pthread_cond_signal(&batchReady);
+	waitForDurableLsnLocked(forcedLsn);
+	pthread_mutex_unlock(&mutex);
+}
 
+void AriesLogProxy::checkError() {
+	pthread_mutex_lock(&mutex);
+	checkErrorLocked();
+	pthread_mutex_unlock(&mutex);
+}
+
+// Releases the mutex before it throws
+void AriesLogProxy::checkErrorLocked() {
+	if (!error.empty()) {
+		string reason = error;
+		pthread_mutex_unlock(&mutex);
+		throwFatalException("AriesLogProxy : log %s is not durable past lsn %ld : %s",
+				logFileName.c_str(), durableLsn, reason.c_str());
+	}
 }
 
 void AriesLogProxy::logToEngineBuffer(const char *data, size_t size) {
@@ -20,10 +20,13 @@
 
 #include "logging/LogDefs.h"
 #include "logging/LogProxy.h"
+#include "logging/LogWriter.h"
 
 #include <iostream>
 #include <cstdio>
 #include <fstream>
+#include <stdint.h>
+#include <pthread.h>
 
 namespace voltdb {
 class VoltDBEngine;
@@ -31,6 +34,20 @@ class VoltDBEngine;
 /**
  * A log proxy implementation geared toward Aries. Implements an
  * extra function to log binary output to files.
+ *
+ * Local logging is group committed: records are appended to a MinimalBuffer
+ * and a flusher thread writes + syncs each batch through a LogWriter. A
+ * batch is closed when it holds groupCommitBytes bytes or
+ * groupCommitRecords records, or when its oldest record is
+ * groupCommitMicros old. A commit closes the open batch right away and
+ * waits for the flush that covers it, so every record logged since the
+ * previous commit shares that one sync.
+ *
+ * LSNs are byte offsets into the log file, so a record is durable once
+ * getDurableLsn() has passed the LSN returned by getAppendedLsn() right
+ * after it was logged. A failed write or sync stops the flusher, leaves the
+ * durable LSN where it was and is raised as a fatal exception on the site
+ * thread by the next call that logs, commits, flushes or checks.
  */
 class AriesLogProxy : public LogProxy {
 public:
@@ -44,18 +61,91 @@ public:
 	std::string getLogFileName();
 	static std::string defaultLogfileName;
 
+	// group commit defaults
+	static const size_t DEFAULT_GROUP_COMMIT_BYTES = 256 << 10;
+	static const int DEFAULT_GROUP_COMMIT_RECORDS = 1024;
+	static const int64_t DEFAULT_GROUP_COMMIT_MICROS = 2000;
+
+	/**
+	 * Change when a batch gets closed. If syncOnCommit is true, the undo
+	 * token release path blocks until the batch holding the transaction's
+	 * records is durable; otherwise commits don't wait at all.
+	 */
+	void setGroupCommitPolicy(size_t maxBytes, int maxRecords, int64_t maxMicros, bool syncOnCommit);
+
+	/** Open the log with O_DSYNC instead of calling fdatasync per batch. */
+	void setUseDSync(bool useDSync);
+
+	/** LSN just past the last record handed to logBinaryOutput */
+	int64_t getAppendedLsn();
+
+	/** LSN up to which the log is known to be on stable storage */
+	int64_t getDurableLsn();
+
+	/** Number of write + sync round trips issued so far */
+	int64_t getSyncCount();
+
+	/** Block until everything before lsn is on disk */
+	void waitForDurableLsn(int64_t lsn);
+
+	/**
+	 * Called when a transaction's undo token is released. Waits for the
+	 * transaction's records to be durable if syncOnCommit is set.
+	 */
+	void commit();
+
+	/** Close the current batch right away and wait for it to be durable */
+	void flush();
+
+	/** Raise a failed write or sync from the flusher thread */
+	void checkError();
+
 private:
 	AriesLogProxy(VoltDBEngine*);
 	AriesLogProxy(VoltDBEngine*, std::string logfileName);
 
 	void init(VoltDBEngine*, std::string logfileName);
+	void startFlusher();
+	void stopFlusher();
 
 	void logLocally(const char *data, size_t size);
 	void logToEngineBuffer(const char *data, size_t size);
 
+	static void* runFlusher(void* proxy);
+	void flushBatches();
+	bool batchClosed() const;
+	void waitForDurableLsnLocked(int64_t lsn);
+	void checkErrorLocked();
+
 	std::string logFileName;
-	FILE* logFile;
-	int logFileFD; // fd equivalent for fsync
+	LogWriter* writer;
+
+	// guards everything below
+	pthread_mutex_t mutex;
+	pthread_cond_t batchReady;
+	pthread_cond_t progress;
+	pthread_t flusher;
+	bool flusherRunning;
+	bool stopping;
+	std::string error;
+
+	// the site thread fills one buffer while the flusher writes the other
+	MinimalBuffer buffers[2];
+	MinimalBuffer* filling;
+	MinimalBuffer* flushing;
+	int bufferedRecords;
+	int64_t batchStartMicros;
+
+	int64_t appendedLsn;
+	int64_t durableLsn;
+	int64_t forcedLsn;
+	int64_t syncCount;
+
+	size_t groupCommitBytes;
+	int groupCommitRecords;
+	int64_t groupCommitMicros;
+	bool syncOnCommit;
+	bool useDSync;
 
 	bool jniLogging;
 	VoltDBEngine* engine;
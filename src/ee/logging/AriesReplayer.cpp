@@ -0,0 +1,326 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <arpa/inet.h>
+
+#include "common/FatalException.hpp"
+#include "common/Pool.hpp"
+#include "common/SerializableEEException.h"
+#include "common/UndoQuantum.h"
+#include "common/DummyUndoQuantum.hpp"
+#include "common/debuglog.h"
+#include "storage/persistenttable.h"
+#include "AriesReplayer.h"
+
+using namespace voltdb;
+
+AriesReplayer::AriesReplayer(int32_t siteId, int64_t replayTxnId)
+    : m_siteId(siteId),
+      m_replayTxnId(replayTxnId),
+      m_endOfLog(NULL),
+      m_nextStream(0),
+      m_replayed(0)
+{
+    pthread_mutex_init(&m_mutex, NULL);
+}
+
+AriesReplayer::~AriesReplayer() {
+    pthread_mutex_destroy(&m_mutex);
+}
+
+size_t AriesReplayer::partition(const char *logData, size_t length, const std::map<int32_t, Table*> &tables) {
+    m_endOfLog = logData + length;
+    m_streams.clear();
+    size_t serialLength = 0;
+    ReferenceSerializeInput input(logData, length);
+
+    while (true) {
+        const char *frame = reinterpret_cast<const char*>(input.getRawPointer(0));
+        int64_t available = m_endOfLog - frame;
+        if (available < static_cast<int64_t>(CompactLogRecord::FRAME_HEADER_SIZE)) {
+            break;
+        }
+        if (!CompactLogRecord::isCompactRecord(frame, available)) {
+            int32_t recordSize;
+            memcpy(&recordSize, frame, sizeof(recordSize));
+            recordSize = ntohl(recordSize);
+            if (recordSize <= OFFSET_TO_TXNTYPE) {
+                // junk at the tail
+                break;
+            }
+
+            int64_t skip = sizeof(int32_t) + recordSize;
+            if (skip > available) {
+                VOLT_WARN("ARIES : truncated log record at the end of the log");
+                break;
+            }
+            int8_t txnType;
+            memcpy(&txnType, frame + sizeof(int32_t) + OFFSET_TO_TXNTYPE, sizeof(txnType));
+            if (txnType == static_cast<int8_t>(LogRecord::T_BULKLOAD)) {
+                if (available - skip < static_cast<int64_t>(sizeof(int64_t))) {
+                    break;
+                }
+                int64_t numBulkLoadBytes;
+                memcpy(&numBulkLoadBytes, frame + skip, sizeof(numBulkLoadBytes));
+                numBulkLoadBytes = ntohll(numBulkLoadBytes);
+                skip += sizeof(int64_t);
+                if (numBulkLoadBytes < 0 || numBulkLoadBytes > available - skip) {
+                    break;
+                }
+                skip += numBulkLoadBytes;
+            }
+
+            // Only the serial loop understands LogRecords, and the compact
+            // records before one may touch the same rows, so all of it goes
+            // to the serial loop and the streams start over after it.
+            input.getRawPointer(skip);
+            serialLength = (frame + skip) - logData;
+            m_streams.clear();
+            continue;
+        }
+
+        int32_t payloadLength;
+        memcpy(&payloadLength, frame + sizeof(int32_t), sizeof(payloadLength));
+        payloadLength = ntohl(payloadLength);
+        if (payloadLength <= 0 ||
+            payloadLength > available - static_cast<int64_t>(CompactLogRecord::FRAME_HEADER_SIZE)) {
+            VOLT_WARN("ARIES : truncated log record at the end of the log");
+            break;
+        }
+
+        CompactLogRecord logrecord(input);
+        if (!logrecord.isValidRecord()) {
+            break;
+        }
+
+        if (logrecord.hasTrailingLoadData()) {
+            if (m_endOfLog - reinterpret_cast<const char*>(input.getRawPointer(0)) < static_cast<int64_t>(sizeof(int64_t))) {
+                break;
+            }
+            int64_t numBulkLoadBytes = input.readLong();
+            if (numBulkLoadBytes < 0 ||
+                numBulkLoadBytes > m_endOfLog - reinterpret_cast<const char*>(input.getRawPointer(0))) {
+                break;
+            }
+            input.getRawPointer(numBulkLoadBytes);
+        }
+
+        if ((logrecord.getTransactionId() < m_replayTxnId) || (logrecord.getExecutionSiteId() != m_siteId)) {
+            continue;
+        }
+
+        std::map<int32_t, Stream>::iterator stream = m_streams.find(logrecord.getTableId());
+        if (stream == m_streams.end()) {
+            std::map<int32_t, Table*>::const_iterator table = tables.find(logrecord.getTableId());
+            PersistentTable *persistentTable = (table != tables.end()) ?
+                dynamic_cast<PersistentTable*>(table->second) : NULL;
+            if (persistentTable == NULL) {
+                // same as the serial replay, an unknown table ends the log
+                VOLT_ERROR("ARIES : log record for unknown table id %d", logrecord.getTableId());
+                break;
+            }
+            stream = m_streams.insert(std::make_pair(logrecord.getTableId(), Stream())).first;
+            stream->second.table = persistentTable;
+        }
+        stream->second.records.push_back(frame);
+    }
+    if (serialLength > 0) {
+        VOLT_WARN("ARIES : log has LogRecord entries, replaying the first %lu bytes serially",
+                  (unsigned long) serialLength);
+    }
+    return serialLength;
+}
+
+int32_t AriesReplayer::replay(int numThreads) {
+    std::vector<Stream*> serialStreams;
+    m_parallelStreams.clear();
+    for (std::map<int32_t, Stream>::iterator i = m_streams.begin(); i != m_streams.end(); i++) {
+        if (i->second.table->hasMaterializedViews()) {
+            serialStreams.push_back(&i->second);
+        } else {
+            m_parallelStreams.push_back(&i->second);
+        }
+    }
+
+    // hand out the longest streams first so one big table doesn't start last
+    std::vector<std::pair<size_t, Stream*> > bySize;
+    for (size_t i = 0; i < m_parallelStreams.size(); i++) {
+        bySize.push_back(std::make_pair(m_parallelStreams[i]->records.size(), m_parallelStreams[i]));
+    }
+    std::sort(bySize.begin(), bySize.end());
+    for (size_t i = 0; i < bySize.size(); i++) {
+        m_parallelStreams[i] = bySize[bySize.size() - 1 - i].second;
+    }
+    m_nextStream = 0;
+    m_replayed = 0;
+
+    numThreads = std::min(numThreads, static_cast<int>(m_parallelStreams.size()));
+    std::vector<pthread_t> threads;
+    for (int i = 1; i < numThreads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, replayThread, this) != 0) {
+            VOLT_WARN("ARIES : could not start recovery thread, continuing with %d", i);
+            break;
+        }
+        threads.push_back(thread);
+    }
+    // the calling thread takes part too
+    replayStreams();
+    for (size_t i = 0; i < threads.size(); i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (m_error.empty()) {
+        Pool stringPool;
+        for (size_t i = 0; i < serialStreams.size(); i++) {
+            m_replayed += replayStream(*serialStreams[i], &stringPool);
+        }
+    }
+
+    if (!m_error.empty()) {
+        throwFatalException("ARIES : recovery failed: %s", m_error.c_str());
+    }
+    VOLT_DEBUG("ARIES : replayed %d records from %d tables on %d threads",
+               m_replayed, (int) m_streams.size(), (int) threads.size() + 1);
+    return m_replayed;
+}
+
+void* AriesReplayer::replayThread(void *arg) {
+    static_cast<AriesReplayer*>(arg)->replayStreams();
+    return NULL;
+}
+
+void AriesReplayer::replayStreams() {
+    DummyUndoQuantum undoQuantum;
+    Pool stringPool;
+    int32_t replayed = 0;
+
+    while (true) {
+        pthread_mutex_lock(&m_mutex);
+        Stream *stream = NULL;
+        if (m_error.empty() && m_nextStream < m_parallelStreams.size()) {
+            stream = m_parallelStreams[m_nextStream++];
+        }
+        pthread_mutex_unlock(&m_mutex);
+        if (stream == NULL) {
+            break;
+        }
+
+        stream->table->setUndoQuantumOverride(&undoQuantum);
+        try {
+            replayed += replayStream(*stream, &stringPool);
+        } catch (SerializableEEException &e) {
+            pthread_mutex_lock(&m_mutex);
+            if (m_error.empty()) {
+                m_error = stream->table->name() + ": " + e.message();
+            }
+            pthread_mutex_unlock(&m_mutex);
+        }
+        stream->table->setUndoQuantumOverride(NULL);
+    }
+
+    pthread_mutex_lock(&m_mutex);
+    m_replayed += replayed;
+    pthread_mutex_unlock(&m_mutex);
+}
+
+int32_t AriesReplayer::replayStream(Stream &stream, Pool *stringPool) {
+    for (size_t i = 0; i < stream.records.size(); i++) {
+        const char *frame = stream.records[i];
+        ReferenceSerializeInput input(frame, m_endOfLog - frame);
+        // partition() already checked every frame
+        CompactLogRecord logrecord(input, false);
+        applyRecord(stream.table, logrecord, input, stringPool, true);
+    }
+    stream.table->finishRecoveryAppends();
+    return static_cast<int32_t>(stream.records.size());
+}
+
+void AriesReplayer::applyRecord(PersistentTable *table, CompactLogRecord &logrecord,
+                                ReferenceSerializeInput &input, Pool *stringPool, bool deferIndexes) {
+    if (logrecord.getType() != LogRecord::T_INSERT || !deferIndexes) {
+        // everything but an insert needs the earlier inserts to be indexed
+        table->finishRecoveryAppends();
+    }
+
+    if (logrecord.getType() == LogRecord::T_BULKLOAD) {
+        VOLT_DEBUG("Log record recovery : BULKLOAD");
+        int64_t numBulkLoadBytes = input.readLong();
+        ReferenceSerializeInput bulkIn(input.getRawPointer(numBulkLoadBytes), numBulkLoadBytes);
+        table->loadTuplesFrom(false, bulkIn);
+        return;
+    } else if (logrecord.getType() == LogRecord::T_TRUNCATE) {
+        VOLT_DEBUG("Log record recovery : TRUNCATE");
+        table->deleteAllTuples(true);
+        return;
+    }
+
+    logrecord.populateFields(table->schema(), table->primaryKeyIndex(), stringPool);
+    if (!logrecord.isValidRecord()) {
+        stringPool->purge();
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "ARIES : log record does not match its table");
+    }
+
+    TableTuple *beforeImage = logrecord.getTupleBeforeImage();
+    TableTuple *afterImage = logrecord.getTupleAfterImage();
+
+    // without a primary key the before image is a copy, find the live tuple
+    TableTuple target(table->schema());
+    if (beforeImage != NULL) {
+        target = (table->primaryKeyIndex() != NULL) ? *beforeImage : table->lookupTuple(*beforeImage);
+    }
+
+    if (logrecord.getType() == LogRecord::T_INSERT) {
+        VOLT_DEBUG("Log record recovery : INSERT");
+        if (afterImage != NULL) {
+            if (deferIndexes) {
+                table->appendTupleForRecovery(*afterImage);
+            } else {
+                table->insertTuple(*afterImage);
+            }
+        }
+    } else if (logrecord.getType() == LogRecord::T_UPDATE) {
+        VOLT_DEBUG("Log record recovery : UPDATE");
+        if (!target.isNullTuple() && afterImage != NULL) {
+            table->updateTuple(*afterImage, target, true);
+        } else {
+            VOLT_WARN("ARIES : update of a tuple missing from table '%s'", table->name().c_str());
+        }
+    } else if (logrecord.getType() == LogRecord::T_DELETE) {
+        VOLT_DEBUG("Log record recovery : DELETE");
+        if (!target.isNullTuple()) {
+            table->deleteTuple(target, true);
+        } else {
+            VOLT_WARN("ARIES : delete of a tuple missing from table '%s'", table->name().c_str());
+        }
+    } else {
+        VOLT_WARN("Log record recovery : Invalid Record");
+    }
+
+    stringPool->purge();
+}
@@ -0,0 +1,121 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ARIESREPLAYER_H_
+#define ARIESREPLAYER_H_
+
+#include "common/serializeio.h"
+#include "logging/CompactLogrecord.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stdint.h>
+
+namespace voltdb {
+
+class Pool;
+class Table;
+class PersistentTable;
+
+/**
+ * Parallel replay of an ARIES log made of CompactLogRecords.
+ *
+ * All the changes a site makes to a table are logged in order, and records
+ * of different tables never depend on each other. partition() therefore
+ * splits the log into one stream per table, and replay() hands the streams
+ * to a pool of threads. Every thread registers its tables' UndoActions with
+ * its own DummyUndoQuantum, so the only state the threads share is the
+ * read-only log.
+ *
+ * Within a stream, a run of inserts is appended without index maintenance
+ * and indexed in one pass once the run ends. Tables that feed materialized
+ * views also write to the view's table, so they are replayed on the calling
+ * thread after the pool is done.
+ */
+class AriesReplayer {
+public:
+    AriesReplayer(int32_t siteId, int64_t replayTxnId);
+    ~AriesReplayer();
+
+    /**
+     * Split the log into per-table streams, skipping records of other sites
+     * and of transactions before the replay point. Scanning stops at the
+     * first torn or corrupted record.
+     *
+     * Records in the old LogRecord format are only understood by the serial
+     * replay in VoltDBEngine. Returns the length of the log prefix that ends
+     * with the last of them, which the caller has to replay serially before
+     * replay() is run; the streams only hold the records after it.
+     */
+    size_t partition(const char *logData, size_t length, const std::map<int32_t, Table*> &tables);
+
+    /**
+     * Replay the streams on up to numThreads threads and return the number
+     * of records replayed.
+     */
+    int32_t replay(int numThreads);
+
+    size_t streamCount() const {
+        return m_streams.size();
+    }
+
+    /**
+     * Apply one record to its table. input must be positioned after the
+     * record, where the bytes of a bulk load follow it. With deferIndexes,
+     * inserts are only appended and the table must be finished with
+     * PersistentTable::finishRecoveryAppends() before it is read.
+     */
+    static void applyRecord(PersistentTable *table, CompactLogRecord &logrecord,
+                            ReferenceSerializeInput &input, Pool *stringPool, bool deferIndexes);
+
+private:
+    struct Stream {
+        PersistentTable *table;
+        std::vector<const char*> records;
+    };
+
+    static void* replayThread(void *arg);
+    void replayStreams();
+    int32_t replayStream(Stream &stream, Pool *stringPool);
+
+    const int32_t m_siteId;
+    const int64_t m_replayTxnId;
+    const char *m_endOfLog;
+
+    std::map<int32_t, Stream> m_streams;
+
+    // streams handed out to the pool, largest first
+    std::vector<Stream*> m_parallelStreams;
+    size_t m_nextStream;
+    int32_t m_replayed;
+    std::string m_error;
+    pthread_mutex_t m_mutex;
+};
+
+}
+
+#endif /* ARIESREPLAYER_H_ */
@@ -0,0 +1,324 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <arpa/inet.h>
+
+#include "common/NValue.hpp"
+#include "common/Pool.hpp"
+#include "common/SerializableEEException.h"
+#include "common/crc32c.h"
+#include "common/debuglog.h"
+#include "CompactLogrecord.h"
+
+using namespace voltdb;
+
+const int32_t CompactLogRecord::MAGIC;
+const size_t CompactLogRecord::FRAME_HEADER_SIZE;
+
+static inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static inline void writeTypedValue(SerializeOutput &output, const NValue &value) {
+    output.writeByte(static_cast<int8_t>(ValuePeeker::peekValueType(value)));
+    value.serializeTo(output);
+}
+
+CompactLogRecord::CompactLogRecord(LogRecord::Logrec_type_t type, LogRecord::Logrec_category_t category,
+                                   int64_t lsn, int64_t prevLsn, int64_t xid, int32_t execSiteId, int32_t tableId,
+                                   TableIndex *pkeyIndex, const std::vector<int32_t> *modifiedCols,
+                                   TableTuple *beforeImage, TableTuple *afterImage)
+    : isValid(true),
+      populated(false),
+      type(type),
+      category(category),
+      lsn(lsn),
+      prevLsn(prevLsn),
+      xid(xid),
+      execSiteId(execSiteId),
+      tableId(tableId),
+      pkeyIndex(pkeyIndex),
+      modifiedColsIn(modifiedCols),
+      beforeImageIn(beforeImage),
+      afterImageIn(afterImage),
+      payload(NULL),
+      payloadLength(0),
+      flags(0),
+      beforeImageData(NULL),
+      afterImageData(NULL)
+{
+}
+
+CompactLogRecord::CompactLogRecord(ReferenceSerializeInput &input, bool verifyChecksum)
+    : isValid(false),
+      populated(false),
+      type(LogRecord::T_INVALIDTYPE),
+      category(LogRecord::T_BAD_CATEGORY),
+      lsn(-1),
+      prevLsn(-1),
+      xid(-1),
+      execSiteId(-1),
+      tableId(-1),
+      pkeyIndex(NULL),
+      modifiedColsIn(NULL),
+      beforeImageIn(NULL),
+      afterImageIn(NULL),
+      payload(NULL),
+      payloadLength(0),
+      flags(0),
+      beforeImageData(NULL),
+      afterImageData(NULL)
+{
+    if (input.numBytesNotYetRead() < FRAME_HEADER_SIZE) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "CompactLogRecord : truncated frame header");
+    }
+    if (input.readInt() != MAGIC) {
+        return;
+    }
+    payloadLength = input.readInt();
+    uint32_t crc = static_cast<uint32_t>(input.readInt());
+    if (payloadLength <= 0) {
+        return;
+    }
+    if (static_cast<size_t>(payloadLength) > input.numBytesNotYetRead()) {
+        char message[128];
+        snprintf(message, sizeof(message), "CompactLogRecord : payload of %d bytes but only %lu left",
+                 payloadLength, (unsigned long) input.numBytesNotYetRead());
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION, message);
+    }
+    payload = reinterpret_cast<const char*>(input.getRawPointer(payloadLength));
+
+    if (verifyChecksum && crc32cComplete(payload, payloadLength) != crc) {
+        VOLT_WARN("CompactLogRecord : checksum mismatch, treating as end of log");
+        return;
+    }
+
+    // only the header is decoded here, the images wait for populateFields()
+    ReferenceSerializeInput payloadIn(payload, payloadLength);
+    type = static_cast<LogRecord::Logrec_type_t>(payloadIn.readByte());
+    category = static_cast<LogRecord::Logrec_category_t>(payloadIn.readByte());
+    lsn = unzigzag(readVarint(payloadIn));
+    prevLsn = unzigzag(readVarint(payloadIn));
+    xid = unzigzag(readVarint(payloadIn));
+    execSiteId = static_cast<int32_t>(unzigzag(readVarint(payloadIn)));
+    tableId = static_cast<int32_t>(readVarint(payloadIn));
+    flags = static_cast<uint8_t>(payloadIn.readByte());
+
+    isValid = true;
+}
+
+CompactLogRecord::~CompactLogRecord() {
+    delete[] beforeImageData;
+    delete[] afterImageData;
+}
+
+bool CompactLogRecord::isCompactRecord(const char *data, size_t available) {
+    if (available < FRAME_HEADER_SIZE) {
+        return false;
+    }
+    int32_t magic;
+    memcpy(&magic, data, sizeof(magic));
+    return static_cast<int32_t>(ntohl(magic)) == MAGIC;
+}
+
+void CompactLogRecord::writeVarint(SerializeOutput &output, uint64_t value) {
+    while (value >= 0x80) {
+        output.writeByte(static_cast<int8_t>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    output.writeByte(static_cast<int8_t>(value));
+}
+
+uint64_t CompactLogRecord::readVarint(ReferenceSerializeInput &input) {
+    uint64_t value = 0;
+    int shift = 0;
+    while (shift < 64) {
+        if (input.numBytesNotYetRead() == 0) {
+            throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                          "CompactLogRecord : varint runs past the end of the record");
+        }
+        uint8_t byte = static_cast<uint8_t>(input.readByte());
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+        shift += 7;
+    }
+    return value;
+}
+
+void CompactLogRecord::serializeTo(SerializeOutput &output) {
+    output.writeInt(MAGIC);
+    size_t lengthPos = output.reserveBytes(2 * sizeof(int32_t));
+    size_t payloadStart = output.position();
+
+    serializePayloadTo(output);
+
+    int32_t length = static_cast<int32_t>(output.position() - payloadStart);
+    uint32_t crc = crc32cComplete(output.data() + payloadStart, length);
+    output.writeIntAt(lengthPos, length);
+    output.writeIntAt(lengthPos + sizeof(int32_t), static_cast<int32_t>(crc));
+}
+
+void CompactLogRecord::serializePayloadTo(SerializeOutput &output) {
+    output.writeByte(static_cast<int8_t>(type));
+    output.writeByte(static_cast<int8_t>(category));
+    writeVarint(output, zigzag(lsn));
+    writeVarint(output, zigzag(prevLsn));
+    writeVarint(output, zigzag(xid));
+    writeVarint(output, zigzag(execSiteId));
+    writeVarint(output, static_cast<uint64_t>(tableId));
+
+    uint8_t outFlags = 0;
+    if (beforeImageIn != NULL) {
+        outFlags |= (pkeyIndex != NULL) ? HAS_KEY : HAS_BEFORE;
+    }
+    if (afterImageIn != NULL) {
+        outFlags |= HAS_AFTER;
+    }
+    output.writeByte(static_cast<int8_t>(outFlags));
+
+    if (outFlags & HAS_KEY) {
+        const std::vector<int> &keyColumns = pkeyIndex->getColumnIndices();
+        for (size_t i = 0; i < keyColumns.size(); i++) {
+            writeTypedValue(output, beforeImageIn->getNValue(keyColumns[i]));
+        }
+    } else if (outFlags & HAS_BEFORE) {
+        for (int i = 0; i < beforeImageIn->sizeInValues(); i++) {
+            writeTypedValue(output, beforeImageIn->getNValue(i));
+        }
+    }
+
+    if (outFlags & HAS_AFTER) {
+        if (type == LogRecord::T_UPDATE && modifiedColsIn != NULL) {
+            writeVarint(output, modifiedColsIn->size());
+            for (size_t i = 0; i < modifiedColsIn->size(); i++) {
+                writeVarint(output, static_cast<uint64_t>((*modifiedColsIn)[i]));
+            }
+            for (size_t i = 0; i < modifiedColsIn->size(); i++) {
+                writeTypedValue(output, afterImageIn->getNValue((*modifiedColsIn)[i]));
+            }
+        } else {
+            if (type == LogRecord::T_UPDATE) {
+                writeVarint(output, 0);
+            }
+            for (int i = 0; i < afterImageIn->sizeInValues(); i++) {
+                writeTypedValue(output, afterImageIn->getNValue(i));
+            }
+        }
+    }
+}
+
+void CompactLogRecord::deserializeValuesInto(ReferenceSerializeInput &input, TableTuple &tuple,
+                                             const std::vector<int32_t> &columns, Pool *stringPool) {
+    for (size_t i = 0; i < columns.size(); i++) {
+        tuple.setNValue(columns[i], NValue::deserializeFromAllocateForStorage(input, stringPool));
+    }
+}
+
+void CompactLogRecord::populateFields(const TupleSchema *imageSchema, TableIndex *index, Pool *stringPool) {
+    if (!isValid || populated) {
+        return;
+    }
+
+    ReferenceSerializeInput input(payload, payloadLength);
+    // skip the header, it was decoded when the frame was read
+    input.readByte();
+    input.readByte();
+    for (int i = 0; i < 5; i++) {
+        readVarint(input);
+    }
+    input.readByte();
+
+    const size_t imageLength = imageSchema->tupleLength() + TUPLE_HEADER_SIZE;
+    std::vector<int32_t> allColumns(imageSchema->columnCount());
+    for (int i = 0; i < imageSchema->columnCount(); i++) {
+        allColumns[i] = i;
+    }
+
+    if (flags & HAS_KEY) {
+        if (index == NULL) {
+            VOLT_ERROR("CompactLogRecord : record has a primary key but table %d has no primary key index", tableId);
+            isValid = false;
+            return;
+        }
+        // replay works against the live tuple the key points to
+        const TupleSchema *keySchema = index->getKeySchema();
+        const size_t keyLength = keySchema->tupleLength() + TUPLE_HEADER_SIZE;
+        char *keyData = new char[keyLength];
+        memset(keyData, 0, keyLength);
+        TableTuple keyTuple(keyData, keySchema);
+        std::vector<int32_t> keyColumns(keySchema->columnCount());
+        for (int i = 0; i < keySchema->columnCount(); i++) {
+            keyColumns[i] = i;
+        }
+        deserializeValuesInto(input, keyTuple, keyColumns, stringPool);
+
+        beforeImage = TableTuple(imageSchema);
+        if (index->moveToKey(&keyTuple)) {
+            beforeImage = index->nextValueAtKey();
+        }
+        delete[] keyData;
+    } else if (flags & HAS_BEFORE) {
+        beforeImageData = new char[imageLength];
+        memset(beforeImageData, 0, imageLength);
+        beforeImage = TableTuple(beforeImageData, imageSchema);
+        deserializeValuesInto(input, beforeImage, allColumns, stringPool);
+    }
+
+    if (flags & HAS_AFTER) {
+        afterImageData = new char[imageLength];
+        memset(afterImageData, 0, imageLength);
+        afterImage = TableTuple(afterImageData, imageSchema);
+
+        if (type == LogRecord::T_UPDATE) {
+            modifiedCols.resize(static_cast<size_t>(readVarint(input)));
+            for (size_t i = 0; i < modifiedCols.size(); i++) {
+                modifiedCols[i] = static_cast<int32_t>(readVarint(input));
+            }
+        }
+
+        if (!modifiedCols.empty()) {
+            if (beforeImage.address() == NULL) {
+                VOLT_ERROR("CompactLogRecord : update of a tuple that is not in table %d", tableId);
+                isValid = false;
+                return;
+            }
+            afterImage.copy(beforeImage);
+            deserializeValuesInto(input, afterImage, modifiedCols, stringPool);
+        } else {
+            deserializeValuesInto(input, afterImage, allColumns, stringPool);
+        }
+    }
+
+    populated = true;
+}
@@ -0,0 +1,186 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef COMPACTLOGRECORD_H_
+#define COMPACTLOGRECORD_H_
+
+#include "common/tabletuple.h"
+#include "common/TupleSchema.h"
+#include "common/serializeio.h"
+#include "indexes/tableindex.h"
+#include "logging/Logrecord.h"
+
+#include <vector>
+
+namespace voltdb {
+
+class Pool;
+
+/**
+ * Compact ARIES log record.
+ *
+ * Unlike LogRecord, which wraps every field in a TableTuple, this encoding
+ * identifies the table by its catalog id, writes the header fields as
+ * varints and, for updates, only records the columns that changed. Every
+ * record is framed as
+ *
+ *   [int32 MAGIC][int32 payload length][int32 crc32c(payload)][payload]
+ *
+ * MAGIC has its high bit set, so a reader that only knows the old format
+ * sees a negative record size and stops, while doAriesRecovery can tell
+ * the two formats apart record by record. A torn or corrupted record fails
+ * its checksum and is treated as the end of the log.
+ *
+ * Payload layout:
+ *   type, category                  1 byte each
+ *   lsn, prevLsn, xid, siteId       zigzag varints
+ *   tableId                         varint (catalog relative index)
+ *   flags                           1 byte (HAS_KEY, HAS_BEFORE, HAS_AFTER)
+ *   key / before image              typed NValues, key columns or full row
+ *   modified column count + ids     varints (updates only)
+ *   after image                     typed NValues, modified columns or full row
+ */
+class CompactLogRecord {
+public:
+    static const int32_t MAGIC = static_cast<int32_t>(0xAC1E5C02);
+    static const size_t FRAME_HEADER_SIZE = 3 * sizeof(int32_t);
+
+    enum Flags {
+        HAS_KEY = 1,
+        HAS_BEFORE = 2,
+        HAS_AFTER = 4
+    };
+
+    /**
+     * Build a record for writing. If pkeyIndex is given, the before image is
+     * logged as just its primary key. If modifiedCols is given, only those
+     * columns of the after image are logged.
+     */
+    CompactLogRecord(LogRecord::Logrec_type_t type, LogRecord::Logrec_category_t category,
+                     int64_t lsn, int64_t prevLsn, int64_t xid, int32_t execSiteId, int32_t tableId,
+                     TableIndex *pkeyIndex, const std::vector<int32_t> *modifiedCols,
+                     TableTuple *beforeImage, TableTuple *afterImage);
+
+    /**
+     * Parse a record back. Advances input past the frame even if it is
+     * invalid. The checksum can be skipped for frames that were already
+     * verified once. Throws a SerializableEEException if the frame runs
+     * past the end of input.
+     */
+    CompactLogRecord(ReferenceSerializeInput &input, bool verifyChecksum = true);
+
+    ~CompactLogRecord();
+
+    /** True if the bytes at data start a compact record */
+    static bool isCompactRecord(const char *data, size_t available);
+
+    void serializeTo(SerializeOutput &output);
+
+    /**
+     * Rebuild the tuple images against the table they belong to. Must be
+     * called before getTupleBeforeImage()/getTupleAfterImage(). Uninlined
+     * strings are allocated from stringPool and stay valid until it is purged.
+     */
+    void populateFields(const TupleSchema *imageSchema, TableIndex *pkeyIndex, Pool *stringPool);
+
+    inline bool isValidRecord() const {
+        return isValid;
+    }
+
+    inline LogRecord::Logrec_type_t getType() const {
+        return type;
+    }
+
+    inline int64_t getLsn() const {
+        return lsn;
+    }
+
+    inline int64_t getTransactionId() const {
+        return xid;
+    }
+
+    inline int32_t getExecutionSiteId() const {
+        return execSiteId;
+    }
+
+    inline int32_t getTableId() const {
+        return tableId;
+    }
+
+    inline TableTuple* getTupleBeforeImage() {
+        return (populated && beforeImage.address() != NULL) ? &beforeImage : NULL;
+    }
+
+    inline TableTuple* getTupleAfterImage() {
+        return (populated && afterImage.address() != NULL) ? &afterImage : NULL;
+    }
+
+    inline bool hasTrailingLoadData() const {
+        return ((type == LogRecord::T_BULKLOAD) && (category == LogRecord::T_FORWARD));
+    }
+
+    static void writeVarint(SerializeOutput &output, uint64_t value);
+    static uint64_t readVarint(ReferenceSerializeInput &input);
+
+private:
+    CompactLogRecord();
+
+    void serializePayloadTo(SerializeOutput &output);
+    void deserializeValuesInto(ReferenceSerializeInput &input, TableTuple &tuple,
+                               const std::vector<int32_t> &columns, Pool *stringPool);
+
+    bool isValid;
+    bool populated;
+
+    LogRecord::Logrec_type_t type;
+    LogRecord::Logrec_category_t category;
+
+    int64_t lsn;
+    int64_t prevLsn;
+    int64_t xid;
+    int32_t execSiteId;
+    int32_t tableId;
+
+    // writing side
+    TableIndex *pkeyIndex;
+    const std::vector<int32_t> *modifiedColsIn;
+    TableTuple *beforeImageIn;
+    TableTuple *afterImageIn;
+
+    // reading side
+    const char *payload;
+    int32_t payloadLength;
+    uint8_t flags;
+    std::vector<int32_t> modifiedCols;
+
+    char *beforeImageData;
+    TableTuple beforeImage;
+    char *afterImageData;
+    TableTuple afterImage;
+};
+
+}
+
+#endif /* COMPACTLOGRECORD_H_ */
@@ -86,6 +86,8 @@ public:
      */
     ~LogManager() {
         delete m_proxy;
+        // the ARIES proxy is owned by us and flushes its last batch on the way out
+        delete getAriesLogProxy();
     }
 
 
@@ -113,6 +115,13 @@ public:
     	return (m_ariesLogger);
     }
 
+    /**
+     * The group-committing proxy behind the ARIES logger, NULL if ARIES is off
+     */
+    AriesLogProxy* getAriesLogProxy() const {
+    	return const_cast<AriesLogProxy*>(dynamic_cast<const AriesLogProxy*>(m_ariesLogger.m_logProxy));
+    }
+
 
 private:
 
@@ -0,0 +1,134 @@
+/* Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+ * All rights reserved. Use of this source code is governed by a
+ * BSD-style license that can be found in the LICENSE file.
+ */
+
+#include "logging/LogWriter.h"
+#include "common/FatalException.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifndef __APPLE__
+#define HAVE_FDATASYNC
+#endif
+
+static inline int syncFileDescriptor(int fd) {
+#ifdef HAVE_FDATASYNC
+    return fdatasync(fd);
+#else
+    return fsync(fd);
+#endif
+}
+
+namespace voltdb {
+
+MinimalBuffer::MinimalBuffer() : written_(0) {
+#ifndef __APPLE__
+    void* mem = NULL;
+    if (posix_memalign(&mem, BUFFER_ALIGN, BUFFER_SIZE) != 0) {
+        throwFatalException("Failed to allocate %d byte log buffer", BUFFER_SIZE);
+    }
+    buffer_ = static_cast<char*>(mem);
+#else
+    // Mac OS X: Doesn't need to be aligned for F_NOCACHE?
+    buffer_ = (char*) malloc(BUFFER_SIZE);
+#endif
+}
+
+MinimalBuffer::~MinimalBuffer() {
+    free(buffer_);
+}
+
+size_t MinimalBuffer::append(const char* data, size_t length) {
+    size_t room = BUFFER_SIZE - written_;
+    if (length > room) {
+        length = room;
+    }
+    memcpy(buffer_ + written_, data, length);
+    written_ += static_cast<int>(length);
+    assert(0 <= written_ && written_ <= BUFFER_SIZE);
+    return length;
+}
+
+
+LogWriter::LogWriter(const std::string &path, bool o_dsync) :
+        path_(path), fd_(-1), total_bytes_(0), o_dsync_(o_dsync) {
+    int flags = O_WRONLY | O_CREAT | O_APPEND;
+#ifdef O_DSYNC
+    if (o_dsync_) {
+        flags |= O_DSYNC;
+    }
+#else
+    o_dsync_ = false;
+#endif
+    fd_ = open(path_.c_str(), flags, 0644);
+    if (fd_ < 0) {
+        throwFatalException("Failed to open log file %s: %s", path_.c_str(), strerror(errno));
+    }
+    off_t end = lseek(fd_, 0, SEEK_END);
+    if (end < 0) {
+        int error = errno;
+        ::close(fd_);
+        fd_ = -1;
+        throwFatalException("Failed to seek to the end of log file %s: %s", path_.c_str(), strerror(error));
+    }
+    total_bytes_ = end;
+}
+
+LogWriter::~LogWriter() {
+    close();
+}
+
+void LogWriter::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void LogWriter::discardUnsynced() {
+    // don't leave a torn batch behind for recovery to trip over
+    if (ftruncate(fd_, total_bytes_) != 0) {
+        fprintf(stderr, "Failed to truncate log file %s back to %ld bytes: %s\n",
+                path_.c_str(), (long) total_bytes_, strerror(errno));
+    }
+}
+
+void LogWriter::syncWriteBuffer(MinimalBuffer* buffer) {
+    assert(fd_ >= 0);
+    const char* data;
+    int length;
+    buffer->getReadBuffer(&data, &length);
+
+    int done = 0;
+    while (done < length) {
+        ssize_t written = write(fd_, data + done, length - done);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            int error = errno;
+            discardUnsynced();
+            throwFatalException("Failed to write %d bytes to log file %s: %s",
+                                length, path_.c_str(), strerror(error));
+        }
+        done += static_cast<int>(written);
+    }
+
+    if (!o_dsync_ && syncFileDescriptor(fd_) != 0) {
+        int error = errno;
+        discardUnsynced();
+        throwFatalException("Failed to sync log file %s: %s", path_.c_str(), strerror(error));
+    }
+    total_bytes_ += length;
+    buffer->consumedRead();
+}
+
+}  // namespace voltdb
@@ -0,0 +1,79 @@
+/* Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+ * All rights reserved. Use of this source code is governed by a
+ * BSD-style license that can be found in the LICENSE file.
+ *
+ * EE copy of the dtxn MinimalBuffer and LogWriter (src/dtxn/logging/logfile.h).
+ * The dtxn writer truncates and zero fills a fixed size file; the ARIES log
+ * has to survive restarts because its LSNs are file offsets, so this one
+ * appends to whatever is already there. Failures raise a FatalException
+ * instead of aborting the process.
+ */
+
+#ifndef HSTORELOGWRITER_H
+#define HSTORELOGWRITER_H
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <stdint.h>
+
+namespace voltdb {
+
+// Wraps a single page-aligned allocation. The log is not opened O_DIRECT,
+// batches end at arbitrary byte offsets.
+class MinimalBuffer {
+public:
+    static const int BUFFER_SIZE = 512 << 10;
+    static const int BUFFER_ALIGN = 4 << 10;
+
+    MinimalBuffer();
+    ~MinimalBuffer();
+
+    // Copies as much of data as fits, returns the number of bytes copied.
+    size_t append(const char* data, size_t length);
+
+    void getReadBuffer(const char** buffer, int* length) const {
+        *buffer = buffer_;
+        *length = written_;
+    }
+
+    void consumedRead() {
+        written_ = 0;
+    }
+
+    int available() const { return written_; }
+    bool full() const { return written_ == BUFFER_SIZE; }
+
+private:
+    char* buffer_;
+    int written_;
+};
+
+// Appends buffers to a file, each followed by a data integrity operation.
+// NOTE: The destructor does *not* invoke a file integrity operation.
+class LogWriter {
+public:
+    LogWriter(const std::string &path, bool o_dsync);
+    ~LogWriter();
+
+    void close();
+
+    // Appends the data in buffer and syncs it. Throws a FatalException if
+    // either fails, in which case size() does not move and the file is cut
+    // back to it.
+    void syncWriteBuffer(MinimalBuffer* buffer);
+
+    // Offset at which the next buffer lands, i.e. everything before it is durable.
+    int64_t size() const { return total_bytes_; }
+
+private:
+    void discardUnsynced();
+
+    std::string path_;
+    int fd_;
+    int64_t total_bytes_;
+    bool o_dsync_;
+};
+
+}  // namespace voltdb
+#endif
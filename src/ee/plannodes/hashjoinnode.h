@@ -0,0 +1,51 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HSTOREHASHJOINNODE_H
+#define HSTOREHASHJOINNODE_H
+
+#include "abstractjoinnode.h"
+
+namespace voltdb
+{
+
+/**
+ * Equi-join of its two children. The join keys are the equality
+ * comparisons between an outer and an inner column in the conjunction
+ * of the predicate, the rest of the predicate is checked on each match.
+ */
+class HashJoinPlanNode : public AbstractJoinPlanNode
+{
+public:
+    HashJoinPlanNode(CatalogId id);
+    HashJoinPlanNode();
+    ~HashJoinPlanNode();
+
+    virtual PlanNodeType getPlanNodeType() const;
+};
+
+}
+
+#endif
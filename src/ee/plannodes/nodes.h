@@ -52,6 +52,7 @@
 #include "plannodes/aggregatenode.h"
 #include "plannodes/deletenode.h"
 #include "plannodes/distinctnode.h"
+#include "plannodes/hashjoinnode.h"
 #include "plannodes/indexscannode.h"
 #include "plannodes/insertnode.h"
 #include "plannodes/limitnode.h"
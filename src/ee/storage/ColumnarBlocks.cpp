@@ -0,0 +1,223 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "storage/ColumnarBlocks.h"
+#include "common/debuglog.h"
+#include "common/tabletuple.h"
+#include "common/TupleSchema.h"
+#include "storage/table.h"
+
+#include <algorithm>
+
+namespace voltdb {
+
+namespace {
+
+template <typename S, typename T>
+void fillMinipage(const char *data, uint32_t tupleLength, uint32_t offset, int slots,
+                  const char *live, S nullValue, T widenedNull, T *values) {
+    for (int slot = 0; slot < slots; slot++) {
+        if (live[slot] == 0) {
+            values[slot] = widenedNull;
+            continue;
+        }
+        S value = *reinterpret_cast<const S*>(data + slot * tupleLength + TUPLE_HEADER_SIZE + offset);
+        values[slot] = (value == nullValue) ? widenedNull : static_cast<T>(value);
+    }
+}
+
+bool startsAfter(const char *address, const std::pair<const char*, size_t> &start) {
+    return address < start.first;
+}
+
+}
+
+ColumnarBlocks::ColumnarBlocks(const Table *table) :
+    m_table(table), m_tuplesPerBlock(table->m_tuplesPerBlock), m_tupleLength(table->m_tupleLength),
+    m_numBigInts(0), m_numDoubles(0), m_blocksRebuilt(0) {
+    const TupleSchema *schema = table->schema();
+    for (int column = 0; column < schema->columnCount(); column++) {
+        switch (schema->columnType(column)) {
+          case VALUE_TYPE_TINYINT:
+          case VALUE_TYPE_SMALLINT:
+          case VALUE_TYPE_INTEGER:
+          case VALUE_TYPE_BIGINT:
+          case VALUE_TYPE_TIMESTAMP:
+            m_minipages.push_back(m_numBigInts++);
+            m_doubleColumns.push_back(false);
+            break;
+          case VALUE_TYPE_DOUBLE:
+            m_minipages.push_back(m_numDoubles++);
+            m_doubleColumns.push_back(true);
+            break;
+          default:
+            m_minipages.push_back(-1);
+            m_doubleColumns.push_back(false);
+            break;
+        }
+    }
+}
+
+ColumnarBlocks::~ColumnarBlocks() {
+    for (size_t i = 0; i < m_blocks.size(); i++) {
+        delete m_blocks[i];
+    }
+}
+
+const TupleSchema* ColumnarBlocks::schema() const {
+    return m_table->schema();
+}
+
+void ColumnarBlocks::markStale(const char *address) {
+    std::vector<std::pair<const char*, size_t> >::const_iterator start =
+        std::upper_bound(m_starts.begin(), m_starts.end(), address, startsAfter);
+    if (start == m_starts.begin()) {
+        return;
+    }
+    --start;
+    // a block the table allocated since the last sync() starts out stale anyway
+    if (address < start->first + static_cast<size_t>(m_tuplesPerBlock) * m_tupleLength) {
+        m_blocks[start->second]->stale = true;
+    }
+}
+
+size_t ColumnarBlocks::sync() {
+    const std::vector<char*> &data = m_table->m_data;
+    bool changed = (data.size() != m_blocks.size());
+    while (m_blocks.size() > data.size()) {
+        delete m_blocks.back();
+        m_blocks.pop_back();
+    }
+    for (size_t i = 0; i < data.size(); i++) {
+        if (i == m_blocks.size()) {
+            Block *block = new Block();
+            block->live.resize(m_tuplesPerBlock);
+            block->bigInts.resize(static_cast<size_t>(m_numBigInts) * m_tuplesPerBlock);
+            block->doubles.resize(static_cast<size_t>(m_numDoubles) * m_tuplesPerBlock);
+            block->data = NULL;
+            block->stale = true;
+            block->slots = 0;
+            m_blocks.push_back(block);
+        }
+        if (m_blocks[i]->data != data[i]) {
+            m_blocks[i]->data = data[i];
+            m_blocks[i]->stale = true;
+            changed = true;
+        }
+    }
+    if (changed) {
+        m_starts.clear();
+        for (size_t i = 0; i < m_blocks.size(); i++) {
+            m_starts.push_back(std::make_pair(static_cast<const char*>(m_blocks[i]->data), i));
+        }
+        std::sort(m_starts.begin(), m_starts.end());
+    }
+    return m_blocks.size();
+}
+
+int ColumnarBlocks::usedSlots(size_t block) const {
+    const int64_t first = static_cast<int64_t>(block) * m_tuplesPerBlock;
+    const int64_t used = static_cast<int64_t>(m_table->m_usedTuples) - first;
+    return static_cast<int>(std::max(static_cast<int64_t>(0),
+                                     std::min(used, static_cast<int64_t>(m_tuplesPerBlock))));
+}
+
+int ColumnarBlocks::refresh(size_t index) {
+    Block &block = *m_blocks[index];
+    const int slots = usedSlots(index);
+    if (block.stale || block.slots != slots) {
+        block.slots = slots;
+        rebuild(block);
+    }
+    return block.slots;
+}
+
+void ColumnarBlocks::rebuild(Block &block) {
+    const TupleSchema *schema = m_table->schema();
+    TableTuple tuple(schema);
+    for (int slot = 0; slot < block.slots; slot++) {
+        tuple.move(block.data + static_cast<size_t>(slot) * m_tupleLength);
+        block.live[slot] = tuple.isActive() ? 1 : 0;
+    }
+
+    // one column at a time, so each minipage is written front to back
+    for (int column = 0; column < static_cast<int>(m_minipages.size()); column++) {
+        if (m_minipages[column] < 0) {
+            continue;
+        }
+        const uint32_t offset = schema->columnOffset(column);
+        const size_t first = static_cast<size_t>(m_minipages[column]) * m_tuplesPerBlock;
+        switch (schema->columnType(column)) {
+          case VALUE_TYPE_TINYINT:
+            fillMinipage<int8_t, int64_t>(block.data, m_tupleLength, offset, block.slots, &block.live[0],
+                                          INT8_NULL, INT64_NULL, &block.bigInts[first]);
+            break;
+          case VALUE_TYPE_SMALLINT:
+            fillMinipage<int16_t, int64_t>(block.data, m_tupleLength, offset, block.slots, &block.live[0],
+                                           INT16_NULL, INT64_NULL, &block.bigInts[first]);
+            break;
+          case VALUE_TYPE_INTEGER:
+            fillMinipage<int32_t, int64_t>(block.data, m_tupleLength, offset, block.slots, &block.live[0],
+                                           INT32_NULL, INT64_NULL, &block.bigInts[first]);
+            break;
+          case VALUE_TYPE_BIGINT:
+          case VALUE_TYPE_TIMESTAMP:
+            fillMinipage<int64_t, int64_t>(block.data, m_tupleLength, offset, block.slots, &block.live[0],
+                                           INT64_NULL, INT64_NULL, &block.bigInts[first]);
+            break;
+          case VALUE_TYPE_DOUBLE:
+            fillMinipage<double, double>(block.data, m_tupleLength, offset, block.slots, &block.live[0],
+                                         DOUBLE_MIN, DOUBLE_MIN, &block.doubles[first]);
+            break;
+          default:
+            break;
+        }
+    }
+    block.stale = false;
+    m_blocksRebuilt++;
+}
+
+int ColumnarBlocks::nextBatch(size_t &block, int &slot, char **tuples, int *slots, int max) {
+    while (block < m_blocks.size()) {
+        const int used = refresh(block);
+        const char *live = &m_blocks[block]->live[0];
+        int count = 0;
+        while (count < max && slot < used) {
+            if (live[slot]) {
+                slots[count] = slot;
+                tuples[count++] = tupleAddress(block, slot);
+            }
+            slot++;
+        }
+        if (count > 0) {
+            return count;
+        }
+        block++;
+        slot = 0;
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,155 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HSTORECOLUMNARBLOCKS_H
+#define HSTORECOLUMNARBLOCKS_H
+
+#include "common/types.h"
+
+#include <utility>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace voltdb {
+
+class ColumnarBlocks;
+class Table;
+class TupleSchema;
+
+/**
+ * A batch of live tuples from one block of a table with a columnar
+ * layout, handed to AbstractExpression::evalBatch() next to the tuples so
+ * that comparisons can read their column out of the block's minipage.
+ * slots[i] is the slot of the i-th tuple of the batch within the block.
+ */
+struct ColumnarBatch {
+    const ColumnarBlocks *blocks;
+    size_t block;
+    const int *slots;
+};
+
+/**
+ * A PAX style layout of a table's blocks for read-mostly tables. Each
+ * block of the table gets a minipage per integer, timestamp and double
+ * column with the values of all of the block's slots, widened to a bigint
+ * or a double the way comparisonbatch widens them (nulls become
+ * INT64_NULL and DOUBLE_MIN), and a minipage that flags the live slots.
+ * Slots are addressed like dataPtrForTuple() does: the n-th tuple of the
+ * table is slot n % tuplesPerBlock of block n / tuplesPerBlock.
+ *
+ * The rows are left where they are and remain the copy that is written
+ * and that TableTuples and indexes point at. The table marks a block
+ * stale whenever it writes a tuple in it, and a stale block's minipages
+ * are rebuilt from its rows the next time a scan reaches it, so a table
+ * that is mostly read rebuilds a block once per batch of writes to it.
+ *
+ * Nothing but a scan of the table may write it between sync() and the
+ * end of the scan.
+ */
+class ColumnarBlocks {
+    public:
+        ColumnarBlocks(const Table *table);
+        ~ColumnarBlocks();
+
+        /** Whether the column has a minipage, and whether it holds doubles */
+        inline bool hasColumn(int column) const {
+            return m_minipages[column] >= 0;
+        }
+        inline bool isDouble(int column) const {
+            return m_doubleColumns[column];
+        }
+
+        /** Mark the block the tuple at the given address lives in stale */
+        void markStale(const char *address);
+
+        /**
+         * Catch up with the blocks the table allocated or released since
+         * the last call. Returns the number of blocks.
+         */
+        size_t sync();
+
+        /** Rebuild the block's minipages if it is stale. Returns its used slots */
+        int refresh(size_t block);
+
+        /**
+         * Fill tuples and slots with up to max live tuples of a single
+         * block, starting at the given block and slot, and move the two
+         * past them. Returns 0 once the table is done.
+         */
+        int nextBatch(size_t &block, int &slot, char **tuples, int *slots, int max);
+
+        inline const char* live(size_t block) const {
+            return &m_blocks[block]->live[0];
+        }
+        inline const int64_t* bigInts(size_t block, int column) const {
+            return &m_blocks[block]->bigInts[m_minipages[column] * m_tuplesPerBlock];
+        }
+        inline const double* doubles(size_t block, int column) const {
+            return &m_blocks[block]->doubles[m_minipages[column] * m_tuplesPerBlock];
+        }
+        inline char* tupleAddress(size_t block, int slot) const {
+            return m_blocks[block]->data + static_cast<size_t>(slot) * m_tupleLength;
+        }
+
+        const TupleSchema* schema() const;
+
+        /** Blocks whose minipages have been built, for tests */
+        inline int64_t getBlocksRebuilt() const {
+            return m_blocksRebuilt;
+        }
+
+    private:
+        struct Block {
+            char *data;
+            bool stale;
+            int slots;
+            std::vector<char> live;
+            std::vector<int64_t> bigInts;
+            std::vector<double> doubles;
+        };
+
+        void rebuild(Block &block);
+        int usedSlots(size_t block) const;
+
+        const Table *m_table;
+        const uint32_t m_tuplesPerBlock;
+        const uint32_t m_tupleLength;
+
+        // index of each column's minipage among the bigint or the double ones, -1 for none
+        std::vector<int> m_minipages;
+        std::vector<bool> m_doubleColumns;
+        int m_numBigInts;
+        int m_numDoubles;
+
+        std::vector<Block*> m_blocks;
+        // start of each block as of the last sync(), sorted, with its index
+        std::vector<std::pair<const char*, size_t> > m_starts;
+        int64_t m_blocksRebuilt;
+}; // CLASS
+
+}
+
+#endif
@@ -38,6 +38,8 @@ vector<string> TableStats::generateTableStatsColumnNames() {
     columnNames.push_back("TUPLE_DATA_MEMORY");
     columnNames.push_back("STRING_DATA_MEMORY");
     columnNames.push_back("INDEX_MEMORY");
+    columnNames.push_back("TUPLE_HUGEPAGE_MEMORY");
+    columnNames.push_back("TUPLE_NUMA_NODE");
     
     #ifdef ANTICACHE
     // ACTIVE
@@ -72,6 +74,16 @@ void TableStats::populateTableStatsSchema(
     types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);
     types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);
     types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);
+
+    // TUPLE_HUGEPAGE_MEMORY
+    types.push_back(VALUE_TYPE_INTEGER);
+    columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER));
+    allowNull.push_back(false);
+
+    // TUPLE_NUMA_NODE
+    types.push_back(VALUE_TYPE_INTEGER);
+    columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER));
+    allowNull.push_back(false);
     
     #ifdef ANTICACHE
     // ANTICACHE_TUPLES_EVICTED
@@ -153,7 +165,7 @@ TableStats::generateEmptyTableStatsTable()
 TableStats::TableStats(Table* table)
     : StatsSource(), m_table(table), m_lastTupleCount(0), m_lastTupleAccessCount(0),
       m_lastAllocatedTupleMemory(0), m_lastOccupiedTupleMemory(0),
-      m_lastStringDataMemory(0), m_lastIndexMemory(0)
+      m_lastStringDataMemory(0), m_lastIndexMemory(0), m_lastHugePageTupleMemory(0)
 {
     #ifdef ANTICACHE
     m_lastTuplesEvicted = 0;
@@ -213,6 +225,7 @@ void TableStats::updateStatsTuple(TableTuple *tuple) {
     int64_t allocated_tuple_mem_kb = m_table->allocatedTupleMemory() / 1024;
     int64_t occupied_tuple_mem_kb = m_table->occupiedTupleMemory() / 1024;
     int64_t string_data_mem_kb = m_table->nonInlinedMemorySize() / 1024;
+    int64_t hugepage_tuple_mem_kb = m_table->hugePageTupleMemory() / 1024;
 
     int64_t index_mem = 0;
     int64_t index_mem_kb;
@@ -256,6 +269,9 @@ void TableStats::updateStatsTuple(TableTuple *tuple) {
         index_mem_kb =
             index_mem_kb - m_lastIndexMemory / 1024;
         m_lastIndexMemory = index_mem;
+        hugepage_tuple_mem_kb =
+            hugepage_tuple_mem_kb - (m_lastHugePageTupleMemory / 1024);
+        m_lastHugePageTupleMemory = m_table->hugePageTupleMemory();
         
         #ifdef ANTICACHE
         
@@ -307,6 +323,10 @@ void TableStats::updateStatsTuple(TableTuple *tuple) {
     {
         index_mem_kb = -1;
     }
+    if (hugepage_tuple_mem_kb > INT32_MAX)
+    {
+        hugepage_tuple_mem_kb = -1;
+    }
 
     tuple->setNValue(
             StatsSource::m_columnName2Index["TUPLE_COUNT"],
@@ -327,6 +347,12 @@ void TableStats::updateStatsTuple(TableTuple *tuple) {
     tuple->setNValue( StatsSource::m_columnName2Index["INDEX_MEMORY"],
                       ValueFactory::
                       getIntegerValue(static_cast<int32_t>(index_mem_kb)));
+    tuple->setNValue( StatsSource::m_columnName2Index["TUPLE_HUGEPAGE_MEMORY"],
+                      ValueFactory::
+                      getIntegerValue(static_cast<int32_t>(hugepage_tuple_mem_kb)));
+    tuple->setNValue( StatsSource::m_columnName2Index["TUPLE_NUMA_NODE"],
+                      ValueFactory::
+                      getIntegerValue(m_table->tupleMemoryNumaNode()));
     
     #ifdef ANTICACHE
     tuple->setNValue( StatsSource::m_columnName2Index["ANTICACHE_TUPLES_EVICTED"],
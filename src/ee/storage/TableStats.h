@@ -112,6 +112,7 @@ private:
     int64_t m_lastOccupiedTupleMemory;
     int64_t m_lastStringDataMemory;
     int64_t m_lastIndexMemory;
+    int64_t m_lastHugePageTupleMemory;
     
     #ifdef ANTICACHE
     // ACTIVE
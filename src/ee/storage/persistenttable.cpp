@@ -43,6 +43,7 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <sstream>
 #include <cassert>
 #include <cstdio>
@@ -80,6 +81,7 @@
 #include "anticache/EvictedTable.h"
 #include "anticache/AntiCacheDB.h"
 #include "anticache/EvictionIterator.h"
+#include "anticache/EvictedIndexRanges.h"
 #include "anticache/UnknownBlockAccessException.h"
 #endif
 
@@ -99,8 +101,9 @@ TableTuple keyTuple;
 PersistentTable::PersistentTable(ExecutorContext *ctx, bool exportEnabled) :
     Table(TABLE_BLOCKSIZE,ctx->isMMAPEnabled()), m_executorContext(ctx), m_uniqueIndexes(NULL), m_uniqueIndexCount(0), m_allowNulls(NULL),
     m_indexes(NULL), m_indexCount(0), m_pkeyIndex(NULL), m_wrapper(NULL),
-    m_tsSeqNo(0), stats_(this), m_exportEnabled(exportEnabled),
-    m_COWContext(NULL)
+    m_tsSeqNo(0), m_undoQuantumOverride(NULL), m_recoveryAppends(0),
+    m_compactionBoundary(0), m_compactionCursor(0),
+    stats_(this), m_exportEnabled(exportEnabled), m_COWContext(NULL)
 {
 
 #ifdef ANTICACHE
@@ -110,8 +113,11 @@ PersistentTable::PersistentTable(ExecutorContext *ctx, bool exportEnabled) :
     m_newestTupleID = 0;
     m_oldestTupleID = 0;
     m_numTuplesInEvictionChain = 0;
+    m_evictionPolicy = ANTICACHE_EVICTION_LRU;
+    m_clockHand = 0;
     m_blockMerge = true;
     m_batchEvicted = false;
+    m_evictedIndexRanges = NULL;
 #endif
 
     if (exportEnabled) {
@@ -126,8 +132,9 @@ PersistentTable::PersistentTable(ExecutorContext *ctx, bool exportEnabled) :
 PersistentTable::PersistentTable(ExecutorContext *ctx, const std::string name, bool exportEnabled) :
     Table(TABLE_BLOCKSIZE,ctx->isMMAPEnabled()), m_executorContext(ctx), m_uniqueIndexes(NULL), m_uniqueIndexCount(0), m_allowNulls(NULL),
     m_indexes(NULL), m_indexCount(0), m_pkeyIndex(NULL), m_wrapper(NULL),
-    m_tsSeqNo(0), stats_(this), m_exportEnabled(exportEnabled),
-    m_COWContext(NULL)
+    m_tsSeqNo(0), m_undoQuantumOverride(NULL), m_recoveryAppends(0),
+    m_compactionBoundary(0), m_compactionCursor(0),
+    stats_(this), m_exportEnabled(exportEnabled), m_COWContext(NULL)
 {
 
 #ifdef ANTICACHE
@@ -137,8 +144,11 @@ PersistentTable::PersistentTable(ExecutorContext *ctx, const std::string name, b
     m_newestTupleID = 0;
     m_oldestTupleID = 0;
     m_numTuplesInEvictionChain = 0;
+    m_evictionPolicy = ANTICACHE_EVICTION_LRU;
+    m_clockHand = 0;
     m_blockMerge = true;
     m_batchEvicted = false;
+    m_evictedIndexRanges = NULL;
 #endif
 
     if (exportEnabled) {
@@ -182,6 +192,7 @@ PersistentTable::~PersistentTable() {
     
     #ifdef ANTICACHE
 //     if (m_evictedTable) delete m_evictedTable;
+    delete m_evictedIndexRanges;
     #endif
 
     // note this class has ownership of the views, even if they
@@ -227,6 +238,43 @@ int PersistentTable::getNumTuplesInEvictionChain()
     return m_numTuplesInEvictionChain;  
 }
 
+AntiCacheEvictionPolicy PersistentTable::getEvictionPolicy()
+{
+    return m_evictionPolicy;
+}
+
+void PersistentTable::setEvictionPolicy(AntiCacheEvictionPolicy policy)
+{
+    m_evictionPolicy = policy;
+    m_clockBits.clear();
+    m_clockHand = 0;
+}
+
+void PersistentTable::setBlockReferenced(int block)
+{
+    if (block >= static_cast<int>(m_clockBits.size()))
+        m_clockBits.resize(m_data.size(), 0);
+    m_clockBits[block] = 1;
+}
+
+bool PersistentTable::clearBlockReferenced(int block)
+{
+    if (block >= static_cast<int>(m_clockBits.size()) || m_clockBits[block] == 0)
+        return false;
+    m_clockBits[block] = 0;
+    return true;
+}
+
+uint32_t PersistentTable::getClockHand()
+{
+    return m_clockHand;
+}
+
+void PersistentTable::setClockHand(uint32_t hand)
+{
+    m_clockHand = hand;
+}
+
 void PersistentTable::setNewestTupleID(uint32_t id)
 {
     m_newestTupleID = id; 
@@ -312,23 +360,23 @@ void PersistentTable::setBytesWritten(int64_t bytesWritten)
     m_bytesWritten = bytesWritten;
 }
 
-std::map<int32_t, int32_t> PersistentTable::getUnevictedBlockIDs()
+std::map<int64_t, int32_t> PersistentTable::getUnevictedBlockIDs()
 {
     return m_unevictedBlockIDs;
 }
 
-bool PersistentTable::isAlreadyUnEvicted(int32_t blockId)
+bool PersistentTable::isAlreadyUnEvicted(int64_t blockId)
 {
     return m_unevictedBlockIDs.find(blockId) != m_unevictedBlockIDs.end();
 }
 
-void PersistentTable::insertUnevictedBlockID(std::pair<int32_t,int32_t> pair)
+void PersistentTable::insertUnevictedBlockID(std::pair<int64_t,int32_t> pair)
 {
     VOLT_DEBUG("pair is %d", pair.first);
     m_unevictedBlockIDs.insert(pair);
 }
 
-bool PersistentTable::removeUnevictedBlockID(int32_t blockId) {
+bool PersistentTable::removeUnevictedBlockID(int64_t blockId) {
     if (isAlreadyUnEvicted(blockId)) {
         VOLT_INFO("Reusing blockID %x, so we need to remove it from list", blockId);
         m_unevictedBlockIDs.erase(m_unevictedBlockIDs.find(blockId));
@@ -380,6 +428,46 @@ bool PersistentTable::mergeStrategy()
     return m_blockMerge;
 }
 
+void PersistentTable::setBlockMerge(bool blockMerge)
+{
+    m_blockMerge = blockMerge;
+}
+
+/*
+ * Only the entries of non-unique secondary indexes are dropped. Evicted
+ * tuples keep their primary key entry, which the merge uses to find them
+ * again, and their entries in unique indexes so that inserts still see
+ * the keys taken. The setting can only change while none of the table's
+ * tuples are evicted.
+ */
+bool PersistentTable::setIndexEviction(bool evictIndexes)
+{
+    if (evictIndexes == (m_evictedIndexRanges != NULL)) {
+        return true;
+    }
+    if (m_tuplesEvicted > 0 || (evictIndexes && m_pkeyIndex == NULL)) {
+        return false;
+    }
+    if (evictIndexes) {
+        std::vector<TableIndex*> secondaryIndexes;
+        for (int i = 0; i < m_indexCount; ++i) {
+            if (m_indexes[i] != m_pkeyIndex && m_indexes[i]->isUniqueIndex() == false) {
+                secondaryIndexes.push_back(m_indexes[i]);
+            }
+        }
+        m_evictedIndexRanges = new EvictedIndexRanges(secondaryIndexes);
+    } else {
+        delete m_evictedIndexRanges;
+        m_evictedIndexRanges = NULL;
+    }
+    return true;
+}
+
+EvictedIndexRanges* PersistentTable::getEvictedIndexRanges()
+{
+    return m_evictedIndexRanges;
+}
+
 voltdb::TableTuple * PersistentTable::getTempTarget1()
 {
     return &m_tmpTarget1;
@@ -418,7 +506,21 @@ int64_t PersistentTable::unevictTuple(ReferenceSerializeInput * in, int j, int m
     m_tmpTarget1.setDeletedFalse();
     // update the indexes to point to this newly unevicted tuple
     VOLT_DEBUG("BEFORE: tuple.isEvicted() = %d", m_tmpTarget1.isEvicted());
-    setEntryToNewAddressForAllIndexes(&m_tmpTarget1, m_tmpTarget1.address(), m_tmpTarget2.address());
+    if (m_evictedIndexRanges == NULL) {
+        setEntryToNewAddressForAllIndexes(&m_tmpTarget1, m_tmpTarget1.address(), m_tmpTarget2.address());
+    } else {
+        // the indexes the evicted tuple's entries were dropped from get them back
+        for (int i = m_indexCount - 1; i >= 0; --i) {
+            bool restored = (m_evictedIndexRanges->covers(m_indexes[i]) ?
+                             m_indexes[i]->addEntry(&m_tmpTarget1) :
+                             m_indexes[i]->setEntryToNewAddress(&m_tmpTarget1, m_tmpTarget1.address(),
+                                                                m_tmpTarget2.address()));
+            if (!restored) {
+                throwFatalException("Failed to restore unevicted tuple in index %s.%s",
+                                    name().c_str(), m_indexes[i]->getName().c_str());
+            }
+        }
+    }
     updateStringMemory((int)m_tmpTarget1.getNonInlinedMemorySize());
 
     //deleteFromAllIndexes(&m_tmpTarget1);
@@ -524,7 +626,7 @@ bool PersistentTable::insertTuple(TableTuple &source) {
     /*
      * Create and register an undo action.
      */
-    voltdb::UndoQuantum *undoQuantum = m_executorContext->getCurrentUndoQuantum();
+    voltdb::UndoQuantum *undoQuantum = currentUndoQuantum();
     assert(undoQuantum);
     voltdb::Pool *pool = undoQuantum->getDataPool();
     assert(pool);
@@ -611,6 +713,38 @@ void PersistentTable::insertTupleForUndo(TableTuple &source, size_t wrapperOffse
 #endif
 }
 
+UndoQuantum* PersistentTable::currentUndoQuantum() {
+    if (m_undoQuantumOverride != NULL) {
+        return m_undoQuantumOverride;
+    }
+    return m_executorContext->getCurrentUndoQuantum();
+}
+
+void PersistentTable::appendTupleForRecovery(TableTuple &source) {
+    while (m_usedTuples + m_recoveryAppends >= m_allocatedTuples) {
+        allocateNextBlock();
+    }
+
+    m_tmpTarget1.move(dataPtrForTuple((int) (m_usedTuples + m_recoveryAppends)));
+    m_tmpTarget1.copyForPersistentInsert(source, NULL);
+    m_tmpTarget1.setDeletedFalse();
+    m_tmpTarget1.setDirtyFalse();
+    m_tmpTarget1.setEvictedFalse();
+    m_recoveryAppends++;
+
+    processLoadedTuple(false, m_tmpTarget1);
+}
+
+void PersistentTable::finishRecoveryAppends() {
+    if (m_recoveryAppends == 0) {
+        return;
+    }
+    populateIndexes(m_recoveryAppends);
+    m_tupleCount += m_recoveryAppends;
+    m_usedTuples += m_recoveryAppends;
+    m_recoveryAppends = 0;
+}
+
 /*
  * Regular tuple update function that does a copy and allocation for
  * updated strings and creates an UndoAction.
@@ -622,7 +756,7 @@ bool PersistentTable::updateTuple(TableTuple &source, TableTuple &target, bool u
      * Create and register an undo action and then use the copy of
      * the target (old value with no updates)
      */
-    voltdb::UndoQuantum *undoQuantum = m_executorContext->getCurrentUndoQuantum();
+    voltdb::UndoQuantum *undoQuantum = currentUndoQuantum();
     assert(undoQuantum);
     voltdb::Pool *pool = undoQuantum->getDataPool();
     assert(pool);
@@ -650,6 +784,9 @@ bool PersistentTable::updateTuple(TableTuple &source, TableTuple &target, bool u
 
     /** TODO : Not Using MMAP pool **/
     target.copyForPersistentUpdate(source, NULL);
+    if (m_columnarBlocks != NULL) {
+        m_columnarBlocks->markStale(target.address());
+    }
 
     ptuua->setNewTuple(target, pool);
 
@@ -744,6 +881,9 @@ void PersistentTable::updateTupleForUndo(TableTuple &source, TableTuple &target,
     bool dirty = target.isDirty();
     // this is the actual in-place revert to the old version
     target.copy(source);
+    if (m_columnarBlocks != NULL) {
+        m_columnarBlocks->markStale(target.address());
+    }
     if (dirty) {
         target.setDirtyTrue();
     } else {
@@ -795,7 +935,7 @@ bool PersistentTable::deleteTuple(TableTuple &target, bool deleteAllocatedString
     /*
      * Create and register an undo action.
      */
-    voltdb::UndoQuantum *undoQuantum = m_executorContext->getCurrentUndoQuantum();
+    voltdb::UndoQuantum *undoQuantum = currentUndoQuantum();
     assert(undoQuantum);
     voltdb::Pool *pool = undoQuantum->getDataPool();
     assert(pool);
@@ -941,6 +1081,191 @@ void PersistentTable::setEntryToNewAddressForAllIndexes(const TableTuple *tuple,
     }
 }
 
+// ------------------------------------------------------------------
+// COMPACTION
+// ------------------------------------------------------------------
+
+// blocks a pass keeps beyond what the live tuples fill, so that a table
+// that grows again doesn't have to allocate right away
+static const size_t COMPACTION_SPARE_BLOCKS = 1;
+
+bool PersistentTable::compactTuples(int maxTuples) {
+#if defined(MEMCHECK_NOFREELIST) || (defined(ANTICACHE) && !defined(ANTICACHE_TIMESTAMPS))
+    // no free list to move tuples into, or an LRU chain that links
+    // tuples by their position in the table
+    return false;
+#else
+    // snapshots and recovery streams walk the blocks in place
+    if (m_COWContext != NULL || m_recoveryContext != NULL || m_recoveryAppends > 0 ||
+        m_executorContext->isMMAPEnabled()) {
+        return false;
+    }
+    if (m_compactionBoundary == 0 && !beginCompaction()) {
+        return false;
+    }
+
+    bool outOfHoles = false;
+    for (int i = 0; i < maxTuples && m_compactionCursor > m_compactionBoundary; i++) {
+        m_tmpTarget2.move(dataPtrForTuple((int) m_compactionCursor - 1));
+        if (!m_tmpTarget2.isActive()) {
+            m_compactionCursor--;
+            continue;
+        }
+
+        // holes in the zone come from deletes since the pass began,
+        // finishCompaction() puts back the ones that survive
+        char *hole = NULL;
+        while (hole == NULL && !m_holeFreeTuples.empty()) {
+            hole = m_holeFreeTuples.back();
+            m_holeFreeTuples.pop_back();
+            if (inCompactionZone(hole)) {
+                hole = NULL;
+            }
+        }
+        if (hole == NULL) {
+            outOfHoles = true;
+            break;
+        }
+
+        ::memcpy(hole, m_tmpTarget2.address(), m_tupleLength);
+        if (m_columnarBlocks != NULL) {
+            m_columnarBlocks->markStale(hole);
+            m_columnarBlocks->markStale(m_tmpTarget2.address());
+        }
+        m_tmpTarget1.move(hole);
+        setEntryToNewAddressForAllIndexes(&m_tmpTarget1, hole, m_tmpTarget2.address());
+        // the old slot goes away with its block, not onto the free list
+        m_tmpTarget2.setDeletedTrue();
+        m_compactionCursor--;
+    }
+
+    if (outOfHoles || m_compactionCursor <= m_compactionBoundary) {
+        finishCompaction();
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool PersistentTable::setColumnarLayout(bool columnar) {
+#ifdef MEMCHECK_NOFREELIST
+    return columnar == false;
+#else
+    if (columnar == (m_columnarBlocks != NULL)) {
+        return true;
+    }
+    if (columnar) {
+        m_columnarBlocks = new ColumnarBlocks(this);
+    } else {
+        delete m_columnarBlocks;
+        m_columnarBlocks = NULL;
+    }
+    VOLT_DEBUG("Columnar layout of table '%s' is %s", m_name.c_str(), columnar ? "on" : "off");
+    return true;
+#endif
+}
+
+#ifndef MEMCHECK_NOFREELIST
+bool PersistentTable::beginCompaction() {
+    size_t keepBlocks = (m_tupleCount + m_tuplesPerBlock - 1) / m_tuplesPerBlock + COMPACTION_SPARE_BLOCKS;
+    if (m_data.size() <= keepBlocks) {
+        return false;
+    }
+
+    m_compactionBoundary = static_cast<uint32_t>(keepBlocks * m_tuplesPerBlock);
+    m_compactionCursor = m_usedTuples;
+    setCompactionZone();
+    VOLT_DEBUG("Compacting table '%s' from %d to %d blocks",
+               m_name.c_str(), (int) m_data.size(), (int) keepBlocks);
+    return true;
+}
+
+void PersistentTable::finishCompaction() {
+    // the pass may have run out of holes, and inserts may have landed in
+    // the zone behind the cursor, so look for the last live tuple again
+    uint32_t used = m_usedTuples;
+    while (used > m_compactionBoundary) {
+        m_tmpTarget2.move(dataPtrForTuple((int) used - 1));
+        if (m_tmpTarget2.isActive()) {
+            break;
+        }
+        used--;
+    }
+    m_usedTuples = used;
+
+    // blocks allocated during the pass belong to the zone too
+    setCompactionZone();
+    for (uint32_t i = m_compactionBoundary; i < m_usedTuples; i++) {
+        m_tmpTarget2.move(dataPtrForTuple((int) i));
+        if (!m_tmpTarget2.isActive()) {
+            m_holeFreeTuples.push_back(m_tmpTarget2.address());
+        }
+    }
+
+    size_t keepBlocks = std::max(m_compactionBoundary, m_usedTuples + m_tuplesPerBlock - 1) / m_tuplesPerBlock;
+    size_t released = 0;
+    while (m_data.size() > keepBlocks) {
+        freeBlockMemory(m_data.back(), m_tableAllocationTargetSize);
+        m_data.pop_back();
+#ifdef ANTICACHE_TIMESTAMPS_PRIME
+        m_evictPosition.pop_back();
+        m_stepPrime.pop_back();
+#endif
+        m_allocatedTuples -= m_tuplesPerBlock;
+        released++;
+    }
+#ifdef ANTICACHE
+    // the CLOCK bits of the released blocks go with them
+    if (m_clockBits.size() > m_data.size()) {
+        m_clockBits.resize(m_data.size());
+    }
+    if (m_clockHand >= m_data.size()) {
+        m_clockHand = 0;
+    }
+#endif
+    VOLT_DEBUG("Compacted table '%s', released %d blocks", m_name.c_str(), (int) released);
+
+    m_compactionZone.clear();
+    m_compactionBoundary = 0;
+    m_compactionCursor = 0;
+}
+
+/*
+ * Record the address ranges of the blocks from m_compactionBoundary on and
+ * take their holes off the free list, so inserts only fill the front.
+ */
+void PersistentTable::setCompactionZone() {
+    const size_t blockLength = static_cast<size_t>(m_tuplesPerBlock) * m_tupleLength;
+    m_compactionZone.clear();
+    for (size_t i = m_compactionBoundary / m_tuplesPerBlock; i < m_data.size(); i++) {
+        m_compactionZone.push_back(std::make_pair(m_data[i], m_data[i] + blockLength));
+    }
+    std::sort(m_compactionZone.begin(), m_compactionZone.end());
+
+    size_t kept = 0;
+    for (size_t i = 0; i < m_holeFreeTuples.size(); i++) {
+        if (!inCompactionZone(m_holeFreeTuples[i])) {
+            m_holeFreeTuples[kept++] = m_holeFreeTuples[i];
+        }
+    }
+    m_holeFreeTuples.resize(kept);
+}
+
+static bool blockStartsAfter(const char *address, const std::pair<char*, char*> &block) {
+    return address < block.first;
+}
+
+bool PersistentTable::inCompactionZone(const char *address) const {
+    std::vector<std::pair<char*, char*> >::const_iterator block =
+        std::upper_bound(m_compactionZone.begin(), m_compactionZone.end(), address, blockStartsAfter);
+    if (block == m_compactionZone.begin()) {
+        return false;
+    }
+    --block;
+    return address < block->second;
+}
+#endif
+
 bool PersistentTable::tryInsertOnAllIndexes(TableTuple *tuple) {
     for (int i = m_indexCount - 1; i >= 0; --i) {
         FAIL_IF(!m_indexes[i]->addEntry(tuple)) {
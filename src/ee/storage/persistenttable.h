@@ -84,11 +84,13 @@ class ReferenceSerializeOutput;
 class ExecutorContext;
 class MaterializedViewMetadata;
 class RecoveryProtoMsg;
+class UndoQuantum;
     
 #ifdef ANTICACHE
 class EvictedTable;
 class AntiCacheEvictionManager; 
 class EvictionIterator;
+class EvictedIndexRanges;
 #endif
 
 /**
@@ -178,6 +180,51 @@ class PersistentTable : public Table {
      */
     voltdb::TableTuple lookupTuple(TableTuple tuple);
 
+    /*
+     * Used by ARIES recovery to replay runs of inserts. Tuples are
+     * appended to the unused tail of the table with no UndoAction and no
+     * index maintenance, and only become visible once
+     * finishRecoveryAppends() has added all of them to the indexes in one
+     * pass, the same way loadTuplesFrom() handles bulk loads.
+     */
+    void appendTupleForRecovery(TableTuple &source);
+    void finishRecoveryAppends();
+
+    /*
+     * Register this table's UndoActions with the given quantum instead of
+     * the executor context's current one, so that recovery threads can
+     * replay different tables at once. NULL restores the default.
+     */
+    void setUndoQuantumOverride(UndoQuantum *undoQuantum) {
+        m_undoQuantumOverride = undoQuantum;
+    }
+
+    bool hasMaterializedViews() const {
+        return !m_views.empty();
+    }
+
+    /*
+     * Incremental compaction of the tuple storage. Deleted tuples only
+     * become holes, so a table that shrank keeps all of its blocks. Once
+     * the live tuples fit in at least two fewer blocks, a compaction pass
+     * moves the tuples of the trailing blocks into holes further up,
+     * repoints their index entries and then frees the emptied blocks.
+     * Each call looks at no more than maxTuples tuple slots and returns
+     * true while the pass is unfinished. Tuples change address, so this
+     * may only be called between transactions, with nothing left in the
+     * UndoLog.
+     */
+    bool compactTuples(int maxTuples);
+
+    /*
+     * Keep column minipages of the blocks next to the rows (see
+     * ColumnarBlocks), so that scans and aggregates over the integer and
+     * double columns of a read-mostly table can run a column at a time.
+     * Every write marks the block it lands in for a rebuild. Not
+     * available in the memcheck build, which has a block per tuple.
+     */
+    bool setColumnarLayout(bool columnar);
+
     // ------------------------------------------------------------------
     // INDEXES
     // ------------------------------------------------------------------
@@ -278,11 +325,22 @@ class PersistentTable : public Table {
     uint32_t getOldestTupleID();
     void setNumTuplesInEvictionChain(int num_tuples);
     int getNumTuplesInEvictionChain(); 
+    // needed for CLOCK eviction
+    AntiCacheEvictionPolicy getEvictionPolicy();
+    void setEvictionPolicy(AntiCacheEvictionPolicy policy);
+    void setBlockReferenced(int block);
+    bool clearBlockReferenced(int block);
+    uint32_t getClockHand();
+    void setClockHand(uint32_t hand);
     AntiCacheDB* getAntiCacheDB(int level);
-    std::map<int32_t, int32_t> getUnevictedBlockIDs();
+    std::map<int64_t, int32_t> getUnevictedBlockIDs();
     std::vector<char*> getUnevictedBlocks();
     int32_t getMergeTupleOffset(int);
     bool mergeStrategy();
+    void setBlockMerge(bool blockMerge);
+    // drop the secondary index entries of evicted tuples
+    bool setIndexEviction(bool evictIndexes);
+    EvictedIndexRanges* getEvictedIndexRanges();
     int32_t getTuplesEvicted();
     void setTuplesEvicted(int32_t tuplesEvicted);
     int32_t getBlocksEvicted();
@@ -296,11 +354,11 @@ class PersistentTable : public Table {
     int64_t getBytesWritten();
     void setBytesWritten(int64_t bytesWritten);
     voltdb::TableTuple * getTempTarget1();
-    void insertUnevictedBlockID(std::pair<int32_t,int32_t>);
-    bool removeUnevictedBlockID(int32_t blockId);
+    void insertUnevictedBlockID(std::pair<int64_t,int32_t>);
+    bool removeUnevictedBlockID(int64_t blockId);
     void insertUnevictedBlock(char* unevicted_tuples);
     void insertTupleOffset(int32_t tuple_offset);
-    bool isAlreadyUnEvicted(int32_t blockId);
+    bool isAlreadyUnEvicted(int64_t blockId);
     int32_t getTuplesRead();
     void setTuplesRead(int32_t tuplesRead);
     void setBatchEvicted(bool batchEvicted);
@@ -378,7 +436,7 @@ protected:
     #ifdef ANTICACHE
     voltdb::Table *m_evictedTable;
     
-    std::map<int32_t, int32_t> m_unevictedBlockIDs; 
+    std::map<int64_t, int32_t> m_unevictedBlockIDs; 
 //    std::vector<int16_t> m_unevictedBlockIDs;
     std::vector<char*> m_unevictedBlocks;
     std::vector<int32_t> m_mergeTupleOffset; 
@@ -392,9 +450,18 @@ protected:
     uint32_t m_newestTupleID; 
     
     int m_numTuplesInEvictionChain;
+
+    // the eviction policy the state below is kept for
+    AntiCacheEvictionPolicy m_evictionPolicy;
+    // CLOCK reference bit of each storage block, grown on demand
+    std::vector<uint8_t> m_clockBits;
+    uint32_t m_clockHand;
     
     bool m_blockMerge;
     bool m_batchEvicted;
+    // key ranges of the evicted blocks for the indexes their entries
+    // were dropped from, NULL unless index eviction is on
+    EvictedIndexRanges *m_evictedIndexRanges;
 
     #endif
     
@@ -407,6 +474,22 @@ protected:
     // list of materialized views that are sourced from this table
     std::vector<MaterializedViewMetadata *> m_views;
 
+    // ARIES recovery: see setUndoQuantumOverride() and appendTupleForRecovery()
+    UndoQuantum *m_undoQuantumOverride;
+    uint32_t m_recoveryAppends;
+    UndoQuantum* currentUndoQuantum();
+
+    // Compaction pass: the tuples from m_compactionBoundary on are moved
+    // out, scanning down from m_compactionCursor. m_compactionZone holds
+    // the address ranges of those blocks, sorted by start address.
+    uint32_t m_compactionBoundary;
+    uint32_t m_compactionCursor;
+    std::vector<std::pair<char*, char*> > m_compactionZone;
+    bool beginCompaction();
+    void finishCompaction();
+    void setCompactionZone();
+    bool inCompactionZone(const char *address) const;
+
     // STATS
     voltdb::PersistentTableStats stats_;
     voltdb::TableStats* getTableStats();
@@ -433,7 +516,7 @@ inline void PersistentTable::allocateNextBlock() {
 #else
     int bytes = m_tableAllocationTargetSize;
 #endif
-    char *memory = (char*)(new char[bytes]);
+    char *memory = allocateBlockMemory(bytes);
     m_data.push_back(memory);
 #ifdef ANTICACHE_TIMESTAMPS_PRIME
     m_evictPosition.push_back(0);
@@ -51,6 +51,7 @@
 #include "common/serializeio.h"
 #include "common/TupleSchema.h"
 #include "common/tabletuple.h"
+#include "common/WireTupleSerializer.h"
 #include "common/Pool.hpp"
 #include "common/FatalException.hpp"
 #include "indexes/tableindex.h"
@@ -72,8 +73,11 @@ Table::Table(int tableAllocationTargetSize) :
     m_tuplesPerBlock(0),
     m_tupleLength(0),
     m_nonInlinedMemorySize(0),
+    m_hugePageTupleMemory(0),
+    m_tupleMemoryNumaNode(-1),
     m_columnHeaderData(NULL),
     m_columnHeaderSize(-1),
+    m_wireSerializer(NULL),
     m_columnNames(NULL),
     m_databaseId(-1),
     m_name(""),
@@ -82,6 +86,7 @@ Table::Table(int tableAllocationTargetSize) :
     m_tempTableMemoryInBytes(NULL),
     m_pool(NULL),
     m_data_manager(NULL),
+    m_columnarBlocks(NULL),
     m_refcount(0),
     m_enableMMAP(false)
 {
@@ -111,8 +116,11 @@ Table::Table(int tableAllocationTargetSize, bool enableMMAP) :
     m_tuplesPerBlock(0),
     m_tupleLength(0),
     m_nonInlinedMemorySize(0),
+    m_hugePageTupleMemory(0),
+    m_tupleMemoryNumaNode(-1),
     m_columnHeaderData(NULL),
     m_columnHeaderSize(-1),
+    m_wireSerializer(NULL),
     m_columnNames(NULL),
     m_databaseId(-1),
     m_name(""),
@@ -121,6 +129,7 @@ Table::Table(int tableAllocationTargetSize, bool enableMMAP) :
     m_tempTableMemoryInBytes(NULL),
     m_pool(NULL),
     m_data_manager(NULL),
+    m_columnarBlocks(NULL),
     m_refcount(0),
     m_enableMMAP(enableMMAP)
 {
@@ -148,6 +157,9 @@ Table::~Table() {
         TupleSchema::freeTupleSchema(m_schema);
     }
 
+    delete m_columnarBlocks;
+    m_columnarBlocks = NULL;
+
     m_schema = NULL;
     delete[] m_columnNames;
     m_columnNames = NULL;
@@ -179,7 +191,7 @@ Table::~Table() {
     if(m_enableMMAP == false){
     // clear the tuple memory
     for (std::vector<char*>::iterator iter = m_data.begin(); iter != m_data.end(); ++iter)
-        delete[] reinterpret_cast<char*>(*iter);
+        freeBlockMemory(*iter, m_tableAllocationTargetSize);
     }
 #endif
 
@@ -187,6 +199,8 @@ Table::~Table() {
     if (m_columnHeaderData)
         delete[] m_columnHeaderData;
     m_columnHeaderData = NULL;
+    delete m_wireSerializer;
+    m_wireSerializer = NULL;
 
     /** Clean MMAP pool pointer **/
     delete m_pool;
@@ -205,6 +219,8 @@ void Table::initializeWithColumns(TupleSchema *schema, const std::string* column
     m_schema  = schema;
 
     m_columnCount = schema->columnCount();
+    delete m_wireSerializer;
+    m_wireSerializer = NULL;
 #ifdef MEMCHECK
     m_tuplesPerBlock = 1;
 #else
@@ -268,6 +284,9 @@ void Table::nextFreeTuple(TableTuple *tuple) {
         m_holeFreeTuples.pop_back();
         assert (m_columnCount == tuple->sizeInValues());
         tuple->move(ret);
+        if (m_columnarBlocks != NULL) {
+            m_columnarBlocks->markStale(ret);
+        }
         return;
     }
 #endif
@@ -282,6 +301,9 @@ void Table::nextFreeTuple(TableTuple *tuple) {
     assert (m_usedTuples < m_allocatedTuples);
     assert (m_columnCount == tuple->sizeInValues());
     tuple->move(dataPtrForTuple((int) m_usedTuples));
+    if (m_columnarBlocks != NULL) {
+        m_columnarBlocks->markStale(tuple->address());
+    }
     ++m_usedTuples;
     //cout << "table::nextFreeTuple(" << reinterpret_cast<const void *>(this) << ") m_usedTuples == " << m_usedTuples << endl;
 }
@@ -445,11 +467,14 @@ bool Table::serializeTo(SerializeOutput &serialize_io) {
 
     // active tuple counts
     serialize_io.writeInt(static_cast<int32_t>(m_tupleCount));
+    if (m_wireSerializer == NULL) {
+        m_wireSerializer = new WireTupleSerializer(m_schema);
+    }
     int64_t written_count = 0;
     TableIterator titer(this);
     TableTuple tuple(m_schema);
     while (titer.next(tuple)) {
-        tuple.serializeTo(serialize_io);
+        m_wireSerializer->serializeTo(tuple, serialize_io);
         ++written_count;
     }
     assert(written_count == m_tupleCount);
@@ -478,8 +503,11 @@ bool Table::serializeTupleTo(SerializeOutput &serialize_io, voltdb::TableTuple *
         return false;
 
     serialize_io.writeInt(static_cast<int32_t>(numTuples));
+    if (m_wireSerializer == NULL) {
+        m_wireSerializer = new WireTupleSerializer(m_schema);
+    }
     for (int ii = 0; ii < numTuples; ii++) {
-        tuples[ii].serializeTo(serialize_io);
+        m_wireSerializer->serializeTo(tuples[ii], serialize_io);
     }
 
     serialize_io.writeIntAt(pos, static_cast<int32_t>(serialize_io.position() - pos - sizeof(int32_t)));
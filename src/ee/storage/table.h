@@ -53,10 +53,12 @@
 #endif
 #include "common/ids.h"
 #include "common/types.h"
+#include "common/BlockAllocator.h"
 #include "common/TupleSchema.h"
 #include "common/Pool.hpp"
 #include "common/tabletuple.h"
 #include "common/MMAPMemoryManager.h"
+#include "storage/ColumnarBlocks.h"
 
 namespace voltdb {
 
@@ -75,6 +77,7 @@ class TableStats;
 class StatsSource;
 class StreamBlock;
 class Topend;
+class WireTupleSerializer;
 
 const size_t COLUMN_DESCRIPTOR_SIZE = 1 + 4 + 4; // type, name offset, name length
 
@@ -113,6 +116,7 @@ class Table {
     friend class TableStats;
     friend class StatsSource;
     friend class EvictionIterator; 
+    friend class ColumnarBlocks;
 
   private:
     // no default constructor, no copy
@@ -197,6 +201,16 @@ public:
     int64_t nonInlinedMemorySize() const {
         return m_nonInlinedMemorySize;
     }
+
+    /** Bytes of tuple blocks that are backed by huge pages */
+    int64_t hugePageTupleMemory() const {
+        return m_hugePageTupleMemory;
+    }
+
+    /** NUMA node the last tuple block was allocated on, -1 if unknown */
+    int32_t tupleMemoryNumaNode() const {
+        return m_tupleMemoryNumaNode;
+    }
     
     /**
      * Estimate for the number of times that tuples are accessed (either for a read or write)
@@ -354,6 +368,11 @@ public:
     MMAPMemoryManager* getDataManager(){
       return (m_data_manager);
     }
+
+    /** The columnar layout of the blocks, NULL unless the table has one */
+    ColumnarBlocks* getColumnarBlocks() const {
+      return (m_columnarBlocks);
+    }
     
 protected:
     Table(int tableAllocationTargetSize);
@@ -365,6 +384,10 @@ protected:
     char * dataPtrForTupleForced(const int index);
     virtual void allocateNextBlock();
 
+    /** Tuple block memory comes from the BlockAllocator, these track its stats */
+    char* allocateBlockMemory(int bytes);
+    void freeBlockMemory(char *memory, int bytes);
+
     /**
      * Normally this will return the tuple storage to the free list.
      * In the memcheck build it will return the storage to the heap.
@@ -387,6 +410,9 @@ protected:
     uint32_t m_tuplesPerBlock;
     uint32_t m_tupleLength;
     int64_t m_nonInlinedMemorySize;
+    BlockAllocator m_blockAllocator;
+    int64_t m_hugePageTupleMemory;
+    int32_t m_tupleMemoryNumaNode;
     
     // pointers to chunks of data
     std::vector<char*> m_data;
@@ -394,6 +420,9 @@ protected:
     char *m_columnHeaderData;
     int32_t m_columnHeaderSize;
 
+    // writes the tuples of serializeTo(), built on first use
+    WireTupleSerializer *m_wireSerializer;
+
 #if ANTICACHE
     // ACTIVE
     int32_t m_tuplesEvicted;
@@ -458,6 +487,9 @@ protected:
 
     /** MMAP Data Storage **/
     MMAPMemoryManager* m_data_manager;
+
+    /** Minipages of the blocks, kept by tables that opted into a columnar layout */
+    ColumnarBlocks* m_columnarBlocks;
     
   private:
     int32_t m_refcount;
@@ -500,13 +532,29 @@ inline char* Table::dataPtrForTupleForced(const int index) {
 
 inline const std::string& Table::name()     const { return m_name; }
 
+inline char* Table::allocateBlockMemory(int bytes) {
+    bool onHugePages;
+    char *memory = m_blockAllocator.allocate(bytes, &onHugePages);
+    if (onHugePages) {
+        m_hugePageTupleMemory += bytes;
+    }
+    m_tupleMemoryNumaNode = BlockAllocator::currentNode();
+    return memory;
+}
+
+inline void Table::freeBlockMemory(char *memory, int bytes) {
+    if (m_blockAllocator.deallocate(memory, bytes)) {
+        m_hugePageTupleMemory -= bytes;
+    }
+}
+
 inline void Table::allocateNextBlock() {
 #ifdef MEMCHECK
     int bytes = m_schema->tupleLength() + TUPLE_HEADER_SIZE;
 #else
     int bytes = m_tableAllocationTargetSize;
 #endif
-    char *memory = (char*)(new char[bytes]);
+    char *memory = allocateBlockMemory(bytes);
     m_data.push_back(memory);
 #ifdef ANTICACHE_TIMESTAMPS_PRIME
     m_evictPosition.push_back(0);
@@ -591,6 +639,9 @@ inline void Table::deleteTupleStorage(TableTuple &tuple) {
 inline void Table::deleteTupleStorage(TableTuple &tuple) {
     tuple.setDeletedTrue(); // does NOT free strings
     tuple.setEvictedFalse();
+    if (m_columnarBlocks != NULL) {
+        m_columnarBlocks->markStale(tuple.address());
+    }
 
     // add to the free list
     m_tupleCount--;
@@ -215,7 +215,7 @@ inline void TempTable::deleteAllTuplesNonVirtual(bool freeAllocatedStrings) {
         if (m_tempTableMemoryInBytes)
             (*m_tempTableMemoryInBytes) -= m_tableAllocationTargetSize;
         assert(chunk != NULL);
-        delete[] chunk;
+        freeBlockMemory(chunk, m_tableAllocationTargetSize);
 #endif
     }
 
@@ -530,7 +530,6 @@ int8_t VoltDBIPC::quiesce(struct ipc_command *cmd) {
 
 void VoltDBIPC::executeQueryPlanFragmentsAndGetResults(struct ipc_command *cmd) {
     int errors = 0;
-    NValueArray &params = m_engine->getParameterContainer();
 
     querypfs *queryCommand = (querypfs*) cmd;
 
@@ -553,21 +552,18 @@ void VoltDBIPC::executeQueryPlanFragmentsAndGetResults(struct ipc_command *cmd)
         m_engine->resetReusedResultOutputBuffer(1);//1 byte to add status code
         m_engine->setUndoToken(ntohll(queryCommand->undoToken));
         int numFrags = ntohl(queryCommand->numFragmentIds);
+        int64_t *fragmentIds = m_engine->getBatchFragmentIdsContainer();
+        int32_t *inputDepIds = m_engine->getBatchInputDepIdsContainer();
+        int32_t *outputDepIds = m_engine->getBatchOutputDepIdsContainer();
         for (int i = 0; i < numFrags; ++i) {
-            int cnt = serialize_in.readShort();
-            assert(cnt> -1);
-            Pool *pool = m_engine->getStringPool();
-            deserializeParameterSetCommon(cnt, serialize_in, params, pool);
-            m_engine->setUsedParamcnt(cnt);
-            if (m_engine->executeQuery(ntohll(fragmentId[i]), 1, -1,
-                                       params, ntohll(queryCommand->txnId),
-                                       ntohll(queryCommand->lastCommittedTxnId),
-                                       i == 0 ? true : false, //first
-                                       i == numFrags - 1 ? true : false)) { //last
-                ++errors;
-            }
-            pool->purge();
+            fragmentIds[i] = ntohll(fragmentId[i]);
+            outputDepIds[i] = 1;
+            inputDepIds[i] = -1;
         }
+        errors = m_engine->executeQueries(numFrags, fragmentIds, outputDepIds, inputDepIds,
+                                          serialize_in, ntohll(queryCommand->txnId),
+                                          ntohll(queryCommand->lastCommittedTxnId));
+        m_engine->getStringPool()->purge();
     } catch (FatalException e) {
         crashVoltDB(e);
     }
@@ -703,30 +703,11 @@ SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeExecu
 
         // all fragments' parameters are in this buffer
         ReferenceSerializeInput serialize_in(engine->getParameterBuffer(), engine->getParameterBufferCapacity());
-        NValueArray &params = engine->getParameterContainer();
 
         // count failures
-        int failures = 0;
-
-        for (int i = 0; i < batch_size; ++i) {
-            int cnt = serialize_in.readShort();
-            if (cnt < 0) {
-                throwFatalException("parameter count is negative: %d", cnt);
-            }
-            assert (cnt < MAX_PARAM_COUNT);
-            deserializeParameterSetCommon(cnt, serialize_in, params, stringPool);
-
-            engine->setUsedParamcnt(cnt);
-            // success is 0 and error is 1.
-            if (engine->executeQuery(fragment_ids_buffer[i],
-                                     output_depIds_buffer[i],
-                                     input_depIds_buffer[i],
-                                     params, txnId, lastCommittedTxnId, i == 0,
-                                     i == (batch_size - 1)))
-            {
-                ++failures;
-            }
-        }
+        int failures = engine->executeQueries(batch_size, fragment_ids_buffer,
+                                              output_depIds_buffer, input_depIds_buffer,
+                                              serialize_in, txnId, lastCommittedTxnId);
 
         // cleanup
         stringPool->purge();
@@ -864,6 +845,39 @@ SHAREDLIB_JNIEXPORT void JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeQuies
     }
 }
 
+/*
+ * Class:     org_voltdb_jni_ExecutionEngine
+ * Method:    nativeSetCompactionTimeBudget
+ * Signature: (JJ)I
+ *
+ * Sets how long each tick may spend compacting tables, 0 turns it off.
+ */
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeSetCompactionTimeBudget
+  (JNIEnv *env, jobject obj, jlong engine_ptr, jlong micros)
+{
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    engine->setCompactionTimeBudget(micros);
+    return org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
+}
+
+/*
+ * Class:     org_voltdb_jni_ExecutionEngine
+ * Method:    nativeSetBlockAllocatorOptions
+ * Signature: (JZZ)I
+ *
+ * Backs table blocks, pool chunks and index arrays allocated from now on
+ * with huge pages and/or memory on the NUMA node of the calling thread.
+ */
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeSetBlockAllocatorOptions
+  (JNIEnv *env, jobject obj, jlong engine_ptr, jboolean hugePages, jboolean numaLocal)
+{
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    engine->setBlockAllocatorOptions(hugePages == JNI_TRUE, numaLocal == JNI_TRUE);
+    return org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
+}
+
 /**
  * Class:     org_voltdb_jni_ExecutionEngine
  * Method:    nativeGetStats
@@ -1503,7 +1517,7 @@ SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiC
         jobject obj,
         jlong engine_ptr,
         jint tableId,
-        jintArray blockIdsArray,
+        jlongArray blockIdsArray,
         jintArray offsetsArray) {
     
     int retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
@@ -1514,7 +1528,7 @@ SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiC
     
     try {
         jsize numBlockIds = env->GetArrayLength(blockIdsArray);
-        jint *_blockIds = env->GetIntArrayElements(blockIdsArray, NULL);
+        jlong *_blockIds = env->GetLongArrayElements(blockIdsArray, NULL);
         jint *_tupleOffsets = env->GetIntArrayElements(offsetsArray, NULL); 
         if (_blockIds == NULL) {
             VOLT_ERROR("No evicted blockIds were given to the EE");
@@ -1526,7 +1540,7 @@ SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiC
         }
         
         // XXX: Is this necessary?
-        int32_t *blockIds = new int32_t[numBlockIds];
+        int64_t *blockIds = new int64_t[numBlockIds];
         for (int ii = 0; ii < numBlockIds; ii++) {
             blockIds[ii] = _blockIds[ii];
         } // FOR
@@ -1612,6 +1626,174 @@ SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiC
     }
     return (retval);
 }
+
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiCacheSetCompression (
+        JNIEnv *env,
+        jobject obj,
+        jlong engine_ptr,
+        jint compressionType,
+        jint level) {
+
+    int retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    VOLT_DEBUG("nativeAntiCacheSetCompression() start");
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return (retval);
+    Topend *topend = static_cast<JNITopend*>(engine->getTopend())->updateJNIEnv(env);
+
+    try {
+        if (engine->antiCacheSetCompression(static_cast<AntiCacheCompressionType>(compressionType), static_cast<int>(level))) {
+            retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
+        }
+    } catch (FatalException e) {
+        topend->crashVoltDB(e);
+    }
+    return (retval);
+}
+
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiCacheSetMergeStrategy (
+        JNIEnv *env,
+        jobject obj,
+        jlong engine_ptr,
+        jint tableId,
+        jboolean blockMerge) {
+
+    int retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    VOLT_DEBUG("nativeAntiCacheSetMergeStrategy() start");
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return (retval);
+    Topend *topend = static_cast<JNITopend*>(engine->getTopend())->updateJNIEnv(env);
+
+    try {
+        engine->antiCacheSetMergeStrategy(static_cast<int32_t>(tableId), blockMerge == JNI_TRUE);
+        retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
+    } catch (FatalException e) {
+        topend->crashVoltDB(e);
+    }
+    return (retval);
+}
+
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiCacheSetEvictionPolicy (
+        JNIEnv *env,
+        jobject obj,
+        jlong engine_ptr,
+        jint tableId,
+        jint evictionPolicy) {
+
+    int retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    VOLT_DEBUG("nativeAntiCacheSetEvictionPolicy() start");
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return (retval);
+    Topend *topend = static_cast<JNITopend*>(engine->getTopend())->updateJNIEnv(env);
+
+    try {
+        if (engine->antiCacheSetEvictionPolicy(static_cast<int32_t>(tableId),
+                                               static_cast<AntiCacheEvictionPolicy>(evictionPolicy))) {
+            retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
+        }
+    } catch (FatalException e) {
+        topend->crashVoltDB(e);
+    }
+    return (retval);
+}
+
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiCacheSetBackgroundWrites (
+        JNIEnv *env,
+        jobject obj,
+        jlong engine_ptr,
+        jint queueDepth) {
+
+    int retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    VOLT_DEBUG("nativeAntiCacheSetBackgroundWrites() start");
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return (retval);
+    Topend *topend = static_cast<JNITopend*>(engine->getTopend())->updateJNIEnv(env);
+
+    try {
+        if (engine->antiCacheSetBackgroundWrites(static_cast<int>(queueDepth))) {
+            retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
+        }
+    } catch (FatalException e) {
+        topend->crashVoltDB(e);
+    }
+    return (retval);
+}
+
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiCacheSetTierPolicy (
+        JNIEnv *env,
+        jobject obj,
+        jlong engine_ptr,
+        jint promoteAccesses,
+        jint demotePercent) {
+
+    int retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    VOLT_DEBUG("nativeAntiCacheSetTierPolicy() start");
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return (retval);
+    Topend *topend = static_cast<JNITopend*>(engine->getTopend())->updateJNIEnv(env);
+
+    try {
+        if (engine->antiCacheSetTierPolicy(static_cast<int>(promoteAccesses), static_cast<int>(demotePercent))) {
+            retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
+        }
+    } catch (FatalException e) {
+        topend->crashVoltDB(e);
+    }
+    return (retval);
+}
+
+/**
+ * Check whether the tuples with the primary keys in the parameter buffer
+ * are evicted.
+ * @param engine_ptr the VoltDBEngine pointer
+ * @param tableId the table the keys belong to
+ * @return error code, the EvictedTupleAccessException is in the exception buffer
+ */
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiCachePrefetch (
+        JNIEnv *env,
+        jobject obj,
+        jlong engine_ptr,
+        jint tableId) {
+
+    int retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    VOLT_DEBUG("nativeAntiCachePrefetch() start");
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return (retval);
+    Topend *topend = static_cast<JNITopend*>(engine->getTopend())->updateJNIEnv(env);
+
+    try {
+        NValueArray &params = engine->getParameterContainer();
+        const int numValues = deserializeParameterSet(engine->getParameterBuffer(), engine->getParameterBufferCapacity(),
+                                                      params, engine->getStringPool());
+        retval = engine->antiCachePrefetch(static_cast<int32_t>(tableId), params, numValues);
+        engine->getStringPool()->purge();
+    } catch (FatalException e) {
+        topend->crashVoltDB(e);
+    }
+    return (retval);
+}
+
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeAntiCacheSetIndexEviction (
+        JNIEnv *env,
+        jobject obj,
+        jlong engine_ptr,
+        jint tableId,
+        jboolean evictIndexes) {
+
+    int retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    VOLT_DEBUG("nativeAntiCacheSetIndexEviction() start");
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return (retval);
+    Topend *topend = static_cast<JNITopend*>(engine->getTopend())->updateJNIEnv(env);
+
+    try {
+        if (engine->antiCacheSetIndexEviction(static_cast<int32_t>(tableId), evictIndexes == JNI_TRUE)) {
+            retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
+        }
+    } catch (FatalException e) {
+        topend->crashVoltDB(e);
+    }
+    return (retval);
+}
 #endif // ANTICACHE
 
 
@@ -1688,6 +1870,56 @@ SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeARIES
     return org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
 }
 
+/**
+ * Sets the group commit policy of the local ARIES log.
+ * @param pointer the VoltDBEngine pointer
+ * @param groupCommitMicros the longest a batch of log records stays open
+ * @param syncOnCommit whether a commit waits for its records to be durable
+ * @param useDSync whether to open the log O_DSYNC instead of syncing each batch
+ * @return error code
+ */
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeARIESSetGroupCommit (
+        JNIEnv *env,
+        jobject obj,
+        jlong engine_ptr,
+        jlong groupCommitMicros,
+        jboolean syncOnCommit,
+        jboolean useDSync) {
+    int retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    VOLT_DEBUG("nativeARIESSetGroupCommit() start");
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return (retval);
+    Topend *topend = static_cast<JNITopend*>(engine->getTopend())->updateJNIEnv(env);
+
+    try {
+        if (engine->ARIESSetGroupCommit(groupCommitMicros, syncOnCommit == JNI_TRUE,
+                                        useDSync == JNI_TRUE)) {
+            retval = org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
+        }
+    } catch (FatalException e) {
+        topend->crashVoltDB(e);
+    }
+    return (retval);
+}
+
+/**
+ * Sets how many threads replay the ARIES log during recovery.
+ * @param pointer the VoltDBEngine pointer
+ * @param numThreads replay threads, 0 means one per core
+ * @return error code
+ */
+SHAREDLIB_JNIEXPORT jint JNICALL Java_org_voltdb_jni_ExecutionEngine_nativeARIESSetRecoveryThreads (
+        JNIEnv *env,
+        jobject obj,
+        jlong engine_ptr,
+        jint numThreads) {
+    VOLT_DEBUG("nativeARIESSetRecoveryThreads() start");
+    VoltDBEngine *engine = castToEngine(engine_ptr);
+    if (engine == NULL) return org_voltdb_jni_ExecutionEngine_ERRORCODE_ERROR;
+    engine->setARIESRecoveryThreads(numThreads);
+    return org_voltdb_jni_ExecutionEngine_ERRORCODE_SUCCESS;
+}
+
 /*
 * Class: org_voltdb_jni_ExecutionEngine
 * Method: getArieslogBufferLength
@@ -2692,7 +2692,7 @@ public class HStoreSite implements VoltProcedureListener.Handler, Shutdownable,
             }
             
             EvictedTupleAccessException error = (EvictedTupleAccessException)orig_error;
-            int block_ids[] = error.getBlockIds();
+            long block_ids[] = error.getBlockIds();
             int tuple_offsets[] = error.getTupleOffsets();
 
             Table evicted_table = error.getTable(this.catalogContext.database);
@@ -102,7 +102,9 @@ import org.voltdb.jni.ExecutionEngineJNI;
 import org.voltdb.jni.MockExecutionEngine;
 import org.voltdb.messaging.FastDeserializer;
 import org.voltdb.messaging.FastSerializer;
+import org.voltdb.types.AntiCacheCompressionType;
 import org.voltdb.types.AntiCacheDBType;
+import org.voltdb.types.AntiCacheEvictionOrderType;
 import org.voltdb.types.SpecExecSchedulerPolicyType;
 import org.voltdb.types.SpeculationConflictCheckerType;
 import org.voltdb.types.SpeculationType;
@@ -610,6 +612,39 @@ public class PartitionExecutor implements Runnable, Configurable, Shutdownable {
         return Size;
     }
 
+    /**
+     * Pass the anti-cache options that are set after the tables were loaded
+     * down to the EE. Everything here is left at the EE's default unless
+     * it is set in the HStoreConf.
+     * @param eeTemp
+     */
+    private void initializeAntiCacheOptions(ExecutionEngine eeTemp) {
+        AntiCacheCompressionType compression = AntiCacheCompressionType.get(hstore_conf.site.anticache_compression);
+        if (compression != null && compression != AntiCacheCompressionType.NONE) {
+            eeTemp.antiCacheSetCompression(compression, hstore_conf.site.anticache_compression_level);
+        }
+        if (hstore_conf.site.anticache_background_writes > 0) {
+            eeTemp.antiCacheSetBackgroundWrites(hstore_conf.site.anticache_background_writes);
+        }
+        if (hstore_conf.site.anticache_enable_multilevel &&
+            (hstore_conf.site.anticache_promote_accesses > 0 || hstore_conf.site.anticache_demote_percent < 100)) {
+            eeTemp.antiCacheSetTierPolicy(hstore_conf.site.anticache_promote_accesses,
+                                          hstore_conf.site.anticache_demote_percent);
+        }
+        AntiCacheEvictionOrderType order = AntiCacheEvictionOrderType.get(hstore_conf.site.anticache_eviction_order);
+        for (Table catalog_tbl : catalogContext.getEvictableTables()) {
+            if (hstore_conf.site.anticache_block_merge == false) {
+                eeTemp.antiCacheSetMergeStrategy(catalog_tbl, false);
+            }
+            if (order != null && order != AntiCacheEvictionOrderType.LRU) {
+                eeTemp.antiCacheSetEvictionOrder(catalog_tbl, order);
+            }
+            if (hstore_conf.site.anticache_evict_indexes) {
+                eeTemp.antiCacheSetIndexEviction(catalog_tbl, true);
+            }
+        }
+    }
+
  
     // ----------------------------------------------------------------------------
     // PROFILING OBJECTS
@@ -810,6 +845,12 @@ public class PartitionExecutor implements Runnable, Configurable, Shutdownable {
                                                 this.getPartitionId(),
                                                 this.site.getHost().getId(),
                                                 "localhost");
+
+                // Must happen before the first table block is allocated
+                if (hstore_conf.site.storage_huge_pages || hstore_conf.site.storage_numa_local) {
+                    eeTemp.setBlockAllocatorOptions(hstore_conf.site.storage_huge_pages,
+                                                    hstore_conf.site.storage_numa_local);
+                }
                 
                // Initialize Anti-Cache
                 if (hstore_conf.site.anticache_enable) {
@@ -863,11 +904,19 @@ public class PartitionExecutor implements Runnable, Configurable, Shutdownable {
                     File dbFile = getARIESDir(this);
                     File logFile = getARIESFile(this);
                     eeTemp.ARIESInitialize(dbFile, logFile);
+                    eeTemp.ARIESSetGroupCommit(hstore_conf.site.aries_group_commit_micros,
+                                               hstore_conf.site.aries_sync_on_commit,
+                                               hstore_conf.site.aries_dsync);
+                    eeTemp.ARIESSetRecoveryThreads(hstore_conf.site.aries_recovery_threads);
                 }                            
                 
                 // Important: This has to be called *after* we initialize the anti-cache
                 //            and the storage information!
                 eeTemp.loadCatalog(catalogContext.catalog.serialize());
+                eeTemp.setCompactionTimeBudget(hstore_conf.site.storage_compaction_budget);
+                if (hstore_conf.site.anticache_enable) {
+                    this.initializeAntiCacheOptions(eeTemp);
+                }
                 this.lastTickTime = System.currentTimeMillis();
                 eeTemp.tick(this.lastTickTime, 0);
                 
@@ -745,6 +745,89 @@ public final class HStoreConf {
                 enumOptions="org.voltdb.types.AntiCacheDBType"
         )
         public String anticache_dbtype;
+
+        @ConfigProperty(
+                description="How the EE compresses the blocks that it evicts. The EE must have been " +
+                            "compiled with support for the chosen format.",
+                defaultString="NONE",
+                experimental=true,
+                enumOptions="org.voltdb.types.AntiCacheCompressionType"
+        )
+        public String anticache_compression;
+
+        @ConfigProperty(
+                description="Compression level for ${site.anticache_compression}. " +
+                            "Zero uses the format's default.",
+                defaultInt=0,
+                experimental=true
+        )
+        public int anticache_compression_level;
+
+        @ConfigProperty(
+                description="Merge unevicted tuples back by reading their whole blocks. If false, " +
+                            "the EE only reads back the tuples that were accessed wherever the " +
+                            "AntiCacheDB allows it.",
+                defaultBoolean=true,
+                experimental=true
+        )
+        public boolean anticache_block_merge;
+
+        @ConfigProperty(
+                description="How the EE picks the tuples of each evictable table to evict. " +
+                            "This is separate from ${site.anticache_eviction_distribution}, " +
+                            "which spreads evictions over the tables.",
+                defaultString="LRU",
+                experimental=true,
+                enumOptions="org.voltdb.types.AntiCacheEvictionOrderType"
+        )
+        public String anticache_eviction_order;
+
+        @ConfigProperty(
+                description="Number of evicted blocks that may wait for a background thread in the EE " +
+                            "to compress and write them out. Zero writes them out inline.",
+                defaultInt=0,
+                experimental=true
+        )
+        public int anticache_background_writes;
+
+        @ConfigProperty(
+                description="With ${site.anticache_enable_multilevel}, the number of tuple reads " +
+                            "after which an evicted block is moved up to the next faster level. " +
+                            "Zero never moves blocks up.",
+                defaultInt=0,
+                experimental=true
+        )
+        public int anticache_promote_accesses;
+
+        @ConfigProperty(
+                description="With ${site.anticache_enable_multilevel}, how full (in percent) a level " +
+                            "may get before the EE moves its least recently used blocks down to " +
+                            "the next level.",
+                defaultInt=100,
+                experimental=true
+        )
+        public int anticache_demote_percent;
+
+        @ConfigProperty(
+                description="Before a transaction runs, have the EE check whether the tuple its " +
+                            "partitioning parameter selects through the primary key of an evictable " +
+                            "table is evicted. If it is, the transaction waits for the AntiCacheManager " +
+                            "to read in the block before it runs any queries, instead of being aborted " +
+                            "and restarted once it hits the tuple halfway through.",
+                defaultBoolean=false,
+                experimental=true
+        )
+        public boolean anticache_prefetch;
+
+        @ConfigProperty(
+                description="Drop the entries that the non-unique secondary indexes of evictable " +
+                            "tables have for evicted tuples, keeping only the key range of each " +
+                            "evicted block. Saves memory at the cost of reading in blocks that may " +
+                            "not hold the key looked up.",
+                defaultBoolean=false,
+                experimental=true
+        )
+        public boolean anticache_evict_indexes;
        
         @ConfigProperty(
             description="Enable the anti-cache timestamps feature. This requires that the system " +
@@ -803,6 +886,31 @@ public final class HStoreConf {
         )
         public long storage_mmap_sync_frequency; 
 
+        @ConfigProperty(
+            description="How many microseconds each EE tick may spend moving tuples out of the " +
+                        "sparse trailing blocks of a table so that those blocks can be freed. " +
+                        "Zero disables table compaction.",
+            defaultLong=1000,
+            experimental=true
+        )
+        public long storage_compaction_budget;
+
+        @ConfigProperty(
+            description="Back the EE's table blocks, memory pools and index arrays with 2MB " +
+                        "huge pages where the OS provides them.",
+            defaultBoolean=false,
+            experimental=true
+        )
+        public boolean storage_huge_pages;
+
+        @ConfigProperty(
+            description="Allocate the EE's table blocks, memory pools and index arrays on the " +
+                        "NUMA node of the partition's thread.",
+            defaultBoolean=false,
+            experimental=true
+        )
+        public boolean storage_numa_local;
+
         // ----------------------------------------------------------------------------
         // ARIES Physical Recovery Options
         // ----------------------------------------------------------------------------
@@ -836,6 +944,42 @@ public final class HStoreConf {
                 experimental=true
         )
         public boolean aries_reset;
+
+        @ConfigProperty(
+                description="The longest time in microseconds that ARIES log records are buffered " +
+                            "before they are written out and synced together. " +
+                            "This is only used if ${site.aries} is enabled. ",
+                defaultLong=2000,
+                experimental=true
+        )
+        public long aries_group_commit_micros;
+
+        @ConfigProperty(
+                description="Make a transaction wait for its ARIES log records to be durable " +
+                            "before it commits. If disabled, a crash can lose the transactions " +
+                            "that committed within the last group commit interval. " +
+                            "This is only used if ${site.aries} is enabled. ",
+                defaultBoolean=true,
+                experimental=true
+        )
+        public boolean aries_sync_on_commit;
+
+        @ConfigProperty(
+                description="Open the ARIES log with O_DSYNC instead of syncing it after " +
+                            "every write. This is only used if ${site.aries} is enabled. ",
+                defaultBoolean=false,
+                experimental=true
+        )
+        public boolean aries_dsync;
+
+        @ConfigProperty(
+                description="The number of threads that replay the ARIES log during recovery. " +
+                            "Zero means one thread per core. " +
+                            "This is only used if ${site.aries} is enabled. ",
+                defaultInt=0,
+                experimental=true
+        )
+        public int aries_recovery_threads;
         
         // ----------------------------------------------------------------------------
         //  Logical Recovery Options
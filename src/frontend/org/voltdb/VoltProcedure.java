@@ -36,6 +36,8 @@ import java.util.concurrent.atomic.AtomicBoolean;
 
 import org.apache.log4j.Logger;
 import org.voltdb.catalog.CatalogMap;
+import org.voltdb.catalog.Column;
+import org.voltdb.catalog.Index;
 import org.voltdb.catalog.PlanFragment;
 import org.voltdb.catalog.ProcParameter;
 import org.voltdb.catalog.Procedure;
@@ -137,6 +139,10 @@ public abstract class VoltProcedure implements Poolable {
     /** The local partition id where this VoltProcedure is running */
     protected int partitionId = -1;
 
+    /** The evictable table whose primary key is the partitioning parameter, if anti-cache prefetching is on */
+    private Table prefetchTable = null;
+    private int prefetchParam = -1;
+
     /** Callback for when the VoltProcedure finishes and we need to send a ClientResponse somewhere **/
     private EventObservable<ClientResponse> observable = null;
 
@@ -410,11 +416,46 @@ public abstract class VoltProcedure implements Poolable {
                 paramTypeComponentType[param.getIndex()] = null;
             }
         }
+
+        // ANTI-CACHE PREFETCH
+        if (hstore_conf.site.anticache_enable && hstore_conf.site.anticache_prefetch &&
+            catalog_proc.getHasjava() && this.procIsMapReduce == false &&
+            catalog_proc.getSystemproc() == false && catalog_proc.getPartitionparameter() >= 0) {
+            this.initPrefetchTable();
+        }
+        
         if (trace.val)
             LOG.trace(String.format("Initialized VoltProcedure for %s [partition=%d]",
                       this.procedure_name, this.partitionId));
     }
     
+    /**
+     * Prefetching only knows the key of a txn up front if its partitioning
+     * parameter is the whole primary key of an evictable table
+     */
+    private void initPrefetchTable() {
+        Column catalog_col = this.catalog_proc.getPartitioncolumn();
+        if (catalog_col == null) return;
+        Table catalog_tbl = catalog_col.getParent();
+        if (catalog_tbl.getEvictable() == false) return;
+        
+        Index catalog_idx = null;
+        try {
+            catalog_idx = CatalogUtil.getPrimaryKeyIndex(catalog_tbl);
+        } catch (Exception ex) {
+            return;
+        }
+        if (catalog_idx.getColumns().size() != 1 ||
+            catalog_idx.getColumns().get(0).getColumn().equals(catalog_col) == false) {
+            return;
+        }
+        this.prefetchTable = catalog_tbl;
+        this.prefetchParam = this.catalog_proc.getPartitionparameter();
+        if (debug.val)
+            LOG.debug(String.format("%s prefetches evicted tuples of %s from parameter #%d",
+                      this.procedure_name, catalog_tbl.getName(), this.prefetchParam));
+    }
+    
     protected SQLStmt getSQLStmt(String name) {
         return (this.stmts.get(name));
     }
@@ -572,6 +613,21 @@ public abstract class VoltProcedure implements Poolable {
                           this.procParams + Arrays.toString(this.procParams),
                           this.partitionId));
             try {
+                // ANTI-CACHE PREFETCH
+                // If the tuple that the txn is going to look up by its partitioning
+                // parameter is evicted, send it to the AntiCacheManager before it
+                // runs any queries. The blocks are read in on the AntiCacheManager's
+                // thread and merged below once the txn is scheduled again.
+                if (this.prefetchTable != null && txnState.hasAntiCacheMergeTable() == false) {
+                    Object keys[] = { this.procParams[this.prefetchParam] };
+                    try {
+                        this.executor.getExecutionEngine().antiCachePrefetch(this.prefetchTable, keys);
+                    } catch (EvictedTupleAccessException ex) {
+                        ex.setPartitionId(this.partitionId);
+                        throw ex;
+                    }
+                }
+                
                 // ANTI-CACHE TABLE MERGE
                 if (hstore_conf.site.anticache_enable && txnState.hasAntiCacheMergeTable()) {
                     if (debug.val)
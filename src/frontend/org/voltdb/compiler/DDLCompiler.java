@@ -432,7 +432,9 @@ public class DDLCompiler {
 
         // set the type of the index based on it's name (giant hack)
         String indexNameNoCase = name.toLowerCase();
-        if (indexNameNoCase.contains("tree"))
+        if (indexNameNoCase.contains("ctree"))
+            index.setType(IndexType.CONCURRENT_TREE.getValue());
+        else if (indexNameNoCase.contains("tree"))
             index.setType(IndexType.BALANCED_TREE.getValue());
         else if (indexNameNoCase.contains("array"))
             index.setType(IndexType.ARRAY.getValue());
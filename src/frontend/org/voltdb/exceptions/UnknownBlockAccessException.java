@@ -15,7 +15,7 @@ public class UnknownBlockAccessException extends SerializableException {
 
     public static final long serialVersionUID = 0L;
 
-    public final int block_id;
+    public final long block_id;
     
     /**
      * 
@@ -25,9 +25,9 @@ public class UnknownBlockAccessException extends SerializableException {
         super(buffer);
         
         FastDeserializer fds = new FastDeserializer(buffer);
-        int _block_id;
+        long _block_id;
         try {
-            _block_id = fds.readShort();
+            _block_id = fds.readLong();
         } catch (IOException ex) {
             throw new RuntimeException(ex);
         }
@@ -37,7 +37,7 @@ public class UnknownBlockAccessException extends SerializableException {
     /**
      * Retrieve the block ids that the txn tried to access that generated this exception.
      */
-    public int getBlockId() {
+    public long getBlockId() {
         return (this.block_id);
     }
 
@@ -46,7 +46,7 @@ public class UnknownBlockAccessException extends SerializableException {
      */
     @Override
     protected int p_getSerializedSize() {
-        return (6);
+        return (8);
     }
 
     /**
@@ -57,7 +57,7 @@ public class UnknownBlockAccessException extends SerializableException {
     protected void p_serializeToBuffer(ByteBuffer b) throws IOException {
         FastSerializer fs = new FastSerializer();
         try {
-            fs.writeShort(this.block_id);
+            fs.writeLong(this.block_id);
         } catch (IOException ex) {
             throw new RuntimeException(ex);
         }
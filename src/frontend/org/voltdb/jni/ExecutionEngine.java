@@ -39,7 +39,9 @@ import org.voltdb.messaging.FastDeserializer;
 import org.voltdb.utils.DBBPool.BBContainer;
 import org.voltdb.utils.LogKeys;
 import org.voltdb.utils.VoltLoggerFactory;
+import org.voltdb.types.AntiCacheCompressionType;
 import org.voltdb.types.AntiCacheDBType;
+import org.voltdb.types.AntiCacheEvictionOrderType;
 
 import edu.brown.hstore.HStore;
 import edu.brown.hstore.PartitionExecutor;
@@ -389,6 +391,25 @@ public abstract class ExecutionEngine implements FastDeserializer.Deserializatio
      */
     abstract public void tick(long time, long lastCommittedTxnId);
 
+    /**
+     * Set how long each tick() may spend moving tuples out of the sparse
+     * trailing blocks of tables so that they can be released.
+     * @param micros time budget per tick, 0 turns compaction off
+     * @throws EEException
+     */
+    abstract public void setCompactionTimeBudget(long micros) throws EEException;
+
+    /**
+     * Back the table blocks, pool chunks and index arrays that the EE allocates
+     * from now on with huge pages and/or memory on the NUMA node of the calling
+     * thread. This applies to the whole process, so it should be invoked
+     * before the catalog is loaded.
+     * @param hugePages use 2MB pages where the OS has them
+     * @param numaLocal prefer the NUMA node of the partition's thread
+     * @throws EEException
+     */
+    abstract public void setBlockAllocatorOptions(boolean hugePages, boolean numaLocal) throws EEException;
+
     /**
      * Instruct EE to come to an idle state. Flush Export buffers, finish
      * any in-progress checkpoint, etc.
@@ -598,6 +619,10 @@ public abstract class ExecutionEngine implements FastDeserializer.Deserializatio
      */
     protected native void nativeTick(long pointer, long time, long lastCommittedTxnId);
 
+    protected native int nativeSetCompactionTimeBudget(long pointer, long micros);
+
+    protected native int nativeSetBlockAllocatorOptions(long pointer, boolean hugePages, boolean numaLocal);
+
     /**
      * Native implementation of quiesce engine interface method.
      * @param pointer
@@ -817,7 +842,7 @@ public abstract class ExecutionEngine implements FastDeserializer.Deserializatio
      * @param catalog_tbl
      * @param block_ids
      */
-    public abstract void antiCacheReadBlocks(Table catalog_tbl, int block_ids[], int tuple_offsets[]);
+    public abstract void antiCacheReadBlocks(Table catalog_tbl, long block_ids[], int tuple_offsets[]);
 
     /**
      * Forcibly tell the EE that it needs to evict a certain number of bytes
@@ -844,6 +869,74 @@ public abstract class ExecutionEngine implements FastDeserializer.Deserializatio
      * @param catalog_tbl
      */
     public abstract void antiCacheMergeBlocks(Table catalog_tbl);
+
+    /**
+     * Compress the blocks that the EE evicts from now on with the given format.
+     * <B>NOTE:</B> This can only be invoked after antiCacheInitialize is invoked
+     * @param type
+     * @param level The compression level, or 0 for the format's default
+     * @throws EEException if the EE was compiled without that format
+     */
+    public abstract void antiCacheSetCompression(AntiCacheCompressionType type, int level) throws EEException;
+
+    /**
+     * Choose whether the unevicted tuples of a table are merged back by
+     * reading their whole blocks or only the tuples that were accessed
+     * @param catalog_tbl
+     * @param blockMerge false to merge single tuples
+     */
+    public abstract void antiCacheSetMergeStrategy(Table catalog_tbl, boolean blockMerge);
+
+    /**
+     * Choose how the EE picks the tuples of a table to evict
+     * <B>NOTE:</B> This can only be invoked after antiCacheInitialize is invoked
+     * @param catalog_tbl
+     * @param order
+     * @throws EEException
+     */
+    public abstract void antiCacheSetEvictionOrder(Table catalog_tbl, AntiCacheEvictionOrderType order) throws EEException;
+
+    /**
+     * Hand the compression and writing of evicted blocks to a background
+     * thread in the EE.
+     * <B>NOTE:</B> This can only be invoked after antiCacheInitialize is invoked
+     * @param queueDepth The number of blocks that may wait to be written, or 0 to write them inline
+     * @throws EEException
+     */
+    public abstract void antiCacheSetBackgroundWrites(int queueDepth) throws EEException;
+
+    /**
+     * Set when the EE moves evicted blocks between the anti-cache levels.
+     * The EE does this on its own in tick().
+     * <B>NOTE:</B> This can only be invoked after antiCacheInitialize is invoked
+     * @param promoteAccesses Tuple reads after which a block goes up a level, or 0 to never promote
+     * @param demotePercent How full (1-100) a level gets before its LRU blocks go down a level
+     * @throws EEException
+     */
+    public abstract void antiCacheSetTierPolicy(int promoteAccesses, int demotePercent) throws EEException;
+
+    /**
+     * Check whether the tuples with the given primary keys are evicted before
+     * the transaction that is about to access them runs. If they are, this
+     * throws the EvictedTupleAccessException that the transaction would have
+     * hit halfway through, so that it waits for the AntiCacheManager to read
+     * in the blocks instead.
+     * <B>NOTE:</B> This can only be invoked after antiCacheInitialize is invoked
+     * @param catalog_tbl
+     * @param keys The values of the primary key columns, one key after the other
+     * @throws EEException
+     */
+    public abstract void antiCachePrefetch(Table catalog_tbl, Object keys[]) throws EEException;
+
+    /**
+     * Choose whether the non-unique secondary indexes of a table keep entries
+     * for its evicted tuples, or only the key range of each evicted block.
+     * <B>NOTE:</B> This can only be invoked before any tuple of the table is evicted
+     * @param catalog_tbl
+     * @param evictIndexes
+     * @throws EEException if the table has evicted tuples or no primary key
+     */
+    public abstract void antiCacheSetIndexEviction(Table catalog_tbl, boolean evictIndexes) throws EEException;
         
     /**
      * Enables the anti-cache feature in the EE. The given database directory path
@@ -879,7 +972,7 @@ public abstract class ExecutionEngine implements FastDeserializer.Deserializatio
      * @param block_ids
      * @return
      */
-    protected native int nativeAntiCacheReadBlocks(long pointer, int tableId, int block_ids[], int tuple_offsets[]);
+    protected native int nativeAntiCacheReadBlocks(long pointer, int tableId, long block_ids[], int tuple_offsets[]);
     
     /**
      * 
@@ -906,6 +999,67 @@ public abstract class ExecutionEngine implements FastDeserializer.Deserializatio
      * @return
      */
     protected native int nativeAntiCacheMergeBlocks(long pointer, int tableId);
+
+    /**
+     * 
+     * @param pointer
+     * @param compressionType
+     * @param level
+     * @return
+     */
+    protected native int nativeAntiCacheSetCompression(long pointer, int compressionType, int level);
+
+    /**
+     * 
+     * @param pointer
+     * @param tableId
+     * @param blockMerge
+     * @return
+     */
+    protected native int nativeAntiCacheSetMergeStrategy(long pointer, int tableId, boolean blockMerge);
+
+    /**
+     * 
+     * @param pointer
+     * @param tableId
+     * @param evictionPolicy
+     * @return
+     */
+    protected native int nativeAntiCacheSetEvictionPolicy(long pointer, int tableId, int evictionPolicy);
+
+    /**
+     * 
+     * @param pointer
+     * @param queueDepth
+     * @return
+     */
+    protected native int nativeAntiCacheSetBackgroundWrites(long pointer, int queueDepth);
+
+    /**
+     * 
+     * @param pointer
+     * @param promoteAccesses
+     * @param demotePercent
+     * @return
+     */
+    protected native int nativeAntiCacheSetTierPolicy(long pointer, int promoteAccesses, int demotePercent);
+
+    /**
+     * The keys are passed in the parameter buffer
+     * @param pointer
+     * @param tableId
+     * @return
+     */
+    protected native int nativeAntiCachePrefetch(long pointer, int tableId);
+
+    /**
+     * 
+     * @param pointer
+     * @param tableId
+     * @param evictIndexes
+     * @return
+     */
+    protected native int nativeAntiCacheSetIndexEviction(long pointer, int tableId, boolean evictIndexes);
     
     /**
      * This code only does anything useful on MACOSX.
@@ -932,11 +1086,32 @@ public abstract class ExecutionEngine implements FastDeserializer.Deserializatio
 
     public abstract void ARIESInitialize(File dbDir, File logFile) throws EEException;
 
+    /**
+     * Set the group commit policy of the partition's ARIES log.
+     * <B>NOTE:</B> This can only be invoked after ARIESInitialize()
+     * @param groupCommitMicros the longest a batch of log records stays open
+     * @param syncOnCommit whether a commit waits for its records to be durable
+     * @param useDSync open the log O_DSYNC instead of syncing each batch
+     * @throws EEException
+     */
+    public abstract void ARIESSetGroupCommit(long groupCommitMicros, boolean syncOnCommit, boolean useDSync) throws EEException;
+
+    /**
+     * Set how many threads replay the partition's ARIES log during recovery.
+     * @param numThreads replay threads, 0 means one per core
+     * @throws EEException
+     */
+    public abstract void ARIESSetRecoveryThreads(int numThreads) throws EEException;
+
     /**
      * Enables the ARIES  feature in the EE. The given database directory path
      * must be a unique location for this partition where the EE can store ARIES logs
      */
     protected native int nativeARIESInitialize(long pointer, String dbDir, String logFile);
+
+    protected native int nativeARIESSetGroupCommit(long pointer, long groupCommitMicros, boolean syncOnCommit, boolean useDSync);
+
+    protected native int nativeARIESSetRecoveryThreads(long pointer, int numThreads);
         
     protected native void nativeDoAriesRecoveryPhase(long pointer, long replayPointer, long replayLogSize, long replayTxnId);
 
@@ -49,7 +49,9 @@ import org.voltdb.messaging.FastDeserializer;
 import org.voltdb.messaging.FastSerializer;
 import org.voltdb.utils.DBBPool.BBContainer;
 import org.voltdb.utils.NotImplementedException;
+import org.voltdb.types.AntiCacheCompressionType;
 import org.voltdb.types.AntiCacheDBType;
+import org.voltdb.types.AntiCacheEvictionOrderType;
 
 import edu.brown.hstore.HStore;
 import edu.brown.hstore.PartitionExecutor;
@@ -790,6 +792,16 @@ public class ExecutionEngineIPC extends ExecutionEngine {
         // no return code for tick.
     }
 
+    @Override
+    public void setCompactionTimeBudget(long micros) throws EEException {
+        throw new NotImplementedException("Table compaction is disabled for IPC ExecutionEngine");
+    }
+
+    @Override
+    public void setBlockAllocatorOptions(boolean hugePages, boolean numaLocal) throws EEException {
+        throw new NotImplementedException("Block allocator options are disabled for IPC ExecutionEngine");
+    }
+
     @Override
     public void quiesce(long lastCommittedTransactionId) {
         int result = ExecutionEngine.ERRORCODE_ERROR;
@@ -1489,7 +1501,7 @@ public class ExecutionEngineIPC extends ExecutionEngine {
     }
 
     @Override
-    public void antiCacheReadBlocks(Table catalog_tbl, int[] block_ids, int[] tuple_offsets) {
+    public void antiCacheReadBlocks(Table catalog_tbl, long[] block_ids, int[] tuple_offsets) {
         throw new NotImplementedException("Anti-Caching is disabled for IPC ExecutionEngine");
     }
 
@@ -1498,6 +1510,41 @@ public class ExecutionEngineIPC extends ExecutionEngine {
         throw new NotImplementedException("Anti-Caching is disabled for IPC ExecutionEngine");
     }
 
+    @Override
+    public void antiCacheSetCompression(AntiCacheCompressionType type, int level) throws EEException {
+        throw new NotImplementedException("Anti-Caching is disabled for IPC ExecutionEngine");
+    }
+
+    @Override
+    public void antiCacheSetMergeStrategy(Table catalog_tbl, boolean blockMerge) {
+        throw new NotImplementedException("Anti-Caching is disabled for IPC ExecutionEngine");
+    }
+
+    @Override
+    public void antiCacheSetEvictionOrder(Table catalog_tbl, AntiCacheEvictionOrderType order) throws EEException {
+        throw new NotImplementedException("Anti-Caching is disabled for IPC ExecutionEngine");
+    }
+
+    @Override
+    public void antiCacheSetBackgroundWrites(int queueDepth) throws EEException {
+        throw new NotImplementedException("Anti-Caching is disabled for IPC ExecutionEngine");
+    }
+
+    @Override
+    public void antiCacheSetTierPolicy(int promoteAccesses, int demotePercent) throws EEException {
+        throw new NotImplementedException("Anti-Caching is disabled for IPC ExecutionEngine");
+    }
+
+    @Override
+    public void antiCachePrefetch(Table catalog_tbl, Object keys[]) throws EEException {
+        throw new NotImplementedException("Anti-Caching is disabled for IPC ExecutionEngine");
+    }
+
+    @Override
+    public void antiCacheSetIndexEviction(Table catalog_tbl, boolean evictIndexes) throws EEException {
+        throw new NotImplementedException("Anti-Caching is disabled for IPC ExecutionEngine");
+    }
+
     @Override
     public VoltTable antiCacheEvictBlock(Table catalog_tbl, long block_size, int num_blocks) {
         throw new NotImplementedException("Anti-Caching is disabled for IPC ExecutionEngine");
@@ -1520,6 +1567,16 @@ public class ExecutionEngineIPC extends ExecutionEngine {
     public void ARIESInitialize(File dbDir, File logFile) throws EEException {
         throw new NotImplementedException("ARIES recovery is disabled for IPC ExecutionEngine");
     }
+
+    @Override
+    public void ARIESSetGroupCommit(long groupCommitMicros, boolean syncOnCommit, boolean useDSync) throws EEException {
+        throw new NotImplementedException("ARIES recovery is disabled for IPC ExecutionEngine");
+    }
+
+    @Override
+    public void ARIESSetRecoveryThreads(int numThreads) throws EEException {
+        throw new NotImplementedException("ARIES recovery is disabled for IPC ExecutionEngine");
+    }
     
     @Override
     public long getArieslogBufferLength() {
@@ -39,7 +39,9 @@ import org.voltdb.export.ExportProtoMessage;
 import org.voltdb.messaging.FastDeserializer;
 import org.voltdb.messaging.FastSerializer;
 import org.voltdb.messaging.FastSerializer.BufferGrowCallback;
+import org.voltdb.types.AntiCacheCompressionType;
 import org.voltdb.types.AntiCacheDBType;
+import org.voltdb.types.AntiCacheEvictionOrderType;
 import org.voltdb.utils.DBBPool.BBContainer;
 
 import edu.brown.hstore.HStoreConstants;
@@ -516,6 +518,18 @@ public class ExecutionEngineJNI extends ExecutionEngine {
         nativeTick(this.pointer, time, lastCommittedTxnId);
     }
 
+    @Override
+    public void setCompactionTimeBudget(long micros) throws EEException {
+        final int errorCode = nativeSetCompactionTimeBudget(this.pointer, micros);
+        checkErrorCode(errorCode);
+    }
+
+    @Override
+    public void setBlockAllocatorOptions(boolean hugePages, boolean numaLocal) throws EEException {
+        final int errorCode = nativeSetBlockAllocatorOptions(this.pointer, hugePages, numaLocal);
+        checkErrorCode(errorCode);
+    }
+
     @Override
     public void quiesce(long lastCommittedTxnId) {
         nativeQuiesce(this.pointer, lastCommittedTxnId);
@@ -803,7 +817,7 @@ public class ExecutionEngineJNI extends ExecutionEngine {
 
     
     @Override
-    public void antiCacheReadBlocks(Table catalog_tbl, int[] block_ids, int[] tuple_offsets) {
+    public void antiCacheReadBlocks(Table catalog_tbl, long[] block_ids, int[] tuple_offsets) {
         if (m_anticache == false) {
             String msg = "Trying to invoke anti-caching operation but feature is not enabled";
             throw new VoltProcedure.VoltAbortException(msg);
@@ -877,6 +891,71 @@ public class ExecutionEngineJNI extends ExecutionEngine {
         checkErrorCode(errorCode);
     }
 
+    @Override
+    public void antiCacheSetCompression(AntiCacheCompressionType type, int level) throws EEException {
+        assert(m_anticache);
+        if (debug.val)
+            LOG.debug(String.format("Compressing anti-cache blocks at partition %d with %s [level=%d]",
+                                    this.executor.getPartitionId(), type, level));
+        final int errorCode = nativeAntiCacheSetCompression(this.pointer, type.ordinal(), level);
+        checkErrorCode(errorCode);
+    }
+
+    @Override
+    public void antiCacheSetMergeStrategy(Table catalog_tbl, boolean blockMerge) {
+        assert(m_anticache);
+        final int errorCode = nativeAntiCacheSetMergeStrategy(this.pointer, catalog_tbl.getRelativeIndex(), blockMerge);
+        checkErrorCode(errorCode);
+    }
+
+    @Override
+    public void antiCacheSetEvictionOrder(Table catalog_tbl, AntiCacheEvictionOrderType order) throws EEException {
+        assert(m_anticache);
+        if (debug.val)
+            LOG.debug(String.format("Evicting tuples of table %s in %s order", catalog_tbl.getName(), order));
+        final int errorCode = nativeAntiCacheSetEvictionPolicy(this.pointer, catalog_tbl.getRelativeIndex(), order.ordinal());
+        checkErrorCode(errorCode);
+    }
+
+    @Override
+    public void antiCacheSetBackgroundWrites(int queueDepth) throws EEException {
+        assert(m_anticache);
+        final int errorCode = nativeAntiCacheSetBackgroundWrites(this.pointer, queueDepth);
+        checkErrorCode(errorCode);
+    }
+
+    @Override
+    public void antiCacheSetTierPolicy(int promoteAccesses, int demotePercent) throws EEException {
+        assert(m_anticache);
+        final int errorCode = nativeAntiCacheSetTierPolicy(this.pointer, promoteAccesses, demotePercent);
+        checkErrorCode(errorCode);
+    }
+
+    @Override
+    public void antiCachePrefetch(Table catalog_tbl, Object keys[]) throws EEException {
+        assert(m_anticache);
+        ParameterSet parameterSet = new ParameterSet(true);
+        parameterSet.setParameters(keys);
+
+        // serialize the param set
+        fsForParameterSet.clear();
+        try {
+            parameterSet.writeExternal(fsForParameterSet);
+        } catch (final IOException exception) {
+            throw new RuntimeException(exception); // can't happen
+        }
+
+        final int errorCode = nativeAntiCachePrefetch(this.pointer, catalog_tbl.getRelativeIndex());
+        checkErrorCode(errorCode);
+    }
+
+    @Override
+    public void antiCacheSetIndexEviction(Table catalog_tbl, boolean evictIndexes) throws EEException {
+        assert(m_anticache);
+        final int errorCode = nativeAntiCacheSetIndexEviction(this.pointer, catalog_tbl.getRelativeIndex(), evictIndexes);
+        checkErrorCode(errorCode);
+    }
+
     
     /*
      * MMAP STORAGE
@@ -908,6 +987,18 @@ public class ExecutionEngineJNI extends ExecutionEngine {
         checkErrorCode(errorCode);
         m_anticache = true;
     }
+
+    @Override
+    public void ARIESSetGroupCommit(long groupCommitMicros, boolean syncOnCommit, boolean useDSync) throws EEException {
+        final int errorCode = nativeARIESSetGroupCommit(this.pointer, groupCommitMicros, syncOnCommit, useDSync);
+        checkErrorCode(errorCode);
+    }
+
+    @Override
+    public void ARIESSetRecoveryThreads(int numThreads) throws EEException {
+        final int errorCode = nativeARIESSetRecoveryThreads(this.pointer, numThreads);
+        checkErrorCode(errorCode);
+    }
     
     @Override
     public void doAriesRecoveryPhase(long replayPointer, long replayLogSize, long replayTxnId) {
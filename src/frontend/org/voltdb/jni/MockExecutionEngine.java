@@ -31,7 +31,9 @@ import org.voltdb.exceptions.EEException;
 import org.voltdb.export.ExportProtoMessage;
 import org.voltdb.utils.NotImplementedException;
 import org.voltdb.utils.DBBPool.BBContainer;
+import org.voltdb.types.AntiCacheCompressionType;
 import org.voltdb.types.AntiCacheDBType;
+import org.voltdb.types.AntiCacheEvictionOrderType;
 
 public class MockExecutionEngine extends ExecutionEngine {
 
@@ -120,6 +122,16 @@ public class MockExecutionEngine extends ExecutionEngine {
         // TODO Auto-generated method stub
     }
 
+    @Override
+    public void setCompactionTimeBudget(long micros) throws EEException {
+        // TODO Auto-generated method stub
+    }
+
+    @Override
+    public void setBlockAllocatorOptions(boolean hugePages, boolean numaLocal) throws EEException {
+        // TODO Auto-generated method stub
+    }
+
     @Override
     public int toggleProfiler(final int toggle) {
         // TODO Auto-generated method stub
@@ -209,7 +221,7 @@ public class MockExecutionEngine extends ExecutionEngine {
     }
 
     @Override
-    public void antiCacheReadBlocks(Table catalog_tbl, int[] block_ids, int[] tuple_offsets) {
+    public void antiCacheReadBlocks(Table catalog_tbl, long[] block_ids, int[] tuple_offsets) {
         // TODO Auto-generated method stub
     }
     @Override
@@ -217,6 +229,41 @@ public class MockExecutionEngine extends ExecutionEngine {
         // TODO Auto-generated method stub
     }
 
+    @Override
+    public void antiCacheSetCompression(AntiCacheCompressionType type, int level) throws EEException {
+        // TODO Auto-generated method stub
+    }
+
+    @Override
+    public void antiCacheSetMergeStrategy(Table catalog_tbl, boolean blockMerge) {
+        // TODO Auto-generated method stub
+    }
+
+    @Override
+    public void antiCacheSetEvictionOrder(Table catalog_tbl, AntiCacheEvictionOrderType order) throws EEException {
+        // TODO Auto-generated method stub
+    }
+
+    @Override
+    public void antiCacheSetBackgroundWrites(int queueDepth) throws EEException {
+        // TODO Auto-generated method stub
+    }
+
+    @Override
+    public void antiCacheSetTierPolicy(int promoteAccesses, int demotePercent) throws EEException {
+        // TODO Auto-generated method stub
+    }
+
+    @Override
+    public void antiCachePrefetch(Table catalog_tbl, Object keys[]) throws EEException {
+        // TODO Auto-generated method stub
+    }
+
+    @Override
+    public void antiCacheSetIndexEviction(Table catalog_tbl, boolean evictIndexes) throws EEException {
+        // TODO Auto-generated method stub
+    }
+
     @Override
     public VoltTable antiCacheEvictBlock(Table catalog_tbl, long block_size, int num_blocks) {
         // TODO Auto-generated method stub
@@ -242,6 +289,16 @@ public class MockExecutionEngine extends ExecutionEngine {
      // TODO Auto-generated method stub        
     }
 
+    @Override
+    public void ARIESSetGroupCommit(long groupCommitMicros, boolean syncOnCommit, boolean useDSync) throws EEException {
+        // TODO Auto-generated method stub
+    }
+
+    @Override
+    public void ARIESSetRecoveryThreads(int numThreads) throws EEException {
+        // TODO Auto-generated method stub
+    }
+
     @Override
     public long getArieslogBufferLength() { 
     // XXX: do nothing, we only implement this for JNI now.
@@ -165,7 +165,8 @@ public abstract class SubPlanAssembler {
         // TODO: Should be metadata on the IndexType instance.
         final boolean indexScannable =
             (index.getType() == IndexType.BALANCED_TREE.getValue()) ||
-            (index.getType() == IndexType.BTREE.getValue());
+            (index.getType() == IndexType.BTREE.getValue()) ||
+            (index.getType() == IndexType.CONCURRENT_TREE.getValue());
 
         // build a set of all columns we can filter on (using equality for now)
         // sort expressions in to the proper buckets within the access path
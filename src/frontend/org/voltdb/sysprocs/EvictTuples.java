@@ -43,6 +43,11 @@ public class EvictTuples extends VoltSystemProcedure {
         new ColumnInfo("ANTICACHE_TUPLES_EVICTED", VoltType.INTEGER),
         new ColumnInfo("ANTICACHE_BLOCKS_EVICTED", VoltType.INTEGER),
         new ColumnInfo("ANTICACHE_BYTES_EVICTED", VoltType.BIGINT),
+        new ColumnInfo("ANTICACHE_BLOCK_BYTES_RAW", VoltType.BIGINT),
+        new ColumnInfo("ANTICACHE_BLOCK_BYTES_STORED", VoltType.BIGINT),
+        new ColumnInfo("ANTICACHE_COMPRESS_MICROS", VoltType.BIGINT),
+        new ColumnInfo("ANTICACHE_DECOMPRESS_MICROS", VoltType.BIGINT),
+        new ColumnInfo("ANTICACHE_EVICT_PAUSE_MICROS", VoltType.BIGINT),
         new ColumnInfo("CREATED", VoltType.TIMESTAMP),
     };
     
@@ -150,6 +155,11 @@ public class EvictTuples extends VoltSystemProcedure {
                     tuplesEvicted,
                     blocksEvicted,
                     bytesEvicted,
+                    vt.getLong("ANTICACHE_BLOCK_BYTES_RAW"),
+                    vt.getLong("ANTICACHE_BLOCK_BYTES_STORED"),
+                    vt.getLong("ANTICACHE_COMPRESS_MICROS"),
+                    vt.getLong("ANTICACHE_DECOMPRESS_MICROS"),
+                    vt.getLong("ANTICACHE_EVICT_PAUSE_MICROS"),
                     new TimestampType()
             };
             allResults.addRow(row);
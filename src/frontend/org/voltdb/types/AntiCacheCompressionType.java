@@ -0,0 +1,44 @@
+package org.voltdb.types;
+
+import java.util.EnumSet;
+import java.util.HashMap;
+import java.util.Map;
+
+/**
+ * How the EE compresses anti-cache blocks before writing them out.
+ * The ordinals match AntiCacheCompressionType in the EE's common/types.h
+ */
+public enum AntiCacheCompressionType {
+    /**
+     * Blocks are written as they are serialized
+     */
+    NONE,
+    /**
+     * LZ4 (fast)
+     */
+    LZ4,
+    /**
+     * Zstd with a dictionary trained per table
+     */
+    ZSTD
+    ;
+
+    private static final Map<String, AntiCacheCompressionType> name_lookup = new HashMap<String, AntiCacheCompressionType>();
+    static {
+        for (AntiCacheCompressionType vt : EnumSet.allOf(AntiCacheCompressionType.class)) {
+            name_lookup.put(vt.name().toLowerCase(), vt);
+        }
+    } // STATIC
+
+    public static AntiCacheCompressionType get(int idx) {
+        AntiCacheCompressionType values[] = AntiCacheCompressionType.values();
+        if (idx < 0 || idx >= values.length) {
+            return(null);
+        }
+        return (values[idx]);
+    }
+
+    public static AntiCacheCompressionType get(String name) {
+        return AntiCacheCompressionType.name_lookup.get(name.toLowerCase());
+    }
+}
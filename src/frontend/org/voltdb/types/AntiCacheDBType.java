@@ -20,7 +20,11 @@ public enum AntiCacheDBType {
     /**
      * NVM file-based store
      */
-    NVM
+    NVM,
+    /**
+     * Block file read asynchronously in batches
+     */
+    FILE
     ;
 
     private static final Map<String, AntiCacheDBType> name_lookup = new HashMap<String, AntiCacheDBType>();
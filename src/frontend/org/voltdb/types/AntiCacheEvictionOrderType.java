@@ -0,0 +1,43 @@
+package org.voltdb.types;
+
+import java.util.EnumSet;
+import java.util.HashMap;
+import java.util.Map;
+
+/**
+ * How the EE picks the tuples of a table to evict. Unlike
+ * AntiCacheEvictionPolicyType, which spreads evictions over tables, this is
+ * applied within each table. The ordinals match AntiCacheEvictionPolicy in
+ * the EE's common/types.h
+ */
+public enum AntiCacheEvictionOrderType {
+    /**
+     * Tuples are evicted in the order of the LRU chain kept in their headers
+     */
+    LRU,
+    /**
+     * A CLOCK hand sweeps the table's storage blocks and evicts the tuples
+     * of blocks that were not referenced since it last passed them
+     */
+    CLOCK
+    ;
+
+    private static final Map<String, AntiCacheEvictionOrderType> name_lookup = new HashMap<String, AntiCacheEvictionOrderType>();
+    static {
+        for (AntiCacheEvictionOrderType vt : EnumSet.allOf(AntiCacheEvictionOrderType.class)) {
+            name_lookup.put(vt.name().toLowerCase(), vt);
+        }
+    } // STATIC
+
+    public static AntiCacheEvictionOrderType get(int idx) {
+        AntiCacheEvictionOrderType values[] = AntiCacheEvictionOrderType.values();
+        if (idx < 0 || idx >= values.length) {
+            return(null);
+        }
+        return (values[idx]);
+    }
+
+    public static AntiCacheEvictionOrderType get(String name) {
+        return AntiCacheEvictionOrderType.name_lookup.get(name.toLowerCase());
+    }
+}
@@ -14463,15 +14463,15 @@ public final class Hstoreservice {
     public boolean hasTableId() { return hasTableId; }
     public int getTableId() { return tableId_; }
     
-    // repeated int32 block_ids = 5 [packed = true];
+    // repeated int64 block_ids = 5 [packed = true];
     public static final int BLOCK_IDS_FIELD_NUMBER = 5;
-    private java.util.List<java.lang.Integer> blockIds_ =
+    private java.util.List<java.lang.Long> blockIds_ =
       java.util.Collections.emptyList();
-    public java.util.List<java.lang.Integer> getBlockIdsList() {
+    public java.util.List<java.lang.Long> getBlockIdsList() {
       return blockIds_;
     }
     public int getBlockIdsCount() { return blockIds_.size(); }
-    public int getBlockIds(int index) {
+    public long getBlockIds(int index) {
       return blockIds_.get(index);
     }
     private int blockIdsMemoizedSerializedSize = -1;
@@ -14526,8 +14526,8 @@ public final class Hstoreservice {
         output.writeRawVarint32(42);
         output.writeRawVarint32(blockIdsMemoizedSerializedSize);
       }
-      for (int element : getBlockIdsList()) {
-        output.writeInt32NoTag(element);
+      for (long element : getBlockIdsList()) {
+        output.writeInt64NoTag(element);
       }
       if (getTupleOffsetsList().size() > 0) {
         output.writeRawVarint32(50);
@@ -14566,9 +14566,9 @@ public final class Hstoreservice {
       }
       {
         int dataSize = 0;
-        for (int element : getBlockIdsList()) {
+        for (long element : getBlockIdsList()) {
           dataSize += com.google.protobuf.CodedOutputStream
-            .computeInt32SizeNoTag(element);
+            .computeInt64SizeNoTag(element);
         }
         size += dataSize;
         if (!getBlockIdsList().isEmpty()) {
@@ -14776,7 +14776,7 @@ public final class Hstoreservice {
         }
         if (!other.blockIds_.isEmpty()) {
           if (result.blockIds_.isEmpty()) {
-            result.blockIds_ = new java.util.ArrayList<java.lang.Integer>();
+            result.blockIds_ = new java.util.ArrayList<java.lang.Long>();
           }
           result.blockIds_.addAll(other.blockIds_);
         }
@@ -14831,14 +14831,14 @@ public final class Hstoreservice {
               break;
             }
             case 40: {
-              addBlockIds(input.readInt32());
+              addBlockIds(input.readInt64());
               break;
             }
             case 42: {
               int length = input.readRawVarint32();
               int limit = input.pushLimit(length);
               while (input.getBytesUntilLimit() > 0) {
-                addBlockIds(input.readInt32());
+                addBlockIds(input.readInt64());
               }
               input.popLimit(limit);
               break;
@@ -14937,31 +14937,31 @@ public final class Hstoreservice {
         return this;
       }
       
-      // repeated int32 block_ids = 5 [packed = true];
-      public java.util.List<java.lang.Integer> getBlockIdsList() {
+      // repeated int64 block_ids = 5 [packed = true];
+      public java.util.List<java.lang.Long> getBlockIdsList() {
         return java.util.Collections.unmodifiableList(result.blockIds_);
       }
       public int getBlockIdsCount() {
         return result.getBlockIdsCount();
       }
-      public int getBlockIds(int index) {
+      public long getBlockIds(int index) {
         return result.getBlockIds(index);
       }
-      public Builder setBlockIds(int index, int value) {
+      public Builder setBlockIds(int index, long value) {
         result.blockIds_.set(index, value);
         return this;
       }
-      public Builder addBlockIds(int value) {
+      public Builder addBlockIds(long value) {
         if (result.blockIds_.isEmpty()) {
-          result.blockIds_ = new java.util.ArrayList<java.lang.Integer>();
+          result.blockIds_ = new java.util.ArrayList<java.lang.Long>();
         }
         result.blockIds_.add(value);
         return this;
       }
       public Builder addAllBlockIds(
-          java.lang.Iterable<? extends java.lang.Integer> values) {
+          java.lang.Iterable<? extends java.lang.Long> values) {
         if (result.blockIds_.isEmpty()) {
-          result.blockIds_ = new java.util.ArrayList<java.lang.Integer>();
+          result.blockIds_ = new java.util.ArrayList<java.lang.Long>();
         }
         super.addAll(values, result.blockIds_);
         return this;
@@ -17668,7 +17668,7 @@ public final class Hstoreservice {
       "\002 \002(\0162\030.edu.brown.hstore.Status\"\267\001\n\022Unev" +
       "ictDataRequest\022\023\n\013sender_site\030\001 \002(\005\022\026\n\016t" +
       "ransaction_id\030\002 \002(\003\022\024\n\014partition_id\030\003 \002(" +
-      "\005\022\020\n\010table_id\030\004 \002(\005\022\025\n\tblock_ids\030\005 \003(\005B\002" +
+      "\005\022\020\n\010table_id\030\004 \002(\005\022\025\n\tblock_ids\030\005 \003(\003B\002" +
       "\020\001\022\031\n\rtuple_offsets\030\006 \003(\005B\002\020\001\022\032\n\022new_tra" +
       "nsaction_id\030\007 \002(\003\"\202\001\n\023UnevictDataRespons" +
       "e\022\023\n\013sender_site\030\001 \002(\005\022(\n\006status\030\002 \002(\0162\030" +
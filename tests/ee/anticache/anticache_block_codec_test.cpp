@@ -0,0 +1,184 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string>
+#include "harness.h"
+#include "anticache/AntiCacheBlockCodec.h"
+#include "common/serializeio.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace voltdb;
+
+#define BLOCK_SIZE 262144
+#define TABLE_NAME "FAKE"
+
+/**
+ * AntiCacheBlockCodec Tests
+ */
+class AntiCacheBlockCodecTest : public Test {
+public:
+    AntiCacheBlockCodecTest() {
+        srand(0);
+    };
+
+    /**
+     * Lay out a block the way BerkeleyDBBlock does (table count, table
+     * name, tuple count) followed by tuple-like rows that compress well.
+     */
+    vector<char> makeBlock(int seed) {
+        vector<char> data(BLOCK_SIZE);
+        ReferenceSerializeOutput out(&data[0], BLOCK_SIZE);
+        out.writeInt(1);
+        out.writeTextString(TABLE_NAME);
+        out.writeInt(BLOCK_SIZE / 64);
+        int row = 0;
+        while (out.remaining() >= 64) {
+            char buffer[64];
+            memset(buffer, 0, sizeof(buffer));
+            snprintf(buffer, sizeof(buffer), "customer-%08d|seed-%d|balance-%06d", row, seed, (row * 7) % 100000);
+            out.writeBytes(buffer, sizeof(buffer));
+            row++;
+        }
+        return data;
+    }
+
+    vector<char> makeRandomBlock() {
+        vector<char> data(BLOCK_SIZE);
+        data[3] = 1;
+        for (int i = 4; i < BLOCK_SIZE; i++) {
+            data[i] = static_cast<char>(rand());
+        }
+        return data;
+    }
+
+    void checkRoundTrip(AntiCacheBlockCodec &codec, const vector<char> &raw, bool expectCompressed) {
+        long storedSize;
+        const char* stored = codec.compressBlock(TABLE_NAME, &raw[0], (long)raw.size(), storedSize);
+        ASSERT_EQ(expectCompressed, AntiCacheBlockCodec::isCompressed(stored, storedSize));
+        if (expectCompressed) {
+            ASSERT_TRUE(storedSize < (long)raw.size());
+        } else {
+            ASSERT_EQ((long)raw.size(), storedSize);
+        }
+
+        // the stored bytes have to outlive the codec's buffer, like they do in an AntiCacheDB
+        vector<char> copy(stored, stored + storedSize);
+        long rawSize;
+        char* restored = codec.decompressBlock(TABLE_NAME, &copy[0], storedSize, rawSize);
+        ASSERT_EQ((long)raw.size(), rawSize);
+        ASSERT_EQ(0, memcmp(&raw[0], restored, rawSize));
+        delete [] restored;
+    }
+};
+
+TEST_F(AntiCacheBlockCodecTest, NoCompression) {
+    AntiCacheBlockCodec codec;
+    ASSERT_EQ(ANTICACHE_COMPRESSION_NONE, codec.getCompression());
+
+    vector<char> raw = makeBlock(0);
+    long storedSize;
+    const char* stored = codec.compressBlock(TABLE_NAME, &raw[0], (long)raw.size(), storedSize);
+    ASSERT_EQ(&raw[0], stored);
+    ASSERT_FALSE(AntiCacheBlockCodec::isCompressed(stored, storedSize));
+    checkRoundTrip(codec, raw, false);
+
+    AntiCacheCodecStats stats = codec.getStats(TABLE_NAME);
+    ASSERT_EQ(2, stats.blocksWritten);
+    ASSERT_EQ(stats.rawBytes, stats.storedBytes);
+    ASSERT_EQ(1, stats.blocksRead);
+}
+
+TEST_F(AntiCacheBlockCodecTest, UnavailableFormat) {
+    AntiCacheBlockCodec codec;
+    if (AntiCacheBlockCodec::isAvailable(ANTICACHE_COMPRESSION_LZ4) == false) {
+        ASSERT_FALSE(codec.setCompression(ANTICACHE_COMPRESSION_LZ4, 0));
+        ASSERT_EQ(ANTICACHE_COMPRESSION_NONE, codec.getCompression());
+    }
+    if (AntiCacheBlockCodec::isAvailable(ANTICACHE_COMPRESSION_ZSTD) == false) {
+        ASSERT_FALSE(codec.setCompression(ANTICACHE_COMPRESSION_ZSTD, 0));
+        ASSERT_EQ(ANTICACHE_COMPRESSION_NONE, codec.getCompression());
+    }
+}
+
+TEST_F(AntiCacheBlockCodecTest, LZ4) {
+    if (AntiCacheBlockCodec::isAvailable(ANTICACHE_COMPRESSION_LZ4) == false) return;
+    AntiCacheBlockCodec codec;
+
+    // a block written before compression was turned on must still be readable
+    vector<char> old = makeBlock(1);
+    long oldSize;
+    const char* oldStored = codec.compressBlock(TABLE_NAME, &old[0], (long)old.size(), oldSize);
+    vector<char> oldCopy(oldStored, oldStored + oldSize);
+
+    ASSERT_TRUE(codec.setCompression(ANTICACHE_COMPRESSION_LZ4, 0));
+    checkRoundTrip(codec, makeBlock(2), true);
+    checkRoundTrip(codec, makeRandomBlock(), false);
+
+    long rawSize;
+    char* restored = codec.decompressBlock(TABLE_NAME, &oldCopy[0], oldSize, rawSize);
+    ASSERT_EQ(0, memcmp(&old[0], restored, rawSize));
+    delete [] restored;
+
+    AntiCacheCodecStats stats = codec.getStats(TABLE_NAME);
+    ASSERT_EQ(3, stats.blocksWritten);
+    ASSERT_TRUE(stats.storedBytes < stats.rawBytes);
+}
+
+TEST_F(AntiCacheBlockCodecTest, ZstdDictionary) {
+    if (AntiCacheBlockCodec::isAvailable(ANTICACHE_COMPRESSION_ZSTD) == false) return;
+    AntiCacheBlockCodec codec;
+    ASSERT_TRUE(codec.setCompression(ANTICACHE_COMPRESSION_ZSTD, 0));
+
+    // blocks compressed before and after the dictionary is trained
+    vector<vector<char> > stored;
+    vector<vector<char> > raw;
+    int blocksToTrain = AntiCacheBlockCodec::DICT_SAMPLE_BYTES /
+                        (AntiCacheBlockCodec::DICT_SAMPLE_SIZE * AntiCacheBlockCodec::DICT_SAMPLES_PER_BLOCK);
+    for (int i = 0; i < blocksToTrain + 2; i++) {
+        raw.push_back(makeBlock(i));
+        long storedSize;
+        const char* data = codec.compressBlock(TABLE_NAME, &raw.back()[0], (long)raw.back().size(), storedSize);
+        ASSERT_TRUE(AntiCacheBlockCodec::isCompressed(data, storedSize));
+        stored.push_back(vector<char>(data, data + storedSize));
+    }
+    ASSERT_TRUE(codec.hasDictionary(TABLE_NAME));
+    ASSERT_FALSE(codec.hasDictionary("OTHER"));
+
+    for (size_t i = 0; i < stored.size(); i++) {
+        long rawSize;
+        char* restored = codec.decompressBlock(TABLE_NAME, &stored[i][0], (long)stored[i].size(), rawSize);
+        ASSERT_EQ((long)raw[i].size(), rawSize);
+        ASSERT_EQ(0, memcmp(&raw[i][0], restored, rawSize));
+        delete [] restored;
+    }
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -46,6 +46,10 @@
 #include "boost/scoped_ptr.hpp"
 
 #include "anticache/AntiCacheDB.h"
+#include "anticache/FileAntiCacheDB.h"
+#include "anticache/EvictedTable.h"
+#include "anticache/EvictedIndexRanges.h"
+#include "anticache/EvictedTupleAccessException.h"
 
 #define BLOCK_SIZE 1024000
 #define MAX_SIZE 1024000000
@@ -140,12 +144,12 @@ public:
         primaryKeyIndexScheme.keySchema = m_primaryKeyIndexSchema;
         secondaryIndexScheme.keySchema = m_primaryKeyIndexSchema;
         std::vector<voltdb::TableIndexScheme> indexes;
-        indexes.push_back(primaryKeyIndexScheme);
         indexes.push_back(secondaryIndexScheme);
         
         m_table = dynamic_cast<voltdb::PersistentTable*>(voltdb::TableFactory::getPersistentTable
                                                          (0, m_engine->getExecutorContext(), "Foo",
-                                                          m_tableSchema, &m_columnNames[0], indexes, 0,
+                                                          m_tableSchema, &m_columnNames[0],
+                                                          primaryKeyIndexScheme, indexes, 0,
                                                           false, false));
                 
         TupleSchema *evictedSchema = TupleSchema::createEvictedTupleSchema();
@@ -220,20 +224,21 @@ TEST_F(AntiCacheEvictionManagerTest, MigrateBlock) {
     string tableName("TEST");
     string payload("Test payload");
 
-    int16_t blockId = nvmdb->nextBlockId();
+    int64_t blockId = nvmdb->nextBlockId();
     nvmdb->writeBlock(tableName,
         blockId,
         1,
         const_cast<char*>(payload.data()),
         static_cast<int>(payload.size())+1);
 
-    //int32_t fullBlockId = (nvm_acid << 16) | blockId;
-    //VOLT_INFO("acid: %x, blockId: %x fullBlockId: %x\n", nvm_acid, blockId, fullBlockId);
+    //int64_t fullBlockId = AntiCacheDB::packBlockId(nvm_acid, blockId);
+    //VOLT_INFO("acid: %x, blockId: %lx fullBlockId: %lx\n", nvm_acid, (long)blockId, (long)fullBlockId);
     
     //AntiCacheBlock* nvmblock = nvmdb->readBlock(blockId);
-    int32_t newBlockId = (int32_t) acem->migrateBlock(blockId, berkeleydb);
-    int16_t _new_block_id = (int16_t) (newBlockId & 0x0000FFFF);
-    VOLT_INFO("blockId: %x newBlockId: %x _new_block_id: %x", blockId, newBlockId, _new_block_id);
+    int64_t newBlockId = acem->migrateBlock(blockId, berkeleydb);
+    int64_t _new_block_id = AntiCacheDB::unpackBlockId(newBlockId);
+    ASSERT_EQ(berkeley_acid, AntiCacheDB::unpackACID(newBlockId));
+    VOLT_INFO("blockId: %lx newBlockId: %lx _new_block_id: %lx", (long)blockId, (long)newBlockId, (long)_new_block_id);
     AntiCacheBlock* berkeleyblock = berkeleydb->readBlock(_new_block_id);
     VOLT_INFO("tableName: %s berkeleyblock name: %s", tableName.c_str(), berkeleyblock->getTableName().c_str());
     
@@ -253,7 +258,7 @@ TEST_F(AntiCacheEvictionManagerTest, MigrateBlock) {
 
     VOLT_DEBUG("migrating LRU block..."); 
     
-    int16_t blockIdLRU = nvmdb->nextBlockId();
+    int64_t blockIdLRU = nvmdb->nextBlockId();
     nvmdb->writeBlock(tableNameLRU,
         blockIdLRU,
         1,
@@ -268,9 +273,9 @@ TEST_F(AntiCacheEvictionManagerTest, MigrateBlock) {
         static_cast<int>(payload.size())+1);
     
     //AntiCacheBlock* nvmblock = nvmdb->readBlock(blockId);
-    newBlockId = (int32_t)acem->migrateLRUBlock(nvmdb, berkeleydb);
+    newBlockId = acem->migrateLRUBlock(nvmdb, berkeleydb);
     
-    _new_block_id = (int16_t) (newBlockId & 0x0000FFFF);
+    _new_block_id = AntiCacheDB::unpackBlockId(newBlockId);
 
     berkeleyblock = berkeleydb->readBlock(_new_block_id);
     VOLT_INFO("tableName: %s berkeleyblock name: %s\n", tableName.c_str(), berkeleyblock->getTableName().c_str());
@@ -293,6 +298,355 @@ TEST_F(AntiCacheEvictionManagerTest, MigrateBlock) {
     delete acem;
 }
 
+TEST_F(AntiCacheEvictionManagerTest, BatchedBlockFetch) {
+    initTable(true);
+    string temp = tempdir.name();
+    ExecutorContext* ctx = m_engine->getExecutorContext();
+
+    AntiCacheEvictionManager* acem = new AntiCacheEvictionManager(m_engine);
+    AntiCacheDB* filedb = new FileAntiCacheDB(ctx, temp, BLOCK_SIZE, MAX_SIZE);
+    AntiCacheDB* nvmdb = new NVMAntiCacheDB(ctx, temp, BLOCK_SIZE, MAX_SIZE);
+    int16_t file_acid = acem->addAntiCacheDB(filedb);
+    int16_t nvm_acid = acem->addAntiCacheDB(nvmdb);
+
+    // an empty block of the table, just the block header
+    CopySerializeOutput out;
+    out.writeInt(1);
+    out.writeTextString(m_table->name());
+    out.writeInt(0);
+
+    const int numBlocks = 6;
+    int64_t blockIds[numBlocks];
+    int32_t tupleOffsets[numBlocks];
+    for (int i = 0; i < numBlocks; i++) {
+        AntiCacheDB* db = (i % 2 == 0) ? filedb : nvmdb;
+        int64_t blockId = db->nextBlockId();
+        db->writeBlock(m_table->name(), blockId, 0, static_cast<const char*>(out.data()), out.size());
+        blockIds[i] = AntiCacheDB::packBlockId((i % 2 == 0) ? file_acid : nvm_acid, blockId);
+        tupleOffsets[i] = i;
+    }
+
+    // nothing is installed until the fetches are completed
+    ASSERT_TRUE(acem->readEvictedBlocks(m_table, numBlocks, blockIds, tupleOffsets));
+    ASSERT_EQ(0, m_table->unevictedBlocksSize());
+    // asking again does not read the blocks twice
+    ASSERT_TRUE(acem->readEvictedBlocks(m_table, numBlocks, blockIds, tupleOffsets));
+
+    acem->completeFetches(m_table);
+    ASSERT_EQ(numBlocks, m_table->unevictedBlocksSize());
+    ASSERT_EQ(numBlocks, acem->getFetchLatency().count());
+    ASSERT_EQ(0, filedb->getNumBlocks());
+    ASSERT_EQ(0, nvmdb->getNumBlocks());
+    // the blocks are grouped per AntiCacheDB, each keeps its own tuple offset
+    std::set<int32_t> offsets;
+    for (int i = 0; i < numBlocks; i++) {
+        ASSERT_TRUE(m_table->isAlreadyUnEvicted(blockIds[i]));
+        offsets.insert(m_table->getMergeTupleOffset(i));
+        delete [] m_table->getUnevictedBlocks(i);
+    }
+    ASSERT_EQ(numBlocks, (int)offsets.size());
+    m_table->clearUnevictedBlocks();
+    m_table->clearMergeTupleOffsets();
+
+    delete nvmdb;
+    delete filedb;
+    delete acem;
+    cleanupTable();
+}
+
+TEST_F(AntiCacheEvictionManagerTest, TieredMigration) {
+    initTable(true);
+    m_table->setBlockMerge(false);
+    string temp = tempdir.name();
+    ExecutorContext* ctx = m_engine->getExecutorContext();
+
+    AntiCacheEvictionManager* acem = new AntiCacheEvictionManager(m_engine);
+    AntiCacheDB* nvmdb = new NVMAntiCacheDB(ctx, temp, BLOCK_SIZE, 8 * BLOCK_SIZE);
+    AntiCacheDB* filedb = new FileAntiCacheDB(ctx, temp, BLOCK_SIZE, MAX_SIZE);
+    acem->addAntiCacheDB(nvmdb);
+    acem->addAntiCacheDB(filedb);
+
+    // blocks of 8 small tuples with their tuple directory, so that single
+    // tuples can be read out of them
+    const int numTuples = 8;
+    const int tupleSize = 16;
+    int32_t headerSize = static_cast<int32_t>(4 * sizeof(int32_t) + m_table->name().size());
+    CopySerializeOutput out;
+    out.writeInt(1);
+    out.writeTextString(m_table->name());
+    out.writeInt(numTuples);
+    out.writeInt(headerSize + numTuples * tupleSize);
+    for (int i = 0; i < numTuples * tupleSize; i++) {
+        out.writeByte(static_cast<int8_t>(i));
+    }
+    for (int i = 0; i <= numTuples; i++) {
+        out.writeInt(headerSize + i * tupleSize);
+    }
+
+    const int numBlocks = 4;
+    int64_t blockIds[numBlocks];
+    for (int i = 0; i < numBlocks; i++) {
+        int64_t blockId = nvmdb->nextBlockId();
+        nvmdb->writeBlock(m_table->name(), blockId, numTuples, static_cast<const char*>(out.data()), out.size());
+        blockIds[i] = AntiCacheDB::packBlockId(nvmdb->getACID(), blockId);
+    }
+
+    // nothing moves until a tier fills past the watermark
+    ASSERT_EQ(0, acem->migrateTiers(numBlocks));
+    ASSERT_FALSE(acem->setTierPolicy(2, 0));
+    ASSERT_TRUE(acem->setTierPolicy(2, 25));
+
+    // the two coldest blocks go down a tier
+    ASSERT_EQ(2, acem->migrateTiers(numBlocks));
+    ASSERT_EQ(2, nvmdb->getNumBlocks());
+    ASSERT_EQ(2, filedb->getNumBlocks());
+    ASSERT_EQ(2, acem->getTierStats(filedb->getACID()).blocksDemoted);
+
+    // the ids handed out before the move still find the tuples
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(acem->readEvictedBlock(m_table, blockIds[0], i));
+    }
+    ASSERT_EQ(3, acem->getTierStats(filedb->getACID()).tuplesRead);
+    ASSERT_EQ(3, acem->getTierStats(filedb->getACID()).readLatency.count());
+    ASSERT_EQ(2, filedb->getNumBlocks());
+
+    // the block that was read from goes back up once there is room for it
+    ASSERT_TRUE(acem->setTierPolicy(2, 50));
+    ASSERT_EQ(1, acem->migrateTiers(numBlocks));
+    ASSERT_EQ(3, nvmdb->getNumBlocks());
+    ASSERT_EQ(1, filedb->getNumBlocks());
+    ASSERT_EQ(1, acem->getTierStats(nvmdb->getACID()).blocksPromoted);
+    ASSERT_TRUE(acem->readEvictedBlock(m_table, blockIds[0], 3));
+    ASSERT_EQ(1, acem->getTierStats(nvmdb->getACID()).tuplesRead);
+    // its way up did not take the id the other demoted block is still read by
+    ASSERT_TRUE(acem->readEvictedBlock(m_table, blockIds[1], 0));
+    ASSERT_EQ(4, acem->getTierStats(filedb->getACID()).tuplesRead);
+
+    // it is in the fastest tier now, another pass leaves everything alone
+    ASSERT_EQ(0, acem->migrateTiers(numBlocks));
+
+    for (int i = 0; i < m_table->unevictedBlocksSize(); i++) {
+        delete [] m_table->getUnevictedBlocks(i);
+    }
+    m_table->clearUnevictedBlocks();
+    m_table->clearMergeTupleOffsets();
+
+    delete acem;
+    delete filedb;
+    delete nvmdb;
+    cleanupTable();
+}
+
+TEST_F(AntiCacheEvictionManagerTest, TieredMigrationOnTick) {
+    string temp = tempdir.name();
+    m_engine->antiCacheInitialize(temp, ANTICACHEDB_NVM, BLOCK_SIZE, 4 * BLOCK_SIZE);
+    m_engine->antiCacheAddDB(temp, ANTICACHEDB_FILE, BLOCK_SIZE, MAX_SIZE);
+    AntiCacheEvictionManager* acem = m_engine->getExecutorContext()->getAntiCacheEvictionManager();
+    AntiCacheDB* nvmdb = acem->getAntiCacheDB(0);
+    AntiCacheDB* filedb = acem->getAntiCacheDB(1);
+
+    string tableName("Foo");
+    string payload("Demoted by the tick");
+    for (int i = 0; i < 4; i++) {
+        nvmdb->writeBlock(tableName, nvmdb->nextBlockId(), 1, payload.c_str(), static_cast<long>(payload.size())+1);
+    }
+
+    // nothing moves before a tier policy is set
+    m_engine->tick(1000, 0);
+    ASSERT_EQ(4, nvmdb->getNumBlocks());
+    ASSERT_EQ(0, filedb->getNumBlocks());
+
+    // the engine's tick demotes the blocks over the watermark by itself
+    ASSERT_TRUE(m_engine->antiCacheSetTierPolicy(0, 50));
+    m_engine->tick(2000, 0);
+    ASSERT_EQ(2, nvmdb->getNumBlocks());
+    ASSERT_EQ(2, filedb->getNumBlocks());
+    ASSERT_EQ(2, acem->getTierStats(filedb->getACID()).blocksDemoted);
+
+    // and leaves them alone once the tier is below it
+    m_engine->tick(3000, 0);
+    ASSERT_EQ(2, nvmdb->getNumBlocks());
+}
+
+TEST_F(AntiCacheEvictionManagerTest, PrefetchEvictedTuples) {
+    initTable(true);
+    string temp = tempdir.name();
+    ExecutorContext* ctx = m_engine->getExecutorContext();
+
+    AntiCacheEvictionManager* acem = new AntiCacheEvictionManager(m_engine);
+    AntiCacheDB* filedb = new FileAntiCacheDB(ctx, temp, BLOCK_SIZE, MAX_SIZE);
+    int16_t file_acid = acem->addAntiCacheDB(filedb);
+
+    TableTuple tuple = m_table->tempTuple();
+    for (int i = 0; i < 4; i++) {
+        tuple.setNValue(0, ValueFactory::getIntegerValue(i));
+        tuple.setNValue(1, ValueFactory::getIntegerValue(0));
+        m_table->insertTuple(tuple);
+    }
+
+    // an empty block of the table, just the block header
+    CopySerializeOutput out;
+    out.writeInt(1);
+    out.writeTextString(m_table->name());
+    out.writeInt(0);
+
+    // point the indexes of keys 1 and 2 at evicted tuples, each in its own block
+    EvictedTable* evictedTable = static_cast<EvictedTable*>(m_table->getEvictedTable());
+    TableTuple evicted = evictedTable->tempTuple();
+    int64_t blockIds[2];
+    for (int key = 1; key <= 2; key++) {
+        int64_t blockId = filedb->nextBlockId();
+        filedb->writeBlock(m_table->name(), blockId, 0, static_cast<const char*>(out.data()), out.size());
+        blockIds[key - 1] = AntiCacheDB::packBlockId(file_acid, blockId);
+
+        evicted.setNValue(0, ValueFactory::getBigIntValue(blockIds[key - 1]));
+        evicted.setNValue(1, ValueFactory::getIntegerValue(key));
+        evicted.setEvictedTrue();
+        const void* address = evictedTable->insertEvictedTuple(evicted);
+
+        TableIndex* index = m_table->primaryKeyIndex();
+        tuple.setNValue(0, ValueFactory::getIntegerValue(key));
+        ASSERT_TRUE(index->moveToTuple(&tuple));
+        TableTuple current = index->nextValueAtKey();
+        m_table->setEntryToNewAddressForAllIndexes(&current, address, current.address());
+    }
+
+    // keys 0 and 3 are in memory, 99 does not exist
+    NValueArray keys(5);
+    keys[0] = ValueFactory::getIntegerValue(0);
+    keys[1] = ValueFactory::getIntegerValue(1);
+    keys[2] = ValueFactory::getBigIntValue(2);
+    keys[3] = ValueFactory::getIntegerValue(3);
+    keys[4] = ValueFactory::getIntegerValue(99);
+    bool requeued = false;
+    try {
+        acem->prefetchEvictedTuples(m_table, 7, keys, 5);
+    } catch (EvictedTupleAccessException&) {
+        requeued = true;
+    }
+    ASSERT_TRUE(requeued);
+    // nothing is read on the calling thread
+    ASSERT_EQ(0, m_table->unevictedBlocksSize());
+    ASSERT_EQ(2, filedb->getNumBlocks());
+
+    // the keys that are in memory let the txn run
+    acem->prefetchEvictedTuples(m_table, 7, keys, 1);
+
+    const AntiCachePrefetchStats &stats = acem->getPrefetchStats();
+    ASSERT_EQ(2, stats.requests);
+    ASSERT_EQ(6, stats.keysProbed);
+    ASSERT_EQ(2, stats.evictedTuples);
+    ASSERT_EQ(1, stats.requeued);
+    ASSERT_EQ(0, stats.restarts);
+
+    delete filedb;
+    delete acem;
+    cleanupTable();
+}
+
+TEST_F(AntiCacheEvictionManagerTest, EvictedIndexRanges) {
+    initTable(true);
+    AntiCacheEvictionManager* acem = new AntiCacheEvictionManager(m_engine);
+    TableIndex* pkeyIndex = m_table->primaryKeyIndex();
+    TableIndex* secondaryIndex = m_table->index("secondaryIndex");
+
+    ASSERT_TRUE(m_table->setIndexEviction(true));
+    EvictedIndexRanges* ranges = m_table->getEvictedIndexRanges();
+    ASSERT_TRUE(ranges != NULL);
+    ASSERT_FALSE(ranges->covers(pkeyIndex));
+    ASSERT_TRUE(ranges->covers(secondaryIndex));
+
+    // two blocks, one with secondary keys 10-14 and one with 20-24, and
+    // a third one with only the keys 30 and 40
+    TableTuple tuple = m_table->tempTuple();
+    for (int block = 1; block <= 2; block++) {
+        for (int i = 0; i < 5; i++) {
+            tuple.setNValue(0, ValueFactory::getIntegerValue(m_tuplesInserted++));
+            tuple.setNValue(1, ValueFactory::getIntegerValue(block * 10 + (i * 3) % 5));
+            ranges->addTuple(block, tuple);
+        }
+    }
+    for (int i = 3; i <= 4; i++) {
+        tuple.setNValue(0, ValueFactory::getIntegerValue(m_tuplesInserted++));
+        tuple.setNValue(1, ValueFactory::getIntegerValue(i * 10));
+        ranges->addTuple(3, tuple);
+    }
+    ASSERT_EQ(3, (int)ranges->getNumBlocks());
+    ASSERT_EQ(12, ranges->getEntriesEvicted());
+
+    TableTuple searchKey(secondaryIndex->getKeySchema());
+    char keyData[8];
+    searchKey.moveNoHeader(keyData);
+
+    // a key between the blocks needs neither of them
+    searchKey.setNValue(0, ValueFactory::getIntegerValue(17));
+    acem->initEvictedAccessTracker();
+    acem->recordEvictedIndexAccess(NULL, m_table, secondaryIndex, &searchKey, 1, INDEX_LOOKUP_TYPE_EQ, NULL, true);
+    ASSERT_FALSE(acem->hasEvictedAccesses());
+    // the primary key index still has entries for evicted tuples
+    acem->recordEvictedIndexAccess(NULL, m_table, pkeyIndex, &searchKey, 1, INDEX_LOOKUP_TYPE_EQ, NULL, true);
+    ASSERT_FALSE(acem->hasEvictedAccesses());
+
+    // a range scan that ran out of entries needs every block past its key
+    std::vector<int64_t> blockIds;
+    ranges->findBlocks(secondaryIndex, &searchKey, 1, INDEX_LOOKUP_TYPE_GTE, NULL, true, blockIds);
+    ASSERT_EQ(2, (int)blockIds.size());
+    ASSERT_EQ(2, blockIds[0]);
+    ASSERT_EQ(3, blockIds[1]);
+
+    // one that stopped at a tuple doesn't need the blocks past it
+    tuple.setNValue(1, ValueFactory::getIntegerValue(26));
+    blockIds.clear();
+    ranges->findBlocks(secondaryIndex, &searchKey, 1, INDEX_LOOKUP_TYPE_GTE, &tuple, true, blockIds);
+    ASSERT_EQ(1, (int)blockIds.size());
+    ASSERT_EQ(2, blockIds[0]);
+
+    // without search keys the scan starts at either end of the index
+    blockIds.clear();
+    ranges->findBlocks(secondaryIndex, &searchKey, 0, INDEX_LOOKUP_TYPE_EQ, NULL, true, blockIds);
+    ASSERT_EQ(3, (int)blockIds.size());
+    blockIds.clear();
+    ranges->findBlocks(secondaryIndex, &searchKey, 0, INDEX_LOOKUP_TYPE_EQ, &tuple, true, blockIds);
+    ASSERT_EQ(2, (int)blockIds.size());
+    ASSERT_EQ(1, blockIds[0]);
+    ASSERT_EQ(2, blockIds[1]);
+    blockIds.clear();
+    ranges->findBlocks(secondaryIndex, &searchKey, 0, INDEX_LOOKUP_TYPE_EQ, &tuple, false, blockIds);
+    ASSERT_EQ(1, (int)blockIds.size());
+    ASSERT_EQ(3, blockIds[0]);
+
+    // a key inside the range of the third block that none of its tuples
+    // have is kept out by its filter
+    searchKey.setNValue(0, ValueFactory::getIntegerValue(35));
+    blockIds.clear();
+    ranges->findBlocks(secondaryIndex, &searchKey, 1, INDEX_LOOKUP_TYPE_EQ, NULL, true, blockIds);
+    ASSERT_TRUE(blockIds.empty());
+    searchKey.setNValue(0, ValueFactory::getIntegerValue(40));
+    ranges->findBlocks(secondaryIndex, &searchKey, 1, INDEX_LOOKUP_TYPE_EQ, NULL, true, blockIds);
+    ASSERT_EQ(1, (int)blockIds.size());
+    ASSERT_EQ(3, blockIds[0]);
+
+    searchKey.setNValue(0, ValueFactory::getIntegerValue(12));
+    acem->recordEvictedIndexAccess(NULL, m_table, secondaryIndex, &searchKey, 1, INDEX_LOOKUP_TYPE_EQ, NULL, true);
+    ASSERT_TRUE(acem->hasEvictedAccesses());
+
+    // once merged the block's keys are in the index again
+    ranges->removeBlock(1);
+    ASSERT_EQ(2, (int)ranges->getNumBlocks());
+    ASSERT_EQ(7, ranges->getEntriesEvicted());
+    acem->initEvictedAccessTracker();
+    acem->recordEvictedIndexAccess(NULL, m_table, secondaryIndex, &searchKey, 1, INDEX_LOOKUP_TYPE_EQ, NULL, true);
+    ASSERT_FALSE(acem->hasEvictedAccesses());
+
+    ranges->removeBlock(3);
+    ranges->removeBlock(2);
+    ASSERT_TRUE(m_table->setIndexEviction(false));
+    ASSERT_TRUE(m_table->getEvictedIndexRanges() == NULL);
+
+    delete acem;
+    cleanupTable();
+}
+
 TEST_F(AntiCacheEvictionManagerTest, FullBackingStore) {
     ChTempDir tempdir;
 
@@ -311,22 +665,24 @@ TEST_F(AntiCacheEvictionManagerTest, FullBackingStore) {
 
     string tableName("TEST");
     string payload("Test payload");
+    // the block has to fit in a slot together with the table name
+    long size = static_cast<long>(payload.size()) + 1;
 
 
     acdb = acem->getAntiCacheDB(acem->chooseDB(BLOCK_SIZE));
     ASSERT_EQ(0, acdb->getACID());
-    int16_t blockId = acdb->nextBlockId();
+    int64_t blockId = acdb->nextBlockId();
     acdb->writeBlock(tableName,
         blockId,
         1,
         const_cast<char*>(payload.data()),
-        BLOCK_SIZE);
+        size);
 
     acdb = acem->getAntiCacheDB(acem->chooseDB(BLOCK_SIZE));
     ASSERT_EQ(1, acdb->getACID());
     blockId = acdb->nextBlockId();
 
-    acdb->writeBlock(tableName, blockId, 1, const_cast<char*>(payload.data()), BLOCK_SIZE);
+    acdb->writeBlock(tableName, blockId, 1, const_cast<char*>(payload.data()), size);
     
     ASSERT_EQ(1, nvmdb->getNumBlocks());
     ASSERT_EQ(1, berkeleydb->getNumBlocks());
@@ -336,7 +692,7 @@ TEST_F(AntiCacheEvictionManagerTest, FullBackingStore) {
             blockId,
             1,
             const_cast<char*>(payload.data()),
-            BLOCK_SIZE);
+            size);
     } catch (...)  {
             VOLT_INFO("Throwing FullBackingStoreException (this is what we want!)");
             ASSERT_TRUE(true);
@@ -349,6 +705,59 @@ TEST_F(AntiCacheEvictionManagerTest, FullBackingStore) {
 
  
 
+TEST_F(AntiCacheEvictionManagerTest, ClockEviction)
+{
+    initTable(true);
+    AntiCacheEvictionManager* acem = new AntiCacheEvictionManager(m_engine);
+    acem->setEvictionPolicy(m_table, ANTICACHE_EVICTION_CLOCK);
+    ASSERT_EQ(ANTICACHE_EVICTION_CLOCK, m_table->getEvictionPolicy());
+
+    // fill three storage blocks, in order of their keys
+    TableTuple tuple = m_table->tempTuple();
+    tuple.setNValue(0, ValueFactory::getIntegerValue(m_tuplesInserted++));
+    tuple.setNValue(1, ValueFactory::getIntegerValue(rand()));
+    m_table->insertTuple(tuple);
+    int tuples_per_block = (int)m_table->allocatedTupleCount();
+    while (m_tuplesInserted < 3 * tuples_per_block) {
+        tuple.setNValue(0, ValueFactory::getIntegerValue(m_tuplesInserted++));
+        tuple.setNValue(1, ValueFactory::getIntegerValue(rand()));
+        m_table->insertTuple(tuple);
+    }
+    ASSERT_EQ(3 * tuples_per_block, (int)m_table->allocatedTupleCount());
+
+    // every block was referenced by its inserts, so the hand clears them all
+    // and comes back around to the first one
+    EvictionIterator itr(m_table);
+    TableTuple evict_tuple(m_table->schema());
+    ASSERT_TRUE(itr.hasNext());
+    ASSERT_TRUE(itr.next(evict_tuple));
+    ASSERT_EQ(0, ValuePeeker::peekAsInteger(evict_tuple.getNValue(0)) / tuples_per_block);
+
+    // touch the second block while the first one is handed out
+    tuple.setNValue(0, ValueFactory::getIntegerValue(tuples_per_block + 5));
+    TableTuple hot_tuple = m_table->lookupTuple(tuple);
+    acem->updateTuple(m_table, &hot_tuple, false);
+    for (int i = 1; i < tuples_per_block; i++) {
+        ASSERT_TRUE(itr.next(evict_tuple));
+        ASSERT_EQ(0, ValuePeeker::peekAsInteger(evict_tuple.getNValue(0)) / tuples_per_block);
+    }
+
+    // the second block gets a second chance and the third one is next
+    ASSERT_TRUE(itr.next(evict_tuple));
+    ASSERT_EQ(2, ValuePeeker::peekAsInteger(evict_tuple.getNValue(0)) / tuples_per_block);
+
+#ifndef ANTICACHE_TIMESTAMPS
+    // going back to LRU rebuilds the chain in storage order
+    acem->setEvictionPolicy(m_table, ANTICACHE_EVICTION_LRU);
+    ASSERT_EQ(m_tuplesInserted, m_table->getNumTuplesInEvictionChain());
+    ASSERT_EQ(0, (int)m_table->getOldestTupleID());
+    ASSERT_EQ(m_tuplesInserted - 1, (int)m_table->getNewestTupleID());
+#endif
+
+    delete acem;
+    cleanupTable();
+}
+
 #ifndef ANTICACHE_TIMESTAMPS
 TEST_F(AntiCacheEvictionManagerTest, GetTupleID)
 {
@@ -28,6 +28,14 @@
 #include "anticache/AntiCacheDB.h"
 #include "anticache/BerkeleyAntiCacheDB.h"
 #include "anticache/NVMAntiCacheDB.h"
+#include "anticache/FileAntiCacheDB.h"
+#include "anticache/AntiCacheBlockCodec.h"
+#include "anticache/AntiCacheBlockWriter.h"
+#include "anticache/UnknownBlockAccessException.h"
+#include "common/FatalException.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
 
 using namespace std;
 using namespace voltdb;
@@ -50,9 +58,9 @@ TEST_F(AntiCacheDBTest, BerkeleyNextBlockId) {
     ChTempDir tempdir;
     AntiCacheDB* anticache = new BerkeleyAntiCacheDB(NULL, ".", BLOCK_SIZE, MAX_SIZE);
     
-    uint16_t lastBlockId;
+    int64_t lastBlockId;
     for (int i = 0; i < 1000; i++) {
-        uint16_t blockId = anticache->nextBlockId();
+        int64_t blockId = anticache->nextBlockId();
         if (i > 0) ASSERT_NE(lastBlockId, blockId);
         lastBlockId = blockId;
     } // FOR
@@ -65,9 +73,9 @@ TEST_F(AntiCacheDBTest, NVMNextBlockId) {
     ChTempDir tempdir;
     AntiCacheDB* anticache = new NVMAntiCacheDB(NULL, ".", BLOCK_SIZE, MAX_SIZE);
     
-    uint16_t lastBlockId;
+    int64_t lastBlockId;
     for (int i = 0; i < 1000; i++) {
-        uint16_t blockId = anticache->nextBlockId();
+        int64_t blockId = anticache->nextBlockId();
         if (i > 0) ASSERT_NE(lastBlockId, blockId);
         lastBlockId = blockId;
     } // FOR
@@ -84,7 +92,7 @@ TEST_F(AntiCacheDBTest, BerkeleyWriteBlock) {
 
     string tableName("FAKE");
     string payload("Squirrels and Girls!");
-    uint16_t blockId = anticache->nextBlockId();
+    int64_t blockId = anticache->nextBlockId();
 
     try {
         anticache->writeBlock(tableName,
@@ -106,7 +114,7 @@ TEST_F(AntiCacheDBTest, NVMWriteBlock) {
 
     string tableName("FAKE");
     string payload("Squirrels and Girls!");
-    uint16_t blockId = anticache->nextBlockId();
+    int64_t blockId = anticache->nextBlockId();
 
     try {
         anticache->writeBlock(tableName,
@@ -130,7 +138,7 @@ TEST_F(AntiCacheDBTest, BerkeleyReadBlock) {
 
     string tableName("FAKE");
     string payload("Test Read");
-    uint16_t blockId = anticache->nextBlockId();
+    int64_t blockId = anticache->nextBlockId();
 	anticache->writeBlock(tableName,
 						 blockId,
 						 1,
@@ -160,7 +168,7 @@ TEST_F(AntiCacheDBTest, NVMReadBlock) {
 
     string tableName("FAKE");
     string payload("Test Read");
-    uint16_t blockId = anticache->nextBlockId();
+    int64_t blockId = anticache->nextBlockId();
 	anticache->writeBlock(tableName,
 						 blockId,
 						 1,
@@ -188,7 +196,7 @@ TEST_F(AntiCacheDBTest, BerkeleyCheckCapacity) {
     AntiCacheDB* anticache = new BerkeleyAntiCacheDB(NULL, ".", BLOCK_SIZE, BLOCK_SIZE*10);
     string tableName("FAKE");
     string payload("Test Capacity");
-    uint16_t blockId = anticache->nextBlockId();
+    int64_t blockId = anticache->nextBlockId();
     anticache->writeBlock(tableName,
                          blockId,
                          1,
@@ -214,7 +222,7 @@ TEST_F(AntiCacheDBTest, NVMCheckCapacity) {
     AntiCacheDB* anticache = new NVMAntiCacheDB(NULL, ".", BLOCK_SIZE, BLOCK_SIZE*10);
     string tableName("FAKE");
     string payload("Test Capacity");
-    uint16_t blockId = anticache->nextBlockId();
+    int64_t blockId = anticache->nextBlockId();
     anticache->writeBlock(tableName,
                          blockId,
                          1,
@@ -234,6 +242,347 @@ TEST_F(AntiCacheDBTest, NVMCheckCapacity) {
     delete anticache;
 }
 
+TEST_F(AntiCacheDBTest, FileReadBlock) {
+    ChTempDir tempdir;
+
+    AntiCacheDB* anticache = new FileAntiCacheDB(NULL, ".", BLOCK_SIZE, BLOCK_SIZE*10);
+    string tableName("FAKE");
+    string payload("Test Read");
+    int64_t blockId = anticache->nextBlockId();
+    anticache->writeBlock(tableName,
+                         blockId,
+                         1,
+                         const_cast<char*>(payload.data()),
+                         static_cast<int>(payload.size())+1);
+    ASSERT_EQ(anticache->getNumBlocks(), 1);
+    ASSERT_EQ(anticache->getFreeBlocks(), 9);
+
+    AntiCacheBlock* block = anticache->readBlock(blockId);
+    ASSERT_EQ(block->getTableName(), tableName);
+    ASSERT_EQ(block->getBlockId(), blockId);
+    ASSERT_EQ(block->getSize(), static_cast<long>(payload.size() + 1));
+    ASSERT_EQ(0, payload.compare(block->getData()));
+    ASSERT_EQ(anticache->getNumBlocks(), 0);
+    ASSERT_EQ(anticache->getFreeBlocks(), 10);
+
+    // the block is gone once it has been read
+    bool thrown = false;
+    try {
+        delete anticache->readBlock(blockId);
+    } catch (UnknownBlockAccessException &e) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+
+    delete block;
+    delete anticache;
+}
+
+TEST_F(AntiCacheDBTest, FileAsyncReads) {
+    ChTempDir tempdir;
+
+    const int numBlocks = 20;
+    FileAntiCacheDB* anticache = new FileAntiCacheDB(NULL, ".", BLOCK_SIZE, BLOCK_SIZE*numBlocks);
+    string tableName("FAKE");
+    std::vector<int64_t> blockIds;
+    std::vector<string> payloads;
+    for (int i = 0; i < numBlocks; i++) {
+        char payload[32];
+        snprintf(payload, sizeof(payload), "Test Async Read %d", i);
+        payloads.push_back(string(payload));
+        int64_t blockId = anticache->nextBlockId();
+        anticache->writeBlock(tableName, blockId, 1, payload, static_cast<long>(strlen(payload))+1);
+        blockIds.push_back(blockId);
+    }
+    ASSERT_EQ(anticache->getFreeBlocks(), 0);
+
+    // nothing is read when one of the blocks is unknown
+    std::vector<int64_t> unknown(blockIds);
+    unknown.push_back(numBlocks + 1);
+    bool thrown = false;
+    try {
+        anticache->submitReads(unknown);
+    } catch (UnknownBlockAccessException &e) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+    ASSERT_EQ(anticache->getReadsInFlight(), 0);
+    ASSERT_EQ(anticache->getNumBlocks(), numBlocks);
+
+    anticache->submitReads(blockIds);
+    for (int i = numBlocks - 1; i >= 0; i--) {
+        AntiCacheBlock* block = anticache->completeRead(blockIds[i]);
+        ASSERT_EQ(block->getBlockId(), blockIds[i]);
+        ASSERT_EQ(block->getTableName(), tableName);
+        ASSERT_EQ(block->getSize(), static_cast<long>(payloads[i].size() + 1));
+        ASSERT_EQ(0, payloads[i].compare(block->getData()));
+        delete block;
+    }
+    ASSERT_EQ(anticache->getReadsInFlight(), 0);
+    ASSERT_EQ(anticache->getNumBlocks(), 0);
+    if (anticache->isAsync()) {
+        ASSERT_EQ(anticache->getReadLatency().count(), numBlocks);
+    }
+
+    // the slots are handed out again
+    int64_t blockId = anticache->nextBlockId();
+    ASSERT_TRUE(blockId >= 0 && blockId < numBlocks);
+    string payload("Test Reuse");
+    anticache->writeBlock(tableName, blockId, 1, payload.data(), static_cast<long>(payload.size())+1);
+    anticache->submitReads(std::vector<int64_t>(1, blockId));
+    AntiCacheBlock* block = anticache->readBlock(blockId);
+    ASSERT_EQ(0, payload.compare(block->getData()));
+    delete block;
+
+    delete anticache;
+}
+
+TEST_F(AntiCacheDBTest, FileBackgroundWrites) {
+    ChTempDir tempdir;
+
+    const int numBlocks = 20;
+    FileAntiCacheDB* anticache = new FileAntiCacheDB(NULL, ".", BLOCK_SIZE, BLOCK_SIZE*numBlocks);
+    AntiCacheBlockCodec codec;
+    AntiCacheBlockWriter* writer = new AntiCacheBlockWriter(codec);
+    writer->start(4);
+    ASSERT_TRUE(writer->isRunning());
+
+    string tableName("FAKE");
+    std::vector<int64_t> blockIds;
+    std::vector<string> payloads;
+    for (int i = 0; i < numBlocks; i++) {
+        char payload[32];
+        snprintf(payload, sizeof(payload), "Test Background Write %d", i);
+        payloads.push_back(string(payload));
+        int64_t blockId;
+        {
+            AntiCacheBlockWriter::Guard guard(*writer);
+            blockId = anticache->nextBlockId();
+        }
+        // the writer copies the bytes, the buffer goes away right after
+        writer->submit(anticache, tableName, blockId, 1, payload, static_cast<long>(strlen(payload))+1);
+        blockIds.push_back(blockId);
+    }
+    writer->drain();
+    ASSERT_EQ(writer->pendingBlocks(anticache), 0);
+    ASSERT_EQ(anticache->getNumBlocks(), numBlocks);
+    ASSERT_EQ(writer->getWriteLatency().count(), numBlocks);
+    ASSERT_EQ(codec.getStats(tableName).blocksWritten, numBlocks);
+
+    for (int i = 0; i < numBlocks; i++) {
+        AntiCacheBlock* block = anticache->readBlock(blockIds[i]);
+        ASSERT_EQ(block->getTableName(), tableName);
+        ASSERT_EQ(0, payloads[i].compare(block->getData()));
+        delete block;
+    }
+
+    // the writer has to stop before the AntiCacheDB goes away
+    delete writer;
+    delete anticache;
+}
+
+/**
+ * Fails every write with a FatalException while failing is set
+ */
+class FailingFileAntiCacheDB : public FileAntiCacheDB {
+public:
+    FailingFileAntiCacheDB(long blockSize, long maxSize) :
+        FileAntiCacheDB(NULL, ".", blockSize, maxSize), failing(false) {}
+
+    void writeBlock(const std::string tableName, int64_t blockId, const int tupleCount,
+                    const char* data, const long size) {
+        if (failing) {
+            throwFatalException("Failing write of block %ld", (long)blockId);
+        }
+        FileAntiCacheDB::writeBlock(tableName, blockId, tupleCount, data, size);
+    }
+
+    volatile bool failing;
+};
+
+TEST_F(AntiCacheDBTest, FileBackgroundWriteFailure) {
+    ChTempDir tempdir;
+
+    FailingFileAntiCacheDB* anticache = new FailingFileAntiCacheDB(BLOCK_SIZE, BLOCK_SIZE*10);
+    AntiCacheBlockCodec codec;
+    AntiCacheBlockWriter* writer = new AntiCacheBlockWriter(codec);
+    writer->start(4);
+
+    string tableName("FAKE");
+    string payload("Written on the second try");
+    int64_t blockId = anticache->nextBlockId();
+    anticache->failing = true;
+
+    // the FatalException on the thread comes out of submit() or drain() on
+    // this one, depending on how quick the thread is
+    bool thrown = false;
+    try {
+        writer->submit(anticache, tableName, blockId, 1, payload.c_str(), static_cast<long>(payload.size())+1);
+        writer->drain();
+    } catch (FatalException &e) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+    ASSERT_TRUE(writer->isRunning());
+    ASSERT_EQ(writer->pendingBlocks(anticache), 1);
+    ASSERT_EQ(anticache->getNumBlocks(), 0);
+
+    // the writer kept the block, so the next drain() gets it written
+    anticache->failing = false;
+    writer->drain();
+    ASSERT_EQ(writer->pendingBlocks(anticache), 0);
+    ASSERT_EQ(anticache->getNumBlocks(), 1);
+    AntiCacheBlock* block = anticache->readBlock(blockId);
+    ASSERT_EQ(0, payload.compare(block->getData()));
+    delete block;
+
+    // a block that still fails when the writer stops is dropped. The thread
+    // may get to it before submit() returns, which then raises the failure.
+    anticache->failing = true;
+    try {
+        writer->submit(anticache, tableName, anticache->nextBlockId(), 1, payload.c_str(), static_cast<long>(payload.size())+1);
+    } catch (FatalException &e) {
+    }
+    delete writer;
+    ASSERT_EQ(anticache->getNumBlocks(), 0);
+    delete anticache;
+}
+
+TEST_F(AntiCacheDBTest, FileReadBlockRange) {
+    ChTempDir tempdir;
+
+    AntiCacheDB* anticache = new FileAntiCacheDB(NULL, ".", BLOCK_SIZE, BLOCK_SIZE*10);
+    string tableName("FAKE");
+    string payload("0123456789");
+    int64_t blockId = anticache->nextBlockId();
+    anticache->writeBlock(tableName, blockId, 1, payload.data(), static_cast<long>(payload.size()));
+
+    // reading part of a block leaves it in place
+    char buffer[16];
+    ASSERT_EQ(4, anticache->readBlockRange(blockId, 3, 4, buffer));
+    ASSERT_EQ(0, memcmp("3456", buffer, 4));
+    ASSERT_EQ(2, anticache->readBlockRange(blockId, 8, 4, buffer));
+    ASSERT_EQ(0, memcmp("89", buffer, 2));
+    ASSERT_EQ(anticache->getNumBlocks(), 1);
+
+    AntiCacheBlock* block = anticache->readBlock(blockId);
+    ASSERT_EQ(block->getSize(), static_cast<long>(payload.size()));
+    delete block;
+
+    bool thrown = false;
+    try {
+        anticache->readBlockRange(blockId, 0, 4, buffer);
+    } catch (UnknownBlockAccessException &e) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+
+    delete anticache;
+}
+
+TEST_F(AntiCacheDBTest, NVMReadBlockRange) {
+    ChTempDir tempdir;
+
+    AntiCacheDB* anticache = new NVMAntiCacheDB(NULL, ".", BLOCK_SIZE, MAX_SIZE);
+    string tableName("FAKE");
+    string payload("0123456789");
+    int64_t blockId = anticache->nextBlockId();
+    anticache->writeBlock(tableName, blockId, 1, payload.data(), static_cast<long>(payload.size()));
+
+    char buffer[16];
+    ASSERT_EQ(4, anticache->readBlockRange(blockId, 3, 4, buffer));
+    ASSERT_EQ(0, memcmp("3456", buffer, 4));
+    ASSERT_EQ(2, anticache->readBlockRange(blockId, 8, 4, buffer));
+    ASSERT_EQ(0, memcmp("89", buffer, 2));
+
+    AntiCacheBlock* block = anticache->readBlock(blockId);
+    ASSERT_EQ(block->getSize(), static_cast<long>(payload.size()));
+    delete block;
+
+    delete anticache;
+}
+
+TEST_F(AntiCacheDBTest, NVMBlockViews) {
+    ChTempDir tempdir;
+
+    string tableName("FAKE");
+    const int numBlocks = 4;
+    int64_t blockIds[numBlocks];
+    string payloads[numBlocks];
+    NVMAntiCacheDB* anticache = new NVMAntiCacheDB(NULL, ".", BLOCK_SIZE, BLOCK_SIZE*10);
+    for (int i = 0; i < numBlocks; i++) {
+        char payload[32];
+        snprintf(payload, sizeof(payload), "Test Block View %d", i);
+        payloads[i] = payload;
+        blockIds[i] = anticache->nextBlockId();
+        anticache->writeBlock(tableName, blockIds[i], 1, payload, static_cast<long>(strlen(payload))+1);
+    }
+
+    // the block read back is a view of its slot, which stays taken until
+    // the block is deleted
+    AntiCacheBlock* block = anticache->readBlock(blockIds[1]);
+    ASSERT_EQ(0, payloads[1].compare(block->getData()));
+    int64_t blockId = anticache->nextBlockId();
+    ASSERT_NE(blockIds[1], blockId);
+    anticache->writeBlock(tableName, blockId, 1, payloads[0].data(), static_cast<long>(payloads[0].size())+1);
+    delete anticache->readBlock(blockId);
+    delete block;
+    ASSERT_EQ(blockIds[1], anticache->nextBlockId());
+    ASSERT_EQ(numBlocks - 1, anticache->getNumBlocks());
+    delete anticache;
+
+    // the blocks of the previous run are gone
+    anticache = new NVMAntiCacheDB(NULL, ".", BLOCK_SIZE, BLOCK_SIZE*10);
+    ASSERT_EQ(0, anticache->getNumBlocks());
+    ASSERT_EQ(10, anticache->getFreeBlocks());
+    ASSERT_EQ(0, anticache->nextBlockId());
+    delete anticache;
+}
+
+TEST_F(AntiCacheDBTest, BerkeleyReadBlockRange) {
+    ChTempDir tempdir;
+
+    // BerkeleyDB only hands out whole blocks
+    AntiCacheDB* anticache = new BerkeleyAntiCacheDB(NULL, ".", BLOCK_SIZE, MAX_SIZE);
+    string tableName("FAKE");
+    string payload("0123456789");
+    int64_t blockId = anticache->nextBlockId();
+    anticache->writeBlock(tableName, blockId, 1, payload.data(), static_cast<long>(payload.size()));
+
+    char buffer[16];
+    ASSERT_EQ(-1, anticache->readBlockRange(blockId, 3, 4, buffer));
+
+    delete anticache;
+}
+
+TEST_F(AntiCacheDBTest, WideBlockIds) {
+    ChTempDir tempdir;
+
+    // the ACID and the block id survive packing for ids far past 16 bits
+    int64_t wideId = (static_cast<int64_t>(1) << 40) + 7;
+    int64_t packed = AntiCacheDB::packBlockId(3, wideId);
+    ASSERT_EQ(3, AntiCacheDB::unpackACID(packed));
+    ASSERT_EQ(wideId, AntiCacheDB::unpackBlockId(packed));
+
+    // a database can hand out and read back more than 32K blocks
+    const int numBlocks = 40000;
+    AntiCacheDB* anticache = new FileAntiCacheDB(NULL, ".", 1024, 1024L*numBlocks);
+    int64_t blockId = -1;
+    for (int i = 0; i < numBlocks; i++) {
+        blockId = anticache->nextBlockId();
+    }
+    ASSERT_EQ(numBlocks - 1, blockId);
+
+    string tableName("FAKE");
+    string payload("Test Wide Block Id");
+    anticache->writeBlock(tableName, blockId, 1, payload.data(), static_cast<long>(payload.size())+1);
+    AntiCacheBlock* block = anticache->readBlock(blockId);
+    ASSERT_EQ(block->getBlockId(), blockId);
+    ASSERT_EQ(0, payload.compare(block->getData()));
+    delete block;
+
+    delete anticache;
+}
 
 
 int main() {
@@ -0,0 +1,227 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/BlockAllocator.h"
+#include "common/Pool.hpp"
+#include "common/TupleSchema.h"
+#include "common/ValueFactory.hpp"
+#include "common/types.h"
+#include "execution/VoltDBEngine.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace voltdb;
+
+class BlockAllocatorTest : public Test {
+public:
+    BlockAllocatorTest() : m_mappedBytes(BlockAllocator::mappedBytes()) {
+    }
+
+    ~BlockAllocatorTest() {
+        BlockAllocator::configure(false, false);
+    }
+
+    static bool mapped() {
+#ifdef MEMCHECK
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    BlockAllocator m_allocator;
+    int64_t m_mappedBytes;
+};
+
+TEST_F(BlockAllocatorTest, SmallAllocationsComeFromTheHeap) {
+    char *memory = m_allocator.allocate(100);
+    ASSERT_TRUE(memory != NULL);
+    memset(memory, 1, 100);
+    EXPECT_EQ(m_mappedBytes, BlockAllocator::mappedBytes());
+    EXPECT_FALSE(m_allocator.deallocate(memory, 100));
+}
+
+TEST_F(BlockAllocatorTest, LargeAllocationsStayOnTheHeapByDefault) {
+    size_t size = BlockAllocator::MAPPED_ALLOCATION_SIZE * 4;
+    bool onHugePages = true;
+    char *memory = m_allocator.allocate(size, &onHugePages);
+    ASSERT_TRUE(memory != NULL);
+    EXPECT_FALSE(onHugePages);
+    memset(memory, 1, size);
+    EXPECT_EQ(m_mappedBytes, BlockAllocator::mappedBytes());
+    EXPECT_FALSE(m_allocator.deallocate(memory, size));
+}
+
+TEST_F(BlockAllocatorTest, LargeAllocationsAreMapped) {
+    if (!mapped()) return;
+    BlockAllocator::configure(false, true);
+    size_t size = BlockAllocator::MAPPED_ALLOCATION_SIZE + 10;
+    bool onHugePages = true;
+    char *memory = m_allocator.allocate(size, &onHugePages);
+    ASSERT_TRUE(memory != NULL);
+    EXPECT_FALSE(onHugePages);
+    memset(memory, 1, size);
+    EXPECT_TRUE(BlockAllocator::mappedBytes() >= m_mappedBytes + static_cast<int64_t>(size));
+    EXPECT_FALSE(m_allocator.deallocate(memory, size));
+    EXPECT_EQ(m_mappedBytes, BlockAllocator::mappedBytes());
+}
+
+TEST_F(BlockAllocatorTest, OptionsChangingUnderLiveMemory) {
+    if (!mapped()) return;
+    size_t size = BlockAllocator::MAPPED_ALLOCATION_SIZE * 2;
+    char *heap = m_allocator.allocate(size);
+    BlockAllocator::configure(false, true);
+    char *mappedMemory = m_allocator.allocate(size);
+    EXPECT_TRUE(BlockAllocator::mappedBytes() >= m_mappedBytes + static_cast<int64_t>(size));
+
+    // each is released the way it was allocated, whatever the options are now
+    BlockAllocator::configure(false, false);
+    m_allocator.deallocate(mappedMemory, size);
+    EXPECT_EQ(m_mappedBytes, BlockAllocator::mappedBytes());
+    BlockAllocator::configure(false, true);
+    m_allocator.deallocate(heap, size);
+    EXPECT_EQ(m_mappedBytes, BlockAllocator::mappedBytes());
+}
+
+TEST_F(BlockAllocatorTest, HugePagesOrFallback) {
+    if (!mapped()) return;
+    BlockAllocator::configure(true, false);
+    int64_t hugePageBytes = BlockAllocator::hugePageBytes();
+    int64_t transparentBytes = BlockAllocator::transparentHugePageBytes();
+    int64_t fallbacks = BlockAllocator::hugePageFallbacks();
+
+    size_t size = BlockAllocator::HUGE_PAGE_SIZE + 1;
+    bool onHugePages = false;
+    char *memory = m_allocator.allocate(size, &onHugePages);
+    ASSERT_TRUE(memory != NULL);
+    memset(memory, 1, size);
+
+    // rounded up to whole huge pages
+    int64_t length = 2 * BlockAllocator::HUGE_PAGE_SIZE;
+    EXPECT_EQ(m_mappedBytes + length, BlockAllocator::mappedBytes());
+    if (BlockAllocator::hugePageBytes() == hugePageBytes) {
+        // no reserved huge pages, an aligned mapping is advised instead
+        EXPECT_EQ(fallbacks + 1, BlockAllocator::hugePageFallbacks());
+        EXPECT_EQ(0, reinterpret_cast<size_t>(memory) % BlockAllocator::HUGE_PAGE_SIZE);
+        EXPECT_EQ(onHugePages, BlockAllocator::transparentHugePageBytes() == transparentBytes + length);
+    } else {
+        EXPECT_TRUE(onHugePages);
+        EXPECT_EQ(hugePageBytes + length, BlockAllocator::hugePageBytes());
+    }
+
+    EXPECT_EQ(onHugePages, m_allocator.deallocate(memory, size));
+    EXPECT_EQ(m_mappedBytes, BlockAllocator::mappedBytes());
+    EXPECT_EQ(hugePageBytes, BlockAllocator::hugePageBytes());
+    EXPECT_EQ(transparentBytes, BlockAllocator::transparentHugePageBytes());
+
+    // smaller mappings never use huge pages
+    memory = m_allocator.allocate(BlockAllocator::MAPPED_ALLOCATION_SIZE, &onHugePages);
+    EXPECT_FALSE(onHugePages);
+    m_allocator.deallocate(memory, BlockAllocator::MAPPED_ALLOCATION_SIZE);
+}
+
+TEST_F(BlockAllocatorTest, NumaLocal) {
+    if (!mapped()) return;
+    BlockAllocator::configure(false, true);
+    int64_t numaLocalBytes = BlockAllocator::numaLocalBytes();
+    size_t size = BlockAllocator::HUGE_PAGE_SIZE;
+    char *memory = m_allocator.allocate(size);
+    memset(memory, 1, size);
+    // mbind fails without NUMA support, the memory is usable either way
+    EXPECT_TRUE(BlockAllocator::numaLocalBytes() == numaLocalBytes ||
+                BlockAllocator::numaLocalBytes() == numaLocalBytes + static_cast<int64_t>(size));
+    m_allocator.deallocate(memory, size);
+    EXPECT_EQ(numaLocalBytes, BlockAllocator::numaLocalBytes());
+}
+
+TEST_F(BlockAllocatorTest, PoolChunks) {
+    if (!mapped()) return;
+    BlockAllocator::configure(false, true);
+    {
+        Pool pool(BlockAllocator::MAPPED_ALLOCATION_SIZE * 2, 1);
+        EXPECT_EQ(m_mappedBytes + static_cast<int64_t>(BlockAllocator::MAPPED_ALLOCATION_SIZE * 2),
+                  BlockAllocator::mappedBytes());
+        for (int i = 0; i < 10; i++) {
+            memset(pool.allocate(BlockAllocator::MAPPED_ALLOCATION_SIZE), 1, BlockAllocator::MAPPED_ALLOCATION_SIZE);
+        }
+        // oversize chunks are released by purge, extra chunks beyond the first too
+        memset(pool.allocate(BlockAllocator::MAPPED_ALLOCATION_SIZE * 3), 1, BlockAllocator::MAPPED_ALLOCATION_SIZE * 3);
+        pool.purge();
+        EXPECT_EQ(m_mappedBytes + static_cast<int64_t>(BlockAllocator::MAPPED_ALLOCATION_SIZE * 2),
+                  BlockAllocator::mappedBytes());
+    }
+    EXPECT_EQ(m_mappedBytes, BlockAllocator::mappedBytes());
+}
+
+TEST_F(BlockAllocatorTest, TableBlocks) {
+    BlockAllocator::configure(true, true);
+    VoltDBEngine *engine = new VoltDBEngine();
+    engine->initialize(1, 1, 0, 0, "");
+    engine->setUndoToken(INT64_MIN + 1);
+
+    std::string columnNames[] = { "ID", "PAD" };
+    std::vector<ValueType> types;
+    std::vector<int32_t> sizes;
+    std::vector<bool> allowNull(2, false);
+    types.push_back(VALUE_TYPE_BIGINT);
+    sizes.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    types.push_back(VALUE_TYPE_VARCHAR);
+    sizes.push_back(60);
+    TupleSchema *schema = TupleSchema::createTupleSchema(types, sizes, allowNull, true);
+    Table *table = TableFactory::getPersistentTable(0, engine->getExecutorContext(), "FOO",
+                                                    schema, columnNames, -1, false, false);
+
+    NValue pad = ValueFactory::getStringValue("padding");
+    TableTuple &tuple = table->tempTuple();
+    tuple.setNValue(1, pad);
+    for (int64_t id = 0; id < 50000; id++) {
+        tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+        ASSERT_TRUE(table->insertTuple(tuple));
+    }
+    pad.free();
+    ASSERT_TRUE(table->allocatedBlockCount() > 1);
+
+    // either every block made it onto huge pages or none did
+    EXPECT_TRUE(table->hugePageTupleMemory() == 0 ||
+                table->hugePageTupleMemory() == table->allocatedTupleMemory());
+    EXPECT_EQ(BlockAllocator::currentNode(), table->tupleMemoryNumaNode());
+    if (mapped()) {
+        EXPECT_TRUE(BlockAllocator::mappedBytes() >= m_mappedBytes + table->allocatedTupleMemory());
+    }
+
+    engine->releaseUndoToken(INT64_MIN + 1);
+    delete table;
+    delete engine;
+    EXPECT_EQ(m_mappedBytes, BlockAllocator::mappedBytes());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -50,8 +50,10 @@
  */
 
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <unistd.h>
+#include <boost/shared_array.hpp>
 #include <boost/shared_ptr.hpp>
 #include "harness.h"
 #include "common/common.h"
@@ -76,6 +78,11 @@
 #include "catalog/table.h"
 #include "catalog/database.h"
 #include "catalog/constraint.h"
+#include "common/Topend.h"
+#include "common/serializeio.h"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "logging/StdoutLogProxy.h"
 
 using namespace std;
 
@@ -96,6 +103,80 @@ voltdb::ValueType COLUMN_TYPES[NUM_OF_COLUMNS]  = { voltdb::VALUE_TYPE_BIGINT,
 int COLUMN_SIZES[NUM_OF_COLUMNS]                = { 8, 8, 8, 8, 8};
 bool COLUMN_ALLOW_NULLS[NUM_OF_COLUMNS]         = { true, true, true, true, true };
 
+#define BUFFER_SIZE 1024 * 64
+
+//
+// Plan fragments for the batch tests. Both insert one WAREHOUSE row in a
+// single-partition plan, so a row that hashes to another partition fails.
+//
+#define WAREHOUSE_PARAM_COLUMNS \
+    "[{\"GUID\": 1, \"NAME\": \"W_ID\", \"TYPE\": \"INTEGER\", \"SIZE\": 4," \
+    " \"INPUT_TABLE_NAME\": \"\", \"INPUT_COLUMN_NAME\": \"\"," \
+    " \"EXPRESSION\": {\"TYPE\": \"VALUE_PARAMETER\", \"VALUE_TYPE\": \"INTEGER\", \"VALUE_SIZE\": 4, \"PARAM_IDX\": 0}}," \
+    " {\"GUID\": 2, \"NAME\": \"W_NAME\", \"TYPE\": \"STRING\", \"SIZE\": 16," \
+    " \"INPUT_TABLE_NAME\": \"\", \"INPUT_COLUMN_NAME\": \"\"," \
+    " \"EXPRESSION\": {\"TYPE\": \"VALUE_PARAMETER\", \"VALUE_TYPE\": \"STRING\", \"VALUE_SIZE\": 16, \"PARAM_IDX\": 1}}]"
+
+#define WAREHOUSE_INSERT_AND_SEND \
+    "{\"ID\": 3, \"PLAN_NODE_TYPE\": \"SEND\", \"INLINE_NODES\": [], \"CHILDREN_IDS\": [1], \"PARENT_IDS\": []," \
+    " \"OUTPUT_COLUMNS\": " WAREHOUSE_PARAM_COLUMNS ", \"DEPENDENCY_ID\": 1073741825, \"FAKE\": false}," \
+    " {\"ID\": 1, \"PLAN_NODE_TYPE\": \"INSERT\", \"INLINE_NODES\": [], \"CHILDREN_IDS\": [2], \"PARENT_IDS\": [3]," \
+    " \"OUTPUT_COLUMNS\": " WAREHOUSE_PARAM_COLUMNS ", \"TARGET_TABLE_NAME\": \"WAREHOUSE\", \"MULTI_PARTITION\": false}"
+
+// INSERT INTO WAREHOUSE VALUES (?, ?)
+#define INSERT_FRAGMENT_ID 1
+const char *INSERT_FRAGMENT =
+    "{\"PLAN_NODES\": [" WAREHOUSE_INSERT_AND_SEND ","
+    " {\"ID\": 2, \"PLAN_NODE_TYPE\": \"MATERIALIZE\", \"INLINE_NODES\": [], \"CHILDREN_IDS\": [], \"PARENT_IDS\": [1],"
+    " \"OUTPUT_COLUMNS\": " WAREHOUSE_PARAM_COLUMNS ", \"BATCHED\": false}],"
+    " \"PARAMETERS\": [], \"EXECUTE_LIST\": [2, 1, 3]}";
+
+// insert the rows of the input dependency into WAREHOUSE
+#define RECEIVE_FRAGMENT_ID 2
+const char *RECEIVE_FRAGMENT =
+    "{\"PLAN_NODES\": [" WAREHOUSE_INSERT_AND_SEND ","
+    " {\"ID\": 2, \"PLAN_NODE_TYPE\": \"RECEIVE\", \"INLINE_NODES\": [], \"CHILDREN_IDS\": [], \"PARENT_IDS\": [1],"
+    " \"OUTPUT_COLUMNS\": " WAREHOUSE_PARAM_COLUMNS "}],"
+    " \"PARAMETERS\": [], \"EXECUTE_LIST\": [2, 1, 3]}";
+
+//
+// Hands every receive executor one dependency holding a single WAREHOUSE row
+// with the next id in the queue, and remembers the table it loaded.
+//
+class DependencyTopend : public voltdb::Topend {
+    public:
+        DependencyTopend() : destination(NULL), m_loaded(false) {}
+
+        int loadNextDependency(int32_t dependencyId, voltdb::Pool *pool, voltdb::Table* destination) {
+            this->destination = destination;
+            if (m_loaded || ids.empty()) {
+                m_loaded = false;
+                return 0;
+            }
+            voltdb::TableTuple &tuple = destination->tempTuple();
+            tuple.setNValue(0, voltdb::ValueFactory::getIntegerValue(ids.front()));
+            tuple.setNValue(1, voltdb::ValueFactory::getNullStringValue());
+            destination->insertTuple(tuple);
+            ids.erase(ids.begin());
+            m_loaded = true;
+            return 1;
+        }
+
+        void crashVoltDB(voltdb::FatalException e) {
+        }
+
+        std::vector<int32_t> ids;
+        voltdb::Table *destination;
+    private:
+        bool m_loaded;
+};
+
+static string hexEncode(const char *json) {
+    boost::shared_array<char> buffer(new char[strlen(json) * 2 + 1]);
+    catalog::Catalog::hexEncodeString(json, buffer.get());
+    return string(buffer.get());
+}
+
 class ExecutionEngineTest : public Test {
     public:
         ExecutionEngineTest() {
@@ -107,7 +188,7 @@ class ExecutionEngineTest : public Test {
                 "\nadd /clusters[cluster]/databases[database] tables WAREHOUSE"
                 "\nset /clusters[cluster]/databases[database]/tables[WAREHOUSE] type 0"
                 "\nset /clusters[cluster]/databases[database]/tables[WAREHOUSE] isreplicated false"
-                "\nset /clusters[cluster]/databases[database]/tables[WAREHOUSE] partitioncolumn 0"
+                "\nset /clusters[cluster]/databases[database]/tables[WAREHOUSE] partitioncolumn /clusters[cluster]/databases[database]/tables[WAREHOUSE]/columns[W_ID]"
                 "\nset /clusters[cluster]/databases[database]/tables[WAREHOUSE] estimatedtuplecount 0"
                 "\nadd /clusters[cluster]/databases[database]/tables[WAREHOUSE] columns W_ID"
                 "\nset /clusters[cluster]/databases[database]/tables[WAREHOUSE]/columns[W_ID] index 0"
@@ -145,19 +226,27 @@ class ExecutionEngineTest : public Test {
                 "\nset /clusters[cluster]/databases[database]/tables[STOCK]/columns[S_QUANTITY] nullable false"
                 "\nset /clusters[cluster]/databases[database]/tables[STOCK]/columns[S_QUANTITY] name \"S_QUANTITY\""
                 "\nadd /clusters[cluster] hosts 0"
-                "\nadd /clusters[cluster] partitions 0"
-                "\nadd /clusters[cluster] partitions 1"
-                "\nadd /clusters[cluster] partitions 2"
                 "\nadd /clusters[cluster] sites 0"
-                "\nset /clusters[cluster]/sites[0] partition /clusters[cluster]/partitions[0]"
-                "\nset /clusters[cluster]/sites[0] host /clusters[cluster]/hosts[0]";
+                "\nset /clusters[cluster]/sites[0] host /clusters[cluster]/hosts[0]"
+                "\nadd /clusters[cluster]/sites[0] partitions 0"
+                "\nset /clusters[cluster] num_partitions 3"
+                "\nadd /clusters[cluster]/databases[database] procedures InsertWarehouse"
+                "\nadd /clusters[cluster]/databases[database]/procedures[InsertWarehouse] statements insert"
+                "\nadd /clusters[cluster]/databases[database]/procedures[InsertWarehouse]/statements[insert] fragments 1"
+                "\nset /clusters[cluster]/databases[database]/procedures[InsertWarehouse]/statements[insert]/fragments[1] plannodetree \"" + hexEncode(INSERT_FRAGMENT) + "\""
+                "\nadd /clusters[cluster]/databases[database]/procedures[InsertWarehouse] statements receive"
+                "\nadd /clusters[cluster]/databases[database]/procedures[InsertWarehouse]/statements[receive] fragments 2"
+                "\nset /clusters[cluster]/databases[database]/procedures[InsertWarehouse]/statements[receive]/fragments[2] plannodetree \"" + hexEncode(RECEIVE_FRAGMENT) + "\"";
 
             /*
              * Initialize the engine
              */
-            engine = new voltdb::VoltDBEngine();
+            topend = new DependencyTopend();
+            engine = new voltdb::VoltDBEngine(topend, new voltdb::StdoutLogProxy());
             ASSERT_TRUE(engine->initialize(this->cluster_id, this->site_id, 0, 0, ""));
             ASSERT_TRUE(engine->loadCatalog(catalog_string));
+            engine->setBuffers(parameter_buffer, BUFFER_SIZE, result_buffer, BUFFER_SIZE,
+                               exception_buffer, BUFFER_SIZE);
 
             /*
              * Get a link to the catalog and pull out information about it
@@ -188,11 +277,49 @@ class ExecutionEngineTest : public Test {
             delete(this->engine);
         }
 
+        // the first id from start on whose row this site does (not) store
+        int32_t partitionedId(int32_t start, bool local) {
+            while (engine->isLocalSite(voltdb::ValueFactory::getIntegerValue(start)) != local)
+                start++;
+            return start;
+        }
+
+        // appends a parameter set for INSERT_FRAGMENT as org.voltdb.ParameterSet writes it
+        void writeParameters(voltdb::ReferenceSerializeOutput &out, int32_t id, const string &name) {
+            out.writeShort(2);
+            out.writeByte(voltdb::VALUE_TYPE_INTEGER);
+            out.writeInt(id);
+            out.writeByte(voltdb::VALUE_TYPE_VARCHAR);
+            out.writeBinaryString(name.data(), name.size());
+        }
+
+        // number of WAREHOUSE rows with this id, and with this name unless it is NULL
+        int countWarehouse(int32_t id, const char *name) {
+            int count = 0;
+            voltdb::TableIterator iterator(warehouse_table);
+            voltdb::TableTuple tuple(warehouse_table->schema());
+            while (iterator.next(tuple)) {
+                if (voltdb::ValuePeeker::peekInteger(tuple.getNValue(0)) != id)
+                    continue;
+                voltdb::NValue value = tuple.getNValue(1);
+                if (name == NULL ||
+                    (!value.isNull() &&
+                     voltdb::ValuePeeker::peekObjectLength(value) == strlen(name) &&
+                     memcmp(voltdb::ValuePeeker::peekObjectValue(value), name, strlen(name)) == 0))
+                    count++;
+            }
+            return count;
+        }
+
     protected:
         voltdb::CatalogId cluster_id;
         voltdb::CatalogId database_id;
         voltdb::CatalogId site_id;
         voltdb::VoltDBEngine *engine;
+        DependencyTopend *topend; // owned by the engine
+        char parameter_buffer[BUFFER_SIZE];
+        char result_buffer[BUFFER_SIZE];
+        char exception_buffer[BUFFER_SIZE];
         string catalog_string;
         catalog::Catalog *catalog; //This is not the real catalog that the VoltDBEngine uses. It is a duplicate made locally to get GUIDs
         catalog::Cluster *cluster;
@@ -236,6 +363,85 @@ void ExecutionEngineTest::compareTables(voltdb::Table *first, voltdb::Table *sec
     }
 }
 
+// ------------------------------------------------------------------
+// ExecuteQueries_RepeatedParameters
+// ------------------------------------------------------------------
+TEST_F(ExecutionEngineTest, ExecuteQueries_RepeatedParameters) {
+    //
+    // A parameter set that repeats the previous one byte for byte is not
+    // decoded again. Every fragment still has to see its own values, and
+    // the input has to be consumed up to the end of the batch.
+    //
+    int32_t first = partitionedId(1000, true);
+    int32_t second = partitionedId(first + 1, true);
+    int32_t ids[] = { first, first, second, second, first };
+    const char *names[] = { "alpha", "alpha", "beta", "beta", "alpha" };
+    const int batch = 5;
+
+    voltdb::ReferenceSerializeOutput out(parameter_buffer, BUFFER_SIZE);
+    int64_t fragmentIds[batch];
+    int32_t outputDepIds[batch];
+    int32_t inputDepIds[batch];
+    for (int i = 0; i < batch; i++) {
+        fragmentIds[i] = INSERT_FRAGMENT_ID;
+        outputDepIds[i] = i;
+        inputDepIds[i] = -1;
+        writeParameters(out, ids[i], names[i]);
+    }
+
+    engine->setUndoToken(1);
+    engine->resetReusedResultOutputBuffer();
+    voltdb::ReferenceSerializeInput in(parameter_buffer, out.position());
+    EXPECT_EQ(0, engine->executeQueries(batch, fragmentIds, outputDepIds, inputDepIds,
+                                        in, 1, 0));
+    EXPECT_EQ(0, in.numBytesNotYetRead());
+
+    EXPECT_EQ(3, countWarehouse(first, "alpha"));
+    EXPECT_EQ(2, countWarehouse(second, "beta"));
+    EXPECT_EQ(0, countWarehouse(first, "beta"));
+    EXPECT_EQ(0, countWarehouse(second, "alpha"));
+}
+
+// ------------------------------------------------------------------
+// ExecuteQueries_FailureMidBatch
+// ------------------------------------------------------------------
+TEST_F(ExecutionEngineTest, ExecuteQueries_FailureMidBatch) {
+    //
+    // The second fragment receives a row that belongs to another partition,
+    // so its insert fails after the receive executor loaded it. The batch
+    // goes on, the failure is counted, and the received rows are cleared.
+    //
+    int32_t received = partitionedId(2000, true);
+    int32_t remote = partitionedId(received + 1, false);
+    int32_t inserted = partitionedId(remote + 1, true);
+    int receivedBefore = countWarehouse(received, NULL);
+    int remoteBefore = countWarehouse(remote, NULL);
+    topend->ids.push_back(received);
+    topend->ids.push_back(remote);
+
+    voltdb::ReferenceSerializeOutput out(parameter_buffer, BUFFER_SIZE);
+    out.writeShort(0);
+    out.writeShort(0);
+    writeParameters(out, inserted, "gamma");
+    int64_t fragmentIds[] = { RECEIVE_FRAGMENT_ID, RECEIVE_FRAGMENT_ID, INSERT_FRAGMENT_ID };
+    int32_t outputDepIds[] = { 1, 2, 3 };
+    int32_t inputDepIds[] = { 10, 20, -1 };
+
+    engine->setUndoToken(1);
+    engine->resetReusedResultOutputBuffer();
+    voltdb::ReferenceSerializeInput in(parameter_buffer, out.position());
+    EXPECT_EQ(1, engine->executeQueries(3, fragmentIds, outputDepIds, inputDepIds,
+                                        in, 1, 0));
+    EXPECT_EQ(0, in.numBytesNotYetRead());
+
+    ASSERT_TRUE(topend->destination != NULL);
+    EXPECT_EQ(0, topend->destination->activeTupleCount());
+    EXPECT_TRUE(topend->ids.empty());
+    EXPECT_EQ(receivedBefore + 1, countWarehouse(received, NULL));
+    EXPECT_EQ(remoteBefore, countWarehouse(remote, NULL));
+    EXPECT_EQ(1, countWarehouse(inserted, "gamma"));
+}
+
 /*
 // ------------------------------------------------------------------
 // Execute_PlanFragmentInfo
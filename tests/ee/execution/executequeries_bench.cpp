@@ -0,0 +1,267 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Runs a NewOrder-style batch of single-row inserts the way the JNI layer
+ * did before VoltDBEngine::executeQueries(), decoding the parameters and
+ * calling executeQuery() once per fragment, and then as one batch through
+ * executeQueries(). Prints the statements/s of each, once with a distinct
+ * parameter set per statement (ORDER_LINE rows) and once with every
+ * statement repeating the same set. Usage:
+ *
+ *   executequeries_bench [batch size] [batches]
+ */
+
+#include "harness.h"
+#include "common/common.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/Pool.hpp"
+#include "common/serializeio.h"
+#include "common/Topend.h"
+#include "execution/VoltDBEngine.h"
+#include "catalog/catalog.h"
+#include "logging/StdoutLogProxy.h"
+#include <boost/shared_array.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/time.h>
+
+using namespace voltdb;
+
+extern void deserializeParameterSetCommon(int, ReferenceSerializeInput&, GenericValueArray<NValue>&, Pool *stringPool);
+
+static int batchSize = 15;
+static int numBatches = 20000;
+
+#define BUFFER_SIZE 1024 * 1024
+
+#define ORDER_LINE_PARAM_COLUMNS \
+    "[{\"GUID\": 1, \"NAME\": \"OL_W_ID\", \"TYPE\": \"INTEGER\", \"SIZE\": 4," \
+    " \"INPUT_TABLE_NAME\": \"\", \"INPUT_COLUMN_NAME\": \"\"," \
+    " \"EXPRESSION\": {\"TYPE\": \"VALUE_PARAMETER\", \"VALUE_TYPE\": \"INTEGER\", \"VALUE_SIZE\": 4, \"PARAM_IDX\": 0}}," \
+    " {\"GUID\": 2, \"NAME\": \"OL_I_ID\", \"TYPE\": \"INTEGER\", \"SIZE\": 4," \
+    " \"INPUT_TABLE_NAME\": \"\", \"INPUT_COLUMN_NAME\": \"\"," \
+    " \"EXPRESSION\": {\"TYPE\": \"VALUE_PARAMETER\", \"VALUE_TYPE\": \"INTEGER\", \"VALUE_SIZE\": 4, \"PARAM_IDX\": 1}}," \
+    " {\"GUID\": 3, \"NAME\": \"OL_DIST_INFO\", \"TYPE\": \"STRING\", \"SIZE\": 24," \
+    " \"INPUT_TABLE_NAME\": \"\", \"INPUT_COLUMN_NAME\": \"\"," \
+    " \"EXPRESSION\": {\"TYPE\": \"VALUE_PARAMETER\", \"VALUE_TYPE\": \"STRING\", \"VALUE_SIZE\": 24, \"PARAM_IDX\": 2}}]"
+
+// INSERT INTO ORDER_LINE VALUES (?, ?, ?)
+#define INSERT_FRAGMENT_ID 1
+const char *INSERT_FRAGMENT =
+    "{\"PLAN_NODES\": ["
+    " {\"ID\": 3, \"PLAN_NODE_TYPE\": \"SEND\", \"INLINE_NODES\": [], \"CHILDREN_IDS\": [1], \"PARENT_IDS\": [],"
+    " \"OUTPUT_COLUMNS\": " ORDER_LINE_PARAM_COLUMNS ", \"DEPENDENCY_ID\": 1073741825, \"FAKE\": false},"
+    " {\"ID\": 1, \"PLAN_NODE_TYPE\": \"INSERT\", \"INLINE_NODES\": [], \"CHILDREN_IDS\": [2], \"PARENT_IDS\": [3],"
+    " \"OUTPUT_COLUMNS\": " ORDER_LINE_PARAM_COLUMNS ", \"TARGET_TABLE_NAME\": \"ORDER_LINE\", \"MULTI_PARTITION\": false},"
+    " {\"ID\": 2, \"PLAN_NODE_TYPE\": \"MATERIALIZE\", \"INLINE_NODES\": [], \"CHILDREN_IDS\": [], \"PARENT_IDS\": [1],"
+    " \"OUTPUT_COLUMNS\": " ORDER_LINE_PARAM_COLUMNS ", \"BATCHED\": false}],"
+    " \"PARAMETERS\": [], \"EXECUTE_LIST\": [2, 1, 3]}";
+
+static int64_t nowMicros() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+static std::string hexEncode(const char *json) {
+    boost::shared_array<char> buffer(new char[strlen(json) * 2 + 1]);
+    catalog::Catalog::hexEncodeString(json, buffer.get());
+    return std::string(buffer.get());
+}
+
+class BenchTopend : public Topend {
+public:
+    int loadNextDependency(int32_t dependencyId, Pool *pool, Table* destination) {
+        return 0;
+    }
+
+    void crashVoltDB(FatalException e) {
+    }
+};
+
+class ExecuteQueriesBench : public Test {
+public:
+    ExecuteQueriesBench() : m_engine(NULL), m_undoToken(0) {
+        std::string column = "/clusters[cluster]/databases[database]/tables[ORDER_LINE]/columns";
+        std::string catalogString = "add / clusters cluster"
+            "\nadd /clusters[cluster] databases database"
+            "\nadd /clusters[cluster]/databases[database] programs program"
+            "\nadd /clusters[cluster]/databases[database] tables ORDER_LINE"
+            "\nset /clusters[cluster]/databases[database]/tables[ORDER_LINE] type 0"
+            "\nset /clusters[cluster]/databases[database]/tables[ORDER_LINE] isreplicated false"
+            "\nset /clusters[cluster]/databases[database]/tables[ORDER_LINE] partitioncolumn " + column + "[OL_W_ID]"
+            "\nset /clusters[cluster]/databases[database]/tables[ORDER_LINE] estimatedtuplecount 0"
+            "\nadd /clusters[cluster]/databases[database]/tables[ORDER_LINE] columns OL_W_ID"
+            "\nset " + column + "[OL_W_ID] index 0"
+            "\nset " + column + "[OL_W_ID] type 5"
+            "\nset " + column + "[OL_W_ID] size 0"
+            "\nset " + column + "[OL_W_ID] nullable false"
+            "\nset " + column + "[OL_W_ID] name \"OL_W_ID\""
+            "\nadd /clusters[cluster]/databases[database]/tables[ORDER_LINE] columns OL_I_ID"
+            "\nset " + column + "[OL_I_ID] index 1"
+            "\nset " + column + "[OL_I_ID] type 5"
+            "\nset " + column + "[OL_I_ID] size 0"
+            "\nset " + column + "[OL_I_ID] nullable false"
+            "\nset " + column + "[OL_I_ID] name \"OL_I_ID\""
+            "\nadd /clusters[cluster]/databases[database]/tables[ORDER_LINE] columns OL_DIST_INFO"
+            "\nset " + column + "[OL_DIST_INFO] index 2"
+            "\nset " + column + "[OL_DIST_INFO] type 9"
+            "\nset " + column + "[OL_DIST_INFO] size 24"
+            "\nset " + column + "[OL_DIST_INFO] nullable true"
+            "\nset " + column + "[OL_DIST_INFO] name \"OL_DIST_INFO\""
+            "\nadd /clusters[cluster] hosts 0"
+            "\nadd /clusters[cluster] sites 0"
+            "\nset /clusters[cluster]/sites[0] host /clusters[cluster]/hosts[0]"
+            "\nadd /clusters[cluster]/sites[0] partitions 0"
+            "\nset /clusters[cluster] num_partitions 1"
+            "\nadd /clusters[cluster]/databases[database] procedures NewOrder"
+            "\nadd /clusters[cluster]/databases[database]/procedures[NewOrder] statements insertOrderLine"
+            "\nadd /clusters[cluster]/databases[database]/procedures[NewOrder]/statements[insertOrderLine] fragments 1"
+            "\nset /clusters[cluster]/databases[database]/procedures[NewOrder]/statements[insertOrderLine]/fragments[1] plannodetree \"" + hexEncode(INSERT_FRAGMENT) + "\"";
+
+        m_parameterBuffer.resize(BUFFER_SIZE);
+        m_resultBuffer.resize(BUFFER_SIZE);
+        m_exceptionBuffer.resize(BUFFER_SIZE);
+        m_engine = new VoltDBEngine(new BenchTopend(), new StdoutLogProxy());
+        m_engine->initialize(0, 0, 0, 0, "");
+        m_engine->loadCatalog(catalogString);
+        m_engine->setBuffers(&m_parameterBuffer[0], BUFFER_SIZE, &m_resultBuffer[0], BUFFER_SIZE,
+                             &m_exceptionBuffer[0], BUFFER_SIZE);
+    }
+
+    ~ExecuteQueriesBench() {
+        delete m_engine;
+    }
+
+    /** The parameter sets of one NewOrder call, as org.voltdb.ParameterSet writes them */
+    size_t writeParameters(bool repeated) {
+        ReferenceSerializeOutput out(&m_parameterBuffer[0], BUFFER_SIZE);
+        for (int i = 0; i < batchSize; i++) {
+            int32_t itemId = repeated ? 1 : rand() % 100000;
+            char distInfo[25];
+            snprintf(distInfo, sizeof(distInfo), "DIST-%019d", itemId);
+            out.writeShort(3);
+            out.writeByte(VALUE_TYPE_INTEGER);
+            out.writeInt(1);
+            out.writeByte(VALUE_TYPE_INTEGER);
+            out.writeInt(itemId);
+            out.writeByte(VALUE_TYPE_VARCHAR);
+            out.writeBinaryString(distInfo, strlen(distInfo));
+        }
+        return out.position();
+    }
+
+    /** What nativeExecuteQueryPlanFragment did for every fragment of the batch */
+    int runPerFragment(size_t length) {
+        ReferenceSerializeInput in(&m_parameterBuffer[0], length);
+        NValueArray &params = m_engine->getParameterContainer();
+        int failures = 0;
+        for (int i = 0; i < batchSize; i++) {
+            m_engine->resetReusedResultOutputBuffer();
+            int cnt = in.readShort();
+            deserializeParameterSetCommon(cnt, in, params, m_engine->getStringPool());
+            m_engine->setUsedParamcnt(cnt);
+            failures += m_engine->executeQuery(INSERT_FRAGMENT_ID, i, -1, params,
+                                               m_undoToken, m_undoToken - 1, true, true);
+            m_engine->getStringPool()->purge();
+        }
+        return failures;
+    }
+
+    /** What nativeExecuteQueryPlanFragmentsAndGetResults does for the batch */
+    int runBatch(size_t length) {
+        m_engine->resetReusedResultOutputBuffer();
+        ReferenceSerializeInput in(&m_parameterBuffer[0], length);
+        int failures = m_engine->executeQueries(batchSize, &m_fragmentIds[0], &m_outputDepIds[0],
+                                                &m_inputDepIds[0], in, m_undoToken, m_undoToken - 1);
+        m_engine->getStringPool()->purge();
+        return failures;
+    }
+
+    void measure(const char *label, bool repeated) {
+        m_fragmentIds.assign(batchSize, INSERT_FRAGMENT_ID);
+        m_outputDepIds.resize(batchSize);
+        m_inputDepIds.assign(batchSize, -1);
+        for (int i = 0; i < batchSize; i++) {
+            m_outputDepIds[i] = i;
+        }
+
+        // the inserts are rolled back outside the timed part so that the
+        // table stays the same size for both ways of running the batch
+        int64_t perFragmentMicros = 0;
+        int64_t batchMicros = 0;
+        srand(1);
+        for (int i = 0; i < numBatches; i++) {
+            size_t length = writeParameters(repeated);
+
+            m_engine->setUndoToken(++m_undoToken);
+            int64_t start = nowMicros();
+            ASSERT_EQ(0, runPerFragment(length));
+            perFragmentMicros += nowMicros() - start;
+            m_engine->undoUndoToken(m_undoToken);
+
+            m_engine->setUndoToken(++m_undoToken);
+            start = nowMicros();
+            ASSERT_EQ(0, runBatch(length));
+            batchMicros += nowMicros() - start;
+            m_engine->undoUndoToken(m_undoToken);
+        }
+        perFragmentMicros = std::max(perFragmentMicros, static_cast<int64_t>(1));
+        batchMicros = std::max(batchMicros, static_cast<int64_t>(1));
+        double statements = static_cast<double>(batchSize) * numBatches;
+        printf("%-24s per fragment %10.0f stmts/s  executeQueries %10.0f stmts/s  %.2fx\n", label,
+               statements * 1000000.0 / static_cast<double>(perFragmentMicros),
+               statements * 1000000.0 / static_cast<double>(batchMicros),
+               static_cast<double>(perFragmentMicros) / static_cast<double>(batchMicros));
+    }
+
+    VoltDBEngine *m_engine;
+    int64_t m_undoToken;
+    std::vector<char> m_parameterBuffer;
+    std::vector<char> m_resultBuffer;
+    std::vector<char> m_exceptionBuffer;
+    std::vector<int64_t> m_fragmentIds;
+    std::vector<int32_t> m_outputDepIds;
+    std::vector<int32_t> m_inputDepIds;
+};
+
+TEST_F(ExecuteQueriesBench, NewOrderInserts) {
+    printf("\n%d inserts per batch, %d batches\n", batchSize, numBatches);
+    measure("distinct parameters", false);
+    measure("repeated parameters", true);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) batchSize = atoi(argv[1]);
+    if (argc > 2) numBatches = atoi(argv[2]);
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,277 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/SQLException.h"
+#include "execution/VoltDBEngine.h"
+#include "executors/hashjoinexecutor.h"
+#include "executors/nestloopexecutor.h"
+#include "expressions/expressions.h"
+#include "expressions/expressionutil.h"
+#include "plannodes/hashjoinnode.h"
+#include "plannodes/nestloopnode.h"
+#include "plannodes/receivenode.h"
+#include "storage/table.h"
+#include "storage/temptable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace voltdb;
+
+/** Hands a table to the join as a child's output */
+class InputPlanNode : public ReceivePlanNode {
+public:
+    InputPlanNode(Table *table) {
+        setOutputTable(table);
+        for (int ii = 0; ii < table->columnCount(); ii++) {
+            AbstractPlanNode::m_outputColumnGuids.push_back(ii);
+        }
+    }
+};
+
+class HashJoinExecutorTest : public Test {
+public:
+    HashJoinExecutorTest() : m_tempTableMemory(0), m_innerNameLength(16) {
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(1, 1, 0, 0, "");
+    }
+
+    ~HashJoinExecutorTest() {
+        delete m_engine;
+    }
+
+    /** OUTER(ID INTEGER, NAME VARCHAR(16), VAL BIGINT) */
+    Table* createOuter(int rows) {
+        ValueType types[] = { VALUE_TYPE_INTEGER, VALUE_TYPE_VARCHAR, VALUE_TYPE_BIGINT };
+        std::string names[] = { "ID", "NAME", "VAL" };
+        Table *table = createTable("OUTER", types, names, 16);
+        TableTuple &tuple = table->tempTuple();
+        for (int ii = 0; ii < rows; ii++) {
+            tuple.setNValue(0, (ii % 17 == 0) ? NValue::getNullValue(VALUE_TYPE_INTEGER) :
+                            ValueFactory::getIntegerValue(ii % 50));
+            NValue name = ValueFactory::getStringValue((ii % 3 == 0) ? "even" : "odd");
+            tuple.setNValue(1, name);
+            name.free();
+            tuple.setNValue(2, ValueFactory::getBigIntValue(ii));
+            table->insertTuple(tuple);
+        }
+        return table;
+    }
+
+    /** INNER(OID BIGINT, NAME VARCHAR(m_innerNameLength), VAL INTEGER) */
+    Table* createInner(int rows) {
+        ValueType types[] = { VALUE_TYPE_BIGINT, VALUE_TYPE_VARCHAR, VALUE_TYPE_INTEGER };
+        std::string names[] = { "OID", "NAME", "VAL" };
+        Table *table = createTable("INNER", types, names, m_innerNameLength);
+        TableTuple &tuple = table->tempTuple();
+        for (int ii = 0; ii < rows; ii++) {
+            tuple.setNValue(0, (ii % 13 == 0) ? NValue::getNullValue(VALUE_TYPE_BIGINT) :
+                            ValueFactory::getBigIntValue(ii % 40));
+            NValue name = ValueFactory::getStringValue((ii % 2 == 0) ? "even" : "odd");
+            // a long NAME is stored out of line, and has to outlive the local value
+            tuple.setNValueAllocateForObjectCopies(1, name, &m_stringPool);
+            name.free();
+            tuple.setNValue(2, ValueFactory::getIntegerValue(ii * 3));
+            table->insertTuple(tuple);
+        }
+        return table;
+    }
+
+    Table* createTable(const char *name, ValueType *types, std::string *columnNames, int nameLength) {
+        std::vector<ValueType> columnTypes(types, types + 3);
+        std::vector<int32_t> sizes;
+        for (int ii = 0; ii < 3; ii++) {
+            sizes.push_back(types[ii] == VALUE_TYPE_VARCHAR ? nameLength : NValue::getTupleStorageSize(types[ii]));
+        }
+        std::vector<bool> allowNull(3, true);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, sizes, allowNull, true);
+        return TableFactory::getTempTable(0, name, schema, columnNames, NULL);
+    }
+
+    static AbstractExpression* outerColumn(int idx) {
+        return new TupleValueExpression(idx, "OUTER", "C");
+    }
+
+    static AbstractExpression* innerColumn(int idx) {
+        return new TupleValueExpression(idx, "INNER", "C");
+    }
+
+    /** Join the tables with a plan node of the given type, the rows in a canonical order */
+    std::vector<std::string> join(AbstractJoinPlanNode *node, AbstractPlanNode *outer, AbstractPlanNode *inner,
+                                  AbstractExpression *predicate, int *keyColumns = NULL) {
+        node->addChild(outer);
+        node->addChild(inner);
+        node->setPredicate(predicate);
+        AbstractExecutor *executor;
+        HashJoinExecutor *hashJoin = NULL;
+        if (node->getPlanNodeType() == PLAN_NODE_TYPE_HASHJOIN) {
+            executor = hashJoin = new HashJoinExecutor(m_engine, node);
+        } else {
+            executor = new NestLoopExecutor(m_engine, node);
+        }
+        node->setExecutor(executor);
+        EXPECT_TRUE(executor->init(m_engine, NULL, &m_tempTableMemory));
+        if (keyColumns != NULL && hashJoin != NULL) {
+            *keyColumns = hashJoin->keyColumnCount();
+        }
+        NValueArray params;
+        EXPECT_TRUE(executor->execute(params, NULL));
+
+        std::vector<std::string> rows;
+        TableTuple tuple(node->getOutputTable()->schema());
+        TableIterator iterator(node->getOutputTable());
+        while (iterator.next(tuple)) {
+            // drop the [@address] of the inlined strings
+            std::string row = tuple.debugNoHeader();
+            for (size_t at = row.find("[@"); at != std::string::npos; at = row.find("[@", at)) {
+                row.erase(at, row.find(']', at) - at + 1);
+            }
+            rows.push_back(row);
+        }
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    }
+
+    /** Check the hash join gives the nest loop's rows for both build sides */
+    void check(AbstractExpression *(*predicate)(), int expectedKeyColumns) {
+        int sizes[][2] = { { 300, 100 }, { 100, 300 } };
+        for (int ii = 0; ii < 2; ii++) {
+            InputPlanNode outer(createOuter(sizes[ii][0]));
+            InputPlanNode inner(createInner(sizes[ii][1]));
+
+            NestLoopPlanNode nestLoop;
+            std::vector<std::string> expected = join(&nestLoop, &outer, &inner, predicate());
+            HashJoinPlanNode hashJoin;
+            int keyColumns = -1;
+            std::vector<std::string> actual = join(&hashJoin, &outer, &inner, predicate(), &keyColumns);
+
+            EXPECT_EQ(expectedKeyColumns, keyColumns);
+            ASSERT_TRUE(expected.size() > 0);
+            ASSERT_EQ(expected.size(), actual.size());
+            ASSERT_TRUE(expected == actual);
+        }
+    }
+
+    VoltDBEngine *m_engine;
+    int m_tempTableMemory;
+    int m_innerNameLength;
+    Pool m_stringPool;
+};
+
+/** OUTER.ID = INNER.OID, an INTEGER and a BIGINT */
+static AbstractExpression* intKey() {
+    return comparisonFactory(EXPRESSION_TYPE_COMPARE_EQUAL,
+                             HashJoinExecutorTest::outerColumn(0), HashJoinExecutorTest::innerColumn(0));
+}
+
+/** INNER.NAME = OUTER.NAME AND OUTER.ID = INNER.OID */
+static AbstractExpression* mixedKey() {
+    return conjunctionFactory(EXPRESSION_TYPE_CONJUNCTION_AND,
+        comparisonFactory(EXPRESSION_TYPE_COMPARE_EQUAL,
+                          HashJoinExecutorTest::innerColumn(1), HashJoinExecutorTest::outerColumn(1)),
+        intKey());
+}
+
+/** OUTER.NAME = INNER.NAME */
+static AbstractExpression* nameKey() {
+    return comparisonFactory(EXPRESSION_TYPE_COMPARE_EQUAL,
+                             HashJoinExecutorTest::outerColumn(1), HashJoinExecutorTest::innerColumn(1));
+}
+
+/** OUTER.ID = INNER.OID AND OUTER.VAL < INNER.VAL */
+static AbstractExpression* keyAndResidual() {
+    return conjunctionFactory(EXPRESSION_TYPE_CONJUNCTION_AND, intKey(),
+        comparisonFactory(EXPRESSION_TYPE_COMPARE_LESSTHAN,
+                          HashJoinExecutorTest::outerColumn(2), HashJoinExecutorTest::innerColumn(2)));
+}
+
+/** OUTER.VAL > INNER.VAL OR OUTER.ID = INNER.OID has no join key */
+static AbstractExpression* noKey() {
+    return conjunctionFactory(EXPRESSION_TYPE_CONJUNCTION_OR,
+        comparisonFactory(EXPRESSION_TYPE_COMPARE_GREATERTHAN,
+                          HashJoinExecutorTest::outerColumn(2), HashJoinExecutorTest::innerColumn(2)),
+        intKey());
+}
+
+TEST_F(HashJoinExecutorTest, IntegerKey) {
+    check(intKey, 1);
+}
+
+TEST_F(HashJoinExecutorTest, MixedKey) {
+    check(mixedKey, 2);
+}
+
+TEST_F(HashJoinExecutorTest, KeyAndResidualPredicate) {
+    check(keyAndResidual, 1);
+}
+
+TEST_F(HashJoinExecutorTest, InlinedAndOutOfLineStringKey) {
+    // VARCHAR(16) is inlined, VARCHAR(100) is not, so the key is out of line
+    m_innerNameLength = 100;
+    check(nameKey, 1);
+    check(mixedKey, 2);
+}
+
+TEST_F(HashJoinExecutorTest, NoKeyFallsBackToNestLoop) {
+    check(noKey, 0);
+}
+
+TEST_F(HashJoinExecutorTest, BuildSideCountsAsTempTableMemory) {
+    InputPlanNode outer(createOuter(1000));
+    InputPlanNode inner(createInner(1000));
+    HashJoinPlanNode node;
+    node.addChild(&outer);
+    node.addChild(&inner);
+    node.setPredicate(intKey());
+    HashJoinExecutor *executor = new HashJoinExecutor(m_engine, &node);
+    node.setExecutor(executor);
+    ASSERT_TRUE(executor->init(m_engine, NULL, &m_tempTableMemory));
+
+    // the build side alone goes over the limit
+    const int used = MAX_TEMP_TABLE_MEMORY - 1000;
+    m_tempTableMemory = used;
+    NValueArray params;
+    bool overflow = false;
+    try {
+        executor->execute(params, NULL);
+    } catch (SQLException &e) {
+        overflow = true;
+    }
+    EXPECT_TRUE(overflow);
+    EXPECT_EQ(used, m_tempTableMemory);
+    EXPECT_EQ(0, node.getOutputTable()->activeTupleCount());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,275 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "execution/VoltDBEngine.h"
+#include "executors/orderbyexecutor.h"
+#include "plannodes/limitnode.h"
+#include "plannodes/orderbynode.h"
+#include "plannodes/receivenode.h"
+#include "storage/table.h"
+#include "storage/temptable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace voltdb;
+
+/** Hands a table to the order by as its child's output */
+class InputPlanNode : public ReceivePlanNode {
+public:
+    InputPlanNode(Table *table) {
+        setOutputTable(table);
+        for (int ii = 0; ii < table->columnCount(); ii++) {
+            m_outputColumnGuids.push_back(ii);
+        }
+    }
+
+    ~InputPlanNode() {
+        // the fixture owns the table
+        setOutputTable(NULL);
+    }
+};
+
+/** The order TupleComparer defines, on the test's side */
+class ReferenceComparer {
+public:
+    ReferenceComparer(const std::vector<int> &columns, const std::vector<SortDirectionType> &dirs)
+        : m_columns(columns), m_dirs(dirs) {
+    }
+
+    int compare(const TableTuple &a, const TableTuple &b) const {
+        for (int ii = 0; ii < m_columns.size(); ii++) {
+            int cmp = a.getNValue(m_columns[ii]).compare(b.getNValue(m_columns[ii]));
+            if (cmp != 0) {
+                return (m_dirs[ii] == SORT_DIRECTION_TYPE_ASC) ? cmp : -cmp;
+            }
+        }
+        return 0;
+    }
+
+    bool operator()(const TableTuple &a, const TableTuple &b) const {
+        return compare(a, b) < 0;
+    }
+
+private:
+    std::vector<int> m_columns;
+    std::vector<SortDirectionType> m_dirs;
+};
+
+class OrderByExecutorTest : public Test {
+public:
+    static const int ROWS = 2000;
+
+    OrderByExecutorTest() : m_tempTableMemory(0) {
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(1, 1, 0, 0, "");
+        srand(42);
+
+        // I INTEGER, S VARCHAR(40), D DOUBLE, B BIGINT, T TINYINT, M DECIMAL, N VARCHAR(8)
+        ValueType types[] = { VALUE_TYPE_INTEGER, VALUE_TYPE_VARCHAR, VALUE_TYPE_DOUBLE,
+                              VALUE_TYPE_BIGINT, VALUE_TYPE_TINYINT, VALUE_TYPE_DECIMAL,
+                              VALUE_TYPE_VARCHAR };
+        std::string names[] = { "I", "S", "D", "B", "T", "M", "N" };
+        std::vector<ValueType> columnTypes(types, types + COLUMNS);
+        std::vector<int32_t> sizes;
+        for (int ii = 0; ii < COLUMNS; ii++) {
+            sizes.push_back(types[ii] != VALUE_TYPE_VARCHAR ? NValue::getTupleStorageSize(types[ii]) :
+                            (ii == 1 ? 40 : 8));
+        }
+        std::vector<bool> allowNull(COLUMNS, true);
+        TupleSchema *schema = TupleSchema::createTupleSchema(columnTypes, sizes, allowNull, true);
+        m_input = TableFactory::getTempTable(0, "INPUT", schema, names, NULL);
+
+        TableTuple &tuple = m_input->tempTuple();
+        char buffer[64];
+        for (int ii = 0; ii < ROWS; ii++) {
+            bool null = (rand() % 20 == 0);
+            tuple.setNValue(0, null ? NValue::getNullValue(VALUE_TYPE_INTEGER) :
+                            ValueFactory::getIntegerValue(rand() % 200 - 100));
+            // long shared prefixes, the keys only hold 16 bytes of them
+            snprintf(buffer, sizeof(buffer), "customer-name-%d-%d", rand() % 5, rand() % 50);
+            NValue string = ValueFactory::getStringValue(buffer);
+            tuple.setNValue(1, (rand() % 25 == 0) ? NValue::getNullValue(VALUE_TYPE_VARCHAR) : string);
+            string.free();
+            double d = (rand() % 100 - 50) / 4.0;
+            tuple.setNValue(2, ValueFactory::getDoubleValue((rand() % 10 == 0) ? -0.0 : d));
+            tuple.setNValue(3, ValueFactory::getBigIntValue((static_cast<int64_t>(rand()) << 20) *
+                                                            ((rand() % 2) ? 1 : -1)));
+            tuple.setNValue(4, null ? NValue::getNullValue(VALUE_TYPE_TINYINT) :
+                            ValueFactory::getTinyIntValue(static_cast<int8_t>(rand() % 256 - 128)));
+            snprintf(buffer, sizeof(buffer), "%d.%04d", rand() % 2000 - 1000, rand() % 10000);
+            tuple.setNValue(5, ValueFactory::getDecimalValueFromString(buffer));
+            snprintf(buffer, sizeof(buffer), "%c%c", 'a' + rand() % 3, 'a' + rand() % 3);
+            NValue shortString = ValueFactory::getStringValue(rand() % 7 == 0 ? "" : buffer);
+            tuple.setNValue(6, shortString);
+            shortString.free();
+            m_input->insertTuple(tuple);
+        }
+    }
+
+    ~OrderByExecutorTest() {
+        delete m_input;
+        delete m_engine;
+    }
+
+    /**
+     * Sort the input by the given columns and check the output against
+     * the reference order. Equal keys may come out in any order, so the
+     * rows are checked to be in order and to end with the right key.
+     */
+    void check(const std::vector<int> &columns, const std::vector<SortDirectionType> &dirs, int limit = -1) {
+        InputPlanNode input(m_input);
+        OrderByPlanNode node;
+        node.addChild(&input);
+        std::vector<SortDirectionType> directions(dirs);
+        node.setSortDirections(directions);
+        std::vector<std::string> names;
+        for (int ii = 0; ii < columns.size(); ii++) {
+            node.getSortColumnGuids().push_back(columns[ii]);
+            names.push_back(m_input->columnName(columns[ii]));
+        }
+        node.setSortColumnNames(names);
+        if (limit >= 0) {
+            LimitPlanNode *limitNode = new LimitPlanNode();
+            limitNode->setLimit(limit);
+            node.addInlinePlanNode(limitNode);
+        }
+        OrderByExecutor *executor = new OrderByExecutor(m_engine, &node);
+        node.setExecutor(executor);
+        ASSERT_TRUE(executor->init(m_engine, NULL, &m_tempTableMemory));
+        EXPECT_TRUE(executor->keyWidth() > 0);
+        NValueArray params;
+        ASSERT_TRUE(executor->execute(params, NULL));
+
+        ReferenceComparer comparer(columns, dirs);
+        std::vector<TableTuple> expected;
+        TableTuple tuple(m_input->schema());
+        TableIterator inputIterator(m_input);
+        while (inputIterator.next(tuple)) {
+            expected.push_back(tuple);
+        }
+        std::stable_sort(expected.begin(), expected.end(), comparer);
+        int expectedCount = (limit >= 0 && limit < ROWS) ? limit : ROWS;
+
+        Table *output = node.getOutputTable();
+        ASSERT_EQ(expectedCount, static_cast<int>(output->activeTupleCount()));
+        TableTuple previous(output->schema());
+        TableTuple current(output->schema());
+        TableIterator outputIterator(output);
+        int count = 0;
+        while (outputIterator.next(current)) {
+            if (count > 0) {
+                ASSERT_TRUE(comparer.compare(previous, current) <= 0);
+            }
+            previous = current;
+            count++;
+        }
+        if (count > 0) {
+            EXPECT_EQ(0, comparer.compare(previous, expected[count - 1]));
+        }
+        // a single key has to put each value at the same position
+        if (columns.size() == 1) {
+            int position = 0;
+            TableIterator again(output);
+            while (again.next(current)) {
+                ASSERT_EQ(0, comparer.compare(current, expected[position++]));
+            }
+        }
+    }
+
+    void checkColumn(int column) {
+        std::vector<int> columns(1, column);
+        check(columns, std::vector<SortDirectionType>(1, SORT_DIRECTION_TYPE_ASC));
+        check(columns, std::vector<SortDirectionType>(1, SORT_DIRECTION_TYPE_DESC));
+    }
+
+    static const int COLUMNS = 7;
+
+    VoltDBEngine *m_engine;
+    Table *m_input;
+    int m_tempTableMemory;
+};
+
+TEST_F(OrderByExecutorTest, IntegerWithNulls) {
+    checkColumn(0);
+}
+
+TEST_F(OrderByExecutorTest, StringsLongerThanTheKeyPrefix) {
+    checkColumn(1);
+}
+
+TEST_F(OrderByExecutorTest, DoublesWithNegativeZero) {
+    checkColumn(2);
+}
+
+TEST_F(OrderByExecutorTest, BigInt) {
+    checkColumn(3);
+}
+
+TEST_F(OrderByExecutorTest, TinyIntWithNulls) {
+    checkColumn(4);
+}
+
+TEST_F(OrderByExecutorTest, Decimal) {
+    checkColumn(5);
+}
+
+TEST_F(OrderByExecutorTest, ShortAndEmptyStrings) {
+    checkColumn(6);
+}
+
+TEST_F(OrderByExecutorTest, MixedDirections) {
+    int columnArray[] = { 6, 1, 4, 2 };
+    SortDirectionType dirArray[] = { SORT_DIRECTION_TYPE_DESC, SORT_DIRECTION_TYPE_ASC,
+                                     SORT_DIRECTION_TYPE_DESC, SORT_DIRECTION_TYPE_ASC };
+    check(std::vector<int>(columnArray, columnArray + 4),
+          std::vector<SortDirectionType>(dirArray, dirArray + 4));
+}
+
+TEST_F(OrderByExecutorTest, InlineLimit) {
+    int columnArray[] = { 1, 0 };
+    SortDirectionType dirArray[] = { SORT_DIRECTION_TYPE_DESC, SORT_DIRECTION_TYPE_ASC };
+    std::vector<int> columns(columnArray, columnArray + 2);
+    std::vector<SortDirectionType> dirs(dirArray, dirArray + 2);
+    int limits[] = { 0, 1, 10, ROWS - 1, ROWS, ROWS * 2 };
+    for (int ii = 0; ii < 6; ii++) {
+        check(columns, dirs, limits[ii]);
+    }
+    check(std::vector<int>(1, 2), std::vector<SortDirectionType>(1, SORT_DIRECTION_TYPE_ASC), 25);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
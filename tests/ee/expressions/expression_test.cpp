@@ -57,9 +57,15 @@
 #include "json_spirit/json_spirit.h"
 
 #include "expressions/abstractexpression.h"
+#include "expressions/compiledpredicate.h"
 #include "expressions/expressions.h"
+#include "expressions/expressionutil.h"
 #include "common/types.h"
 #include "common/ValuePeeker.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/TupleSchema.h"
+#include "common/tabletuple.h"
+#include "common/valuevector.h"
 
 using namespace std;
 using namespace voltdb;
@@ -315,6 +321,238 @@ TEST_F(ExpressionTest, SimpleMultiplication) {
     ASSERT_EQ(ValuePeeker::peekAsBigInt(r2), 13LL);
 }
 
+/*
+ * Batch evaluation: a table of tuples covering the numeric types with
+ * nulls mixed in, checked against eval() one tuple at a time.
+ */
+class BatchExpressionTest : public Test {
+    public:
+        static const int COLUMNS = 7;
+        static const int ROWS = 300;
+
+        BatchExpressionTest() {
+            ValueType types[COLUMNS] = { VALUE_TYPE_TINYINT, VALUE_TYPE_SMALLINT,
+                                         VALUE_TYPE_INTEGER, VALUE_TYPE_BIGINT,
+                                         VALUE_TYPE_TIMESTAMP, VALUE_TYPE_DOUBLE,
+                                         VALUE_TYPE_DECIMAL };
+            std::vector<ValueType> columnTypes(types, types + COLUMNS);
+            std::vector<int32_t> sizes;
+            for (int i = 0; i < COLUMNS; i++) {
+                sizes.push_back(NValue::getTupleStorageSize(types[i]));
+            }
+            std::vector<bool> allowNull(COLUMNS, true);
+            m_schema = TupleSchema::createTupleSchema(columnTypes, sizes, allowNull, true);
+
+            const int length = m_schema->tupleLength() + TUPLE_HEADER_SIZE;
+            m_data = new char[length * ROWS]();
+            TableTuple tuple(m_schema);
+            for (int row = 0; row < ROWS; row++) {
+                m_tuples[row] = m_data + length * row;
+                tuple.move(m_tuples[row]);
+                int v = (row % 41) - 20;
+                for (int col = 0; col < COLUMNS; col++) {
+                    if ((row + col) % 13 == 0) {
+                        tuple.setNValue(col, NValue::getNullValue(types[col]));
+                        continue;
+                    }
+                    switch (types[col]) {
+                      case VALUE_TYPE_TINYINT: tuple.setNValue(col, ValueFactory::getTinyIntValue(static_cast<int8_t>(v))); break;
+                      case VALUE_TYPE_SMALLINT: tuple.setNValue(col, ValueFactory::getSmallIntValue(static_cast<int16_t>(v * 100))); break;
+                      case VALUE_TYPE_INTEGER: tuple.setNValue(col, ValueFactory::getIntegerValue(v * 10000)); break;
+                      case VALUE_TYPE_BIGINT: tuple.setNValue(col, ValueFactory::getBigIntValue(v * 10000000000LL)); break;
+                      case VALUE_TYPE_TIMESTAMP: tuple.setNValue(col, ValueFactory::getTimestampValue(v)); break;
+                      case VALUE_TYPE_DOUBLE: tuple.setNValue(col, ValueFactory::getDoubleValue(v * 0.5)); break;
+                      default: tuple.setNValue(col, ValueFactory::getDecimalValueFromString(v < 0 ? "-1.5" : "2.25")); break;
+                    }
+                }
+            }
+        }
+
+        ~BatchExpressionTest() {
+            delete[] m_data;
+            TupleSchema::freeTupleSchema(m_schema);
+        }
+
+        /** The tuples eval() says the predicate holds for, from every other one */
+        std::vector<int> expected(const AbstractExpression *predicate) {
+            std::vector<int> matches;
+            TableTuple tuple(m_schema);
+            for (int row = 0; row < ROWS; row += 2) {
+                tuple.move(m_tuples[row]);
+                if (predicate->eval(&tuple, NULL).isTrue()) {
+                    matches.push_back(row);
+                }
+            }
+            return matches;
+        }
+
+        std::vector<int> batch(const AbstractExpression *predicate) {
+            int selection[ROWS];
+            int count = 0;
+            for (int row = 0; row < ROWS; row += 2) {
+                selection[count++] = row;
+            }
+            count = predicate->evalBatch(m_schema, m_tuples, selection, count);
+            return std::vector<int>(selection, selection + count);
+        }
+
+        std::vector<int> compiled(const CompiledPredicate *predicate) {
+            std::vector<int> matches;
+            TableTuple tuple(m_schema);
+            for (int row = 0; row < ROWS; row += 2) {
+                tuple.move(m_tuples[row]);
+                if (predicate->isTrue(&tuple, NULL)) {
+                    matches.push_back(row);
+                }
+            }
+            return matches;
+        }
+
+        std::vector<int> compiledBatch(const CompiledPredicate *predicate) {
+            int selection[ROWS];
+            int count = 0;
+            for (int row = 0; row < ROWS; row += 2) {
+                selection[count++] = row;
+            }
+            count = predicate->evalBatch(m_tuples, selection, count, NULL);
+            return std::vector<int>(selection, selection + count);
+        }
+
+        TupleSchema *m_schema;
+        char *m_data;
+        char *m_tuples[ROWS];
+};
+
+static const ExpressionType comparisons[] = {
+    EXPRESSION_TYPE_COMPARE_EQUAL, EXPRESSION_TYPE_COMPARE_NOTEQUAL,
+    EXPRESSION_TYPE_COMPARE_LESSTHAN, EXPRESSION_TYPE_COMPARE_GREATERTHAN,
+    EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO, EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO
+};
+
+TEST_F(BatchExpressionTest, ColumnAndConstant) {
+    NValue constants[] = { ValueFactory::getTinyIntValue(3), ValueFactory::getIntegerValue(-70000),
+                           ValueFactory::getBigIntValue(0), ValueFactory::getDoubleValue(2.5),
+                           ValueFactory::getDoubleValue(-7.0),
+                           NValue::getNullValue(VALUE_TYPE_BIGINT),
+                           NValue::getNullValue(VALUE_TYPE_DOUBLE),
+                           ValueFactory::getDecimalValueFromString("1") };
+    for (int col = 0; col < COLUMNS; col++) {
+        for (int c = 0; c < sizeof(constants) / sizeof(constants[0]); c++) {
+            // decimals don't compare with doubles or timestamps
+            ValueType constantType = ValuePeeker::peekValueType(constants[c]);
+            ValueType columnType = m_schema->columnType(col);
+            if ((columnType == VALUE_TYPE_DECIMAL && constantType == VALUE_TYPE_DOUBLE) ||
+                (constantType == VALUE_TYPE_DECIMAL &&
+                 (columnType == VALUE_TYPE_DOUBLE || columnType == VALUE_TYPE_TIMESTAMP))) {
+                continue;
+            }
+            for (int op = 0; op < sizeof(comparisons) / sizeof(comparisons[0]); op++) {
+                for (int side = 0; side < 2; side++) {
+                    AbstractExpression *column = new TupleValueExpression(col, "T", "C");
+                    AbstractExpression *constant = constantValueFactory(constants[c]);
+                    auto_ptr<AbstractExpression> predicate(side == 0 ?
+                        comparisonFactory(comparisons[op], column, constant) :
+                        comparisonFactory(comparisons[op], constant, column));
+                    ASSERT_TRUE(expected(predicate.get()) == batch(predicate.get()));
+                    auto_ptr<CompiledPredicate> kernel(CompiledPredicate::compile(predicate.get(), m_schema, NULL));
+                    ASSERT_TRUE(expected(predicate.get()) == compiled(kernel.get()));
+                    ASSERT_TRUE(expected(predicate.get()) == compiledBatch(kernel.get()));
+                }
+            }
+        }
+    }
+}
+
+TEST_F(BatchExpressionTest, ColumnAndParameter) {
+    NValueArray params(1);
+    NValue values[] = { ValueFactory::getSmallIntValue(-5), ValueFactory::getDoubleValue(0.5) };
+    for (int v = 0; v < 2; v++) {
+        params[0] = values[v];
+        for (int op = 0; op < sizeof(comparisons) / sizeof(comparisons[0]); op++) {
+            auto_ptr<AbstractExpression> predicate(
+                comparisonFactory(comparisons[op], new TupleValueExpression(2, "T", "C"),
+                                  parameterValueFactory(0)));
+            predicate->substitute(params);
+            ASSERT_TRUE(expected(predicate.get()) == batch(predicate.get()));
+        }
+    }
+}
+
+TEST_F(BatchExpressionTest, Conjunctions) {
+    ExpressionType conjunctions[] = { EXPRESSION_TYPE_CONJUNCTION_AND, EXPRESSION_TYPE_CONJUNCTION_OR };
+    for (int i = 0; i < 2; i++) {
+        // ((TINYINT > -3) op (DOUBLE <= 4.0)) op (BIGINT + 0 = 0), the last one falls back to eval()
+        AbstractExpression *left =
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_GREATERTHAN, new TupleValueExpression(0, "T", "C"),
+                              constantValueFactory(ValueFactory::getTinyIntValue(-3)));
+        AbstractExpression *right =
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO, new TupleValueExpression(5, "T", "C"),
+                              constantValueFactory(ValueFactory::getDoubleValue(4.0)));
+        AbstractExpression *sum =
+            operatorFactory(EXPRESSION_TYPE_OPERATOR_PLUS, new TupleValueExpression(3, "T", "C"),
+                            constantValueFactory(ValueFactory::getBigIntValue(0)));
+        AbstractExpression *last =
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_EQUAL, sum,
+                              constantValueFactory(ValueFactory::getBigIntValue(0)));
+        auto_ptr<AbstractExpression> predicate(
+            conjunctionFactory(conjunctions[i],
+                               conjunctionFactory(conjunctions[i], left, right), last));
+        std::vector<int> matches = expected(predicate.get());
+        ASSERT_TRUE(matches.size() > 0);
+        ASSERT_TRUE(matches.size() < ROWS / 2);
+        ASSERT_TRUE(matches == batch(predicate.get()));
+        auto_ptr<CompiledPredicate> kernel(CompiledPredicate::compile(predicate.get(), m_schema, NULL));
+        ASSERT_EQ(1, kernel->getInterpretedNodes());
+        ASSERT_TRUE(matches == compiled(kernel.get()));
+        ASSERT_TRUE(matches == compiledBatch(kernel.get()));
+    }
+}
+
+TEST_F(BatchExpressionTest, CompiledColumns) {
+    // every pair of numeric columns, nulls on either side
+    for (int left = 0; left < COLUMNS - 1; left++) {
+        for (int right = 0; right < COLUMNS - 1; right++) {
+            for (int op = 0; op < sizeof(comparisons) / sizeof(comparisons[0]); op++) {
+                auto_ptr<AbstractExpression> predicate(
+                    comparisonFactory(comparisons[op], new TupleValueExpression(left, "T", "C"),
+                                      new TupleValueExpression(right, "T", "C")));
+                auto_ptr<CompiledPredicate> kernel(CompiledPredicate::compile(predicate.get(), m_schema, NULL));
+                ASSERT_EQ(0, kernel->getInterpretedNodes());
+                ASSERT_TRUE(expected(predicate.get()) == compiled(kernel.get()));
+                ASSERT_TRUE(expected(predicate.get()) == compiledBatch(kernel.get()));
+            }
+        }
+    }
+}
+
+TEST_F(BatchExpressionTest, CompiledRebind) {
+    // NOT (INTEGER < ?), bound again after each substitute()
+    NValueArray params(1);
+    params[0] = ValueFactory::getIntegerValue(0);
+    auto_ptr<AbstractExpression> predicate(
+        operatorFactory(EXPRESSION_TYPE_OPERATOR_NOT,
+                        comparisonFactory(EXPRESSION_TYPE_COMPARE_LESSTHAN,
+                                          new TupleValueExpression(2, "T", "C"),
+                                          parameterValueFactory(0)),
+                        NULL));
+    predicate->substitute(params);
+    auto_ptr<CompiledPredicate> kernel(CompiledPredicate::compile(predicate.get(), m_schema, NULL));
+    ASSERT_EQ(0, kernel->getInterpretedNodes());
+
+    NValue values[] = { ValueFactory::getBigIntValue(-50000), ValueFactory::getDoubleValue(0.5),
+                        NValue::getNullValue(VALUE_TYPE_INTEGER),
+                        ValueFactory::getDecimalValueFromString("1") };
+    for (int v = 0; v < sizeof(values) / sizeof(values[0]); v++) {
+        params[0] = values[v];
+        predicate->substitute(params);
+        kernel->bind();
+        // a null or decimal parameter leaves the comparison to eval()
+        ASSERT_EQ(v < 2 ? 0 : 1, kernel->getInterpretedNodes());
+        ASSERT_TRUE(expected(predicate.get()) == compiled(kernel.get()));
+        ASSERT_TRUE(expected(predicate.get()) == compiledBatch(kernel.get()));
+    }
+}
+
 int main() {
      return TestSuite::globalInstance()->runAll();
 }
@@ -0,0 +1,235 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Scans a table with a few predicates the way SeqScanExecutor does, once
+ * calling eval() per tuple, once with evalBatch() and once with the
+ * predicate compiled into a CompiledPredicate as IndexScanExecutor does,
+ * and prints the rows per second of each. The scans run on a single thread, so the numbers are
+ * per core. Usage:
+ *
+ *   scan_predicate_bench [rows] [scans]
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/tabletuple.h"
+#include "execution/VoltDBEngine.h"
+#include "expressions/compiledpredicate.h"
+#include "expressions/expressions.h"
+#include "expressions/expressionutil.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/time.h>
+
+using namespace voltdb;
+
+static int numRows = 1000000;
+static int numScans = 10;
+
+static int64_t nowMicros() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+class ScanPredicateBench : public Test {
+public:
+    ScanPredicateBench() {
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(1, 1, 0, 0, "");
+        m_engine->setUndoToken(INT64_MIN + 1);
+
+        std::string columnNames[] = { "ID", "QUANTITY", "PRICE", "NAME" };
+        std::vector<ValueType> types;
+        std::vector<int32_t> sizes;
+        types.push_back(VALUE_TYPE_BIGINT);
+        types.push_back(VALUE_TYPE_INTEGER);
+        types.push_back(VALUE_TYPE_DOUBLE);
+        types.push_back(VALUE_TYPE_VARCHAR);
+        for (int i = 0; i < 3; i++) {
+            sizes.push_back(NValue::getTupleStorageSize(types[i]));
+        }
+        sizes.push_back(32);
+        std::vector<bool> allowNull(4, true);
+        TupleSchema *schema = TupleSchema::createTupleSchema(types, sizes, allowNull, true);
+        m_table = TableFactory::getPersistentTable(0, m_engine->getExecutorContext(), "ITEMS",
+                                                   schema, columnNames, -1, false, false);
+
+        NValue name = ValueFactory::getStringValue("item name");
+        TableTuple &tuple = m_table->tempTuple();
+        tuple.setNValue(3, name);
+        srand(1);
+        for (int64_t id = 0; id < numRows; id++) {
+            tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+            tuple.setNValue(1, ValueFactory::getIntegerValue(rand() % 100));
+            tuple.setNValue(2, ValueFactory::getDoubleValue((rand() % 10000) / 100.0));
+            m_table->insertTuple(tuple);
+        }
+        name.free();
+    }
+
+    ~ScanPredicateBench() {
+        m_engine->releaseUndoToken(INT64_MIN + 1);
+        delete m_table;
+        delete m_engine;
+    }
+
+    /** Count the matches one tuple at a time */
+    int64_t scanTuples(const AbstractExpression *predicate) {
+        int64_t matches = 0;
+        TableTuple tuple(m_table->schema());
+        TableIterator iterator(m_table);
+        while (iterator.next(tuple)) {
+            if (predicate->eval(&tuple, NULL).isTrue()) {
+                matches++;
+            }
+        }
+        return matches;
+    }
+
+    /** Count the matches a batch at a time, as SeqScanExecutor does */
+    int64_t scanBatches(const AbstractExpression *predicate) {
+        char *batch[EXPRESSION_BATCH_SIZE];
+        int selection[EXPRESSION_BATCH_SIZE];
+        int64_t matches = 0;
+        TableTuple tuple(m_table->schema());
+        TableIterator iterator(m_table);
+        while (true) {
+            int count = 0;
+            while (count < EXPRESSION_BATCH_SIZE && iterator.next(tuple)) {
+                batch[count++] = tuple.address();
+            }
+            if (count == 0) {
+                break;
+            }
+            for (int i = 0; i < count; i++) {
+                selection[i] = i;
+            }
+            matches += predicate->evalBatch(m_table->schema(), batch, selection, count);
+        }
+        return matches;
+    }
+
+    /** Count the matches one tuple at a time with the compiled predicate */
+    int64_t scanCompiled(const CompiledPredicate *predicate) {
+        int64_t matches = 0;
+        TableTuple tuple(m_table->schema());
+        TableIterator iterator(m_table);
+        while (iterator.next(tuple)) {
+            if (predicate->isTrue(&tuple, NULL)) {
+                matches++;
+            }
+        }
+        return matches;
+    }
+
+    void measure(const char *label, AbstractExpression *predicate) {
+        std::auto_ptr<AbstractExpression> owner(predicate);
+        std::auto_ptr<CompiledPredicate> compiled(CompiledPredicate::compile(predicate, m_table->schema(), NULL));
+        int64_t tupleMatches = 0;
+        int64_t batchMatches = 0;
+        int64_t compiledMatches = 0;
+        int64_t start = nowMicros();
+        for (int i = 0; i < numScans; i++) {
+            tupleMatches = scanTuples(predicate);
+        }
+        int64_t tupleMicros = std::max(nowMicros() - start, static_cast<int64_t>(1));
+        start = nowMicros();
+        for (int i = 0; i < numScans; i++) {
+            batchMatches = scanBatches(predicate);
+        }
+        int64_t batchMicros = std::max(nowMicros() - start, static_cast<int64_t>(1));
+        start = nowMicros();
+        for (int i = 0; i < numScans; i++) {
+            compiledMatches = scanCompiled(compiled.get());
+        }
+        int64_t compiledMicros = std::max(nowMicros() - start, static_cast<int64_t>(1));
+
+        double rows = static_cast<double>(numRows) * numScans * 1000000.0;
+        printf("%-28s eval %12.0f rows/sec/core  evalBatch %12.0f rows/sec/core  %.2fx"
+               "  compiled %12.0f rows/sec/core  %.2fx\n", label,
+               rows / static_cast<double>(tupleMicros), rows / static_cast<double>(batchMicros),
+               static_cast<double>(tupleMicros) / static_cast<double>(batchMicros),
+               rows / static_cast<double>(compiledMicros),
+               static_cast<double>(tupleMicros) / static_cast<double>(compiledMicros));
+        ASSERT_EQ(tupleMatches, batchMatches);
+        ASSERT_EQ(tupleMatches, compiledMatches);
+    }
+
+    static AbstractExpression* column(int id) {
+        return new TupleValueExpression(id, "ITEMS", "C");
+    }
+
+    static AbstractExpression* constant(NValue value) {
+        return constantValueFactory(value);
+    }
+
+    VoltDBEngine *m_engine;
+    Table *m_table;
+};
+
+TEST_F(ScanPredicateBench, Predicates) {
+    printf("\n%d rows, %d scans\n", numRows, numScans);
+    measure("QUANTITY < 10",
+        comparisonFactory(EXPRESSION_TYPE_COMPARE_LESSTHAN, column(1),
+                          constant(ValueFactory::getIntegerValue(10))));
+    measure("PRICE >= 50.0",
+        comparisonFactory(EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO, column(2),
+                          constant(ValueFactory::getDoubleValue(50.0))));
+    measure("ID <> 7 AND QUANTITY = 42",
+        conjunctionFactory(EXPRESSION_TYPE_CONJUNCTION_AND,
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_NOTEQUAL, column(0),
+                              constant(ValueFactory::getBigIntValue(7))),
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_EQUAL, column(1),
+                              constant(ValueFactory::getIntegerValue(42)))));
+    measure("QUANTITY > 90 OR PRICE < 1.0",
+        conjunctionFactory(EXPRESSION_TYPE_CONJUNCTION_OR,
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_GREATERTHAN, column(1),
+                              constant(ValueFactory::getIntegerValue(90))),
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_LESSTHAN, column(2),
+                              constant(ValueFactory::getDoubleValue(1.0)))));
+    measure("QUANTITY < PRICE",
+        comparisonFactory(EXPRESSION_TYPE_COMPARE_LESSTHAN, column(1), column(2)));
+    measure("NOT (ID < 500000)",
+        operatorFactory(EXPRESSION_TYPE_OPERATOR_NOT,
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_LESSTHAN, column(0),
+                              constant(ValueFactory::getBigIntValue(500000))), NULL));
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) numRows = atoi(argv[1]);
+    if (argc > 2) numScans = atoi(argv[2]);
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,357 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/NValue.hpp"
+#include "common/TupleSchema.h"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/tabletuple.h"
+#include "common/types.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stdint.h>
+
+using namespace std;
+using namespace voltdb;
+
+#define NUM_OF_TUPLES 5000
+
+/** Rows of (ID BIGINT, GRP INTEGER, NAME VARCHAR(12)) */
+class ConcurrentTreeIndexTest : public Test {
+public:
+    ConcurrentTreeIndexTest() {
+        vector<ValueType> types;
+        vector<int32_t> sizes;
+        types.push_back(VALUE_TYPE_BIGINT);
+        sizes.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        types.push_back(VALUE_TYPE_INTEGER);
+        sizes.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER));
+        types.push_back(VALUE_TYPE_VARCHAR);
+        sizes.push_back(12);
+        m_schema = TupleSchema::createTupleSchema(types, sizes, vector<bool>(3, false), true);
+        m_tupleLength = m_schema->tupleLength() + TUPLE_HEADER_SIZE;
+        m_data = new char[m_tupleLength * NUM_OF_TUPLES]();
+        srand(7);
+    }
+
+    ~ConcurrentTreeIndexTest() {
+        delete[] m_data;
+        TupleSchema::freeTupleSchema(m_schema);
+    }
+
+    TableTuple row(int ii) {
+        TableTuple tuple(m_schema);
+        tuple.move(m_data + m_tupleLength * ii);
+        return tuple;
+    }
+
+    void setRow(int ii, int64_t id, int32_t group) {
+        TableTuple tuple = row(ii);
+        tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+        tuple.setNValue(1, ValueFactory::getIntegerValue(group));
+        char name[16];
+        snprintf(name, sizeof(name), "name%d", group % 37);
+        NValue value = ValueFactory::getStringValue(name);
+        tuple.setNValue(2, value);
+        value.free();
+    }
+
+    TableIndex* createIndex(TableIndexType type, bool unique, bool intsOnly, int column, int column2 = -1) {
+        vector<int> columns(1, column);
+        vector<ValueType> columnTypes(1, m_schema->columnType(column));
+        if (column2 >= 0) {
+            columns.push_back(column2);
+            columnTypes.push_back(m_schema->columnType(column2));
+        }
+        TableIndexScheme scheme("IDX", type, columns, columnTypes, unique, intsOnly, m_schema);
+        return TableIndexFactory::getInstance(scheme);
+    }
+
+    /** The key of a row, in the index's key schema */
+    TableTuple key(TableIndex *index, int ii, char *buffer) {
+        TableTuple searchKey(index->getKeySchema());
+        searchKey.move(buffer);
+        const vector<int> &columns = index->getColumnIndices();
+        for (int jj = 0; jj < columns.size(); jj++) {
+            searchKey.setNValue(jj, row(ii).getNValue(columns[jj]));
+        }
+        return searchKey;
+    }
+
+    /** The keys the index hands out from the current position, as strings */
+    static vector<string> scan(TableIndex *index, const vector<int> &columns, bool addresses) {
+        vector<string> values;
+        TableTuple tuple;
+        while (!(tuple = index->nextValue()).isNullTuple()) {
+            values.push_back(describe(tuple, columns, addresses));
+        }
+        return values;
+    }
+
+    static string describe(const TableTuple &tuple, const vector<int> &columns, bool address) {
+        string description;
+        for (int ii = 0; ii < columns.size(); ii++) {
+            description += tuple.getNValue(columns[ii]).debug() + " ";
+        }
+        // drop the [@address] of the inlined strings
+        for (size_t at = description.find("[@"); at != string::npos; at = description.find("[@", at)) {
+            description.erase(at, description.find(']', at) - at + 1);
+        }
+        if (address) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%p", tuple.address());
+            description += buffer;
+        }
+        return description;
+    }
+
+    /**
+     * Run the same inserts, deletes and updates against a balanced tree
+     * and a concurrent tree and compare what their cursors return. Equal
+     * keys of non-unique indexes may come out in different orders, so
+     * only unique indexes compare the tuples themselves.
+     */
+    void compare(bool unique, bool intsOnly, int column, int column2 = -1) {
+        TableIndex *tree = createIndex(BALANCED_TREE_INDEX, unique, intsOnly, column, column2);
+        TableIndex *concurrent = createIndex(CONCURRENT_TREE_INDEX, unique, intsOnly, column, column2);
+        ASSERT_EQ(string("ConcurrentTreeIndex"), concurrent->getTypeName());
+        const vector<int> &columns = tree->getColumnIndices();
+
+        for (int ii = 0; ii < NUM_OF_TUPLES; ii++) {
+            setRow(ii, (ii * 7919) % NUM_OF_TUPLES, rand() % 300);
+            TableTuple tuple = row(ii);
+            ASSERT_EQ(tree->addEntry(&tuple), concurrent->addEntry(&tuple));
+        }
+        ASSERT_EQ(tree->getSize(), concurrent->getSize());
+        for (int ii = 0; ii < NUM_OF_TUPLES; ii += 3) {
+            TableTuple tuple = row(ii);
+            ASSERT_EQ(tree->deleteEntry(&tuple), concurrent->deleteEntry(&tuple));
+        }
+        // move some keys, the tuples stay where they are
+        char *old = new char[m_tupleLength];
+        for (int ii = 1; ii < NUM_OF_TUPLES; ii += 10) {
+            TableTuple tuple = row(ii);
+            TableTuple before(m_schema);
+            before.move(old);
+            before.copy(tuple);
+            setRow(ii, NUM_OF_TUPLES + ii, rand() % 300);
+            ASSERT_EQ(tree->checkForIndexChange(&before, &tuple),
+                      concurrent->checkForIndexChange(&before, &tuple));
+            ASSERT_EQ(tree->replaceEntry(&before, &tuple), concurrent->replaceEntry(&before, &tuple));
+        }
+        delete[] old;
+        ASSERT_EQ(tree->getSize(), concurrent->getSize());
+
+        for (int begin = 0; begin < 2; begin++) {
+            tree->moveToEnd(begin == 1);
+            concurrent->moveToEnd(begin == 1);
+            vector<string> expected = scan(tree, columns, unique);
+            ASSERT_EQ(expected.size(), tree->getSize());
+            ASSERT_TRUE(expected == scan(concurrent, columns, unique));
+        }
+
+        char *buffer = new char[tree->getKeySchema()->tupleLength() + TUPLE_HEADER_SIZE];
+        for (int ii = 0; ii < NUM_OF_TUPLES; ii += 7) {
+            TableTuple searchKey = key(tree, ii, buffer);
+            TableTuple tuple = row(ii);
+            ASSERT_EQ(tree->exists(&tuple), concurrent->exists(&tuple));
+            bool found = tree->moveToKey(&searchKey);
+            ASSERT_EQ(found, concurrent->moveToKey(&searchKey));
+            vector<string> expected, actual;
+            TableTuple match;
+            while (!(match = tree->nextValueAtKey()).isNullTuple()) {
+                expected.push_back(describe(match, columns, true));
+            }
+            while (!(match = concurrent->nextValueAtKey()).isNullTuple()) {
+                actual.push_back(describe(match, columns, true));
+            }
+            sort(expected.begin(), expected.end());
+            sort(actual.begin(), actual.end());
+            ASSERT_TRUE(expected == actual);
+
+            // the unique tree can only advance from a key it found
+            if (found) {
+                ASSERT_EQ(tree->advanceToNextKey(), concurrent->advanceToNextKey());
+                TableTuple next = tree->nextValueAtKey();
+                if (!next.isNullTuple()) {
+                    ASSERT_EQ(describe(next, columns, unique),
+                              describe(concurrent->nextValueAtKey(), columns, unique));
+                }
+            }
+
+            tree->moveToKeyOrGreater(&searchKey);
+            concurrent->moveToKeyOrGreater(&searchKey);
+            ASSERT_TRUE(scan(tree, columns, unique) == scan(concurrent, columns, unique));
+            tree->moveToGreaterThanKey(&searchKey);
+            concurrent->moveToGreaterThanKey(&searchKey);
+            ASSERT_TRUE(scan(tree, columns, unique) == scan(concurrent, columns, unique));
+        }
+        delete[] buffer;
+
+        for (int ii = 0; ii < NUM_OF_TUPLES; ii++) {
+            TableTuple tuple = row(ii);
+            ASSERT_EQ(tree->deleteEntry(&tuple), concurrent->deleteEntry(&tuple));
+        }
+        EXPECT_EQ(0, concurrent->getSize());
+        concurrent->moveToEnd(true);
+        EXPECT_TRUE(concurrent->nextValue().isNullTuple());
+        delete tree;
+        delete concurrent;
+    }
+
+    TupleSchema *m_schema;
+    int m_tupleLength;
+    char *m_data;
+};
+
+TEST_F(ConcurrentTreeIndexTest, UniqueIntsKey) {
+    compare(true, true, 0);
+}
+
+TEST_F(ConcurrentTreeIndexTest, MultiIntsKey) {
+    compare(false, true, 1);
+}
+
+TEST_F(ConcurrentTreeIndexTest, UniqueGenericKey) {
+    compare(true, false, 2, 0);
+}
+
+TEST_F(ConcurrentTreeIndexTest, MultiGenericKey) {
+    compare(false, false, 2);
+}
+
+/** What the readers share with the test */
+struct ReaderState {
+    TableIndex *index;
+    int stableKeys;
+    volatile bool done;
+    volatile int scans;
+    volatile int failures;
+};
+
+/**
+ * Scans the index back and forth while the test changes it. Even IDs
+ * are never touched, so every scan has to see all of them, in order.
+ */
+static void* readIndex(void *arg) {
+    ReaderState *state = static_cast<ReaderState*>(arg);
+    IndexCursor *cursor = state->index->newCursor();
+    char buffer[64];
+    TableTuple searchKey(state->index->getKeySchema());
+    searchKey.move(buffer);
+    unsigned int seed = static_cast<unsigned int>(reinterpret_cast<uintptr_t>(&seed));
+    int scans = 0;
+    int failures = 0;
+    while (!state->done || scans < 2) {
+        bool forward = (scans % 2 == 0);
+        cursor->moveToEnd(forward);
+        int stable = 0;
+        int64_t last = forward ? INT64_MIN : INT64_MAX;
+        TableTuple tuple;
+        while (!(tuple = cursor->nextValue()).isNullTuple()) {
+            int64_t id = ValuePeeker::peekBigInt(tuple.getNValue(0));
+            if (forward ? (id <= last) : (id >= last)) {
+                failures++;
+            }
+            last = id;
+            if (id % 2 == 0) {
+                stable++;
+            }
+        }
+        if (stable != state->stableKeys) {
+            failures++;
+        }
+
+        int64_t id = 2 * (rand_r(&seed) % state->stableKeys);
+        searchKey.setNValue(0, ValueFactory::getBigIntValue(id));
+        if (!cursor->moveToKey(&searchKey) ||
+            ValuePeeker::peekBigInt(cursor->nextValueAtKey().getNValue(0)) != id) {
+            failures++;
+        }
+        scans++;
+    }
+    delete cursor;
+    __sync_fetch_and_add(&state->scans, scans);
+    __sync_fetch_and_add(&state->failures, failures);
+    return NULL;
+}
+
+TEST_F(ConcurrentTreeIndexTest, ReadersWhileWriting) {
+    TableIndex *index = createIndex(CONCURRENT_TREE_INDEX, true, true, 0);
+    const int stableKeys = NUM_OF_TUPLES / 2;
+    for (int ii = 0; ii < NUM_OF_TUPLES; ii++) {
+        setRow(ii, ii, 0);
+    }
+    for (int ii = 0; ii < NUM_OF_TUPLES; ii += 2) {
+        TableTuple tuple = row(ii);
+        ASSERT_TRUE(index->addEntry(&tuple));
+    }
+
+    ReaderState state;
+    state.index = index;
+    state.stableKeys = stableKeys;
+    state.done = false;
+    state.scans = 0;
+    state.failures = 0;
+    const int READERS = 4;
+    pthread_t readers[READERS];
+    for (int ii = 0; ii < READERS; ii++) {
+        ASSERT_EQ(0, pthread_create(&readers[ii], NULL, readIndex, &state));
+    }
+
+    // odd IDs come and go, splitting leaves all over the tree
+    vector<bool> present(NUM_OF_TUPLES, false);
+    for (int round = 0; round < 50000; round++) {
+        int ii = 2 * (rand() % stableKeys) + 1;
+        if (ii >= NUM_OF_TUPLES) continue;
+        TableTuple tuple = row(ii);
+        if (present[ii]) {
+            ASSERT_TRUE(index->deleteEntry(&tuple));
+        } else {
+            ASSERT_TRUE(index->addEntry(&tuple));
+        }
+        present[ii] = !present[ii];
+    }
+    state.done = true;
+    for (int ii = 0; ii < READERS; ii++) {
+        pthread_join(readers[ii], NULL);
+    }
+    EXPECT_TRUE(state.scans >= 2 * READERS);
+    EXPECT_EQ(0, state.failures);
+    EXPECT_EQ(stableKeys + count(present.begin(), present.end(), true),
+              static_cast<int>(index->getSize()));
+    delete index;
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,230 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Compares the open addressing hash index the factory builds for integer
+ * keys with the boost::unordered_map index it replaced and with the tree:
+ * random lookups of unique keys, and a non-unique index over a column with
+ * few distinct values. Usage:
+ *
+ *   hash_index_bench [keys] [lookups] [distinct values]
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/tabletuple.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "indexes/HashTableUniqueIndex.h"
+#include "indexes/indexkey.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+#include <sys/time.h>
+
+using namespace voltdb;
+
+static int numKeys = 200000;
+static int numLookups = 2000000;
+static int numDistinct = 16;
+
+static int64_t nowMicros() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+static double perSecond(int64_t count, int64_t elapsed) {
+    return static_cast<double>(count) * 1000000.0 / static_cast<double>(elapsed > 0 ? elapsed : 1);
+}
+
+/**
+ * The boost::unordered_map hash index the factory used to build for
+ * integer keys, kept to compare the open addressing one against.
+ */
+class BoostHashUniqueIndex : public HashTableUniqueIndex<IntsKey<1>, IntsHasher<1>, IntsEqualityChecker<1> > {
+public:
+    BoostHashUniqueIndex(const TableIndexScheme &scheme) :
+        HashTableUniqueIndex<IntsKey<1>, IntsHasher<1>, IntsEqualityChecker<1> >(scheme) {}
+};
+
+class HashIndexBench : public Test {
+public:
+    HashIndexBench() {
+        // ID is unique, GRP repeats numDistinct values
+        std::vector<ValueType> types(2, VALUE_TYPE_BIGINT);
+        std::vector<int32_t> sizes(2, NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        std::vector<bool> allowNull(2, false);
+        m_schema = TupleSchema::createTupleSchema(types, sizes, allowNull, true);
+
+        TableTuple tuple(m_schema);
+        m_tupleLength = tuple.tupleLength();
+        m_storage = new char[static_cast<size_t>(m_tupleLength) * numKeys];
+        memset(m_storage, 0, static_cast<size_t>(m_tupleLength) * numKeys);
+        for (int64_t id = 0; id < numKeys; id++) {
+            tuple.move(m_storage + id * m_tupleLength);
+            tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+            tuple.setNValue(1, ValueFactory::getBigIntValue(id % numDistinct));
+        }
+    }
+
+    ~HashIndexBench() {
+        delete[] m_storage;
+        TupleSchema::freeTupleSchema(m_schema);
+    }
+
+    TupleSchema* bigIntKeySchema() {
+        std::vector<ValueType> types(1, VALUE_TYPE_BIGINT);
+        std::vector<int32_t> sizes(1, NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        std::vector<bool> allowNull(1, true);
+        return TupleSchema::createTupleSchema(types, sizes, allowNull, true);
+    }
+
+    TableIndexScheme scheme(int column, bool unique) {
+        std::vector<int32_t> columns(1, column);
+        std::vector<ValueType> types(1, VALUE_TYPE_BIGINT);
+        return TableIndexScheme("bench", HASH_TABLE_INDEX, columns, types, unique, true, m_schema);
+    }
+
+    void addAll(TableIndex *index) {
+        TableTuple tuple(m_schema);
+        for (int64_t id = 0; id < numKeys; id++) {
+            tuple.move(m_storage + id * m_tupleLength);
+            index->addEntry(&tuple);
+        }
+    }
+
+    /** Random lookups of the unique ID column */
+    void lookups(TableIndex *index) {
+        addAll(index);
+        ASSERT_EQ(numKeys, index->getSize());
+
+        TupleSchema *keySchema = bigIntKeySchema();
+        TableTuple searchkey(keySchema);
+        searchkey.move(new char[searchkey.tupleLength()]);
+        int found = 0;
+        int64_t start = nowMicros();
+        for (int64_t i = 0; i < numLookups; i++) {
+            // a stride prime to the key count visits every key in a scattered order
+            searchkey.setNValue(0, ValueFactory::getBigIntValue((i * 7919) % numKeys));
+            found += index->moveToKey(&searchkey);
+        }
+        int64_t elapsed = nowMicros() - start;
+        EXPECT_EQ(numLookups, found);
+        printf("%-24s %12.0f lookups/sec %8.1f bytes/entry\n", index->getTypeName().c_str(),
+               perSecond(numLookups, elapsed),
+               static_cast<double>(index->getMemoryEstimate()) / numKeys);
+
+        delete[] searchkey.address();
+        TupleSchema::freeTupleSchema(keySchema);
+    }
+
+    /** Build, scan and tear down a non-unique index on GRP */
+    void duplicates(TableIndex *index) {
+        int64_t start = nowMicros();
+        addAll(index);
+        int64_t inserted = nowMicros();
+        ASSERT_EQ(numKeys, index->getSize());
+
+        TupleSchema *keySchema = bigIntKeySchema();
+        TableTuple searchkey(keySchema);
+        searchkey.move(new char[searchkey.tupleLength()]);
+        int64_t scanned = 0;
+        for (int64_t value = 0; value < numDistinct; value++) {
+            searchkey.setNValue(0, ValueFactory::getBigIntValue(value));
+            index->moveToKey(&searchkey);
+            while (!index->nextValueAtKey().isNullTuple()) {
+                scanned++;
+            }
+        }
+        int64_t scanEnd = nowMicros();
+        EXPECT_EQ(numKeys, scanned);
+
+        TableTuple tuple(m_schema);
+        for (int64_t id = 0; id < numKeys; id++) {
+            tuple.move(m_storage + id * m_tupleLength);
+            index->deleteEntry(&tuple);
+        }
+        int64_t deleted = nowMicros();
+        EXPECT_EQ(0, index->getSize());
+
+        printf("%-24s %12.0f inserts/sec %12.0f scanned/sec %12.0f deletes/sec\n",
+               index->getTypeName().c_str(), perSecond(numKeys, inserted - start),
+               perSecond(numKeys, scanEnd - inserted), perSecond(numKeys, deleted - scanEnd));
+
+        delete[] searchkey.address();
+        TupleSchema::freeTupleSchema(keySchema);
+    }
+
+    TupleSchema *m_schema;
+    char *m_storage;
+    int m_tupleLength;
+};
+
+TEST_F(HashIndexBench, UniqueLookups) {
+    printf("\n%d keys, %d lookups\n", numKeys, numLookups);
+
+    TableIndexScheme unique = scheme(0, true);
+    TableIndex *index = TableIndexFactory::getInstance(unique);
+    lookups(index);
+    delete index;
+
+    unique.keySchema = bigIntKeySchema();
+    index = new BoostHashUniqueIndex(unique);
+    lookups(index);
+    delete index;
+
+    unique.keySchema = NULL;
+    unique.setTree();
+    index = TableIndexFactory::getInstance(unique);
+    lookups(index);
+    delete index;
+}
+
+TEST_F(HashIndexBench, DuplicateKeys) {
+    printf("\n%d tuples over %d distinct values\n", numKeys, numDistinct);
+
+    TableIndexScheme multi = scheme(1, false);
+    TableIndex *index = TableIndexFactory::getInstance(multi);
+    duplicates(index);
+    delete index;
+
+    multi.setTree();
+    index = TableIndexFactory::getInstance(multi);
+    duplicates(index);
+    delete index;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) numKeys = atoi(argv[1]);
+    if (argc > 2) numLookups = atoi(argv[2]);
+    if (argc > 3) numDistinct = atoi(argv[3]);
+    return TestSuite::globalInstance()->runAll();
+}
@@ -366,6 +366,13 @@ public:
                         .op_equals(tuple.getNValue(i)).isTrue());
     }
 
+    TupleSchema* bigIntKeySchema(int columns) {
+        vector<ValueType> keyColumnTypes(columns, VALUE_TYPE_BIGINT);
+        vector<int32_t> keyColumnLengths(columns, NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        vector<bool> keyColumnAllowNull(columns, true);
+        return TupleSchema::createTupleSchema(keyColumnTypes, keyColumnLengths, keyColumnAllowNull, true);
+    }
+
 protected:
     PersistentTable* table;
     char* m_exceptionBuffer;
@@ -902,6 +909,170 @@ TEST_F(IndexTest, TupleKeyUnique) {
     delete[] searchkey.address();
 }
 
+TEST_F(IndexTest, HashUnique) {
+    vector<int> hu_column_indices;
+    vector<ValueType> hu_column_types;
+    hu_column_indices.push_back(0);
+    hu_column_types.push_back(VALUE_TYPE_BIGINT);
+    init(TableIndexScheme("hu",
+                          HASH_TABLE_INDEX,
+                          hu_column_indices,
+                          hu_column_types,
+                          true, true, NULL));
+    TableIndex* index = table->index("hu");
+    ASSERT_TRUE(index != NULL);
+    EXPECT_EQ("OpenHashTableIndex", index->getTypeName());
+    EXPECT_EQ(NUM_OF_TUPLES, index->getSize());
+
+    TupleSchema *keySchema = bigIntKeySchema(1);
+    TableTuple searchkey(keySchema);
+    searchkey.move(new char[searchkey.tupleLength()]);
+    TableTuple tuple(table->schema());
+    for (int64_t i = 1; i <= NUM_OF_TUPLES; i++) {
+        searchkey.setNValue(0, ValueFactory::getBigIntValue(i));
+        ASSERT_TRUE(index->moveToKey(&searchkey));
+        tuple = index->nextValueAtKey();
+        EXPECT_TRUE(ValueFactory::getBigIntValue(i * 11).op_equals(tuple.getNValue(4)).isTrue());
+        EXPECT_TRUE(index->nextValueAtKey().isNullTuple());
+    }
+    searchkey.setNValue(0, ValueFactory::getBigIntValue(NUM_OF_TUPLES + 1));
+    EXPECT_FALSE(index->moveToKey(&searchkey));
+    EXPECT_TRUE(index->nextValueAtKey().isNullTuple());
+
+    // duplicates are refused
+    searchkey.setNValue(0, ValueFactory::getBigIntValue(7));
+    ASSERT_TRUE(index->moveToKey(&searchkey));
+    tuple = index->nextValueAtKey();
+    EXPECT_FALSE(index->addEntry(&tuple));
+    EXPECT_TRUE(index->exists(&tuple));
+
+    // the entry follows the tuple to a new address and back
+    char moved[tuple.tupleLength()];
+    memcpy(moved, tuple.address(), tuple.tupleLength());
+    EXPECT_TRUE(index->setEntryToNewAddress(&tuple, moved, tuple.address()));
+    ASSERT_TRUE(index->moveToKey(&searchkey));
+    EXPECT_EQ(moved, index->nextValueAtKey().address());
+    TableTuple movedTuple(moved, table->schema());
+    EXPECT_TRUE(index->setEntryToNewAddress(&movedTuple, tuple.address(), moved));
+    ASSERT_TRUE(index->moveToKey(&searchkey));
+    EXPECT_EQ(tuple.address(), index->nextValueAtKey().address());
+
+    // delete and add back every other key a few times, tombstones must not lose keys
+    for (int round = 0; round < 5; round++) {
+        for (int64_t i = 2; i <= NUM_OF_TUPLES; i += 2) {
+            searchkey.setNValue(0, ValueFactory::getBigIntValue(i));
+            ASSERT_TRUE(index->moveToKey(&searchkey));
+            tuple = index->nextValueAtKey();
+            ASSERT_TRUE(index->deleteEntry(&tuple));
+            EXPECT_FALSE(index->deleteEntry(&tuple));
+            EXPECT_FALSE(index->exists(&tuple));
+            ASSERT_TRUE(index->addEntry(&tuple));
+        }
+        EXPECT_EQ(NUM_OF_TUPLES, index->getSize());
+    }
+    for (int64_t i = 1; i <= NUM_OF_TUPLES; i++) {
+        searchkey.setNValue(0, ValueFactory::getBigIntValue(i));
+        ASSERT_TRUE(index->moveToKey(&searchkey));
+    }
+
+    // the table grows and shrinks through the index
+    TableTuple &temp = table->tempTuple();
+    for (int64_t i = NUM_OF_TUPLES + 1; i <= NUM_OF_TUPLES * 10; i++) {
+        temp.setNValue(0, ValueFactory::getBigIntValue(i));
+        ASSERT_TRUE(table->insertTuple(temp));
+    }
+    EXPECT_EQ(NUM_OF_TUPLES * 10, index->getSize());
+    for (int64_t i = 1; i <= NUM_OF_TUPLES * 10; i += 3) {
+        searchkey.setNValue(0, ValueFactory::getBigIntValue(i));
+        ASSERT_TRUE(index->moveToKey(&searchkey));
+        tuple = index->nextValueAtKey();
+        ASSERT_TRUE(table->deleteTuple(tuple, true));
+    }
+    for (int64_t i = 1; i <= NUM_OF_TUPLES * 10; i++) {
+        searchkey.setNValue(0, ValueFactory::getBigIntValue(i));
+        EXPECT_EQ(i % 3 != 1, index->moveToKey(&searchkey));
+    }
+
+    delete[] searchkey.address();
+    TupleSchema::freeTupleSchema(keySchema);
+}
+
+TEST_F(IndexTest, HashMulti) {
+    vector<int> hm_column_indices;
+    vector<ValueType> hm_column_types;
+    hm_column_indices.push_back(2);
+    hm_column_indices.push_back(1);
+    hm_column_types.push_back(VALUE_TYPE_BIGINT);
+    hm_column_types.push_back(VALUE_TYPE_BIGINT);
+    init(TableIndexScheme("hm",
+                          HASH_TABLE_INDEX,
+                          hm_column_indices,
+                          hm_column_types,
+                          false, true, NULL));
+    TableIndex* index = table->index("hm");
+    ASSERT_TRUE(index != NULL);
+    EXPECT_EQ("OpenHashTableIndex", index->getTypeName());
+
+    TupleSchema *keySchema = bigIntKeySchema(2);
+    TableTuple searchkey(keySchema);
+    searchkey.move(new char[searchkey.tupleLength()]);
+    TableTuple tuple(table->schema());
+
+    // (i % 3, i % 2) has six keys with 166 or 167 tuples each
+    int total = 0;
+    for (int64_t mod3 = 0; mod3 < 3; mod3++) {
+        for (int64_t mod2 = 0; mod2 < 2; mod2++) {
+            searchkey.setNValue(0, ValueFactory::getBigIntValue(mod3));
+            searchkey.setNValue(1, ValueFactory::getBigIntValue(mod2));
+            ASSERT_TRUE(index->moveToKey(&searchkey));
+            int count = 0;
+            while (!(tuple = index->nextValueAtKey()).isNullTuple()) {
+                EXPECT_TRUE(ValueFactory::getBigIntValue(mod3).op_equals(tuple.getNValue(2)).isTrue());
+                EXPECT_TRUE(ValueFactory::getBigIntValue(mod2).op_equals(tuple.getNValue(1)).isTrue());
+                count++;
+            }
+            EXPECT_TRUE(count == 166 || count == 167);
+            total += count;
+        }
+    }
+    EXPECT_EQ(NUM_OF_TUPLES, total);
+
+    // only the entry of the given tuple moves
+    searchkey.setNValue(0, ValueFactory::getBigIntValue(1));
+    searchkey.setNValue(1, ValueFactory::getBigIntValue(0));
+    ASSERT_TRUE(index->moveToKey(&searchkey));
+    index->nextValueAtKey();
+    tuple = index->nextValueAtKey();
+    char moved[tuple.tupleLength()];
+    memcpy(moved, tuple.address(), tuple.tupleLength());
+    EXPECT_FALSE(index->setEntryToNewAddress(&tuple, moved, moved));
+    EXPECT_TRUE(index->setEntryToNewAddress(&tuple, moved, tuple.address()));
+    index->moveToKey(&searchkey);
+    int count = 0;
+    int movedCount = 0;
+    TableTuple match(table->schema());
+    while (!(match = index->nextValueAtKey()).isNullTuple()) {
+        count++;
+        movedCount += (match.address() == moved);
+        EXPECT_NE(tuple.address(), match.address());
+    }
+    EXPECT_EQ(167, count);
+    EXPECT_EQ(1, movedCount);
+    TableTuple movedTuple(moved, table->schema());
+    EXPECT_TRUE(index->setEntryToNewAddress(&movedTuple, tuple.address(), moved));
+
+    // deleting one tuple leaves the others of its key
+    ASSERT_TRUE(index->deleteEntry(&tuple));
+    EXPECT_FALSE(index->deleteEntry(&tuple));
+    index->moveToKey(&searchkey);
+    for (count = 0; !index->nextValueAtKey().isNullTuple(); count++);
+    EXPECT_EQ(166, count);
+    ASSERT_TRUE(index->addEntry(&tuple));
+    EXPECT_EQ(NUM_OF_TUPLES, index->getSize());
+
+    delete[] searchkey.address();
+    TupleSchema::freeTupleSchema(keySchema);
+}
 
 int main()
 {
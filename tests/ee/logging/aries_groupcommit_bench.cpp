@@ -0,0 +1,108 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2010 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Compares ARIES txns/sec with a sync per log record (the old behavior)
+ * against the group committed AriesLogProxy, in the spirit of
+ * src/dtxn/logging/logfilebench.cc. Built by "build.py buildbench".
+ *
+ *   aries_groupcommit_bench [temp log file] [txns] [records per txn]
+ */
+
+#include "logging/AriesLogProxy.h"
+#include "execution/VoltDBEngine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+using namespace voltdb;
+
+static const int RECORD_SIZE = 128;
+
+static int64_t nowMicros() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+/**
+ * Run the workload with the given policy and return txns/sec
+ */
+static double runWorkload(VoltDBEngine *engine, const std::string &logPath, int numTxns, int recordsPerTxn,
+                          const char *name, size_t maxBytes, int maxRecords, int64_t maxMicros, bool syncOnCommit) {
+    char record[RECORD_SIZE];
+    memset(record, 'r', RECORD_SIZE);
+
+    unlink(logPath.c_str());
+    AriesLogProxy *proxy = AriesLogProxy::getAriesLogProxy(engine);
+    proxy->setGroupCommitPolicy(maxBytes, maxRecords, maxMicros, syncOnCommit);
+
+    int64_t start = nowMicros();
+    for (int txn = 0; txn < numTxns; txn++) {
+        for (int ii = 0; ii < recordsPerTxn; ii++) {
+            proxy->logBinaryOutput(record, RECORD_SIZE);
+        }
+        proxy->commit();
+    }
+    proxy->flush();
+    int64_t elapsed = nowMicros() - start;
+
+    double txnsPerSec = (double)numTxns * 1000000.0 / (double)(elapsed > 0 ? elapsed : 1);
+    printf("%-32s %8d txns %8ld syncs %12.1f txns/sec\n",
+           name, numTxns, (long)proxy->getSyncCount(), txnsPerSec);
+    delete proxy;
+    return txnsPerSec;
+}
+
+int main(int argc, const char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "aries_groupcommit_bench [temp log file] [txns] [records per txn]\n");
+        return 1;
+    }
+    std::string logPath = argv[1];
+    int numTxns = (argc > 2 ? atoi(argv[2]) : 500);
+    int recordsPerTxn = (argc > 3 ? atoi(argv[3]) : 4);
+
+    VoltDBEngine *engine = new VoltDBEngine();
+    engine->setARIESEnabled(true);
+    engine->setARIESFile(logPath);
+
+    // one sync per record is what logLocally used to do
+    double perRecord = runWorkload(engine, logPath, numTxns, recordsPerTxn, "sync per record", 1, 1, 0, true);
+    double waiting = runWorkload(engine, logPath, numTxns, recordsPerTxn, "group commit, commit waits",
+                                 AriesLogProxy::DEFAULT_GROUP_COMMIT_BYTES, AriesLogProxy::DEFAULT_GROUP_COMMIT_RECORDS,
+                                 AriesLogProxy::DEFAULT_GROUP_COMMIT_MICROS, true);
+    double async = runWorkload(engine, logPath, numTxns, recordsPerTxn, "group commit, commit returns",
+                               AriesLogProxy::DEFAULT_GROUP_COMMIT_BYTES, AriesLogProxy::DEFAULT_GROUP_COMMIT_RECORDS,
+                               AriesLogProxy::DEFAULT_GROUP_COMMIT_MICROS, false);
+    printf("speedup vs sync per record: %.2fx waiting, %.2fx not waiting\n",
+           waiting / perRecord, async / perRecord);
+
+    delete engine;
+    unlink(logPath.c_str());
+    return 0;
+}
@@ -0,0 +1,250 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Compares the size of single column update records for the original
+ * LogRecord format and CompactLogRecord, and how fast the compact records
+ * replay. Usage:
+ *
+ *   aries_logrecord_bench [rows] [updates]
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/serializeio.h"
+#include "execution/VoltDBEngine.h"
+#include "logging/Logrecord.h"
+#include "logging/CompactLogrecord.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "indexes/tableindex.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/time.h>
+
+using namespace voltdb;
+
+static int numRows = 1000;
+static int numUpdates = 20000;
+
+// the column every update changes
+static const int UPDATED_COLUMN = 4;
+
+static int64_t nowMicros() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+class AriesLogRecordBench : public Test {
+public:
+    AriesLogRecordBench() : m_stringPool(16384, 1), m_undoToken(0) {
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(1, 1, 0, 0, "");
+        m_engine->setUndoToken(m_undoToken);
+
+        // a narrow-ish OLTP row: key, a few counters and two strings
+        std::string columnNames[] = { "ID", "C1", "C2", "C3", "BALANCE", "YTD", "NAME", "DATA" };
+        std::vector<ValueType> types;
+        std::vector<int32_t> sizes;
+        std::vector<bool> allowNull;
+        types.push_back(VALUE_TYPE_BIGINT);
+        types.push_back(VALUE_TYPE_INTEGER);
+        types.push_back(VALUE_TYPE_INTEGER);
+        types.push_back(VALUE_TYPE_INTEGER);
+        types.push_back(VALUE_TYPE_BIGINT);
+        types.push_back(VALUE_TYPE_BIGINT);
+        types.push_back(VALUE_TYPE_VARCHAR);
+        types.push_back(VALUE_TYPE_VARCHAR);
+        for (int i = 0; i < 6; i++) {
+            sizes.push_back(NValue::getTupleStorageSize(types[i]));
+        }
+        sizes.push_back(32);
+        sizes.push_back(250);
+        for (int i = 0; i < 8; i++) {
+            allowNull.push_back(i != 0);
+        }
+        TupleSchema *schema = TupleSchema::createTupleSchema(types, sizes, allowNull, true);
+
+        std::vector<int32_t> keyColumns(1, 0);
+        std::vector<ValueType> keyTypes(1, VALUE_TYPE_BIGINT);
+        std::vector<int32_t> keySizes(1, NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        std::vector<bool> keyAllowNull(1, false);
+        TableIndexScheme pkey("pkey", BALANCED_TREE_INDEX, keyColumns, keyTypes, true, false, schema);
+        pkey.keySchema = TupleSchema::createTupleSchema(keyTypes, keySizes, keyAllowNull, true);
+
+        std::vector<TableIndexScheme> indexes;
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, m_engine->getExecutorContext(), "WAREHOUSE",
+                                             schema, columnNames, pkey, indexes, -1, false, false));
+
+        // the update executor's input: tuple address followed by the new values
+        std::vector<ValueType> inputTypes(2, VALUE_TYPE_BIGINT);
+        std::vector<int32_t> inputSizes(2, NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        std::vector<bool> inputAllowNull(2, true);
+        m_inputSchema = TupleSchema::createTupleSchema(inputTypes, inputSizes, inputAllowNull, true);
+
+        NValue name = ValueFactory::getStringValue("warehouse name");
+        NValue data = ValueFactory::getStringValue(std::string(200, 'd'));
+        TableTuple &tuple = m_table->tempTuple();
+        for (int64_t id = 0; id < numRows; id++) {
+            tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+            for (int i = 1; i < 4; i++) {
+                tuple.setNValue(i, ValueFactory::getIntegerValue(static_cast<int32_t>(id * i)));
+            }
+            tuple.setNValue(4, ValueFactory::getBigIntValue(id * 1000));
+            tuple.setNValue(5, ValueFactory::getBigIntValue(0));
+            tuple.setNValue(6, name);
+            tuple.setNValue(7, data);
+            m_table->insertTuple(tuple);
+        }
+        name.free();
+        data.free();
+        commit();
+    }
+
+    ~AriesLogRecordBench() {
+        TupleSchema::freeTupleSchema(m_inputSchema);
+        delete m_table;
+        delete m_engine;
+    }
+
+    void commit() {
+        m_engine->releaseUndoToken(m_undoToken);
+        m_engine->setUndoToken(++m_undoToken);
+    }
+
+    TableTuple findTuple(int64_t id) {
+        TableIndex *pkey = m_table->primaryKeyIndex();
+        char keyData[64];
+        TableTuple key(keyData, pkey->getKeySchema());
+        key.setNValue(0, ValueFactory::getBigIntValue(id));
+        pkey->moveToKey(&key);
+        return pkey->nextValueAtKey();
+    }
+
+    /** Log numUpdates single column updates into output */
+    void writeUpdates(FallbackSerializeOutput &output, bool compact) {
+        TableIndex *pkey = m_table->primaryKeyIndex();
+        std::vector<int32_t> modifiedCols(1, UPDATED_COLUMN);
+
+        char keyData[64];
+        TableTuple key(keyData, pkey->getKeySchema());
+        char inputData[64];
+        TableTuple input(inputData, m_inputSchema);
+
+        srand(1);
+        for (int i = 0; i < numUpdates; i++) {
+            TableTuple target = findTuple(rand() % numRows);
+            TableTuple &update = m_table->getTempTupleInlined(target);
+            update.setNValue(UPDATED_COLUMN, ValueFactory::getBigIntValue(i));
+
+            if (compact) {
+                CompactLogRecord logrecord(LogRecord::T_UPDATE, LogRecord::T_FORWARD, output.position(), -1,
+                                           i, 0, 0, pkey, &modifiedCols, &target, &update);
+                logrecord.serializeTo(output);
+            } else {
+                // this is what the update executor used to log
+                key.setNValue(0, target.getNValue(0));
+                input.setNValue(0, ValueFactory::getBigIntValue(0));
+                input.setNValue(1, ValueFactory::getBigIntValue(i));
+                LogRecord logrecord(0, LogRecord::T_UPDATE, LogRecord::T_FORWARD, -1, i, 0,
+                                    m_table->name(), &key, 1, &modifiedCols, NULL, &input);
+                logrecord.serializeTo(output);
+            }
+        }
+    }
+
+    /** Replay the compact records in data and return the elapsed micros */
+    int64_t replay(const char *data, size_t length) {
+        ReferenceSerializeInput input(data, length);
+        const char *end = data + length;
+        int replayed = 0;
+
+        int64_t start = nowMicros();
+        while (reinterpret_cast<const char*>(input.getRawPointer(0)) < end) {
+            CompactLogRecord logrecord(input);
+            logrecord.populateFields(m_table->schema(), m_table->primaryKeyIndex(), &m_stringPool);
+            m_table->updateTuple(*logrecord.getTupleAfterImage(), *logrecord.getTupleBeforeImage(), true);
+            m_stringPool.purge();
+            if (++replayed % 1000 == 0) {
+                commit();
+            }
+        }
+        int64_t elapsed = nowMicros() - start;
+        commit();
+        return (elapsed > 0) ? elapsed : 1;
+    }
+
+    /** Log the updates in one format and print the size and log/replay rates */
+    void report(const char *name, bool compact) {
+        FallbackSerializeOutput output;
+        char *buffer = new char[1024 * 1024];
+        output.initializeWithPosition(buffer, 1024 * 1024, 0);
+
+        int64_t start = nowMicros();
+        writeUpdates(output, compact);
+        int64_t elapsed = nowMicros() - start;
+        size_t length = output.position();
+        printf("%-16s %8.1f bytes/update %10.1f MB/s logged",
+               name, (double)length / numUpdates, (double)length / (double)(elapsed > 0 ? elapsed : 1));
+
+        // LogRecord keeps its images in VARBINARY columns, which trips the
+        // ValuePeeker asserts on the way back in, so only compact records replay here
+        if (compact) {
+            elapsed = replay(output.data(), length);
+            printf(" %10.1f MB/s %12.1f updates/sec replayed",
+                   (double)length / (double)elapsed, (double)numUpdates * 1000000.0 / (double)elapsed);
+        }
+        printf("\n");
+        delete[] buffer;
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_table;
+    TupleSchema *m_inputSchema;
+    Pool m_stringPool;
+    int64_t m_undoToken;
+};
+
+TEST_F(AriesLogRecordBench, UpdateRecords) {
+    printf("\n");
+    report("LogRecord", false);
+    report("CompactLogRecord", true);
+
+    ASSERT_FALSE(findTuple(0).isNullTuple());
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) numRows = atoi(argv[1]);
+    if (argc > 2) numUpdates = atoi(argv[2]);
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,237 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Replays the same ARIES log of inserts and updates over several tables with
+ * one thread and with a pool of threads, and prints the recovery time of
+ * each. Usage:
+ *
+ *   aries_recovery_bench [tables] [rows per table] [updates per table] [threads]
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/serializeio.h"
+#include "execution/VoltDBEngine.h"
+#include "logging/AriesReplayer.h"
+#include "logging/CompactLogrecord.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "indexes/tableindex.h"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace voltdb;
+
+static int numTables = 8;
+static int numRows = 20000;
+static int numUpdates = 20000;
+static int numThreads = 0;
+
+static int64_t nowMicros() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+class AriesRecoveryBench : public Test {
+public:
+    AriesRecoveryBench() : m_undoToken(0) {
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(1, 1, 0, 0, "");
+        m_engine->setUndoToken(m_undoToken);
+        if (numThreads <= 0) {
+            numThreads = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+        }
+    }
+
+    ~AriesRecoveryBench() {
+        deleteTables(m_tables);
+        delete m_engine;
+    }
+
+    void commit() {
+        m_engine->releaseUndoToken(m_undoToken);
+        m_engine->setUndoToken(++m_undoToken);
+    }
+
+    std::map<int32_t, Table*> createTables() {
+        std::string columnNames[] = { "ID", "C1", "C2", "BALANCE", "NAME", "DATA" };
+        std::map<int32_t, Table*> tables;
+        for (int id = 0; id < numTables; id++) {
+            std::vector<ValueType> types;
+            std::vector<int32_t> sizes;
+            std::vector<bool> allowNull;
+            types.push_back(VALUE_TYPE_BIGINT);
+            types.push_back(VALUE_TYPE_INTEGER);
+            types.push_back(VALUE_TYPE_INTEGER);
+            types.push_back(VALUE_TYPE_BIGINT);
+            types.push_back(VALUE_TYPE_VARCHAR);
+            types.push_back(VALUE_TYPE_VARCHAR);
+            for (int i = 0; i < 4; i++) {
+                sizes.push_back(NValue::getTupleStorageSize(types[i]));
+            }
+            sizes.push_back(32);
+            sizes.push_back(100);
+            for (int i = 0; i < 6; i++) {
+                allowNull.push_back(i != 0);
+            }
+            TupleSchema *schema = TupleSchema::createTupleSchema(types, sizes, allowNull, true);
+
+            std::vector<int32_t> keyColumns(1, 0);
+            std::vector<ValueType> keyTypes(1, VALUE_TYPE_BIGINT);
+            TableIndexScheme pkey("pkey", BALANCED_TREE_INDEX, keyColumns, keyTypes, true, false, schema);
+            std::vector<int32_t> c1Columns(1, 1);
+            std::vector<ValueType> c1Types(1, VALUE_TYPE_INTEGER);
+            std::vector<TableIndexScheme> indexes;
+            indexes.push_back(TableIndexScheme("c1", BALANCED_TREE_INDEX, c1Columns, c1Types, false, false, schema));
+
+            char name[16];
+            snprintf(name, sizeof(name), "T%d", id);
+            tables[id] = TableFactory::getPersistentTable(0, m_engine->getExecutorContext(), name,
+                                                          schema, columnNames, pkey, indexes, -1, false, false);
+        }
+        return tables;
+    }
+
+    void deleteTables(std::map<int32_t, Table*> &tables) {
+        for (std::map<int32_t, Table*>::iterator i = tables.begin(); i != tables.end(); i++) {
+            delete i->second;
+        }
+        tables.clear();
+    }
+
+    TableTuple findTuple(PersistentTable *table, int64_t id) {
+        TableIndex *pkey = table->primaryKeyIndex();
+        char keyData[64];
+        TableTuple key(keyData, pkey->getKeySchema());
+        key.setNValue(0, ValueFactory::getBigIntValue(id));
+        pkey->moveToKey(&key);
+        return pkey->nextValueAtKey();
+    }
+
+    /** Load every table and then update random rows, logging as the executors do */
+    void writeLog(FallbackSerializeOutput &output) {
+        m_tables = createTables();
+        NValue name = ValueFactory::getStringValue("customer name");
+        NValue data = ValueFactory::getStringValue(std::string(80, 'd'));
+        int64_t xid = 0;
+
+        for (int64_t id = 0; id < numRows; id++) {
+            for (int t = 0; t < numTables; t++) {
+                PersistentTable *table = static_cast<PersistentTable*>(m_tables[t]);
+                TableTuple &tuple = table->tempTuple();
+                tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+                tuple.setNValue(1, ValueFactory::getIntegerValue(static_cast<int32_t>(id % 100)));
+                tuple.setNValue(2, ValueFactory::getIntegerValue(static_cast<int32_t>(id)));
+                tuple.setNValue(3, ValueFactory::getBigIntValue(id * 10));
+                tuple.setNValue(4, name);
+                tuple.setNValue(5, data);
+                table->insertTuple(tuple);
+                CompactLogRecord logrecord(LogRecord::T_INSERT, LogRecord::T_FORWARD, output.position(), -1,
+                                           xid++, 0, t, NULL, NULL, NULL, &tuple);
+                logrecord.serializeTo(output);
+            }
+            if (id % 1000 == 0) {
+                commit();
+            }
+        }
+        name.free();
+        data.free();
+
+        std::vector<int32_t> modifiedCols(1, 3);
+        srand(1);
+        for (int i = 0; i < numUpdates; i++) {
+            for (int t = 0; t < numTables; t++) {
+                PersistentTable *table = static_cast<PersistentTable*>(m_tables[t]);
+                TableTuple target = findTuple(table, rand() % numRows);
+                TableTuple &update = table->getTempTupleInlined(target);
+                update.setNValue(3, ValueFactory::getBigIntValue(i));
+                CompactLogRecord logrecord(LogRecord::T_UPDATE, LogRecord::T_FORWARD, output.position(), -1,
+                                           xid++, 0, t, table->primaryKeyIndex(), &modifiedCols,
+                                           &target, &update);
+                logrecord.serializeTo(output);
+                table->updateTuple(update, target, true);
+            }
+            if (i % 1000 == 0) {
+                commit();
+            }
+        }
+        commit();
+    }
+
+    /** Recover fresh tables from the log and return the elapsed micros */
+    int64_t recover(const char *data, size_t length, int threads) {
+        std::map<int32_t, Table*> tables = createTables();
+        int64_t start = nowMicros();
+        AriesReplayer replayer(0, 0);
+        replayer.partition(data, length, tables);
+        int32_t replayed = replayer.replay(threads);
+        int64_t elapsed = nowMicros() - start;
+        elapsed = (elapsed > 0) ? elapsed : 1;
+
+        printf("%3d thread(s) %10.1f ms %12.1f records/sec\n", threads,
+               (double)elapsed / 1000.0, (double)replayed * 1000000.0 / (double)elapsed);
+        int64_t recoveredRows = tables[0]->activeTupleCount();
+        deleteTables(tables);
+        return (recoveredRows == numRows) ? elapsed : -1;
+    }
+
+    VoltDBEngine *m_engine;
+    std::map<int32_t, Table*> m_tables;
+    int64_t m_undoToken;
+};
+
+TEST_F(AriesRecoveryBench, ReplayThreads) {
+    FallbackSerializeOutput output;
+    char *buffer = new char[1024 * 1024];
+    output.initializeWithPosition(buffer, 1024 * 1024, 0);
+    writeLog(output);
+    printf("\n%d tables, %.1f MB of log\n", numTables, (double)output.position() / (1024.0 * 1024.0));
+
+    int64_t serial = recover(output.data(), output.position(), 1);
+    int64_t parallel = recover(output.data(), output.position(), numThreads);
+    ASSERT_TRUE(serial > 0);
+    ASSERT_TRUE(parallel > 0);
+    printf("speedup %.2fx\n", (double)serial / (double)parallel);
+    delete[] buffer;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) numTables = atoi(argv[1]);
+    if (argc > 2) numRows = atoi(argv[2]);
+    if (argc > 3) numUpdates = atoi(argv[3]);
+    if (argc > 4) numThreads = atoi(argv[4]);
+    return TestSuite::globalInstance()->runAll();
+}
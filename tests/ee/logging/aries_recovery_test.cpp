@@ -0,0 +1,515 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/serializeio.h"
+#include "execution/VoltDBEngine.h"
+#include "logging/AriesLogProxy.h"
+#include "logging/AriesReplayer.h"
+#include "logging/CompactLogrecord.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include "indexes/tableindex.h"
+#include "catalog/catalog.h"
+#include "catalog/cluster.h"
+#include "catalog/database.h"
+#include "catalog/table.h"
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace voltdb;
+
+#define NUM_TABLES 3
+#define LOG_BUFFER_SIZE (4 * 1024 * 1024)
+
+class AriesRecoveryTest : public Test {
+public:
+    AriesRecoveryTest() : m_xid(0) {
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(1, 1, 0, 0, "");
+        m_engine->setUndoToken(INT64_MIN + 1);
+
+        m_logBuffer = new char[LOG_BUFFER_SIZE];
+        m_log.initializeWithPosition(m_logBuffer, LOG_BUFFER_SIZE, 0);
+
+        for (int i = 0; i < NUM_TABLES; i++) {
+            // the last table has no primary key, so its records carry full before images
+            m_source[i] = createTable(i, i < NUM_TABLES - 1);
+            m_recovered[i] = createTable(i, i < NUM_TABLES - 1);
+            m_recoveredById[i] = m_recovered[i];
+        }
+    }
+
+    ~AriesRecoveryTest() {
+        // the source tables' undo actions point into them
+        m_engine->releaseUndoToken(INT64_MIN + 1);
+        for (int i = 0; i < NUM_TABLES; i++) {
+            delete m_source[i];
+            delete m_recovered[i];
+        }
+        delete[] m_logBuffer;
+        delete m_engine;
+    }
+
+    PersistentTable* createTable(int id, bool withPrimaryKey) {
+        std::string columnNames[] = { "ID", "GRP", "VAL", "NAME" };
+        std::vector<ValueType> types;
+        std::vector<int32_t> sizes;
+        std::vector<bool> allowNull;
+        types.push_back(VALUE_TYPE_BIGINT);
+        types.push_back(VALUE_TYPE_INTEGER);
+        types.push_back(VALUE_TYPE_BIGINT);
+        types.push_back(VALUE_TYPE_VARCHAR);
+        for (int i = 0; i < 3; i++) {
+            sizes.push_back(NValue::getTupleStorageSize(types[i]));
+        }
+        sizes.push_back(64);
+        for (int i = 0; i < 4; i++) {
+            allowNull.push_back(i != 0);
+        }
+        TupleSchema *schema = TupleSchema::createTupleSchema(types, sizes, allowNull, false);
+
+        char name[16];
+        snprintf(name, sizeof(name), "T%d", id);
+        if (!withPrimaryKey) {
+            return dynamic_cast<PersistentTable*>(
+                TableFactory::getPersistentTable(0, m_engine->getExecutorContext(), name,
+                                                 schema, columnNames, -1, false, false));
+        }
+
+        std::vector<int32_t> keyColumns(1, 0);
+        std::vector<ValueType> keyTypes(1, VALUE_TYPE_BIGINT);
+        TableIndexScheme pkey("pkey", BALANCED_TREE_INDEX, keyColumns, keyTypes, true, false, schema);
+
+        // a non-unique secondary index, to check it is rebuilt after runs of inserts
+        std::vector<int32_t> grpColumns(1, 1);
+        std::vector<ValueType> grpTypes(1, VALUE_TYPE_INTEGER);
+        std::vector<TableIndexScheme> indexes;
+        indexes.push_back(TableIndexScheme("grp", BALANCED_TREE_INDEX, grpColumns, grpTypes, false, false, schema));
+
+        return dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, m_engine->getExecutorContext(), name,
+                                             schema, columnNames, pkey, indexes, -1, false, false));
+    }
+
+    TableTuple findTuple(PersistentTable *table, int64_t id) {
+        TableIndex *pkey = table->primaryKeyIndex();
+        if (pkey == NULL) {
+            TableTuple tuple(table->schema());
+            TableIterator iterator(table);
+            while (iterator.next(tuple)) {
+                if (tuple.getNValue(0).compare(ValueFactory::getBigIntValue(id)) == 0) {
+                    return tuple;
+                }
+            }
+            return TableTuple(table->schema());
+        }
+        char keyData[64];
+        TableTuple key(keyData, pkey->getKeySchema());
+        key.setNValue(0, ValueFactory::getBigIntValue(id));
+        pkey->moveToKey(&key);
+        return pkey->nextValueAtKey();
+    }
+
+    /** Apply the change to the source table and log it like the executors do */
+    void insert(int table, int64_t id, int32_t grp, int64_t val) {
+        PersistentTable *source = m_source[table];
+        TableTuple &tuple = source->tempTuple();
+        tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+        tuple.setNValue(1, ValueFactory::getIntegerValue(grp));
+        tuple.setNValue(2, ValueFactory::getBigIntValue(val));
+        char name[32];
+        snprintf(name, sizeof(name), "row %lld", (long long) id);
+        NValue str = ValueFactory::getStringValue(name);
+        tuple.setNValue(3, str);
+        ASSERT_TRUE(source->insertTuple(tuple));
+
+        CompactLogRecord logrecord(LogRecord::T_INSERT, LogRecord::T_FORWARD, m_log.position(), -1,
+                                   m_xid++, 0, table, NULL, NULL, NULL, &tuple);
+        logrecord.serializeTo(m_log);
+        str.free();
+    }
+
+    void update(int table, int64_t id, int64_t val) {
+        PersistentTable *source = m_source[table];
+        TableTuple target = findTuple(source, id);
+        ASSERT_FALSE(target.isNullTuple());
+        TableTuple &update = source->getTempTupleInlined(target);
+        update.setNValue(2, ValueFactory::getBigIntValue(val));
+
+        std::vector<int32_t> modifiedCols(1, 2);
+        CompactLogRecord logrecord(LogRecord::T_UPDATE, LogRecord::T_FORWARD, m_log.position(), -1,
+                                   m_xid++, 0, table, source->primaryKeyIndex(), &modifiedCols,
+                                   &target, &update);
+        logrecord.serializeTo(m_log);
+        ASSERT_TRUE(source->updateTuple(update, target, true));
+    }
+
+    void remove(int table, int64_t id) {
+        PersistentTable *source = m_source[table];
+        TableTuple target = findTuple(source, id);
+        ASSERT_FALSE(target.isNullTuple());
+
+        CompactLogRecord logrecord(LogRecord::T_DELETE, LogRecord::T_FORWARD, m_log.position(), -1,
+                                   m_xid++, 0, table, source->primaryKeyIndex(), NULL, &target, NULL);
+        logrecord.serializeTo(m_log);
+        ASSERT_TRUE(source->deleteTuple(target, true));
+    }
+
+    /** A mix of insert runs, updates and deletes interleaved across the tables */
+    void writeWorkload(int rows) {
+        for (int64_t id = 0; id < rows; id++) {
+            for (int table = 0; table < NUM_TABLES; table++) {
+                insert(table, id, static_cast<int32_t>(id % 7), id);
+            }
+        }
+        for (int64_t id = 0; id < rows; id += 3) {
+            for (int table = 0; table < NUM_TABLES; table++) {
+                update(table, id, id * 100 + table);
+            }
+        }
+        for (int64_t id = 1; id < rows; id += 5) {
+            remove(static_cast<int>(id % NUM_TABLES), id);
+        }
+        for (int64_t id = rows; id < rows + 10; id++) {
+            insert(0, id, 3, -id);
+        }
+    }
+
+    void verify() {
+        for (int i = 0; i < NUM_TABLES; i++) {
+            PersistentTable *source = m_source[i];
+            PersistentTable *recovered = m_recovered[i];
+            ASSERT_EQ(source->activeTupleCount(), recovered->activeTupleCount());
+
+            TableTuple tuple(source->schema());
+            TableIterator iterator(source);
+            while (iterator.next(tuple)) {
+                int64_t id = ValuePeeker::peekAsBigInt(tuple.getNValue(0));
+                TableTuple copy = findTuple(recovered, id);
+                ASSERT_FALSE(copy.isNullTuple());
+                for (int col = 0; col < tuple.sizeInValues(); col++) {
+                    EXPECT_EQ(0, tuple.getNValue(col).compare(copy.getNValue(col)));
+                }
+            }
+
+            std::vector<TableIndex*> indexes = recovered->allIndexes();
+            for (size_t j = 0; j < indexes.size(); j++) {
+                EXPECT_EQ(static_cast<size_t>(recovered->activeTupleCount()), indexes[j]->getSize());
+            }
+        }
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_source[NUM_TABLES];
+    PersistentTable *m_recovered[NUM_TABLES];
+    std::map<int32_t, Table*> m_recoveredById;
+    char *m_logBuffer;
+    FallbackSerializeOutput m_log;
+    int64_t m_xid;
+};
+
+TEST_F(AriesRecoveryTest, RecoveryAppendsAreIndexedWhenFinished) {
+    PersistentTable *table = m_recovered[0];
+    TableTuple &tuple = table->tempTuple();
+    NValue str = ValueFactory::getStringValue("appended");
+    for (int64_t id = 0; id < 5000; id++) {
+        tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+        tuple.setNValue(1, ValueFactory::getIntegerValue(static_cast<int32_t>(id % 7)));
+        tuple.setNValue(2, ValueFactory::getBigIntValue(id));
+        tuple.setNValue(3, str);
+        table->appendTupleForRecovery(tuple);
+    }
+    str.free();
+
+    // nothing is visible until the run is finished
+    EXPECT_EQ(0, table->activeTupleCount());
+    table->finishRecoveryAppends();
+    EXPECT_EQ(5000, table->activeTupleCount());
+    EXPECT_EQ(5000, table->primaryKeyIndex()->getSize());
+    EXPECT_EQ(5000, table->index("grp")->getSize());
+    ASSERT_FALSE(findTuple(table, 4321).isNullTuple());
+    EXPECT_EQ(0, findTuple(table, 4321).getNValue(2).compare(ValueFactory::getBigIntValue(4321)));
+
+    // a second finish is a no-op
+    table->finishRecoveryAppends();
+    EXPECT_EQ(5000, table->activeTupleCount());
+}
+
+TEST_F(AriesRecoveryTest, ParallelReplayMatchesSource) {
+    writeWorkload(2000);
+
+    AriesReplayer replayer(0, 0);
+    ASSERT_EQ(0, replayer.partition(m_log.data(), m_log.position(), m_recoveredById));
+    EXPECT_EQ(NUM_TABLES, replayer.streamCount());
+    EXPECT_EQ(m_xid, replayer.replay(NUM_TABLES));
+    verify();
+}
+
+TEST_F(AriesRecoveryTest, SingleThreadReplayMatchesSource) {
+    writeWorkload(500);
+
+    AriesReplayer replayer(0, 0);
+    ASSERT_EQ(0, replayer.partition(m_log.data(), m_log.position(), m_recoveredById));
+    EXPECT_EQ(m_xid, replayer.replay(1));
+    verify();
+}
+
+TEST_F(AriesRecoveryTest, SkipsOldTransactionsAndOtherSites) {
+    insert(0, 1, 1, 1);
+    int64_t replayFrom = m_xid;
+    insert(0, 2, 1, 2);
+    insert(1, 3, 1, 3);
+
+    TableTuple &tuple = m_source[1]->tempTuple();
+    tuple.setNValue(0, ValueFactory::getBigIntValue(99));
+    tuple.setNValue(1, ValueFactory::getIntegerValue(1));
+    tuple.setNValue(2, ValueFactory::getBigIntValue(99));
+    tuple.setNValue(3, ValueFactory::getNullStringValue());
+    CompactLogRecord otherSite(LogRecord::T_INSERT, LogRecord::T_FORWARD, 0, -1, m_xid, 5, 1,
+                               NULL, NULL, NULL, &tuple);
+    otherSite.serializeTo(m_log);
+
+    AriesReplayer replayer(0, replayFrom);
+    ASSERT_EQ(0, replayer.partition(m_log.data(), m_log.position(), m_recoveredById));
+    EXPECT_EQ(2, replayer.replay(4));
+    EXPECT_TRUE(findTuple(m_recovered[0], 1).isNullTuple());
+    EXPECT_FALSE(findTuple(m_recovered[0], 2).isNullTuple());
+    EXPECT_FALSE(findTuple(m_recovered[1], 3).isNullTuple());
+    EXPECT_TRUE(findTuple(m_recovered[1], 99).isNullTuple());
+}
+
+TEST_F(AriesRecoveryTest, TornTailEndsTheLog) {
+    insert(0, 1, 1, 1);
+    insert(1, 2, 1, 2);
+    size_t complete = m_log.position();
+    insert(0, 3, 1, 3);
+
+    // the last record only made it halfway to disk
+    AriesReplayer replayer(0, 0);
+    ASSERT_EQ(0, replayer.partition(m_log.data(), complete + (m_log.position() - complete) / 2,
+                                    m_recoveredById));
+    EXPECT_EQ(2, replayer.replay(2));
+    EXPECT_EQ(1, m_recovered[0]->activeTupleCount());
+    EXPECT_EQ(1, m_recovered[1]->activeTupleCount());
+}
+
+TEST_F(AriesRecoveryTest, LegacyRecordsAreLeftToTheSerialReplay) {
+    insert(0, 1, 1, 1);
+
+    TableTuple &tuple = m_source[0]->tempTuple();
+    tuple.setNValue(0, ValueFactory::getBigIntValue(50));
+    tuple.setNValue(1, ValueFactory::getIntegerValue(1));
+    tuple.setNValue(2, ValueFactory::getBigIntValue(50));
+    tuple.setNValue(3, ValueFactory::getNullStringValue());
+    LogRecord legacy(0.0, LogRecord::T_INSERT, LogRecord::T_FORWARD, -1, m_xid++, 0, "T0",
+                     NULL, -1, NULL, NULL, &tuple);
+    legacy.serializeTo(m_log);
+    size_t serialLength = m_log.position();
+
+    insert(0, 2, 1, 2);
+    insert(1, 3, 1, 3);
+
+    // everything up to the LogRecord is the caller's, the streams start after it
+    AriesReplayer replayer(0, 0);
+    ASSERT_EQ(serialLength, replayer.partition(m_log.data(), m_log.position(), m_recoveredById));
+    EXPECT_EQ(2, replayer.streamCount());
+    EXPECT_EQ(2, replayer.replay(2));
+    EXPECT_TRUE(findTuple(m_recovered[0], 1).isNullTuple());
+    EXPECT_TRUE(findTuple(m_recovered[0], 50).isNullTuple());
+    EXPECT_FALSE(findTuple(m_recovered[0], 2).isNullTuple());
+    EXPECT_FALSE(findTuple(m_recovered[1], 3).isNullTuple());
+}
+
+#ifdef ARIES
+// the engine only reads and replays its log when it is built with ARIES
+/**
+ * Goes through the engine end to end: the log is written by an
+ * AriesLogProxy, read back by readAriesLogForReplay() and replayed by
+ * doAriesRecovery() into the catalog table it came from.
+ */
+class AriesEngineRecoveryTest : public Test {
+public:
+    AriesEngineRecoveryTest() : m_dir("/tmp/aries_engine_recovery_test"), m_xid(0) {
+        mkdir(m_dir.c_str(), 0755);
+        m_logFile = m_dir + "/" + AriesLogProxy::defaultLogfileName;
+        unlink(m_logFile.c_str());
+
+        std::string catalog =
+            "add / clusters cluster"
+            "\nadd /clusters[cluster] databases database"
+            "\nadd /clusters[cluster]/databases[database] programs program"
+            "\nadd /clusters[cluster]/databases[database] tables T"
+            "\nset /clusters[cluster]/databases[database]/tables[T] type 0"
+            "\nset /clusters[cluster]/databases[database]/tables[T] isreplicated false"
+            "\nset /clusters[cluster]/databases[database]/tables[T] partitioncolumn 0"
+            "\nset /clusters[cluster]/databases[database]/tables[T] estimatedtuplecount 0"
+            "\nadd /clusters[cluster]/databases[database]/tables[T] columns ID"
+            "\nset /clusters[cluster]/databases[database]/tables[T]/columns[ID] index 0"
+            "\nset /clusters[cluster]/databases[database]/tables[T]/columns[ID] type 6"
+            "\nset /clusters[cluster]/databases[database]/tables[T]/columns[ID] size 0"
+            "\nset /clusters[cluster]/databases[database]/tables[T]/columns[ID] nullable false"
+            "\nset /clusters[cluster]/databases[database]/tables[T]/columns[ID] name \"ID\""
+            "\nadd /clusters[cluster]/databases[database]/tables[T] columns VAL"
+            "\nset /clusters[cluster]/databases[database]/tables[T]/columns[VAL] index 1"
+            "\nset /clusters[cluster]/databases[database]/tables[T]/columns[VAL] type 6"
+            "\nset /clusters[cluster]/databases[database]/tables[T]/columns[VAL] size 0"
+            "\nset /clusters[cluster]/databases[database]/tables[T]/columns[VAL] nullable true"
+            "\nset /clusters[cluster]/databases[database]/tables[T]/columns[VAL] name \"VAL\"";
+
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(0, SITE_ID, 0, 0, "");
+        m_engine->loadCatalog(catalog);
+        m_engine->setARIESEnabled(true);
+        m_engine->setARIESDir(m_dir);
+        m_engine->setARIESFile(m_logFile);
+
+        m_tableId = m_engine->getCatalog()->clusters().get("cluster")->databases().get("database")
+            ->tables().get("T")->relativeIndex();
+        m_table = dynamic_cast<PersistentTable*>(m_engine->getTable(m_tableId));
+        m_proxy = AriesLogProxy::getAriesLogProxy(m_engine);
+    }
+
+    ~AriesEngineRecoveryTest() {
+        delete m_proxy;
+        delete m_engine;
+        unlink(m_logFile.c_str());
+        rmdir(m_dir.c_str());
+    }
+
+    TableTuple& row(int64_t id, int64_t val) {
+        TableTuple &tuple = m_table->tempTuple();
+        tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+        tuple.setNValue(1, ValueFactory::getBigIntValue(val));
+        return tuple;
+    }
+
+    void logCompactInsert(int64_t id, int64_t val) {
+        char buffer[256];
+        ReferenceSerializeOutput output(buffer, sizeof(buffer));
+        CompactLogRecord logrecord(LogRecord::T_INSERT, LogRecord::T_FORWARD, m_proxy->getAppendedLsn(), -1,
+                                   m_xid++, SITE_ID, m_tableId, NULL, NULL, NULL, &row(id, val));
+        logrecord.serializeTo(output);
+        m_proxy->logBinaryOutput(output.data(), output.position());
+    }
+
+    void logLegacyInsert(int64_t id, int64_t val) {
+        char buffer[1024];
+        ReferenceSerializeOutput output(buffer, sizeof(buffer));
+        LogRecord logrecord(0.0, LogRecord::T_INSERT, LogRecord::T_FORWARD, -1, m_xid++, SITE_ID, "T",
+                            NULL, -1, NULL, NULL, &row(id, val));
+        logrecord.serializeTo(output);
+        m_proxy->logBinaryOutput(output.data(), output.position());
+    }
+
+    /** Make the log durable, close it and replay it into the empty table */
+    void recover() {
+        m_proxy->flush();
+        delete m_proxy;
+        m_proxy = NULL;
+
+        int64_t size = 0;
+        char *logData = m_engine->readAriesLogForReplay(&size);
+        ASSERT_TRUE(logData != NULL);
+        m_engine->doAriesRecovery(logData, size, 0);
+        m_engine->freePointerToReplayLog(logData);
+    }
+
+    int64_t valueOf(int64_t id) {
+        TableTuple tuple(m_table->schema());
+        TableIterator iterator(m_table);
+        while (iterator.next(tuple)) {
+            if (ValuePeeker::peekAsBigInt(tuple.getNValue(0)) == id) {
+                return ValuePeeker::peekAsBigInt(tuple.getNValue(1));
+            }
+        }
+        return -1;
+    }
+
+    static const int32_t SITE_ID = 1;
+
+    std::string m_dir;
+    std::string m_logFile;
+    VoltDBEngine *m_engine;
+    AriesLogProxy *m_proxy;
+    PersistentTable *m_table;
+    int32_t m_tableId;
+    int64_t m_xid;
+};
+
+TEST_F(AriesEngineRecoveryTest, CompactRecordsAfterLegacyRecordsAreReplayed) {
+    ASSERT_TRUE(m_table != NULL);
+    ASSERT_TRUE(m_proxy != NULL);
+
+    // an older log continued by the compact format
+    logLegacyInsert(1, 10);
+    for (int64_t id = 2; id <= 5; id++) {
+        logCompactInsert(id, id * 10);
+    }
+    recover();
+
+    EXPECT_EQ(5, m_table->activeTupleCount());
+    for (int64_t id = 1; id <= 5; id++) {
+        EXPECT_EQ(id * 10, valueOf(id));
+    }
+}
+
+TEST_F(AriesEngineRecoveryTest, InterleavedLogRecordsReplayInOrder) {
+    ASSERT_TRUE(m_table != NULL);
+    ASSERT_TRUE(m_proxy != NULL);
+
+    // the serial part ends with the second LogRecord, the rest goes to the replayer
+    logLegacyInsert(1, 10);
+    logCompactInsert(2, 20);
+    logCompactInsert(3, 30);
+    logLegacyInsert(4, 40);
+    for (int64_t id = 5; id <= 20; id++) {
+        logCompactInsert(id, id * 10);
+    }
+    recover();
+
+    EXPECT_EQ(20, m_table->activeTupleCount());
+    for (int64_t id = 1; id <= 20; id++) {
+        EXPECT_EQ(id * 10, valueOf(id));
+    }
+}
+#endif
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,271 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/SerializableEEException.h"
+#include "common/crc32c.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/serializeio.h"
+#include "execution/VoltDBEngine.h"
+#include "logging/CompactLogrecord.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "indexes/tableindex.h"
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace voltdb;
+
+#define BUFFER_SIZE 4096
+
+class CompactLogRecordTest : public Test {
+public:
+    CompactLogRecordTest() : m_stringPool(16384, 1) {
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(1, 1, 0, 0, "");
+        m_engine->setUndoToken(INT64_MIN + 1);
+
+        std::string columnNames[] = { "ID", "A", "B", "NAME" };
+        std::vector<ValueType> types;
+        std::vector<int32_t> sizes;
+        std::vector<bool> allowNull;
+        types.push_back(VALUE_TYPE_BIGINT);
+        sizes.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        types.push_back(VALUE_TYPE_INTEGER);
+        sizes.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER));
+        types.push_back(VALUE_TYPE_BIGINT);
+        sizes.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        types.push_back(VALUE_TYPE_VARCHAR);
+        sizes.push_back(300);
+        for (int i = 0; i < 4; i++) {
+            allowNull.push_back(i != 0);
+        }
+        TupleSchema *schema = TupleSchema::createTupleSchema(types, sizes, allowNull, false);
+
+        std::vector<int32_t> keyColumns(1, 0);
+        std::vector<ValueType> keyTypes(1, VALUE_TYPE_BIGINT);
+        std::vector<int32_t> keySizes(1, NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        std::vector<bool> keyAllowNull(1, false);
+        TableIndexScheme pkey("pkey", BALANCED_TREE_INDEX, keyColumns, keyTypes, true, false, schema);
+        pkey.keySchema = TupleSchema::createTupleSchema(keyTypes, keySizes, keyAllowNull, false);
+
+        std::vector<TableIndexScheme> indexes;
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, m_engine->getExecutorContext(), "FOO",
+                                             schema, columnNames, pkey, indexes, -1, false, false));
+    }
+
+    ~CompactLogRecordTest() {
+        delete m_table;
+        delete m_engine;
+    }
+
+    TableTuple& makeTuple(int64_t id, int32_t a, int64_t b, const std::string &name) {
+        TableTuple &tuple = m_table->tempTuple();
+        tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+        tuple.setNValue(1, ValueFactory::getIntegerValue(a));
+        tuple.setNValue(2, ValueFactory::getBigIntValue(b));
+        NValue str = ValueFactory::getStringValue(name);
+        tuple.setNValue(3, str);
+        m_strings.push_back(str);
+        return tuple;
+    }
+
+    void freeStrings() {
+        for (size_t i = 0; i < m_strings.size(); i++) {
+            m_strings[i].free();
+        }
+        m_strings.clear();
+    }
+
+    size_t serialize(CompactLogRecord &logrecord) {
+        ReferenceSerializeOutput output(m_buffer, BUFFER_SIZE);
+        logrecord.serializeTo(output);
+        return output.position();
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_table;
+    Pool m_stringPool;
+    std::vector<NValue> m_strings;
+    char m_buffer[BUFFER_SIZE];
+};
+
+TEST_F(CompactLogRecordTest, Crc32cKnownValue) {
+    const char *data = "123456789";
+    EXPECT_EQ(0xE3069283, crc32cFinish(crc32cSarwate(crc32cInit(), data, 9)));
+    EXPECT_EQ(0xE3069283, crc32cComplete(data, 9));
+
+    // the detected implementation agrees with the table driven one on odd lengths
+    char buffer[1027];
+    for (int i = 0; i < (int)sizeof(buffer); i++) {
+        buffer[i] = static_cast<char>(i * 31);
+    }
+    for (size_t length = 0; length < sizeof(buffer); length += 13) {
+        EXPECT_EQ(crc32cSarwate(crc32cInit(), buffer + 1, length),
+                  crc32c(crc32cInit(), buffer + 1, length));
+    }
+}
+
+TEST_F(CompactLogRecordTest, Varints) {
+    uint64_t values[] = { 0, 1, 127, 128, 16383, 16384, 0xFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL };
+    ReferenceSerializeOutput output(m_buffer, BUFFER_SIZE);
+    for (int i = 0; i < 8; i++) {
+        CompactLogRecord::writeVarint(output, values[i]);
+    }
+    // small values take a single byte
+    EXPECT_EQ(1 + 1 + 1 + 2 + 2 + 3 + 5 + 10, output.position());
+
+    ReferenceSerializeInput input(m_buffer, output.position());
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(values[i], CompactLogRecord::readVarint(input));
+    }
+}
+
+TEST_F(CompactLogRecordTest, InsertRoundTrip) {
+    TableTuple &tuple = makeTuple(42, 7, -5, "forty-two");
+    CompactLogRecord out(LogRecord::T_INSERT, LogRecord::T_FORWARD, 1000, -1, 77, 3, 9,
+                         NULL, NULL, NULL, &tuple);
+    size_t length = serialize(out);
+    ASSERT_TRUE(CompactLogRecord::isCompactRecord(m_buffer, length));
+
+    ReferenceSerializeInput input(m_buffer, length);
+    CompactLogRecord in(input);
+    ASSERT_TRUE(in.isValidRecord());
+    EXPECT_EQ(0, input.numBytesNotYetRead());
+    EXPECT_EQ(LogRecord::T_INSERT, in.getType());
+    EXPECT_EQ(1000, in.getLsn());
+    EXPECT_EQ(77, in.getTransactionId());
+    EXPECT_EQ(3, in.getExecutionSiteId());
+    EXPECT_EQ(9, in.getTableId());
+
+    in.populateFields(m_table->schema(), m_table->primaryKeyIndex(), &m_stringPool);
+    ASSERT_TRUE(in.getTupleBeforeImage() == NULL);
+    TableTuple *after = in.getTupleAfterImage();
+    ASSERT_TRUE(after != NULL);
+    EXPECT_EQ(0, after->getNValue(0).compare(ValueFactory::getBigIntValue(42)));
+    EXPECT_EQ(0, after->getNValue(1).compare(ValueFactory::getIntegerValue(7)));
+    EXPECT_EQ(0, after->getNValue(2).compare(ValueFactory::getBigIntValue(-5)));
+    EXPECT_EQ(0, after->getNValue(3).compare(tuple.getNValue(3)));
+    freeStrings();
+}
+
+TEST_F(CompactLogRecordTest, UpdateLogsKeyAndModifiedColumns) {
+    ASSERT_TRUE(m_table->insertTuple(makeTuple(1, 10, 100, "one")));
+    freeStrings();
+
+    TableTuple target(m_table->schema());
+    TableIndex *pkey = m_table->primaryKeyIndex();
+    TableTuple key(pkey->getKeySchema());
+    char keyData[64];
+    key.move(keyData);
+    key.setNValue(0, ValueFactory::getBigIntValue(1));
+    ASSERT_TRUE(pkey->moveToKey(&key));
+    target = pkey->nextValueAtKey();
+
+    TableTuple &update = m_table->getTempTupleInlined(target);
+    update.setNValue(2, ValueFactory::getBigIntValue(200));
+    std::vector<int32_t> modifiedCols(1, 2);
+
+    CompactLogRecord full(LogRecord::T_UPDATE, LogRecord::T_FORWARD, 0, -1, 1, 0, 0,
+                          NULL, NULL, &target, &update);
+    size_t fullLength = serialize(full);
+    CompactLogRecord delta(LogRecord::T_UPDATE, LogRecord::T_FORWARD, 0, -1, 1, 0, 0,
+                           pkey, &modifiedCols, &target, &update);
+    size_t deltaLength = serialize(delta);
+    EXPECT_TRUE(deltaLength < fullLength / 2);
+
+    ReferenceSerializeInput input(m_buffer, deltaLength);
+    CompactLogRecord in(input);
+    ASSERT_TRUE(in.isValidRecord());
+    in.populateFields(m_table->schema(), pkey, &m_stringPool);
+
+    // the before image is the live tuple found through the primary key
+    ASSERT_TRUE(in.getTupleBeforeImage() != NULL);
+    EXPECT_EQ(target.address(), in.getTupleBeforeImage()->address());
+
+    TableTuple *after = in.getTupleAfterImage();
+    ASSERT_TRUE(after != NULL);
+    EXPECT_EQ(0, after->getNValue(0).compare(ValueFactory::getBigIntValue(1)));
+    EXPECT_EQ(0, after->getNValue(1).compare(ValueFactory::getIntegerValue(10)));
+    EXPECT_EQ(0, after->getNValue(2).compare(ValueFactory::getBigIntValue(200)));
+    EXPECT_EQ(0, after->getNValue(3).compare(target.getNValue(3)));
+}
+
+TEST_F(CompactLogRecordTest, CorruptRecordIsInvalid) {
+    TableTuple &tuple = makeTuple(5, 1, 2, "five");
+    CompactLogRecord out(LogRecord::T_INSERT, LogRecord::T_FORWARD, 0, -1, 1, 0, 0,
+                         NULL, NULL, NULL, &tuple);
+    size_t length = serialize(out);
+    freeStrings();
+
+    m_buffer[length - 3] ^= 0x10;
+    ReferenceSerializeInput input(m_buffer, length);
+    CompactLogRecord in(input);
+    EXPECT_FALSE(in.isValidRecord());
+
+    // old style records start with a positive size
+    int32_t oldStyle = htonl(120);
+    memcpy(m_buffer, &oldStyle, sizeof(oldStyle));
+    EXPECT_FALSE(CompactLogRecord::isCompactRecord(m_buffer, length));
+}
+
+TEST_F(CompactLogRecordTest, TruncatedFrameThrows) {
+    TableTuple &tuple = makeTuple(6, 1, 2, "six");
+    CompactLogRecord out(LogRecord::T_INSERT, LogRecord::T_FORWARD, 0, -1, 1, 0, 0,
+                         NULL, NULL, NULL, &tuple);
+    size_t length = serialize(out);
+    freeStrings();
+
+    // the payload length promises more than the buffer holds
+    bool thrown = false;
+    try {
+        ReferenceSerializeInput input(m_buffer, length - 1);
+        CompactLogRecord in(input);
+    } catch (SerializableEEException &e) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+
+    // so does a buffer that cannot even hold the frame header
+    thrown = false;
+    try {
+        ReferenceSerializeInput input(m_buffer, CompactLogRecord::FRAME_HEADER_SIZE - 1);
+        CompactLogRecord in(input);
+    } catch (SerializableEEException &e) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
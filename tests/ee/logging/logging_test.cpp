@@ -24,8 +24,12 @@
 #include "harness.h"
 #include "logging/LogManager.h"
 #include "logging/LogProxy.h"
+#include "logging/AriesLogProxy.h"
 #include "execution/VoltDBEngine.h"
+#include "common/FatalException.hpp"
 #include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 voltdb::LoggerId loggerIds[] = {
         voltdb::LOGGERID_SQL,
@@ -132,6 +136,171 @@ TEST_F(LoggingTest, TestLoggerUsesProxyLevels) {
     }
 }
 
+class AriesGroupCommitTest : public Test {
+    public:
+        AriesGroupCommitTest() : m_logFile("/tmp/aries_groupcommit_test.log") {
+            unlink(m_logFile.c_str());
+            m_engine = new voltdb::VoltDBEngine();
+            m_engine->setARIESEnabled(true);
+            m_engine->setARIESFile(m_logFile);
+        }
+        ~AriesGroupCommitTest() {
+            delete m_engine;
+            unlink(m_logFile.c_str());
+        }
+
+        int64_t fileSize() {
+            struct stat st;
+            if (stat(m_logFile.c_str(), &st) != 0) return -1;
+            return st.st_size;
+        }
+
+        // the flusher runs on its own thread, give it a few seconds
+        bool becomesDurable(voltdb::AriesLogProxy *proxy, int64_t lsn) {
+            for (int ii = 0; ii < 5000; ii++) {
+                if (proxy->getDurableLsn() >= lsn) return true;
+                usleep(1000);
+            }
+            return false;
+        }
+
+        std::string m_logFile;
+        voltdb::VoltDBEngine *m_engine;
+};
+
+TEST_F(AriesGroupCommitTest, BatchesByRecordCount) {
+    voltdb::AriesLogProxy *proxy = voltdb::AriesLogProxy::getAriesLogProxy(m_engine);
+    ASSERT_TRUE(proxy != NULL);
+    proxy->setGroupCommitPolicy(1 << 20, 4, INT64_MAX, false);
+
+    const char record[] = "0123456789";
+    for (int ii = 0; ii < 10; ii++) {
+        proxy->logBinaryOutput(record, sizeof(record));
+        proxy->commit();
+        if (ii % 4 == 3) {
+            // a batch that fills up while another one is being written
+            // just grows, so let each one land before starting the next
+            ASSERT_TRUE(becomesDurable(proxy, (ii + 1) * sizeof(record)));
+        }
+    }
+    // 10 records in batches of 4, the last two are still buffered
+    ASSERT_EQ(10 * sizeof(record), proxy->getAppendedLsn());
+    usleep(10000);
+    ASSERT_EQ(8 * sizeof(record), proxy->getDurableLsn());
+    ASSERT_EQ(2, proxy->getSyncCount());
+    ASSERT_EQ(8 * sizeof(record), fileSize());
+
+    proxy->flush();
+    ASSERT_EQ(proxy->getAppendedLsn(), proxy->getDurableLsn());
+    ASSERT_EQ(3, proxy->getSyncCount());
+
+    // nothing new to sync
+    proxy->flush();
+    proxy->waitForDurableLsn(proxy->getAppendedLsn());
+    ASSERT_EQ(3, proxy->getSyncCount());
+    delete proxy;
+    ASSERT_EQ(10 * sizeof(record), fileSize());
+}
+
+TEST_F(AriesGroupCommitTest, BatchesByInterval) {
+    voltdb::AriesLogProxy *proxy = voltdb::AriesLogProxy::getAriesLogProxy(m_engine);
+    ASSERT_TRUE(proxy != NULL);
+    proxy->setGroupCommitPolicy(1 << 20, 1000, 20000, false);
+
+    const char record[] = "abcdefgh";
+    for (int ii = 0; ii < 5; ii++) {
+        proxy->logBinaryOutput(record, sizeof(record));
+        proxy->commit();
+    }
+    // nobody forces the batch out, the interval closes it
+    ASSERT_TRUE(becomesDurable(proxy, 5 * sizeof(record)));
+    ASSERT_EQ(1, proxy->getSyncCount());
+    ASSERT_EQ(5 * sizeof(record), fileSize());
+    delete proxy;
+}
+
+TEST_F(AriesGroupCommitTest, SyncOnCommit) {
+    voltdb::AriesLogProxy *proxy = voltdb::AriesLogProxy::getAriesLogProxy(m_engine);
+    ASSERT_TRUE(proxy != NULL);
+
+    const char record[] = "abcdefgh";
+    for (int txn = 0; txn < 5; txn++) {
+        // several records per txn, the commit waits for the shared flush
+        for (int ii = 0; ii < 3; ii++) {
+            proxy->logBinaryOutput(record, sizeof(record));
+        }
+        proxy->commit();
+        ASSERT_EQ(proxy->getAppendedLsn(), proxy->getDurableLsn());
+    }
+    ASSERT_TRUE(proxy->getSyncCount() <= 5);
+    ASSERT_EQ(15 * sizeof(record), fileSize());
+
+    // read-only txns don't touch the disk
+    int64_t syncs = proxy->getSyncCount();
+    proxy->commit();
+    ASSERT_EQ(syncs, proxy->getSyncCount());
+    delete proxy;
+
+    // LSNs pick up at the end of an existing log
+    proxy = voltdb::AriesLogProxy::getAriesLogProxy(m_engine);
+    ASSERT_EQ(15 * sizeof(record), proxy->getDurableLsn());
+    proxy->setUseDSync(true);
+    proxy->logBinaryOutput(record, sizeof(record));
+    proxy->commit();
+    ASSERT_EQ(16 * sizeof(record), proxy->getDurableLsn());
+    delete proxy;
+    ASSERT_EQ(16 * sizeof(record), fileSize());
+}
+
+TEST_F(AriesGroupCommitTest, LargeRecords) {
+    voltdb::AriesLogProxy *proxy = voltdb::AriesLogProxy::getAriesLogProxy(m_engine);
+    ASSERT_TRUE(proxy != NULL);
+    proxy->setGroupCommitPolicy(1 << 20, 1000, INT64_MAX, false);
+
+    // spans more than both buffers
+    size_t bigSize = 2 * voltdb::MinimalBuffer::BUFFER_SIZE + 100;
+    char *big = new char[bigSize];
+    memset(big, 'x', bigSize);
+    proxy->logBinaryOutput("small", 5);
+    proxy->logBinaryOutput(big, bigSize);
+    proxy->logBinaryOutput("small", 5);
+    delete [] big;
+
+    ASSERT_EQ(10 + bigSize, proxy->getAppendedLsn());
+    proxy->flush();
+    ASSERT_EQ(10 + bigSize, proxy->getDurableLsn());
+    ASSERT_EQ(10 + bigSize, fileSize());
+    delete proxy;
+}
+
+TEST_F(AriesGroupCommitTest, WriteErrorIsFatal) {
+    m_engine->setARIESFile("/dev/full");
+    voltdb::AriesLogProxy *proxy = voltdb::AriesLogProxy::getAriesLogProxy(m_engine);
+    ASSERT_TRUE(proxy != NULL);
+
+    proxy->logBinaryOutput("lost", 4);
+    bool thrown = false;
+    try {
+        proxy->commit();
+    } catch (voltdb::FatalException &e) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+    ASSERT_EQ(0, proxy->getDurableLsn());
+    ASSERT_EQ(0, proxy->getSyncCount());
+
+    // the failure sticks, later records are refused as well
+    thrown = false;
+    try {
+        proxy->logBinaryOutput("lost", 4);
+    } catch (voltdb::FatalException &e) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+    ASSERT_EQ(0, proxy->getDurableLsn());
+    delete proxy;
+}
+
 int main() {
     return TestSuite::globalInstance()->runAll();
 }
@@ -0,0 +1,268 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/tabletuple.h"
+#include "execution/VoltDBEngine.h"
+#include "expressions/expressions.h"
+#include "expressions/expressionutil.h"
+#include "storage/ColumnarBlocks.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace voltdb;
+
+#define NUM_TUPLES 20000
+
+class ColumnarBlocksTest : public Test {
+public:
+    ColumnarBlocksTest() {
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(1, 1, 0, 0, "");
+        m_engine->setUndoToken(INT64_MIN + 1);
+
+        std::string columnNames[] = { "ID", "QTY", "AMOUNT", "PRICE", "STAMP", "NAME" };
+        std::vector<ValueType> types;
+        types.push_back(VALUE_TYPE_BIGINT);
+        types.push_back(VALUE_TYPE_TINYINT);
+        types.push_back(VALUE_TYPE_INTEGER);
+        types.push_back(VALUE_TYPE_DOUBLE);
+        types.push_back(VALUE_TYPE_TIMESTAMP);
+        types.push_back(VALUE_TYPE_VARCHAR);
+        std::vector<int32_t> sizes;
+        for (int i = 0; i < 5; i++) {
+            sizes.push_back(NValue::getTupleStorageSize(types[i]));
+        }
+        sizes.push_back(32);
+        std::vector<bool> allowNull(6, true);
+        allowNull[0] = false;
+        TupleSchema *schema = TupleSchema::createTupleSchema(types, sizes, allowNull, true);
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, m_engine->getExecutorContext(), "ITEMS",
+                                             schema, columnNames, -1, false, false));
+    }
+
+    ~ColumnarBlocksTest() {
+        m_engine->releaseUndoToken(INT64_MIN + 1);
+        delete m_table;
+        delete m_engine;
+    }
+
+    /** Every seventh tuple has a null QTY and PRICE */
+    void insert(int64_t id) {
+        TableTuple &tuple = m_table->tempTuple();
+        tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+        if (id % 7 == 0) {
+            tuple.setNValue(1, NValue::getNullValue(VALUE_TYPE_TINYINT));
+            tuple.setNValue(3, NValue::getNullValue(VALUE_TYPE_DOUBLE));
+        } else {
+            tuple.setNValue(1, ValueFactory::getTinyIntValue(static_cast<int8_t>(id % 100)));
+            tuple.setNValue(3, ValueFactory::getDoubleValue(static_cast<double>(id) / 4.0));
+        }
+        tuple.setNValue(2, ValueFactory::getIntegerValue(static_cast<int32_t>(id * 3)));
+        tuple.setNValue(4, ValueFactory::getTimestampValue(id * 1000));
+        NValue name = ValueFactory::getStringValue("name");
+        tuple.setNValue(5, name);
+        ASSERT_TRUE(m_table->insertTuple(tuple));
+        name.free();
+    }
+
+    TableTuple find(int64_t id) {
+        TableTuple tuple(m_table->schema());
+        TableIterator iterator(m_table);
+        while (iterator.next(tuple)) {
+            if (ValuePeeker::peekBigInt(tuple.getNValue(0)) == id) {
+                return tuple;
+            }
+        }
+        return TableTuple(m_table->schema());
+    }
+
+    /**
+     * Walk the table a batch at a time and check each live tuple's
+     * minipage values against its row. Returns the live tuples seen.
+     */
+    int64_t checkMinipages() {
+        ColumnarBlocks *columns = m_table->getColumnarBlocks();
+        columns->sync();
+        char *tuples[EXPRESSION_BATCH_SIZE];
+        int slots[EXPRESSION_BATCH_SIZE];
+        size_t block = 0;
+        int slot = 0;
+        int64_t seen = 0;
+        TableTuple tuple(m_table->schema());
+        int count;
+        while ((count = columns->nextBatch(block, slot, tuples, slots, EXPRESSION_BATCH_SIZE)) > 0) {
+            for (int i = 0; i < count; i++) {
+                tuple.move(tuples[i]);
+                EXPECT_TRUE(tuple.isActive());
+                EXPECT_EQ(tuples[i], columns->tupleAddress(block, slots[i]));
+                EXPECT_EQ(1, columns->live(block)[slots[i]]);
+                for (int column = 0; column < 3; column++) {
+                    const NValue value = tuple.getNValue(column);
+                    const int64_t expected = value.isNull() ? INT64_NULL : ValuePeeker::peekAsBigInt(value);
+                    EXPECT_EQ(expected, columns->bigInts(block, column)[slots[i]]);
+                }
+                const NValue price = tuple.getNValue(3);
+                const double expected = price.isNull() ? DOUBLE_MIN : ValuePeeker::peekDouble(price);
+                EXPECT_EQ(expected, columns->doubles(block, 3)[slots[i]]);
+                EXPECT_EQ(ValuePeeker::peekTimestamp(tuple.getNValue(4)), columns->bigInts(block, 4)[slots[i]]);
+            }
+            seen += count;
+        }
+        return seen;
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_table;
+};
+
+TEST_F(ColumnarBlocksTest, Layout) {
+    ASSERT_TRUE(m_table->setColumnarLayout(true));
+    ColumnarBlocks *columns = m_table->getColumnarBlocks();
+    ASSERT_TRUE(columns != NULL);
+    for (int column = 0; column < 5; column++) {
+        ASSERT_TRUE(columns->hasColumn(column));
+        ASSERT_EQ(column == 3, columns->isDouble(column));
+    }
+    ASSERT_FALSE(columns->hasColumn(5));
+
+    ASSERT_TRUE(m_table->setColumnarLayout(false));
+    ASSERT_TRUE(m_table->getColumnarBlocks() == NULL);
+}
+
+TEST_F(ColumnarBlocksTest, MinipagesFollowWrites) {
+#ifndef MEMCHECK_NOFREELIST
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        insert(id);
+    }
+    ASSERT_TRUE(m_table->setColumnarLayout(true));
+    ASSERT_EQ(NUM_TUPLES, checkMinipages());
+
+    // an update is seen by the next scan
+    TableTuple target = find(42);
+    ASSERT_FALSE(target.isNullTuple());
+    TableTuple &source = m_table->tempTuple();
+    source.copy(target);
+    source.setNValue(2, ValueFactory::getIntegerValue(-5));
+    source.setNValue(3, NValue::getNullValue(VALUE_TYPE_DOUBLE));
+    ASSERT_TRUE(m_table->updateTuple(source, target, true));
+    ASSERT_EQ(NUM_TUPLES, checkMinipages());
+
+    // as are deletes, and inserts into the slots they free
+    for (int64_t id = 100; id < 200; id++) {
+        TableTuple tuple = find(id);
+        ASSERT_TRUE(m_table->deleteTuple(tuple, true));
+    }
+    ASSERT_EQ(NUM_TUPLES - 100, checkMinipages());
+    for (int64_t id = NUM_TUPLES; id < NUM_TUPLES + 300; id++) {
+        insert(id);
+    }
+    ASSERT_EQ(NUM_TUPLES + 200, checkMinipages());
+#endif
+}
+
+TEST_F(ColumnarBlocksTest, OnlyStaleBlocksAreRebuilt) {
+#ifndef MEMCHECK_NOFREELIST
+    // a few blocks' worth, NUM_TUPLES fit into one
+    int64_t numTuples = 0;
+    while (static_cast<const Table*>(m_table)->allocatedBlockCount() < 3) {
+        insert(numTuples++);
+    }
+    ASSERT_TRUE(m_table->setColumnarLayout(true));
+    ColumnarBlocks *columns = m_table->getColumnarBlocks();
+    const int64_t blocks = static_cast<int64_t>(static_cast<const Table*>(m_table)->allocatedBlockCount());
+    ASSERT_TRUE(blocks > 1);
+
+    checkMinipages();
+    ASSERT_EQ(blocks, columns->getBlocksRebuilt());
+    checkMinipages();
+    ASSERT_EQ(blocks, columns->getBlocksRebuilt());
+
+    // a write to one block only rebuilds that block
+    TableTuple tuple = find(numTuples / 2);
+    ASSERT_TRUE(m_table->deleteTuple(tuple, true));
+    checkMinipages();
+    ASSERT_EQ(blocks + 1, columns->getBlocksRebuilt());
+#endif
+}
+
+TEST_F(ColumnarBlocksTest, ComparisonsReadMinipages) {
+#ifndef MEMCHECK_NOFREELIST
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        insert(id);
+    }
+    ASSERT_TRUE(m_table->setColumnarLayout(true));
+    ColumnarBlocks *columns = m_table->getColumnarBlocks();
+    columns->sync();
+
+    std::auto_ptr<AbstractExpression> predicate(
+        conjunctionFactory(EXPRESSION_TYPE_CONJUNCTION_OR,
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_LESSTHAN,
+                              new TupleValueExpression(1, "ITEMS", "QTY"),
+                              constantValueFactory(ValueFactory::getIntegerValue(10))),
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_GREATERTHAN,
+                              new TupleValueExpression(3, "ITEMS", "PRICE"),
+                              constantValueFactory(ValueFactory::getBigIntValue(4000)))));
+
+    // the same tuples have to pass with and without the minipages
+    char *tuples[EXPRESSION_BATCH_SIZE];
+    int slots[EXPRESSION_BATCH_SIZE];
+    int rows[EXPRESSION_BATCH_SIZE];
+    int minipages[EXPRESSION_BATCH_SIZE];
+    ColumnarBatch batch = { columns, 0, slots };
+    int slot = 0;
+    int64_t matches = 0;
+    int count;
+    while ((count = columns->nextBatch(batch.block, slot, tuples, slots, EXPRESSION_BATCH_SIZE)) > 0) {
+        for (int i = 0; i < count; i++) {
+            rows[i] = minipages[i] = i;
+        }
+        int rowCount = predicate->evalBatch(m_table->schema(), tuples, rows, count);
+        int minipageCount = predicate->evalBatch(m_table->schema(), tuples, minipages, count, &batch);
+        ASSERT_EQ(rowCount, minipageCount);
+        for (int i = 0; i < rowCount; i++) {
+            ASSERT_EQ(rows[i], minipages[i]);
+        }
+        matches += rowCount;
+    }
+    ASSERT_TRUE(matches > 0);
+    ASSERT_TRUE(matches < NUM_TUPLES);
+#endif
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,290 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Scans and aggregates a wide table the way SeqScanExecutor and
+ * AggregateExecutor do, once over the rows and once over the minipages
+ * of its columnar layout, and prints the rows per second of each. The
+ * scans run on a single thread, so the numbers are per core. Usage:
+ *
+ *   columnar_scan_bench [rows] [scans]
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/tabletuple.h"
+#include "execution/VoltDBEngine.h"
+#include "executors/executors.h"
+#include "expressions/expressions.h"
+#include "expressions/expressionutil.h"
+#include "storage/ColumnarBlocks.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/time.h>
+
+using namespace voltdb;
+
+#define NUM_PADS 8
+
+static int numRows = 500000;
+static int numScans = 10;
+
+static int64_t nowMicros() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+class ColumnarScanBench : public Test {
+public:
+    ColumnarScanBench() {
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(1, 1, 0, 0, "");
+        m_engine->setUndoToken(INT64_MIN + 1);
+
+        // the inlined pads make each tuple about half a kilobyte wide
+        std::vector<std::string> columnNames;
+        std::vector<ValueType> types;
+        std::vector<int32_t> sizes;
+        columnNames.push_back("ID");
+        types.push_back(VALUE_TYPE_BIGINT);
+        columnNames.push_back("QUANTITY");
+        types.push_back(VALUE_TYPE_INTEGER);
+        columnNames.push_back("PRICE");
+        types.push_back(VALUE_TYPE_DOUBLE);
+        for (int i = 0; i < 3; i++) {
+            sizes.push_back(NValue::getTupleStorageSize(types[i]));
+        }
+        for (int i = 0; i < NUM_PADS; i++) {
+            char name[16];
+            snprintf(name, sizeof(name), "PAD%d", i);
+            columnNames.push_back(name);
+            types.push_back(VALUE_TYPE_VARCHAR);
+            sizes.push_back(60);
+        }
+        std::vector<bool> allowNull(types.size(), true);
+        TupleSchema *schema = TupleSchema::createTupleSchema(types, sizes, allowNull, true);
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, m_engine->getExecutorContext(), "ITEMS",
+                                             schema, &columnNames[0], -1, false, false));
+
+        NValue pad = ValueFactory::getStringValue("padding that is never read by the scans");
+        TableTuple &tuple = m_table->tempTuple();
+        for (int i = 0; i < NUM_PADS; i++) {
+            tuple.setNValue(3 + i, pad);
+        }
+        srand(1);
+        for (int64_t id = 0; id < numRows; id++) {
+            tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+            tuple.setNValue(1, ValueFactory::getIntegerValue(rand() % 100));
+            tuple.setNValue(2, ValueFactory::getDoubleValue((rand() % 10000) / 100.0));
+            m_table->insertTuple(tuple);
+        }
+        pad.free();
+    }
+
+    ~ColumnarScanBench() {
+        m_engine->releaseUndoToken(INT64_MIN + 1);
+        delete m_table;
+        delete m_engine;
+    }
+
+    /** Count the matches a batch of rows at a time, as SeqScanExecutor does */
+    int64_t scanRows(const AbstractExpression *predicate) {
+        char *batch[EXPRESSION_BATCH_SIZE];
+        int selection[EXPRESSION_BATCH_SIZE];
+        int64_t matches = 0;
+        TableTuple tuple(m_table->schema());
+        TableIterator iterator(m_table);
+        while (true) {
+            int count = 0;
+            while (count < EXPRESSION_BATCH_SIZE && iterator.next(tuple)) {
+                batch[count++] = tuple.address();
+            }
+            if (count == 0) {
+                break;
+            }
+            for (int i = 0; i < count; i++) {
+                selection[i] = i;
+            }
+            matches += predicate->evalBatch(m_table->schema(), batch, selection, count);
+        }
+        return matches;
+    }
+
+    /** Count the matches a batch of a block's minipages at a time */
+    int64_t scanColumns(const AbstractExpression *predicate) {
+        ColumnarBlocks *columns = m_table->getColumnarBlocks();
+        char *batch[EXPRESSION_BATCH_SIZE];
+        int selection[EXPRESSION_BATCH_SIZE];
+        int slots[EXPRESSION_BATCH_SIZE];
+        ColumnarBatch columnarBatch = { columns, 0, slots };
+        int slot = 0;
+        int64_t matches = 0;
+        columns->sync();
+        int count;
+        while ((count = columns->nextBatch(columnarBatch.block, slot, batch, slots, EXPRESSION_BATCH_SIZE)) > 0) {
+            for (int i = 0; i < count; i++) {
+                selection[i] = i;
+            }
+            matches += predicate->evalBatch(m_table->schema(), batch, selection, count, &columnarBatch);
+        }
+        return matches;
+    }
+
+    /** SUM and MAX of a column a tuple at a time, as AggregateExecutor does */
+    NValue aggregateRows(ExpressionType type, int column) {
+        SumAgg sum;
+        MaxAgg max;
+        Agg *agg = (type == EXPRESSION_TYPE_AGGREGATE_SUM) ? static_cast<Agg*>(&sum) : &max;
+        TableTuple tuple(m_table->schema());
+        TableIterator iterator(m_table);
+        while (iterator.next(tuple)) {
+            agg->advance(tuple.getNValue(column));
+        }
+        return agg->finalize();
+    }
+
+    /** The same a minipage at a time, as AggregateExecutor does for a columnar table */
+    NValue aggregateColumns(ExpressionType type, int column) {
+        ColumnarBlocks *columns = m_table->getColumnarBlocks();
+        int64_t count = 0;
+        bool seen = false;
+        int64_t bigInt = 0;
+        double dbl = 0;
+        const size_t blocks = columns->sync();
+        for (size_t block = 0; block < blocks; block++) {
+            const int slots = columns->refresh(block);
+            if (columns->isDouble(column)) {
+                accumulateMinipage(type, columns->doubles(block, column), slots, count, seen, dbl);
+            } else {
+                accumulateMinipage(type, columns->bigInts(block, column), slots, count, seen, bigInt);
+            }
+        }
+        if (columns->isDouble(column)) {
+            return ValueFactory::getDoubleValue(dbl);
+        }
+        return (type == EXPRESSION_TYPE_AGGREGATE_SUM) ? ValueFactory::getBigIntValue(bigInt) :
+                                                         ValueFactory::getIntegerValue(static_cast<int32_t>(bigInt));
+    }
+
+    void report(const char *label, int64_t rowMicros, int64_t columnMicros) {
+        double rows = static_cast<double>(numRows) * numScans * 1000000.0;
+        printf("%-28s rows %12.0f rows/sec/core  minipages %12.0f rows/sec/core  %.2fx\n", label,
+               rows / static_cast<double>(rowMicros), rows / static_cast<double>(columnMicros),
+               static_cast<double>(rowMicros) / static_cast<double>(columnMicros));
+    }
+
+    void measureScan(const char *label, AbstractExpression *predicate) {
+        std::auto_ptr<AbstractExpression> owner(predicate);
+        int64_t rowMatches = 0;
+        int64_t columnMatches = 0;
+        int64_t start = nowMicros();
+        for (int i = 0; i < numScans; i++) {
+            rowMatches = scanRows(predicate);
+        }
+        int64_t rowMicros = std::max(nowMicros() - start, static_cast<int64_t>(1));
+        start = nowMicros();
+        for (int i = 0; i < numScans; i++) {
+            columnMatches = scanColumns(predicate);
+        }
+        int64_t columnMicros = std::max(nowMicros() - start, static_cast<int64_t>(1));
+        report(label, rowMicros, columnMicros);
+        ASSERT_EQ(rowMatches, columnMatches);
+    }
+
+    void measureAggregate(const char *label, ExpressionType type, int column) {
+        NValue rowResult;
+        NValue columnResult;
+        int64_t start = nowMicros();
+        for (int i = 0; i < numScans; i++) {
+            rowResult = aggregateRows(type, column);
+        }
+        int64_t rowMicros = std::max(nowMicros() - start, static_cast<int64_t>(1));
+        start = nowMicros();
+        for (int i = 0; i < numScans; i++) {
+            columnResult = aggregateColumns(type, column);
+        }
+        int64_t columnMicros = std::max(nowMicros() - start, static_cast<int64_t>(1));
+        report(label, rowMicros, columnMicros);
+        ASSERT_TRUE(rowResult.op_equals(columnResult).isTrue());
+    }
+
+    static AbstractExpression* column(int id) {
+        return new TupleValueExpression(id, "ITEMS", "C");
+    }
+
+    static AbstractExpression* constant(NValue value) {
+        return constantValueFactory(value);
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_table;
+};
+
+TEST_F(ColumnarScanBench, WideTable) {
+    ASSERT_TRUE(m_table->setColumnarLayout(true));
+    ColumnarBlocks *columns = m_table->getColumnarBlocks();
+    int64_t start = nowMicros();
+    const size_t blocks = columns->sync();
+    for (size_t block = 0; block < blocks; block++) {
+        columns->refresh(block);
+    }
+    printf("\n%d rows of %d bytes, %d scans, minipages built in %lld us\n", numRows,
+           static_cast<int>(m_table->schema()->tupleLength()), numScans,
+           static_cast<long long>(nowMicros() - start));
+
+    measureScan("QUANTITY < 10",
+        comparisonFactory(EXPRESSION_TYPE_COMPARE_LESSTHAN, column(1),
+                          constant(ValueFactory::getIntegerValue(10))));
+    measureScan("PRICE >= 50.0",
+        comparisonFactory(EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO, column(2),
+                          constant(ValueFactory::getDoubleValue(50.0))));
+    measureScan("QUANTITY > 90 OR PRICE < 1.0",
+        conjunctionFactory(EXPRESSION_TYPE_CONJUNCTION_OR,
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_GREATERTHAN, column(1),
+                              constant(ValueFactory::getIntegerValue(90))),
+            comparisonFactory(EXPRESSION_TYPE_COMPARE_LESSTHAN, column(2),
+                              constant(ValueFactory::getDoubleValue(1.0)))));
+    measureAggregate("SUM(QUANTITY)", EXPRESSION_TYPE_AGGREGATE_SUM, 1);
+    measureAggregate("MAX(QUANTITY)", EXPRESSION_TYPE_AGGREGATE_MAX, 1);
+    measureAggregate("SUM(PRICE)", EXPRESSION_TYPE_AGGREGATE_SUM, 2);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) numRows = atoi(argv[1]);
+    if (argc > 2) numScans = atoi(argv[2]);
+    return TestSuite::globalInstance()->runAll();
+}
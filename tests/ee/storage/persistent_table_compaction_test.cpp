@@ -0,0 +1,350 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "execution/VoltDBEngine.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include "indexes/tableindex.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace voltdb;
+
+#define NUM_TUPLES 50000
+
+class PersistentTableCompactionTest : public Test {
+public:
+    PersistentTableCompactionTest() {
+        m_engine = new VoltDBEngine();
+        m_engine->initialize(1, 1, 0, 0, "");
+        m_engine->setUndoToken(INT64_MIN + 1);
+
+        // three inlined pads make the tuples wide enough to fill a few blocks
+        std::string columnNames[] = { "ID", "GRP", "PAD1", "PAD2", "PAD3", "NAME" };
+        std::vector<ValueType> types;
+        std::vector<int32_t> sizes;
+        std::vector<bool> allowNull;
+        types.push_back(VALUE_TYPE_BIGINT);
+        sizes.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        types.push_back(VALUE_TYPE_INTEGER);
+        sizes.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER));
+        for (int i = 0; i < 3; i++) {
+            types.push_back(VALUE_TYPE_VARCHAR);
+            sizes.push_back(60);
+        }
+        types.push_back(VALUE_TYPE_VARCHAR);
+        sizes.push_back(200);
+        for (int i = 0; i < 6; i++) {
+            allowNull.push_back(i != 0);
+        }
+        TupleSchema *schema = TupleSchema::createTupleSchema(types, sizes, allowNull, true);
+
+        std::vector<int32_t> keyColumns(1, 0);
+        std::vector<ValueType> keyTypes(1, VALUE_TYPE_BIGINT);
+        TableIndexScheme pkey("pkey", BALANCED_TREE_INDEX, keyColumns, keyTypes, true, false, schema);
+
+        std::vector<int32_t> grpColumns(1, 1);
+        std::vector<ValueType> grpTypes(1, VALUE_TYPE_INTEGER);
+        std::vector<TableIndexScheme> indexes;
+        indexes.push_back(TableIndexScheme("grp", BALANCED_TREE_INDEX, grpColumns, grpTypes, false, false, schema));
+        indexes.push_back(TableIndexScheme("grp_hash", HASH_TABLE_INDEX, grpColumns, grpTypes, false, false, schema));
+
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, m_engine->getExecutorContext(), "FOO",
+                                             schema, columnNames, pkey, indexes, -1, false, false));
+    }
+
+    ~PersistentTableCompactionTest() {
+        m_engine->releaseUndoToken(INT64_MIN + 1);
+        delete m_table;
+        delete m_engine;
+    }
+
+    static bool compactionSupported() {
+#if defined(MEMCHECK_NOFREELIST) || (defined(ANTICACHE) && !defined(ANTICACHE_TIMESTAMPS))
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    void insert(int64_t id) {
+        TableTuple &tuple = m_table->tempTuple();
+        tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+        tuple.setNValue(1, ValueFactory::getIntegerValue(static_cast<int32_t>(id % 13)));
+        char pad[32];
+        snprintf(pad, sizeof(pad), "pad %lld", (long long) id);
+        NValue padValue = ValueFactory::getStringValue(pad);
+        for (int i = 2; i < 5; i++) {
+            tuple.setNValue(i, padValue);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "name of tuple %lld", (long long) id);
+        NValue nameValue = ValueFactory::getStringValue(name);
+        tuple.setNValue(5, nameValue);
+        ASSERT_TRUE(m_table->insertTuple(tuple));
+        padValue.free();
+        nameValue.free();
+    }
+
+    TableTuple find(int64_t id) {
+        TableIndex *pkey = m_table->primaryKeyIndex();
+        char keyData[64];
+        TableTuple key(keyData, pkey->getKeySchema());
+        key.setNValue(0, ValueFactory::getBigIntValue(id));
+        pkey->moveToKey(&key);
+        return pkey->nextValueAtKey();
+    }
+
+    void remove(int64_t id) {
+        TableTuple tuple = find(id);
+        ASSERT_FALSE(tuple.isNullTuple());
+        ASSERT_TRUE(m_table->deleteTuple(tuple, true));
+    }
+
+    size_t blockCount() const {
+        return static_cast<const Table*>(m_table)->allocatedBlockCount();
+    }
+
+    int compactAll(int maxTuples) {
+        int calls = 0;
+        while (m_table->compactTuples(maxTuples)) {
+            calls++;
+        }
+        return calls;
+    }
+
+    /** Every live tuple can be found through every index and has its values */
+    void verify(const std::vector<bool> &live) {
+        int64_t expected = 0;
+        for (size_t id = 0; id < live.size(); id++) {
+            TableTuple tuple = find(id);
+            if (!live[id]) {
+                ASSERT_TRUE(tuple.isNullTuple());
+                continue;
+            }
+            expected++;
+            ASSERT_FALSE(tuple.isNullTuple());
+            ASSERT_TRUE(tuple.isActive());
+            EXPECT_EQ(static_cast<int32_t>(id % 13), ValuePeeker::peekAsInteger(tuple.getNValue(1)));
+            char name[64];
+            snprintf(name, sizeof(name), "name of tuple %lld", (long long) id);
+            NValue nameValue = ValueFactory::getStringValue(name);
+            EXPECT_EQ(0, tuple.getNValue(5).compare(nameValue));
+            nameValue.free();
+        }
+        ASSERT_EQ(expected, m_table->activeTupleCount());
+
+        int64_t scanned = 0;
+        TableTuple tuple(m_table->schema());
+        TableIterator iterator(m_table);
+        while (iterator.next(tuple)) {
+            ASSERT_TRUE(live[ValuePeeker::peekAsBigInt(tuple.getNValue(0))]);
+            scanned++;
+        }
+        EXPECT_EQ(expected, scanned);
+
+        std::vector<TableIndex*> indexes = m_table->allIndexes();
+        for (size_t i = 0; i < indexes.size(); i++) {
+            EXPECT_EQ(expected, static_cast<int64_t>(indexes[i]->getSize()));
+        }
+
+        // the secondary indexes point at the moved tuples too
+        TableIndex *grp = m_table->index("grp_hash");
+        char keyData[64];
+        TableTuple key(keyData, grp->getKeySchema());
+        key.setNValue(0, ValueFactory::getIntegerValue(5));
+        grp->moveToKey(&key);
+        int64_t matches = 0;
+        TableTuple match(m_table->schema());
+        while (!(match = grp->nextValueAtKey()).isNullTuple()) {
+            ASSERT_TRUE(match.isActive());
+            int64_t id = ValuePeeker::peekAsBigInt(match.getNValue(0));
+            ASSERT_EQ(5, id % 13);
+            ASSERT_TRUE(live[id]);
+            matches++;
+        }
+        int64_t expectedMatches = 0;
+        for (size_t id = 5; id < live.size(); id += 13) {
+            expectedMatches += live[id] ? 1 : 0;
+        }
+        EXPECT_EQ(expectedMatches, matches);
+    }
+
+    VoltDBEngine *m_engine;
+    PersistentTable *m_table;
+};
+
+TEST_F(PersistentTableCompactionTest, DenseTableIsLeftAlone) {
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        insert(id);
+    }
+    size_t blocks = blockCount();
+    ASSERT_TRUE(blocks > 3);
+
+    // a few holes are not worth moving tuples for
+    for (int64_t id = 0; id < NUM_TUPLES; id += 100) {
+        remove(id);
+    }
+    EXPECT_FALSE(m_table->compactTuples(1000));
+    EXPECT_EQ(blocks, blockCount());
+}
+
+TEST_F(PersistentTableCompactionTest, SparseTableReleasesBlocks) {
+    if (!compactionSupported()) return;
+
+    std::vector<bool> live(NUM_TUPLES, true);
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        insert(id);
+    }
+    size_t blocks = blockCount();
+    int64_t memory = m_table->allocatedTupleMemory();
+
+    // keep one tuple in five, spread over every block
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        if (id % 5 != 0) {
+            remove(id);
+            live[id] = false;
+        }
+    }
+    EXPECT_EQ(blocks, blockCount());
+
+    // small slices, so the pass has to resume many times
+    EXPECT_TRUE(compactAll(100) > 10);
+    EXPECT_TRUE(blockCount() < blocks);
+    EXPECT_TRUE(m_table->allocatedTupleMemory() < memory);
+    EXPECT_TRUE(blockCount() <= (blocks + 4) / 5 + 1);
+    verify(live);
+
+    // nothing left to do
+    EXPECT_FALSE(m_table->compactTuples(100));
+
+    // the table keeps working, and fills the holes before growing again
+    size_t compacted = blockCount();
+    for (int64_t id = NUM_TUPLES; id < NUM_TUPLES + 1000; id++) {
+        insert(id);
+        live.push_back(true);
+    }
+    EXPECT_EQ(compacted, blockCount());
+    verify(live);
+}
+
+TEST_F(PersistentTableCompactionTest, ChangesBetweenSlices) {
+    if (!compactionSupported()) return;
+
+    std::vector<bool> live(NUM_TUPLES, true);
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        insert(id);
+    }
+    size_t blocks = blockCount();
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        if (id % 4 != 0) {
+            remove(id);
+            live[id] = false;
+        }
+    }
+
+    int64_t nextId = NUM_TUPLES;
+    int slices = 0;
+    while (m_table->compactTuples(500)) {
+        // transactions run between ticks: delete both moved and unmoved
+        // tuples and insert new ones
+        for (int i = 0; i < 20; i++) {
+            int64_t victim = (slices * 997 + i * 4 * 131) % NUM_TUPLES;
+            victim -= victim % 4;
+            if (live[victim]) {
+                remove(victim);
+                live[victim] = false;
+            }
+        }
+        for (int i = 0; i < 10; i++) {
+            insert(nextId++);
+            live.push_back(true);
+        }
+        slices++;
+    }
+    EXPECT_TRUE(slices > 1);
+    EXPECT_TRUE(blockCount() < blocks);
+    verify(live);
+}
+
+#ifdef ANTICACHE
+TEST_F(PersistentTableCompactionTest, ReleasedBlocksDropTheirClockBits) {
+    if (!compactionSupported()) return;
+
+    m_table->setEvictionPolicy(ANTICACHE_EVICTION_CLOCK);
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        insert(id);
+    }
+    size_t blocks = blockCount();
+    int last = static_cast<int>(blocks) - 1;
+    m_table->setBlockReferenced(last);
+    m_table->setClockHand(last);
+
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        if (id % 5 != 0) {
+            remove(id);
+        }
+    }
+    compactAll(1000);
+    ASSERT_TRUE(blockCount() < blocks);
+
+    // the bit went with the block, and the hand is back on a live one
+    EXPECT_FALSE(m_table->clearBlockReferenced(last));
+    EXPECT_TRUE(m_table->getClockHand() < blockCount());
+}
+#endif
+
+TEST_F(PersistentTableCompactionTest, EmptyTableKeepsOneBlock) {
+    if (!compactionSupported()) return;
+
+    std::vector<bool> live(NUM_TUPLES, false);
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        insert(id);
+    }
+    for (int64_t id = 0; id < NUM_TUPLES; id++) {
+        remove(id);
+    }
+    compactAll(1000);
+    EXPECT_EQ(1, blockCount());
+    verify(live);
+
+    insert(7);
+    live[7] = true;
+    verify(live);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,183 @@
+/* Copyright (C) 2013 by H-Store Project
+ * Brown University
+ * Massachusetts Institute of Technology
+ * Yale University
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Serializes a large result table into a reused buffer the way
+ * VoltDBEngine::send() does, once value by value through
+ * TableTuple::serializeTo() and once with Table::serializeTo(), and
+ * prints the MB/s of each. Usage:
+ *
+ *   result_serialize_bench [rows] [passes]
+ */
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/serializeio.h"
+#include "common/tabletuple.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include "storage/temptable.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/time.h>
+
+using namespace voltdb;
+
+static int numRows = 200000;
+static int numPasses = 20;
+
+static int64_t nowMicros() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+class ResultSerializeBench : public Test {
+public:
+    ResultSerializeBench() : m_table(NULL) {}
+
+    ~ResultSerializeBench() {
+        if (m_table != NULL) {
+            m_table->deleteAllTuples(true);
+            delete m_table;
+        }
+    }
+
+    /** A result table shaped like a SELECT of a few numbers and strings */
+    void createTable(bool withStrings) {
+        if (m_table != NULL) {
+            m_table->deleteAllTuples(true);
+            delete m_table;
+        }
+        std::string columnNames[] = { "ID", "W_ID", "AMOUNT", "CREATED", "CODE", "INFO" };
+        std::vector<ValueType> types;
+        types.push_back(VALUE_TYPE_BIGINT);
+        types.push_back(VALUE_TYPE_INTEGER);
+        types.push_back(VALUE_TYPE_DOUBLE);
+        types.push_back(VALUE_TYPE_TIMESTAMP);
+        if (withStrings) {
+            types.push_back(VALUE_TYPE_VARCHAR);
+            types.push_back(VALUE_TYPE_VARCHAR);
+        }
+        std::vector<int32_t> sizes;
+        for (int i = 0; i < 4; i++) {
+            sizes.push_back(NValue::getTupleStorageSize(types[i]));
+        }
+        if (withStrings) {
+            sizes.push_back(16);
+            sizes.push_back(100);
+        }
+        std::vector<bool> allowNull(types.size(), true);
+        TupleSchema *schema = TupleSchema::createTupleSchema(types, sizes, allowNull, true);
+        m_table = TableFactory::getTempTable(0, "RESULT", schema, columnNames, NULL);
+
+        TableTuple &tuple = m_table->tempTuple();
+        srand(1);
+        for (int64_t id = 0; id < numRows; id++) {
+            tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+            tuple.setNValue(1, ValueFactory::getIntegerValue(rand() % 100));
+            tuple.setNValue(2, ValueFactory::getDoubleValue((rand() % 10000) / 100.0));
+            tuple.setNValue(3, ValueFactory::getTimestampValue(id * 1000));
+            if (withStrings) {
+                char code[16];
+                snprintf(code, sizeof(code), "C%06d", rand() % 1000000);
+                NValue codeValue = ValueFactory::getStringValue(code);
+                NValue infoValue = ValueFactory::getStringValue(std::string(20 + rand() % 60, 'x'));
+                tuple.setNValueAllocateForObjectCopies(4, codeValue, NULL);
+                tuple.setNValueAllocateForObjectCopies(5, infoValue, NULL);
+                codeValue.free();
+                infoValue.free();
+            }
+            m_table->insertTuple(tuple);
+        }
+    }
+
+    /** What Table::serializeTo() used to do, a value at a time */
+    void serializeValues(SerializeOutput &out) {
+        size_t pos = out.reserveBytes(sizeof(int32_t));
+        m_table->serializeColumnHeaderTo(out);
+        out.writeInt(static_cast<int32_t>(m_table->activeTupleCount()));
+        TableIterator iterator(m_table);
+        TableTuple tuple(m_table->schema());
+        while (iterator.next(tuple)) {
+            tuple.serializeTo(out);
+        }
+        out.writeIntAt(pos, static_cast<int32_t>(out.position() - pos - sizeof(int32_t)));
+    }
+
+    void measure(const char *label) {
+        std::vector<char> buffer(static_cast<size_t>(numRows) * 256 + 1024 * 1024);
+        std::vector<char> expected;
+        int64_t valueMicros = 0;
+        int64_t tableMicros = 0;
+        size_t bytes = 0;
+        for (int i = 0; i < numPasses; i++) {
+            ReferenceSerializeOutput values(&buffer[0], buffer.size());
+            int64_t start = nowMicros();
+            serializeValues(values);
+            valueMicros += nowMicros() - start;
+            expected.assign(values.data(), values.data() + values.size());
+
+            ReferenceSerializeOutput table(&buffer[0], buffer.size());
+            start = nowMicros();
+            m_table->serializeTo(table);
+            tableMicros += nowMicros() - start;
+            bytes = table.size();
+            ASSERT_EQ(expected.size(), bytes);
+            ASSERT_EQ(0, ::memcmp(&expected[0], table.data(), bytes));
+        }
+        valueMicros = std::max(valueMicros, static_cast<int64_t>(1));
+        tableMicros = std::max(tableMicros, static_cast<int64_t>(1));
+        double mb = static_cast<double>(bytes) * numPasses / (1024.0 * 1024.0);
+        printf("%-24s %8.1f MB  per value %8.0f MB/s  Table::serializeTo %8.0f MB/s  %.2fx\n", label,
+               static_cast<double>(bytes) / (1024.0 * 1024.0),
+               mb * 1000000.0 / static_cast<double>(valueMicros),
+               mb * 1000000.0 / static_cast<double>(tableMicros),
+               static_cast<double>(valueMicros) / static_cast<double>(tableMicros));
+    }
+
+    Table *m_table;
+};
+
+TEST_F(ResultSerializeBench, LargeSelect) {
+    printf("\n%d rows, %d passes\n", numRows, numPasses);
+    createTable(false);
+    measure("numbers");
+    createTable(true);
+    measure("numbers and strings");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) numRows = atoi(argv[1]);
+    if (argc > 2) numPasses = atoi(argv[2]);
+    return TestSuite::globalInstance()->runAll();
+}
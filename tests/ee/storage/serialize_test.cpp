@@ -112,6 +112,60 @@ class TableSerializeTest : public Test {
             delete []columnNames;
         }
     protected:
+        /** Replace the table with one that has a column of each type, every fourth row all nulls */
+        void fillWithEveryType() {
+            const int columnCount = 10;
+            std::string names[columnCount] = { "TINY", "SMALL", "INT", "BIG", "STAMP", "DBL", "DEC",
+                                               "SHORTSTR", "LONGSTR", "BIN" };
+            ValueType types[columnCount] = { VALUE_TYPE_TINYINT, VALUE_TYPE_SMALLINT, VALUE_TYPE_INTEGER,
+                                             VALUE_TYPE_BIGINT, VALUE_TYPE_TIMESTAMP, VALUE_TYPE_DOUBLE,
+                                             VALUE_TYPE_DECIMAL, VALUE_TYPE_VARCHAR, VALUE_TYPE_VARCHAR,
+                                             VALUE_TYPE_VARBINARY };
+            std::vector<voltdb::ValueType> columnTypes(types, types + columnCount);
+            std::vector<int32_t> columnSizes;
+            for (int i = 0; i < 7; i++) {
+                columnSizes.push_back(NValue::getTupleStorageSize(types[i]));
+            }
+            columnSizes.push_back(20);
+            columnSizes.push_back(300);
+            columnSizes.push_back(10);
+            std::vector<bool> columnAllowNull(columnCount, true);
+            voltdb::TupleSchema *schema = voltdb::TupleSchema::createTupleSchema(columnTypes, columnSizes, columnAllowNull, true);
+            table_->deleteAllTuples(true);
+            delete table_;
+            table_ = TableFactory::getTempTable(this->database_id, "temp_table", schema, names, NULL);
+            EXPECT_FALSE(table_->schema()->columnIsInlined(8));
+
+            for (int64_t i = 0; i < TUPLES; i++) {
+                TableTuple &tuple = table_->tempTuple();
+                if (i % 4 == 3) {
+                    for (int col = 0; col < columnCount; col++) {
+                        tuple.setNValue(col, NValue::getNullValue(types[col]));
+                    }
+                } else {
+                    tuple.setNValue(0, ValueFactory::getTinyIntValue(static_cast<int8_t>(-i)));
+                    tuple.setNValue(1, ValueFactory::getSmallIntValue(static_cast<int16_t>(i * 1001)));
+                    tuple.setNValue(2, ValueFactory::getIntegerValue(static_cast<int32_t>(i * -100003)));
+                    tuple.setNValue(3, ValueFactory::getBigIntValue(i * 10000000019LL));
+                    tuple.setNValue(4, ValueFactory::getTimestampValue(i * 1000000));
+                    tuple.setNValue(5, ValueFactory::getDoubleValue(-2.5 * static_cast<double>(i)));
+                    ostringstream decimal;
+                    decimal << "-" << i << "12345678901234.5678";
+                    tuple.setNValue(6, ValueFactory::getDecimalValueFromString(decimal.str()));
+                    NValue shortString = ValueFactory::getStringValue(std::string(static_cast<size_t>(i % 15), 'a'));
+                    NValue longString = ValueFactory::getStringValue(std::string(static_cast<size_t>(i * 13), 'b'));
+                    NValue binary = ValueFactory::getBinaryValue(std::string(static_cast<size_t>(i % 5) * 2, 'c'));
+                    tuple.setNValueAllocateForObjectCopies(7, shortString, NULL);
+                    tuple.setNValueAllocateForObjectCopies(8, longString, NULL);
+                    tuple.setNValueAllocateForObjectCopies(9, binary, NULL);
+                    shortString.free();
+                    longString.free();
+                    binary.free();
+                }
+                table_->insertTuple(tuple);
+            }
+        }
+
         CatalogId database_id;
         CatalogId table_id;
         Table* table_;
@@ -168,8 +222,6 @@ TEST_F(TableSerializeTest, NullStrings) {
     table_->deleteAllTuples(true);
     delete table_;
     table_ = TableFactory::getTempTable(this->database_id, "temp_table", schema, columnNames, NULL);
-    // clean up
-    delete[] columnNames;
 
 
     TableTuple& tuple = table_->tempTuple();
@@ -185,6 +237,8 @@ TEST_F(TableSerializeTest, NullStrings) {
     int tempTableMemory = 0;
     schema = TupleSchema::createTupleSchema(table_->schema());
     Table* deserialized = TableFactory::getTempTable(this->database_id, "foo", schema, columnNames, &tempTableMemory);
+    // clean up
+    delete[] columnNames;
     deserialized->loadTuplesFrom(false,  serialize_in, NULL);
 
     EXPECT_EQ(1, deserialized->activeTupleCount());
@@ -213,6 +267,30 @@ TEST_F(TableSerializeTest, NullStrings) {
     delete deserialized;
 }
 
+TEST_F(TableSerializeTest, WireFormatOfEveryType) {
+    // serializeTo() writes tuples straight from their storage, it has to
+    // produce the bytes NValue::serializeTo() does for every type and null
+    fillWithEveryType();
+
+    CopySerializeOutput expected;
+    TableIterator iter(table_);
+    TableTuple tuple(table_->schema());
+    while (iter.next(tuple)) {
+        tuple.serializeTo(expected);
+    }
+    CopySerializeOutput serialize_out;
+    table_->serializeTo(serialize_out);
+    ASSERT_TRUE(serialize_out.size() > expected.size());
+    const char *tuples = serialize_out.data() + serialize_out.size() - expected.size();
+    EXPECT_EQ(0, ::memcmp(expected.data(), tuples, expected.size()));
+
+    // and the same again with the serializer the table has kept
+    CopySerializeOutput serialize_out2;
+    table_->serializeTo(serialize_out2);
+    ASSERT_EQ(serialize_out.size(), serialize_out2.size());
+    EXPECT_EQ(0, ::memcmp(serialize_out.data(), serialize_out2.data(), serialize_out.size()));
+}
+
 int main() {
     return TestSuite::globalInstance()->runAll();
 }
@@ -417,7 +417,7 @@ public class TestAntiCacheMultiLevel extends BaseTestCase {
 
     @Test
     public void testReadNonExistentBlock() throws Exception {
-        int block_ids[] = new int[]{ 1111 };
+        long block_ids[] = new long[]{ 1111 };
         int tuple_offsets[] = new int[]{0}; 
         boolean failed = false;
         try {